@@ -0,0 +1,212 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+// writes a synthetic corpus (see CorpusGenerator), or with --scale times
+// each phase of the compiler on corpora of 1 KLOC, 10 KLOC and so on up to
+// --scale lines, to show where a phase stops scaling: its KLOC/s falls as
+// the corpus grows. files are --lines long, so larger corpora have more of
+// them.
+//
+//   tinycsharp_gen [--seed=N] [--files=N] [--lines=N] [--depth=N]
+//                  [--ident=N] [--comments=F] [--jobs=N] (--out=DIR | --scale=LINES)
+
+#include "bytecode.h"
+#include "corpus.h"
+#include "ir.h"
+#include "lexer.h"
+#include "parser.h"
+#include "passes.h"
+#include "sema.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+    bool StartsWith(const std::string &s, const char *prefix)
+    {
+        return s.compare(0, std::char_traits<char>::length(prefix), prefix) == 0;
+    }
+
+    double Seconds(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    int Write(const tinycsharp::CorpusGenerator &generator, const std::string &dir)
+    {
+        std::filesystem::create_directories(dir);
+        std::size_t lines = 0;
+        std::size_t bytes = 0;
+        for (int i = 0; i < generator.options().files; i++)
+        {
+            tinycsharp::CorpusFile file = generator.File(i);
+            std::filesystem::path path = std::filesystem::path(dir) / file.name;
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            out << file.text;
+            if (!out.flush())
+                throw std::runtime_error("cannot write " + path.string());
+            lines += static_cast<std::size_t>(std::count(file.text.begin(), file.text.end(), '\n'));
+            bytes += file.text.size();
+        }
+        std::printf("wrote %d files, %zu lines, %zu bytes to %s\n", generator.options().files, lines, bytes, dir.c_str());
+        return 0;
+    }
+
+    // one corpus through every phase, each timed on its own.
+    void Measure(const tinycsharp::CorpusOptions &options, tinycsharp::ThreadPool *pool)
+    {
+        enum
+        {
+            kGenerate,
+            kLex,
+            kParse,
+            kCheck,
+            kLower,
+            kBytecode,
+            kPhases
+        };
+        double seconds[kPhases] = {};
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<tinycsharp::CorpusFile> files = tinycsharp::CorpusGenerator{options}.Files();
+        seconds[kGenerate] = Seconds(start);
+        std::size_t lines = 0;
+        for (const auto &file : files)
+            lines += static_cast<std::size_t>(std::count(file.text.begin(), file.text.end(), '\n'));
+
+        tinycsharp::AstContext ctx;
+        std::vector<std::vector<tinycsharp::Token>> tokens(files.size());
+        start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < files.size(); i++)
+        {
+            tinycsharp::SourceLocation base = ctx.sources().Begin(ctx.sources().AddFile(files[i].name, files[i].text));
+            tinycsharp::Lexer lexer{files[i].text, base};
+            tokens[i] = lexer.Tokenize();
+        }
+        seconds[kLex] = Seconds(start);
+
+        start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < files.size(); i++)
+        {
+            tinycsharp::Parser parser{ctx, std::move(tokens[i]), files[i].name};
+            parser.ParseCompilationUnit();
+        }
+        seconds[kParse] = Seconds(start);
+
+        start = std::chrono::steady_clock::now();
+        tinycsharp::Sema sema{ctx.interner()};
+        if (!sema.Analyze(ctx.units, pool))
+            throw std::runtime_error("generated corpus does not check: " + sema.diagnostics()[0].message);
+        seconds[kCheck] = Seconds(start);
+
+        start = std::chrono::steady_clock::now();
+        tinycsharp::IrModule module = tinycsharp::LowerToIr(sema.globals());
+        tinycsharp::PassManager passes;
+        passes.AddPipeline(tinycsharp::OptLevel::kO1);
+        passes.Run(module);
+        seconds[kLower] = Seconds(start);
+
+        start = std::chrono::steady_clock::now();
+        tinycsharp::CompileBytecode(module);
+        seconds[kBytecode] = Seconds(start);
+
+        double kloc = static_cast<double>(lines) / 1000.0;
+        std::printf("%10zu %7zu", lines, files.size());
+        for (double s : seconds)
+            std::printf(" %10.0f", s > 0 ? kloc / s : 0.0);
+        std::printf("\n");
+        std::fflush(stdout);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    tinycsharp::CorpusOptions options;
+    std::string out;
+    long scale = 0;
+    unsigned jobs = 1;
+    try
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            if (StartsWith(arg, "--seed="))
+                options.seed = std::stoull(arg.substr(7));
+            else if (StartsWith(arg, "--files="))
+                options.files = std::stoi(arg.substr(8));
+            else if (StartsWith(arg, "--lines="))
+                options.lines_per_file = std::stoi(arg.substr(8));
+            else if (StartsWith(arg, "--depth="))
+                options.max_depth = std::stoi(arg.substr(8));
+            else if (StartsWith(arg, "--ident="))
+                options.identifier_length = std::stoi(arg.substr(8));
+            else if (StartsWith(arg, "--comments="))
+                options.comment_density = std::stod(arg.substr(11));
+            else if (StartsWith(arg, "--jobs="))
+                jobs = static_cast<unsigned>(std::stoul(arg.substr(7)));
+            else if (StartsWith(arg, "--out="))
+                out = arg.substr(6);
+            else if (StartsWith(arg, "--scale="))
+                scale = std::stol(arg.substr(8));
+            else
+                throw std::invalid_argument("unknown option " + arg);
+        }
+        if (out.empty() == (scale <= 0))
+            throw std::invalid_argument("give one of --out=DIR and --scale=LINES");
+    }
+    catch (const std::exception &e)
+    {
+        std::fprintf(stderr, "tinycsharp_gen: %s\n", e.what());
+        std::fprintf(stderr, "usage: tinycsharp_gen [--seed=N] [--files=N] [--lines=N] [--depth=N] [--ident=N] [--comments=F] [--jobs=N] (--out=DIR | --scale=LINES)\n"
+                             "  --lines=N  lines per file, exactly for N of 25 or more\n");
+        return 2;
+    }
+
+    try
+    {
+        if (!out.empty())
+            return Write(tinycsharp::CorpusGenerator{options}, out);
+
+        // the checker takes a pool; the other phases run on this thread.
+        std::unique_ptr<tinycsharp::ThreadPool> pool;
+        if (jobs > 1)
+            pool = std::make_unique<tinycsharp::ThreadPool>(jobs);
+        std::printf("KLOC/s by phase\n%10s %7s %10s %10s %10s %10s %10s %10s\n", "lines", "files", "generate", "lex", "parse", "check",
+                    "lower", "bytecode");
+        for (long lines = 1000; lines <= scale; lines *= 10)
+        {
+            tinycsharp::CorpusOptions sized = options;
+            sized.files = static_cast<int>(std::max(1L, lines / options.lines_per_file));
+            Measure(sized, pool.get());
+        }
+        return 0;
+    }
+    catch (const std::exception &e)
+    {
+        std::fprintf(stderr, "tinycsharp_gen: %s\n", e.what());
+        return 1;
+    }
+}
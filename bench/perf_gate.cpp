@@ -0,0 +1,431 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+// the performance regression gate: lexing, parsing, checking and whole
+// compilation of fixed, generated corpora, each timed --runs times. a
+// calibration loop is timed alongside, and every benchmark is scored as its
+// throughput over the calibration's, so a baseline recorded on one machine
+// holds on another of a different speed. the median score is compared with
+// the baseline; a benchmark fails when it drops by more than the tolerance,
+// widened to three times the run-to-run noise (the scaled median absolute
+// deviation) when that is larger, and one with no baseline entry fails
+// too. --update records this run's scores into the baseline instead,
+// keeping the entries of benchmarks it did not run.
+//
+//   tinycsharp_perf --baseline=FILE [--runs=N] [--tolerance=F] [--update] [NAME...]
+
+#include "bytecode.h"
+#include "cache.h"
+#include "ir.h"
+#include "lexer.h"
+#include "parser.h"
+#include "passes.h"
+#include "sema.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    // many small classes: fields, constructors, virtual calls, strings.
+    std::string ClassesCorpus()
+    {
+        std::ostringstream out;
+        out << "using System;\nnamespace Corpus.Classes\n{\n";
+        out << "    abstract class Node\n    {\n        public int id;\n"
+               "        public abstract int Weight(int depth);\n"
+               "        public virtual string Label() { return \"node\"; }\n    }\n";
+        for (int i = 0; i < 1500; i++)
+        {
+            out << "    // generated class " << i << "\n";
+            out << "    class Item" << i << " : Node\n    {\n";
+            out << "        private int count;\n        private string name = \"item" << i << "\";\n";
+            out << "        public Item" << i << "(int seed) { id = seed; count = seed * " << (i % 7 + 1) << "; }\n";
+            out << "        public override int Weight(int depth)\n        {\n";
+            out << "            int total = count;\n            int k = 0;\n";
+            out << "            while (k < depth)\n            {\n";
+            out << "                total = total + (k * " << (i % 13 + 2) << ") % 17;\n                k++;\n            }\n";
+            out << "            if (total > " << (i * 3) << ") { return total - id; }\n";
+            out << "            return total + id;\n        }\n";
+            out << "        public override string Label() { return name + \":\" + count; }\n";
+            out << "    }\n";
+        }
+        out << "    class Program\n    {\n        static int Main()\n        {\n            int sum = 0;\n";
+        for (int i = 0; i < 1500; i += 50)
+        {
+            out << "            sum += new Item" << i << "(" << i << ").Weight(3);\n";
+        }
+        out << "            return sum;\n        }\n    }\n}\n";
+        return out.str();
+    }
+
+    // a few classes with long method bodies: nested control flow, locals,
+    // arrays and arithmetic.
+    std::string MethodsCorpus()
+    {
+        std::ostringstream out;
+        out << "namespace Corpus.Methods\n{\n";
+        for (int c = 0; c < 20; c++)
+        {
+            out << "    static class Kernel" << c << "\n    {\n";
+            for (int m = 0; m < 20; m++)
+            {
+                out << "        /* kernel " << c << "." << m << " */\n";
+                out << "        public static long Run" << m << "(int n)\n        {\n";
+                out << "            int[] data = new int[n + 1];\n            long acc = " << m << ";\n";
+                out << "            int i = 0;\n            while (i < n)\n            {\n";
+                for (int s = 0; s < 6; s++)
+                {
+                    out << "                if ((i + " << s << ") % " << (s + 2) << " == 0)\n                {\n";
+                    out << "                    data[i] = data[i] + i * " << (s + c + 1) << ";\n";
+                    out << "                    acc = acc + data[i] - " << (m + s) << ";\n";
+                    out << "                }\n                else\n                {\n";
+                    out << "                    acc = acc ^ (i << " << (s % 5) << ");\n                }\n";
+                }
+                out << "                i++;\n            }\n            return acc;\n        }\n";
+            }
+            out << "    }\n";
+        }
+        out << "}\n";
+        return out.str();
+    }
+
+    std::size_t Lines(const std::string &text)
+    {
+        return static_cast<std::size_t>(std::count(text.begin(), text.end(), '\n'));
+    }
+
+    // work whose speed tracks the machine's: hashing, sorting and hash map
+    // inserts, the same kinds of work the compiler does.
+    std::size_t Calibrate()
+    {
+        std::string buffer(1 << 16, 'x');
+        std::uint64_t h = 0;
+        for (int i = 0; i < 64; i++)
+        {
+            buffer[static_cast<std::size_t>(i)] = static_cast<char>(h);
+            h = tinycsharp::HashBytes(buffer, h);
+        }
+        std::vector<std::uint64_t> values(1 << 15);
+        for (auto &v : values)
+        {
+            h = h * 6364136223846793005ull + 1442695040888963407ull;
+            v = h >> 17;
+        }
+        std::sort(values.begin(), values.end());
+        std::unordered_map<std::uint64_t, std::uint32_t> map;
+        for (std::size_t i = 0; i < values.size(); i += 2)
+        {
+            map[values[i]] = static_cast<std::uint32_t>(i);
+        }
+        return map.size() + static_cast<std::size_t>(h & 1);
+    }
+
+    struct Benchmark
+    {
+        std::string name;
+        const char *unit;
+        double work; // per run, in units
+        // runs once; returns the seconds of the timed part.
+        std::function<double()> run;
+    };
+
+    double Seconds(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    double Median(std::vector<double> values)
+    {
+        std::sort(values.begin(), values.end());
+        std::size_t n = values.size();
+        return n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+    }
+
+    // the median absolute deviation, scaled to estimate a standard
+    // deviation.
+    double Mad(const std::vector<double> &values, double median)
+    {
+        std::vector<double> deviations;
+        for (double v : values)
+        {
+            deviations.push_back(std::fabs(v - median));
+        }
+        return 1.4826 * Median(deviations);
+    }
+
+    std::vector<Benchmark> Benchmarks(const std::vector<std::pair<std::string, std::string>> &corpora)
+    {
+        std::vector<Benchmark> out;
+        for (const auto &[name, source] : corpora)
+        {
+            std::size_t tokens = tinycsharp::Lexer{source}.Tokenize().size();
+            std::string dump = tinycsharp::EncodeTokens(tinycsharp::Lexer{source}.Tokenize());
+            double kloc = static_cast<double>(Lines(source)) / 1000.0;
+            const std::string *text = &source;
+
+            out.push_back({name + "/lex", "Mtok/s", tokens / 1e6, [text]
+                           {
+                               auto start = std::chrono::steady_clock::now();
+                               tinycsharp::Lexer lexer{*text};
+                               std::vector<tinycsharp::Token> tokens = lexer.Tokenize();
+                               return Seconds(start);
+                           }});
+            out.push_back({name + "/parse", "Mtok/s", tokens / 1e6, [dump, name]
+                           {
+                               // the parser consumes its tokens; decoding them is not timed.
+                               std::vector<tinycsharp::Token> tokens = tinycsharp::DecodeTokens(dump);
+                               tinycsharp::AstContext ctx;
+                               auto start = std::chrono::steady_clock::now();
+                               tinycsharp::Parser parser{ctx, std::move(tokens), name};
+                               parser.ParseCompilationUnit();
+                               return Seconds(start);
+                           }});
+            out.push_back({name + "/check", "KLOC/s", kloc, [text, name]
+                           {
+                               tinycsharp::AstContext ctx;
+                               tinycsharp::Parser parser{ctx, *text, name};
+                               parser.ParseCompilationUnit();
+                               auto start = std::chrono::steady_clock::now();
+                               tinycsharp::Sema sema{ctx.interner()};
+                               if (!sema.Analyze(ctx.units))
+                               {
+                                   throw std::runtime_error(name + ": " + sema.diagnostics()[0].message);
+                               }
+                               return Seconds(start);
+                           }});
+            out.push_back({name + "/compile", "KLOC/s", kloc, [text, name]
+                           {
+                               auto start = std::chrono::steady_clock::now();
+                               tinycsharp::AstContext ctx;
+                               tinycsharp::Parser parser{ctx, *text, name};
+                               parser.ParseCompilationUnit();
+                               tinycsharp::Sema sema{ctx.interner()};
+                               if (!sema.Analyze(ctx.units))
+                               {
+                                   throw std::runtime_error(name + ": " + sema.diagnostics()[0].message);
+                               }
+                               tinycsharp::IrModule module = tinycsharp::LowerToIr(sema.globals());
+                               tinycsharp::PassManager passes;
+                               passes.AddPipeline(tinycsharp::OptLevel::kO1);
+                               passes.Run(module);
+                               tinycsharp::CompileBytecode(module);
+                               return Seconds(start);
+                           }});
+        }
+        return out;
+    }
+
+    // the "name": score pairs of a baseline file's "benchmarks" object.
+    std::map<std::string, double> ReadBaseline(const std::string &path)
+    {
+        std::ifstream in(path);
+        if (!in)
+        {
+            throw std::runtime_error("cannot read " + path);
+        }
+        std::ostringstream ss;
+        ss << in.rdbuf();
+        std::string text = ss.str();
+        std::size_t start = text.find("\"benchmarks\"");
+        if (start == std::string::npos)
+        {
+            throw std::runtime_error(path + ": no \"benchmarks\" object");
+        }
+        std::map<std::string, double> out;
+        std::regex entry("\"([^\"]+)\"\\s*:\\s*([-+0-9.eE]+)");
+        std::string body = text.substr(start + 12, text.find('}', start) - start - 12);
+        for (std::sregex_iterator it(body.begin(), body.end(), entry), end; it != end; ++it)
+        {
+            out[(*it)[1]] = std::stod((*it)[2]);
+        }
+        return out;
+    }
+
+    void WriteBaseline(const std::string &path, const std::map<std::string, double> &scores)
+    {
+        std::ofstream out(path, std::ios::trunc);
+        out << "{\n";
+        out << "    \"about\": \"tinycsharp_perf scores: throughput relative to the calibration loop\",\n";
+        out << "    \"benchmarks\": {\n";
+        std::size_t i = 0;
+        for (const auto &[name, score] : scores)
+        {
+            char value[32];
+            std::snprintf(value, sizeof value, "%.4g", score);
+            out << "        \"" << name << "\": " << value << (++i < scores.size() ? ",\n" : "\n");
+        }
+        out << "    }\n}\n";
+        if (!out.flush())
+        {
+            throw std::runtime_error("cannot write " + path);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string baseline_path;
+    int runs = 7;
+    double tolerance = 0.25;
+    bool update = false;
+    std::vector<std::string> only;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg.compare(0, 11, "--baseline=") == 0)
+            baseline_path = arg.substr(11);
+        else if (arg.compare(0, 7, "--runs=") == 0)
+            runs = std::max(3, std::stoi(arg.substr(7)));
+        else if (arg.compare(0, 12, "--tolerance=") == 0)
+            tolerance = std::stod(arg.substr(12));
+        else if (arg == "--update")
+            update = true;
+        else
+            only.push_back(arg);
+    }
+    if (baseline_path.empty())
+    {
+        std::fprintf(stderr, "usage: tinycsharp_perf --baseline=FILE [--runs=N] [--tolerance=F] [--update] [NAME...]\n");
+        return 2;
+    }
+
+    try
+    {
+        // --update may start a baseline file; checking needs one.
+        std::map<std::string, double> baseline;
+        if (!update || std::ifstream(baseline_path))
+            baseline = ReadBaseline(baseline_path);
+
+        // the benchmarks keep pointers to the corpora.
+        const std::vector<std::pair<std::string, std::string>> corpora = {{"classes", ClassesCorpus()},
+                                                                           {"methods", MethodsCorpus()}};
+        std::vector<Benchmark> benchmarks = Benchmarks(corpora);
+        for (const std::string &name : only)
+        {
+            if (std::none_of(benchmarks.begin(), benchmarks.end(), [&](const Benchmark &b)
+                             { return b.name == name; }))
+                throw std::runtime_error("no benchmark named " + name);
+        }
+
+        // calibration runs are interleaved with the benchmarks', so both see
+        // the same state of the machine.
+        std::vector<double> calibration;
+        auto calibrate = [&]
+        {
+            auto start = std::chrono::steady_clock::now();
+            Calibrate();
+            calibration.push_back(1.0 / Seconds(start));
+        };
+
+        std::map<std::string, double> scores;
+        bool failed = false;
+        int unrecorded = 0;
+        std::printf("%-18s %10s %8s %8s %8s %8s %8s  %s\n", "benchmark", "median", "unit", "noise", "score", "baseline",
+                    "change", "status");
+        for (const Benchmark &bench : benchmarks)
+        {
+            if (!only.empty() && std::find(only.begin(), only.end(), bench.name) == only.end())
+                continue;
+            // warm up, and repeat short benchmarks within a run until the
+            // run is long enough for the clock.
+            int repeat = static_cast<int>(std::ceil(0.02 / bench.run()));
+            repeat = std::max(1, std::min(repeat, 1000));
+            std::vector<double> throughput;
+            std::vector<double> score;
+            for (int r = 0; r < runs; r++)
+            {
+                calibrate();
+                double seconds = 0;
+                for (int i = 0; i < repeat; i++)
+                    seconds += bench.run();
+                throughput.push_back(bench.work * repeat / seconds);
+                score.push_back(throughput.back() / calibration.back());
+            }
+            double median = Median(throughput);
+            double median_score = Median(score);
+            double noise = Mad(score, median_score) / median_score;
+            scores[bench.name] = median_score;
+
+            auto it = baseline.find(bench.name);
+            if (update || it == baseline.end())
+            {
+                std::printf("%-18s %10.2f %8s %7.1f%% %8.4g %8s %8s  %s\n", bench.name.c_str(), median, bench.unit,
+                            noise * 100, median_score, "-", "-", update ? "recorded" : "NO BASELINE");
+                if (!update)
+                    unrecorded++;
+                continue;
+            }
+            double change = median_score / it->second - 1;
+            double allowed = std::max(tolerance, 3 * noise);
+            const char *status = "ok";
+            if (change < -allowed)
+            {
+                status = "REGRESSED";
+                failed = true;
+            }
+            else if (change > allowed)
+            {
+                status = "faster (consider --update)";
+            }
+            std::printf("%-18s %10.2f %8s %7.1f%% %8.4g %8.4g %+7.1f%%  %s\n", bench.name.c_str(), median, bench.unit,
+                        noise * 100, median_score, it->second, change * 100, status);
+        }
+        if (update)
+        {
+            // the scores of benchmarks not run are kept; those of benchmarks
+            // that no longer exist are dropped.
+            std::map<std::string, double> merged;
+            for (const Benchmark &bench : benchmarks)
+            {
+                auto it = scores.find(bench.name);
+                if (it != scores.end())
+                    merged[bench.name] = it->second;
+                else if (auto old = baseline.find(bench.name); old != baseline.end())
+                    merged[bench.name] = old->second;
+            }
+            WriteBaseline(baseline_path, merged);
+            std::printf("baseline written to %s\n", baseline_path.c_str());
+            return 0;
+        }
+        if (failed)
+        {
+            std::printf("perf: throughput regressed past the tolerance (%.0f%%, or 3x the noise)\n", tolerance * 100);
+        }
+        if (unrecorded)
+        {
+            std::printf("perf: %d benchmark%s no baseline; record with --update\n", unrecorded,
+                        unrecorded == 1 ? " has" : "s have");
+        }
+        return failed || unrecorded ? 1 : 0;
+    }
+    catch (const std::exception &e)
+    {
+        std::fprintf(stderr, "tinycsharp_perf: %s\n", e.what());
+        return 2;
+    }
+}
@@ -0,0 +1,358 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+// interpreter throughput on small arithmetic, loop and call heavy programs.
+// every program is compiled once and run --reps times; the best run is
+// reported together with the number of dispatched instructions. --plain
+// turns off quickening, superinstructions and move coalescing, for
+// comparing dispatch counts against the generic instruction set. --no-jit
+// keeps hot functions in the interpreter; with the JIT, instructions run as
+// native code are not counted as dispatches.
+//
+// --parse=DUMP times the parser alone instead, replaying a token dump
+// written by tinycsharp --emit-tokens=bin.
+//
+//   tinycsharp_bench [-O0|-O1|-O2] [--reps=N] [--plain] [--no-jit] [NAME...]
+//   tinycsharp_bench [--reps=N] --parse=DUMP
+
+#include "bytecode.h"
+#include "cache.h"
+#include "ir.h"
+#include "parser.h"
+#include "passes.h"
+#include "sema.h"
+#include "vm.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct Benchmark
+    {
+        const char *name;
+        const char *source;
+    };
+
+    const Benchmark kBenchmarks[] = {
+        {"int-arith", R"(
+class Program
+{
+    static int Main()
+    {
+        int s = 0;
+        int i = 0;
+        while (i < 5000000)
+        {
+            s = s + ((i * 7) ^ (i >> 3)) % 13;
+            i++;
+        }
+        return s;
+    }
+}
+)"},
+        {"double-arith", R"(
+class Program
+{
+    static int Main()
+    {
+        double x = 1.0;
+        int i = 0;
+        while (i < 3000000)
+        {
+            x = x * 0.999999 + 0.5;
+            i++;
+        }
+        return (int)x;
+    }
+}
+)"},
+        {"nested-loops", R"(
+class Program
+{
+    static int Main()
+    {
+        int s = 0;
+        int i = 0;
+        while (i < 2000)
+        {
+            int j = 0;
+            while (j < 2000)
+            {
+                s = s + ((i * j) & 255);
+                j++;
+            }
+            i++;
+        }
+        return s;
+    }
+}
+)"},
+        {"fib", R"(
+class Program
+{
+    static int Fib(int n)
+    {
+        if (n < 2) return n;
+        return Fib(n - 1) + Fib(n - 2);
+    }
+    static int Main() { return Fib(27); }
+}
+)"},
+        {"field-loop", R"(
+class Counter
+{
+    public int hits;
+    public long total;
+}
+class Program
+{
+    static int Main()
+    {
+        Counter c = new Counter();
+        int i = 0;
+        while (i < 3000000)
+        {
+            c.hits++;
+            c.total += i;
+            i++;
+        }
+        return c.hits + (int)(c.total % 1000);
+    }
+}
+)"},
+        {"virtual-calls", R"(
+class Shape
+{
+    public virtual int Sides() { return 0; }
+}
+class Triangle : Shape { public override int Sides() { return 3; } }
+class Square : Shape { public override int Sides() { return 4; } }
+class Program
+{
+    static int Main()
+    {
+        Shape[] shapes = new Shape[16];
+        int i = 0;
+        while (i < 16)
+        {
+            if (i % 4 == 0) shapes[i] = new Square(); else shapes[i] = new Triangle();
+            i++;
+        }
+        Shape one = new Triangle();
+        int s = 0;
+        i = 0;
+        while (i < 1000000)
+        {
+            s = s + one.Sides() + shapes[i & 15].Sides();
+            i++;
+        }
+        return s;
+    }
+}
+)"},
+        {"array-loop", R"(
+class Program
+{
+    static int Main()
+    {
+        int[] data = new int[1000];
+        int round = 0;
+        int s = 0;
+        while (round < 1000)
+        {
+            int i = 0;
+            while (i < data.Length)
+            {
+                data[i] = data[i] + i;
+                s = s + data[i];
+                i++;
+            }
+            round++;
+        }
+        return s;
+    }
+}
+)"},
+        {"allocation", R"(
+class Point
+{
+    public int x;
+    public int y;
+    public Point(int x, int y) { this.x = x; this.y = y; }
+}
+class Segment
+{
+    public Point from;
+    public Point to;
+    public Segment(Point from, Point to) { this.from = from; this.to = to; }
+    public int Length() { return to.x - from.x + to.y - from.y; }
+}
+class Program
+{
+    static int Main()
+    {
+        Segment[] recent = new Segment[64];
+        int i = 0;
+        int s = 0;
+        while (i < 1000000)
+        {
+            Segment seg = new Segment(new Point(i, i), new Point(i + 3, i + 4));
+            s = s + seg.Length();
+            recent[i & 63] = seg;
+            i++;
+        }
+        return s + recent[5].from.x % 1000;
+    }
+}
+)"},
+    };
+
+    tinycsharp::BcProgram Compile(const Benchmark &bench, tinycsharp::OptLevel level, const tinycsharp::BcOptions &options)
+    {
+        tinycsharp::Interner interner;
+        tinycsharp::AstContext ctx{interner};
+        tinycsharp::Parser parser{ctx, bench.source, bench.name};
+        parser.ParseCompilationUnit();
+        tinycsharp::Sema sema{interner};
+        if (!sema.Analyze(ctx.units))
+        {
+            throw std::runtime_error(std::string(bench.name) + ": " + sema.diagnostics()[0].message);
+        }
+        tinycsharp::IrModule module = tinycsharp::LowerToIr(sema.globals());
+        tinycsharp::PassManager passes;
+        passes.AddPipeline(level);
+        passes.Run(module);
+        return tinycsharp::CompileBytecode(module, nullptr, options);
+    }
+
+    int BenchParser(const std::string &path, int reps)
+    {
+        std::ifstream in(path, std::ios::binary);
+        std::ostringstream ss;
+        ss << in.rdbuf();
+        std::string dump = ss.str();
+        if (!in || !tinycsharp::IsTokenDump(dump))
+        {
+            std::fprintf(stderr, "tinycsharp_bench: %s is not a token dump\n", path.c_str());
+            return 1;
+        }
+        double best = 1e300;
+        std::size_t tokens = 0;
+        std::size_t nodes = 0;
+        for (int r = 0; r < reps; r++)
+        {
+            // decoding is not timed; the parser consumes its tokens.
+            tinycsharp::AstContext ctx;
+            std::vector<tinycsharp::Token> stream = tinycsharp::ReadTokenDump(dump, ctx.sources(), path);
+            tokens = stream.size();
+            auto start = std::chrono::steady_clock::now();
+            tinycsharp::Parser parser{ctx, std::move(stream), path};
+            parser.ParseCompilationUnit();
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            best = std::min(best, elapsed.count());
+            nodes = ctx.NodeCount();
+        }
+        std::printf("%-14s %10s %10s %10s %12s\n", "parse", "ms", "tokens", "nodes", "Mtok/s");
+        std::printf("%-14s %10.2f %10zu %10zu %12.1f\n", "best", best, tokens, nodes,
+                    static_cast<double>(tokens) / (best * 1000.0));
+        return 0;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string opt_flag = "-O1";
+    int reps = 3;
+    bool plain = false;
+    bool no_jit = false;
+    std::vector<std::string> only;
+    std::string parse_dump;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg.compare(0, 2, "-O") == 0)
+            opt_flag = arg;
+        else if (arg.compare(0, 7, "--reps=") == 0)
+            reps = std::max(1, std::stoi(arg.substr(7)));
+        else if (arg == "--plain")
+            plain = true;
+        else if (arg == "--no-jit")
+            no_jit = true;
+        else if (arg.compare(0, 8, "--parse=") == 0)
+            parse_dump = arg.substr(8);
+        else
+            only.push_back(arg);
+    }
+    if (!parse_dump.empty())
+        return BenchParser(parse_dump, reps);
+    tinycsharp::OptLevel level = tinycsharp::ParseOptLevel(opt_flag);
+    tinycsharp::BcOptions options;
+    tinycsharp::Vm::Options vm_options;
+    if (plain)
+    {
+        options.superinstructions = false;
+        options.coalesce_moves = false;
+        vm_options.quicken = false;
+    }
+    vm_options.jit = !no_jit;
+
+    std::printf("dispatch: %s, %s%s%s, best of %d\n", tinycsharp::Vm::ThreadedDispatch() ? "computed goto" : "switch",
+                opt_flag.c_str(), plain ? ", plain" : "", vm_options.jit && tinycsharp::Jit::Supported() ? ", jit" : "", reps);
+    std::printf("%-14s %10s %14s %12s %8s %10s %12s\n", "benchmark", "ms", "instructions", "Minst/s", "ic hit", "gc",
+                "result");
+    for (const Benchmark &bench : kBenchmarks)
+    {
+        if (!only.empty() && std::find(only.begin(), only.end(), bench.name) == only.end())
+            continue;
+        tinycsharp::BcProgram program = Compile(bench, level, options);
+        double best = 1e300;
+        std::uint64_t instructions = 0;
+        tinycsharp::VmStats stats;
+        tinycsharp::HeapStats heap;
+        int result = 0;
+        for (int r = 0; r < reps; r++)
+        {
+            std::ostringstream out;
+            tinycsharp::Vm vm{program, out, vm_options};
+            auto start = std::chrono::steady_clock::now();
+            result = vm.Run();
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            if (elapsed.count() < best)
+                best = elapsed.count();
+            instructions = vm.stats().instructions;
+            stats = vm.stats();
+            heap = vm.heap().stats();
+        }
+        char hit_rate[16] = "-";
+        if (stats.VirtualCalls())
+            std::snprintf(hit_rate, sizeof hit_rate, "%.1f%%", stats.InlineCacheHitRate() * 100.0);
+        // minor/major collections
+        char collections[32] = "-";
+        if (heap.collections)
+            std::snprintf(collections, sizeof collections, "%llu/%llu", static_cast<unsigned long long>(heap.minor_collections),
+                          static_cast<unsigned long long>(heap.major_collections));
+        std::printf("%-14s %10.2f %14llu %12.1f %8s %10s %12d\n", bench.name, best, static_cast<unsigned long long>(instructions),
+                    static_cast<double>(instructions) / (best * 1000.0), hit_rate, collections, result);
+    }
+    return 0;
+}
@@ -0,0 +1,113 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace tinycsharp
+{
+    // bump allocator. memory is handed out from large blocks and released all at
+    // once when the arena dies, so only trivially destructible objects may live
+    // here.
+    class Arena
+    {
+    public:
+        explicit Arena(std::size_t block_size = 64 * 1024) : block_size_(block_size) {}
+        ~Arena() = default;
+        Arena(const Arena &) = delete;
+        Arena &operator=(const Arena &) = delete;
+        Arena(Arena &&) = default;
+        Arena &operator=(Arena &&) = default;
+
+        void *Allocate(std::size_t size, std::size_t align)
+        {
+            std::uintptr_t p = (reinterpret_cast<std::uintptr_t>(cur_) + align - 1) & ~(align - 1);
+            if (cur_ == nullptr || p + size > reinterpret_cast<std::uintptr_t>(end_))
+            {
+                NewBlock(size + align);
+                p = (reinterpret_cast<std::uintptr_t>(cur_) + align - 1) & ~(align - 1);
+            }
+            cur_ = reinterpret_cast<char *>(p + size);
+            bytes_used_ += size;
+            return reinterpret_cast<void *>(p);
+        }
+
+        template <typename T, typename... Args>
+        T *New(Args &&...args)
+        {
+            static_assert(std::is_trivially_destructible_v<T>, "arena objects are never destroyed");
+            return new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        }
+
+        template <typename T>
+        T *NewArray(std::size_t n)
+        {
+            static_assert(std::is_trivially_destructible_v<T>, "arena objects are never destroyed");
+            if (n == 0)
+            {
+                return nullptr;
+            }
+            T *p = static_cast<T *>(Allocate(sizeof(T) * n, alignof(T)));
+            for (std::size_t i = 0; i < n; i++)
+            {
+                new (p + i) T();
+            }
+            return p;
+        }
+
+        std::string_view CopyString(std::string_view s)
+        {
+            if (s.empty())
+            {
+                return {};
+            }
+            char *p = static_cast<char *>(Allocate(s.size(), 1));
+            std::memcpy(p, s.data(), s.size());
+            return std::string_view(p, s.size());
+        }
+
+        std::size_t BytesUsed() const { return bytes_used_; }
+
+    private:
+        void NewBlock(std::size_t min_size)
+        {
+            std::size_t size = min_size > block_size_ ? min_size : block_size_;
+            blocks_.push_back(std::make_unique<char[]>(size));
+            cur_ = blocks_.back().get();
+            end_ = cur_ + size;
+        }
+
+        std::size_t block_size_;
+        std::size_t bytes_used_ = 0;
+        char *cur_ = nullptr;
+        char *end_ = nullptr;
+        std::vector<std::unique_ptr<char[]>> blocks_;
+    };
+
+}
+
+#endif // ARENA_H
@@ -0,0 +1,493 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#ifndef AST_H
+#define AST_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include "arena.h"
+#include "interner.h"
+#include "source_manager.h"
+#include "token.h"
+
+namespace tinycsharp
+{
+    // every concrete node type, in NodeKind order. X(Name) expands once per
+    // node; the visitor and the per-kind index are generated from this list.
+#define TINYCSHARP_AST_NODES(X) \
+    X(CompilationUnit)          \
+    X(UsingDirective)           \
+    X(NamespaceDecl)            \
+    X(ClassDecl)                \
+    X(FieldDecl)                \
+    X(MethodDecl)               \
+    X(ParamDecl)                \
+    X(TypeRef)                  \
+    X(BlockStmt)                \
+    X(LocalVarStmt)             \
+    X(ExprStmt)                 \
+    X(IfStmt)                   \
+    X(WhileStmt)                \
+    X(DoWhileStmt)              \
+    X(ReturnStmt)               \
+    X(BreakStmt)                \
+    X(ContinueStmt)             \
+    X(ThrowStmt)                \
+    X(LiteralExpr)              \
+    X(NameExpr)                 \
+    X(MemberExpr)               \
+    X(CallExpr)                 \
+    X(IndexExpr)                \
+    X(UnaryExpr)                \
+    X(BinaryExpr)               \
+    X(AssignExpr)               \
+    X(ConditionalExpr)          \
+    X(CastExpr)                 \
+    X(NewExpr)                  \
+    X(ThisExpr)                 \
+    X(AwaitExpr)
+
+    enum class NodeKind : std::uint8_t
+    {
+#define TINYCSHARP_NODE_KIND(Name) k##Name,
+        TINYCSHARP_AST_NODES(TINYCSHARP_NODE_KIND)
+#undef TINYCSHARP_NODE_KIND
+    };
+
+#define TINYCSHARP_NODE_COUNT(Name) +1
+    constexpr std::size_t kNodeKindCount = 0 TINYCSHARP_AST_NODES(TINYCSHARP_NODE_COUNT);
+#undef TINYCSHARP_NODE_COUNT
+
+    const char *NodeKindToString(NodeKind);
+
+    // declaration modifiers, or'ed together in Modifiers.
+    enum Modifier : std::uint32_t
+    {
+        kModPublic = 1u << 0,
+        kModPrivate = 1u << 1,
+        kModProtected = 1u << 2,
+        kModInternal = 1u << 3,
+        kModStatic = 1u << 4,
+        kModConst = 1u << 5,
+        kModReadonly = 1u << 6,
+        kModVirtual = 1u << 7,
+        kModOverride = 1u << 8,
+        kModAbstract = 1u << 9,
+        kModSealed = 1u << 10,
+        kModAsync = 1u << 11,
+    };
+    using Modifiers = std::uint32_t;
+
+    struct Node
+    {
+        NodeKind kind;
+        SourceLocation loc; // decoded through the unit's SourceManager
+    };
+
+    // arena-allocated, fixed-size list of child nodes.
+    template <typename T>
+    struct NodeList
+    {
+        T **items = nullptr;
+        std::uint32_t count = 0;
+
+        T **begin() const { return items; }
+        T **end() const { return items + count; }
+        T *operator[](std::size_t i) const { return items[i]; }
+        std::size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+    };
+
+    // semantic information attached by Sema. defined in types.h and sema.h.
+    struct Type;
+    struct ClassInfo;
+    struct FieldInfo;
+    struct MethodInfo;
+    struct ConstValue;
+
+    struct Expr : Node
+    {
+        const Type *type = nullptr;         // set by the type checker
+        const ConstValue *constant = nullptr; // set when constant folding evaluated the expression
+    };
+
+    struct ClassDecl;
+    struct CompilationUnit;
+    struct NamespaceDecl;
+    struct BlockStmt;
+
+    struct TypeRef : Node
+    {
+        static constexpr NodeKind kKind = NodeKind::kTypeRef;
+        std::string_view name; // dotted, e.g. System.String
+        SymbolId name_id = kNoSymbol;
+        NodeList<TypeRef> args;
+        std::uint8_t array_rank = 0;
+    };
+
+    struct UsingDirective : Node
+    {
+        static constexpr NodeKind kKind = NodeKind::kUsingDirective;
+        std::string_view name;
+        SymbolId name_id = kNoSymbol;
+    };
+
+    struct CompilationUnit : Node
+    {
+        static constexpr NodeKind kKind = NodeKind::kCompilationUnit;
+        std::string_view file;
+        // where the locations of the unit's nodes are; null for a unit not
+        // parsed from source.
+        const SourceManager *sources = nullptr;
+        NodeList<UsingDirective> usings;
+        NodeList<Node> members; // NamespaceDecl or ClassDecl
+
+        // where a node of the unit is; all zero without sources.
+        SourcePosition Locate(const Node *node) const { return sources ? sources->Decode(node->loc) : SourcePosition{}; }
+    };
+
+    struct NamespaceDecl : Node
+    {
+        static constexpr NodeKind kKind = NodeKind::kNamespaceDecl;
+        std::string_view name;
+        SymbolId name_id = kNoSymbol;
+        NamespaceDecl *outer = nullptr;
+        NodeList<UsingDirective> usings;
+        NodeList<Node> members; // NamespaceDecl or ClassDecl
+    };
+
+    struct ClassDecl : Node
+    {
+        static constexpr NodeKind kKind = NodeKind::kClassDecl;
+        std::string_view name;
+        SymbolId name_id = kNoSymbol;
+        Modifiers modifiers = 0;
+        bool is_struct = false;
+        CompilationUnit *unit = nullptr;
+        NamespaceDecl *ns = nullptr;
+        ClassDecl *outer = nullptr;
+        NodeList<TypeRef> bases;
+        NodeList<Node> members; // FieldDecl, MethodDecl or ClassDecl
+        ClassInfo *info = nullptr;
+    };
+
+    struct FieldDecl : Node
+    {
+        static constexpr NodeKind kKind = NodeKind::kFieldDecl;
+        std::string_view name;
+        SymbolId name_id = kNoSymbol;
+        Modifiers modifiers = 0;
+        bool is_property = false;
+        ClassDecl *owner = nullptr;
+        TypeRef *type = nullptr;
+        Expr *init = nullptr;
+        FieldInfo *info = nullptr;
+    };
+
+    struct ParamDecl : Node
+    {
+        static constexpr NodeKind kKind = NodeKind::kParamDecl;
+        std::string_view name;
+        SymbolId name_id = kNoSymbol;
+        TypeRef *type = nullptr;
+        std::uint32_t index = 0;
+        const Type *resolved_type = nullptr;
+    };
+
+    struct MethodDecl : Node
+    {
+        static constexpr NodeKind kKind = NodeKind::kMethodDecl;
+        std::string_view name;
+        SymbolId name_id = kNoSymbol;
+        Modifiers modifiers = 0;
+        bool is_ctor = false;
+        ClassDecl *owner = nullptr;
+        TypeRef *return_type = nullptr; // null for constructors
+        NodeList<ParamDecl> params;
+        BlockStmt *body = nullptr; // null for abstract methods
+        MethodInfo *info = nullptr;
+    };
+
+    struct BlockStmt : Node
+    {
+        static constexpr NodeKind kKind = NodeKind::kBlockStmt;
+        NodeList<Node> stmts;
+    };
+
+    struct LocalVarStmt : Node
+    {
+        static constexpr NodeKind kKind = NodeKind::kLocalVarStmt;
+        std::string_view name;
+        SymbolId name_id = kNoSymbol;
+        bool is_const = false;
+        TypeRef *type = nullptr; // null for var
+        Expr *init = nullptr;
+        const Type *resolved_type = nullptr;
+    };
+
+    struct ExprStmt : Node
+    {
+        static constexpr NodeKind kKind = NodeKind::kExprStmt;
+        Expr *expr = nullptr;
+    };
+
+    struct IfStmt : Node
+    {
+        static constexpr NodeKind kKind = NodeKind::kIfStmt;
+        Expr *cond = nullptr;
+        Node *then_stmt = nullptr;
+        Node *else_stmt = nullptr;
+    };
+
+    struct WhileStmt : Node
+    {
+        static constexpr NodeKind kKind = NodeKind::kWhileStmt;
+        Expr *cond = nullptr;
+        Node *body = nullptr;
+    };
+
+    struct DoWhileStmt : Node
+    {
+        static constexpr NodeKind kKind = NodeKind::kDoWhileStmt;
+        Node *body = nullptr;
+        Expr *cond = nullptr;
+    };
+
+    struct ReturnStmt : Node
+    {
+        static constexpr NodeKind kKind = NodeKind::kReturnStmt;
+        Expr *value = nullptr;
+    };
+
+    struct BreakStmt : Node
+    {
+        static constexpr NodeKind kKind = NodeKind::kBreakStmt;
+    };
+
+    struct ContinueStmt : Node
+    {
+        static constexpr NodeKind kKind = NodeKind::kContinueStmt;
+    };
+
+    struct ThrowStmt : Node
+    {
+        static constexpr NodeKind kKind = NodeKind::kThrowStmt;
+        Expr *value = nullptr;
+    };
+
+    enum class LiteralKind : std::uint8_t
+    {
+        kInt,
+        kFloat,
+        kString,
+        kBool,
+    };
+
+    struct LiteralExpr : Expr
+    {
+        static constexpr NodeKind kKind = NodeKind::kLiteralExpr;
+        LiteralKind literal_kind = LiteralKind::kInt;
+        std::int64_t int_value = 0;
+        double float_value = 0;
+        bool bool_value = false;
+        std::string_view string_value;
+    };
+
+    struct NameExpr : Expr
+    {
+        static constexpr NodeKind kKind = NodeKind::kNameExpr;
+        std::string_view name;
+        SymbolId name_id = kNoSymbol;
+        // declaration the name binds to, filled in by the Binder: a ClassDecl,
+        // FieldDecl, MethodDecl, ParamDecl or LocalVarStmt.
+        Node *decl = nullptr;
+    };
+
+    struct MemberExpr : Expr
+    {
+        static constexpr NodeKind kKind = NodeKind::kMemberExpr;
+        Expr *object = nullptr;
+        std::string_view name;
+        SymbolId name_id = kNoSymbol;
+        FieldInfo *field = nullptr;    // resolved field, if the member is one
+        std::uint16_t builtin = 0;     // a Builtin for library members (string.Length, ...)
+    };
+
+    struct CallExpr : Expr
+    {
+        static constexpr NodeKind kKind = NodeKind::kCallExpr;
+        Expr *callee = nullptr;
+        NodeList<Expr> args;
+        MethodInfo *target = nullptr;  // resolved user method
+        std::uint16_t builtin = 0;     // a Builtin from sema.h when the callee is a library function
+    };
+
+    struct IndexExpr : Expr
+    {
+        static constexpr NodeKind kKind = NodeKind::kIndexExpr;
+        Expr *object = nullptr;
+        Expr *index = nullptr;
+    };
+
+    // op is the operator token: kTMinus, kTNot, kTIncrement or kTDecrement.
+    struct UnaryExpr : Expr
+    {
+        static constexpr NodeKind kKind = NodeKind::kUnaryExpr;
+        TokenKind op = TokenKind::kTError;
+        bool postfix = false;
+        Expr *operand = nullptr;
+    };
+
+    struct BinaryExpr : Expr
+    {
+        static constexpr NodeKind kKind = NodeKind::kBinaryExpr;
+        TokenKind op = TokenKind::kTError;
+        Expr *lhs = nullptr;
+        Expr *rhs = nullptr;
+    };
+
+    // op is kTAssign, kTPlusAssign or kTMinusAssign.
+    struct AssignExpr : Expr
+    {
+        static constexpr NodeKind kKind = NodeKind::kAssignExpr;
+        TokenKind op = TokenKind::kTAssign;
+        Expr *target = nullptr;
+        Expr *value = nullptr;
+    };
+
+    struct ConditionalExpr : Expr
+    {
+        static constexpr NodeKind kKind = NodeKind::kConditionalExpr;
+        Expr *cond = nullptr;
+        Expr *then_expr = nullptr;
+        Expr *else_expr = nullptr;
+    };
+
+    struct CastExpr : Expr
+    {
+        static constexpr NodeKind kKind = NodeKind::kCastExpr;
+        TypeRef *type = nullptr;
+        Expr *operand = nullptr;
+    };
+
+    struct NewExpr : Expr
+    {
+        static constexpr NodeKind kKind = NodeKind::kNewExpr;
+        TypeRef *type = nullptr;
+        NodeList<Expr> args;
+        MethodInfo *ctor = nullptr;
+    };
+
+    struct ThisExpr : Expr
+    {
+        static constexpr NodeKind kKind = NodeKind::kThisExpr;
+    };
+
+    struct AwaitExpr : Expr
+    {
+        static constexpr NodeKind kKind = NodeKind::kAwaitExpr;
+        Expr *operand = nullptr;
+    };
+
+    // owns the nodes of one or more compilation units. nodes live in an arena
+    // and are also recorded in a per-kind index, so a pass interested in a
+    // single kind (say every CallExpr) can iterate it without walking the tree.
+    class AstContext
+    {
+    public:
+        // a context with its own interner and SourceManager. contexts whose
+        // names must compare equal across files (a whole program) share an
+        // interner instead, and those whose units are checked together a
+        // SourceManager, so that their locations do not overlap.
+        AstContext();
+        explicit AstContext(Interner &);
+        AstContext(Interner &, SourceManager &);
+        ~AstContext() = default;
+        AstContext(const AstContext &) = delete;
+        AstContext &operator=(const AstContext &) = delete;
+
+        template <typename T>
+        T *Make(SourceLocation loc)
+        {
+            T *node = arena_.New<T>();
+            node->kind = T::kKind;
+            node->loc = loc;
+            by_kind_[static_cast<std::size_t>(T::kKind)].push_back(node);
+            return node;
+        }
+
+        template <typename T>
+        NodeList<T> MakeList(const std::vector<T *> &items)
+        {
+            NodeList<T> list;
+            list.count = static_cast<std::uint32_t>(items.size());
+            list.items = arena_.NewArray<T *>(items.size());
+            for (std::size_t i = 0; i < items.size(); i++)
+            {
+                list.items[i] = items[i];
+            }
+            return list;
+        }
+
+        // identifier spelling owned by the interner; equal names share storage.
+        std::string_view Intern(std::string_view s) { return interner_->Spelling(interner_->Intern(s)); }
+        SymbolId Symbol(std::string_view s) { return interner_->Intern(s); }
+        // arbitrary text (literals, file names) copied into the arena.
+        std::string_view CopyString(std::string_view s) { return arena_.CopyString(s); }
+        Interner &interner() { return *interner_; }
+        SourceManager &sources() { return *sources_; }
+
+        // nodes of one kind in creation order.
+        const std::vector<Node *> &NodesOfKind(NodeKind kind) const
+        {
+            return by_kind_[static_cast<std::size_t>(kind)];
+        }
+
+        std::size_t NodeCount() const;
+        std::size_t BytesUsed() const { return arena_.BytesUsed(); }
+
+        std::vector<CompilationUnit *> units;
+
+    private:
+        std::unique_ptr<Interner> owned_interner_;
+        Interner *interner_;
+        std::unique_ptr<SourceManager> owned_sources_;
+        SourceManager *sources_;
+        Arena arena_;
+        std::array<std::vector<Node *>, kNodeKindCount> by_kind_;
+    };
+
+    // checked downcast: returns null when node is not a T.
+    template <typename T>
+    T *NodeCast(Node *node)
+    {
+        return node && node->kind == T::kKind ? static_cast<T *>(node) : nullptr;
+    }
+    template <typename T>
+    const T *NodeCast(const Node *node)
+    {
+        return node && node->kind == T::kKind ? static_cast<const T *>(node) : nullptr;
+    }
+
+}
+
+#endif // AST_H
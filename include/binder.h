@@ -0,0 +1,76 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#ifndef BINDER_H
+#define BINDER_H
+
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "ast.h"
+#include "diagnostics.h"
+#include "symbol_table.h"
+#include "visitor.h"
+
+namespace tinycsharp
+{
+    // resolves simple names (NameExpr) to their declarations across the
+    // namespace, class, method and block scopes of a set of compilation
+    // units. member access (a.b) needs types and is left to the type checker.
+    class Binder : public RecursiveAstVisitor<Binder>
+    {
+    public:
+        Binder(Interner &, std::vector<Diagnostic> &);
+
+        // names that resolve outside the program (library types such as
+        // Console) and must not be reported as undeclared.
+        void AddExternalName(std::string_view);
+        void Bind(const std::vector<CompilationUnit *> &);
+
+        void VisitCompilationUnit(CompilationUnit *);
+        void VisitNamespaceDecl(NamespaceDecl *);
+        void VisitClassDecl(ClassDecl *);
+        void VisitFieldDecl(FieldDecl *);
+        void VisitMethodDecl(MethodDecl *);
+        void VisitBlockStmt(BlockStmt *);
+        void VisitLocalVarStmt(LocalVarStmt *);
+        void VisitNameExpr(NameExpr *);
+        void VisitTypeRef(TypeRef *) {}
+
+    private:
+        void IndexClasses(Node *member, SymbolId ns);
+        void DeclareNamespaceClasses(SymbolId ns);
+        void DeclareUsings(const NodeList<UsingDirective> &);
+        void DeclareMembers(ClassDecl *);
+        void DeclareBaseMembers(ClassDecl *, std::unordered_set<ClassDecl *> &seen);
+        void DeclareLocal(SymbolId, SymbolKind, Node *);
+        void Error(const Node *, const std::string &);
+
+        Interner &interner_;
+        std::vector<Diagnostic> &diagnostics_;
+        ScopedSymbolTable table_;
+        std::unordered_map<SymbolId, std::vector<ClassDecl *>> classes_by_namespace_;
+        std::unordered_set<SymbolId> external_names_;
+        const CompilationUnit *unit_ = nullptr;
+        std::size_t method_scope_ = 0; // depth of the current method's parameter scope, 0 outside methods
+    };
+
+}
+
+#endif // BINDER_H
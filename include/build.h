@@ -0,0 +1,162 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#ifndef BUILD_H
+#define BUILD_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "interner.h"
+#include "sema.h"
+#include "source_manager.h"
+#include "thread_pool.h"
+
+namespace tinycsharp
+{
+    // a project manifest: named assemblies and the files in each.
+    //
+    //     # comment
+    //     assembly Core
+    //         src/core/Text.cs
+    //     assembly App
+    //         src/app/Main.cs
+    //
+    // relative paths are taken from the manifest's directory. dependencies
+    // are not listed: an assembly depends on the ones declaring the
+    // namespaces its using directives name.
+    struct BuildManifest
+    {
+        struct Assembly
+        {
+            std::string name;
+            std::vector<std::string> files;
+        };
+        std::vector<Assembly> assemblies;
+
+        // throws std::runtime_error naming the line at fault.
+        static BuildManifest Parse(std::string_view text, const std::string &dir = "", const std::string &name = "manifest");
+        static BuildManifest Load(const std::string &path);
+    };
+
+    // a DAG of build steps run on a thread pool. a step starts once all of
+    // its dependencies succeeded, and is skipped when one failed or was
+    // skipped. steps may be added between runs, depending on steps that
+    // already ran. each step's start and end are recorded, relative to the
+    // graph's creation, for the timing report.
+    class TaskGraph
+    {
+    public:
+        using Step = std::size_t;
+
+        enum class Status : std::uint8_t
+        {
+            kPending,
+            kSucceeded,
+            kFailed,
+            kSkipped,
+        };
+
+        struct Node
+        {
+            std::string name;
+            std::function<bool()> work; // false or a throw fails the step
+            std::vector<Step> deps;
+            Status status = Status::kPending;
+            double start_ms = 0;
+            double end_ms = 0;
+            std::string error; // what a throw said
+
+            double Duration() const { return end_ms - start_ms; }
+        };
+
+        TaskGraph();
+
+        Step Add(std::string name, std::function<bool()> work, std::vector<Step> deps = {});
+        // runs every pending step. true when none of them failed or was
+        // skipped.
+        bool Run(ThreadPool &pool);
+
+        const std::vector<Node> &nodes() const { return nodes_; }
+        // the chain of steps, each a dependency of the next, whose durations
+        // add up to the most: what bounds the build however many cores run
+        // it.
+        std::vector<Step> CriticalPath() const;
+        // every step by start time, then the critical path.
+        void PrintTimings(std::ostream &) const;
+
+    private:
+        std::vector<Node> nodes_;
+        std::chrono::steady_clock::time_point epoch_;
+    };
+
+    // checks a manifest's assemblies through a TaskGraph. each file is read
+    // and parsed as a step of its own. declarations are program-wide, so one
+    // step declares every file; then each assembly's bodies are checked in a
+    // step that waits for the assemblies it depends on, and a last step
+    // folds constants and orders the diagnostics.
+    class ProjectBuild
+    {
+    public:
+        ProjectBuild(BuildManifest, ThreadPool &);
+        ~ProjectBuild();
+        ProjectBuild(const ProjectBuild &) = delete;
+        ProjectBuild &operator=(const ProjectBuild &) = delete;
+
+        // runs the steps; false when any failed. read and parse errors,
+        // dependency cycles and diagnostics go to err.
+        bool Check(std::ostream &err);
+
+        const BuildManifest &manifest() const { return manifest_; }
+        // for each assembly, the indices of those it depends on.
+        const std::vector<std::vector<std::size_t>> &dependencies() const { return deps_; }
+        // "App -> Core (using Core.Text)", one line per dependency.
+        void PrintDependencies(std::ostream &) const;
+
+        TaskGraph &graph() { return graph_; }
+        // the step that finishes checking, for later steps to wait on.
+        TaskGraph::Step checked() const { return finish_; }
+        Sema &sema() { return *sema_; }
+
+    private:
+        struct File;
+
+        void FindDependencies();
+        bool FindCycle(std::ostream &err) const;
+
+        BuildManifest manifest_;
+        ThreadPool &pool_;
+        Interner interner_;
+        SourceManager sources_;
+        std::vector<std::unique_ptr<File>> files_;
+        std::vector<std::vector<std::size_t>> deps_;
+        std::vector<std::vector<std::string>> reasons_; // the namespace behind each dependency
+        std::unique_ptr<Sema> sema_;
+        TaskGraph graph_;
+        TaskGraph::Step finish_ = 0;
+    };
+
+}
+
+#endif // BUILD_H
@@ -0,0 +1,330 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "ir.h"
+
+namespace tinycsharp
+{
+    // register-based bytecode run by the Vm. every instruction is 8 bytes: an
+    // opcode, a type byte and three 16-bit operands, so a function's code is
+    // a flat array the interpreter walks without decoding. registers are
+    // 8-byte slots in the function's frame; parameters come first.
+    //
+    // operand use (a, b, c are the 16-bit fields; w is b:c as one 32-bit
+    // operand; t is the type byte):
+    //   kMove        a <- b
+    //   kLoadK       a <- constants[w]   kLoadStr a <- program string w
+    //   kLoadNull    a <- null
+    //   binary ops   a <- b op c, t = operand type; integer ops wrap
+    //   kNeg, kNot   a <- op b
+    //   compares     a <- b cmp c, t = operand type
+    //   kConvert     a <- b, t = target type, c = source type (boxes and unboxes)
+    //   kToString    a <- b, c = source type
+    //   kStrEq       a <- b == c         kConcat  a <- b + c
+    //   kGetField    a <- b.slots[c]     kSetField a.slots[c] <- b
+    //   kGetStatic   a <- statics[c]     kSetStatic statics[c] <- b
+    //   kNew         a <- new class c    kNewArray a <- new t[b]
+    //   kGetElem     a <- b[c]           kSetElem  a[b] <- c
+    //   kArrayLength, kStringLength a <- b
+    //   kCharAt      a <- b[c]           kCheckCast a <- b as class c
+    //   kCall        a = result register or kNoRegister, b = argument count,
+    //                c = function; followed by the argument registers packed
+    //                four to an instruction word
+    //   kCallVirtual as kCall with c = vtable slot; the first argument is the
+    //                receiver. one more word follows the arguments, its w
+    //                numbering the call site's inline cache in the program
+    //   kCallBuiltin as kCall with c = Builtin, t = result type
+    //   kAwait       a <- result of task b
+    //   kJump        pc = w              kJumpIfTrue, kJumpIfFalse a, pc = w
+    //   kReturn      a                   kReturnVoid
+    //   kThrow       a
+    //
+    // the ops above are generic: arithmetic, compares and conversions switch
+    // on t every time they run. the Vm quickens them: on first execution an
+    // instruction is rewritten in place to the variant for its type (kAddI32,
+    // kLtI, kConvIF64, ...), which has the same operands; conversions that
+    // only copy become kMove. the ...I compares serve every type whose
+    // values compare as 64-bit integers: bool, char, i32, i64 and, for
+    // equality, references.
+    //
+    // superinstructions are formed by the compiler from common sequences:
+    //   kJumpIfLtI ... a, b; jumps to the target in the next word when
+    //                the integer compare holds, else falls through past it
+    //   kAddField    a.slots[c] += b     kAddStatic statics[c] += b
+    //   kAddElem     a[b] += c           (t = type of the addition)
+#define TINYCSHARP_BC_OPS(X) \
+    X(Nop)                   \
+    X(Move)                  \
+    X(LoadK)                 \
+    X(LoadStr)               \
+    X(LoadNull)              \
+    X(Add)                   \
+    X(Sub)                   \
+    X(Mul)                   \
+    X(Div)                   \
+    X(Rem)                   \
+    X(And)                   \
+    X(Or)                    \
+    X(Xor)                   \
+    X(Shl)                   \
+    X(Shr)                   \
+    X(Neg)                   \
+    X(Not)                   \
+    X(Eq)                    \
+    X(Ne)                    \
+    X(Lt)                    \
+    X(Le)                    \
+    X(Gt)                    \
+    X(Ge)                    \
+    X(Convert)               \
+    X(StrEq)                 \
+    X(Concat)                \
+    X(ToString)              \
+    X(GetField)              \
+    X(SetField)              \
+    X(GetStatic)             \
+    X(SetStatic)             \
+    X(New)                   \
+    X(NewArray)              \
+    X(GetElem)               \
+    X(SetElem)               \
+    X(ArrayLength)           \
+    X(StringLength)          \
+    X(CharAt)                \
+    X(CheckCast)             \
+    X(Call)                  \
+    X(CallVirtual)           \
+    X(CallBuiltin)           \
+    X(Await)                 \
+    X(Jump)                  \
+    X(JumpIfTrue)            \
+    X(JumpIfFalse)           \
+    X(Return)                \
+    X(ReturnVoid)            \
+    X(Throw)                 \
+    X(AddI32)                \
+    X(AddI64)                \
+    X(AddF64)                \
+    X(SubI32)                \
+    X(SubI64)                \
+    X(SubF64)                \
+    X(MulI32)                \
+    X(MulI64)                \
+    X(MulF64)                \
+    X(DivI32)                \
+    X(DivI64)                \
+    X(DivF64)                \
+    X(RemI32)                \
+    X(RemI64)                \
+    X(ShlI32)                \
+    X(ShlI64)                \
+    X(ShrI32)                \
+    X(ShrI64)                \
+    X(NegI32)                \
+    X(NegF64)                \
+    X(EqI)                   \
+    X(NeI)                   \
+    X(LtI)                   \
+    X(LeI)                   \
+    X(GtI)                   \
+    X(GeI)                   \
+    X(EqF64)                 \
+    X(NeF64)                 \
+    X(LtF64)                 \
+    X(LeF64)                 \
+    X(GtF64)                 \
+    X(GeF64)                 \
+    X(ConvI64I32)            \
+    X(ConvIF64)              \
+    X(ConvF64I32)            \
+    X(JumpIfEqI)             \
+    X(JumpIfNeI)             \
+    X(JumpIfLtI)             \
+    X(JumpIfLeI)             \
+    X(JumpIfGtI)             \
+    X(JumpIfGeI)             \
+    X(AddField)              \
+    X(AddStatic)             \
+    X(AddElem)
+
+    enum class BcOp : std::uint8_t
+    {
+#define TINYCSHARP_BC_OP_KIND(Name) k##Name,
+        TINYCSHARP_BC_OPS(TINYCSHARP_BC_OP_KIND)
+#undef TINYCSHARP_BC_OP_KIND
+    };
+
+    const char *BcOpToString(BcOp);
+    constexpr std::uint16_t kNoRegister = 0xffff;
+    // registers are numbered with 16 bits, with kNoRegister reserved.
+    constexpr std::uint32_t kMaxRegisters = 0xffff;
+
+    struct BcInst
+    {
+        BcOp op = BcOp::kNop;
+        IrType type = IrType::kVoid;
+        std::uint16_t a = 0;
+        std::uint16_t b = 0;
+        std::uint16_t c = 0;
+
+        std::uint32_t Wide() const { return static_cast<std::uint32_t>(b) | (static_cast<std::uint32_t>(c) << 16); }
+        void SetWide(std::uint32_t w)
+        {
+            b = static_cast<std::uint16_t>(w);
+            c = static_cast<std::uint16_t>(w >> 16);
+        }
+    };
+    static_assert(sizeof(BcInst) == 8, "BcInst is meant to stay 8 bytes");
+
+    // registers of argument i of the call at code[pc], from the words after it.
+    inline std::uint16_t CallArgument(const BcInst *call, std::uint32_t i)
+    {
+        const auto *words = reinterpret_cast<const std::uint16_t *>(call + 1);
+        return words[i];
+    }
+    // instruction words a call with argc arguments occupies, itself included.
+    inline std::uint32_t CallLength(std::uint32_t argc) { return 1 + (argc + 3) / 4; }
+    inline bool IsCallOp(BcOp op) { return op == BcOp::kCall || op == BcOp::kCallVirtual || op == BcOp::kCallBuiltin; }
+    // the inline cache number of the kCallVirtual at call.
+    inline std::uint32_t CallSite(const BcInst *call) { return call[CallLength(call->b)].Wide(); }
+    inline bool IsFusedJump(BcOp op) { return op >= BcOp::kJumpIfEqI && op <= BcOp::kJumpIfGeI; }
+    // instruction words from inst to the next instruction; code is walked
+    // with this so argument and target words are never read as opcodes.
+    inline std::uint32_t InstLength(const BcInst &inst)
+    {
+        if (IsCallOp(inst.op))
+            return CallLength(inst.b) + (inst.op == BcOp::kCallVirtual);
+        return IsFusedJump(inst.op) ? 2 : 1;
+    }
+    // the type-specialized op a generic instruction quickens to, or its own
+    // op when there is none.
+    BcOp QuickenedOp(const BcInst &);
+
+    // the registers holding live references at a safepoint, an
+    // instruction that may collect: allocations and calls. a register is
+    // listed only while its value is valid, so the collector can rewrite
+    // it when objects move.
+    struct BcStackMap
+    {
+        std::uint32_t pc;
+        std::uint32_t first; // into BcFunction::stack_map_registers
+        std::uint32_t count;
+    };
+
+    // what an await that finds its task still running saves to suspend
+    // the function: the registers live across it, references first, so
+    // resuming can restore them and run the await again.
+    struct BcAwaitPoint
+    {
+        std::uint32_t pc;
+        std::uint32_t first; // into BcFunction::await_registers
+        std::uint32_t count;
+        std::uint32_t refs;  // the first refs registers hold references
+    };
+
+    struct BcFunction
+    {
+        std::string name;
+        std::vector<BcInst> code; // empty for methods without a body
+        std::vector<std::int64_t> constants;
+        std::vector<int> lines;   // source line per instruction word
+        // by pc; safepoints without live references have no entry.
+        std::vector<BcStackMap> stack_maps;
+        std::vector<std::uint16_t> stack_map_registers;
+        // one per await, by pc; await_slots is the most any of them saves.
+        std::vector<BcAwaitPoint> await_points;
+        std::vector<std::uint16_t> await_registers;
+        std::uint32_t await_slots = 0;
+        std::uint16_t num_params = 0;
+        std::uint16_t num_registers = 0;
+        IrType return_type = IrType::kVoid;
+
+        const BcStackMap *FindStackMap(std::uint32_t pc) const
+        {
+            auto it = std::lower_bound(stack_maps.begin(), stack_maps.end(), pc,
+                                       [](const BcStackMap &map, std::uint32_t at)
+                                       { return map.pc < at; });
+            return it != stack_maps.end() && it->pc == pc ? &*it : nullptr;
+        }
+        const BcAwaitPoint *FindAwaitPoint(std::uint32_t pc) const
+        {
+            auto it = std::lower_bound(await_points.begin(), await_points.end(), pc,
+                                       [](const BcAwaitPoint &point, std::uint32_t at)
+                                       { return point.pc < at; });
+            return it != await_points.end() && it->pc == pc ? &*it : nullptr;
+        }
+    };
+
+    struct BcClass
+    {
+        std::string name;
+        std::int32_t base = -1;
+        std::uint32_t num_slots = 0;
+        std::vector<std::uint16_t> ref_slots;
+        std::vector<std::uint32_t> vtable; // function per vtable slot
+    };
+
+    // a whole program ready to run: functions numbered as in the IrModule.
+    struct BcProgram
+    {
+        std::vector<BcFunction> functions;
+        std::vector<BcClass> classes;
+        std::vector<std::string> strings;
+        std::uint32_t num_statics = 0;
+        std::vector<std::uint32_t> ref_statics;
+        std::uint32_t num_call_sites = 0; // kCallVirtual inline caches
+        std::int32_t static_init = -1;
+        std::int32_t entry = -1;
+
+        // instruction words over all functions.
+        std::size_t CodeSize() const;
+        bool IsSubclass(std::uint32_t cls, std::uint32_t of) const;
+    };
+
+    struct BcOptions
+    {
+        // fuse compare-and-branch and load-add-store sequences, and repeat
+        // a loop's exit test at the end of its body instead of jumping back
+        // to it.
+        bool superinstructions = true;
+        // let a value that only feeds a phi be computed straight into the
+        // phi's register, dropping the move on the edge.
+        bool coalesce_moves = true;
+    };
+
+    // translates SSA to register code: every value gets its own register,
+    // constants are loaded once on entry and phis become moves on the
+    // incoming edges. functions are translated in parallel when a pool is
+    // given. throws std::runtime_error when a function outgrows the 16-bit
+    // register or function numbering.
+    BcProgram CompileBytecode(const IrModule &, ThreadPool *pool = nullptr, const BcOptions & = BcOptions{});
+
+    void PrintBytecode(std::ostream &, const BcProgram &, const BcFunction &);
+    void PrintBytecode(std::ostream &, const BcProgram &);
+
+}
+
+#endif // BYTECODE_H
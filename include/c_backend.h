@@ -0,0 +1,53 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#ifndef C_BACKEND_H
+#define C_BACKEND_H
+
+#include <ostream>
+#include <string>
+#include "ir.h"
+
+namespace tinycsharp
+{
+    struct CBackendOptions
+    {
+        // the C compiler; empty means $CC, or cc when that is unset.
+        std::string compiler;
+        std::string flags = "-O2";
+        // keeps the generated source next to the executable as OUTPUT.c.
+        bool keep_source = false;
+    };
+
+    // ahead-of-time backend: the IR of a whole program as one C99
+    // translation unit, with a small runtime of its own, for the system C
+    // compiler to turn into a native executable. integer arithmetic wraps
+    // through unsigned types and every IR instruction becomes one statement,
+    // so overflow and evaluation order stay those of C#. unhandled
+    // exceptions print the interpreter's message and stack trace. objects
+    // are never freed: the output is meant for batch jobs that run to
+    // completion. async methods are not supported and throw
+    // std::runtime_error, as does a module without a static Main.
+    void EmitC(std::ostream &, const IrModule &);
+    // emits the module and compiles it to an executable at output. throws
+    // std::runtime_error when the C compiler fails.
+    void CompileNative(const IrModule &, const std::string &output, const CBackendOptions & = {});
+
+}
+
+#endif // C_BACKEND_H
@@ -0,0 +1,157 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "ast.h"
+#include "token.h"
+
+#ifndef TINYCSHARP_VERSION
+#define TINYCSHARP_VERSION "dev"
+#endif
+
+namespace tinycsharp
+{
+    // the phase whose output a cache entry holds. one source file has one
+    // entry per phase.
+    enum class CachePhase : std::uint8_t
+    {
+        kTokens,
+        kAst,
+    };
+
+    const char *CachePhaseToString(CachePhase);
+
+    // 64-bit non-cryptographic hash, 8 bytes per round.
+    std::uint64_t HashBytes(std::string_view, std::uint64_t seed = 0);
+
+    struct CacheKey
+    {
+        std::uint64_t hash;
+        CachePhase phase;
+
+        // file name of the entry inside the cache directory, e.g. 0123abcd...89.tokens
+        std::string FileName() const;
+    };
+
+    struct CacheStats
+    {
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        std::uint64_t stores = 0;
+        std::uint64_t failed_stores = 0;
+        std::uint64_t evictions = 0;
+    };
+
+    // on-disk, content-addressed store for the per-file outputs of the front end.
+    // keys mix the file contents with the phase and the compiler version, so
+    // a compiler upgrade never serves a stale entry. a phase's output must
+    // depend on nothing else: tokens are the same whatever the flags.
+    // writes go to a temporary file that is renamed into place, which keeps
+    // concurrent compilers from ever reading a torn entry; a write that fails
+    // is dropped and counted, never raised. once the directory grows past
+    // max_bytes the least recently used entries are dropped.
+    class CompilationCache
+    {
+    public:
+        CompilationCache(std::filesystem::path dir, std::uint64_t max_bytes);
+        ~CompilationCache() = default;
+        CompilationCache(const CompilationCache &) = delete;
+        CompilationCache &operator=(const CompilationCache &) = delete;
+
+        CacheKey KeyFor(std::string_view contents, CachePhase) const;
+        std::optional<std::string> Lookup(const CacheKey &);
+        void Store(const CacheKey &, std::string_view blob);
+
+        CacheStats Stats() const;
+        std::uint64_t SizeInBytes() const;
+        std::size_t EntryCount() const;
+        const std::filesystem::path &Directory() const { return dir_; }
+
+    private:
+        struct Entry
+        {
+            std::uint64_t size;
+            std::uint64_t last_use;
+        };
+
+        void LoadIndex();
+        void EvictLocked();
+        void RemoveLocked(const std::string &);
+
+        std::filesystem::path dir_;
+        std::uint64_t max_bytes_;
+        std::uint64_t seed_;
+        std::uint64_t clock_ = 0;
+        std::uint64_t total_bytes_ = 0;
+        std::unordered_map<std::string, Entry> index_;
+        CacheStats stats_;
+        mutable std::mutex mu_;
+    };
+
+    // compact serialisation of a token stream, used for kTokens entries.
+    // locations are kept as offsets from base, where the tokens' file
+    // begins, and decode to offsets from the base given then.
+    std::string EncodeTokens(const std::vector<Token> &, SourceLocation base = {});
+    // throws std::runtime_error on a truncated or foreign blob.
+    std::vector<Token> DecodeTokens(std::string_view, SourceLocation base = {});
+
+    // compact serialisation of a parsed unit, used for kAst entries. nodes
+    // are written in tree order, and one reached twice (the type shared by
+    // the fields of one declaration) as a reference to the first. locations
+    // are kept as offsets from base, as in EncodeTokens(). Sema's
+    // annotations are left out.
+    std::string EncodeAst(const CompilationUnit &, SourceLocation base = {});
+    // makes the unit's nodes in ctx, as Parser would, and appends it to
+    // ctx.units; the per-kind index lists them in tree order. throws
+    // std::runtime_error on a truncated or foreign blob.
+    CompilationUnit *DecodeAst(std::string_view, AstContext &ctx, std::string_view file, SourceLocation base = {});
+
+    // a token dump file, as written by --emit-tokens=bin: "TCST", the line
+    // table of the tokens' file and an EncodeTokens() blob. a dump replays
+    // through Parser exactly as the lexer's tokens would; reading one loads
+    // its file, known by its lines alone, into sources as name.
+    void WriteTokenDump(std::ostream &, const SourceManager &sources, FileId file, const std::vector<Token> &);
+    bool IsTokenDump(std::string_view data);
+    // throws std::runtime_error on a truncated or foreign dump.
+    std::vector<Token> ReadTokenDump(std::string_view data, SourceManager &sources, std::string name);
+
+    // lex source, serving the result from the cache when the same contents were
+    // lexed before by this compiler version. tokens are located from base.
+    std::vector<Token> LexCached(CompilationCache &, const std::string &source, SourceLocation base = {});
+    // parse source as file into ctx, serving the tree from the cache when the
+    // same contents were parsed before by this compiler version, so that
+    // neither the lexer nor the parser runs. nodes are located from base,
+    // and token_count, when given, receives the number of tokens of the
+    // source. parse errors throw as from Parser and store nothing.
+    CompilationUnit *ParseCached(CompilationCache &, AstContext &ctx, const std::string &source, std::string_view file,
+                                 SourceLocation base = {}, std::size_t *token_count = nullptr);
+
+}
+
+#endif // CACHE_H
@@ -0,0 +1,115 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#ifndef CONST_EVAL_H
+#define CONST_EVAL_H
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "ast.h"
+#include "diagnostics.h"
+#include "sema.h"
+#include "types.h"
+
+namespace tinycsharp
+{
+    // a compile-time value. type is one of int, long, char, float, double,
+    // bool or string; integral and bool values live in int_value.
+    struct ConstValue
+    {
+        const Type *type = nullptr;
+        std::int64_t int_value = 0;
+        double float_value = 0;
+        std::string_view string_value;
+
+        bool IsIntegral() const { return type->IsIntegral() || type->kind == TypeKind::kBool; }
+    };
+
+    std::string ConstValueToString(const ConstValue *);
+
+    // owns every ConstValue of a program. safe to use from several threads.
+    class ConstantPool
+    {
+    public:
+        explicit ConstantPool(TypeTable &types) : types_(types) {}
+        ConstantPool(const ConstantPool &) = delete;
+        ConstantPool &operator=(const ConstantPool &) = delete;
+
+        const ConstValue *Integral(const Type *, std::int64_t);
+        const ConstValue *Floating(const Type *, double);
+        const ConstValue *Bool(bool value) { return Integral(types_.Bool(), value); }
+        const ConstValue *String(std::string_view);
+        std::size_t Size() const;
+
+    private:
+        TypeTable &types_;
+        std::deque<ConstValue> values_;
+        std::deque<std::string> strings_;
+        mutable std::mutex mu_;
+    };
+
+    // folds constant expressions on literals, const locals and const fields,
+    // recording the value on Expr::constant (and FieldInfo::constant), so
+    // later phases load the value instead of computing it. overflow and
+    // division by zero are reported the way C# reports them in a checked
+    // constant context.
+    class ConstantFolder
+    {
+    public:
+        ConstantFolder(const GlobalSymbols &, ConstantPool &, std::vector<Diagnostic> &);
+
+        // evaluates every const field of the program, following references
+        // across classes and files. run once, before any FoldBody().
+        void FoldConstFields();
+        // folds the constant subexpressions of one body. const fields must
+        // already be evaluated; bodies can then be folded concurrently.
+        void FoldBody(const BodyTask &);
+
+        const ConstValue *Fold(Expr *);
+
+    private:
+        const ConstValue *EvaluateField(FieldInfo *);
+        const ConstValue *FoldChildren(Expr *);
+        const ConstValue *FoldUnary(UnaryExpr *);
+        const ConstValue *FoldBinary(BinaryExpr *);
+        const ConstValue *FoldCast(CastExpr *);
+        void FoldStatement(Node *);
+        // the value as it is stored in a variable of type to (int to long,
+        // a double literal to float); null if the conversion is not implicit.
+        const ConstValue *Convert(const ConstValue *, const Type *to, const Node *at, bool is_explicit);
+        const ConstValue *Overflow(const Node *);
+        void Error(const Node *, const std::string &);
+
+        const GlobalSymbols &globals_;
+        TypeTable &types_;
+        ConstantPool &pool_;
+        std::vector<Diagnostic> &diagnostics_;
+        const CompilationUnit *unit_ = nullptr;
+        bool fields_done_ = false;
+        std::unordered_map<const FieldInfo *, int> field_state_;
+        std::unordered_map<const LocalVarStmt *, const ConstValue *> locals_;
+    };
+
+}
+
+#endif // CONST_EVAL_H
@@ -0,0 +1,77 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#ifndef CORPUS_H
+#define CORPUS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tinycsharp
+{
+    struct CorpusOptions
+    {
+        std::uint64_t seed = 1;
+        int files = 1;
+        // a file has exactly this many lines, comments making up what the
+        // code leaves; or, below 25, the few more its namespace, static
+        // class, Entry() and Main() may need.
+        int lines_per_file = 500;
+        // how deep ifs and loops nest within a method.
+        int max_depth = 3;
+        // generated names are at least this long, and longer only where a
+        // name's unique number does not fit.
+        int identifier_length = 8;
+        // the share of lines that are comments, below 1.
+        double comment_density = 0.1;
+    };
+
+    struct CorpusFile
+    {
+        std::string name;
+        std::string text;
+    };
+
+    // synthetic C# in the subset the compiler takes: namespaces, classes
+    // with fields, constructors and methods, nested ifs and loops, literals
+    // of every type, and line and block comments. a corpus is a function of
+    // its options alone, so one of any size can be regenerated rather than
+    // shipped. every file checks without errors: each has a static class
+    // whose Entry() calls that of an earlier file, and the last file holds
+    // Main(). no method recurses and every loop is bounded, so the program
+    // also runs to an end.
+    class CorpusGenerator
+    {
+    public:
+        // throws std::invalid_argument for options out of range.
+        explicit CorpusGenerator(CorpusOptions);
+
+        const CorpusOptions &options() const { return options_; }
+        // file index of the corpus. it depends only on the options and the
+        // index, so files can be made in any order, or on several threads.
+        CorpusFile File(int index) const;
+        std::vector<CorpusFile> Files() const;
+
+    private:
+        CorpusOptions options_;
+    };
+
+}
+
+#endif // CORPUS_H
@@ -0,0 +1,115 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ast.h"
+#include "interner.h"
+
+namespace tinycsharp
+{
+    class CompilationCache;
+
+    // the front end's work kept between compilations of one long-lived
+    // process: a single interner and SourceManager, and every file's syntax
+    // tree until the file's contents change. each compilation analyzes the
+    // trees afresh; Sema writes its annotations into them, and clears those
+    // of the last analysis first, since they may point into the tree of a
+    // file parsed again since. a replaced file's text is released at once,
+    // but the interner and the source address space only grow, so Trim()
+    // starts over once enough of them is no longer in use.
+    class FrontEndCache
+    {
+    public:
+        struct File
+        {
+            std::string path;
+            std::string_view source; // held by sources()
+            FileId id = kNoFile;
+            std::size_t tokens = 0;
+            std::unique_ptr<AstContext> ast;
+        };
+
+        struct Stats
+        {
+            std::uint64_t hits = 0;
+            std::uint64_t misses = 0;
+            std::uint64_t trims = 0;
+        };
+
+        // source address space a Trim() lets go unused before starting over.
+        static constexpr std::uint64_t kTrimLimit = 256u << 20;
+
+        FrontEndCache();
+        FrontEndCache(const FrontEndCache &) = delete;
+        FrontEndCache &operator=(const FrontEndCache &) = delete;
+
+        // the parse of source, reused when path had the same contents last
+        // time. parses through cache when given. parse errors throw and
+        // leave nothing cached for path.
+        const File &Parse(const std::string &path, const std::string &source, CompilationCache *cache = nullptr);
+        // drops every tree, the interner and the sources once more than
+        // limit bytes of the address space belong to no cached file: those
+        // of replaced files, and of files other contexts loaded into
+        // sources(). call it between compilations, when nothing else points
+        // into the cache.
+        void Trim(std::uint64_t limit = kTrimLimit);
+        Interner &interner() { return *interner_; }
+        SourceManager &sources() { return *sources_; }
+        const Stats &stats() const { return stats_; }
+
+    private:
+        void Drop(const File &);
+
+        std::unique_ptr<Interner> interner_;
+        std::unique_ptr<SourceManager> sources_;
+        std::unordered_map<std::string, std::unique_ptr<File>> files_;
+        std::uint64_t live_ = 0; // address space of the cached files
+        Stats stats_;
+    };
+
+    // runs one compiler invocation: its arguments, without the program name,
+    // and the streams standing in for stdout and stderr. returns the exit
+    // status.
+    using DaemonHandler = std::function<int(const std::vector<std::string> &args, std::ostream &out, std::ostream &err)>;
+
+    // serves compile requests on a Unix domain socket at path, one at a
+    // time, until a client sends --shutdown. each request runs in the
+    // client's working directory; its output is buffered and sent back when
+    // it finishes. the socket is only accessible to the current user. throws
+    // std::runtime_error when the socket cannot be set up, or on platforms
+    // without Unix domain sockets.
+    void ServeDaemon(const std::string &path, const DaemonHandler &);
+
+    // sends args to the daemon at path and copies its output to out and err.
+    // returns the exit status, or nothing when no daemon answers there.
+    std::optional<int> SendToDaemon(const std::string &path, const std::vector<std::string> &args, std::ostream &out,
+                                    std::ostream &err);
+
+}
+
+#endif // DAEMON_H
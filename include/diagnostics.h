@@ -0,0 +1,69 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tinycsharp
+{
+    enum class Severity
+    {
+        kError,
+        kWarning,
+    };
+
+    struct Diagnostic
+    {
+        Severity severity;
+        std::string file;
+        int line;
+        int column;
+        std::string message;
+    };
+
+    inline bool HasErrors(const std::vector<Diagnostic> &diags)
+    {
+        for (const auto &d : diags)
+        {
+            if (d.severity == Severity::kError)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    inline std::ostream &operator<<(std::ostream &os, const Diagnostic &d)
+    {
+        if (!d.file.empty())
+        {
+            os << d.file << ":";
+        }
+        os << d.line << ":" << d.column << ": "
+           << (d.severity == Severity::kError ? "error: " : "warning: ") << d.message;
+        return os;
+    }
+
+}
+
+#endif // DIAGNOSTICS_H
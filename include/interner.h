@@ -0,0 +1,70 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#ifndef INTERNER_H
+#define INTERNER_H
+
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <vector>
+#include "arena.h"
+
+namespace tinycsharp
+{
+    // dense id of an interned identifier. 0 is never handed out.
+    using SymbolId = std::uint32_t;
+    constexpr SymbolId kNoSymbol = 0;
+
+    // maps identifier spellings to small integer ids so later passes compare
+    // and hash names as integers. spellings are stored once and stay valid for
+    // the life of the interner. Intern() is safe to call from several threads.
+    class Interner
+    {
+    public:
+        Interner();
+        ~Interner() = default;
+        Interner(const Interner &) = delete;
+        Interner &operator=(const Interner &) = delete;
+
+        SymbolId Intern(std::string_view);
+        // kNoSymbol when the spelling was never interned.
+        SymbolId Find(std::string_view) const;
+        std::string_view Spelling(SymbolId) const;
+        std::size_t Size() const;
+
+    private:
+        static std::uint32_t Hash(std::string_view);
+        SymbolId FindLocked(std::string_view, std::uint32_t hash, std::size_t &slot) const;
+        void Grow();
+
+        struct Slot
+        {
+            std::uint32_t hash = 0;
+            SymbolId id = kNoSymbol;
+        };
+
+        Arena arena_;
+        std::vector<Slot> slots_;
+        std::vector<std::string_view> spellings_;
+        mutable std::mutex mu_;
+    };
+
+}
+
+#endif // INTERNER_H
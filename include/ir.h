@@ -0,0 +1,395 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#ifndef IR_H
+#define IR_H
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "arena.h"
+
+namespace tinycsharp
+{
+    struct MethodInfo;
+    struct Type;
+    class GlobalSymbols;
+    struct BodyTask;
+    class ThreadPool;
+
+    // 32-bit reference to the value an instruction defines: its index in
+    // IrFunction::insts. blocks are likewise referred to by index.
+    using ValueId = std::uint32_t;
+    using BlockId = std::uint32_t;
+    constexpr ValueId kNoValue = 0xffffffffu;
+
+    // machine-level type of an IR value. every C# reference type (string,
+    // object, classes, arrays, tasks) is kRef.
+    enum class IrType : std::uint8_t
+    {
+        kVoid,
+        kBool,
+        kChar,
+        kI32,
+        kI64,
+        kF32,
+        kF64,
+        kRef,
+    };
+
+    const char *IrTypeToString(IrType);
+    IrType IrTypeOf(const Type *);
+    inline bool IsIntegralIrType(IrType t) { return t == IrType::kBool || t == IrType::kChar || t == IrType::kI32 || t == IrType::kI64; }
+    inline bool IsFloatIrType(IrType t) { return t == IrType::kF32 || t == IrType::kF64; }
+
+    // operand use per opcode (a, b, c are the IrInst fields):
+    //   kConst       integral/bool/char/float bits in b:c (Imm()); kRef: aux 1
+    //                is string a, aux 0 is null
+    //   kParam       a = parameter index (0 is 'this' for instance methods)
+    //   kPhi         operands list a, count b; one per predecessor, in order
+    //   binary ops   a, b; integer ops wrap, like unchecked C#
+    //   kNeg, kNot   a
+    //   compares     a, b; aux = operand IrType, result kBool
+    //   kConvert     a; aux = source IrType, type = target
+    //   kStrEq       a, b (string value equality)
+    //   kConcat      a, b (strings)
+    //   kToString    a; aux = source IrType
+    //   kLoadField   a = object, c = slot     kStoreField  a = object, b = value, c = slot
+    //   kLoadStatic  c = slot                 kStoreStatic b = value, c = slot
+    //   kNewObject   c = class id             kNewArray    a = length, aux = element IrType
+    //   kLoadElem    a = array, b = index     kStoreElem   a = array, b = index, c = value
+    //   kArrayLength, kStringLength a         kCheckCast   a, c = class id
+    //   kCharAt      a = string, b = index
+    //   kCall        operands list a, count b, c = method id ('this' first)
+    //   kCallVirtual as kCall; dispatched through the receiver's vtable;
+    //                aux = 1 + the receiver's static class id, 0 if unknown
+    //   kCallBuiltin operands list a, count b, c = Builtin; for Builtin::kNone
+    //                (a library member the compiler cannot see) the first
+    //                operand is a string naming it, "new T" for constructors
+    //   kCallInit    a = object, c = class id; runs instance field initializers
+    //   kAwait       a = task
+    //   kJump        a = target block
+    //   kBranch      a = condition, b = true block, c = false block
+    //   kReturn      a = value or kNoValue
+    //   kThrow       a = exception
+#define TINYCSHARP_IR_OPS(X) \
+    X(Nop)                   \
+    X(Const)                 \
+    X(Param)                 \
+    X(Phi)                   \
+    X(Add)                   \
+    X(Sub)                   \
+    X(Mul)                   \
+    X(Div)                   \
+    X(Rem)                   \
+    X(And)                   \
+    X(Or)                    \
+    X(Xor)                   \
+    X(Shl)                   \
+    X(Shr)                   \
+    X(Neg)                   \
+    X(Not)                   \
+    X(Eq)                    \
+    X(Ne)                    \
+    X(Lt)                    \
+    X(Le)                    \
+    X(Gt)                    \
+    X(Ge)                    \
+    X(Convert)               \
+    X(StrEq)                 \
+    X(Concat)                \
+    X(ToString)              \
+    X(LoadField)             \
+    X(StoreField)            \
+    X(LoadStatic)            \
+    X(StoreStatic)           \
+    X(NewObject)             \
+    X(NewArray)              \
+    X(LoadElem)              \
+    X(StoreElem)             \
+    X(ArrayLength)           \
+    X(StringLength)          \
+    X(CharAt)                \
+    X(CheckCast)             \
+    X(Call)                  \
+    X(CallVirtual)           \
+    X(CallBuiltin)           \
+    X(CallInit)              \
+    X(Await)                 \
+    X(Jump)                  \
+    X(Branch)                \
+    X(Return)                \
+    X(Throw)
+
+    enum class IrOp : std::uint8_t
+    {
+#define TINYCSHARP_IR_OP_KIND(Name) k##Name,
+        TINYCSHARP_IR_OPS(TINYCSHARP_IR_OP_KIND)
+#undef TINYCSHARP_IR_OP_KIND
+    };
+
+    const char *IrOpToString(IrOp);
+    inline bool IsTerminator(IrOp op) { return op >= IrOp::kJump; }
+    inline bool IsCall(IrOp op) { return op >= IrOp::kCall && op <= IrOp::kCallInit; }
+    inline bool IsBinary(IrOp op) { return op >= IrOp::kAdd && op <= IrOp::kShr; }
+    inline bool IsCompare(IrOp op) { return op >= IrOp::kEq && op <= IrOp::kGe; }
+    // false when the instruction can be dropped if its value is unused: no
+    // stores, calls, allocation-visible effects or traps.
+    bool HasSideEffects(IrOp);
+    // which of the a, b, c fields hold value references (bits 0, 1, 2); the
+    // other fields are immediates, slots or block ids. a kNoValue field is
+    // an absent operand.
+    std::uint8_t ValueOperandMask(IrOp);
+    // phis and calls keep their operands in a separate list.
+    inline bool HasOperandList(IrOp op) { return op == IrOp::kPhi || (IsCall(op) && op != IrOp::kCallInit); }
+
+    struct IrInst
+    {
+        IrOp op = IrOp::kNop;
+        IrType type = IrType::kVoid;
+        std::uint16_t aux = 0;
+        ValueId a = kNoValue;
+        ValueId b = kNoValue;
+        ValueId c = kNoValue;
+
+        std::int64_t Imm() const { return static_cast<std::int64_t>((static_cast<std::uint64_t>(c) << 32) | b); }
+        double FloatImm() const
+        {
+            std::uint64_t bits = (static_cast<std::uint64_t>(c) << 32) | b;
+            double d;
+            std::memcpy(&d, &bits, sizeof d);
+            return d;
+        }
+        void SetImm(std::int64_t v)
+        {
+            b = static_cast<std::uint32_t>(static_cast<std::uint64_t>(v));
+            c = static_cast<std::uint32_t>(static_cast<std::uint64_t>(v) >> 32);
+        }
+        void SetFloatImm(double d)
+        {
+            std::uint64_t bits;
+            std::memcpy(&bits, &d, sizeof bits);
+            SetImm(static_cast<std::int64_t>(bits));
+        }
+    };
+    static_assert(sizeof(IrInst) == 16, "IrInst is meant to stay 16 bytes");
+
+    // a basic block is a contiguous range of instructions: its phis first,
+    // then ordinary instructions, then exactly one terminator.
+    struct IrBlock
+    {
+        std::uint32_t begin = 0;
+        std::uint32_t end = 0;
+        std::uint32_t pred_begin = 0;
+        std::uint32_t pred_count = 0;
+    };
+
+    template <typename T>
+    struct IrSpan
+    {
+        const T *data = nullptr;
+        std::uint32_t count = 0;
+
+        const T *begin() const { return data; }
+        const T *end() const { return data + count; }
+        const T &operator[](std::size_t i) const { return data[i]; }
+        std::size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+    };
+
+    // one lowered method in SSA form. every array lives in the function's own
+    // arena, so functions can be built and rewritten on different threads.
+    class IrFunction
+    {
+    public:
+        IrFunction() = default;
+        IrFunction(const IrFunction &) = delete;
+        IrFunction &operator=(const IrFunction &) = delete;
+
+        std::string name;
+        const MethodInfo *method = nullptr; // null for synthesized functions
+        IrType return_type = IrType::kVoid;
+        std::vector<IrType> param_types;     // including 'this'
+
+        std::uint32_t NumInsts() const { return num_insts_; }
+        std::uint32_t NumBlocks() const { return num_blocks_; }
+        const IrInst &Inst(ValueId v) const { return insts_[v]; }
+        IrInst &MutableInst(ValueId v) { return insts_[v]; }
+        const IrBlock &Block(BlockId b) const { return blocks_[b]; }
+        int Line(ValueId v) const { return lines_[v]; }
+        IrSpan<ValueId> Operands(const IrInst &) const;
+        IrSpan<BlockId> Preds(BlockId) const;
+        // targets of the block's terminator.
+        std::uint32_t Successors(BlockId, BlockId out[2]) const;
+        std::string_view String(std::uint32_t i) const { return strings_[i]; }
+        std::uint32_t NumStrings() const { return num_strings_; }
+        const IrInst &Terminator(BlockId b) const { return insts_[blocks_[b].end - 1]; }
+        std::size_t BytesUsed() const { return arena_.BytesUsed(); }
+
+    private:
+        friend class IrBuilder;
+
+        Arena arena_{16 * 1024};
+        IrInst *insts_ = nullptr;
+        int *lines_ = nullptr;
+        std::uint32_t num_insts_ = 0;
+        IrBlock *blocks_ = nullptr;
+        std::uint32_t num_blocks_ = 0;
+        ValueId *operands_ = nullptr;
+        std::uint32_t num_operands_ = 0;
+        BlockId *preds_ = nullptr;
+        std::uint32_t num_preds_ = 0;
+        std::string_view *strings_ = nullptr;
+        std::uint32_t num_strings_ = 0;
+    };
+
+    // builds an IrFunction. instructions are appended to per-block lists
+    // while the CFG is still growing and Finalize() lays them out into the
+    // function's flat arrays. local variables are put into SSA form on the
+    // fly (Braun et al., "Simple and Efficient Construction of Static Single
+    // Assignment Form"): reads look the variable up through the
+    // predecessors and place phis only where definitions meet.
+    class IrBuilder
+    {
+    public:
+        IrBuilder(std::string name, IrType return_type, std::vector<IrType> param_types);
+        // a builder holding a copy of an existing function, for passes that
+        // restructure it. variables are not available on such a builder.
+        explicit IrBuilder(const IrFunction &);
+
+        BlockId NewBlock();
+        void SetBlock(BlockId);
+        BlockId CurrentBlock() const { return current_; }
+        // true once the current block has its terminator.
+        bool IsTerminated() const;
+        void SetLine(int line) { line_ = line; }
+        void SetMethod(const MethodInfo *method) { method_ = method; }
+
+        ValueId Emit(IrOp, IrType, ValueId a = kNoValue, ValueId b = kNoValue, ValueId c = kNoValue, std::uint16_t aux = 0);
+        ValueId EmitList(IrOp, IrType, const std::vector<ValueId> &operands, std::uint32_t c, std::uint16_t aux = 0);
+        ValueId ConstInt(IrType, std::int64_t);
+        ValueId ConstFloat(IrType, double);
+        ValueId ConstString(std::string_view);
+        ValueId ConstNull();
+        void Jump(BlockId target);
+        void Branch(ValueId cond, BlockId if_true, BlockId if_false);
+        void Return(ValueId value);
+
+        // SSA construction over numbered variables.
+        std::uint32_t NewVariable(IrType);
+        void WriteVariable(std::uint32_t var, ValueId);
+        ValueId ReadVariable(std::uint32_t var);
+        // no more predecessors will be added to the block.
+        void SealBlock(BlockId);
+
+        // raw access for passes working on a copied function. killed
+        // instructions stay in the block lists as kNop until Finalize().
+        IrInst &At(ValueId v) { return insts_[v]; }
+        const IrInst &At(ValueId v) const { return insts_[v]; }
+        int LineOf(ValueId v) const { return lines_[v]; }
+        std::vector<ValueId> &ListOf(ValueId v) { return lists_[insts_[v].a]; }
+        std::vector<ValueId> &BlockPhis(BlockId b) { return blocks_[b].phis; }
+        std::vector<ValueId> &BlockInsts(BlockId b) { return blocks_[b].insts; }
+        std::vector<BlockId> &BlockPreds(BlockId b) { return blocks_[b].preds; }
+        std::uint32_t NumBlocks() const { return static_cast<std::uint32_t>(blocks_.size()); }
+        std::uint32_t NumValues() const { return static_cast<std::uint32_t>(insts_.size()); }
+        std::string_view StringAt(std::uint32_t i) const { return strings_[i]; }
+        std::uint32_t InternString(std::string_view);
+        // appends inst to the end of block b, past any terminator; the
+        // caller keeps the block well formed. list operands are copied.
+        ValueId Insert(BlockId b, const IrInst &inst, int line, const std::vector<ValueId> *list = nullptr);
+        ValueId InsertPhi(BlockId b, IrType, std::vector<ValueId> operands);
+        // targets of b's terminator, or none while it has no terminator.
+        std::uint32_t Successors(BlockId b, BlockId out[2]) const;
+        // drops one from -> to edge: the predecessor entry and the matching
+        // phi operands. the terminator of from is left to the caller.
+        void RemoveEdge(BlockId from, BlockId to);
+        // uses of v are redirected to replacement when the function is laid out.
+        void Replace(ValueId v, ValueId replacement);
+        ValueId Resolve(ValueId) const;
+        // removes v from its block (its value must be unused or replaced).
+        void Kill(ValueId v) { insts_[v].op = IrOp::kNop; }
+
+        std::unique_ptr<IrFunction> Finalize();
+
+    private:
+        struct BuilderBlock
+        {
+            std::vector<ValueId> phis;
+            std::vector<ValueId> insts;
+            std::vector<BlockId> preds;
+            bool sealed = false;
+            std::vector<std::pair<std::uint32_t, ValueId>> incomplete_phis;
+        };
+
+        ValueId Append(BlockId, const IrInst &, bool phi);
+        ValueId ReadVariableIn(std::uint32_t var, BlockId);
+        void AddPhiOperands(std::uint32_t var, ValueId phi, BlockId);
+        void AddEdge(BlockId from, BlockId to);
+
+        std::string name_;
+        IrType return_type_;
+        std::vector<IrType> param_types_;
+        const MethodInfo *method_ = nullptr;
+        std::vector<IrInst> insts_;
+        std::vector<int> lines_;
+        std::vector<std::vector<ValueId>> lists_;
+        std::vector<BuilderBlock> blocks_;
+        std::vector<std::string> strings_;
+        std::vector<ValueId> replaced_;
+        std::vector<IrType> var_types_;
+        // current definition of each variable per block.
+        std::vector<std::vector<ValueId>> defs_;
+        BlockId current_ = 0;
+        int line_ = 0;
+    };
+
+    // a lowered program: one function per method with a body, indexed by
+    // MethodInfo::id, plus synthesized initializers.
+    struct IrModule
+    {
+        const GlobalSymbols *globals = nullptr;
+        std::vector<std::unique_ptr<IrFunction>> functions;
+        // function running a class's instance field initializers (its bases'
+        // first), by class id; -1 when there are none.
+        std::vector<std::int32_t> instance_init;
+        std::int32_t static_init = -1;
+        std::int32_t entry = -1; // static Main, if any
+        std::uint32_t num_static_slots = 0;
+
+        std::size_t NumInsts() const;
+    };
+
+    // lowers every analyzed body to SSA. each method is lowered by its own
+    // task, in parallel when a pool is given.
+    IrModule LowerToIr(const GlobalSymbols &, ThreadPool *pool = nullptr);
+
+    void PrintIr(std::ostream &, const IrFunction &);
+    void PrintIr(std::ostream &, const IrModule &);
+    // structural checks: operand ranges, phi placement and arity, one
+    // terminator per block, definitions dominating uses in straight-line
+    // code. returns an empty string when the function is well formed.
+    std::string VerifyIr(const IrFunction &);
+
+}
+
+#endif // IR_H
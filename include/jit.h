@@ -0,0 +1,98 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#ifndef JIT_H
+#define JIT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "bytecode.h"
+#include "runtime.h"
+
+namespace tinycsharp
+{
+    // how native code stopped: it returned value, or it reached pc, an
+    // instruction the interpreter has to run.
+    struct JitExit
+    {
+        Value value;
+        std::uint32_t pc;
+    };
+
+    // the machine code of one function, in executable memory of its own.
+    class JitFunction
+    {
+    public:
+        static constexpr std::uint32_t kNoEntry = 0xffffffffu;
+
+        ~JitFunction();
+        JitFunction(const JitFunction &) = delete;
+        JitFunction &operator=(const JitFunction &) = delete;
+
+        // the native address of the instruction at pc, or null for one the
+        // interpreter runs.
+        const void *Entry(std::uint32_t pc) const
+        {
+            return pc < entries_.size() && entries_[pc] != kNoEntry ? static_cast<const char *>(memory_) + entries_[pc] : nullptr;
+        }
+        // runs the function from entry on the frame regs. true when it
+        // returned, false when it left at exit->pc.
+        bool Run(Value *regs, JitExit *exit, const void *entry) const;
+        std::size_t CodeBytes() const { return size_; }
+
+    private:
+        friend class Jit;
+
+        JitFunction() = default;
+
+        void *memory_ = nullptr;
+        std::size_t size_ = 0;
+        std::vector<std::uint32_t> entries_; // code offset per pc
+    };
+
+    // baseline compiler from bytecode to x86-64 machine code, with no
+    // register allocation: every instruction becomes a fixed template
+    // working on the interpreter's own frame, so native code and the
+    // interpreter can take over from each other at any instruction. native
+    // code is entered at a function's start, at a loop's back edge (on
+    // stack replacement) or after a call returns, and leaves at whatever it
+    // does not compile: calls, allocation, most string operations, and
+    // every path that would throw, which the interpreter then runs again
+    // and reports exactly as it would have. native code never collects, so
+    // stack maps stay the interpreter's.
+    class Jit
+    {
+    public:
+        Jit(Heap &, const StringImage &, Value *statics);
+
+        // x86-64 on a Unix system, unless built with TINYCSHARP_NO_JIT.
+        static bool Supported();
+        // null when the code cannot be made executable.
+        std::unique_ptr<JitFunction> Compile(const BcFunction &) const;
+
+    private:
+        Heap &heap_;
+        const StringImage &strings_;
+        Value *statics_;
+    };
+
+}
+
+#endif // JIT_H
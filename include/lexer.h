@@ -20,6 +20,7 @@
 #define LEXER_H
 #include <string>
 #include <iostream>
+#include <vector>
 #include "token.h"
 
 namespace tinycsharp
@@ -33,14 +34,17 @@ namespace tinycsharp
         unsigned char c_char;
         unsigned char n_char;
         std::string source;
-        std::shared_ptr<int> line;
-        std::shared_ptr<int> column;
+        // where the text starts in its SourceManager; tokens are located
+        // from there.
+        SourceLocation base;
 
-        Lexer(std::string);
+        Lexer(std::string, SourceLocation base = {});
         Lexer() = default;
         ~Lexer() = default;
 
         Token Lex();
+        // Lex the whole source, including the trailing kTEof token.
+        std::vector<Token> Tokenize();
         void NextToken();
         char Peek();
         void ConsumeWhitespace();
@@ -52,7 +56,7 @@ namespace tinycsharp
         Token MakeStringLiteralToken();
         Token MakeNumericLiteralToken();
         Token NewToken(const TokenKind &, const std::string &, int);
-        Token NewToken(const TokenKind &, const std::string &, int, int);
+        Token NewToken(const TokenKind &, const std::string &, int, std::int64_t);
         Token NewToken(const TokenKind &, const std::string &, int, double);
         std::unique_ptr<Lexer> Clone() const;
 
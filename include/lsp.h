@@ -0,0 +1,144 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#ifndef LSP_H
+#define LSP_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "interner.h"
+#include "thread_pool.h"
+#include "token.h"
+
+namespace tinycsharp
+{
+    class Sema;
+    struct Node;
+
+    // the tokens of one document, kept current across edits. an edit re-lexes
+    // from the last token before it, resuming the lexer where it stood after
+    // that token, and stops once the lexer is back in step with an old token
+    // past the edit; the tokens after that one are reused, shifted by the
+    // bytes the edit added or removed. token locations are offsets into the
+    // text.
+    class TokenStream
+    {
+    public:
+        void Reset(std::string text);
+        // replaces length bytes at offset with text.
+        void Edit(std::size_t offset, std::size_t length, std::string_view text);
+
+        const std::string &text() const { return text_; }
+        const std::vector<Token> &tokens() const { return tokens_; }
+        // a copy for the parser, which consumes its tokens, located from the
+        // start of the text's file in a SourceManager.
+        std::vector<Token> CopyTokens(SourceLocation base) const;
+        // tokens lexed by the last Reset() or Edit().
+        std::size_t relexed() const { return relexed_; }
+        // set when the text does not lex; the tokens are then just the end
+        // of file.
+        const std::string &error() const { return error_; }
+        int error_line() const { return error_line_; }
+
+    private:
+        void Relex(std::size_t keep, long delta, long edit_end);
+
+        std::string text_;
+        std::vector<Token> tokens_;
+        // the lexer's position after each token.
+        std::vector<int> after_;
+        std::size_t relexed_ = 0;
+        std::string error_;
+        int error_line_ = 0;
+    };
+
+    // a Language Server Protocol server: JSON-RPC messages with
+    // Content-Length framing. documents are synced incrementally and
+    // re-lexed through a TokenStream; all open documents are analyzed
+    // together as one program once no message is waiting, or before a
+    // request needs fresh results. diagnostics are published after each
+    // analysis. hover and go-to-definition look the name up in a per-line
+    // index of the document's names and the declarations they bind to, kept
+    // with the analysis that produced it. a request is cancelled when a
+    // newer edit of its document, or a $/cancelRequest for it, is already
+    // queued.
+    class LanguageServer
+    {
+    public:
+        explicit LanguageServer(std::ostream &out, unsigned jobs = 0);
+        ~LanguageServer();
+        LanguageServer(const LanguageServer &) = delete;
+        LanguageServer &operator=(const LanguageServer &) = delete;
+
+        // queues one message body. safe to call from a reader thread.
+        void Post(std::string message);
+        // no more messages will be posted.
+        void Close();
+        // handles messages until exit, or until the input is closed and
+        // drained. returns the process exit code.
+        int Serve();
+
+        // a parsed protocol message, or part of one.
+        struct Json;
+
+    private:
+        struct Document;
+        struct Symbol;
+
+        void Handle(const Json &message);
+        void Reply(const Json &id, Json result);
+        void ReplyError(const Json &id, int code, const std::string &message);
+        void Send(const Json &message);
+        bool IsStale(const Json &request);
+        void Change(const Json &params);
+        void Analyze();
+        void Index(Document &);
+        const Symbol *SymbolAt(const Json &params, Document *&doc);
+        Document *DocumentOf(const Node *decl, Document &from);
+        Json Location(const Node *decl, Document &from);
+
+        std::ostream &out_;
+        ThreadPool pool_;
+        Interner interner_;
+        std::unordered_map<std::string, std::unique_ptr<Document>> documents_;
+        // the last analysis, which the documents' syntax trees point into.
+        std::unique_ptr<Sema> sema_;
+        bool dirty_ = false;
+        bool shutdown_ = false;
+
+        std::mutex mu_;
+        std::condition_variable cv_;
+        std::deque<std::string> queue_;
+        bool closed_ = false;
+    };
+
+    // runs a LanguageServer on framed messages from in, replying on out.
+    int RunLanguageServer(std::istream &in, std::ostream &out);
+
+}
+
+#endif // LSP_H
@@ -0,0 +1,162 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#ifndef METADATA_H
+#define METADATA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace tinycsharp
+{
+    class GlobalSymbols;
+
+    // a reference metadata module: the public surface of a compiled
+    // library, so a program can be checked against it without its sources.
+    // all integers are little-endian; strings are a u32 length and the bytes,
+    // named by their offset in the file (0 is no string).
+    //
+    //     header      "TCSM", version, type count, index slots, index offset,
+    //                 namespace count, namespaces offset, file size
+    //     index       slots of (u32 name hash, u32 type offset), open
+    //                 addressed with linear probing; offset 0 is empty
+    //     namespaces  sorted string offsets, including every prefix
+    //     types       name, base, flags, instance slots, member count,
+    //                 members offset (24 bytes each)
+    //     members     kind, flags, parameter count, name, type, parameters
+    //                 offset or field slot, u64 value of a const (24 bytes)
+    //     parameters  (name, type) string offset pairs
+    //     strings
+    //
+    // types are spelled as TypeToString() prints them.
+    struct MetadataMember
+    {
+        enum Kind : std::uint8_t
+        {
+            kField,
+            kMethod,
+            kCtor,
+        };
+        enum Flags : std::uint8_t
+        {
+            kStatic = 1u << 0,
+            kConst = 1u << 1,
+            kReadonly = 1u << 2,
+            kVirtual = 1u << 3,
+            kAbstract = 1u << 4,
+            kOverride = 1u << 5,
+            kAsync = 1u << 6,
+        };
+
+        Kind kind = kField;
+        std::uint8_t flags = 0;
+        std::string_view name;
+        std::string_view type; // a field's type or a method's return type
+        std::vector<std::pair<std::string_view, std::string_view>> params; // name, type
+        std::uint32_t slot = 0; // of a non-const field
+        // a const's value: the integer, the bits of the double, or the
+        // offset of the string.
+        std::uint64_t value = 0;
+    };
+
+    struct MetadataType
+    {
+        enum Flags : std::uint32_t
+        {
+            kStruct = 1u << 0,
+            kSealed = 1u << 1,
+            kAbstract = 1u << 2,
+            kStatic = 1u << 3,
+        };
+
+        std::string_view name; // qualified
+        std::string_view base; // qualified, empty when none
+        std::uint32_t flags = 0;
+        std::uint32_t instance_slots = 0;
+        std::vector<MetadataMember> members;
+    };
+
+    // an open module. the file is mapped, not read: opening checks only the
+    // header, and a type's record and member table are decoded on its first
+    // lookup. the strings handed out point into the mapping, so the module
+    // must outlive every analysis that references it. safe to use from
+    // several threads.
+    class MetadataModule
+    {
+    public:
+        static constexpr std::uint32_t kVersion = 1;
+
+        // throws std::runtime_error when the file cannot be read or is not
+        // a module.
+        static std::unique_ptr<MetadataModule> Open(const std::string &path);
+        // a module held in memory; name stands in for the path.
+        static std::unique_ptr<MetadataModule> FromBytes(std::string bytes, const std::string &name);
+        ~MetadataModule();
+        MetadataModule(const MetadataModule &) = delete;
+        MetadataModule &operator=(const MetadataModule &) = delete;
+
+        const std::string &path() const { return path_; }
+        std::uint32_t type_count() const { return type_count_; }
+        // a type by qualified name, or null. a malformed record reads as
+        // missing.
+        const MetadataType *FindType(std::string_view qualified_name) const;
+        // a namespace the module declares a type in, or a prefix of one.
+        bool HasNamespace(std::string_view) const;
+        // a string of the module, by offset; used for string constants.
+        std::string_view String(std::uint32_t offset) const;
+        // types decoded so far.
+        std::size_t decoded_types() const;
+
+    private:
+        MetadataModule(std::string path, const char *data, std::size_t size);
+        bool Read32(std::size_t offset, std::uint32_t &out) const;
+        bool ReadString(std::uint32_t offset, std::string_view &out) const;
+        const MetadataType *Decode(std::uint32_t offset) const;
+
+        std::string path_;
+        const char *data_ = nullptr;
+        std::size_t size_ = 0;
+        void *mapping_ = nullptr; // set when data_ is mapped
+        std::string bytes_;       // otherwise the data
+        std::uint32_t type_count_ = 0;
+        std::uint32_t index_slots_ = 0;
+        std::uint32_t index_offset_ = 0;
+        std::uint32_t namespace_count_ = 0;
+        std::uint32_t namespaces_offset_ = 0;
+
+        mutable std::mutex mu_;
+        mutable std::unordered_map<std::uint32_t, std::unique_ptr<MetadataType>> decoded_;
+    };
+
+    // writes the public surface of an analyzed program: its public classes,
+    // with their public and protected members and the values of their
+    // consts. nested classes are written when they and their outer classes
+    // are public. the program must have analyzed without errors.
+    void WriteMetadata(std::ostream &, const GlobalSymbols &);
+
+}
+
+#endif // METADATA_H
@@ -19,16 +19,85 @@
 #ifndef PARSER_H
 #define PARSER_H
 
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ast.h"
+#include "token.h"
+
 namespace tinycsharp
 {
 
+    class ParseError : public std::runtime_error
+    {
+    public:
+        ParseError(const std::string &message, int line, int column);
+        int line;
+        int column;
+    };
+
+    // recursive descent parser for the C# subset the lexer understands. nodes
+    // are allocated in the AstContext handed in, and the finished unit is
+    // appended to its units list. the parser stops at the first error by
+    // throwing ParseError. tokens handed in are located in the context's
+    // SourceManager; parsing source loads it there first.
     class Parser
     {
     public:
-        Parser() = default;
+        Parser(AstContext &, std::vector<Token>, std::string_view file = "");
+        Parser(AstContext &, const std::string &source, std::string_view file = "");
         ~Parser() = default;
+
+        CompilationUnit *ParseCompilationUnit();
+
+    private:
+        const Token &Peek(std::size_t ahead = 0) const;
+        const Token &Current() const { return Peek(0); }
+        const Token &Advance();
+        bool Check(TokenKind) const;
+        bool Match(TokenKind);
+        const Token &Expect(TokenKind, const char *what);
+        [[noreturn]] void Error(const std::string &message) const;
+        std::string_view ExpectIdent(const char *what);
+
+        bool IsClassKeyword(const Token &) const;
+        bool IsModifier(const Token &) const;
+        Modifiers ParseModifiers();
+        std::string_view ParseQualifiedName();
+
+        UsingDirective *ParseUsing();
+        NamespaceDecl *ParseNamespace(NamespaceDecl *outer);
+        void ParseNamespaceBody(NamespaceDecl *ns, std::vector<UsingDirective *> &usings, std::vector<Node *> &members, bool braced);
+        ClassDecl *ParseClass(Modifiers, NamespaceDecl *ns, ClassDecl *outer);
+        void ParseMember(ClassDecl *owner, std::vector<Node *> &members);
+        MethodDecl *ParseMethodRest(ClassDecl *owner, Modifiers, TypeRef *return_type, const Token &name);
+        void ParsePropertyRest(FieldDecl *field);
+        TypeRef *ParseType();
+        bool TryParseType(TypeRef *&out);
+        bool StartsType(const Token &) const;
+
+        BlockStmt *ParseBlock();
+        Node *ParseStatement();
+        Node *ParseLocalVar(TypeRef *type, bool is_const);
+        bool LooksLikeLocalDecl();
+
+        Expr *ParseExpression();
+        Expr *ParseAssignment();
+        Expr *ParseConditional();
+        Expr *ParseBinary(int min_prec);
+        Expr *ParseUnary();
+        Expr *ParsePostfix(Expr *);
+        Expr *ParsePrimary();
+        NodeList<Expr> ParseArguments();
+
+        AstContext &ctx_;
+        std::vector<Token> tokens_;
+        std::size_t pos_ = 0;
+        std::string_view file_;
+        CompilationUnit *unit_ = nullptr;
     };
 
 }
 
-#endif // PARSER_H
\ No newline at end of file
+#endif // PARSER_H
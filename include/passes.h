@@ -0,0 +1,117 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#ifndef PASSES_H
+#define PASSES_H
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ir.h"
+
+namespace tinycsharp
+{
+    class ThreadPool;
+
+    enum class OptLevel : std::uint8_t
+    {
+        kO0, // no optimization: the IR as lowered
+        kO1, // cheap cleanups: constant folding, value numbering, dead code
+        kO2, // O1 plus devirtualization, inlining and loop-invariant code motion
+    };
+
+    // accepts -O0, -O1, -O2 (and the same without the dash).
+    OptLevel ParseOptLevel(std::string_view);
+
+    struct PassStats
+    {
+        std::string pass;
+        double millis = 0;
+        std::uint64_t changes = 0;
+        std::uint32_t functions_changed = 0;
+        std::size_t insts_before = 0;
+        std::size_t insts_after = 0;
+    };
+
+    // one transformation of a single function. a pass rewrites the function
+    // through a builder holding a copy of it and sees the rest of the module
+    // read-only, as it was when the pass started, so it can run on every
+    // function of the module at once.
+    class IrPass
+    {
+    public:
+        virtual ~IrPass() = default;
+        virtual const char *Name() const = 0;
+        // returns the number of changes made; 0 means the builder is
+        // untouched and the function is kept as it was.
+        virtual std::uint32_t Run(IrBuilder &, const IrFunction &, const IrModule &) const = 0;
+    };
+
+    // removes instructions whose value is never used and that have no side
+    // effects, and turns branches on a constant into jumps.
+    std::unique_ptr<IrPass> MakeDeadCodeElimination();
+    // dominator-scoped value numbering with constant folding and algebraic
+    // simplification: a computation dominated by an identical one reuses it.
+    std::unique_ptr<IrPass> MakeGlobalValueNumbering();
+    // turns virtual calls into direct ones when class hierarchy analysis
+    // leaves a single target: the receiver is sealed, freshly allocated, or
+    // no class below its static type overrides the method. a receiver that
+    // may be null is tested first, so the call still faults on it.
+    std::unique_ptr<IrPass> MakeDevirtualization();
+    // inlines direct calls to functions of at most max_callee_insts
+    // instructions. virtual, recursive and async callees are left alone.
+    std::unique_ptr<IrPass> MakeInliner(std::uint32_t max_callee_insts);
+    // hoists side-effect-free computations whose operands do not change in
+    // a loop into the loop's preheader, creating one when needed.
+    std::unique_ptr<IrPass> MakeLoopInvariantCodeMotion();
+
+    // runs a pipeline of passes over a module. each pass runs over every
+    // function (in parallel when a pool is given) before the next one
+    // starts, and records its time and number of changes.
+    class PassManager
+    {
+    public:
+        explicit PassManager(ThreadPool *pool = nullptr) : pool_(pool) {}
+        PassManager(const PassManager &) = delete;
+        PassManager &operator=(const PassManager &) = delete;
+
+        void Add(std::unique_ptr<IrPass>);
+        // appends the standard pipeline for a level.
+        void AddPipeline(OptLevel);
+        // check every rewritten function with VerifyIr() and throw
+        // std::logic_error on the first broken one.
+        void SetVerify(bool verify) { verify_ = verify; }
+
+        void Run(IrModule &);
+
+        const std::vector<PassStats> &stats() const { return stats_; }
+        void PrintStats(std::ostream &) const;
+
+    private:
+        ThreadPool *pool_;
+        bool verify_ = false;
+        std::vector<std::unique_ptr<IrPass>> passes_;
+        std::vector<PassStats> stats_;
+    };
+
+}
+
+#endif // PASSES_H
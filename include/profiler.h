@@ -0,0 +1,141 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+#include "bytecode.h"
+
+namespace tinycsharp
+{
+    // where a Vm spends its time, as a tree of the call paths it ran. a
+    // sampling profiler takes a sample each time a CPU timer (SIGPROF) fires:
+    // the signal handler only counts the tick, and the interpreter records
+    // its frame stack and pc at the next dispatch, weighted by the ticks
+    // since the last one. an exact profiler counts every dispatch on the
+    // path of the frame running it, and every call. both keep counts per
+    // opcode and per bytecode pc, which BcFunction::lines maps back to the
+    // source.
+    class Profiler
+    {
+    public:
+        enum class Mode
+        {
+            kSample,
+            kExact,
+        };
+
+        explicit Profiler(Mode mode, std::chrono::microseconds interval = std::chrono::milliseconds(1));
+        ~Profiler();
+        Profiler(const Profiler &) = delete;
+        Profiler &operator=(const Profiler &) = delete;
+
+        Mode mode() const { return mode_; }
+        // false where there is no SIGPROF timer; Start() then throws.
+        static bool SamplingSupported();
+        // starts and stops the timer of a sampling profiler; one profiler
+        // samples at a time. an exact profiler needs neither.
+        void Start();
+        void Stop();
+
+        // set while timer ticks wait to be taken; read at every dispatch of
+        // a sampling run.
+        static bool Pending() { return ticks_.load(std::memory_order_relaxed) != 0; }
+        static std::uint32_t TakeTicks() { return ticks_.exchange(0, std::memory_order_relaxed); }
+
+        // the path events are counted on, from the outermost frame. the Vm
+        // keeps it in line with its frames through Truncate() and Enter().
+        std::size_t depth() const { return path_.size(); }
+        const BcFunction *FunctionAt(std::size_t depth) const { return nodes_[path_[depth]].fn; }
+        void Truncate(std::size_t depth) { path_.resize(depth); }
+        // a call of fn on top of the path.
+        void Enter(const BcFunction *fn);
+        // weight events at pc of fn, the top of the path.
+        void Count(const BcFunction *fn, const BcInst *pc, std::uint64_t weight);
+
+        struct Method
+        {
+            const BcFunction *fn = nullptr;
+            std::uint64_t self = 0;
+            // self plus the events of everything it called.
+            std::uint64_t total = 0;
+            // exact profiles only.
+            std::uint64_t calls = 0;
+            std::vector<std::uint64_t> pcs; // events per instruction word
+        };
+
+        // dispatches, or timer ticks, in all.
+        std::uint64_t events() const { return events_; }
+        // by self, most first.
+        std::vector<Method> Methods() const;
+        const std::array<std::uint64_t, 256> &opcodes() const { return opcodes_; }
+
+        // one line per call path with events of its own, "A;B;C count", in
+        // the folded format flamegraph.pl and speedscope read.
+        void WriteFolded(std::ostream &) const;
+        // the methods with the most events, each with its hottest
+        // instructions and their source lines, then the hottest opcodes.
+        void WriteReport(std::ostream &, std::size_t methods = 20, std::size_t instructions = 5) const;
+
+    private:
+        struct Node
+        {
+            const BcFunction *fn;
+            std::uint32_t parent;
+            std::uint64_t self = 0;
+            std::unordered_map<const BcFunction *, std::uint32_t> children;
+        };
+
+        struct Counts
+        {
+            std::uint64_t calls = 0;
+            std::vector<std::uint64_t> pcs;
+        };
+
+        Counts &CountsOf(const BcFunction *fn);
+        // the SIGPROF handler.
+        static void Tick(int);
+
+        static std::atomic<std::uint32_t> ticks_;
+        static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "the signal handler needs a lock-free counter");
+
+        Mode mode_;
+        std::chrono::microseconds interval_;
+        bool running_ = false;
+        std::vector<Node> nodes_; // the root, without a function, first
+        std::vector<std::uint32_t> path_;
+        std::unordered_map<const BcFunction *, Counts> counts_;
+        // the function counted last, whose Counts the next event most
+        // likely goes to.
+        const BcFunction *last_fn_ = nullptr;
+        Counts *last_counts_ = nullptr;
+        std::uint64_t events_ = 0;
+        std::array<std::uint64_t, 256> opcodes_ = {};
+    };
+
+}
+
+#endif // PROFILER_H
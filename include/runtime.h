@@ -0,0 +1,367 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#ifndef RUNTIME_H
+#define RUNTIME_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "bytecode.h"
+
+namespace tinycsharp
+{
+    struct Object;
+
+    // one register or heap slot. what it holds is known statically from the
+    // bytecode: ints are kept sign extended in i (bools and chars zero
+    // extended), floats in f, doubles in d.
+    union Value
+    {
+        std::int64_t i;
+        double d;
+        float f;
+        Object *ref;
+    };
+    static_assert(sizeof(Value) == 8, "a Value is one machine word");
+
+    inline Value IntValue(std::int64_t i)
+    {
+        Value v;
+        v.i = i;
+        return v;
+    }
+    inline Value RefValue(Object *ref)
+    {
+        Value v;
+        v.i = 0;
+        v.ref = ref;
+        return v;
+    }
+
+    enum class ObjectKind : std::uint8_t
+    {
+        kInstance, // info = class id; slots follow the header
+        kArray,    // info = length, type = element type; elements follow
+        kString,   // info = length; bytes follow, NUL terminated. strings are
+                   // byte strings, so chars above 0xff do not round trip
+        kBox,      // type = boxed type; one value follows
+        kTask,     // info = 1 once completed; a TaskPayload follows
+        kExternal, // an instance of a library type: name and message strings
+        kRope,     // info = length; a concatenation of two strings, built
+                   // lazily. once flattened, left is the flat text and right
+                   // null
+        kStateMachine, // info = function; a suspended async call, see
+                       // StateMachinePayload
+    };
+
+    // header shared by every heap object. payloads follow the header
+    // directly and are reached through the accessors below. objects move
+    // when collected; forward holds the new address while they do.
+    struct Object
+    {
+        Object *forward = nullptr;
+        ObjectKind kind = ObjectKind::kInstance;
+        std::uint8_t gc_bits = 0; // Heap::k* flags and the nursery age
+        IrType type = IrType::kVoid;
+        std::uint8_t flags = 0;
+        std::uint32_t info = 0;
+    };
+    static_assert(sizeof(Object) == 16, "object header is two words");
+
+    inline Value *Payload(Object *object) { return reinterpret_cast<Value *>(object + 1); }
+    inline const Value *Payload(const Object *object) { return reinterpret_cast<const Value *>(object + 1); }
+    inline char *StringData(Object *s) { return reinterpret_cast<char *>(s + 1); }
+    struct RopePayload
+    {
+        Object *left;
+        Object *right;
+    };
+    inline RopePayload *Rope(Object *rope) { return reinterpret_cast<RopePayload *>(rope + 1); }
+    inline const RopePayload *Rope(const Object *rope) { return reinterpret_cast<const RopePayload *>(rope + 1); }
+    inline bool IsString(const Object *object) { return object->kind == ObjectKind::kString || object->kind == ObjectKind::kRope; }
+    inline bool IsFlat(const Object *s) { return s->kind == ObjectKind::kString || !Rope(s)->right; }
+    // the text of a flat string or a flattened rope.
+    inline std::string_view StringView(const Object *s)
+    {
+        if (s->kind == ObjectKind::kRope)
+            s = Rope(s)->left;
+        return std::string_view(reinterpret_cast<const char *>(s + 1), s->info);
+    }
+    // copies the text of any string, ropes included, to dest; it needs no
+    // allocation.
+    void CopyText(const Object *s, char *dest);
+    std::string StringText(const Object *s);
+
+    // the name of a library object's type and its message, for exceptions.
+    struct ExternalPayload
+    {
+        Object *name;
+        Object *message;
+    };
+    inline ExternalPayload *External(Object *object) { return reinterpret_cast<ExternalPayload *>(object + 1); }
+
+    // a task's (boxed) result once it completes, and until then the state
+    // machines suspended on it, linked through StateMachinePayload::next.
+    struct TaskPayload
+    {
+        Object *result;
+        Object *waiters;
+    };
+    inline TaskPayload *TaskOf(Object *task) { return reinterpret_cast<TaskPayload *>(task + 1); }
+
+    // an async call suspended at an await, created when it first suspends
+    // and reused for its later awaits. await numbers the function's
+    // BcAwaitPoint, task is the call's own Task, completed when the call
+    // returns. the registers the await point saves follow, references
+    // first.
+    struct StateMachinePayload
+    {
+        std::int64_t await;
+        Object *task;
+        Object *next;
+    };
+    inline StateMachinePayload *StateMachine(Object *machine) { return reinterpret_cast<StateMachinePayload *>(machine + 1); }
+    inline Value *SavedRegisters(Object *machine) { return reinterpret_cast<Value *>(StateMachine(machine) + 1); }
+
+    struct HeapStats
+    {
+        std::uint64_t collections = 0; // minor and major
+        std::uint64_t minor_collections = 0;
+        std::uint64_t major_collections = 0;
+        std::uint64_t objects_allocated = 0;
+        std::uint64_t bytes_allocated = 0;
+        std::uint64_t bytes_promoted = 0; // moved from the nursery to the old generation
+        std::uint64_t bytes_freed = 0;
+        std::size_t live_bytes = 0;       // in use now, garbage not yet found included
+    };
+
+    // generational garbage collected object heap. new objects are bump
+    // allocated in the nursery's eden through thread-local allocation
+    // buffers carved from it, so allocating is a pointer bump with no lock
+    // and no malloc. a full eden starts a minor collection, which copies
+    // the live young objects to a survivor space, or into the old
+    // generation once they have survived kTenureAge collections. the old
+    // generation is one contiguous region collected by mark-compact, which
+    // empties the nursery too; it runs when the old generation passes a
+    // threshold that grows with its live size. objects too big for the
+    // nursery are allocated old.
+    //
+    // collections move objects, so roots are precise and updatable: the
+    // owner supplies them through the root callback, which must hand every
+    // reference it holds to the visitor, and the visitor rewrites it. a
+    // reference stored into an old object must be reported to WriteBarrier
+    // so minor collections see it. collections stop the world: they run on
+    // the allocating thread and no other thread may touch the heap
+    // meanwhile.
+    class Heap
+    {
+    public:
+        using RootVisitor = std::function<void(Object *&)>;
+        using RootCallback = std::function<void(const RootVisitor &)>;
+
+        static constexpr std::uint8_t kMarked = 1;
+        static constexpr std::uint8_t kRemembered = 2;
+        static constexpr std::uint8_t kForwarded = 4;
+        // outside the collected heap, e.g. in a StringImage; never moved or
+        // freed.
+        static constexpr std::uint8_t kImmortal = 8;
+        static constexpr unsigned kAgeShift = 4;
+        static constexpr unsigned kTenureAge = 2;
+
+        // eden_bytes sizes the nursery; the old generation starts at four
+        // times that, at least 1MB.
+        explicit Heap(const BcProgram &, std::size_t eden_bytes = 8u << 20);
+        ~Heap();
+        Heap(const Heap &) = delete;
+        Heap &operator=(const Heap &) = delete;
+
+        void SetRoots(RootCallback roots) { roots_ = std::move(roots); }
+
+        // allocations may collect first, moving objects; references held
+        // outside the roots are stale afterwards.
+        Object *NewInstance(std::uint32_t cls);
+        Object *NewArray(IrType element, std::uint32_t length);
+        // text must not point into the heap.
+        Object *NewString(std::string_view);
+        // an uninitialized string of length bytes, for the caller to fill.
+        Object *NewString(std::size_t length);
+        Object *NewBox(IrType, Value);
+        Object *NewTask(bool completed, Object *result);
+        // sized for the function's await point that saves the most.
+        Object *NewStateMachine(std::uint32_t function);
+        Object *NewExternal();
+        // the concatenation of two non-empty strings, without copying them.
+        Object *NewRope(Object *left, Object *right);
+
+        // call after storing value into a field or element of holder.
+        void WriteBarrier(Object *holder, Object *value)
+        {
+            if (value && IsYoung(value) && !IsYoung(holder) && !(holder->gc_bits & kRemembered))
+                Remember(holder);
+        }
+        bool IsYoung(const Object *object) const
+        {
+            const char *p = reinterpret_cast<const char *>(object);
+            return p >= young_.get() && p < young_end_;
+        }
+
+        // a major collection of both generations.
+        void Collect() { CollectMajor(0); }
+        void CollectMinor();
+        // folds in the calling thread's allocation buffer first.
+        const HeapStats &stats();
+        // counts the calling thread's allocations so far, for a thread
+        // that hands the heap to another.
+        void FlushTlab() { RetireTlab(); }
+
+    private:
+        // a thread's allocation buffer in this heap: [top, end) is free.
+        // it is in use while its epoch is the heap's; every collection
+        // starts a new epoch, which drops all buffers.
+        struct Tlab
+        {
+            std::uint64_t epoch = 0;
+            char *start = nullptr;
+            char *top = nullptr;
+            char *end = nullptr;
+            std::uint64_t objects = 0;
+        };
+        // the heap a thread allocated from last and its buffer there. heap
+        // ids are never reused, so a matching id means a live buffer.
+        struct TlabCache
+        {
+            std::uint64_t heap = 0;
+            Tlab *tlab = nullptr;
+        };
+
+        Object *Allocate(ObjectKind, std::size_t payload_bytes);
+        char *AllocateSlow(std::size_t size);
+        char *AllocateOld(std::size_t size);
+        // the calling thread's buffer, made on its first allocation.
+        Tlab &OwnTlab();
+        void RetireTlab();
+        void NewEpoch();
+        void Remember(Object *);
+        void VisitRoots(const RootVisitor &);
+        Object *Evacuate(Object *);
+        void CollectMajor(std::size_t extra);
+        std::size_t YoungBytes() const;
+        static std::size_t SizeOf(const Object *, const BcProgram &);
+
+        static thread_local TlabCache tlab_cache_;
+
+        const BcProgram &program_;
+        RootCallback roots_;
+        std::uint64_t id_;
+        std::uint64_t epoch_ = 0;
+        // the nursery: eden, then two survivor spaces. objects are copied
+        // from the current survivor space (from) to the other one (to).
+        std::unique_ptr<char[]> young_;
+        char *young_end_ = nullptr;
+        char *eden_end_ = nullptr;
+        char *eden_top_ = nullptr;
+        char *survivors_[2] = {};
+        std::size_t survivor_bytes_ = 0;
+        unsigned from_ = 0;
+        char *from_top_ = nullptr;
+        char *to_top_ = nullptr;
+        std::size_t tlab_bytes_;
+        std::size_t large_object_bytes_;
+        std::mutex refill_mutex_;
+        // one buffer per thread that allocated here; nodes, so the cached
+        // pointers stay valid.
+        std::mutex tlabs_mutex_;
+        std::unordered_map<std::thread::id, Tlab> tlabs_;
+        // the old generation: [old_, old_top_) holds objects back to back.
+        std::unique_ptr<char[]> old_;
+        char *old_top_ = nullptr;
+        char *old_end_ = nullptr;
+        std::size_t old_threshold_;
+        std::size_t initial_old_threshold_;
+        // old objects that may hold references to young ones.
+        std::vector<Object *> remembered_;
+        // references the heap itself holds across an allocation.
+        std::vector<Object *> handles_;
+        std::vector<Object *> mark_stack_;
+        std::vector<Object *> young_live_;
+        HeapStats stats_;
+    };
+
+    // immortal strings laid out back to back in one block outside the
+    // collected heap: the program's literals, deduplicated when it was
+    // compiled, then the empty string and every one-byte string. loading a
+    // literal, "" or a char's string never allocates, and the collector
+    // neither scans nor moves them.
+    class StringImage
+    {
+    public:
+        explicit StringImage(const std::vector<std::string> &literals);
+
+        Object *Literal(std::uint32_t i) const { return objects_[i]; }
+        Object *Empty() const { return objects_[num_literals_]; }
+        Object *Char(unsigned char c) const { return objects_[num_literals_ + 1 + c]; }
+        std::size_t Bytes() const { return bytes_; }
+
+    private:
+        std::unique_ptr<std::uint64_t[]> memory_;
+        std::vector<Object *> objects_;
+        std::size_t num_literals_;
+        std::size_t bytes_ = 0;
+    };
+
+    // unchecked float to integer conversion, saturating like .NET 9:
+    // NaN becomes 0 and out of range values clamp.
+    template <typename T>
+    inline std::int64_t Saturate(double d)
+    {
+        if (std::isnan(d))
+            return 0;
+        if (d <= static_cast<double>(std::numeric_limits<T>::min()))
+            return std::numeric_limits<T>::min();
+        if (d >= static_cast<double>(std::numeric_limits<T>::max()))
+            return std::numeric_limits<T>::max();
+        return static_cast<std::int64_t>(static_cast<T>(d));
+    }
+
+    // a conversion between primitive types, as an unchecked C# cast does.
+    Value ConvertPrimitive(Value, IrType from, IrType to);
+
+    // C# formatting of values, as ToString() would produce.
+    std::string FormatDouble(double);
+    std::string FormatFloat(float);
+    std::string FormatValue(Value, IrType);
+    // Object.ToString() of a heap reference; classes print their full name.
+    std::string FormatObject(const Object *, const BcProgram &);
+    // System.Int32 and friends.
+    const char *ClrTypeName(IrType);
+    // runtime type of an object, as InvalidCastException messages name it.
+    std::string ObjectTypeName(const Object *, const BcProgram &);
+
+}
+
+#endif // RUNTIME_H
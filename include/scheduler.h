@@ -0,0 +1,110 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace tinycsharp
+{
+    // work-stealing scheduler for continuations. every worker owns a run
+    // queue: a job submitted from a worker goes to the back of that
+    // worker's queue and the worker takes its newest job first, so a chain
+    // of continuations stays on one core while its data is still cached.
+    // a worker with nothing left steals the oldest job from another's
+    // queue. jobs submitted from other threads are spread round robin.
+    // delayed jobs wait on a timer thread, which queues them when due. jobs
+    // must not throw.
+    class TaskScheduler
+    {
+    public:
+        using Job = std::function<void()>;
+        using Clock = std::chrono::steady_clock;
+
+        // 0 workers means one per hardware thread.
+        explicit TaskScheduler(unsigned workers = 0);
+        // stops first; see Stop().
+        ~TaskScheduler();
+        TaskScheduler(const TaskScheduler &) = delete;
+        TaskScheduler &operator=(const TaskScheduler &) = delete;
+
+        void Submit(Job);
+        void SubmitAfter(std::chrono::milliseconds, Job);
+        // jobs queued, running or waiting for their timer.
+        std::size_t Outstanding() const { return outstanding_.load(); }
+        // drops queued and delayed jobs and waits for running ones; not to
+        // be called from a job.
+        void Stop();
+
+        unsigned Size() const { return static_cast<unsigned>(queues_.size()); }
+        // jobs a worker took from another worker's queue.
+        std::uint64_t Steals() const { return steals_.load(); }
+
+    private:
+        struct RunQueue
+        {
+            std::mutex mu;
+            std::deque<Job> jobs;
+        };
+        struct Timer
+        {
+            Clock::time_point due;
+            std::uint64_t sequence; // keeps timers with one due time in order
+            Job job;
+            bool operator>(const Timer &other) const
+            {
+                return due != other.due ? due > other.due : sequence > other.sequence;
+            }
+        };
+
+        void Push(Job);
+        bool RunOne(unsigned worker);
+        void WorkerLoop(unsigned worker);
+        void TimerLoop();
+
+        std::vector<std::unique_ptr<RunQueue>> queues_;
+        std::vector<std::thread> workers_;
+        std::thread timer_thread_;
+        std::mutex mu_;
+        std::condition_variable work_cv_;
+        std::size_t queued_ = 0; // guarded by mu_
+        std::mutex timer_mu_;
+        std::condition_variable timer_cv_;
+        std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+        std::uint64_t next_sequence_ = 0;
+        bool stopping_ = false; // guarded by mu_ and timer_mu_
+        std::atomic<std::size_t> outstanding_{0};
+        std::atomic<unsigned> next_queue_{0};
+        std::atomic<std::uint64_t> steals_{0};
+    };
+
+}
+
+#endif // SCHEDULER_H
@@ -0,0 +1,327 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#ifndef SEMA_H
+#define SEMA_H
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "ast.h"
+#include "diagnostics.h"
+#include "interner.h"
+#include "types.h"
+
+namespace tinycsharp
+{
+    class ThreadPool;
+    class ConstantPool;
+    class AstContext;
+    class MetadataModule;
+
+    // library functions and members the checker knows the signature of.
+    enum class Builtin : std::uint16_t
+    {
+        kNone,
+        kConsoleWriteLine,
+        kConsoleWrite,
+        kMathAbs,
+        kMathMax,
+        kMathMin,
+        kMathSqrt,
+        kTaskFromResult,
+        kTaskYield,
+        kTaskDelay,
+        kTaskCompleted,
+        kStringLength,
+        kArrayLength,
+        kIntMaxValue,
+        kIntMinValue,
+        kLongMaxValue,
+        kLongMinValue,
+    };
+
+    const char *BuiltinToString(Builtin);
+
+    // classes visible by simple name in one namespace block of one file.
+    // lookups fall back to the parent (enclosing namespace, then the file).
+    struct ImportScope
+    {
+        const ImportScope *parent = nullptr;
+        std::unordered_map<SymbolId, ClassInfo *> classes;
+        // a using names a System namespace the compiler does not model, so
+        // unknown type names are assumed to come from the library.
+        bool has_external_usings = false;
+        // namespaces of referenced modules that are in scope, by using or
+        // by enclosing namespace.
+        std::vector<std::string> referenced_namespaces;
+
+        ClassInfo *Find(SymbolId) const;
+        bool AllowsExternalTypes() const;
+    };
+
+    struct FieldInfo
+    {
+        FieldDecl *decl = nullptr;
+        ClassInfo *owner = nullptr;
+        const Type *type = nullptr;
+        bool is_static = false;
+        bool is_const = false;
+        bool is_readonly = false;
+        // index into the object's slots for instance fields, or into the
+        // program-wide static slots. const fields have no storage.
+        std::uint32_t slot = 0;
+        const ConstValue *constant = nullptr; // value of a const field
+    };
+
+    struct MethodInfo
+    {
+        MethodDecl *decl = nullptr;
+        ClassInfo *owner = nullptr;
+        const Type *return_type = nullptr;
+        std::vector<const Type *> param_types;
+        bool is_static = false;
+        bool is_virtual = false; // virtual, abstract or override
+        bool is_abstract = false;
+        bool is_ctor = false;
+        bool is_async = false;
+        int vtable_slot = -1;
+        MethodInfo *overridden = nullptr;
+        std::uint32_t id = 0; // dense index into GlobalSymbols::methods()
+    };
+
+    struct ClassInfo
+    {
+        ClassDecl *decl = nullptr;
+        std::string qualified_name;
+        ClassInfo *base = nullptr;
+        ClassInfo *outer = nullptr;
+        const ImportScope *imports = nullptr;
+        const Type *type = nullptr;
+        std::uint32_t id = 0;
+        // the module a referenced class was loaded from. such a class is not
+        // part of classes(): it has no bodies to check or lower.
+        const MetadataModule *reference = nullptr;
+        bool is_sealed = false;
+        bool is_abstract = false;
+        bool is_static = false;
+
+        std::vector<FieldInfo *> fields; // declared here, in source order
+        std::vector<MethodInfo *> methods;
+        std::vector<MethodInfo *> ctors;
+        std::unordered_map<SymbolId, FieldInfo *> field_map;
+        std::unordered_map<SymbolId, std::vector<MethodInfo *>> method_map;
+        std::unordered_map<SymbolId, ClassInfo *> nested;
+
+        std::uint32_t instance_slots = 0; // including inherited fields
+        std::vector<MethodInfo *> vtable;
+
+        // searches this class, then its bases.
+        FieldInfo *FindField(SymbolId) const;
+        void FindMethods(SymbolId, std::vector<MethodInfo *> &out) const;
+        bool IsSubclassOf(const ClassInfo *) const;
+    };
+
+    // the program-wide view of every declaration, built by the declaration
+    // pass and read-only afterwards, so method bodies can be checked
+    // concurrently against it.
+    class GlobalSymbols
+    {
+    public:
+        GlobalSymbols(Interner &, TypeTable &);
+        ~GlobalSymbols();
+        GlobalSymbols(const GlobalSymbols &) = delete;
+        GlobalSymbols &operator=(const GlobalSymbols &) = delete;
+
+        const std::vector<ClassInfo *> &classes() const { return classes_; }
+        const std::vector<MethodInfo *> &methods() const { return methods_; }
+        const std::vector<FieldInfo *> &static_fields() const { return static_fields_; }
+        // a class of the program, else of the referenced modules, which is
+        // loaded on its first lookup.
+        ClassInfo *FindClass(std::string_view qualified_name) const;
+        // true for every namespace the program or a referenced module
+        // declares, and their prefixes.
+        bool IsNamespace(std::string_view name) const;
+        bool IsReferencedNamespace(std::string_view name) const;
+        // a class named as written in code: nested classes of the context
+        // and its outer classes first, then the imports, then a fully
+        // qualified name. dotted names may walk into nested classes.
+        ClassInfo *LookupClass(std::string_view name, const ClassInfo *context, const ImportScope *imports) const;
+        // the type a TypeRef names, seen from inside context. unknown names
+        // are reported to diags (when given) and resolve to the error type.
+        const Type *ResolveType(const TypeRef *, const ClassInfo *context, std::vector<Diagnostic> *diags) const;
+
+        Interner &interner() const { return interner_; }
+        TypeTable &types() const { return types_; }
+
+        // a module to load classes from that the program does not declare.
+        // added before the declaration pass; it must outlive this object.
+        void AddReference(const MetadataModule *module) { references_.push_back(module); }
+        const std::vector<const MetadataModule *> &references() const { return references_; }
+        // whether a using of a System namespace lets its scope name types
+        // the compiler does not model. set before the declaration pass.
+        void SetLibraryUsings(bool allowed) { library_usings_ = allowed; }
+        // the referenced classes loaded so far, in load order.
+        std::vector<ClassInfo *> ReferencedClasses() const;
+
+    private:
+        friend class DeclarationPass;
+
+        // under reference_mu_.
+        ClassInfo *FindReferenced(const std::string &qualified_name) const;
+        const Type *ReferencedType(std::string_view spelling) const;
+
+        Interner &interner_;
+        TypeTable &types_;
+        std::deque<ClassInfo> class_storage_;
+        std::deque<FieldInfo> field_storage_;
+        std::deque<MethodInfo> method_storage_;
+        std::deque<ImportScope> scope_storage_;
+        std::vector<ClassInfo *> classes_;
+        std::vector<MethodInfo *> methods_;
+        std::vector<FieldInfo *> static_fields_;
+        std::unordered_map<std::string, ClassInfo *> by_qualified_name_;
+        std::unordered_set<std::string> namespaces_;
+        bool library_usings_ = true;
+
+        // classes loaded from references_, null for names none of them has.
+        std::vector<const MetadataModule *> references_;
+        mutable std::mutex reference_mu_;
+        mutable std::unique_ptr<AstContext> reference_ast_;
+        mutable std::deque<ClassInfo> reference_classes_;
+        mutable std::deque<FieldInfo> reference_fields_;
+        mutable std::deque<MethodInfo> reference_methods_;
+        std::unique_ptr<ConstantPool> reference_constants_;
+        mutable std::unordered_map<std::string, ClassInfo *> referenced_;
+        mutable std::vector<ClassInfo *> referenced_order_;
+    };
+
+    // collects every class, field and method signature of the program into
+    // GlobalSymbols: qualified names, base classes, field slots and vtables.
+    class DeclarationPass
+    {
+    public:
+        DeclarationPass(GlobalSymbols &, std::vector<Diagnostic> &);
+        void Run(const std::vector<CompilationUnit *> &);
+
+    private:
+        void CollectClasses(Node *member, std::string_view ns, ClassInfo *outer);
+        void BuildScopes(const CompilationUnit *unit, const NodeList<Node> &members, const NodeList<UsingDirective> &usings,
+                         const ImportScope *parent, const Node *owner);
+        void AddNamespaceClasses(ImportScope &, std::string_view ns);
+        void ResolveBase(ClassInfo *);
+        void Layout(ClassInfo *);
+        void DeclareField(ClassInfo *, FieldDecl *);
+        void DeclareMethod(ClassInfo *, MethodDecl *);
+        void Error(const Node *, const ClassInfo *, const std::string &);
+        void Error(const Node *, const CompilationUnit *, const std::string &);
+
+        GlobalSymbols &globals_;
+        std::vector<Diagnostic> &diagnostics_;
+        ImportScope *root_ = nullptr;
+        // top-level classes by namespace ("" is the global namespace).
+        std::unordered_map<std::string, std::vector<ClassInfo *>> namespace_classes_;
+        std::unordered_map<const Node *, const ImportScope *> scopes_;
+        std::unordered_map<ClassInfo *, int> layout_state_;
+        std::uint32_t static_slots_ = 0;
+    };
+
+    // C.M(int, string), as used in diagnostics.
+    std::string MethodSignature(const MethodInfo *);
+
+    // one unit of body checking: a method body or a field initializer.
+    struct BodyTask
+    {
+        Node *member; // MethodDecl or FieldDecl
+        ClassInfo *owner;
+        std::string_view file;
+    };
+
+    // type checks a single body against the global view. reads nothing but
+    // the global symbols and writes only nodes inside the body, so bodies can
+    // be checked in parallel; diagnostics go to the caller's buffer.
+    void CheckBody(const GlobalSymbols &, const BodyTask &, std::vector<Diagnostic> &);
+
+    // two-phase semantic analysis: a serial declaration pass, then every body
+    // checked as its own task. const fields are then evaluated in one serial
+    // pass and the bodies constant folded, again one task each. per-task
+    // diagnostics are merged back in source order so output does not depend
+    // on scheduling.
+    class Sema
+    {
+    public:
+        explicit Sema(Interner &);
+        ~Sema();
+
+        // true when no errors were reported. with a pool, bodies are checked
+        // in parallel.
+        bool Analyze(const std::vector<CompilationUnit *> &, ThreadPool *pool = nullptr);
+
+        // Analyze() in stages, for a driver that schedules them itself:
+        // Declare() once, then CheckFiles() for disjoint sets of files, from
+        // several threads at once if need be, then Finish(). each is true
+        // when its own stage reported no errors; Finish() reports for all.
+        bool Declare(const std::vector<CompilationUnit *> &);
+        bool CheckFiles(const std::vector<std::string_view> &files, ThreadPool *pool = nullptr);
+        bool Finish(ThreadPool *pool = nullptr);
+
+        // a metadata module the program is checked against, for the classes
+        // it does not declare. takes effect from the next Declare(); the
+        // module must outlive this object.
+        void AddReference(const MetadataModule *module) { references_.push_back(module); }
+        // off for a driver given the whole program: a using of a System
+        // namespace then no longer lets unknown names pass as library
+        // types, so they are reported. takes effect from the next Declare().
+        void SetLibraryUsings(bool allowed) { library_usings_ = allowed; }
+
+        const std::vector<Diagnostic> &diagnostics() const { return diagnostics_; }
+        GlobalSymbols &globals() { return *globals_; }
+        TypeTable &types() { return types_; }
+        ConstantPool &constants() { return *constants_; }
+        const std::vector<BodyTask> &bodies() const { return bodies_; }
+
+    private:
+        // runs fn once per body, each with its own diagnostic buffer, and
+        // appends the buffers to diagnostics_ in body order.
+        void ForEachBody(ThreadPool *, const std::function<void(const BodyTask &, std::vector<Diagnostic> &)> &fn);
+        // checks the given bodies, each into its own buffer in checked_.
+        bool CheckBodies(const std::vector<std::size_t> &, ThreadPool *);
+
+        Interner &interner_;
+        TypeTable types_;
+        std::unique_ptr<ConstantPool> constants_;
+        std::unique_ptr<GlobalSymbols> globals_;
+        std::vector<const MetadataModule *> references_;
+        bool library_usings_ = true;
+        std::vector<BodyTask> bodies_;
+        std::vector<std::vector<Diagnostic>> checked_; // per body, until Finish()
+        std::vector<std::uint8_t> done_;               // per body; bytes, so threads set their own
+        std::vector<std::string_view> files_;          // in the order given
+        std::vector<Diagnostic> diagnostics_;
+    };
+
+}
+
+#endif // SEMA_H
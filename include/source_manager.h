@@ -0,0 +1,124 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#ifndef SOURCE_MANAGER_H
+#define SOURCE_MANAGER_H
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tinycsharp
+{
+    // a place in the source: an offset into the address space of a
+    // SourceManager, where every buffer it loaded has a range of its own.
+    // 0 is never handed out and stands for no location. a Lexer without a
+    // base gives plain offsets into its own text.
+    struct SourceLocation
+    {
+        std::uint32_t offset = 0;
+
+        bool valid() const { return offset != 0; }
+        SourceLocation operator+(long delta) const { return SourceLocation{static_cast<std::uint32_t>(offset + delta)}; }
+        bool operator==(SourceLocation o) const { return offset == o.offset; }
+        bool operator!=(SourceLocation o) const { return offset != o.offset; }
+        bool operator<(SourceLocation o) const { return offset < o.offset; }
+    };
+
+    // dense id of a loaded buffer, in load order.
+    using FileId = std::uint32_t;
+    constexpr FileId kNoFile = UINT32_MAX;
+
+    // a location decoded: the file's name, and line and column counted
+    // from 1, the column in bytes. all zero for no location.
+    struct SourcePosition
+    {
+        std::string_view file;
+        int line = 0;
+        int column = 0;
+    };
+
+    // owns every buffer a compilation loads and lays them out one after
+    // another in one 32-bit address space, so a location is a single
+    // offset whatever file it is in. each buffer takes its size plus one, the
+    // end of file having a location of its own. the line table of a
+    // buffer is built the first time one of its locations is decoded.
+    // safe to use from several threads.
+    class SourceManager
+    {
+    public:
+        SourceManager() = default;
+        SourceManager(const SourceManager &) = delete;
+        SourceManager &operator=(const SourceManager &) = delete;
+
+        // takes text over as the contents of a file called name. throws
+        // std::length_error once the address space is full.
+        FileId AddFile(std::string name, std::string text);
+        // a file known only by its size and where its lines start, such as
+        // one replayed from a token dump; its Text() is empty.
+        FileId AddFile(std::string name, std::uint32_t size, std::vector<std::uint32_t> line_starts);
+        // frees the text and line table of a file nothing refers to any
+        // more. its range stays taken, and its locations decode to line 1.
+        // what Text() and LineStarts() returned for it is invalid after.
+        void Release(FileId);
+
+        // where file begins; its text at offset i is at Begin(file) + i.
+        SourceLocation Begin(FileId) const;
+        std::uint32_t Size(FileId) const;
+        std::string_view Name(FileId) const;
+        std::string_view Text(FileId) const;
+        // offsets at which the lines of file begin, the first at 0.
+        const std::vector<std::uint32_t> &LineStarts(FileId) const;
+
+        // kNoFile for no location, or one past every file.
+        FileId FileOf(SourceLocation) const;
+        SourcePosition Decode(SourceLocation) const;
+
+        std::size_t FileCount() const;
+        // bytes of address space handed out so far.
+        std::uint64_t AddressSpaceUsed() const;
+
+    private:
+        struct File
+        {
+            std::string name;
+            std::string text;
+            std::uint32_t begin = 0;
+            std::uint32_t size = 0;
+            mutable std::once_flag lines_once;
+            mutable std::vector<std::uint32_t> line_starts;
+        };
+
+        FileId Add(std::string name, std::string text, std::uint32_t size, std::vector<std::uint32_t> line_starts);
+        const File &FileAt(FileId) const;
+        FileId FileOfLocked(SourceLocation) const;
+        static const std::vector<std::uint32_t> &LinesOf(const File &);
+
+        std::deque<File> files_;
+        std::vector<std::uint32_t> begins_; // by FileId, ascending
+        std::uint64_t next_ = 1;
+        mutable std::shared_mutex mu_;
+    };
+
+}
+
+#endif // SOURCE_MANAGER_H
@@ -0,0 +1,92 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include <cstdint>
+#include <vector>
+#include "ast.h"
+#include "interner.h"
+
+namespace tinycsharp
+{
+    enum class SymbolKind : std::uint8_t
+    {
+        kNamespace,
+        kClass,
+        kField,
+        kMethod,
+        kParam,
+        kLocal,
+    };
+
+    const char *SymbolKindToString(SymbolKind);
+
+    struct SymbolEntry
+    {
+        SymbolId name;
+        SymbolKind kind;
+        Node *decl;
+        std::uint32_t shadowed; // entry this one hides, or kNoEntry
+    };
+
+    // lexically scoped symbol table. every binding lives in one flat entries
+    // array; a scope is just the segment of that array pushed since the
+    // matching PushScope(), so popping a scope truncates the array. an open
+    // addressing table keyed by SymbolId points at the innermost visible
+    // binding of each name and each entry remembers the binding it shadowed,
+    // which keeps Lookup() a single probe no matter how deep the nesting is.
+    class ScopedSymbolTable
+    {
+    public:
+        static constexpr std::uint32_t kNoEntry = 0xffffffffu;
+
+        ScopedSymbolTable();
+        ~ScopedSymbolTable() = default;
+
+        void PushScope();
+        void PopScope();
+        std::size_t Depth() const { return scope_starts_.size(); }
+
+        // false if name is already bound in the innermost scope.
+        bool Declare(SymbolId name, SymbolKind kind, Node *decl);
+        const SymbolEntry *Lookup(SymbolId name) const;
+        const SymbolEntry *LookupInCurrentScope(SymbolId name) const;
+        // the scope depth (1 = outermost) a binding was declared in.
+        std::size_t ScopeOf(const SymbolEntry *) const;
+
+    private:
+        struct Slot
+        {
+            SymbolId name = kNoSymbol;
+            std::uint32_t entry = kNoEntry;
+        };
+
+        std::size_t FindSlot(SymbolId) const;
+        void Grow();
+
+        std::vector<Slot> slots_;
+        std::size_t used_slots_ = 0;
+        std::vector<SymbolEntry> entries_;
+        std::vector<std::uint32_t> scope_starts_;
+    };
+
+}
+
+#endif // SYMBOL_TABLE_H
@@ -0,0 +1,69 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tinycsharp
+{
+    // fixed set of worker threads pulling from one queue. compile phases use
+    // ParallelFor() to spread independent work (method bodies, functions,
+    // files) over the cores.
+    class ThreadPool
+    {
+    public:
+        // 0 threads means one per hardware thread.
+        explicit ThreadPool(unsigned threads = 0);
+        ~ThreadPool();
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        void Submit(std::function<void()>);
+        // block until every task submitted so far has finished.
+        void Wait();
+
+        // run fn(0) .. fn(n - 1) across the pool; the calling thread helps.
+        // the first exception thrown by fn is rethrown here once all indices
+        // have been handed out.
+        void ParallelFor(std::size_t n, const std::function<void(std::size_t)> &fn);
+
+        unsigned Size() const { return static_cast<unsigned>(workers_.size()); }
+
+    private:
+        void WorkerLoop();
+
+        std::vector<std::thread> workers_;
+        std::deque<std::function<void()>> queue_;
+        std::mutex mu_;
+        std::condition_variable work_cv_;
+        std::condition_variable idle_cv_;
+        std::size_t active_ = 0;
+        bool stopping_ = false;
+    };
+
+}
+
+#endif // THREAD_POOL_H
@@ -19,9 +19,11 @@
 #ifndef TOKEN_H
 #define TOKEN_H
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <ostream>
+#include "source_manager.h"
 
 namespace tinycsharp
 {
@@ -467,15 +469,14 @@ namespace tinycsharp
     {
     public:
         TokenKind kind;
+        SourceLocation loc; // of the first character
         std::string lexeme;
         std::shared_ptr<Token> next;
-        std::shared_ptr<int> int_val;
+        std::shared_ptr<std::int64_t> int_val;
         std::shared_ptr<double> float_val;
-        int line; // current line this Token is in..
-        int column;
 
         Token(TokenKind kind, const std::string &literal) : kind(kind), lexeme(literal), next(nullptr), int_val(nullptr), float_val(nullptr) {}
-        Token(TokenKind kind, const std::string &literal, int int_val) : kind(kind), lexeme(literal), next(nullptr), int_val(std::make_shared<int>(int_val)), float_val(nullptr) {}
+        Token(TokenKind kind, const std::string &literal, std::int64_t int_val) : kind(kind), lexeme(literal), next(nullptr), int_val(std::make_shared<std::int64_t>(int_val)), float_val(nullptr) {}
         Token(TokenKind kind, const std::string &literal, double float_val) : kind(kind), lexeme(literal), next(nullptr), int_val(nullptr), float_val(std::make_shared<double>(float_val)) {}
 
         Token() = default;
@@ -488,7 +489,7 @@ namespace tinycsharp
 
     inline std::ostream &operator<<(std::ostream &os, const Token &tok)
     {
-        os << "Token(kind=" << TokenKindToString(tok.kind) << ", lexeme=\"" << tok.lexeme << "\"" << ", line=" << tok.line << ", column=" << tok.column;
+        os << "Token(kind=" << TokenKindToString(tok.kind) << ", lexeme=\"" << tok.lexeme << "\"" << ", loc=" << tok.loc.offset;
 
         if (tok.int_val)
         {
@@ -0,0 +1,114 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#ifndef TYPES_H
+#define TYPES_H
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace tinycsharp
+{
+    struct ClassInfo;
+
+    enum class TypeKind : std::uint8_t
+    {
+        kError, // result of an ill-typed expression; converts to anything
+        kVoid,
+        kBool,
+        kChar,
+        kInt,
+        kLong,
+        kFloat,
+        kDouble,
+        kString,
+        kObject,
+        kNull,
+        kClass,
+        kArray,
+        kTask,     // Task or Task<T>; element is the result type (void for Task)
+        kExternal, // a library type the program cannot see into; unchecked
+    };
+
+    struct Type
+    {
+        TypeKind kind;
+        ClassInfo *cls = nullptr;       // kClass
+        const Type *element = nullptr;  // kArray, kTask
+        std::string_view name;          // kExternal
+
+        bool IsNumeric() const { return kind >= TypeKind::kChar && kind <= TypeKind::kDouble; }
+        bool IsIntegral() const { return kind >= TypeKind::kChar && kind <= TypeKind::kLong; }
+        bool IsReference() const
+        {
+            return kind == TypeKind::kString || kind == TypeKind::kObject || kind == TypeKind::kNull ||
+                   kind == TypeKind::kClass || kind == TypeKind::kArray || kind == TypeKind::kTask ||
+                   kind == TypeKind::kExternal;
+        }
+    };
+
+    std::string TypeToString(const Type *);
+
+    // owns every Type. built-in types are singletons, and class, array, task
+    // and external types are created once per distinct shape, so types can be
+    // compared by pointer. safe to use from several threads.
+    class TypeTable
+    {
+    public:
+        TypeTable();
+        TypeTable(const TypeTable &) = delete;
+        TypeTable &operator=(const TypeTable &) = delete;
+
+        const Type *Error() const { return &builtins_[0]; }
+        const Type *Void() const { return &builtins_[1]; }
+        const Type *Bool() const { return &builtins_[2]; }
+        const Type *Char() const { return &builtins_[3]; }
+        const Type *Int() const { return &builtins_[4]; }
+        const Type *Long() const { return &builtins_[5]; }
+        const Type *Float() const { return &builtins_[6]; }
+        const Type *Double() const { return &builtins_[7]; }
+        const Type *String() const { return &builtins_[8]; }
+        const Type *Object() const { return &builtins_[9]; }
+        const Type *Null() const { return &builtins_[10]; }
+
+        // built-in type for a keyword spelling (int, string, ...) or null.
+        const Type *Builtin(std::string_view) const;
+        const Type *ClassType(ClassInfo *);
+        const Type *ArrayOf(const Type *);
+        const Type *TaskOf(const Type *result);
+        const Type *External(std::string_view name);
+
+    private:
+        Type builtins_[11];
+        std::map<const void *, const Type *> classes_;
+        std::map<const Type *, const Type *> arrays_;
+        std::map<const Type *, const Type *> tasks_;
+        std::map<std::string, const Type *, std::less<>> externals_;
+        std::deque<Type> storage_;
+        std::deque<std::string> names_;
+        std::mutex mu_;
+    };
+
+}
+
+#endif // TYPES_H
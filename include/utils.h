@@ -23,6 +23,7 @@
 #include <cctype>
 #include <algorithm>
 #include <string_view>
+#include <array>
 
 namespace util
 {
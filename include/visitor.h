@@ -0,0 +1,212 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#ifndef VISITOR_H
+#define VISITOR_H
+
+#include "ast.h"
+
+namespace tinycsharp
+{
+    // statically dispatched visitor. Derived overrides VisitFoo(Foo *) for the
+    // node types it cares about; Visit() switches on the node kind and calls
+    // straight into Derived, so there is no virtual call per node and the
+    // compiler is free to inline the handlers. kinds Derived does not handle
+    // fall back to VisitNode(), which returns R().
+    //
+    //     struct CallCounter : AstVisitor<CallCounter>
+    //     {
+    //         int calls = 0;
+    //         void VisitCallExpr(CallExpr *) { calls++; }
+    //     };
+    //     CallCounter counter;
+    //     counter.VisitAllOfKind<CallExpr>(ctx); // no tree walk
+    template <typename Derived, typename R = void>
+    class AstVisitor
+    {
+    public:
+        R Visit(Node *node)
+        {
+            switch (node->kind)
+            {
+#define TINYCSHARP_VISIT_CASE(Name) \
+    case NodeKind::k##Name:         \
+        return Self().Visit##Name(static_cast<Name *>(node));
+                TINYCSHARP_AST_NODES(TINYCSHARP_VISIT_CASE)
+#undef TINYCSHARP_VISIT_CASE
+            }
+            return Self().VisitNode(node);
+        }
+
+        // calls the handler for T directly, skipping the kind switch.
+#define TINYCSHARP_VISIT_TYPED(Name) \
+    R VisitTyped(Name *node) { return Self().Visit##Name(node); }
+        TINYCSHARP_AST_NODES(TINYCSHARP_VISIT_TYPED)
+#undef TINYCSHARP_VISIT_TYPED
+
+        // visit every T in ctx through the per-kind index, in creation order.
+        template <typename T>
+        void VisitAllOfKind(const AstContext &ctx)
+        {
+            for (Node *node : ctx.NodesOfKind(T::kKind))
+            {
+                VisitTyped(static_cast<T *>(node));
+            }
+        }
+
+#define TINYCSHARP_VISIT_DEFAULT(Name) \
+    R Visit##Name(Name *node) { return Self().VisitNode(node); }
+        TINYCSHARP_AST_NODES(TINYCSHARP_VISIT_DEFAULT)
+#undef TINYCSHARP_VISIT_DEFAULT
+
+        R VisitNode(Node *) { return R(); }
+
+    protected:
+        Derived &Self() { return *static_cast<Derived *>(this); }
+    };
+
+    // AstVisitor whose default handlers descend into the children of every
+    // node. an override that still wants the subtree calls WalkFoo(node).
+    template <typename Derived>
+    class RecursiveAstVisitor : public AstVisitor<Derived, void>
+    {
+    public:
+#define TINYCSHARP_VISIT_WALK(Name) \
+    void Visit##Name(Name *node) { Walk##Name(node); }
+        TINYCSHARP_AST_NODES(TINYCSHARP_VISIT_WALK)
+#undef TINYCSHARP_VISIT_WALK
+
+        void VisitChild(Node *node)
+        {
+            if (node)
+            {
+                this->Visit(node);
+            }
+        }
+        template <typename T>
+        void VisitChildren(const NodeList<T> &list)
+        {
+            for (T *node : list)
+            {
+                VisitChild(node);
+            }
+        }
+
+        void WalkCompilationUnit(CompilationUnit *n)
+        {
+            VisitChildren(n->usings);
+            VisitChildren(n->members);
+        }
+        void WalkUsingDirective(UsingDirective *) {}
+        void WalkNamespaceDecl(NamespaceDecl *n)
+        {
+            VisitChildren(n->usings);
+            VisitChildren(n->members);
+        }
+        void WalkClassDecl(ClassDecl *n)
+        {
+            VisitChildren(n->bases);
+            VisitChildren(n->members);
+        }
+        void WalkFieldDecl(FieldDecl *n)
+        {
+            VisitChild(n->type);
+            VisitChild(n->init);
+        }
+        void WalkMethodDecl(MethodDecl *n)
+        {
+            VisitChild(n->return_type);
+            VisitChildren(n->params);
+            VisitChild(n->body);
+        }
+        void WalkParamDecl(ParamDecl *n) { VisitChild(n->type); }
+        void WalkTypeRef(TypeRef *n) { VisitChildren(n->args); }
+        void WalkBlockStmt(BlockStmt *n) { VisitChildren(n->stmts); }
+        void WalkLocalVarStmt(LocalVarStmt *n)
+        {
+            VisitChild(n->type);
+            VisitChild(n->init);
+        }
+        void WalkExprStmt(ExprStmt *n) { VisitChild(n->expr); }
+        void WalkIfStmt(IfStmt *n)
+        {
+            VisitChild(n->cond);
+            VisitChild(n->then_stmt);
+            VisitChild(n->else_stmt);
+        }
+        void WalkWhileStmt(WhileStmt *n)
+        {
+            VisitChild(n->cond);
+            VisitChild(n->body);
+        }
+        void WalkDoWhileStmt(DoWhileStmt *n)
+        {
+            VisitChild(n->body);
+            VisitChild(n->cond);
+        }
+        void WalkReturnStmt(ReturnStmt *n) { VisitChild(n->value); }
+        void WalkBreakStmt(BreakStmt *) {}
+        void WalkContinueStmt(ContinueStmt *) {}
+        void WalkThrowStmt(ThrowStmt *n) { VisitChild(n->value); }
+        void WalkLiteralExpr(LiteralExpr *) {}
+        void WalkNameExpr(NameExpr *) {}
+        void WalkMemberExpr(MemberExpr *n) { VisitChild(n->object); }
+        void WalkCallExpr(CallExpr *n)
+        {
+            VisitChild(n->callee);
+            VisitChildren(n->args);
+        }
+        void WalkIndexExpr(IndexExpr *n)
+        {
+            VisitChild(n->object);
+            VisitChild(n->index);
+        }
+        void WalkUnaryExpr(UnaryExpr *n) { VisitChild(n->operand); }
+        void WalkBinaryExpr(BinaryExpr *n)
+        {
+            VisitChild(n->lhs);
+            VisitChild(n->rhs);
+        }
+        void WalkAssignExpr(AssignExpr *n)
+        {
+            VisitChild(n->target);
+            VisitChild(n->value);
+        }
+        void WalkConditionalExpr(ConditionalExpr *n)
+        {
+            VisitChild(n->cond);
+            VisitChild(n->then_expr);
+            VisitChild(n->else_expr);
+        }
+        void WalkCastExpr(CastExpr *n)
+        {
+            VisitChild(n->type);
+            VisitChild(n->operand);
+        }
+        void WalkNewExpr(NewExpr *n)
+        {
+            VisitChild(n->type);
+            VisitChildren(n->args);
+        }
+        void WalkThisExpr(ThisExpr *) {}
+        void WalkAwaitExpr(AwaitExpr *n) { VisitChild(n->operand); }
+    };
+
+}
+
+#endif // VISITOR_H
@@ -0,0 +1,254 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#ifndef VM_H
+#define VM_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "bytecode.h"
+#include "jit.h"
+#include "profiler.h"
+#include "runtime.h"
+#include "scheduler.h"
+
+namespace tinycsharp
+{
+    // a C# exception that reached the top of the program, e.g.
+    // System.NullReferenceException. what() is the text dotnet prints for an
+    // unhandled exception, stack trace included.
+    class VmError : public std::runtime_error
+    {
+    public:
+        VmError(std::string type, std::string message, std::string trace);
+
+        const std::string &type() const { return type_; }
+        const std::string &message() const { return message_; }
+
+    private:
+        std::string type_;
+        std::string message_;
+    };
+
+    struct VmStats
+    {
+        std::uint64_t instructions = 0; // dispatches
+        std::uint64_t calls = 0;
+        std::uint64_t quickened = 0; // instructions rewritten to a typed op
+        // virtual calls by how their call site's inline cache resolved them:
+        // the site's single class, one of a few, a miss that filled the
+        // cache, or a vtable lookup at a site that saw too many classes.
+        std::uint64_t monomorphic_hits = 0;
+        std::uint64_t polymorphic_hits = 0;
+        std::uint64_t inline_cache_misses = 0;
+        std::uint64_t megamorphic_calls = 0;
+        // awaits that found their task still running and suspended the
+        // call, and suspended calls run again once it completed.
+        std::uint64_t suspensions = 0;
+        std::uint64_t resumptions = 0;
+        // functions compiled to native code, and times the interpreter
+        // handed a frame over to it.
+        std::uint64_t jit_functions = 0;
+        std::uint64_t native_entries = 0;
+
+        std::uint64_t VirtualCalls() const { return monomorphic_hits + polymorphic_hits + inline_cache_misses + megamorphic_calls; }
+        // share of virtual calls resolved without a vtable lookup.
+        double InlineCacheHitRate() const
+        {
+            std::uint64_t total = VirtualCalls();
+            return total ? static_cast<double>(monomorphic_hits + polymorphic_hits) / static_cast<double>(total) : 0.0;
+        }
+    };
+
+    // receiver classes a virtual call site has dispatched on, with their
+    // targets. one class makes the site monomorphic, up to kEntries
+    // polymorphic; beyond that it is megamorphic and uses the vtable.
+    struct InlineCache
+    {
+        static constexpr std::uint32_t kEntries = 4;
+        std::uint32_t classes[kEntries] = {};
+        std::uint32_t targets[kEntries] = {};
+        std::uint32_t size = 0;
+        bool megamorphic = false;
+    };
+
+    // bytecode interpreter. registers of all active calls live in one
+    // value stack; each call's frame starts where its caller's ends. the
+    // dispatch loop is threaded through a table of label addresses where the
+    // compiler supports computed goto (GCC, Clang) and falls back to a
+    // switch elsewhere, or when built with TINYCSHARP_VM_SWITCH_DISPATCH.
+    // the Vm runs its own copy of the program so it can quicken the code in
+    // place. functions that run often, counting calls and loop back
+    // edges, are compiled by the baseline Jit; the interpreter then enters
+    // their native code wherever it has some and takes over again wherever
+    // native code leaves.
+    //
+    // async calls are stackless state machines. an await whose task has
+    // completed takes its result and goes on, allocating nothing. otherwise
+    // the call suspends: the registers live across the await move to a
+    // heap state machine, the machine waits on the task, and the frame
+    // returns the call's own Task to its caller. a task that completes
+    // hands the machines waiting on it to a work-stealing TaskScheduler,
+    // whose workers resume them; Task.Delay and Task.Yield complete their
+    // tasks from it too. the interpreter and heap have one mutator, so
+    // continuations run one at a time under the Vm's lock, on whichever
+    // worker picked them up.
+    class Vm
+    {
+    public:
+        struct Options
+        {
+            std::size_t stack_values = 1u << 20;
+            std::size_t max_depth = 100000;
+            // size of the heap's nursery; a minor collection runs each time
+            // it fills.
+            std::size_t gc_threshold = 8u << 20;
+            bool quicken = true;
+            // scheduler threads running continuations; 0 means one per
+            // hardware thread. started when a call first suspends.
+            unsigned async_workers = 0;
+            // compile a function to native code once its calls and back
+            // edges reach jit_threshold; ignored where Jit::Supported() is
+            // false.
+            bool jit = true;
+            std::uint32_t jit_threshold = 1000;
+            // counts or samples the run into this profiler, which refers
+            // to the Vm's code and is read while the Vm lives. the JIT is
+            // off while profiling, so every instruction runs where the
+            // profiler sees it.
+            Profiler *profiler = nullptr;
+        };
+
+        Vm(const BcProgram &, std::ostream &out);
+        Vm(const BcProgram &, std::ostream &out, Options);
+        ~Vm();
+        Vm(const Vm &) = delete;
+        Vm &operator=(const Vm &) = delete;
+
+        // runs the static initializers, then Main. returns Main's int result
+        // (or a Task<int>'s) as the exit code, 0 otherwise. unhandled
+        // exceptions are thrown as VmError.
+        int Run();
+        // calls one function directly; static initializers have to be run
+        // first by the caller if the function depends on them.
+        Value Invoke(std::uint32_t function, const std::vector<Value> &args);
+        void RunStaticInitializers();
+
+        Heap &heap() { return *heap_; }
+        // the code as run so far, quickened instructions included.
+        const BcProgram &program() const { return program_; }
+        // per virtual call site, numbered as in the program.
+        const std::vector<InlineCache> &inline_caches() const { return inline_caches_; }
+        const VmStats &stats() const { return stats_; }
+        // the TINYCSHARP_VM_SWITCH_DISPATCH build reports false.
+        static bool ThreadedDispatch();
+
+    private:
+        struct Frame
+        {
+            const BcFunction *fn;
+            Value *regs;
+            const BcInst *return_pc; // in the caller; null for the entry frame
+            std::uint16_t result;    // caller register taking the result
+            // the safepoint the frame last reached, whose stack map tells
+            // the collector which registers hold references.
+            const BcInst *pc = nullptr;
+            // the state machine of the suspended call the frame resumed.
+            Object *machine = nullptr;
+        };
+
+        // how hot a function has run, and its native code once compiled.
+        struct JitState
+        {
+            std::uint32_t hotness = 0;
+            std::unique_ptr<JitFunction> code;
+        };
+
+        Value Call(std::uint32_t function, const std::vector<Value> &args);
+        // counts one call or back edge of fn; its native code, compiled
+        // when this reaches the threshold, or null.
+        const JitFunction *HotNative(const BcFunction *fn);
+        // starts at start with machine's call resumed there when given.
+        Value Execute(const BcFunction *, Value *regs, const BcInst *start = nullptr, Object *machine = nullptr);
+        Value CallBuiltin(const BcFunction *, const BcInst *, Value *regs);
+        std::uint32_t ResolveVirtual(InlineCache &, std::uint32_t cls, std::uint32_t slot);
+        Value Box(IrType, Value);
+        Value Convert(const BcFunction *, const BcInst *, Value);
+        Object *Concat(Object *, Object *);
+        Object *Flatten(Object *);
+        Object *ToString(Value, IrType);
+        Object *CompletedTask();
+        // a task the scheduler completes after delay.
+        Object *PendingTask(std::chrono::milliseconds delay);
+        Object *Suspend(const BcFunction *, const BcInst *, Value *regs);
+        void Resume(Object *machine);
+        void CompleteTask(Object *task, Object *result);
+        TaskScheduler &Scheduler();
+        // runs job for the scheduler under the Vm's lock, unless the
+        // scheduler it was submitted to has been retired since.
+        void RunJob(std::uint64_t epoch, const std::function<void()> &job);
+        void RetireScheduler();
+        // roots for objects a scheduled job refers to.
+        std::uint32_t Pin(Object *);
+        Object *Unpin(std::uint32_t);
+        [[noreturn]] void Throw(const BcFunction *, const BcInst *, Object *exception);
+        [[noreturn]] void Fault(const BcFunction *, const BcInst *, const char *type, const std::string &message);
+        std::string StackTrace(const BcFunction *, const BcInst *) const;
+        // hands the profiler the event at ip of fn, the top frame.
+        void Profile(const BcFunction *fn, const BcInst *ip, bool exact);
+        void VisitRoots(const Heap::RootVisitor &);
+
+        BcProgram program_;
+        std::ostream &out_;
+        Options options_;
+        std::unique_ptr<Heap> heap_;
+        std::unique_ptr<Value[]> stack_;
+        std::vector<Frame> frames_;
+        std::vector<Value> statics_;
+        StringImage strings_;
+        std::vector<InlineCache> inline_caches_;
+        std::unique_ptr<Jit> jit_; // null when not compiling
+        std::vector<JitState> jit_state_; // per function
+        // objects a builtin holds across an allocation.
+        std::vector<Object *> temp_roots_;
+        Object *completed_task_ = nullptr;
+        VmStats stats_;
+        // set when Execute returned because its entry frame suspended.
+        bool suspended_ = false;
+        // guards everything above once a scheduler runs.
+        std::mutex mutex_;
+        std::condition_variable progress_;
+        std::exception_ptr failure_;
+        std::vector<Object *> pinned_;
+        std::vector<std::uint32_t> free_pins_;
+        std::uint64_t async_epoch_ = 0;
+        std::unique_ptr<TaskScheduler> scheduler_;
+    };
+
+}
+
+#endif // VM_H
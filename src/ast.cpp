@@ -0,0 +1,64 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+
+#include "ast.h"
+
+namespace tinycsharp
+{
+
+    const char *NodeKindToString(NodeKind kind)
+    {
+        switch (kind)
+        {
+#define TINYCSHARP_NODE_NAME(Name) \
+    case NodeKind::k##Name:        \
+        return #Name;
+            TINYCSHARP_AST_NODES(TINYCSHARP_NODE_NAME)
+#undef TINYCSHARP_NODE_NAME
+        default:
+            return "UNKNOWN";
+        }
+    }
+
+    AstContext::AstContext()
+        : owned_interner_(std::make_unique<Interner>()), interner_(owned_interner_.get()),
+          owned_sources_(std::make_unique<SourceManager>()), sources_(owned_sources_.get())
+    {
+    }
+
+    AstContext::AstContext(Interner &interner)
+        : interner_(&interner), owned_sources_(std::make_unique<SourceManager>()), sources_(owned_sources_.get())
+    {
+    }
+
+    AstContext::AstContext(Interner &interner, SourceManager &sources) : interner_(&interner), sources_(&sources)
+    {
+    }
+
+    std::size_t AstContext::NodeCount() const
+    {
+        std::size_t n = 0;
+        for (const auto &nodes : by_kind_)
+        {
+            n += nodes.size();
+        }
+        return n;
+    }
+
+}
@@ -0,0 +1,287 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+
+#include "binder.h"
+
+namespace tinycsharp
+{
+
+    Binder::Binder(Interner &interner, std::vector<Diagnostic> &diagnostics)
+        : interner_(interner), diagnostics_(diagnostics)
+    {
+        for (const char *name : {"Console", "Math", "String", "Task", "System", "null",
+                                 "int", "long", "float", "double", "bool", "string", "char", "object", "byte", "short"})
+        {
+            AddExternalName(name);
+        }
+    }
+
+    void Binder::AddExternalName(std::string_view name)
+    {
+        external_names_.insert(interner_.Intern(name));
+    }
+
+    void Binder::Bind(const std::vector<CompilationUnit *> &units)
+    {
+        classes_by_namespace_.clear();
+        for (CompilationUnit *unit : units)
+        {
+            for (Node *member : unit->members)
+            {
+                IndexClasses(member, kNoSymbol);
+            }
+        }
+        for (CompilationUnit *unit : units)
+        {
+            Visit(unit);
+        }
+    }
+
+    void Binder::IndexClasses(Node *member, SymbolId ns)
+    {
+        if (auto *cls = NodeCast<ClassDecl>(member))
+        {
+            classes_by_namespace_[ns].push_back(cls);
+        }
+        else if (auto *inner = NodeCast<NamespaceDecl>(member))
+        {
+            for (Node *m : inner->members)
+            {
+                IndexClasses(m, inner->name_id);
+            }
+        }
+    }
+
+    void Binder::DeclareNamespaceClasses(SymbolId ns)
+    {
+        auto it = classes_by_namespace_.find(ns);
+        if (it == classes_by_namespace_.end())
+        {
+            return;
+        }
+        for (ClassDecl *cls : it->second)
+        {
+            // the same class may be reachable through more than one using;
+            // partial duplicates across files are reported by the declaration pass.
+            table_.Declare(cls->name_id, SymbolKind::kClass, cls);
+        }
+    }
+
+    void Binder::DeclareUsings(const NodeList<UsingDirective> &usings)
+    {
+        for (UsingDirective *u : usings)
+        {
+            DeclareNamespaceClasses(u->name_id);
+        }
+    }
+
+    void Binder::VisitCompilationUnit(CompilationUnit *unit)
+    {
+        unit_ = unit;
+        table_.PushScope();
+        DeclareNamespaceClasses(kNoSymbol);
+        table_.PushScope();
+        DeclareUsings(unit->usings);
+        VisitChildren(unit->members);
+        table_.PopScope();
+        table_.PopScope();
+    }
+
+    void Binder::VisitNamespaceDecl(NamespaceDecl *ns)
+    {
+        table_.PushScope();
+        // namespace A.B sees the classes of A as well as those of A.B.
+        std::string_view name = ns->name;
+        std::size_t skip = ns->outer ? ns->outer->name.size() + 1 : 0;
+        for (std::size_t dot = name.find('.', skip); dot != std::string_view::npos; dot = name.find('.', dot + 1))
+        {
+            SymbolId prefix = interner_.Find(name.substr(0, dot));
+            if (prefix != kNoSymbol)
+            {
+                DeclareNamespaceClasses(prefix);
+            }
+        }
+        table_.PushScope();
+        DeclareNamespaceClasses(ns->name_id);
+        DeclareUsings(ns->usings);
+        VisitChildren(ns->members);
+        table_.PopScope();
+        table_.PopScope();
+    }
+
+    void Binder::DeclareMembers(ClassDecl *cls)
+    {
+        for (Node *member : cls->members)
+        {
+            if (auto *field = NodeCast<FieldDecl>(member))
+            {
+                if (!table_.Declare(field->name_id, SymbolKind::kField, field))
+                {
+                    Error(field, "The type '" + std::string(cls->name) + "' already contains a definition for '" +
+                                     std::string(field->name) + "'");
+                }
+            }
+            else if (auto *method = NodeCast<MethodDecl>(member))
+            {
+                if (method->is_ctor)
+                {
+                    continue;
+                }
+                const SymbolEntry *existing = table_.LookupInCurrentScope(method->name_id);
+                if (!existing)
+                {
+                    table_.Declare(method->name_id, SymbolKind::kMethod, method);
+                }
+                else if (existing->kind != SymbolKind::kMethod)
+                {
+                    Error(method, "The type '" + std::string(cls->name) + "' already contains a definition for '" +
+                                      std::string(method->name) + "'");
+                }
+                // further overloads share the first entry; the type checker
+                // picks among them by arity and argument types.
+            }
+            else if (auto *nested = NodeCast<ClassDecl>(member))
+            {
+                table_.Declare(nested->name_id, SymbolKind::kClass, nested);
+            }
+        }
+    }
+
+    void Binder::DeclareBaseMembers(ClassDecl *cls, std::unordered_set<ClassDecl *> &seen)
+    {
+        for (TypeRef *base : cls->bases)
+        {
+            const SymbolEntry *e = table_.Lookup(base->name_id);
+            if (!e || e->kind != SymbolKind::kClass)
+            {
+                continue;
+            }
+            auto *base_cls = static_cast<ClassDecl *>(e->decl);
+            if (!seen.insert(base_cls).second)
+            {
+                continue;
+            }
+            // nearest base first, so its members hide those further up.
+            for (Node *member : base_cls->members)
+            {
+                if (auto *field = NodeCast<FieldDecl>(member))
+                {
+                    if (!(field->modifiers & kModPrivate))
+                        table_.Declare(field->name_id, SymbolKind::kField, field);
+                }
+                else if (auto *method = NodeCast<MethodDecl>(member))
+                {
+                    if (!method->is_ctor && !(method->modifiers & kModPrivate))
+                        table_.Declare(method->name_id, SymbolKind::kMethod, method);
+                }
+            }
+            DeclareBaseMembers(base_cls, seen);
+        }
+    }
+
+    void Binder::VisitClassDecl(ClassDecl *cls)
+    {
+        std::unordered_set<ClassDecl *> seen{cls};
+        table_.PushScope();
+        DeclareBaseMembers(cls, seen);
+        table_.PushScope();
+        DeclareMembers(cls);
+        std::size_t saved_method_scope = method_scope_;
+        method_scope_ = 0;
+        VisitChildren(cls->members);
+        method_scope_ = saved_method_scope;
+        table_.PopScope();
+        table_.PopScope();
+    }
+
+    void Binder::VisitFieldDecl(FieldDecl *field)
+    {
+        VisitChild(field->init);
+    }
+
+    void Binder::VisitMethodDecl(MethodDecl *method)
+    {
+        table_.PushScope();
+        std::size_t saved = method_scope_;
+        method_scope_ = table_.Depth();
+        for (ParamDecl *param : method->params)
+        {
+            DeclareLocal(param->name_id, SymbolKind::kParam, param);
+        }
+        VisitChild(method->body);
+        method_scope_ = saved;
+        table_.PopScope();
+    }
+
+    void Binder::VisitBlockStmt(BlockStmt *block)
+    {
+        table_.PushScope();
+        WalkBlockStmt(block);
+        table_.PopScope();
+    }
+
+    void Binder::VisitLocalVarStmt(LocalVarStmt *local)
+    {
+        VisitChild(local->init);
+        DeclareLocal(local->name_id, SymbolKind::kLocal, local);
+    }
+
+    void Binder::DeclareLocal(SymbolId name, SymbolKind kind, Node *decl)
+    {
+        std::string spelling(interner_.Spelling(name));
+        const SymbolEntry *existing = table_.Lookup(name);
+        if (existing && (existing->kind == SymbolKind::kLocal || existing->kind == SymbolKind::kParam) &&
+            method_scope_ != 0 && table_.ScopeOf(existing) >= method_scope_)
+        {
+            if (table_.ScopeOf(existing) == table_.Depth())
+            {
+                Error(decl, "A local variable or parameter named '" + spelling + "' is already defined in this scope");
+            }
+            else
+            {
+                Error(decl, "A local or parameter named '" + spelling +
+                                "' cannot be declared in this scope because that name is used in an enclosing local scope");
+            }
+            return;
+        }
+        table_.Declare(name, kind, decl);
+    }
+
+    void Binder::VisitNameExpr(NameExpr *name)
+    {
+        name->decl = nullptr;
+        if (const SymbolEntry *e = table_.Lookup(name->name_id))
+        {
+            name->decl = e->decl;
+            return;
+        }
+        if (external_names_.count(name->name_id))
+        {
+            return;
+        }
+        Error(name, "The name '" + std::string(name->name) + "' does not exist in the current context");
+    }
+
+    void Binder::Error(const Node *node, const std::string &message)
+    {
+        SourcePosition at = unit_ ? unit_->Locate(node) : SourcePosition{};
+        diagnostics_.push_back(Diagnostic{Severity::kError, std::string(unit_ ? unit_->file : ""), at.line, at.column, message});
+    }
+
+}
@@ -0,0 +1,514 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include "build.h"
+#include "parser.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace tinycsharp
+{
+    namespace
+    {
+        std::string Trim(std::string_view s)
+        {
+            std::size_t begin = s.find_first_not_of(" \t\r");
+            if (begin == std::string_view::npos)
+                return "";
+            std::size_t end = s.find_last_not_of(" \t\r");
+            return std::string(s.substr(begin, end - begin + 1));
+        }
+
+        std::string FullName(const NamespaceDecl *ns)
+        {
+            return ns->outer ? FullName(ns->outer) + "." + std::string(ns->name) : std::string(ns->name);
+        }
+
+        // the namespaces a unit declares and the ones its using directives
+        // name, at any depth.
+        void CollectNamespaces(const NodeList<Node> &members, std::vector<std::string> &declared, std::vector<std::string> &used)
+        {
+            for (Node *member : members)
+            {
+                if (auto *ns = NodeCast<NamespaceDecl>(member))
+                {
+                    declared.push_back(FullName(ns));
+                    for (UsingDirective *u : ns->usings)
+                        used.emplace_back(u->name);
+                    CollectNamespaces(ns->members, declared, used);
+                }
+            }
+        }
+
+        std::string Milliseconds(double ms)
+        {
+            char buf[32];
+            std::snprintf(buf, sizeof buf, "%.1f", ms);
+            return buf;
+        }
+    }
+
+    BuildManifest BuildManifest::Parse(std::string_view text, const std::string &dir, const std::string &name)
+    {
+        BuildManifest manifest;
+        int number = 0;
+        auto fail = [&](const std::string &message)
+        {
+            throw std::runtime_error(name + ":" + std::to_string(number) + ": " + message);
+        };
+        std::istringstream in{std::string(text)};
+        std::string line;
+        while (std::getline(in, line))
+        {
+            number++;
+            std::string content = Trim(line.substr(0, line.find('#')));
+            if (content.empty())
+                continue;
+            if (content.compare(0, 9, "assembly ") == 0 || content == "assembly")
+            {
+                std::string assembly = Trim(std::string_view(content).substr(8));
+                if (assembly.empty() || assembly.find_first_of(" \t") != std::string::npos)
+                    fail("expected 'assembly NAME'");
+                for (const auto &a : manifest.assemblies)
+                {
+                    if (a.name == assembly)
+                        fail("assembly '" + assembly + "' is declared twice");
+                }
+                manifest.assemblies.push_back(Assembly{assembly, {}});
+                continue;
+            }
+            if (manifest.assemblies.empty())
+                fail("'" + content + "' is not in an assembly");
+            std::filesystem::path path{content};
+            if (!dir.empty() && path.is_relative())
+                path = std::filesystem::path(dir) / path;
+            manifest.assemblies.back().files.push_back(path.lexically_normal().string());
+        }
+        if (manifest.assemblies.empty())
+            throw std::runtime_error(name + ": no assemblies");
+        for (const auto &a : manifest.assemblies)
+        {
+            if (a.files.empty())
+                throw std::runtime_error(name + ": assembly '" + a.name + "' lists no files");
+        }
+        return manifest;
+    }
+
+    BuildManifest BuildManifest::Load(const std::string &path)
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+            throw std::runtime_error("cannot read " + path);
+        std::ostringstream ss;
+        ss << in.rdbuf();
+        return Parse(ss.str(), std::filesystem::path(path).parent_path().string(), path);
+    }
+
+    TaskGraph::TaskGraph() : epoch_(std::chrono::steady_clock::now())
+    {
+    }
+
+    TaskGraph::Step TaskGraph::Add(std::string name, std::function<bool()> work, std::vector<Step> deps)
+    {
+        for (Step d : deps)
+        {
+            if (d >= nodes_.size())
+                throw std::invalid_argument("TaskGraph: '" + name + "' depends on a step that does not exist");
+        }
+        Node node;
+        node.name = std::move(name);
+        node.work = std::move(work);
+        node.deps = std::move(deps);
+        nodes_.push_back(std::move(node));
+        return nodes_.size() - 1;
+    }
+
+    bool TaskGraph::Run(ThreadPool &pool)
+    {
+        // a step only depends on earlier ones, so index order is a
+        // topological order.
+        std::mutex mu;
+        std::condition_variable cv;
+        std::size_t outstanding = 0;
+        bool ok = true;
+        std::vector<std::size_t> waiting(nodes_.size(), 0);
+        std::vector<std::uint8_t> doomed(nodes_.size(), 0);
+        std::vector<std::vector<Step>> dependents(nodes_.size());
+        for (Step i = 0; i < nodes_.size(); i++)
+        {
+            if (nodes_[i].status != Status::kPending)
+                continue;
+            outstanding++;
+            for (Step d : nodes_[i].deps)
+            {
+                if (nodes_[d].status == Status::kPending)
+                {
+                    waiting[i]++;
+                    dependents[d].push_back(i);
+                }
+                else if (nodes_[d].status != Status::kSucceeded)
+                {
+                    doomed[i] = 1;
+                }
+            }
+        }
+        if (outstanding == 0)
+            return true;
+
+        std::function<void(Step)> start;
+        // called with mu held.
+        std::function<void(Step, Status)> finish = [&](Step i, Status status)
+        {
+            nodes_[i].status = status;
+            if (status != Status::kSucceeded)
+                ok = false;
+            outstanding--;
+            for (Step j : dependents[i])
+            {
+                if (status != Status::kSucceeded)
+                    doomed[j] = 1;
+                if (--waiting[j] == 0)
+                {
+                    if (doomed[j])
+                        finish(j, Status::kSkipped);
+                    else
+                        start(j);
+                }
+            }
+        };
+        start = [&](Step i)
+        {
+            pool.Submit([&, i]
+                        {
+                Node &node = nodes_[i];
+                node.start_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - epoch_).count();
+                bool succeeded = false;
+                try
+                {
+                    succeeded = node.work();
+                }
+                catch (const std::exception &e)
+                {
+                    node.error = e.what();
+                }
+                node.end_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - epoch_).count();
+                std::lock_guard<std::mutex> lock(mu);
+                finish(i, succeeded ? Status::kSucceeded : Status::kFailed);
+                if (outstanding == 0)
+                    cv.notify_all(); });
+        };
+
+        std::unique_lock<std::mutex> lock(mu);
+        for (Step i = 0; i < nodes_.size(); i++)
+        {
+            if (nodes_[i].status == Status::kPending && waiting[i] == 0 && !doomed[i])
+            {
+                start(i);
+            }
+            else if (nodes_[i].status == Status::kPending && waiting[i] == 0)
+            {
+                finish(i, Status::kSkipped);
+            }
+        }
+        cv.wait(lock, [&]
+                { return outstanding == 0; });
+        return ok;
+    }
+
+    std::vector<TaskGraph::Step> TaskGraph::CriticalPath() const
+    {
+        std::vector<double> longest(nodes_.size(), 0);
+        std::vector<Step> previous(nodes_.size(), nodes_.size());
+        Step last = nodes_.size();
+        for (Step i = 0; i < nodes_.size(); i++)
+        {
+            const Node &node = nodes_[i];
+            if (node.status != Status::kSucceeded && node.status != Status::kFailed)
+                continue;
+            for (Step d : node.deps)
+            {
+                if (longest[d] > longest[i])
+                {
+                    longest[i] = longest[d];
+                    previous[i] = d;
+                }
+            }
+            longest[i] += node.Duration();
+            if (last == nodes_.size() || longest[i] > longest[last])
+                last = i;
+        }
+        std::vector<Step> path;
+        for (Step i = last; i < nodes_.size(); i = previous[i])
+            path.push_back(i);
+        std::reverse(path.begin(), path.end());
+        return path;
+    }
+
+    void TaskGraph::PrintTimings(std::ostream &os) const
+    {
+        std::vector<Step> order;
+        double begin = 0, end = 0, work = 0;
+        bool any = false;
+        for (Step i = 0; i < nodes_.size(); i++)
+        {
+            const Node &node = nodes_[i];
+            if (node.status == Status::kPending)
+                continue;
+            order.push_back(i);
+            if (node.status == Status::kSkipped)
+                continue;
+            begin = any ? std::min(begin, node.start_ms) : node.start_ms;
+            any = true;
+            end = std::max(end, node.end_ms);
+            work += node.Duration();
+        }
+        std::stable_sort(order.begin(), order.end(), [&](Step a, Step b)
+                         {
+                             bool sa = nodes_[a].status == Status::kSkipped, sb = nodes_[b].status == Status::kSkipped;
+                             if (sa != sb)
+                                 return sb;
+                             return nodes_[a].start_ms < nodes_[b].start_ms; });
+        double wall = end - begin;
+        os << "build: " << order.size() << " steps in " << Milliseconds(wall) << " ms, " << Milliseconds(work)
+           << " ms of work (" << Milliseconds(wall > 0 ? work / wall : 1) << "x parallel)\n";
+        os << "   start     time  step\n";
+        for (Step i : order)
+        {
+            const Node &node = nodes_[i];
+            char line[64];
+            if (node.status == Status::kSkipped)
+                std::snprintf(line, sizeof line, "%8s %8s  ", "", "skipped");
+            else
+                std::snprintf(line, sizeof line, "%8.1f %8.1f  ", node.start_ms - begin, node.Duration());
+            os << line << node.name << (node.status == Status::kFailed ? " (failed)" : "") << "\n";
+        }
+        std::vector<Step> path = CriticalPath();
+        double length = 0;
+        for (Step i : path)
+            length += nodes_[i].Duration();
+        os << "critical path, " << Milliseconds(length) << " ms:";
+        for (std::size_t k = 0; k < path.size(); k++)
+            os << (k ? " -> " : " ") << nodes_[path[k]].name;
+        os << "\n";
+    }
+
+    struct ProjectBuild::File
+    {
+        std::string path;
+        std::size_t assembly;
+        std::unique_ptr<AstContext> ast;
+    };
+
+    ProjectBuild::ProjectBuild(BuildManifest manifest, ThreadPool &pool) : manifest_(std::move(manifest)), pool_(pool)
+    {
+    }
+
+    ProjectBuild::~ProjectBuild() = default;
+
+    bool ProjectBuild::Check(std::ostream &err)
+    {
+        std::vector<TaskGraph::Step> parses;
+        for (std::size_t a = 0; a < manifest_.assemblies.size(); a++)
+        {
+            for (const std::string &path : manifest_.assemblies[a].files)
+            {
+                files_.push_back(std::make_unique<File>(File{path, a, nullptr}));
+                File *file = files_.back().get();
+                parses.push_back(graph_.Add("parse " + path, [this, file]
+                                            {
+                    std::ifstream in(file->path, std::ios::binary);
+                    if (!in)
+                        throw std::runtime_error("cannot read " + file->path);
+                    std::ostringstream ss;
+                    ss << in.rdbuf();
+                    auto ast = std::make_unique<AstContext>(interner_, sources_);
+                    Parser parser{*ast, ss.str(), file->path};
+                    parser.ParseCompilationUnit();
+                    file->ast = std::move(ast);
+                    return true; }));
+            }
+        }
+        bool ok = graph_.Run(pool_);
+        for (std::size_t i = 0; i < files_.size(); i++)
+        {
+            const auto &node = graph_.nodes()[parses[i]];
+            if (node.status == TaskGraph::Status::kFailed)
+                err << files_[i]->path << ": " << node.error << "\n";
+        }
+        if (!ok)
+            return false;
+
+        FindDependencies();
+        if (FindCycle(err))
+            return false;
+
+        // the manifest lists every assembly of the program, so a name none
+        // of them declares is an error, not a library type.
+        sema_ = std::make_unique<Sema>(interner_);
+        sema_->SetLibraryUsings(false);
+        TaskGraph::Step declare = graph_.Add("declare", [this]
+                                             {
+            std::vector<CompilationUnit *> units;
+            for (const auto &file : files_)
+                units.insert(units.end(), file->ast->units.begin(), file->ast->units.end());
+            return sema_->Declare(units); }, parses);
+
+        // an assembly's step is added after those of its dependencies.
+        std::size_t count = manifest_.assemblies.size();
+        std::vector<TaskGraph::Step> checks(count, 0);
+        std::vector<std::uint8_t> added(count, 0);
+        std::function<void(std::size_t)> add = [&](std::size_t a)
+        {
+            if (added[a])
+                return;
+            added[a] = 1;
+            std::vector<TaskGraph::Step> deps{declare};
+            for (std::size_t d : deps_[a])
+            {
+                add(d);
+                deps.push_back(checks[d]);
+            }
+            checks[a] = graph_.Add("check " + manifest_.assemblies[a].name, [this, a]
+                                   {
+                std::vector<std::string_view> files;
+                for (const std::string &path : manifest_.assemblies[a].files)
+                    files.push_back(path);
+                return sema_->CheckFiles(files, &pool_); }, deps);
+        };
+        for (std::size_t a = 0; a < count; a++)
+            add(a);
+        finish_ = graph_.Add("finish", [this]
+                             { return sema_->Finish(&pool_); }, checks);
+
+        ok = graph_.Run(pool_);
+        const auto &nodes = graph_.nodes();
+        if (nodes[declare].status == TaskGraph::Status::kSucceeded && nodes[finish_].status == TaskGraph::Status::kSkipped)
+        {
+            // a check failed: report what was checked.
+            sema_->Finish(&pool_);
+        }
+        for (const auto &d : sema_->diagnostics())
+            err << d << "\n";
+        for (std::size_t a = 0; a < count; a++)
+        {
+            if (nodes[checks[a]].status == TaskGraph::Status::kSkipped && nodes[declare].status == TaskGraph::Status::kSucceeded)
+                err << "tinycsharp: " << manifest_.assemblies[a].name << " was not checked: an assembly it depends on has errors\n";
+        }
+        return ok;
+    }
+
+    void ProjectBuild::FindDependencies()
+    {
+        std::size_t count = manifest_.assemblies.size();
+        std::vector<std::vector<std::string>> declared(count), used(count);
+        for (const auto &file : files_)
+        {
+            for (CompilationUnit *unit : file->ast->units)
+            {
+                for (UsingDirective *u : unit->usings)
+                    used[file->assembly].emplace_back(u->name);
+                CollectNamespaces(unit->members, declared[file->assembly], used[file->assembly]);
+            }
+        }
+        std::unordered_map<std::string, std::vector<std::size_t>> owners;
+        for (std::size_t a = 0; a < count; a++)
+        {
+            for (const std::string &ns : declared[a])
+            {
+                auto &list = owners[ns];
+                if (std::find(list.begin(), list.end(), a) == list.end())
+                    list.push_back(a);
+            }
+        }
+        deps_.assign(count, {});
+        reasons_.assign(count, {});
+        for (std::size_t a = 0; a < count; a++)
+        {
+            for (const std::string &ns : used[a])
+            {
+                auto it = owners.find(ns);
+                if (it == owners.end())
+                    continue;
+                for (std::size_t b : it->second)
+                {
+                    if (b != a && std::find(deps_[a].begin(), deps_[a].end(), b) == deps_[a].end())
+                    {
+                        deps_[a].push_back(b);
+                        reasons_[a].push_back(ns);
+                    }
+                }
+            }
+        }
+    }
+
+    bool ProjectBuild::FindCycle(std::ostream &err) const
+    {
+        // depth-first, with the assemblies on the current path marked 1.
+        std::size_t count = deps_.size();
+        std::vector<std::uint8_t> state(count, 0);
+        std::vector<std::size_t> path;
+        std::function<bool(std::size_t)> visit = [&](std::size_t a)
+        {
+            state[a] = 1;
+            path.push_back(a);
+            for (std::size_t d : deps_[a])
+            {
+                if (state[d] == 1)
+                {
+                    err << "tinycsharp: dependency cycle:";
+                    auto from = std::find(path.begin(), path.end(), d);
+                    for (auto it = from; it != path.end(); ++it)
+                        err << " " << manifest_.assemblies[*it].name << " ->";
+                    err << " " << manifest_.assemblies[d].name << "\n";
+                    return true;
+                }
+                if (state[d] == 0 && visit(d))
+                    return true;
+            }
+            state[a] = 2;
+            path.pop_back();
+            return false;
+        };
+        for (std::size_t a = 0; a < count; a++)
+        {
+            if (state[a] == 0 && visit(a))
+                return true;
+        }
+        return false;
+    }
+
+    void ProjectBuild::PrintDependencies(std::ostream &os) const
+    {
+        for (std::size_t a = 0; a < deps_.size(); a++)
+        {
+            for (std::size_t k = 0; k < deps_[a].size(); k++)
+            {
+                os << manifest_.assemblies[a].name << " -> " << manifest_.assemblies[deps_[a][k]].name << " (using "
+                   << reasons_[a][k] << ")\n";
+            }
+        }
+    }
+
+}
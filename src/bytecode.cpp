@@ -0,0 +1,1320 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include "bytecode.h"
+#include "sema.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace tinycsharp
+{
+    const char *BcOpToString(BcOp op)
+    {
+        static const char *const kNames[] = {
+#define TINYCSHARP_BC_OP_NAME(Name) #Name,
+            TINYCSHARP_BC_OPS(TINYCSHARP_BC_OP_NAME)
+#undef TINYCSHARP_BC_OP_NAME
+        };
+        return kNames[static_cast<std::size_t>(op)];
+    }
+
+    BcOp QuickenedOp(const BcInst &inst)
+    {
+        IrType t = inst.type;
+        bool i32 = t == IrType::kI32;
+        bool i64 = t == IrType::kI64;
+        bool f64 = t == IrType::kF64;
+        bool integral = IsIntegralIrType(t);
+        switch (inst.op)
+        {
+        case BcOp::kAdd:
+            return i32 ? BcOp::kAddI32 : i64 ? BcOp::kAddI64 : f64 ? BcOp::kAddF64 : inst.op;
+        case BcOp::kSub:
+            return i32 ? BcOp::kSubI32 : i64 ? BcOp::kSubI64 : f64 ? BcOp::kSubF64 : inst.op;
+        case BcOp::kMul:
+            return i32 ? BcOp::kMulI32 : i64 ? BcOp::kMulI64 : f64 ? BcOp::kMulF64 : inst.op;
+        case BcOp::kDiv:
+            return i32 ? BcOp::kDivI32 : i64 ? BcOp::kDivI64 : f64 ? BcOp::kDivF64 : inst.op;
+        case BcOp::kRem:
+            return i32 ? BcOp::kRemI32 : i64 ? BcOp::kRemI64 : inst.op;
+        case BcOp::kShl:
+            return i32 ? BcOp::kShlI32 : i64 ? BcOp::kShlI64 : inst.op;
+        case BcOp::kShr:
+            return i32 ? BcOp::kShrI32 : i64 ? BcOp::kShrI64 : inst.op;
+        case BcOp::kNeg:
+            return i32 ? BcOp::kNegI32 : f64 ? BcOp::kNegF64 : inst.op;
+        case BcOp::kEq:
+            return integral || t == IrType::kRef ? BcOp::kEqI : f64 ? BcOp::kEqF64 : inst.op;
+        case BcOp::kNe:
+            return integral || t == IrType::kRef ? BcOp::kNeI : f64 ? BcOp::kNeF64 : inst.op;
+        case BcOp::kLt:
+            return integral ? BcOp::kLtI : f64 ? BcOp::kLtF64 : inst.op;
+        case BcOp::kLe:
+            return integral ? BcOp::kLeI : f64 ? BcOp::kLeF64 : inst.op;
+        case BcOp::kGt:
+            return integral ? BcOp::kGtI : f64 ? BcOp::kGtF64 : inst.op;
+        case BcOp::kGe:
+            return integral ? BcOp::kGeI : f64 ? BcOp::kGeF64 : inst.op;
+        case BcOp::kConvert:
+        {
+            IrType from = static_cast<IrType>(inst.c);
+            // integers are kept sign-extended, so widening is a copy.
+            if (from == t || ((from == IrType::kChar || from == IrType::kI32) && (i32 || i64)))
+                return BcOp::kMove;
+            if (from == IrType::kI64 && i32)
+                return BcOp::kConvI64I32;
+            if (IsIntegralIrType(from) && from != IrType::kBool && f64)
+                return BcOp::kConvIF64;
+            if (from == IrType::kF64 && i32)
+                return BcOp::kConvF64I32;
+            return inst.op;
+        }
+        default:
+            return inst.op;
+        }
+    }
+
+    std::size_t BcProgram::CodeSize() const
+    {
+        std::size_t n = 0;
+        for (const auto &fn : functions)
+            n += fn.code.size();
+        return n;
+    }
+
+    bool BcProgram::IsSubclass(std::uint32_t cls, std::uint32_t of) const
+    {
+        for (std::int32_t c = static_cast<std::int32_t>(cls); c >= 0; c = classes[c].base)
+        {
+            if (static_cast<std::uint32_t>(c) == of)
+                return true;
+        }
+        return false;
+    }
+
+    namespace
+    {
+        BcOp TranslateOp(IrOp op)
+        {
+            switch (op)
+            {
+            case IrOp::kAdd:
+                return BcOp::kAdd;
+            case IrOp::kSub:
+                return BcOp::kSub;
+            case IrOp::kMul:
+                return BcOp::kMul;
+            case IrOp::kDiv:
+                return BcOp::kDiv;
+            case IrOp::kRem:
+                return BcOp::kRem;
+            case IrOp::kAnd:
+                return BcOp::kAnd;
+            case IrOp::kOr:
+                return BcOp::kOr;
+            case IrOp::kXor:
+                return BcOp::kXor;
+            case IrOp::kShl:
+                return BcOp::kShl;
+            case IrOp::kShr:
+                return BcOp::kShr;
+            case IrOp::kNeg:
+                return BcOp::kNeg;
+            case IrOp::kNot:
+                return BcOp::kNot;
+            case IrOp::kEq:
+                return BcOp::kEq;
+            case IrOp::kNe:
+                return BcOp::kNe;
+            case IrOp::kLt:
+                return BcOp::kLt;
+            case IrOp::kLe:
+                return BcOp::kLe;
+            case IrOp::kGt:
+                return BcOp::kGt;
+            case IrOp::kGe:
+                return BcOp::kGe;
+            case IrOp::kStrEq:
+                return BcOp::kStrEq;
+            case IrOp::kConcat:
+                return BcOp::kConcat;
+            case IrOp::kArrayLength:
+                return BcOp::kArrayLength;
+            case IrOp::kStringLength:
+                return BcOp::kStringLength;
+            case IrOp::kCharAt:
+                return BcOp::kCharAt;
+            case IrOp::kLoadElem:
+                return BcOp::kGetElem;
+            case IrOp::kAwait:
+                return BcOp::kAwait;
+            default:
+                return BcOp::kNop;
+            }
+        }
+
+        // translates one IrFunction. string loads carry the function's own
+        // string index until the program-wide table is built.
+        class FunctionCompiler
+        {
+        public:
+            FunctionCompiler(const IrFunction &fn, const IrModule &module, const BcOptions &options)
+                : fn_(fn), module_(module), options_(options)
+            {
+            }
+
+            BcFunction Compile()
+            {
+                out_.name = fn_.name;
+                out_.return_type = fn_.return_type;
+                CountUses();
+                AssignRegisters();
+                if (options_.coalesce_moves)
+                    CoalesceMoves();
+                line_ = fn_.NumInsts() ? fn_.Line(0) : 0;
+                for (ValueId v = 0; v < fn_.NumInsts(); v++)
+                {
+                    if (fn_.Inst(v).op == IrOp::kConst)
+                        LoadConstant(v);
+                }
+                block_pc_.assign(fn_.NumBlocks(), 0);
+                for (BlockId b = 0; b < fn_.NumBlocks(); b++)
+                {
+                    block_pc_[b] = static_cast<std::uint32_t>(out_.code.size());
+                    const IrBlock &block = fn_.Block(b);
+                    last_compare_ = kNoValue;
+                    for (ValueId v = block.begin; v + 1 < block.end;)
+                    {
+                        line_ = fn_.Line(v);
+                        std::uint32_t pc = static_cast<std::uint32_t>(out_.code.size());
+                        std::uint32_t consumed = Translate(v, block.end - 1);
+                        if (consumed == 1 && IsSafepoint(fn_.Inst(v)))
+                            safepoints_.emplace_back(v, pc);
+                        v += consumed;
+                    }
+                    line_ = fn_.Line(block.end - 1);
+                    Terminate(b);
+                }
+                for (auto [pc, target] : fixups_)
+                    out_.code[pc].SetWide(block_pc_[target]);
+                EmitStackMaps();
+                EmitAwaitPoints();
+                return std::move(out_);
+            }
+
+        private:
+            template <typename F>
+            void ForEachOperand(const IrInst &inst, F &&fn) const
+            {
+                if (HasOperandList(inst.op))
+                {
+                    for (ValueId op : fn_.Operands(inst))
+                    {
+                        if (op != kNoValue)
+                            fn(op);
+                    }
+                }
+                std::uint8_t mask = ValueOperandMask(inst.op);
+                if ((mask & 1) && inst.a != kNoValue)
+                    fn(inst.a);
+                if ((mask & 2) && inst.b != kNoValue)
+                    fn(inst.b);
+                if ((mask & 4) && inst.c != kNoValue)
+                    fn(inst.c);
+            }
+
+            void CountUses()
+            {
+                uses_.assign(fn_.NumInsts(), 0);
+                for (ValueId v = 0; v < fn_.NumInsts(); v++)
+                    ForEachOperand(fn_.Inst(v), [&](ValueId op)
+                                   { uses_[op]++; });
+            }
+
+            void AssignRegisters()
+            {
+                std::uint32_t next = static_cast<std::uint32_t>(fn_.param_types.size());
+                regs_.assign(fn_.NumInsts(), kNoRegister);
+                for (ValueId v = 0; v < fn_.NumInsts(); v++)
+                {
+                    const IrInst &inst = fn_.Inst(v);
+                    if (inst.op == IrOp::kParam)
+                    {
+                        regs_[v] = static_cast<std::uint16_t>(inst.a);
+                        continue;
+                    }
+                    if (inst.type == IrType::kVoid || inst.op == IrOp::kNop)
+                        continue;
+                    if (next >= kMaxRegisters - 1)
+                        throw std::runtime_error(fn_.name + ": too many values for 16-bit registers");
+                    regs_[v] = static_cast<std::uint16_t>(next++);
+                }
+                // scratch register for breaking cycles of phi moves. moves
+                // never allocate, so it is invisible to the collector.
+                scratch_ = static_cast<std::uint16_t>(next++);
+                out_.num_params = static_cast<std::uint16_t>(fn_.param_types.size());
+                out_.num_registers = static_cast<std::uint16_t>(next);
+            }
+
+            // a value whose only use is a phi operand, defined in the
+            // predecessor the operand comes from, can be computed straight
+            // into the phi's register. that is safe when the phi's current
+            // value is dead from the definition on: not read later in the
+            // block and not live out of it along any edge.
+            void CoalesceMoves()
+            {
+                struct Candidate
+                {
+                    ValueId phi;
+                    ValueId value;
+                    BlockId from;
+                };
+                std::vector<BlockId> block_of(fn_.NumInsts());
+                for (BlockId b = 0; b < fn_.NumBlocks(); b++)
+                {
+                    for (ValueId v = fn_.Block(b).begin; v < fn_.Block(b).end; v++)
+                        block_of[v] = b;
+                }
+                std::vector<Candidate> candidates;
+                std::vector<std::uint32_t> phi_index(fn_.NumInsts(), kNoValue);
+                std::uint32_t num_phis = 0;
+                for (BlockId b = 0; b < fn_.NumBlocks(); b++)
+                {
+                    IrSpan<BlockId> preds = fn_.Preds(b);
+                    for (ValueId v = fn_.Block(b).begin; fn_.Inst(v).op == IrOp::kPhi; v++)
+                    {
+                        IrSpan<ValueId> ops = fn_.Operands(fn_.Inst(v));
+                        for (std::uint32_t i = 0; i < ops.size() && i < preds.size(); i++)
+                        {
+                            ValueId w = ops[i];
+                            if (w == kNoValue || uses_[w] != 1 || block_of[w] != preds[i] || regs_[w] == kNoRegister)
+                                continue;
+                            const IrInst &def = fn_.Inst(w);
+                            if (def.op == IrOp::kPhi || def.op == IrOp::kParam || def.op == IrOp::kConst ||
+                                def.type != fn_.Inst(v).type)
+                                continue;
+                            candidates.push_back(Candidate{v, w, preds[i]});
+                            if (phi_index[v] == kNoValue)
+                                phi_index[v] = num_phis++;
+                        }
+                    }
+                }
+                if (candidates.empty())
+                    return;
+
+                // where each candidate phi is used: the block of an ordinary
+                // use, or the predecessor a phi operand flows in from.
+                struct Use
+                {
+                    BlockId block;
+                    bool at_end;
+                };
+                std::vector<std::vector<Use>> uses(num_phis);
+                for (BlockId b = 0; b < fn_.NumBlocks(); b++)
+                {
+                    IrSpan<BlockId> preds = fn_.Preds(b);
+                    for (ValueId v = fn_.Block(b).begin; v < fn_.Block(b).end; v++)
+                    {
+                        const IrInst &inst = fn_.Inst(v);
+                        if (inst.op == IrOp::kPhi)
+                        {
+                            IrSpan<ValueId> ops = fn_.Operands(inst);
+                            for (std::uint32_t i = 0; i < ops.size() && i < preds.size(); i++)
+                            {
+                                if (ops[i] != kNoValue && phi_index[ops[i]] != kNoValue)
+                                    uses[phi_index[ops[i]]].push_back(Use{preds[i], true});
+                            }
+                            continue;
+                        }
+                        ForEachOperand(inst, [&](ValueId op)
+                                       {
+                                           if (phi_index[op] != kNoValue)
+                                               uses[phi_index[op]].push_back(Use{b, false}); });
+                    }
+                }
+
+                std::vector<std::vector<bool>> live_out(num_phis);
+                std::vector<bool> live_in;
+                std::vector<BlockId> work;
+                for (ValueId phi = 0; phi < fn_.NumInsts(); phi++)
+                {
+                    if (phi_index[phi] == kNoValue)
+                        continue;
+                    std::vector<bool> &out = live_out[phi_index[phi]];
+                    out.assign(fn_.NumBlocks(), false);
+                    live_in.assign(fn_.NumBlocks(), false);
+                    BlockId def = block_of[phi];
+                    auto enter = [&](BlockId b)
+                    {
+                        if (b != def && !live_in[b])
+                        {
+                            live_in[b] = true;
+                            work.push_back(b);
+                        }
+                    };
+                    for (const Use &use : uses[phi_index[phi]])
+                    {
+                        if (use.at_end)
+                            out[use.block] = true;
+                        enter(use.block);
+                    }
+                    while (!work.empty())
+                    {
+                        BlockId b = work.back();
+                        work.pop_back();
+                        for (BlockId pred : fn_.Preds(b))
+                        {
+                            out[pred] = true;
+                            enter(pred);
+                        }
+                    }
+                }
+
+                for (const Candidate &c : candidates)
+                {
+                    if (live_out[phi_index[c.phi]][c.from])
+                        continue;
+                    bool read_later = false;
+                    for (ValueId v = c.value + 1; v < fn_.Block(c.from).end && !read_later; v++)
+                        ForEachOperand(fn_.Inst(v), [&](ValueId op)
+                                       { read_later = read_later || op == c.phi; });
+                    if (!read_later)
+                        regs_[c.value] = regs_[c.phi];
+                }
+            }
+
+            // instructions whose translation may allocate, or call code
+            // that does. string compares and indexing flatten ropes.
+            static bool IsSafepoint(const IrInst &inst)
+            {
+                switch (inst.op)
+                {
+                case IrOp::kNewObject:
+                case IrOp::kNewArray:
+                case IrOp::kConcat:
+                case IrOp::kToString:
+                case IrOp::kStrEq:
+                case IrOp::kCharAt:
+                case IrOp::kCall:
+                case IrOp::kCallVirtual:
+                case IrOp::kCallBuiltin:
+                case IrOp::kCallInit:
+                case IrOp::kAwait:
+                    return true;
+                case IrOp::kConvert:
+                    return inst.type == IrType::kRef && static_cast<IrType>(inst.aux) != IrType::kRef;
+                default:
+                    return false;
+                }
+            }
+
+            // the registers of the tracked values live across or read by
+            // each instruction in points, from a backward liveness pass
+            // over the SSA form. the instruction's own result is left out,
+            // its register holds nothing valid yet. constants are loaded on
+            // entry and stay valid throughout, so every point lists the
+            // tracked ones. lists are sorted and have no duplicates.
+            template <typename Tracked>
+            std::vector<std::vector<std::uint16_t>> LiveRegisters(const std::vector<ValueId> &points, Tracked &&tracked) const
+            {
+                std::vector<std::uint32_t> index(fn_.NumInsts(), kNoValue);
+                std::vector<ValueId> values;
+                std::vector<std::uint16_t> constants;
+                for (ValueId v = 0; v < fn_.NumInsts(); v++)
+                {
+                    const IrInst &inst = fn_.Inst(v);
+                    if (regs_[v] == kNoRegister || !tracked(inst))
+                        continue;
+                    if (inst.op == IrOp::kConst)
+                        constants.push_back(regs_[v]);
+                    else
+                    {
+                        index[v] = static_cast<std::uint32_t>(values.size());
+                        values.push_back(v);
+                    }
+                }
+                const std::uint32_t num_values = static_cast<std::uint32_t>(values.size());
+
+                // values read by the phis of to along the edge from from.
+                auto edge_uses = [&](BlockId from, BlockId to, std::vector<bool> &live)
+                {
+                    IrSpan<BlockId> preds = fn_.Preds(to);
+                    for (std::uint32_t i = 0; i < preds.size(); i++)
+                    {
+                        if (preds[i] != from)
+                            continue;
+                        for (ValueId v = fn_.Block(to).begin; fn_.Inst(v).op == IrOp::kPhi; v++)
+                        {
+                            IrSpan<ValueId> ops = fn_.Operands(fn_.Inst(v));
+                            if (i < ops.size() && ops[i] != kNoValue && index[ops[i]] != kNoValue)
+                                live[index[ops[i]]] = true;
+                        }
+                    }
+                };
+                auto live_out_of = [&](BlockId b, std::vector<bool> &live, const std::vector<std::vector<bool>> &live_in)
+                {
+                    live.assign(num_values, false);
+                    BlockId succs[2];
+                    std::uint32_t n = fn_.Successors(b, succs);
+                    for (std::uint32_t i = 0; i < n; i++)
+                    {
+                        for (std::uint32_t r = 0; r < num_values; r++)
+                        {
+                            if (live_in[succs[i]][r])
+                                live[r] = true;
+                        }
+                        edge_uses(b, succs[i], live);
+                    }
+                };
+                // steps live from after v to before it.
+                auto step = [&](ValueId v, std::vector<bool> &live)
+                {
+                    if (index[v] != kNoValue)
+                        live[index[v]] = false;
+                    ForEachOperand(fn_.Inst(v), [&](ValueId op)
+                                   {
+                                       if (index[op] != kNoValue)
+                                           live[index[op]] = true; });
+                };
+
+                std::vector<std::vector<bool>> live_in(fn_.NumBlocks(), std::vector<bool>(num_values, false));
+                std::vector<bool> live;
+                for (bool changed = true; changed;)
+                {
+                    changed = false;
+                    for (BlockId b = fn_.NumBlocks(); b-- > 0;)
+                    {
+                        live_out_of(b, live, live_in);
+                        const IrBlock &block = fn_.Block(b);
+                        for (ValueId v = block.end; v-- > block.begin && fn_.Inst(v).op != IrOp::kPhi;)
+                            step(v, live);
+                        for (ValueId v = block.begin; v < block.end && fn_.Inst(v).op == IrOp::kPhi; v++)
+                        {
+                            if (index[v] != kNoValue)
+                                live[index[v]] = false;
+                        }
+                        if (live != live_in[b])
+                        {
+                            live_in[b] = live;
+                            changed = true;
+                        }
+                    }
+                }
+
+                std::vector<std::uint32_t> point_of(fn_.NumInsts(), kNoValue);
+                for (std::uint32_t i = 0; i < points.size(); i++)
+                    point_of[points[i]] = i;
+                std::vector<std::vector<std::uint16_t>> result(points.size());
+                for (BlockId b = 0; b < fn_.NumBlocks(); b++)
+                {
+                    const IrBlock &block = fn_.Block(b);
+                    live_out_of(b, live, live_in);
+                    for (ValueId v = block.end; v-- > block.begin && fn_.Inst(v).op != IrOp::kPhi;)
+                    {
+                        if (point_of[v] != kNoValue)
+                        {
+                            std::vector<std::uint16_t> &regs = result[point_of[v]];
+                            regs = constants;
+                            std::vector<bool> at = live;
+                            ForEachOperand(fn_.Inst(v), [&](ValueId op)
+                                           {
+                                               if (index[op] != kNoValue)
+                                                   at[index[op]] = true; });
+                            for (std::uint32_t r = 0; r < num_values; r++)
+                            {
+                                if (at[r] && values[r] != v)
+                                    regs.push_back(regs_[values[r]]);
+                            }
+                            std::sort(regs.begin(), regs.end());
+                            regs.erase(std::unique(regs.begin(), regs.end()), regs.end());
+                        }
+                        step(v, live);
+                    }
+                }
+                return result;
+            }
+
+            // the stack map of each safepoint: the registers of the
+            // reference values live across it or read by it.
+            void EmitStackMaps()
+            {
+                if (safepoints_.empty())
+                    return;
+                std::vector<ValueId> points;
+                for (auto [v, pc] : safepoints_)
+                    points.push_back(v);
+                auto maps = LiveRegisters(points, [](const IrInst &inst)
+                                          { return inst.type == IrType::kRef; });
+                for (std::size_t i = 0; i < points.size(); i++)
+                {
+                    const std::vector<std::uint16_t> &regs = maps[i];
+                    if (regs.empty())
+                        continue;
+                    out_.stack_maps.push_back(BcStackMap{safepoints_[i].second, static_cast<std::uint32_t>(out_.stack_map_registers.size()),
+                                                         static_cast<std::uint32_t>(regs.size())});
+                    out_.stack_map_registers.insert(out_.stack_map_registers.end(), regs.begin(), regs.end());
+                }
+            }
+
+            // what each await saves when it suspends the function: every
+            // register live across it, whatever its type, references first.
+            // the awaited task is among them, since resuming runs the await
+            // again.
+            void EmitAwaitPoints()
+            {
+                std::vector<ValueId> points;
+                std::vector<std::uint32_t> pcs;
+                for (auto [v, pc] : safepoints_)
+                {
+                    if (fn_.Inst(v).op == IrOp::kAwait)
+                    {
+                        points.push_back(v);
+                        pcs.push_back(pc);
+                    }
+                }
+                if (points.empty())
+                    return;
+                std::vector<bool> is_ref(out_.num_registers, false);
+                for (ValueId v = 0; v < fn_.NumInsts(); v++)
+                {
+                    if (regs_[v] != kNoRegister && fn_.Inst(v).type == IrType::kRef)
+                        is_ref[regs_[v]] = true;
+                }
+                auto saved = LiveRegisters(points, [](const IrInst &inst)
+                                           { return inst.type != IrType::kVoid; });
+                for (std::size_t i = 0; i < points.size(); i++)
+                {
+                    std::vector<std::uint16_t> &regs = saved[i];
+                    auto refs_end = std::stable_partition(regs.begin(), regs.end(), [&](std::uint16_t r)
+                                                          { return is_ref[r]; });
+                    out_.await_points.push_back(BcAwaitPoint{pcs[i], static_cast<std::uint32_t>(out_.await_registers.size()),
+                                                             static_cast<std::uint32_t>(regs.size()),
+                                                             static_cast<std::uint32_t>(refs_end - regs.begin())});
+                    out_.await_registers.insert(out_.await_registers.end(), regs.begin(), regs.end());
+                    out_.await_slots = std::max(out_.await_slots, static_cast<std::uint32_t>(regs.size()));
+                }
+            }
+
+            std::uint16_t Reg(ValueId v) const { return v == kNoValue ? kNoRegister : regs_[v]; }
+
+            std::uint16_t Narrow(std::uint32_t x, const char *what) const
+            {
+                if (x > 0xffff)
+                    throw std::runtime_error(fn_.name + ": " + what + " does not fit in 16 bits");
+                return static_cast<std::uint16_t>(x);
+            }
+
+            std::uint32_t Emit(BcOp op, IrType type, std::uint16_t a = 0, std::uint16_t b = 0, std::uint16_t c = 0)
+            {
+                out_.code.push_back(BcInst{op, type, a, b, c});
+                out_.lines.push_back(line_);
+                return static_cast<std::uint32_t>(out_.code.size() - 1);
+            }
+
+            void EmitCall(BcOp op, IrType type, ValueId result, const ValueId *args, std::uint32_t argc, std::uint32_t callee)
+            {
+                Emit(op, type, Reg(result), Narrow(argc, "argument count"), Narrow(callee, "callee"));
+                for (std::uint32_t i = 0; i < argc; i += 4)
+                {
+                    std::uint16_t words[4] = {0, 0, 0, 0};
+                    for (std::uint32_t j = 0; j < 4 && i + j < argc; j++)
+                        words[j] = Reg(args[i + j]);
+                    BcInst packed;
+                    std::memcpy(&packed, words, sizeof packed);
+                    out_.code.push_back(packed);
+                    out_.lines.push_back(line_);
+                }
+                // numbered once the whole program is compiled.
+                if (op == BcOp::kCallVirtual)
+                    Emit(BcOp::kNop, IrType::kVoid);
+            }
+
+            void EmitJump(BcOp op, std::uint16_t cond, BlockId target)
+            {
+                fixups_.emplace_back(Emit(op, IrType::kVoid, cond), target);
+            }
+
+            void LoadConstant(ValueId v)
+            {
+                const IrInst &inst = fn_.Inst(v);
+                if (inst.type == IrType::kRef)
+                {
+                    if (inst.aux == 1)
+                        Emit(BcOp::kLoadStr, IrType::kRef, Reg(v), static_cast<std::uint16_t>(inst.a), static_cast<std::uint16_t>(inst.a >> 16));
+                    else
+                        Emit(BcOp::kLoadNull, IrType::kRef, Reg(v));
+                    return;
+                }
+                std::int64_t bits = inst.Imm();
+                if (inst.type == IrType::kF32)
+                {
+                    float f = static_cast<float>(inst.FloatImm());
+                    std::uint32_t raw;
+                    std::memcpy(&raw, &f, sizeof raw);
+                    bits = raw;
+                }
+                auto [it, inserted] = constant_index_.emplace(bits, static_cast<std::uint32_t>(out_.constants.size()));
+                if (inserted)
+                    out_.constants.push_back(bits);
+                BcInst &load = out_.code[Emit(BcOp::kLoadK, inst.type, Reg(v))];
+                load.SetWide(it->second);
+            }
+
+            // folds "x = load; y = x + z; store y" over one field, static or
+            // element into a single read-modify-write instruction when x and
+            // y have no other use. a widening of z between the load and the
+            // add ("total += i" on a long) is emitted first. returns the
+            // instructions consumed.
+            std::uint32_t FuseLoadAddStore(ValueId v, ValueId end)
+            {
+                if (!options_.superinstructions || uses_[v] != 1)
+                    return 0;
+                ValueId convert = SkipConstants(v + 1, end);
+                const IrInst &between = fn_.Inst(convert);
+                ValueId sum = convert;
+                if (between.op == IrOp::kConvert && between.a != v && between.type != IrType::kRef &&
+                    static_cast<IrType>(between.aux) != IrType::kRef)
+                    sum = SkipConstants(convert + 1, end);
+                else
+                    convert = kNoValue;
+                ValueId at = SkipConstants(sum + 1, end);
+                if (at >= end || uses_[sum] != 1)
+                    return 0;
+                const IrInst &load = fn_.Inst(v);
+                const IrInst &add = fn_.Inst(sum);
+                const IrInst &store = fn_.Inst(at);
+                if (add.op != IrOp::kAdd || (add.a != v && add.b != v))
+                    return 0;
+                if (add.type != IrType::kI32 && add.type != IrType::kI64 && add.type != IrType::kF64)
+                    return 0;
+                ValueId addend = add.a == v ? add.b : add.a;
+                BcInst fused{BcOp::kNop, add.type, 0, 0, 0};
+                if (load.op == IrOp::kLoadField && store.op == IrOp::kStoreField && store.a == load.a &&
+                    store.b == sum && store.c == load.c)
+                    fused = BcInst{BcOp::kAddField, add.type, Reg(load.a), Reg(addend), Narrow(load.c, "field slot")};
+                else if (load.op == IrOp::kLoadStatic && store.op == IrOp::kStoreStatic && store.b == sum && store.c == load.c)
+                    fused = BcInst{BcOp::kAddStatic, add.type, 0, Reg(addend), Narrow(load.c, "static slot")};
+                else if (load.op == IrOp::kLoadElem && store.op == IrOp::kStoreElem && store.a == load.a &&
+                         store.b == load.b && store.c == sum && load.type == add.type)
+                    fused = BcInst{BcOp::kAddElem, add.type, Reg(load.a), Reg(load.b), Reg(addend)};
+                if (fused.op == BcOp::kNop)
+                    return 0;
+                if (convert != kNoValue)
+                    Translate(convert, end);
+                Emit(fused.op, fused.type, fused.a, fused.b, fused.c);
+                return at + 1 - v;
+            }
+
+            // constants are loaded on entry, so they emit nothing in place
+            // and never separate the parts of a fused sequence.
+            ValueId SkipConstants(ValueId v, ValueId end) const
+            {
+                while (v < end && (fn_.Inst(v).op == IrOp::kConst || fn_.Inst(v).op == IrOp::kNop))
+                    v++;
+                return v;
+            }
+
+            // translates the instruction at v, which lies before the block's
+            // terminator at end. returns the instructions consumed.
+            std::uint32_t Translate(ValueId v, ValueId end)
+            {
+                const IrInst &inst = fn_.Inst(v);
+                switch (inst.op)
+                {
+                case IrOp::kNop:
+                case IrOp::kConst:
+                case IrOp::kParam:
+                case IrOp::kPhi:
+                    return 1;
+                case IrOp::kNeg:
+                case IrOp::kNot:
+                case IrOp::kArrayLength:
+                case IrOp::kStringLength:
+                case IrOp::kAwait:
+                    Emit(TranslateOp(inst.op), inst.type, Reg(v), Reg(inst.a));
+                    return 1;
+                case IrOp::kEq:
+                case IrOp::kNe:
+                case IrOp::kLt:
+                case IrOp::kLe:
+                case IrOp::kGt:
+                case IrOp::kGe:
+                    last_compare_ = v;
+                    last_compare_pc_ = Emit(TranslateOp(inst.op), static_cast<IrType>(inst.aux), Reg(v), Reg(inst.a), Reg(inst.b));
+                    return 1;
+                case IrOp::kConvert:
+                    Emit(BcOp::kConvert, inst.type, Reg(v), Reg(inst.a), inst.aux);
+                    return 1;
+                case IrOp::kToString:
+                    Emit(BcOp::kToString, IrType::kRef, Reg(v), Reg(inst.a), inst.aux);
+                    return 1;
+                case IrOp::kLoadField:
+                case IrOp::kLoadStatic:
+                case IrOp::kLoadElem:
+                    if (std::uint32_t fused = FuseLoadAddStore(v, end))
+                        return fused;
+                    if (inst.op == IrOp::kLoadElem)
+                    {
+                        Emit(BcOp::kGetElem, inst.type, Reg(v), Reg(inst.a), Reg(inst.b));
+                        return 1;
+                    }
+                    if (inst.op == IrOp::kLoadStatic)
+                    {
+                        Emit(BcOp::kGetStatic, inst.type, Reg(v), 0, Narrow(inst.c, "static slot"));
+                        return 1;
+                    }
+                    Emit(BcOp::kGetField, inst.type, Reg(v), Reg(inst.a), Narrow(inst.c, "field slot"));
+                    return 1;
+                case IrOp::kStoreField:
+                    Emit(BcOp::kSetField, fn_.Inst(inst.b).type, Reg(inst.a), Reg(inst.b), Narrow(inst.c, "field slot"));
+                    return 1;
+                case IrOp::kStoreStatic:
+                    Emit(BcOp::kSetStatic, fn_.Inst(inst.b).type, 0, Reg(inst.b), Narrow(inst.c, "static slot"));
+                    return 1;
+                case IrOp::kNewObject:
+                    Emit(BcOp::kNew, IrType::kRef, Reg(v), 0, Narrow(inst.c, "class id"));
+                    return 1;
+                case IrOp::kNewArray:
+                    Emit(BcOp::kNewArray, static_cast<IrType>(inst.aux), Reg(v), Reg(inst.a));
+                    return 1;
+                case IrOp::kStoreElem:
+                    Emit(BcOp::kSetElem, fn_.Inst(inst.c).type, Reg(inst.a), Reg(inst.b), Reg(inst.c));
+                    return 1;
+                case IrOp::kCheckCast:
+                    Emit(BcOp::kCheckCast, IrType::kRef, Reg(v), Reg(inst.a), Narrow(inst.c, "class id"));
+                    return 1;
+                case IrOp::kCall:
+                case IrOp::kCallVirtual:
+                case IrOp::kCallBuiltin:
+                {
+                    IrSpan<ValueId> args = fn_.Operands(inst);
+                    std::uint32_t callee = inst.c;
+                    BcOp op = BcOp::kCall;
+                    if (inst.op == IrOp::kCallVirtual)
+                    {
+                        op = BcOp::kCallVirtual;
+                        callee = static_cast<std::uint32_t>(module_.globals->methods()[inst.c]->vtable_slot);
+                    }
+                    else if (inst.op == IrOp::kCallBuiltin)
+                    {
+                        op = BcOp::kCallBuiltin;
+                    }
+                    EmitCall(op, inst.type, v, args.data, args.count, callee);
+                    return 1;
+                }
+                case IrOp::kCallInit:
+                {
+                    ValueId object = inst.a;
+                    EmitCall(BcOp::kCall, IrType::kVoid, kNoValue, &object, 1,
+                             static_cast<std::uint32_t>(module_.instance_init[inst.c]));
+                    return 1;
+                }
+                default:
+                    // binary ops, string ops, loads
+                    Emit(TranslateOp(inst.op), inst.type, Reg(v), Reg(inst.a), Reg(inst.b));
+                    return 1;
+                }
+            }
+
+            bool HasPhis(BlockId b) const { return fn_.Inst(fn_.Block(b).begin).op == IrOp::kPhi; }
+
+            // the phis of to read their operand for the edge from from. the
+            // copies happen in parallel, so a register is only overwritten
+            // once no pending copy still reads it; cycles go through the
+            // scratch register.
+            void EdgeMoves(BlockId from, BlockId to)
+            {
+                IrSpan<BlockId> preds = fn_.Preds(to);
+                std::uint32_t index = 0;
+                while (index < preds.size() && preds[index] != from)
+                    index++;
+                std::vector<std::pair<std::uint16_t, std::uint16_t>> moves;
+                for (ValueId v = fn_.Block(to).begin; fn_.Inst(v).op == IrOp::kPhi; v++)
+                {
+                    IrSpan<ValueId> ops = fn_.Operands(fn_.Inst(v));
+                    if (index >= ops.size() || ops[index] == kNoValue || Reg(ops[index]) == Reg(v))
+                        continue;
+                    moves.emplace_back(Reg(v), Reg(ops[index]));
+                }
+                while (!moves.empty())
+                {
+                    bool emitted = false;
+                    for (std::size_t i = 0; i < moves.size() && !emitted; i++)
+                    {
+                        std::uint16_t dst = moves[i].first;
+                        bool read = std::any_of(moves.begin(), moves.end(), [&](const auto &m)
+                                                { return m.second == dst; });
+                        if (!read)
+                        {
+                            Emit(BcOp::kMove, IrType::kVoid, dst, moves[i].second);
+                            moves.erase(moves.begin() + static_cast<std::ptrdiff_t>(i));
+                            emitted = true;
+                        }
+                    }
+                    if (!emitted)
+                    {
+                        std::uint16_t saved = moves.front().first;
+                        Emit(BcOp::kMove, IrType::kVoid, scratch_, saved);
+                        for (auto &m : moves)
+                        {
+                            if (m.second == saved)
+                                m.second = scratch_;
+                        }
+                    }
+                }
+            }
+
+            // an integer compare whose only use is the branch on it.
+            bool FusableCompare(ValueId cond) const
+            {
+                if (!options_.superinstructions || uses_[cond] != 1 || !IsCompare(fn_.Inst(cond).op))
+                    return false;
+                const IrInst &cmp = fn_.Inst(cond);
+                IrType t = static_cast<IrType>(cmp.aux);
+                return IsIntegralIrType(t) || (t == IrType::kRef && (cmp.op == IrOp::kEq || cmp.op == IrOp::kNe));
+            }
+
+            // the fused jump taken when the compare's result is when. the
+            // operands are integers, so the negation of a compare is the
+            // opposite compare.
+            static BcOp FusedJump(IrOp cmp, bool when)
+            {
+                static const BcOp kTaken[] = {BcOp::kJumpIfEqI, BcOp::kJumpIfNeI, BcOp::kJumpIfLtI,
+                                              BcOp::kJumpIfLeI, BcOp::kJumpIfGtI, BcOp::kJumpIfGeI};
+                static const BcOp kNotTaken[] = {BcOp::kJumpIfNeI, BcOp::kJumpIfEqI, BcOp::kJumpIfGeI,
+                                                 BcOp::kJumpIfGtI, BcOp::kJumpIfLeI, BcOp::kJumpIfLtI};
+                std::size_t i = static_cast<std::size_t>(cmp) - static_cast<std::size_t>(IrOp::kEq);
+                return when ? kTaken[i] : kNotTaken[i];
+            }
+
+            // returns the word holding the jump target.
+            std::uint32_t EmitCompareJump(bool when, ValueId cond)
+            {
+                const IrInst &cmp = fn_.Inst(cond);
+                Emit(FusedJump(cmp.op, when), static_cast<IrType>(cmp.aux), Reg(cmp.a), Reg(cmp.b));
+                return Emit(BcOp::kNop, IrType::kVoid);
+            }
+
+            // a jump taken when cond is when. a compare emitted right before
+            // that only feeds this branch is folded into it. returns the word
+            // holding the jump target.
+            std::uint32_t EmitCondJump(bool when, ValueId cond)
+            {
+                if (cond == last_compare_ && last_compare_pc_ + 1 == out_.code.size() && FusableCompare(cond))
+                {
+                    out_.code.pop_back();
+                    out_.lines.pop_back();
+                    last_compare_ = kNoValue;
+                    return EmitCompareJump(when, cond);
+                }
+                return Emit(when ? BcOp::kJumpIfTrue : BcOp::kJumpIfFalse, IrType::kVoid, Reg(cond));
+            }
+
+            void EmitCondJump(bool when, ValueId cond, BlockId target)
+            {
+                fixups_.emplace_back(EmitCondJump(when, cond), target);
+            }
+
+            // a back edge to a loop header that does nothing but test its
+            // phis repeats the test here and enters the body directly. the
+            // jump to the header that follows is only taken to leave the
+            // loop, so each iteration saves a dispatch.
+            void RepeatLoopTest(BlockId header)
+            {
+                if (!options_.superinstructions)
+                    return;
+                const IrBlock &block = fn_.Block(header);
+                ValueId cond = block.begin;
+                while (fn_.Inst(cond).op == IrOp::kPhi)
+                    cond++;
+                cond = SkipConstants(cond, block.end - 1);
+                const IrInst &term = fn_.Terminator(header);
+                if (SkipConstants(cond + 1, block.end - 1) != block.end - 1 || term.op != IrOp::kBranch || term.a != cond || term.b == term.c ||
+                    !FusableCompare(cond))
+                    return;
+                if (!HasPhis(term.b))
+                    fixups_.emplace_back(EmitCompareJump(true, cond), term.b);
+                else if (!HasPhis(term.c))
+                    fixups_.emplace_back(EmitCompareJump(false, cond), term.c);
+            }
+
+            void Terminate(BlockId b)
+            {
+                const IrInst &term = fn_.Terminator(b);
+                BlockId next = b + 1;
+                switch (term.op)
+                {
+                case IrOp::kJump:
+                    EdgeMoves(b, term.a);
+                    if (term.a != next)
+                    {
+                        if (term.a <= b)
+                            RepeatLoopTest(term.a);
+                        EmitJump(BcOp::kJump, 0, term.a);
+                    }
+                    return;
+                case IrOp::kBranch:
+                {
+                    BlockId if_true = term.b;
+                    BlockId if_false = term.c;
+                    ValueId cond = term.a;
+                    if (if_true == if_false)
+                    {
+                        EdgeMoves(b, if_true);
+                        if (if_true != next)
+                            EmitJump(BcOp::kJump, 0, if_true);
+                        return;
+                    }
+                    bool moves_true = HasPhis(if_true);
+                    bool moves_false = HasPhis(if_false);
+                    if (!moves_true && !moves_false)
+                    {
+                        if (if_true == next)
+                        {
+                            EmitCondJump(false, cond, if_false);
+                        }
+                        else
+                        {
+                            EmitCondJump(true, cond, if_true);
+                            if (if_false != next)
+                                EmitJump(BcOp::kJump, 0, if_false);
+                        }
+                        return;
+                    }
+                    if (!moves_false)
+                    {
+                        EmitCondJump(false, cond, if_false);
+                        EdgeMoves(b, if_true);
+                        if (if_true != next)
+                            EmitJump(BcOp::kJump, 0, if_true);
+                        return;
+                    }
+                    if (!moves_true)
+                    {
+                        EmitCondJump(true, cond, if_true);
+                        EdgeMoves(b, if_false);
+                        if (if_false != next)
+                            EmitJump(BcOp::kJump, 0, if_false);
+                        return;
+                    }
+                    // both edges carry moves: the false edge gets its own
+                    // stub after the true edge's moves.
+                    std::uint32_t skip = EmitCondJump(false, cond);
+                    EdgeMoves(b, if_true);
+                    EmitJump(BcOp::kJump, 0, if_true);
+                    out_.code[skip].SetWide(static_cast<std::uint32_t>(out_.code.size()));
+                    EdgeMoves(b, if_false);
+                    if (if_false != next)
+                        EmitJump(BcOp::kJump, 0, if_false);
+                    return;
+                }
+                case IrOp::kReturn:
+                    if (term.a == kNoValue)
+                        Emit(BcOp::kReturnVoid, IrType::kVoid);
+                    else
+                        Emit(BcOp::kReturn, fn_.return_type, Reg(term.a));
+                    return;
+                case IrOp::kThrow:
+                    Emit(BcOp::kThrow, IrType::kRef, Reg(term.a));
+                    return;
+                default:
+                    throw std::runtime_error(fn_.name + ": block without terminator");
+                }
+            }
+
+            const IrFunction &fn_;
+            const IrModule &module_;
+            const BcOptions &options_;
+            BcFunction out_;
+            std::vector<std::uint32_t> uses_;
+            std::vector<std::uint16_t> regs_;
+            std::uint16_t scratch_ = 0;
+            std::vector<std::uint32_t> block_pc_;
+            std::vector<std::pair<std::uint32_t, BlockId>> fixups_;
+            // (value, pc) of each translated safepoint.
+            std::vector<std::pair<ValueId, std::uint32_t>> safepoints_;
+            std::unordered_map<std::int64_t, std::uint32_t> constant_index_;
+            // the compare translated last in the current block, for folding
+            // into the block's branch.
+            ValueId last_compare_ = kNoValue;
+            std::uint32_t last_compare_pc_ = 0;
+            int line_ = 0;
+        };
+
+        void PrintRegister(std::ostream &out, std::uint16_t r)
+        {
+            if (r == kNoRegister)
+                out << "_";
+            else
+                out << "r" << r;
+        }
+    }
+
+    BcProgram CompileBytecode(const IrModule &module, ThreadPool *pool, const BcOptions &options)
+    {
+        BcProgram program;
+        const GlobalSymbols &globals = *module.globals;
+        std::size_t count = module.functions.size();
+        if (count > 0xffff)
+        {
+            throw std::runtime_error("too many functions for 16-bit function numbers");
+        }
+        program.functions.resize(count);
+        auto compile = [&](std::size_t i)
+        {
+            if (module.functions[i])
+                program.functions[i] = FunctionCompiler(*module.functions[i], module, options).Compile();
+            else if (i < globals.methods().size())
+                program.functions[i].name = MethodSignature(globals.methods()[i]);
+        };
+        if (pool)
+        {
+            pool->ParallelFor(count, compile);
+        }
+        else
+        {
+            for (std::size_t i = 0; i < count; i++)
+                compile(i);
+        }
+
+        // one string table for the program, so each literal becomes a single
+        // runtime object. virtual call sites are numbered on the same walk.
+        std::unordered_map<std::string_view, std::uint32_t> string_ids;
+        for (std::size_t i = 0; i < count; i++)
+        {
+            auto &code = program.functions[i].code;
+            for (std::size_t pc = 0; pc < code.size(); pc += InstLength(code[pc]))
+            {
+                BcInst &inst = code[pc];
+                if (inst.op == BcOp::kCallVirtual)
+                    code[pc + CallLength(inst.b)].SetWide(program.num_call_sites++);
+                if (inst.op != BcOp::kLoadStr)
+                    continue;
+                std::string_view text = module.functions[i]->String(inst.Wide());
+                auto [it, inserted] = string_ids.emplace(text, static_cast<std::uint32_t>(program.strings.size()));
+                if (inserted)
+                    program.strings.emplace_back(text);
+                inst.SetWide(it->second);
+            }
+        }
+
+        program.classes.resize(globals.classes().size());
+        for (const ClassInfo *cls : globals.classes())
+        {
+            BcClass &out = program.classes[cls->id];
+            out.name = cls->qualified_name;
+            out.base = cls->base ? static_cast<std::int32_t>(cls->base->id) : -1;
+            out.num_slots = cls->instance_slots;
+            for (const ClassInfo *c = cls; c; c = c->base)
+            {
+                for (const FieldInfo *field : c->fields)
+                {
+                    if (!field->is_static && !field->is_const && IrTypeOf(field->type) == IrType::kRef)
+                        out.ref_slots.push_back(static_cast<std::uint16_t>(field->slot));
+                }
+            }
+            for (const MethodInfo *method : cls->vtable)
+                out.vtable.push_back(method->id);
+        }
+        program.num_statics = module.num_static_slots;
+        for (const FieldInfo *field : globals.static_fields())
+        {
+            if (!field->is_const && IrTypeOf(field->type) == IrType::kRef)
+                program.ref_statics.push_back(field->slot);
+        }
+        program.static_init = module.static_init;
+        program.entry = module.entry;
+        return program;
+    }
+
+    void PrintBytecode(std::ostream &out, const BcProgram &program, const BcFunction &fn)
+    {
+        out << "function " << fn.name << " : " << fn.num_params << " params, " << fn.num_registers << " registers\n";
+        for (std::size_t pc = 0; pc < fn.code.size(); pc += InstLength(fn.code[pc]))
+        {
+            const BcInst &inst = fn.code[pc];
+            out << "  " << pc << ": " << BcOpToString(inst.op);
+            if (inst.type != IrType::kVoid)
+                out << "." << IrTypeToString(inst.type);
+            switch (inst.op)
+            {
+            case BcOp::kNop:
+            case BcOp::kReturnVoid:
+                break;
+            case BcOp::kLoadK:
+                out << " ";
+                PrintRegister(out, inst.a);
+                out << ", " << fn.constants[inst.Wide()];
+                break;
+            case BcOp::kLoadStr:
+                out << " ";
+                PrintRegister(out, inst.a);
+                out << ", \"" << program.strings[inst.Wide()] << "\"";
+                break;
+            case BcOp::kLoadNull:
+            case BcOp::kReturn:
+            case BcOp::kThrow:
+                out << " ";
+                PrintRegister(out, inst.a);
+                break;
+            case BcOp::kJump:
+                out << " @" << inst.Wide();
+                break;
+            case BcOp::kJumpIfTrue:
+            case BcOp::kJumpIfFalse:
+                out << " ";
+                PrintRegister(out, inst.a);
+                out << ", @" << inst.Wide();
+                break;
+            case BcOp::kJumpIfEqI:
+            case BcOp::kJumpIfNeI:
+            case BcOp::kJumpIfLtI:
+            case BcOp::kJumpIfLeI:
+            case BcOp::kJumpIfGtI:
+            case BcOp::kJumpIfGeI:
+                out << " ";
+                PrintRegister(out, inst.a);
+                out << ", ";
+                PrintRegister(out, inst.b);
+                out << ", @" << (&inst)[1].Wide();
+                break;
+            case BcOp::kGetStatic:
+                out << " ";
+                PrintRegister(out, inst.a);
+                out << ", static " << inst.c;
+                break;
+            case BcOp::kSetStatic:
+            case BcOp::kAddStatic:
+                out << " static " << inst.c << ", ";
+                PrintRegister(out, inst.b);
+                break;
+            case BcOp::kGetField:
+            case BcOp::kSetField:
+            case BcOp::kAddField:
+                out << " ";
+                PrintRegister(out, inst.a);
+                out << ", ";
+                PrintRegister(out, inst.b);
+                out << ", slot " << inst.c;
+                break;
+            case BcOp::kNew:
+                out << " ";
+                PrintRegister(out, inst.a);
+                out << ", " << program.classes[inst.c].name;
+                break;
+            case BcOp::kCheckCast:
+                out << " ";
+                PrintRegister(out, inst.a);
+                out << ", ";
+                PrintRegister(out, inst.b);
+                out << ", " << program.classes[inst.c].name;
+                break;
+            case BcOp::kConvert:
+            case BcOp::kToString:
+                out << " ";
+                PrintRegister(out, inst.a);
+                out << ", ";
+                PrintRegister(out, inst.b);
+                out << " from " << IrTypeToString(static_cast<IrType>(inst.c));
+                break;
+            case BcOp::kMove:
+            case BcOp::kNeg:
+            case BcOp::kNegI32:
+            case BcOp::kNegF64:
+            case BcOp::kConvI64I32:
+            case BcOp::kConvIF64:
+            case BcOp::kConvF64I32:
+            case BcOp::kNot:
+            case BcOp::kNewArray:
+            case BcOp::kArrayLength:
+            case BcOp::kStringLength:
+            case BcOp::kAwait:
+                out << " ";
+                PrintRegister(out, inst.a);
+                out << ", ";
+                PrintRegister(out, inst.b);
+                break;
+            case BcOp::kCall:
+            case BcOp::kCallVirtual:
+            case BcOp::kCallBuiltin:
+            {
+                out << " ";
+                PrintRegister(out, inst.a);
+                if (inst.op == BcOp::kCall)
+                    out << ", " << program.functions[inst.c].name;
+                else if (inst.op == BcOp::kCallVirtual)
+                    out << ", vtable " << inst.c << " site " << CallSite(&inst);
+                else
+                    out << ", " << BuiltinToString(static_cast<Builtin>(inst.c));
+                out << "(";
+                for (std::uint32_t i = 0; i < inst.b; i++)
+                {
+                    if (i)
+                        out << ", ";
+                    PrintRegister(out, CallArgument(&inst, i));
+                }
+                out << ")";
+                break;
+            }
+            default:
+                out << " ";
+                PrintRegister(out, inst.a);
+                out << ", ";
+                PrintRegister(out, inst.b);
+                out << ", ";
+                PrintRegister(out, inst.c);
+                break;
+            }
+            if (const BcStackMap *map = fn.FindStackMap(static_cast<std::uint32_t>(pc)))
+            {
+                out << "  ; refs";
+                for (std::uint32_t i = 0; i < map->count; i++)
+                {
+                    out << " ";
+                    PrintRegister(out, fn.stack_map_registers[map->first + i]);
+                }
+            }
+            if (const BcAwaitPoint *point = fn.FindAwaitPoint(static_cast<std::uint32_t>(pc)))
+            {
+                out << "  ; saves";
+                for (std::uint32_t i = 0; i < point->count; i++)
+                {
+                    out << " ";
+                    PrintRegister(out, fn.await_registers[point->first + i]);
+                }
+            }
+            out << "\n";
+        }
+    }
+
+    void PrintBytecode(std::ostream &out, const BcProgram &program)
+    {
+        for (const auto &fn : program.functions)
+        {
+            if (!fn.code.empty())
+            {
+                PrintBytecode(out, program, fn);
+                out << "\n";
+            }
+        }
+    }
+
+}
@@ -0,0 +1,1275 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include "c_backend.h"
+#include "sema.h"
+#include "types.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace tinycsharp
+{
+    namespace
+    {
+        // the part of the runtime the program's tables refer to.
+        const char *const kRuntimeTypes = R"c(
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__)
+#define TC_NORETURN __attribute__((noreturn))
+#else
+#define TC_NORETURN
+#endif
+
+/* IrType and the object kinds the interpreter uses */
+enum { TC_VOID, TC_BOOL, TC_CHAR, TC_I32, TC_I64, TC_F32, TC_F64, TC_REF };
+enum { TC_INSTANCE, TC_ARRAY, TC_STRING, TC_BOX, TC_EXTERNAL };
+
+/* an object header; slots, elements or bytes follow it */
+typedef struct tc_obj
+{
+    uint8_t kind;
+    uint8_t type;
+    uint32_t info;
+} tc_obj;
+typedef union tc_value
+{
+    int64_t i;
+    double d;
+    float f;
+    tc_obj *r;
+} tc_value;
+#define TC_SLOTS(o) ((tc_value *)((o) + 1))
+#define TC_TEXT(o) ((char *)((o) + 1))
+
+typedef void (*tc_code)(void);
+typedef struct tc_class
+{
+    const char *name;
+    int32_t base;
+    uint32_t slots;
+    const tc_code *vtable;
+} tc_class;
+typedef struct tc_frame
+{
+    const char *name;
+    int line;
+    struct tc_frame *up;
+} tc_frame;
+)c";
+
+        // the rest of the runtime, after the class table it reads.
+        const char *const kRuntime = R"c(
+static tc_frame *tc_top;
+static long tc_depth;
+static char *tc_heap_next;
+static char *tc_heap_end;
+static tc_obj *tc_empty;
+static tc_obj *tc_chars[256];
+
+static const char tc_null_reference[] = "System.NullReferenceException";
+static const char tc_null_reference_message[] = "Object reference not set to an instance of an object.";
+static const char tc_index_out_of_range[] = "System.IndexOutOfRangeException";
+static const char tc_index_out_of_range_message[] = "Index was outside the bounds of the array.";
+static const char tc_overflow[] = "System.OverflowException";
+static const char tc_overflow_message[] = "Arithmetic operation resulted in an overflow.";
+static const char tc_invalid_cast[] = "System.InvalidCastException";
+
+/* prints an unhandled exception the way the interpreter does and exits */
+static TC_NORETURN void tc_unhandled(const char *type, const char *message, size_t length)
+{
+    tc_frame *f;
+    int shown = 0;
+    fflush(stdout);
+    fprintf(stderr, "Unhandled exception. %s: ", type);
+    fwrite(message, 1, length, stderr);
+    for (f = tc_top; f && shown < 32; f = f->up, shown++)
+        fprintf(stderr, "\n   at %s:line %d", f->name, f->line);
+    fputc('\n', stderr);
+    exit(1);
+}
+static TC_NORETURN void tc_fault(const char *type, const char *message)
+{
+    tc_unhandled(type, message, strlen(message));
+}
+
+static void tc_enter(tc_frame *frame, const char *name)
+{
+    if (++tc_depth > 100000)
+        tc_fault("System.StackOverflowException", "Operation caused a stack overflow.");
+    frame->name = name;
+    frame->line = 0;
+    frame->up = tc_top;
+    tc_top = frame;
+}
+#define TC_LEAVE() (tc_top = frame.up, tc_depth--)
+
+/* objects are bump allocated, zeroed, and never freed */
+static void *tc_alloc(size_t bytes)
+{
+    char *p;
+    bytes = (bytes + 7) & ~(size_t)7;
+    if (bytes > (size_t)(tc_heap_end - tc_heap_next))
+    {
+        size_t chunk = bytes > ((size_t)1 << 20) ? bytes : (size_t)1 << 20;
+        tc_heap_next = (char *)calloc(1, chunk);
+        if (!tc_heap_next)
+            tc_fault("System.OutOfMemoryException", "Insufficient memory to continue the execution of the program.");
+        tc_heap_end = tc_heap_next + chunk;
+    }
+    p = tc_heap_next;
+    tc_heap_next += bytes;
+    return p;
+}
+
+static tc_obj *tc_new_string(const char *text, size_t length)
+{
+    tc_obj *s = (tc_obj *)tc_alloc(sizeof(tc_obj) + length + 1);
+    s->kind = TC_STRING;
+    s->info = (uint32_t)length;
+    memcpy(TC_TEXT(s), text, length);
+    return s;
+}
+static tc_obj *tc_new_instance(uint32_t cls)
+{
+    tc_obj *o = (tc_obj *)tc_alloc(sizeof(tc_obj) + sizeof(tc_value) * tc_classes[cls].slots);
+    o->kind = TC_INSTANCE;
+    o->info = cls;
+    return o;
+}
+static tc_obj *tc_new_array(int type, int64_t length)
+{
+    tc_obj *a;
+    if (length < 0)
+        tc_fault(tc_overflow, tc_overflow_message);
+    a = (tc_obj *)tc_alloc(sizeof(tc_obj) + sizeof(tc_value) * (size_t)length);
+    a->kind = TC_ARRAY;
+    a->type = (uint8_t)type;
+    a->info = (uint32_t)length;
+    return a;
+}
+static tc_obj *tc_box(int type, tc_value v)
+{
+    tc_obj *b = (tc_obj *)tc_alloc(sizeof(tc_obj) + sizeof(tc_value));
+    b->kind = TC_BOX;
+    b->type = (uint8_t)type;
+    TC_SLOTS(b)[0] = v;
+    return b;
+}
+static tc_value tc_int_value(int64_t i)
+{
+    tc_value v;
+    v.i = i;
+    return v;
+}
+static tc_value tc_f32_value(float f)
+{
+    tc_value v;
+    v.i = 0;
+    v.f = f;
+    return v;
+}
+static tc_value tc_f64_value(double d)
+{
+    tc_value v;
+    v.d = d;
+    return v;
+}
+static double tc_f64(uint64_t bits)
+{
+    double d;
+    memcpy(&d, &bits, sizeof d);
+    return d;
+}
+static float tc_f32(uint32_t bits)
+{
+    float f;
+    memcpy(&f, &bits, sizeof f);
+    return f;
+}
+
+static tc_obj *tc_null_check(tc_obj *o)
+{
+    if (!o)
+        tc_fault(tc_null_reference, tc_null_reference_message);
+    return o;
+}
+static tc_value *tc_element(tc_obj *a, int64_t index)
+{
+    tc_null_check(a);
+    if ((uint64_t)index >= a->info)
+        tc_fault(tc_index_out_of_range, tc_index_out_of_range_message);
+    return TC_SLOTS(a) + index;
+}
+static int32_t tc_char_at(tc_obj *s, int64_t index)
+{
+    tc_null_check(s);
+    if ((uint64_t)index >= s->info)
+        tc_fault(tc_index_out_of_range, tc_index_out_of_range_message);
+    return (unsigned char)TC_TEXT(s)[index];
+}
+
+/* integer division traps like C#'s; everything else wraps */
+static TC_NORETURN void tc_divide_by_zero(void)
+{
+    tc_fault("System.DivideByZeroException", "Attempted to divide by zero.");
+}
+static int32_t tc_div_i32(int32_t x, int32_t y)
+{
+    if (y == 0)
+        tc_divide_by_zero();
+    if (y == -1 && x == INT32_MIN)
+        tc_fault(tc_overflow, tc_overflow_message);
+    return x / y;
+}
+static int32_t tc_rem_i32(int32_t x, int32_t y)
+{
+    if (y == 0)
+        tc_divide_by_zero();
+    if (y == -1 && x == INT32_MIN)
+        tc_fault(tc_overflow, tc_overflow_message);
+    return x % y;
+}
+static int64_t tc_div_i64(int64_t x, int64_t y)
+{
+    if (y == 0)
+        tc_divide_by_zero();
+    if (y == -1 && x == INT64_MIN)
+        tc_fault(tc_overflow, tc_overflow_message);
+    return x / y;
+}
+static int64_t tc_rem_i64(int64_t x, int64_t y)
+{
+    if (y == 0)
+        tc_divide_by_zero();
+    if (y == -1 && x == INT64_MIN)
+        tc_fault(tc_overflow, tc_overflow_message);
+    return x % y;
+}
+/* unchecked float to integer conversion saturates: NaN is 0 */
+static int64_t tc_saturate(double d, double lo, double hi, int64_t min, int64_t max)
+{
+    if (d != d)
+        return 0;
+    if (d <= lo)
+        return min;
+    if (d >= hi)
+        return max;
+    return (int64_t)d;
+}
+#define TC_SAT_I32(d) ((int32_t)tc_saturate((d), -2147483648.0, 2147483647.0, INT32_MIN, INT32_MAX))
+#define TC_SAT_I64(d) tc_saturate((d), -9223372036854775808.0, 9223372036854775807.0, INT64_MIN, INT64_MAX)
+#define TC_SAT_CHAR(d) ((int32_t)tc_saturate((d), 0.0, 65535.0, 0, 65535))
+
+static const char *tc_clr_type_name(int type)
+{
+    switch (type)
+    {
+    case TC_BOOL:
+        return "System.Boolean";
+    case TC_CHAR:
+        return "System.Char";
+    case TC_I32:
+        return "System.Int32";
+    case TC_I64:
+        return "System.Int64";
+    case TC_F32:
+        return "System.Single";
+    case TC_F64:
+        return "System.Double";
+    default:
+        return "System.Object";
+    }
+}
+/* the name of o's type, into buf */
+static const char *tc_type_name(const tc_obj *o, char *buf, size_t size)
+{
+    switch (o->kind)
+    {
+    case TC_INSTANCE:
+        return tc_classes[o->info].name;
+    case TC_ARRAY:
+        snprintf(buf, size, "%s[]", tc_clr_type_name(o->type));
+        return buf;
+    case TC_STRING:
+        return "System.String";
+    case TC_BOX:
+        return tc_clr_type_name(o->type);
+    default:
+    {
+        const tc_obj *name = TC_SLOTS((tc_obj *)o)[0].r;
+        if (!name)
+            return "System.Object";
+        snprintf(buf, size, "%.*s", (int)name->info, TC_TEXT((tc_obj *)name));
+        return buf;
+    }
+    }
+}
+static TC_NORETURN void tc_cast_fault(const tc_obj *o, const char *to)
+{
+    char name[256];
+    char message[768];
+    snprintf(message, sizeof message, "Unable to cast object of type '%s' to type '%s'.", tc_type_name(o, name, sizeof name), to);
+    tc_fault(tc_invalid_cast, message);
+}
+static tc_obj *tc_check_cast(tc_obj *o, int32_t cls)
+{
+    int32_t c;
+    if (!o)
+        return o;
+    if (o->kind == TC_INSTANCE)
+    {
+        for (c = (int32_t)o->info; c >= 0; c = tc_classes[c].base)
+        {
+            if (c == cls)
+                return o;
+        }
+    }
+    tc_cast_fault(o, tc_classes[cls].name);
+}
+static tc_value tc_unbox(tc_obj *o, int type)
+{
+    tc_null_check(o);
+    if (o->kind != TC_BOX || o->type != type)
+        tc_cast_fault(o, tc_clr_type_name(type));
+    return TC_SLOTS(o)[0];
+}
+static TC_NORETURN void tc_missing(const char *name)
+{
+    char message[512];
+    snprintf(message, sizeof message, "%s has no body.", name);
+    tc_fault("System.MissingMethodException", message);
+}
+static TC_NORETURN void tc_throw(tc_obj *e)
+{
+    char name[256];
+    char message[768];
+    const char *type;
+    tc_null_check(e);
+    type = tc_type_name(e, name, sizeof name);
+    if (e->kind == TC_EXTERNAL && TC_SLOTS(e)[1].r)
+    {
+        tc_obj *text = TC_SLOTS(e)[1].r;
+        tc_unhandled(type, TC_TEXT(text), text->info);
+    }
+    snprintf(message, sizeof message, "Exception of type '%s' was thrown.", type);
+    tc_fault(type, message);
+}
+
+/* C# prints the shortest digits that round trip, switching to exponent
+   notation outside [1e-4, 10^sci_limit) */
+static size_t tc_format_shortest(double value, int max_precision, int sci_limit, int is_float, char *out)
+{
+    char buf[64];
+    char digits[64];
+    size_t n = 0;
+    size_t count = 0;
+    int precision;
+    int exponent;
+    const char *e;
+    const char *p;
+    if (value != value)
+        return (size_t)sprintf(out, "NaN");
+    if (isinf(value))
+        return (size_t)sprintf(out, "%s\xe2\x88\x9e", value < 0 ? "-" : "");
+    if (value == 0)
+        return (size_t)sprintf(out, "%s", signbit(value) ? "-0" : "0");
+    for (precision = 1; precision <= max_precision; precision++)
+    {
+        double back;
+        snprintf(buf, sizeof buf, "%.*e", precision - 1, value);
+        back = strtod(buf, NULL);
+        if (is_float ? (float)back == (float)value : back == value)
+            break;
+    }
+    e = strchr(buf, 'e');
+    exponent = atoi(e + 1);
+    for (p = buf[0] == '-' ? buf + 1 : buf; p < e; p++)
+    {
+        if (*p != '.')
+            digits[count++] = *p;
+    }
+    while (count > 1 && digits[count - 1] == '0')
+        count--;
+    if (buf[0] == '-')
+        out[n++] = '-';
+    if (exponent >= sci_limit || exponent < -4)
+    {
+        out[n++] = digits[0];
+        if (count > 1)
+        {
+            out[n++] = '.';
+            memcpy(out + n, digits + 1, count - 1);
+            n += count - 1;
+        }
+        return n + (size_t)sprintf(out + n, "E%c%02d", exponent < 0 ? '-' : '+', exponent < 0 ? -exponent : exponent);
+    }
+    if (exponent < 0)
+    {
+        out[n++] = '0';
+        out[n++] = '.';
+        while (++exponent < 0)
+            out[n++] = '0';
+        memcpy(out + n, digits, count);
+        return n + count;
+    }
+    {
+        size_t int_digits = (size_t)exponent + 1;
+        size_t i;
+        for (i = 0; i < int_digits; i++)
+            out[n++] = i < count ? digits[i] : '0';
+        if (count > int_digits)
+        {
+            out[n++] = '.';
+            memcpy(out + n, digits + int_digits, count - int_digits);
+            n += count - int_digits;
+        }
+        return n;
+    }
+}
+static tc_obj *tc_format_value(tc_value v, int type)
+{
+    char buf[128];
+    size_t n;
+    switch (type)
+    {
+    case TC_BOOL:
+        return v.i ? tc_new_string("True", 4) : tc_new_string("False", 5);
+    case TC_CHAR:
+        if (!tc_chars[v.i & 0xff])
+        {
+            char c = (char)v.i;
+            tc_chars[v.i & 0xff] = tc_new_string(&c, 1);
+        }
+        return tc_chars[v.i & 0xff];
+    case TC_I32:
+    case TC_I64:
+        n = (size_t)sprintf(buf, "%" PRId64, v.i);
+        break;
+    case TC_F32:
+        n = tc_format_shortest(v.f, 9, 7, 1, buf);
+        break;
+    case TC_F64:
+        n = tc_format_shortest(v.d, 17, 15, 0, buf);
+        break;
+    default:
+        return tc_empty;
+    }
+    return tc_new_string(buf, n);
+}
+static tc_obj *tc_to_string(tc_obj *o)
+{
+    char buf[256];
+    const char *name;
+    if (!o)
+        return tc_empty;
+    if (o->kind == TC_STRING)
+        return o;
+    if (o->kind == TC_BOX)
+        return tc_format_value(TC_SLOTS(o)[0], o->type);
+    name = tc_type_name(o, buf, sizeof buf);
+    return tc_new_string(name, strlen(name));
+}
+static tc_obj *tc_concat(tc_obj *a, tc_obj *b)
+{
+    tc_obj *s;
+    if (!a || a->info == 0)
+        return b ? b : tc_empty;
+    if (!b || b->info == 0)
+        return a;
+    s = (tc_obj *)tc_alloc(sizeof(tc_obj) + (size_t)a->info + b->info + 1);
+    s->kind = TC_STRING;
+    s->info = a->info + b->info;
+    memcpy(TC_TEXT(s), TC_TEXT(a), a->info);
+    memcpy(TC_TEXT(s) + a->info, TC_TEXT(b), b->info);
+    return s;
+}
+static int32_t tc_str_eq(tc_obj *a, tc_obj *b)
+{
+    if (a == b || !a || !b || a->info != b->info)
+        return a == b;
+    return memcmp(TC_TEXT(a), TC_TEXT(b), a->info) == 0;
+}
+
+/* Console.Write and WriteLine; arguments after the first fill its {n} */
+static void tc_write(tc_obj *s)
+{
+    if (s)
+        fwrite(TC_TEXT(s), 1, s->info, stdout);
+}
+static void tc_console(tc_obj **args, uint32_t argc, int newline)
+{
+    if (argc == 1)
+        tc_write(args[0]);
+    else if (argc > 1)
+    {
+        const char *format = args[0] ? TC_TEXT(args[0]) : "";
+        size_t size = args[0] ? args[0]->info : 0;
+        size_t i;
+        for (i = 0; i < size; i++)
+        {
+            char c = format[i];
+            if ((c == '{' || c == '}') && i + 1 < size && format[i + 1] == c)
+            {
+                putchar(c);
+                i++;
+                continue;
+            }
+            if (c == '{')
+            {
+                size_t close = i + 1;
+                size_t index = 0;
+                while (close < size && format[close] != '}')
+                    close++;
+                if (close < size && close > i + 1)
+                {
+                    size_t j;
+                    int numeric = 1;
+                    for (j = i + 1; j < close && numeric; j++)
+                    {
+                        numeric = format[j] >= '0' && format[j] <= '9';
+                        index = index * 10 + (size_t)(format[j] - '0');
+                    }
+                    if (numeric && index + 1 < argc)
+                    {
+                        tc_write(args[index + 1]);
+                        i = close;
+                        continue;
+                    }
+                }
+            }
+            putchar(c);
+        }
+    }
+    if (newline)
+        putchar('\n');
+}
+/* a library member the compiler cannot see: only exception constructors
+   are useful, keeping their type name and message for throw */
+static tc_obj *tc_library(tc_obj **args, uint32_t argc)
+{
+    char message[512];
+    tc_obj *name = argc > 0 ? args[0] : NULL;
+    tc_obj *o;
+    if (!name || name->info < 4 || memcmp(TC_TEXT(name), "new ", 4) != 0)
+    {
+        snprintf(message, sizeof message, "Method not found: '%.*s'.", name ? (int)name->info : 1, name ? TC_TEXT(name) : "?");
+        tc_fault("System.MissingMethodException", message);
+    }
+    o = (tc_obj *)tc_alloc(sizeof(tc_obj) + 2 * sizeof(tc_value));
+    o->kind = TC_EXTERNAL;
+    if (memchr(TC_TEXT(name) + 4, '.', name->info - 4))
+        TC_SLOTS(o)[0].r = tc_new_string(TC_TEXT(name) + 4, name->info - 4);
+    else
+    {
+        int n = snprintf(message, sizeof message, "System.%.*s", (int)name->info - 4, TC_TEXT(name) + 4);
+        TC_SLOTS(o)[0].r = tc_new_string(message, (size_t)n);
+    }
+    if (argc > 1 && args[1] && args[1]->kind == TC_STRING)
+        TC_SLOTS(o)[1].r = args[1];
+    return o;
+}
+static int64_t tc_abs(int64_t v, int64_t min)
+{
+    if (v == min)
+        tc_fault(tc_overflow, "Negating the minimum value of a twos complement number is invalid.");
+    return v < 0 ? -v : v;
+}
+)c";
+
+        const char *CType(IrType type)
+        {
+            switch (type)
+            {
+            case IrType::kVoid:
+                return "void";
+            case IrType::kI64:
+                return "int64_t";
+            case IrType::kF32:
+                return "float";
+            case IrType::kF64:
+                return "double";
+            case IrType::kRef:
+                return "tc_obj *";
+            default:
+                return "int32_t"; // bool, char, int
+            }
+        }
+
+        // a typed read of the tc_value lvalue slot, and a write to it.
+        std::string Read(IrType type, const std::string &slot)
+        {
+            switch (type)
+            {
+            case IrType::kI64:
+                return slot + ".i";
+            case IrType::kF32:
+                return slot + ".f";
+            case IrType::kF64:
+                return slot + ".d";
+            case IrType::kRef:
+                return slot + ".r";
+            default:
+                return "(int32_t)" + slot + ".i";
+            }
+        }
+        std::string Write(IrType type, const std::string &slot, const std::string &value)
+        {
+            switch (type)
+            {
+            case IrType::kF32:
+                return slot + ".f = " + value + ";";
+            case IrType::kF64:
+                return slot + ".d = " + value + ";";
+            case IrType::kRef:
+                return slot + ".r = " + value + ";";
+            default:
+                return slot + ".i = " + value + ";";
+            }
+        }
+
+        // a C string literal; everything but plain printable characters is
+        // escaped in octal, which also rules out trigraphs.
+        std::string Quote(std::string_view text)
+        {
+            std::string out = "\"";
+            for (unsigned char c : text)
+            {
+                if (c >= 0x20 && c < 0x7f && c != '"' && c != '\\' && c != '?')
+                {
+                    out += static_cast<char>(c);
+                    continue;
+                }
+                char escape[8];
+                std::snprintf(escape, sizeof escape, "\\%03o", c);
+                out += escape;
+            }
+            return out + "\"";
+        }
+
+        std::string FunctionName(std::uint32_t id) { return "tc_fn_" + std::to_string(id); }
+
+        // the program's string literals, one runtime object each.
+        class Literals
+        {
+        public:
+            std::uint32_t Intern(std::string_view text)
+            {
+                auto [it, inserted] = ids_.emplace(std::string(text), static_cast<std::uint32_t>(texts_.size()));
+                if (inserted)
+                    texts_.emplace_back(text);
+                return it->second;
+            }
+            const std::vector<std::string> &texts() const { return texts_; }
+
+        private:
+            std::unordered_map<std::string, std::uint32_t> ids_;
+            std::vector<std::string> texts_;
+        };
+
+        bool IsTaskBuiltin(Builtin builtin)
+        {
+            return builtin == Builtin::kTaskFromResult || builtin == Builtin::kTaskYield || builtin == Builtin::kTaskDelay ||
+                   builtin == Builtin::kTaskCompleted;
+        }
+
+        // the C prototype of a function of the given types.
+        std::string Prototype(const std::string &name, IrType return_type, const std::vector<IrType> &params)
+        {
+            std::string out = std::string("static ") + CType(return_type) + " " + name + "(";
+            for (std::size_t i = 0; i < params.size(); i++)
+                out += (i ? ", " : "") + std::string(CType(params[i])) + " p" + std::to_string(i);
+            return out + (params.empty() ? "void)" : ")");
+        }
+
+        // one function as C. SSA values become locals; a phi is assigned
+        // from its own input variable at the top of its block, which every
+        // incoming edge sets first, so the copies of one edge act in
+        // parallel.
+        class CFunctionEmitter
+        {
+        public:
+            CFunctionEmitter(const IrFunction &fn, std::uint32_t id, const IrModule &module, Literals &literals, std::ostream &out)
+                : fn_(fn), id_(id), module_(module), literals_(literals), out_(out)
+            {
+            }
+
+            void Emit()
+            {
+                out_ << "/* " << fn_.name << " */\n"
+                     << Prototype(FunctionName(id_), fn_.return_type, fn_.param_types) << "\n{\n"
+                     << "    tc_frame frame;\n";
+                for (ValueId v = 0; v < fn_.NumInsts(); v++)
+                {
+                    const IrInst &inst = fn_.Inst(v);
+                    if (inst.op == IrOp::kNop || inst.type == IrType::kVoid || IsTerminator(inst.op))
+                        continue;
+                    out_ << "    " << CType(inst.type) << " " << V(v) << ";\n";
+                    if (inst.op == IrOp::kPhi)
+                        out_ << "    " << CType(inst.type) << " " << V(v) << "_in;\n";
+                }
+                out_ << "    tc_enter(&frame, " << Quote(fn_.name) << ");\n";
+                for (BlockId b = 0; b < fn_.NumBlocks(); b++)
+                    EmitBlock(b);
+                out_ << "}\n\n";
+            }
+
+        private:
+            static std::string V(ValueId v) { return "v" + std::to_string(v); }
+            std::string Operand(ValueId v) const { return V(v); }
+
+            void Line(const char *text) { out_ << "    " << text << "\n"; }
+            void Statement(const std::string &text) { out_ << "    " << text << "\n"; }
+
+            static bool CanFault(IrOp op)
+            {
+                switch (op)
+                {
+                case IrOp::kDiv:
+                case IrOp::kRem:
+                case IrOp::kConvert:
+                case IrOp::kLoadField:
+                case IrOp::kStoreField:
+                case IrOp::kNewObject:
+                case IrOp::kNewArray:
+                case IrOp::kLoadElem:
+                case IrOp::kStoreElem:
+                case IrOp::kArrayLength:
+                case IrOp::kStringLength:
+                case IrOp::kCharAt:
+                case IrOp::kCheckCast:
+                case IrOp::kThrow:
+                    return true;
+                default:
+                    return IsCall(op);
+                }
+            }
+
+            void EmitBlock(BlockId b)
+            {
+                const IrBlock &block = fn_.Block(b);
+                out_ << "b" << b << ":;\n";
+                int line = -1;
+                for (ValueId v = block.begin; v < block.end; v++)
+                {
+                    const IrInst &inst = fn_.Inst(v);
+                    if (inst.op == IrOp::kPhi)
+                    {
+                        Statement(V(v) + " = " + V(v) + "_in;");
+                        continue;
+                    }
+                    if (CanFault(inst.op) && fn_.Line(v) != line)
+                    {
+                        line = fn_.Line(v);
+                        Statement("frame.line = " + std::to_string(line) + ";");
+                    }
+                    EmitInst(v, b);
+                }
+            }
+
+            // the phi inputs of to for the edge from from, then the jump.
+            void EmitEdge(BlockId from, BlockId to, const char *indent)
+            {
+                IrSpan<BlockId> preds = fn_.Preds(to);
+                std::uint32_t index = 0;
+                while (index < preds.size() && preds[index] != from)
+                    index++;
+                for (ValueId v = fn_.Block(to).begin; fn_.Inst(v).op == IrOp::kPhi; v++)
+                {
+                    IrSpan<ValueId> ops = fn_.Operands(fn_.Inst(v));
+                    if (index < ops.size() && ops[index] != kNoValue)
+                        out_ << indent << V(v) << "_in = " << V(ops[index]) << ";\n";
+                }
+                out_ << indent << "goto b" << to << ";\n";
+            }
+
+            void Assign(ValueId v, const std::string &value) { Statement(V(v) + " = " + value + ";"); }
+
+            std::string Constant(const IrInst &inst)
+            {
+                char buf[64];
+                switch (inst.type)
+                {
+                case IrType::kRef:
+                    if (inst.aux == 1)
+                        return "tc_lit[" + std::to_string(literals_.Intern(fn_.String(inst.a))) + "]";
+                    return "0";
+                case IrType::kF32:
+                {
+                    float f = static_cast<float>(inst.FloatImm());
+                    std::uint32_t bits;
+                    std::memcpy(&bits, &f, sizeof bits);
+                    std::snprintf(buf, sizeof buf, "tc_f32(0x%08xu)", bits);
+                    return buf;
+                }
+                case IrType::kF64:
+                    std::snprintf(buf, sizeof buf, "tc_f64(UINT64_C(0x%016llx))", static_cast<unsigned long long>(inst.Imm()));
+                    return buf;
+                case IrType::kI64:
+                    if (inst.Imm() == INT64_MIN)
+                        return "INT64_MIN";
+                    return "INT64_C(" + std::to_string(inst.Imm()) + ")";
+                default:
+                {
+                    std::int32_t i = static_cast<std::int32_t>(inst.Imm());
+                    return i == INT32_MIN ? "INT32_MIN" : std::to_string(i);
+                }
+                }
+            }
+
+            std::string Arith(const IrInst &inst, const char *op)
+            {
+                std::string a = Operand(inst.a);
+                std::string b = Operand(inst.b);
+                if (inst.type == IrType::kI64)
+                    return "(int64_t)((uint64_t)" + a + " " + op + " (uint64_t)" + b + ")";
+                if (IsFloatIrType(inst.type))
+                    return a + " " + op + " " + b;
+                return "(int32_t)((uint32_t)" + a + " " + op + " (uint32_t)" + b + ")";
+            }
+
+            std::string Convert(IrType from, IrType to, const std::string &a)
+            {
+                if (from == to)
+                    return a;
+                if (to == IrType::kRef)
+                {
+                    switch (from)
+                    {
+                    case IrType::kF32:
+                        return "tc_box(TC_F32, tc_f32_value(" + a + "))";
+                    case IrType::kF64:
+                        return "tc_box(TC_F64, tc_f64_value(" + a + "))";
+                    default:
+                        return "tc_box(" + std::to_string(static_cast<int>(from)) + ", tc_int_value(" + a + "))";
+                    }
+                }
+                if (from == IrType::kRef)
+                    return Read(to, "tc_unbox(" + a + ", " + std::to_string(static_cast<int>(to)) + ")");
+                if (IsFloatIrType(from))
+                {
+                    std::string d = from == IrType::kF32 ? "(double)" + a : a;
+                    switch (to)
+                    {
+                    case IrType::kF32:
+                        return "(float)" + d;
+                    case IrType::kF64:
+                        return d;
+                    case IrType::kI64:
+                        return "TC_SAT_I64(" + d + ")";
+                    case IrType::kI32:
+                        return "TC_SAT_I32(" + d + ")";
+                    case IrType::kChar:
+                        return "TC_SAT_CHAR(" + d + ")";
+                    default:
+                        return "(int32_t)(" + d + " != 0)";
+                    }
+                }
+                switch (to)
+                {
+                case IrType::kF32:
+                    return "(float)(int64_t)" + a;
+                case IrType::kF64:
+                    return "(double)(int64_t)" + a;
+                case IrType::kI32:
+                    return "(int32_t)(uint32_t)" + a;
+                case IrType::kChar:
+                    return "(int32_t)(" + a + " & 0xffff)";
+                case IrType::kBool:
+                    return "(int32_t)(" + a + " != 0)";
+                default:
+                    return "(int64_t)" + a;
+                }
+            }
+
+            std::string Arguments(IrSpan<ValueId> args)
+            {
+                std::string out;
+                for (std::size_t i = 0; i < args.size(); i++)
+                    out += (i ? ", " : "") + Operand(args[i]);
+                return out;
+            }
+
+            void Call(ValueId v, const IrInst &inst, const std::string &callee, const std::string &args)
+            {
+                std::string call = callee + "(" + args + ");";
+                Statement(inst.type == IrType::kVoid ? call : V(v) + " = " + call);
+            }
+
+            void EmitBuiltin(ValueId v, const IrInst &inst)
+            {
+                IrSpan<ValueId> args = fn_.Operands(inst);
+                Builtin builtin = static_cast<Builtin>(inst.c);
+                auto arg = [&](std::size_t i) { return Operand(args[i]); };
+                switch (builtin)
+                {
+                case Builtin::kConsoleWrite:
+                case Builtin::kConsoleWriteLine:
+                case Builtin::kNone:
+                {
+                    std::string array = "0";
+                    if (!args.empty())
+                    {
+                        std::string list;
+                        for (std::size_t i = 0; i < args.size(); i++)
+                            list += (i ? ", " : "") + (fn_.Inst(args[i]).type == IrType::kRef ? arg(i) : std::string("0"));
+                        Statement("{");
+                        Statement("    tc_obj *args[] = {" + list + "};");
+                        array = "args";
+                    }
+                    std::string count = std::to_string(args.size());
+                    if (builtin == Builtin::kNone)
+                        Statement((args.empty() ? "" : "    ") + (inst.type == IrType::kVoid ? std::string() : V(v) + " = ") +
+                                  "tc_library(" + array + ", " + count + ");");
+                    else
+                        Statement((args.empty() ? "" : "    ") + std::string("tc_console(") + array + ", " + count + ", " +
+                                  (builtin == Builtin::kConsoleWriteLine ? "1" : "0") + ");");
+                    if (!args.empty())
+                        Statement("}");
+                    return;
+                }
+                case Builtin::kMathAbs:
+                    switch (inst.type)
+                    {
+                    case IrType::kI32:
+                        return Assign(v, "(int32_t)tc_abs(" + arg(0) + ", INT32_MIN)");
+                    case IrType::kI64:
+                        return Assign(v, "tc_abs(" + arg(0) + ", INT64_MIN)");
+                    case IrType::kF32:
+                        return Assign(v, "fabsf(" + arg(0) + ")");
+                    default:
+                        return Assign(v, "fabs(" + arg(0) + ")");
+                    }
+                case Builtin::kMathMax:
+                case Builtin::kMathMin:
+                {
+                    bool max = builtin == Builtin::kMathMax;
+                    std::string a = arg(0);
+                    std::string b = arg(1);
+                    if (IsFloatIrType(inst.type))
+                    {
+                        bool f32 = inst.type == IrType::kF32;
+                        std::string fn = std::string(max ? "fmax" : "fmin") + (f32 ? "f" : "");
+                        return Assign(v, "(" + a + " != " + a + " || " + b + " != " + b + ") ? " + (f32 ? "(float)NAN" : "NAN") +
+                                             " : " + fn + "(" + a + ", " + b + ")");
+                    }
+                    return Assign(v, a + (max ? " > " : " < ") + b + " ? " + a + " : " + b);
+                }
+                case Builtin::kMathSqrt:
+                    return Assign(v, "sqrt(" + arg(0) + ")");
+                default:
+                    Statement(std::string("tc_fault(\"System.NotSupportedException\", ") +
+                              Quote(std::string(BuiltinToString(builtin)) + " is not supported.") + ");");
+                    return;
+                }
+            }
+
+            void EmitInst(ValueId v, BlockId b)
+            {
+                const IrInst &inst = fn_.Inst(v);
+                switch (inst.op)
+                {
+                case IrOp::kNop:
+                case IrOp::kPhi:
+                    return;
+                case IrOp::kConst:
+                    return Assign(v, Constant(inst));
+                case IrOp::kParam:
+                    return Assign(v, "p" + std::to_string(inst.a));
+                case IrOp::kAdd:
+                    return Assign(v, Arith(inst, "+"));
+                case IrOp::kSub:
+                    return Assign(v, Arith(inst, "-"));
+                case IrOp::kMul:
+                    return Assign(v, Arith(inst, "*"));
+                case IrOp::kDiv:
+                case IrOp::kRem:
+                {
+                    bool div = inst.op == IrOp::kDiv;
+                    std::string a = Operand(inst.a);
+                    std::string b = Operand(inst.b);
+                    if (inst.type == IrType::kF32)
+                        return Assign(v, div ? a + " / " + b : "fmodf(" + a + ", " + b + ")");
+                    if (inst.type == IrType::kF64)
+                        return Assign(v, div ? a + " / " + b : "fmod(" + a + ", " + b + ")");
+                    std::string helper = std::string(div ? "tc_div_" : "tc_rem_") + (inst.type == IrType::kI64 ? "i64" : "i32");
+                    return Assign(v, helper + "(" + a + ", " + b + ")");
+                }
+                case IrOp::kAnd:
+                    return Assign(v, Operand(inst.a) + " & " + Operand(inst.b));
+                case IrOp::kOr:
+                    return Assign(v, Operand(inst.a) + " | " + Operand(inst.b));
+                case IrOp::kXor:
+                    return Assign(v, Operand(inst.a) + " ^ " + Operand(inst.b));
+                case IrOp::kShl:
+                    if (inst.type == IrType::kI32)
+                        return Assign(v, "(int32_t)((uint32_t)" + Operand(inst.a) + " << (" + Operand(inst.b) + " & 31))");
+                    return Assign(v, "(int64_t)((uint64_t)" + Operand(inst.a) + " << (" + Operand(inst.b) + " & 63))");
+                case IrOp::kShr:
+                    return Assign(v, Operand(inst.a) + " >> (" + Operand(inst.b) + (inst.type == IrType::kI32 ? " & 31)" : " & 63)"));
+                case IrOp::kNeg:
+                    if (inst.type == IrType::kI64)
+                        return Assign(v, "(int64_t)(0u - (uint64_t)" + Operand(inst.a) + ")");
+                    if (IsFloatIrType(inst.type))
+                        return Assign(v, "-" + Operand(inst.a));
+                    return Assign(v, "(int32_t)(0u - (uint32_t)" + Operand(inst.a) + ")");
+                case IrOp::kNot:
+                    return Assign(v, inst.type == IrType::kBool ? Operand(inst.a) + " ^ 1" : "~" + Operand(inst.a));
+                case IrOp::kEq:
+                    return Assign(v, Operand(inst.a) + " == " + Operand(inst.b));
+                case IrOp::kNe:
+                    return Assign(v, Operand(inst.a) + " != " + Operand(inst.b));
+                case IrOp::kLt:
+                    return Assign(v, Operand(inst.a) + " < " + Operand(inst.b));
+                case IrOp::kLe:
+                    return Assign(v, Operand(inst.a) + " <= " + Operand(inst.b));
+                case IrOp::kGt:
+                    return Assign(v, Operand(inst.a) + " > " + Operand(inst.b));
+                case IrOp::kGe:
+                    return Assign(v, Operand(inst.a) + " >= " + Operand(inst.b));
+                case IrOp::kConvert:
+                    return Assign(v, Convert(static_cast<IrType>(inst.aux), inst.type, Operand(inst.a)));
+                case IrOp::kStrEq:
+                    return Assign(v, "tc_str_eq(" + Operand(inst.a) + ", " + Operand(inst.b) + ")");
+                case IrOp::kConcat:
+                    return Assign(v, "tc_concat(" + Operand(inst.a) + ", " + Operand(inst.b) + ")");
+                case IrOp::kToString:
+                {
+                    IrType from = static_cast<IrType>(inst.aux);
+                    if (from == IrType::kRef)
+                        return Assign(v, "tc_to_string(" + Operand(inst.a) + ")");
+                    std::string value = from == IrType::kF32   ? "tc_f32_value(" + Operand(inst.a) + ")"
+                                        : from == IrType::kF64 ? "tc_f64_value(" + Operand(inst.a) + ")"
+                                                               : "tc_int_value(" + Operand(inst.a) + ")";
+                    return Assign(v, "tc_format_value(" + value + ", " + std::to_string(static_cast<int>(from)) + ")");
+                }
+                case IrOp::kLoadField:
+                    return Assign(v, Read(inst.type, "TC_SLOTS(tc_null_check(" + Operand(inst.a) + "))[" + std::to_string(inst.c) + "]"));
+                case IrOp::kStoreField:
+                    return Statement(Write(fn_.Inst(inst.b).type, "TC_SLOTS(tc_null_check(" + Operand(inst.a) + "))[" + std::to_string(inst.c) + "]",
+                                           Operand(inst.b)));
+                case IrOp::kLoadStatic:
+                    return Assign(v, Read(inst.type, "tc_statics[" + std::to_string(inst.c) + "]"));
+                case IrOp::kStoreStatic:
+                    return Statement(Write(fn_.Inst(inst.b).type, "tc_statics[" + std::to_string(inst.c) + "]", Operand(inst.b)));
+                case IrOp::kNewObject:
+                    return Assign(v, "tc_new_instance(" + std::to_string(inst.c) + ")");
+                case IrOp::kNewArray:
+                    return Assign(v, "tc_new_array(" + std::to_string(inst.aux) + ", " + Operand(inst.a) + ")");
+                case IrOp::kLoadElem:
+                    return Assign(v, Read(inst.type, "tc_element(" + Operand(inst.a) + ", " + Operand(inst.b) + ")[0]"));
+                case IrOp::kStoreElem:
+                    return Statement(Write(fn_.Inst(inst.c).type, "tc_element(" + Operand(inst.a) + ", " + Operand(inst.b) + ")[0]",
+                                           Operand(inst.c)));
+                case IrOp::kArrayLength:
+                case IrOp::kStringLength:
+                    return Assign(v, "(int32_t)tc_null_check(" + Operand(inst.a) + ")->info");
+                case IrOp::kCharAt:
+                    return Assign(v, "tc_char_at(" + Operand(inst.a) + ", " + Operand(inst.b) + ")");
+                case IrOp::kCheckCast:
+                    return Assign(v, "tc_check_cast(" + Operand(inst.a) + ", " + std::to_string(inst.c) + ")");
+                case IrOp::kCall:
+                    return Call(v, inst, FunctionName(inst.c), Arguments(fn_.Operands(inst)));
+                case IrOp::kCallVirtual:
+                {
+                    IrSpan<ValueId> args = fn_.Operands(inst);
+                    std::vector<IrType> types;
+                    for (ValueId arg : args)
+                        types.push_back(fn_.Inst(arg).type);
+                    std::string pointer = std::string("(") + CType(inst.type) + " (*)(";
+                    for (std::size_t i = 0; i < types.size(); i++)
+                        pointer += (i ? ", " : "") + std::string(CType(types[i]));
+                    pointer += "))";
+                    int slot = module_.globals->methods()[inst.c]->vtable_slot;
+                    std::string callee = "(" + pointer + "tc_classes[tc_null_check(" + Operand(args[0]) + ")->info].vtable[" +
+                                         std::to_string(slot) + "])";
+                    return Call(v, inst, callee, Arguments(args));
+                }
+                case IrOp::kCallBuiltin:
+                    return EmitBuiltin(v, inst);
+                case IrOp::kCallInit:
+                    return Statement(FunctionName(static_cast<std::uint32_t>(module_.instance_init[inst.c])) + "(" + Operand(inst.a) + ");");
+                case IrOp::kJump:
+                    return EmitEdge(b, inst.a, "    ");
+                case IrOp::kBranch:
+                    Statement("if (" + Operand(inst.a) + ")");
+                    Line("{");
+                    EmitEdge(b, inst.b, "        ");
+                    Line("}");
+                    return EmitEdge(b, inst.c, "    ");
+                case IrOp::kReturn:
+                    Line("TC_LEAVE();");
+                    if (inst.a == kNoValue)
+                        return Line("return;");
+                    return Statement("return " + Operand(inst.a) + ";");
+                case IrOp::kThrow:
+                    return Statement("tc_throw(" + Operand(inst.a) + ");");
+                default:
+                    throw std::runtime_error(fn_.name + ": " + IrOpToString(inst.op) + " is not supported by the C backend");
+                }
+            }
+
+            const IrFunction &fn_;
+            std::uint32_t id_;
+            const IrModule &module_;
+            Literals &literals_;
+            std::ostream &out_;
+        };
+
+        // the async machinery lives in the interpreter's scheduler.
+        void CheckSupported(const IrFunction &fn)
+        {
+            bool async = fn.method && fn.method->is_async;
+            for (ValueId v = 0; v < fn.NumInsts() && !async; v++)
+            {
+                const IrInst &inst = fn.Inst(v);
+                async = inst.op == IrOp::kAwait || (inst.op == IrOp::kCallBuiltin && IsTaskBuiltin(static_cast<Builtin>(inst.c)));
+            }
+            if (async)
+                throw std::runtime_error(fn.name + ": async methods are not supported by the C backend");
+        }
+    }
+
+    void EmitC(std::ostream &out, const IrModule &module)
+    {
+        if (module.entry < 0)
+            throw std::runtime_error("program has no static Main method");
+        const GlobalSymbols &globals = *module.globals;
+        std::size_t count = module.functions.size();
+        out << "/* generated by tinycsharp; C99 */" << kRuntimeTypes << "\n";
+
+        // every method has a C function; those without a body fault when
+        // called, like the interpreter's.
+        std::vector<std::string> missing(count);
+        for (std::uint32_t i = 0; i < count; i++)
+        {
+            if (const IrFunction *fn = module.functions[i].get())
+            {
+                CheckSupported(*fn);
+                out << Prototype(FunctionName(i), fn->return_type, fn->param_types) << ";\n";
+                continue;
+            }
+            if (i >= globals.methods().size())
+                continue;
+            const MethodInfo *method = globals.methods()[i];
+            std::vector<IrType> params;
+            if (!method->is_static)
+                params.push_back(IrType::kRef);
+            for (const Type *type : method->param_types)
+                params.push_back(IrTypeOf(type));
+            IrType return_type = method->return_type ? IrTypeOf(method->return_type) : IrType::kVoid;
+            missing[i] = Prototype(FunctionName(i), return_type, params);
+            out << missing[i] << ";\n";
+        }
+
+        out << "\n";
+        for (const ClassInfo *cls : globals.classes())
+        {
+            if (cls->vtable.empty())
+                continue;
+            out << "static const tc_code tc_vtable" << cls->id << "[] = {";
+            for (std::size_t i = 0; i < cls->vtable.size(); i++)
+                out << (i ? ", " : "") << "(tc_code)" << FunctionName(cls->vtable[i]->id);
+            out << "};\n";
+        }
+        std::vector<const ClassInfo *> classes(globals.classes().size());
+        for (const ClassInfo *cls : globals.classes())
+            classes[cls->id] = cls;
+        out << "static const tc_class tc_classes[] = {\n";
+        for (const ClassInfo *cls : classes)
+        {
+            out << "    {" << Quote(cls->qualified_name) << ", " << (cls->base ? static_cast<std::int64_t>(cls->base->id) : -1) << ", "
+                << cls->instance_slots << ", " << (cls->vtable.empty() ? "0" : "tc_vtable" + std::to_string(cls->id)) << "},\n";
+        }
+        if (classes.empty())
+            out << "    {\"\", -1, 0, 0},\n";
+        out << "};\n"
+            << "static tc_value tc_statics[" << std::max<std::uint32_t>(module.num_static_slots, 1) << "];\n";
+
+        Literals literals;
+        std::ostringstream functions;
+        for (std::uint32_t i = 0; i < count; i++)
+        {
+            if (const IrFunction *fn = module.functions[i].get())
+                CFunctionEmitter(*fn, i, module, literals, functions).Emit();
+            else if (!missing[i].empty())
+                functions << missing[i] << "\n{\n    tc_missing(" << Quote(MethodSignature(globals.methods()[i])) << ");\n}\n\n";
+        }
+
+        out << "static tc_obj *tc_lit[" << std::max<std::size_t>(literals.texts().size(), 1) << "];\n" << kRuntime << "\n";
+        out << "static void tc_init(void)\n{\n    tc_empty = tc_new_string(\"\", 0);\n";
+        for (std::size_t i = 0; i < literals.texts().size(); i++)
+            out << "    tc_lit[" << i << "] = tc_new_string(" << Quote(literals.texts()[i]) << ", " << literals.texts()[i].size() << ");\n";
+        out << "}\n\n" << functions.str();
+
+        const IrFunction &main = *module.functions[static_cast<std::size_t>(module.entry)];
+        out << "int main(void)\n{\n    tc_init();\n";
+        if (module.static_init >= 0)
+            out << "    " << FunctionName(static_cast<std::uint32_t>(module.static_init)) << "();\n";
+        std::string call = FunctionName(static_cast<std::uint32_t>(module.entry)) + "(" +
+                           (main.param_types.size() == 1 ? "tc_new_array(TC_REF, 0)" : "") + ")";
+        if (main.return_type == IrType::kI32)
+            out << "    {\n        int status = " << call << ";\n        fflush(stdout);\n        return status;\n    }\n";
+        else
+            out << "    " << call << ";\n    fflush(stdout);\n    return 0;\n";
+        out << "}\n";
+    }
+
+    void CompileNative(const IrModule &module, const std::string &output, const CBackendOptions &options)
+    {
+        std::string source = output + ".c";
+        {
+            std::ofstream file(source, std::ios::binary | std::ios::trunc);
+            if (!file)
+                throw std::runtime_error("cannot write " + source);
+            EmitC(file, module);
+            if (!file.flush())
+                throw std::runtime_error("cannot write " + source);
+        }
+        std::string compiler = options.compiler;
+        if (compiler.empty())
+        {
+            const char *cc = std::getenv("CC");
+            compiler = cc && *cc ? cc : "cc";
+        }
+        auto quote = [](const std::string &s)
+        {
+            std::string out = "'";
+            for (char c : s)
+                out += c == '\'' ? std::string("'\\''") : std::string(1, c);
+            return out + "'";
+        };
+        std::string command = compiler + " -std=c99 " + options.flags + " -o " + quote(output) + " " + quote(source) + " -lm";
+        int status = std::system(command.c_str());
+        if (!options.keep_source)
+            std::remove(source.c_str());
+        if (status != 0)
+            throw std::runtime_error("C compiler failed: " + command);
+    }
+
+}
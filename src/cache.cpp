@@ -0,0 +1,1084 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+
+#include "cache.h"
+#include "lexer.h"
+#include "parser.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+#include <unistd.h>
+
+namespace tinycsharp
+{
+    namespace
+    {
+        constexpr char kEntryMagic[4] = {'T', 'C', 'S', 'C'};
+        constexpr std::uint8_t kEntryFormat = 1;
+        constexpr std::size_t kEntryHeaderSize = sizeof(kEntryMagic) + 2 + 8 + 8;
+        constexpr std::uint8_t kTokenFormat = 3;
+        constexpr std::uint8_t kAstFormat = 1;
+        constexpr char kDumpMagic[4] = {'T', 'C', 'S', 'T'};
+
+        constexpr std::uint64_t kMul0 = 0x9E3779B97F4A7C15ull;
+        constexpr std::uint64_t kMul1 = 0xC2B2AE3D27D4EB4Full;
+
+        std::uint64_t Mix(std::uint64_t h)
+        {
+            h ^= h >> 33;
+            h *= kMul1;
+            h ^= h >> 29;
+            h *= kMul0;
+            h ^= h >> 32;
+            return h;
+        }
+
+        void PutU64(std::string &out, std::uint64_t v)
+        {
+            for (int i = 0; i < 8; i++)
+            {
+                out += static_cast<char>((v >> (i * 8)) & 0xff);
+            }
+        }
+        std::uint64_t GetU64(const char *p)
+        {
+            std::uint64_t v = 0;
+            for (int i = 0; i < 8; i++)
+            {
+                v |= static_cast<std::uint64_t>(static_cast<unsigned char>(p[i])) << (i * 8);
+            }
+            return v;
+        }
+
+        void PutVarint(std::string &out, std::uint64_t v)
+        {
+            while (v >= 0x80)
+            {
+                out += static_cast<char>((v & 0x7f) | 0x80);
+                v >>= 7;
+            }
+            out += static_cast<char>(v);
+        }
+
+        struct Reader
+        {
+            std::string_view data;
+            std::size_t pos = 0;
+            const char *what = "token stream";
+
+            void Need(std::size_t n) const
+            {
+                if (data.size() - pos < n)
+                {
+                    throw std::runtime_error(std::string("Truncated ") + what);
+                }
+            }
+            std::uint8_t Byte()
+            {
+                Need(1);
+                return static_cast<std::uint8_t>(data[pos++]);
+            }
+            std::uint64_t Varint()
+            {
+                std::uint64_t v = 0;
+                for (int shift = 0; shift < 64; shift += 7)
+                {
+                    std::uint8_t b = Byte();
+                    v |= static_cast<std::uint64_t>(b & 0x7f) << shift;
+                    if (!(b & 0x80))
+                    {
+                        return v;
+                    }
+                }
+                throw std::runtime_error(std::string("Malformed varint in ") + what);
+            }
+            std::string_view Bytes(std::size_t n)
+            {
+                Need(n);
+                std::string_view v = data.substr(pos, n);
+                pos += n;
+                return v;
+            }
+        };
+
+        std::uint64_t ZigZag(std::int64_t v)
+        {
+            return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+        }
+        std::int64_t UnZigZag(std::uint64_t v)
+        {
+            return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+        }
+
+        bool ParseEntryName(const std::string &name, std::uint64_t &hash, CachePhase &phase)
+        {
+            auto dot = name.find('.');
+            if (dot != 16 || name.find(".tmp") != std::string::npos)
+            {
+                return false;
+            }
+            std::string suffix = name.substr(dot + 1);
+            if (suffix == "tokens")
+                phase = CachePhase::kTokens;
+            else if (suffix == "ast")
+                phase = CachePhase::kAst;
+            else
+                return false;
+            try
+            {
+                hash = std::stoull(name.substr(0, dot), nullptr, 16);
+            }
+            catch (const std::exception &)
+            {
+                return false;
+            }
+            return true;
+        }
+    }
+
+    const char *CachePhaseToString(CachePhase phase)
+    {
+        switch (phase)
+        {
+        case CachePhase::kTokens:
+            return "tokens";
+        case CachePhase::kAst:
+            return "ast";
+        default:
+            return "unknown";
+        }
+    }
+
+    std::uint64_t HashBytes(std::string_view data, std::uint64_t seed)
+    {
+        std::uint64_t h = seed ^ (data.size() * kMul0);
+        const char *p = data.data();
+        std::size_t n = data.size();
+        while (n >= 8)
+        {
+            std::uint64_t w;
+            std::memcpy(&w, p, 8);
+            h = (h ^ Mix(w)) * kMul1;
+            h = (h << 27) | (h >> 37);
+            p += 8;
+            n -= 8;
+        }
+        std::uint64_t tail = 0;
+        std::memcpy(&tail, p, n);
+        h ^= Mix(tail ^ (static_cast<std::uint64_t>(n) << 56));
+        return Mix(h);
+    }
+
+    std::string CacheKey::FileName() const
+    {
+        static const char kHex[] = "0123456789abcdef";
+        std::string name(16, '0');
+        for (int i = 0; i < 16; i++)
+        {
+            name[15 - i] = kHex[(hash >> (i * 4)) & 0xf];
+        }
+        return name + "." + CachePhaseToString(phase);
+    }
+
+    CompilationCache::CompilationCache(std::filesystem::path dir, std::uint64_t max_bytes)
+        : dir_(std::move(dir)), max_bytes_(max_bytes)
+    {
+        if (dir_.empty())
+        {
+            throw std::invalid_argument("Cache directory cannot be empty");
+        }
+        seed_ = HashBytes(TINYCSHARP_VERSION);
+        std::filesystem::create_directories(dir_);
+        LoadIndex();
+    }
+
+    CacheKey CompilationCache::KeyFor(std::string_view contents, CachePhase phase) const
+    {
+        return CacheKey{HashBytes(contents, seed_ + static_cast<std::uint64_t>(phase)), phase};
+    }
+
+    void CompilationCache::LoadIndex()
+    {
+        // rebuild recency from modification times; hits touch the file so the
+        // order survives across compiler runs.
+        struct Found
+        {
+            std::string name;
+            std::uint64_t size;
+            std::filesystem::file_time_type mtime;
+        };
+        std::vector<Found> found;
+        for (const auto &de : std::filesystem::directory_iterator(dir_))
+        {
+            if (!de.is_regular_file())
+            {
+                continue;
+            }
+            std::string name = de.path().filename().string();
+            std::uint64_t hash;
+            CachePhase phase;
+            if (!ParseEntryName(name, hash, phase))
+            {
+                continue;
+            }
+            found.push_back({name, static_cast<std::uint64_t>(de.file_size()), de.last_write_time()});
+        }
+        std::sort(found.begin(), found.end(), [](const Found &a, const Found &b)
+                  { return a.mtime < b.mtime; });
+        for (const auto &f : found)
+        {
+            index_[f.name] = Entry{f.size, ++clock_};
+            total_bytes_ += f.size;
+        }
+        EvictLocked();
+    }
+
+    std::optional<std::string> CompilationCache::Lookup(const CacheKey &key)
+    {
+        std::string name = key.FileName();
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            if (!index_.count(name))
+            {
+                stats_.misses++;
+                return std::nullopt;
+            }
+        }
+
+        // the file is read and checked unlocked; entries are immutable once
+        // renamed into place, so a concurrent Store of the same key writes
+        // the same bytes, and one evicted meanwhile reads as missing.
+        std::filesystem::path path = dir_ / name;
+        std::ifstream in(path, std::ios::binary);
+        std::string raw((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        bool valid = in.good() || in.eof();
+        valid = valid && raw.size() >= kEntryHeaderSize + 8 &&
+                std::memcmp(raw.data(), kEntryMagic, sizeof(kEntryMagic)) == 0 &&
+                static_cast<std::uint8_t>(raw[4]) == kEntryFormat &&
+                static_cast<std::uint8_t>(raw[5]) == static_cast<std::uint8_t>(key.phase) &&
+                GetU64(raw.data() + 6) == key.hash &&
+                GetU64(raw.data() + 14) == raw.size() - kEntryHeaderSize - 8;
+        std::string_view payload;
+        if (valid)
+        {
+            payload = std::string_view(raw).substr(kEntryHeaderSize, raw.size() - kEntryHeaderSize - 8);
+            valid = GetU64(raw.data() + raw.size() - 8) == HashBytes(payload);
+        }
+        if (!valid)
+        {
+            // deleted behind our back or corrupted on disk: drop it and recompile.
+            std::lock_guard<std::mutex> lock(mu_);
+            RemoveLocked(name);
+            stats_.misses++;
+            return std::nullopt;
+        }
+
+        std::error_code ec;
+        std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+        std::lock_guard<std::mutex> lock(mu_);
+        auto it = index_.find(name);
+        if (it != index_.end())
+        {
+            it->second.last_use = ++clock_;
+        }
+        stats_.hits++;
+        return std::string(payload);
+    }
+
+    void CompilationCache::Store(const CacheKey &key, std::string_view blob)
+    {
+        static std::atomic<std::uint64_t> tmp_counter{0};
+
+        std::string raw;
+        raw.reserve(kEntryHeaderSize + blob.size() + 8);
+        raw.append(kEntryMagic, sizeof(kEntryMagic));
+        raw += static_cast<char>(kEntryFormat);
+        raw += static_cast<char>(key.phase);
+        PutU64(raw, key.hash);
+        PutU64(raw, blob.size());
+        raw.append(blob.data(), blob.size());
+        PutU64(raw, HashBytes(blob));
+
+        std::string name = key.FileName();
+        std::ostringstream tmp_name;
+        tmp_name << name << ".tmp" << ::getpid() << "." << tmp_counter++;
+        std::filesystem::path tmp = dir_ / tmp_name.str();
+        // the cache only ever saves work: a full disk, a read-only or
+        // vanished directory leaves the entry unwritten and the compile goes on.
+        bool written;
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            out.write(raw.data(), static_cast<std::streamsize>(raw.size()));
+            out.flush();
+            written = static_cast<bool>(out);
+        }
+        std::error_code ec;
+        if (written)
+        {
+            std::filesystem::rename(tmp, dir_ / name, ec);
+        }
+        if (!written || ec)
+        {
+            std::filesystem::remove(tmp, ec);
+            std::lock_guard<std::mutex> lock(mu_);
+            stats_.failed_stores++;
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mu_);
+        auto it = index_.find(name);
+        if (it != index_.end())
+        {
+            total_bytes_ -= it->second.size;
+        }
+        index_[name] = Entry{raw.size(), ++clock_};
+        total_bytes_ += raw.size();
+        stats_.stores++;
+        EvictLocked();
+    }
+
+    void CompilationCache::EvictLocked()
+    {
+        if (total_bytes_ <= max_bytes_)
+        {
+            return;
+        }
+        std::vector<std::pair<std::uint64_t, std::string>> by_age;
+        by_age.reserve(index_.size());
+        for (const auto &kv : index_)
+        {
+            by_age.emplace_back(kv.second.last_use, kv.first);
+        }
+        std::sort(by_age.begin(), by_age.end());
+        for (const auto &victim : by_age)
+        {
+            if (total_bytes_ <= max_bytes_)
+            {
+                break;
+            }
+            RemoveLocked(victim.second);
+            stats_.evictions++;
+        }
+    }
+
+    void CompilationCache::RemoveLocked(const std::string &name)
+    {
+        auto it = index_.find(name);
+        if (it == index_.end())
+        {
+            return;
+        }
+        total_bytes_ -= it->second.size;
+        index_.erase(it);
+        std::error_code ec;
+        std::filesystem::remove(dir_ / name, ec);
+    }
+
+    CacheStats CompilationCache::Stats() const
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        return stats_;
+    }
+    std::uint64_t CompilationCache::SizeInBytes() const
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        return total_bytes_;
+    }
+    std::size_t CompilationCache::EntryCount() const
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        return index_.size();
+    }
+
+    // layout: format byte, token count, then per token
+    //   kind, flags, offset, lexeme, value
+    // flags: 1 = int_val, 2 = float_val, 4 = the lexeme is that of the last
+    // token of the same kind and is left out. offset is the difference from
+    // the previous token's.
+    std::string EncodeTokens(const std::vector<Token> &tokens, SourceLocation base)
+    {
+        constexpr std::size_t kKinds = static_cast<std::size_t>(TokenKind::kTError) + 1;
+        std::string out;
+        out += static_cast<char>(kTokenFormat);
+        PutVarint(out, tokens.size());
+        std::vector<const std::string *> last(kKinds, nullptr);
+        std::int64_t offset = 0;
+        for (const auto &tok : tokens)
+        {
+            const std::string *&previous = last[static_cast<std::size_t>(tok.kind)];
+            bool repeat = previous && *previous == tok.lexeme;
+            std::uint8_t flags = (tok.int_val ? 1 : 0) | (tok.float_val ? 2 : 0) | (repeat ? 4 : 0);
+            out += static_cast<char>(tok.kind);
+            out += static_cast<char>(flags);
+            std::int64_t at = static_cast<std::int64_t>(tok.loc.offset) - base.offset;
+            PutVarint(out, ZigZag(at - offset));
+            offset = at;
+            if (!repeat)
+            {
+                PutVarint(out, tok.lexeme.size());
+                out += tok.lexeme;
+                previous = &tok.lexeme;
+            }
+            if (tok.int_val)
+            {
+                PutVarint(out, ZigZag(*tok.int_val));
+            }
+            if (tok.float_val)
+            {
+                std::uint64_t bits;
+                std::memcpy(&bits, tok.float_val.get(), sizeof(bits));
+                PutU64(out, bits);
+            }
+        }
+        return out;
+    }
+
+    std::vector<Token> DecodeTokens(std::string_view blob, SourceLocation base)
+    {
+        constexpr std::size_t kKinds = static_cast<std::size_t>(TokenKind::kTError) + 1;
+        Reader r{blob};
+        if (r.Byte() != kTokenFormat)
+        {
+            throw std::runtime_error("Unsupported token stream format");
+        }
+        std::uint64_t count = r.Varint();
+        std::vector<Token> tokens;
+        tokens.reserve(std::min<std::uint64_t>(count, blob.size()));
+        std::vector<std::string_view> last(kKinds);
+        std::int64_t offset = 0;
+        for (std::uint64_t i = 0; i < count; i++)
+        {
+            std::uint8_t kind = r.Byte();
+            if (kind >= kKinds)
+            {
+                throw std::runtime_error("Unknown token kind in token stream");
+            }
+            std::uint8_t flags = r.Byte();
+            offset += UnZigZag(r.Varint());
+            if (!(flags & 4))
+            {
+                last[kind] = r.Bytes(r.Varint());
+            }
+            Token tok{static_cast<TokenKind>(kind), std::string(last[kind])};
+            tok.loc = base + static_cast<long>(offset);
+            if (flags & 1)
+            {
+                tok.int_val = std::make_shared<std::int64_t>(UnZigZag(r.Varint()));
+            }
+            if (flags & 2)
+            {
+                std::uint64_t bits = GetU64(r.Bytes(8).data());
+                double d;
+                std::memcpy(&d, &bits, sizeof(d));
+                tok.float_val = std::make_shared<double>(d);
+            }
+            tokens.push_back(std::move(tok));
+        }
+        return tokens;
+    }
+
+    namespace
+    {
+        // the fields of each node kind after its kind and location, in the
+        // order AstWriter writes them and AstReader reads them back; both
+        // run these same functions. the back pointers (owner, outer, ns,
+        // unit) are left to AstReader::Adopt.
+        template <typename Io>
+        void Transfer(Io &io, CompilationUnit *n)
+        {
+            io.List(n->usings);
+            io.List(n->members);
+        }
+        template <typename Io>
+        void Transfer(Io &io, UsingDirective *n) { io.Name(n->name, n->name_id); }
+        template <typename Io>
+        void Transfer(Io &io, NamespaceDecl *n)
+        {
+            io.Name(n->name, n->name_id);
+            io.List(n->usings);
+            io.List(n->members);
+        }
+        template <typename Io>
+        void Transfer(Io &io, ClassDecl *n)
+        {
+            io.Name(n->name, n->name_id);
+            io.Enum(n->modifiers, ~Modifiers{0});
+            io.Enum(n->is_struct, true);
+            io.List(n->bases);
+            io.List(n->members);
+        }
+        template <typename Io>
+        void Transfer(Io &io, FieldDecl *n)
+        {
+            io.Name(n->name, n->name_id);
+            io.Enum(n->modifiers, ~Modifiers{0});
+            io.Enum(n->is_property, true);
+            io.Child(n->type);
+            io.Child(n->init);
+        }
+        template <typename Io>
+        void Transfer(Io &io, MethodDecl *n)
+        {
+            io.Name(n->name, n->name_id);
+            io.Enum(n->modifiers, ~Modifiers{0});
+            io.Enum(n->is_ctor, true);
+            io.Child(n->return_type);
+            io.List(n->params);
+            io.Child(n->body);
+        }
+        template <typename Io>
+        void Transfer(Io &io, ParamDecl *n)
+        {
+            io.Name(n->name, n->name_id);
+            io.Child(n->type);
+            io.Enum(n->index, ~std::uint32_t{0});
+        }
+        template <typename Io>
+        void Transfer(Io &io, TypeRef *n)
+        {
+            io.Name(n->name, n->name_id);
+            io.List(n->args);
+            io.Enum(n->array_rank, std::uint8_t{0xff});
+        }
+        template <typename Io>
+        void Transfer(Io &io, BlockStmt *n) { io.List(n->stmts); }
+        template <typename Io>
+        void Transfer(Io &io, LocalVarStmt *n)
+        {
+            io.Name(n->name, n->name_id);
+            io.Enum(n->is_const, true);
+            io.Child(n->type);
+            io.Child(n->init);
+        }
+        template <typename Io>
+        void Transfer(Io &io, ExprStmt *n) { io.Child(n->expr); }
+        template <typename Io>
+        void Transfer(Io &io, IfStmt *n)
+        {
+            io.Child(n->cond);
+            io.Child(n->then_stmt);
+            io.Child(n->else_stmt);
+        }
+        template <typename Io>
+        void Transfer(Io &io, WhileStmt *n)
+        {
+            io.Child(n->cond);
+            io.Child(n->body);
+        }
+        template <typename Io>
+        void Transfer(Io &io, DoWhileStmt *n)
+        {
+            io.Child(n->body);
+            io.Child(n->cond);
+        }
+        template <typename Io>
+        void Transfer(Io &io, ReturnStmt *n) { io.Child(n->value); }
+        template <typename Io>
+        void Transfer(Io &, BreakStmt *) {}
+        template <typename Io>
+        void Transfer(Io &, ContinueStmt *) {}
+        template <typename Io>
+        void Transfer(Io &io, ThrowStmt *n) { io.Child(n->value); }
+        template <typename Io>
+        void Transfer(Io &io, LiteralExpr *n)
+        {
+            io.Enum(n->literal_kind, LiteralKind::kBool);
+            switch (n->literal_kind)
+            {
+            case LiteralKind::kInt:
+                io.Int(n->int_value);
+                break;
+            case LiteralKind::kFloat:
+                io.Float(n->float_value);
+                break;
+            case LiteralKind::kString:
+                io.Text(n->string_value);
+                break;
+            case LiteralKind::kBool:
+                io.Enum(n->bool_value, true);
+                break;
+            }
+        }
+        template <typename Io>
+        void Transfer(Io &io, NameExpr *n) { io.Name(n->name, n->name_id); }
+        template <typename Io>
+        void Transfer(Io &io, MemberExpr *n)
+        {
+            io.Child(n->object);
+            io.Name(n->name, n->name_id);
+        }
+        template <typename Io>
+        void Transfer(Io &io, CallExpr *n)
+        {
+            io.Child(n->callee);
+            io.List(n->args);
+        }
+        template <typename Io>
+        void Transfer(Io &io, IndexExpr *n)
+        {
+            io.Child(n->object);
+            io.Child(n->index);
+        }
+        template <typename Io>
+        void Transfer(Io &io, UnaryExpr *n)
+        {
+            io.Enum(n->op, TokenKind::kTError);
+            io.Enum(n->postfix, true);
+            io.Child(n->operand);
+        }
+        template <typename Io>
+        void Transfer(Io &io, BinaryExpr *n)
+        {
+            io.Enum(n->op, TokenKind::kTError);
+            io.Child(n->lhs);
+            io.Child(n->rhs);
+        }
+        template <typename Io>
+        void Transfer(Io &io, AssignExpr *n)
+        {
+            io.Enum(n->op, TokenKind::kTError);
+            io.Child(n->target);
+            io.Child(n->value);
+        }
+        template <typename Io>
+        void Transfer(Io &io, ConditionalExpr *n)
+        {
+            io.Child(n->cond);
+            io.Child(n->then_expr);
+            io.Child(n->else_expr);
+        }
+        template <typename Io>
+        void Transfer(Io &io, CastExpr *n)
+        {
+            io.Child(n->type);
+            io.Child(n->operand);
+        }
+        template <typename Io>
+        void Transfer(Io &io, NewExpr *n)
+        {
+            io.Child(n->type);
+            io.List(n->args);
+        }
+        template <typename Io>
+        void Transfer(Io &, ThisExpr *) {}
+        template <typename Io>
+        void Transfer(Io &io, AwaitExpr *n) { io.Child(n->operand); }
+
+        // a node slot holds one of three tags: none, a node written earlier
+        // (by its index in tree order), or a new node.
+        constexpr char kNoNode = 0;
+        constexpr char kSeenNode = 1;
+        constexpr char kNewNode = 2;
+
+        class AstWriter
+        {
+        public:
+            explicit AstWriter(SourceLocation base) : base_(base) {}
+
+            std::string Write(const CompilationUnit &unit)
+            {
+                out_ += static_cast<char>(kAstFormat);
+                Location(unit.loc);
+                // Transfer only reads through a writer.
+                Transfer(*this, const_cast<CompilationUnit *>(&unit));
+                return std::move(out_);
+            }
+
+            template <typename T>
+            void Child(T *node)
+            {
+                if (!node)
+                {
+                    out_ += kNoNode;
+                    return;
+                }
+                auto [it, fresh] = seen_.emplace(node, seen_.size());
+                if (!fresh)
+                {
+                    out_ += kSeenNode;
+                    PutVarint(out_, it->second);
+                    return;
+                }
+                out_ += kNewNode;
+                out_ += static_cast<char>(node->kind);
+                Location(node->loc);
+                switch (node->kind)
+                {
+#define TINYCSHARP_WRITE_NODE(Name)                   \
+    case NodeKind::k##Name:                           \
+        Transfer(*this, static_cast<Name *>(static_cast<Node *>(node))); \
+        break;
+                    TINYCSHARP_AST_NODES(TINYCSHARP_WRITE_NODE)
+#undef TINYCSHARP_WRITE_NODE
+                }
+            }
+            template <typename T>
+            void List(const NodeList<T> &list)
+            {
+                PutVarint(out_, list.size());
+                for (T *node : list)
+                    Child(node);
+            }
+            void Name(std::string_view name, SymbolId)
+            {
+                Text(name);
+            }
+            void Text(std::string_view text)
+            {
+                PutVarint(out_, text.size());
+                out_.append(text.data(), text.size());
+            }
+            template <typename E>
+            void Enum(E value, E)
+            {
+                PutVarint(out_, static_cast<std::uint64_t>(value));
+            }
+            void Int(std::int64_t value) { PutVarint(out_, ZigZag(value)); }
+            void Float(double value)
+            {
+                std::uint64_t bits;
+                std::memcpy(&bits, &value, sizeof(bits));
+                PutU64(out_, bits);
+            }
+
+        private:
+            // offsets are written as the difference from the previous node's.
+            void Location(SourceLocation loc)
+            {
+                std::int64_t at = static_cast<std::int64_t>(loc.offset) - base_.offset;
+                PutVarint(out_, ZigZag(at - offset_));
+                offset_ = at;
+            }
+
+            SourceLocation base_;
+            std::int64_t offset_ = 0;
+            std::string out_;
+            std::unordered_map<const Node *, std::uint64_t> seen_;
+        };
+
+        class AstReader
+        {
+        public:
+            AstReader(std::string_view blob, AstContext &ctx, SourceLocation base)
+                : r_{blob, 0, "syntax tree"}, ctx_(ctx), base_(base)
+            {
+            }
+
+            CompilationUnit *Read(std::string_view file)
+            {
+                if (r_.Byte() != kAstFormat)
+                {
+                    throw std::runtime_error("Unsupported syntax tree format");
+                }
+                SourceLocation loc = Location();
+                unit_ = ctx_.Make<CompilationUnit>(loc);
+                unit_->file = file;
+                unit_->sources = &ctx_.sources();
+                Transfer(*this, unit_);
+                if (r_.pos != r_.data.size())
+                {
+                    throw std::runtime_error("Trailing bytes after syntax tree");
+                }
+                Adopt(unit_->members, nullptr, nullptr);
+                ctx_.units.push_back(unit_);
+                return unit_;
+            }
+
+            template <typename T>
+            void Child(T *&slot)
+            {
+                Node *node = Next();
+                if (node && !Fits<T>(node))
+                {
+                    Malformed();
+                }
+                slot = static_cast<T *>(node);
+            }
+            template <typename T>
+            void List(NodeList<T> &list)
+            {
+                std::uint64_t count = r_.Varint();
+                // every slot takes at least a byte.
+                r_.Need(count);
+                std::vector<T *> items(count);
+                for (T *&item : items)
+                {
+                    Child(item);
+                    if (!item)
+                        Malformed();
+                }
+                list = ctx_.MakeList(items);
+            }
+            void Name(std::string_view &name, SymbolId &id)
+            {
+                name = ctx_.Intern(r_.Bytes(r_.Varint()));
+                id = ctx_.Symbol(name);
+            }
+            void Text(std::string_view &text)
+            {
+                text = ctx_.CopyString(r_.Bytes(r_.Varint()));
+            }
+            template <typename E>
+            void Enum(E &value, E last)
+            {
+                std::uint64_t v = r_.Varint();
+                if (v > static_cast<std::uint64_t>(last))
+                {
+                    Malformed();
+                }
+                value = static_cast<E>(v);
+            }
+            void Int(std::int64_t &value) { value = UnZigZag(r_.Varint()); }
+            void Float(double &value)
+            {
+                std::uint64_t bits = GetU64(r_.Bytes(8).data());
+                std::memcpy(&value, &bits, sizeof(value));
+            }
+
+        private:
+            template <typename T>
+            static bool Fits(const Node *node)
+            {
+                if constexpr (std::is_same_v<T, Node>)
+                    return node->kind != NodeKind::kCompilationUnit;
+                else if constexpr (std::is_same_v<T, Expr>)
+                    return node->kind >= NodeKind::kLiteralExpr;
+                else
+                    return node->kind == T::kKind;
+            }
+
+            [[noreturn]] static void Malformed()
+            {
+                throw std::runtime_error("Malformed syntax tree");
+            }
+
+            SourceLocation Location()
+            {
+                offset_ += UnZigZag(r_.Varint());
+                return base_ + static_cast<long>(offset_);
+            }
+
+            Node *Next()
+            {
+                char tag = static_cast<char>(r_.Byte());
+                if (tag == kNoNode)
+                {
+                    return nullptr;
+                }
+                if (tag == kSeenNode)
+                {
+                    std::uint64_t index = r_.Varint();
+                    if (index >= nodes_.size())
+                    {
+                        Malformed();
+                    }
+                    return nodes_[index];
+                }
+                if (tag != kNewNode)
+                {
+                    Malformed();
+                }
+                std::uint8_t kind = r_.Byte();
+                if (kind >= kNodeKindCount || static_cast<NodeKind>(kind) == NodeKind::kCompilationUnit)
+                {
+                    Malformed();
+                }
+                SourceLocation loc = Location();
+                switch (static_cast<NodeKind>(kind))
+                {
+#define TINYCSHARP_READ_NODE(Name)              \
+    case NodeKind::k##Name:                     \
+    {                                           \
+        auto *node = ctx_.Make<Name>(loc);      \
+        nodes_.push_back(node);                 \
+        Transfer(*this, node);                  \
+        return node;                            \
+    }
+                    TINYCSHARP_AST_NODES(TINYCSHARP_READ_NODE)
+#undef TINYCSHARP_READ_NODE
+                }
+                Malformed();
+            }
+
+            // points the declarations under a namespace (or the unit, with
+            // none) and class at them, as the parser does while parsing.
+            void Adopt(const NodeList<Node> &members, NamespaceDecl *ns, ClassDecl *owner)
+            {
+                for (Node *member : members)
+                {
+                    if (auto *cls = NodeCast<ClassDecl>(member))
+                    {
+                        cls->unit = unit_;
+                        cls->ns = ns;
+                        cls->outer = owner;
+                        Adopt(cls->members, ns, cls);
+                    }
+                    else if (auto *inner = NodeCast<NamespaceDecl>(member); inner && !owner)
+                    {
+                        inner->outer = ns;
+                        Adopt(inner->members, inner, nullptr);
+                    }
+                    else if (auto *field = NodeCast<FieldDecl>(member); field && owner)
+                    {
+                        field->owner = owner;
+                    }
+                    else if (auto *method = NodeCast<MethodDecl>(member); method && owner)
+                    {
+                        method->owner = owner;
+                    }
+                    else
+                    {
+                        Malformed();
+                    }
+                }
+            }
+
+            Reader r_;
+            AstContext &ctx_;
+            SourceLocation base_;
+            std::int64_t offset_ = 0;
+            CompilationUnit *unit_ = nullptr;
+            std::vector<Node *> nodes_;
+        };
+    }
+
+    std::string EncodeAst(const CompilationUnit &unit, SourceLocation base)
+    {
+        return AstWriter{base}.Write(unit);
+    }
+
+    CompilationUnit *DecodeAst(std::string_view blob, AstContext &ctx, std::string_view file, SourceLocation base)
+    {
+        return AstReader{blob, ctx, base}.Read(file);
+    }
+
+    // layout: magic, the file's size and line count, the line starts as
+    // differences, then the EncodeTokens() blob.
+    void WriteTokenDump(std::ostream &out, const SourceManager &sources, FileId file, const std::vector<Token> &tokens)
+    {
+        std::string blob;
+        PutVarint(blob, sources.Size(file));
+        const std::vector<std::uint32_t> &lines = sources.LineStarts(file);
+        PutVarint(blob, lines.size());
+        std::uint32_t previous = 0;
+        for (std::uint32_t start : lines)
+        {
+            PutVarint(blob, start - previous);
+            previous = start;
+        }
+        blob += EncodeTokens(tokens, sources.Begin(file));
+        out.write(kDumpMagic, sizeof(kDumpMagic));
+        out.write(blob.data(), static_cast<std::streamsize>(blob.size()));
+    }
+
+    bool IsTokenDump(std::string_view data)
+    {
+        return data.size() >= sizeof(kDumpMagic) && data.compare(0, sizeof(kDumpMagic), kDumpMagic, sizeof(kDumpMagic)) == 0;
+    }
+
+    std::vector<Token> ReadTokenDump(std::string_view data, SourceManager &sources, std::string name)
+    {
+        if (!IsTokenDump(data))
+        {
+            throw std::runtime_error("Not a token dump");
+        }
+        std::string_view body = data.substr(sizeof(kDumpMagic));
+        Reader r{body};
+        std::uint64_t size = r.Varint();
+        std::uint64_t count = r.Varint();
+        if (size >= UINT32_MAX || count == 0 || count > size + 1)
+        {
+            throw std::runtime_error("Bad line table in token dump");
+        }
+        std::vector<std::uint32_t> lines;
+        lines.reserve(count);
+        std::uint64_t start = 0;
+        for (std::uint64_t i = 0; i < count; i++)
+        {
+            start += r.Varint();
+            if (start > size)
+            {
+                throw std::runtime_error("Bad line table in token dump");
+            }
+            lines.push_back(static_cast<std::uint32_t>(start));
+        }
+        FileId file = sources.AddFile(std::move(name), static_cast<std::uint32_t>(size), std::move(lines));
+        return DecodeTokens(body.substr(r.pos), sources.Begin(file));
+    }
+
+    std::vector<Token> LexCached(CompilationCache &cache, const std::string &source, SourceLocation base)
+    {
+        CacheKey key = cache.KeyFor(source, CachePhase::kTokens);
+        if (auto blob = cache.Lookup(key))
+        {
+            try
+            {
+                return DecodeTokens(*blob, base);
+            }
+            catch (const std::runtime_error &)
+            {
+                // fall through and relex; the Store below replaces the bad entry.
+            }
+        }
+        Lexer lexer{source, base};
+        std::vector<Token> tokens = lexer.Tokenize();
+        cache.Store(key, EncodeTokens(tokens, base));
+        return tokens;
+    }
+
+    // a kAst entry is the token count of the source, then the EncodeAst() blob.
+    CompilationUnit *ParseCached(CompilationCache &cache, AstContext &ctx, const std::string &source, std::string_view file,
+                                 SourceLocation base, std::size_t *token_count)
+    {
+        CacheKey key = cache.KeyFor(source, CachePhase::kAst);
+        if (auto blob = cache.Lookup(key))
+        {
+            Reader r{*blob, 0, "syntax tree"};
+            try
+            {
+                std::uint64_t tokens = r.Varint();
+                CompilationUnit *unit = DecodeAst(std::string_view(*blob).substr(r.pos), ctx, file, base);
+                if (token_count)
+                    *token_count = static_cast<std::size_t>(tokens);
+                return unit;
+            }
+            catch (const std::runtime_error &)
+            {
+                // fall through and parse; the Store below replaces the bad entry.
+            }
+        }
+        Lexer lexer{source, base};
+        std::vector<Token> tokens = lexer.Tokenize();
+        std::size_t count = tokens.size();
+        Parser parser{ctx, std::move(tokens), file};
+        CompilationUnit *unit = parser.ParseCompilationUnit();
+        std::string blob;
+        PutVarint(blob, count);
+        blob += EncodeAst(*unit, base);
+        cache.Store(key, blob);
+        if (token_count)
+            *token_count = count;
+        return unit;
+    }
+
+}
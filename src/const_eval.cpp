@@ -0,0 +1,661 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include "const_eval.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+namespace tinycsharp
+{
+    namespace
+    {
+        bool IsConcrete(const Type *type)
+        {
+            return type && type->kind != TypeKind::kError && type->kind != TypeKind::kExternal;
+        }
+
+        bool IsFloating(const Type *type)
+        {
+            return type->kind == TypeKind::kFloat || type->kind == TypeKind::kDouble;
+        }
+
+        double AsDouble(const ConstValue *v)
+        {
+            return IsFloating(v->type) ? v->float_value : static_cast<double>(v->int_value);
+        }
+
+        // inclusive range of an integral type.
+        void IntegralRange(const Type *type, std::int64_t &lo, std::int64_t &hi)
+        {
+            switch (type->kind)
+            {
+            case TypeKind::kChar:
+                lo = 0;
+                hi = 0xffff;
+                break;
+            case TypeKind::kLong:
+                lo = std::numeric_limits<std::int64_t>::min();
+                hi = std::numeric_limits<std::int64_t>::max();
+                break;
+            default:
+                lo = std::numeric_limits<std::int32_t>::min();
+                hi = std::numeric_limits<std::int32_t>::max();
+                break;
+            }
+        }
+    }
+
+    std::string ConstValueToString(const ConstValue *v)
+    {
+        if (!v)
+        {
+            return "<none>";
+        }
+        switch (v->type->kind)
+        {
+        case TypeKind::kBool:
+            return v->int_value ? "true" : "false";
+        case TypeKind::kString:
+            return "\"" + std::string(v->string_value) + "\"";
+        case TypeKind::kFloat:
+        case TypeKind::kDouble:
+        {
+            std::ostringstream ss;
+            ss.precision(17);
+            ss << v->float_value;
+            return ss.str();
+        }
+        default:
+            return std::to_string(v->int_value);
+        }
+    }
+
+    const ConstValue *ConstantPool::Integral(const Type *type, std::int64_t value)
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        values_.push_back(ConstValue{type, value});
+        return &values_.back();
+    }
+
+    const ConstValue *ConstantPool::Floating(const Type *type, double value)
+    {
+        if (type->kind == TypeKind::kFloat)
+        {
+            value = static_cast<float>(value);
+        }
+        std::lock_guard<std::mutex> lock(mu_);
+        values_.push_back(ConstValue{type, 0, value});
+        return &values_.back();
+    }
+
+    const ConstValue *ConstantPool::String(std::string_view value)
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        strings_.emplace_back(value);
+        values_.push_back(ConstValue{types_.String(), 0, 0, strings_.back()});
+        return &values_.back();
+    }
+
+    std::size_t ConstantPool::Size() const
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        return values_.size();
+    }
+
+    ConstantFolder::ConstantFolder(const GlobalSymbols &globals, ConstantPool &pool, std::vector<Diagnostic> &diagnostics)
+        : globals_(globals), types_(globals.types()), pool_(pool), diagnostics_(diagnostics)
+    {
+    }
+
+    void ConstantFolder::FoldConstFields()
+    {
+        for (ClassInfo *cls : globals_.classes())
+        {
+            for (FieldInfo *field : cls->fields)
+            {
+                if (field->is_const)
+                {
+                    EvaluateField(field);
+                }
+            }
+        }
+        fields_done_ = true;
+    }
+
+    void ConstantFolder::FoldBody(const BodyTask &task)
+    {
+        fields_done_ = true;
+        unit_ = task.owner->decl->unit;
+        locals_.clear();
+        if (auto *field = NodeCast<FieldDecl>(task.member))
+        {
+            if (!field->info->is_const)
+            {
+                Fold(field->init);
+            }
+            return;
+        }
+        FoldStatement(static_cast<MethodDecl *>(task.member)->body);
+    }
+
+    const ConstValue *ConstantFolder::EvaluateField(FieldInfo *field)
+    {
+        // a referenced const has no initializer; its value came with it.
+        if (!field->is_const || fields_done_ || !field->decl->init)
+        {
+            return field->constant;
+        }
+        int &state = field_state_[field];
+        if (state == 2)
+        {
+            return field->constant;
+        }
+        std::string name = field->owner->qualified_name + "." + std::string(field->decl->name);
+        if (state == 1)
+        {
+            Error(field->decl, "The evaluation of the constant value for '" + name + "' involves a circular definition");
+            return nullptr;
+        }
+        state = 1;
+        const CompilationUnit *saved_unit = unit_;
+        unit_ = field->owner->decl->unit;
+        std::size_t reported = diagnostics_.size();
+        const ConstValue *value = Fold(field->decl->init);
+        if (value)
+        {
+            value = Convert(value, field->type, field->decl->init, false);
+        }
+        else if (field->decl->init && IsConcrete(field->decl->init->type) && diagnostics_.size() == reported)
+        {
+            Error(field->decl->init, "The expression being assigned to '" + name + "' must be constant");
+        }
+        field->constant = value;
+        unit_ = saved_unit;
+        field_state_[field] = 2;
+        return value;
+    }
+
+    void ConstantFolder::FoldStatement(Node *node)
+    {
+        if (!node)
+        {
+            return;
+        }
+        switch (node->kind)
+        {
+        case NodeKind::kBlockStmt:
+            for (Node *stmt : static_cast<BlockStmt *>(node)->stmts)
+            {
+                FoldStatement(stmt);
+            }
+            break;
+        case NodeKind::kLocalVarStmt:
+        {
+            auto *local = static_cast<LocalVarStmt *>(node);
+            std::size_t reported = diagnostics_.size();
+            const ConstValue *value = Fold(local->init);
+            if (!local->is_const)
+            {
+                break;
+            }
+            if (value)
+            {
+                locals_[local] = Convert(value, local->resolved_type, local->init, false);
+            }
+            else if (local->init && IsConcrete(local->init->type) && diagnostics_.size() == reported)
+            {
+                Error(local->init, "The expression being assigned to '" + std::string(local->name) + "' must be constant");
+            }
+            break;
+        }
+        case NodeKind::kExprStmt:
+            Fold(static_cast<ExprStmt *>(node)->expr);
+            break;
+        case NodeKind::kIfStmt:
+        {
+            auto *stmt = static_cast<IfStmt *>(node);
+            Fold(stmt->cond);
+            FoldStatement(stmt->then_stmt);
+            FoldStatement(stmt->else_stmt);
+            break;
+        }
+        case NodeKind::kWhileStmt:
+            Fold(static_cast<WhileStmt *>(node)->cond);
+            FoldStatement(static_cast<WhileStmt *>(node)->body);
+            break;
+        case NodeKind::kDoWhileStmt:
+            FoldStatement(static_cast<DoWhileStmt *>(node)->body);
+            Fold(static_cast<DoWhileStmt *>(node)->cond);
+            break;
+        case NodeKind::kReturnStmt:
+            Fold(static_cast<ReturnStmt *>(node)->value);
+            break;
+        case NodeKind::kThrowStmt:
+            Fold(static_cast<ThrowStmt *>(node)->value);
+            break;
+        default:
+            break;
+        }
+    }
+
+    const ConstValue *ConstantFolder::Fold(Expr *expr)
+    {
+        if (!expr)
+        {
+            return nullptr;
+        }
+        const ConstValue *value = nullptr;
+        switch (expr->kind)
+        {
+        case NodeKind::kLiteralExpr:
+        {
+            auto *lit = static_cast<LiteralExpr *>(expr);
+            if (!IsConcrete(expr->type))
+                break;
+            switch (lit->literal_kind)
+            {
+            case LiteralKind::kInt:
+                value = pool_.Integral(expr->type, lit->int_value);
+                break;
+            case LiteralKind::kFloat:
+                value = pool_.Floating(expr->type, lit->float_value);
+                break;
+            case LiteralKind::kString:
+                value = pool_.String(lit->string_value);
+                break;
+            case LiteralKind::kBool:
+                value = pool_.Bool(lit->bool_value);
+                break;
+            }
+            break;
+        }
+        case NodeKind::kNameExpr:
+        {
+            Node *decl = static_cast<NameExpr *>(expr)->decl;
+            if (auto *local = NodeCast<LocalVarStmt>(decl))
+            {
+                auto it = locals_.find(local);
+                value = it == locals_.end() ? nullptr : it->second;
+            }
+            else if (auto *field = NodeCast<FieldDecl>(decl))
+            {
+                value = field->info ? EvaluateField(field->info) : nullptr;
+            }
+            break;
+        }
+        case NodeKind::kMemberExpr:
+        {
+            auto *member = static_cast<MemberExpr *>(expr);
+            Fold(member->object);
+            if (member->field)
+            {
+                value = EvaluateField(member->field);
+                break;
+            }
+            switch (static_cast<Builtin>(member->builtin))
+            {
+            case Builtin::kIntMaxValue:
+                value = pool_.Integral(types_.Int(), std::numeric_limits<std::int32_t>::max());
+                break;
+            case Builtin::kIntMinValue:
+                value = pool_.Integral(types_.Int(), std::numeric_limits<std::int32_t>::min());
+                break;
+            case Builtin::kLongMaxValue:
+                value = pool_.Integral(types_.Long(), std::numeric_limits<std::int64_t>::max());
+                break;
+            case Builtin::kLongMinValue:
+                value = pool_.Integral(types_.Long(), std::numeric_limits<std::int64_t>::min());
+                break;
+            default:
+                break;
+            }
+            break;
+        }
+        case NodeKind::kUnaryExpr:
+            value = FoldUnary(static_cast<UnaryExpr *>(expr));
+            break;
+        case NodeKind::kBinaryExpr:
+            value = FoldBinary(static_cast<BinaryExpr *>(expr));
+            break;
+        case NodeKind::kCastExpr:
+            value = FoldCast(static_cast<CastExpr *>(expr));
+            break;
+        case NodeKind::kConditionalExpr:
+        {
+            auto *cond = static_cast<ConditionalExpr *>(expr);
+            const ConstValue *c = Fold(cond->cond);
+            const ConstValue *a = Fold(cond->then_expr);
+            const ConstValue *b = Fold(cond->else_expr);
+            if (c && a && b && IsConcrete(expr->type))
+            {
+                value = Convert(c->int_value ? a : b, expr->type, expr, false);
+            }
+            break;
+        }
+        default:
+            value = FoldChildren(expr);
+            break;
+        }
+        if (!IsConcrete(expr->type))
+        {
+            value = nullptr;
+        }
+        expr->constant = value;
+        return value;
+    }
+
+    const ConstValue *ConstantFolder::FoldChildren(Expr *expr)
+    {
+        switch (expr->kind)
+        {
+        case NodeKind::kCallExpr:
+        {
+            auto *call = static_cast<CallExpr *>(expr);
+            if (auto *member = NodeCast<MemberExpr>(call->callee))
+                Fold(member->object);
+            for (Expr *arg : call->args)
+                Fold(arg);
+            break;
+        }
+        case NodeKind::kIndexExpr:
+            Fold(static_cast<IndexExpr *>(expr)->object);
+            Fold(static_cast<IndexExpr *>(expr)->index);
+            break;
+        case NodeKind::kAssignExpr:
+            Fold(static_cast<AssignExpr *>(expr)->target);
+            Fold(static_cast<AssignExpr *>(expr)->value);
+            break;
+        case NodeKind::kNewExpr:
+            for (Expr *arg : static_cast<NewExpr *>(expr)->args)
+                Fold(arg);
+            break;
+        case NodeKind::kAwaitExpr:
+            Fold(static_cast<AwaitExpr *>(expr)->operand);
+            break;
+        default:
+            break;
+        }
+        return nullptr;
+    }
+
+    const ConstValue *ConstantFolder::FoldUnary(UnaryExpr *unary)
+    {
+        const ConstValue *v = Fold(unary->operand);
+        if (!v || !IsConcrete(unary->type))
+        {
+            return nullptr;
+        }
+        switch (unary->op)
+        {
+        case TokenKind::kTNot:
+            return pool_.Bool(!v->int_value);
+        case TokenKind::kTPlus:
+            return Convert(v, unary->type, unary, false);
+        case TokenKind::kTMinus:
+        {
+            v = Convert(v, unary->type, unary, false);
+            if (!v)
+                return nullptr;
+            if (IsFloating(v->type))
+                return pool_.Floating(v->type, -v->float_value);
+            std::int64_t lo, hi;
+            IntegralRange(v->type, lo, hi);
+            if (v->int_value == lo)
+                return Overflow(unary);
+            return pool_.Integral(v->type, -v->int_value);
+        }
+        default:
+            return nullptr;
+        }
+    }
+
+    const ConstValue *ConstantFolder::FoldBinary(BinaryExpr *binary)
+    {
+        const ConstValue *a = Fold(binary->lhs);
+        const ConstValue *b = Fold(binary->rhs);
+        const Type *result = binary->type;
+        if (!a || !b || !IsConcrete(result))
+        {
+            return nullptr;
+        }
+        TokenKind op = binary->op;
+
+        if (result->kind == TypeKind::kString)
+        {
+            if (a->type->kind != TypeKind::kString || b->type->kind != TypeKind::kString)
+                return nullptr; // "n=" + 1 converts at run time
+            return pool_.String(std::string(a->string_value) + std::string(b->string_value));
+        }
+        if (a->type->kind == TypeKind::kString || b->type->kind == TypeKind::kString)
+        {
+            if (a->type->kind != b->type->kind)
+                return nullptr;
+            bool equal = a->string_value == b->string_value;
+            return op == TokenKind::kTEquality ? pool_.Bool(equal) : op == TokenKind::kTNeq ? pool_.Bool(!equal) : nullptr;
+        }
+        if (a->type->kind == TypeKind::kBool && b->type->kind == TypeKind::kBool)
+        {
+            bool x = a->int_value, y = b->int_value;
+            switch (op)
+            {
+            case TokenKind::kTLogicalAnd:
+            case TokenKind::kTAmpersand:
+                return pool_.Bool(x && y);
+            case TokenKind::kTLogicalOr:
+            case TokenKind::kTPipe:
+                return pool_.Bool(x || y);
+            case TokenKind::kTXor:
+            case TokenKind::kTNeq:
+                return pool_.Bool(x != y);
+            case TokenKind::kTEquality:
+                return pool_.Bool(x == y);
+            default:
+                return nullptr;
+            }
+        }
+
+        // numeric operands are brought to the operation type first: the
+        // result type, or for comparisons the promoted operand type.
+        bool compare = result->kind == TypeKind::kBool;
+        const Type *operation = result;
+        if (compare)
+        {
+            TypeKind kind = std::max({a->type->kind, b->type->kind, TypeKind::kInt});
+            operation = kind == TypeKind::kLong ? types_.Long() : kind == TypeKind::kFloat ? types_.Float()
+                                                            : kind == TypeKind::kDouble  ? types_.Double()
+                                                                                         : types_.Int();
+        }
+        bool shift = op == TokenKind::kTLShift || op == TokenKind::kTRShift;
+        a = Convert(a, operation, binary->lhs, false);
+        b = shift ? b : Convert(b, operation, binary->rhs, false);
+        if (!a || !b)
+        {
+            return nullptr;
+        }
+
+        if (IsFloating(operation))
+        {
+            double x = a->float_value, y = b->float_value;
+            switch (op)
+            {
+            case TokenKind::kTPlus:
+                return pool_.Floating(operation, x + y);
+            case TokenKind::kTMinus:
+                return pool_.Floating(operation, x - y);
+            case TokenKind::kTStar:
+                return pool_.Floating(operation, x * y);
+            case TokenKind::kTFSlash:
+                return pool_.Floating(operation, x / y);
+            case TokenKind::kTModulo:
+                return pool_.Floating(operation, std::fmod(x, y));
+            case TokenKind::kTLessThan:
+                return pool_.Bool(x < y);
+            case TokenKind::kTGreaterThan:
+                return pool_.Bool(x > y);
+            case TokenKind::kTLessOrEqual:
+                return pool_.Bool(x <= y);
+            case TokenKind::kTGreaterOrEqual:
+                return pool_.Bool(x >= y);
+            case TokenKind::kTEquality:
+                return pool_.Bool(x == y);
+            case TokenKind::kTNeq:
+                return pool_.Bool(x != y);
+            default:
+                return nullptr;
+            }
+        }
+
+        std::int64_t x = a->int_value, y = b->int_value, r = 0;
+        std::int64_t lo, hi;
+        IntegralRange(operation, lo, hi);
+        bool wide = operation->kind == TypeKind::kLong;
+        switch (op)
+        {
+        case TokenKind::kTPlus:
+            if (__builtin_add_overflow(x, y, &r))
+                return Overflow(binary);
+            break;
+        case TokenKind::kTMinus:
+            if (__builtin_sub_overflow(x, y, &r))
+                return Overflow(binary);
+            break;
+        case TokenKind::kTStar:
+            if (__builtin_mul_overflow(x, y, &r))
+                return Overflow(binary);
+            break;
+        case TokenKind::kTFSlash:
+        case TokenKind::kTModulo:
+            if (y == 0)
+            {
+                Error(binary, "Division by constant zero");
+                return nullptr;
+            }
+            if (x == lo && y == -1)
+                return Overflow(binary);
+            r = op == TokenKind::kTFSlash ? x / y : x % y;
+            break;
+        case TokenKind::kTAmpersand:
+            r = x & y;
+            break;
+        case TokenKind::kTPipe:
+            r = x | y;
+            break;
+        case TokenKind::kTXor:
+            r = x ^ y;
+            break;
+        case TokenKind::kTLShift:
+        {
+            int count = static_cast<int>(y & (wide ? 63 : 31));
+            r = wide ? static_cast<std::int64_t>(static_cast<std::uint64_t>(x) << count)
+                     : static_cast<std::int32_t>(static_cast<std::uint32_t>(x) << count);
+            break;
+        }
+        case TokenKind::kTRShift:
+            r = x >> (y & (wide ? 63 : 31));
+            break;
+        case TokenKind::kTLessThan:
+            return pool_.Bool(x < y);
+        case TokenKind::kTGreaterThan:
+            return pool_.Bool(x > y);
+        case TokenKind::kTLessOrEqual:
+            return pool_.Bool(x <= y);
+        case TokenKind::kTGreaterOrEqual:
+            return pool_.Bool(x >= y);
+        case TokenKind::kTEquality:
+            return pool_.Bool(x == y);
+        case TokenKind::kTNeq:
+            return pool_.Bool(x != y);
+        default:
+            return nullptr;
+        }
+        if (r < lo || r > hi)
+        {
+            return Overflow(binary);
+        }
+        return pool_.Integral(operation, r);
+    }
+
+    const ConstValue *ConstantFolder::FoldCast(CastExpr *cast)
+    {
+        const ConstValue *v = Fold(cast->operand);
+        if (!v || !IsConcrete(cast->Expr::type))
+        {
+            return nullptr;
+        }
+        return Convert(v, cast->Expr::type, cast, true);
+    }
+
+    const ConstValue *ConstantFolder::Convert(const ConstValue *v, const Type *to, const Node *at, bool is_explicit)
+    {
+        if (!v || !to)
+        {
+            return nullptr;
+        }
+        if (v->type == to)
+        {
+            return v;
+        }
+        if (!v->type->IsNumeric() || !to->IsNumeric())
+        {
+            return nullptr;
+        }
+        if (IsFloating(to))
+        {
+            return pool_.Floating(to, AsDouble(v));
+        }
+        std::int64_t lo, hi;
+        IntegralRange(to, lo, hi);
+        if (IsFloating(v->type))
+        {
+            double d = std::trunc(v->float_value);
+            // hi + 1 is exact in a double for every integral range, and NaN fails both tests.
+            if (!(d >= static_cast<double>(lo) && d < static_cast<double>(hi) + 1.0))
+            {
+                Error(at, "Constant value '" + ConstValueToString(v) + "' cannot be converted to a '" + TypeToString(to) +
+                              "' (use 'unchecked' syntax to override)");
+                return nullptr;
+            }
+            return pool_.Integral(to, static_cast<std::int64_t>(d));
+        }
+        if (v->int_value < lo || v->int_value > hi)
+        {
+            if (is_explicit)
+            {
+                Error(at, "Constant value '" + ConstValueToString(v) + "' cannot be converted to a '" + TypeToString(to) +
+                              "' (use 'unchecked' syntax to override)");
+            }
+            return nullptr;
+        }
+        return pool_.Integral(to, v->int_value);
+    }
+
+    const ConstValue *ConstantFolder::Overflow(const Node *at)
+    {
+        Error(at, "The operation overflows at compile time in checked mode");
+        return nullptr;
+    }
+
+    void ConstantFolder::Error(const Node *node, const std::string &message)
+    {
+        SourcePosition at = unit_ ? unit_->Locate(node) : SourcePosition{};
+        diagnostics_.push_back(Diagnostic{Severity::kError, std::string(unit_ ? unit_->file : ""), at.line, at.column, message});
+    }
+
+}
@@ -0,0 +1,633 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include "corpus.h"
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+namespace tinycsharp
+{
+    namespace
+    {
+        std::uint64_t Mix(std::uint64_t x)
+        {
+            x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+            x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+            return x ^ (x >> 31);
+        }
+
+        // splitmix64, which gives the same numbers everywhere; the standard
+        // library's distributions need not.
+        class Random
+        {
+        public:
+            explicit Random(std::uint64_t seed) : state_(seed) {}
+
+            std::uint64_t Next()
+            {
+                state_ += 0x9e3779b97f4a7c15ull;
+                return Mix(state_);
+            }
+            int Below(int n) { return static_cast<int>(Next() % static_cast<std::uint64_t>(n)); }
+            int Between(int lo, int hi) { return lo + Below(hi - lo + 1); }
+            bool Chance(double p) { return static_cast<double>(Next() >> 11) * 0x1.0p-53 < p; }
+            template <typename T>
+            const T &Pick(const std::vector<T> &items) { return items[Below(static_cast<int>(items.size()))]; }
+
+        private:
+            std::uint64_t state_;
+        };
+
+        // a name of at least length characters: lead, random letters, then
+        // number, which keeps it unique and, being digits, keeps the name
+        // clear of every keyword.
+        std::string Name(Random &random, char lead, std::uint64_t number, int length)
+        {
+            std::string digits = std::to_string(number);
+            std::string name(1, lead);
+            while (name.size() + digits.size() < static_cast<std::size_t>(length))
+                name += static_cast<char>('a' + random.Below(26));
+            return name + digits;
+        }
+
+        // other files call a file's Entry() through these, so they depend on
+        // the index alone.
+        std::string NamespaceOf(int file)
+        {
+            return "Generated.F" + std::to_string(file);
+        }
+
+        std::string UnitName(const CorpusOptions &options, int file)
+        {
+            Random random{Mix(options.seed ^ Mix(static_cast<std::uint64_t>(file) + 0x756e6974))};
+            return Name(random, 'U', static_cast<std::uint64_t>(file), options.identifier_length);
+        }
+
+        // a method's head, braces, accumulator and return.
+        constexpr int kMethodLines = 5;
+
+        const std::vector<std::string> kWords = {"alpha", "beta", "gamma", "delta", "node", "item", "value", "index",
+                                                 "count", "total", "ratio", "label", "state", "cache", "token", "scope"};
+
+        enum class Kind
+        {
+            kInt,
+            kLong,
+            kDouble,
+            kBool,
+            kString,
+        };
+
+        const char *TypeName(Kind kind)
+        {
+            switch (kind)
+            {
+            case Kind::kInt:
+                return "int";
+            case Kind::kLong:
+                return "long";
+            case Kind::kDouble:
+                return "double";
+            case Kind::kBool:
+                return "bool";
+            case Kind::kString:
+                return "string";
+            }
+            return "int";
+        }
+
+        struct Local
+        {
+            std::string name;
+            Kind kind;
+            bool fixed = false; // a parameter or loop counter: read, never assigned
+        };
+
+        // writes one file a line at a time, following each line with
+        // comments as the density asks. a construct sets aside the lines it
+        // must write, such as its braces, before it starts, and only lines
+        // nobody set aside go to statements, members and comments; so the
+        // file stays within lines_per_file, and comments fill what is left.
+        class FileWriter
+        {
+        public:
+            FileWriter(const CorpusOptions &options, int index)
+                : options_(options), index_(index), random_(Mix(options.seed + Mix(static_cast<std::uint64_t>(index))))
+            {
+                // a comment is a line or, one time in five, a two-line block.
+                // after each line of code come comments while a coin with
+                // odds r lands heads, which makes their share of the lines
+                // the density.
+                double p = options.comment_density;
+                double r = p / (1.2 * (1 - p));
+                comment_chance_ = r / (1 + r);
+            }
+
+            std::string Write()
+            {
+                Emit("// generated by tinycsharp_gen: file " + std::to_string(index_ + 1) + " of " +
+                     std::to_string(options_.files) + ", seed " + std::to_string(options_.seed));
+                // the using, the namespace and its braces, and the static
+                // class, written last.
+                reserved_ += 4 + UnitLines();
+                Owed("using System;");
+                Owed("namespace " + NamespaceOf(index_));
+                Open();
+                // three quarters of the lines go to instance classes, the
+                // rest to the static class that ties them together.
+                int classes_end = options_.lines_per_file * 3 / 4;
+                while (lines_ < classes_end - 20)
+                {
+                    if (!InstanceClass(std::min(classes_end, lines_ + random_.Between(30, 150))))
+                        break;
+                }
+                UnitClass();
+                Close();
+                while (lines_ < options_.lines_per_file)
+                    Emit("// " + Words(random_.Between(2, 8)));
+                return out_.str();
+            }
+
+        private:
+            void Emit(const std::string &text)
+            {
+                out_ << std::string(static_cast<std::size_t>(indent_) * 4, ' ') << text << '\n';
+                lines_++;
+            }
+
+            // the lines not set aside; negative only in a file too short for
+            // what every file has.
+            int Room() const
+            {
+                return options_.lines_per_file - lines_ - reserved_;
+            }
+
+            void Line(const std::string &text)
+            {
+                Emit(text);
+                while (random_.Chance(comment_chance_))
+                    Comment();
+            }
+
+            // a line that was set aside.
+            void Owed(const std::string &text)
+            {
+                reserved_--;
+                Line(text);
+            }
+
+            void Comment()
+            {
+                if (Room() < 1)
+                    return;
+                if (random_.Below(5) == 0 && Room() >= 2)
+                {
+                    Emit("/* " + Words(random_.Between(2, 8)));
+                    Emit("   " + Words(random_.Between(2, 8)) + " */");
+                }
+                else
+                {
+                    Emit("// " + Words(random_.Between(2, 8)));
+                }
+            }
+
+            std::string Words(int count)
+            {
+                std::string text = random_.Pick(kWords);
+                for (int i = 1; i < count; i++)
+                    text += " " + random_.Pick(kWords);
+                return text;
+            }
+
+            // both braces are set aside with the construct they belong to.
+            void Open()
+            {
+                Owed("{");
+                indent_++;
+            }
+
+            void Close(const std::string &text = "}")
+            {
+                indent_--;
+                Owed(text);
+            }
+
+            std::string Fresh(char lead)
+            {
+                return Name(random_, lead, next_name_++, options_.identifier_length);
+            }
+
+            Kind RandomKind()
+            {
+                int roll = random_.Below(100);
+                return roll < 35 ? Kind::kInt : roll < 50 ? Kind::kLong : roll < 65 ? Kind::kDouble : roll < 80 ? Kind::kBool : Kind::kString;
+            }
+
+            // a local, parameter or field of kind in scope; null if there is
+            // none.
+            const Local *Find(Kind kind, bool assignable)
+            {
+                std::vector<const Local *> found;
+                auto consider = [&](const Local &local)
+                {
+                    if (local.kind == kind && !(assignable && local.fixed))
+                        found.push_back(&local);
+                };
+                for (const auto &scope : scopes_)
+                {
+                    for (const Local &local : scope)
+                        consider(local);
+                }
+                for (const Local &field : fields_)
+                    consider(field);
+                return found.empty() ? nullptr : random_.Pick(found);
+            }
+
+            std::string Literal(Kind kind)
+            {
+                switch (kind)
+                {
+                case Kind::kInt:
+                    return std::to_string(random_.Between(0, 99));
+                case Kind::kLong:
+                    return std::to_string(random_.Between(0, 100000));
+                case Kind::kDouble:
+                    return std::to_string(random_.Between(0, 99)) + "." + std::to_string(random_.Between(1, 99));
+                case Kind::kBool:
+                    return random_.Below(2) ? "true" : "false";
+                case Kind::kString:
+                    return "\"" + random_.Pick(kWords) + "\"";
+                }
+                return "0";
+            }
+
+            std::string Atom(Kind kind)
+            {
+                const Local *local = random_.Chance(0.6) ? Find(kind, false) : nullptr;
+                return local ? local->name : Literal(kind);
+            }
+
+            // expressions nest two operators deep at most, which keeps the
+            // lines short and constant ones from overflowing.
+            std::string Expr(Kind kind, int depth)
+            {
+                if (depth >= 2 || random_.Chance(0.4))
+                    return Atom(kind);
+                switch (kind)
+                {
+                case Kind::kInt:
+                    return IntExpr(depth);
+                case Kind::kLong:
+                    return random_.Below(2) ? Expr(Kind::kLong, depth + 1) + " + " + Expr(Kind::kInt, depth + 1)
+                                            : Expr(Kind::kLong, depth + 1) + " * " + std::to_string(random_.Between(1, 9));
+                case Kind::kDouble:
+                    return Expr(Kind::kDouble, depth + 1) + (random_.Below(2) ? " * " : " + ") + Expr(Kind::kDouble, depth + 1);
+                case Kind::kBool:
+                    return BoolExpr(depth);
+                case Kind::kString:
+                    return Expr(Kind::kString, depth + 1) + " + " + Grouped(random_.Below(2) ? Kind::kString : Kind::kInt, depth + 1);
+                }
+                return Atom(kind);
+            }
+
+            // an operand of +, in parentheses unless it is a single name or
+            // literal: after a string, + concatenates.
+            std::string Grouped(Kind kind, int depth)
+            {
+                std::string expr = Expr(kind, depth);
+                return expr.find(' ') == std::string::npos ? expr : "(" + expr + ")";
+            }
+
+            std::string IntExpr(int depth)
+            {
+                static const std::vector<std::string> arithmetic = {"+", "-", "*"};
+                static const std::vector<std::string> bitwise = {"&", "|", "^"};
+                switch (random_.Below(6))
+                {
+                case 0:
+                case 1:
+                    return Expr(Kind::kInt, depth + 1) + " " + random_.Pick(arithmetic) + " " + Expr(Kind::kInt, depth + 1);
+                case 2:
+                    // bitwise operators bind looser than comparisons.
+                    return "(" + Expr(Kind::kInt, depth + 1) + " " + random_.Pick(bitwise) + " " + Expr(Kind::kInt, depth + 1) + ")";
+                case 3:
+                    return "(" + Expr(Kind::kInt, depth + 1) + ") " + (random_.Below(2) ? "%" : "/") + " " + std::to_string(random_.Between(2, 97));
+                case 4:
+                    return "(" + BoolExpr(depth + 1) + " ? " + Expr(Kind::kInt, depth + 1) + " : " + Expr(Kind::kInt, depth + 1) + ")";
+                default:
+                    return "(int)(" + Expr(Kind::kLong, depth + 1) + " % " + std::to_string(random_.Between(2, 1000)) + ")";
+                }
+            }
+
+            std::string BoolExpr(int depth)
+            {
+                static const std::vector<std::string> comparisons = {"<", "<=", ">", ">=", "==", "!="};
+                int roll = depth >= 2 ? 0 : random_.Below(5);
+                switch (roll)
+                {
+                case 0:
+                case 1:
+                    return Expr(Kind::kInt, depth + 1) + " " + random_.Pick(comparisons) + " " + Expr(Kind::kInt, depth + 1);
+                case 2:
+                    return "(" + Expr(Kind::kBool, depth + 1) + " && " + Expr(Kind::kBool, depth + 1) + ")";
+                case 3:
+                    return "(" + Expr(Kind::kBool, depth + 1) + " || " + Expr(Kind::kBool, depth + 1) + ")";
+                default:
+                    return "!(" + Expr(Kind::kBool, depth + 1) + ")";
+                }
+            }
+
+            void Statements(int depth, int count)
+            {
+                for (int i = 0; i < count && Room() > 0; i++)
+                    Statement(depth);
+            }
+
+            void Block(int depth)
+            {
+                Open();
+                scopes_.emplace_back();
+                Statements(depth, random_.Between(1, 3));
+                scopes_.pop_back();
+                Close();
+            }
+
+            void Statement(int depth)
+            {
+                int roll = random_.Below(100);
+                bool nest = depth < options_.max_depth;
+                // an if is its head and braces around at least one
+                // statement, and so is an else.
+                if (nest && roll < 12 && Room() >= 4)
+                {
+                    reserved_ += 3;
+                    Owed("if (" + BoolExpr(0) + ")");
+                    Block(depth + 1);
+                    if (Room() >= 4 && random_.Chance(0.4))
+                    {
+                        reserved_ += 3;
+                        Owed("else");
+                        Block(depth + 1);
+                    }
+                }
+                else if (nest && roll < 24 && Room() >= 5)
+                {
+                    // counted up to the parameter, which calls halve. the
+                    // counter, head, braces and increment are set aside.
+                    reserved_ += 5;
+                    std::string counter = Fresh('k');
+                    Owed("int " + counter + " = 0;");
+                    scopes_.back().push_back(Local{counter, Kind::kInt, true});
+                    bool until = random_.Below(3) == 0;
+                    Owed(until ? "do" : "while (" + counter + " < " + param_ + ")");
+                    Open();
+                    scopes_.emplace_back();
+                    Statements(depth + 1, random_.Between(1, 3));
+                    Owed(counter + "++;");
+                    scopes_.pop_back();
+                    Close(until ? "} while (" + counter + " < " + param_ + ");" : "}");
+                }
+                else if (roll < 45)
+                {
+                    Kind kind = RandomKind();
+                    std::string name = Fresh('l');
+                    Line(std::string(TypeName(kind)) + " " + name + " = " + Expr(kind, 0) + ";");
+                    scopes_.back().push_back(Local{name, kind});
+                }
+                else if (roll < 58 && !callees_.empty())
+                {
+                    Line(acc_ + " += " + random_.Pick(callees_) + "(" + param_ + " / 2);");
+                }
+                else if (roll < 80)
+                {
+                    Kind kind = RandomKind();
+                    const Local *target = Find(kind, true);
+                    if (!target)
+                        Line(acc_ + " += " + Expr(Kind::kInt, 0) + ";");
+                    else if (kind == Kind::kInt || kind == Kind::kLong)
+                        Line(target->name + (random_.Below(2) ? " += " : " = ") + Expr(kind, 0) + ";");
+                    else if (kind == Kind::kString)
+                        // built from strings in scope, a string assigned in a
+                        // loop could double each time round.
+                        Line(target->name + " = " + Literal(kind) + " + " + Grouped(Kind::kInt, 1) + ";");
+                    else
+                        Line(target->name + " = " + Expr(kind, 0) + ";");
+                }
+                else
+                {
+                    Line(acc_ + " = " + acc_ + " + " + Expr(Kind::kInt, 0) + ";");
+                }
+            }
+
+            // an int method of one int parameter, calling only the methods
+            // declared before it. takes kMethodLines of room.
+            void Method(const std::string &head, char lead)
+            {
+                reserved_ += kMethodLines;
+                std::string name = Fresh(lead);
+                param_ = Fresh('p');
+                Owed(head + "int " + name + "(int " + param_ + ")");
+                Open();
+                scopes_.assign(1, {Local{param_, Kind::kInt, true}});
+                acc_ = Fresh('a');
+                Owed("int " + acc_ + " = " + Expr(Kind::kInt, 0) + ";");
+                scopes_[0].push_back(Local{acc_, Kind::kInt});
+                Statements(0, random_.Between(3, 9));
+                Owed("return " + acc_ + ";");
+                Close();
+                callees_.push_back(name);
+            }
+
+            // count lines the caller set aside.
+            void Fields(const std::string &head, int count)
+            {
+                for (int i = 0; i < count; i++)
+                {
+                    Kind kind = RandomKind();
+                    std::string name = Fresh('f');
+                    Owed(head + TypeName(kind) + " " + name + (random_.Below(2) ? " = " + Literal(kind) : std::string()) + ";");
+                    fields_.push_back(Local{name, kind});
+                }
+            }
+
+            // false, writing nothing, without room for the class with one
+            // method.
+            bool InstanceClass(int end)
+            {
+                // the head and braces of the class and its constructor, and
+                // a field and an assignment to it per field.
+                int fields = random_.Between(1, 4);
+                int fixed = 6 + 2 * fields;
+                if (Room() < fixed + kMethodLines)
+                    return false;
+                reserved_ += fixed + kMethodLines;
+                std::string name = Fresh('C');
+                Owed("public class " + name);
+                Open();
+                fields_.clear();
+                callees_.clear();
+                Fields("private ", fields);
+
+                std::string param = Fresh('p');
+                Owed("public " + name + "(int " + param + ")");
+                Open();
+                scopes_.assign(1, {Local{param, Kind::kInt, true}});
+                for (const Local &field : fields_)
+                {
+                    if (random_.Chance(0.7))
+                        Owed(field.name + " = " + Expr(field.kind, 0) + ";");
+                    else
+                        reserved_--;
+                }
+                Close();
+
+                // handed to the first method as it starts.
+                reserved_ -= kMethodLines;
+                do
+                    Method(random_.Below(2) ? "public " : "private ", 'm');
+                while (lines_ < end && Room() >= kMethodLines);
+                Close();
+                made_.push_back({name, callees_.back()});
+                return true;
+            }
+
+            // the most lines the static class takes besides its helpers:
+            // its head and braces, two fields, Entry() and Main().
+            int UnitLines() const
+            {
+                return 3 + 2 + EntryLines(true, true) + (index_ == options_.files - 1 ? 4 : 0);
+            }
+
+            // Entry()'s head, braces, accumulator and return, around three
+            // calls into instance classes and two to helpers, when there
+            // are any, and one to an earlier file.
+            int EntryLines(bool classes, bool helpers) const
+            {
+                return 5 + (classes ? 3 : 0) + (helpers ? 2 : 0) + (index_ > 0 ? 1 : 0);
+            }
+
+            // the static class other files call into: helpers, then Entry(),
+            // which runs some of the instance classes and an earlier file's
+            // Entry(); the last file's also holds Main().
+            void UnitClass()
+            {
+                // what Write() set aside becomes what this class needs,
+                // with room for two helper calls until the helpers are in.
+                int fields = random_.Between(0, 2);
+                int main = index_ == options_.files - 1 ? 4 : 0;
+                reserved_ += 3 + fields + EntryLines(!made_.empty(), true) + main - UnitLines();
+                Owed("public static class " + UnitName(options_, index_));
+                Open();
+                fields_.clear();
+                callees_.clear();
+                Fields("private static ", fields);
+                while (Room() >= kMethodLines)
+                    Method(random_.Below(2) ? "public static " : "private static ", 's');
+                reserved_ -= EntryLines(!made_.empty(), true) - EntryLines(!made_.empty(), !callees_.empty());
+
+                std::string param = Fresh('p');
+                std::string acc = Fresh('a');
+                Owed("public static int Entry(int " + param + ")");
+                Open();
+                Owed("int " + acc + " = " + param + ";");
+                for (int i = 0; i < 3 && !made_.empty(); i++)
+                {
+                    const auto &[cls, method] = random_.Pick(made_);
+                    Owed(acc + " += new " + cls + "(" + param + ")." + method + "(" + param + ");");
+                }
+                for (int i = 0; i < 2 && !callees_.empty(); i++)
+                    Owed(acc + " += " + random_.Pick(callees_) + "(" + param + ");");
+                if (index_ > 0)
+                {
+                    int earlier = random_.Between(std::max(0, index_ - 8), index_ - 1);
+                    Owed(acc + " += " + NamespaceOf(earlier) + "." + UnitName(options_, earlier) + ".Entry(" + param + " - 1);");
+                }
+                Owed("return " + acc + ";");
+                Close();
+
+                if (main)
+                {
+                    Owed("public static int Main()");
+                    Open();
+                    Owed("return Entry(4) % 100;");
+                    Close();
+                }
+                Close();
+            }
+
+            const CorpusOptions &options_;
+            int index_;
+            Random random_;
+            double comment_chance_;
+            std::ostringstream out_;
+            int indent_ = 0;
+            int lines_ = 0;
+            // lines the constructs under way still have to write.
+            int reserved_ = 0;
+            std::uint64_t next_name_ = 0;
+
+            // what the method being written can use: its scopes, the
+            // class's fields and the methods declared before it.
+            std::vector<std::vector<Local>> scopes_;
+            std::vector<Local> fields_;
+            std::vector<std::string> callees_;
+            std::string param_;
+            std::string acc_;
+            // the instance classes written so far, with one method of each.
+            std::vector<std::pair<std::string, std::string>> made_;
+        };
+    }
+
+    CorpusGenerator::CorpusGenerator(CorpusOptions options)
+        : options_(options)
+    {
+        if (options.files < 1)
+            throw std::invalid_argument("corpus: files must be at least 1");
+        if (options.lines_per_file < 1)
+            throw std::invalid_argument("corpus: lines per file must be at least 1");
+        if (options.max_depth < 0)
+            throw std::invalid_argument("corpus: nesting depth cannot be negative");
+        if (options.identifier_length < 1)
+            throw std::invalid_argument("corpus: identifier length must be at least 1");
+        if (!(options.comment_density >= 0 && options.comment_density < 1))
+            throw std::invalid_argument("corpus: comment density must be in [0, 1)");
+    }
+
+    CorpusFile CorpusGenerator::File(int index) const
+    {
+        if (index < 0 || index >= options_.files)
+            throw std::out_of_range("corpus: no file " + std::to_string(index));
+        std::string number = std::to_string(index);
+        std::size_t width = std::to_string(options_.files - 1).size();
+        CorpusFile file;
+        file.name = "file" + std::string(width - number.size(), '0') + number + ".cs";
+        file.text = FileWriter{options_, index}.Write();
+        return file;
+    }
+
+    std::vector<CorpusFile> CorpusGenerator::Files() const
+    {
+        std::vector<CorpusFile> files;
+        files.reserve(static_cast<std::size_t>(options_.files));
+        for (int i = 0; i < options_.files; i++)
+            files.push_back(File(i));
+        return files;
+    }
+
+}
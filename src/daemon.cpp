@@ -0,0 +1,331 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include "daemon.h"
+#include "cache.h"
+#include "lexer.h"
+#include "parser.h"
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TINYCSHARP_DAEMON 1
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#else
+#define TINYCSHARP_DAEMON 0
+#endif
+
+namespace tinycsharp
+{
+    FrontEndCache::FrontEndCache()
+        : interner_(std::make_unique<Interner>()), sources_(std::make_unique<SourceManager>())
+    {
+    }
+
+    const FrontEndCache::File &FrontEndCache::Parse(const std::string &path, const std::string &source, CompilationCache *cache)
+    {
+        auto it = files_.find(path);
+        if (it != files_.end() && it->second->source == source)
+        {
+            stats_.hits++;
+            return *it->second;
+        }
+        stats_.misses++;
+        if (it != files_.end())
+        {
+            // the trees of other files may still point into this one; the
+            // next analysis clears that.
+            Drop(*it->second);
+            files_.erase(it);
+        }
+        auto file = std::make_unique<File>();
+        file->path = path;
+        file->id = sources_->AddFile(path, source);
+        file->source = sources_->Text(file->id);
+        live_ += std::uint64_t{sources_->Size(file->id)} + 1;
+        try
+        {
+            file->ast = std::make_unique<AstContext>(*interner_, *sources_);
+            SourceLocation base = sources_->Begin(file->id);
+            if (cache)
+            {
+                ParseCached(*cache, *file->ast, source, file->path, base, &file->tokens);
+            }
+            else
+            {
+                Lexer lexer{source, base};
+                std::vector<Token> lexed = lexer.Tokenize();
+                file->tokens = lexed.size();
+                Parser parser{*file->ast, std::move(lexed), file->path};
+                parser.ParseCompilationUnit();
+            }
+        }
+        catch (...)
+        {
+            Drop(*file);
+            throw;
+        }
+        auto &slot = files_[path];
+        slot = std::move(file);
+        return *slot;
+    }
+
+    void FrontEndCache::Drop(const File &file)
+    {
+        sources_->Release(file.id);
+        live_ -= std::uint64_t{sources_->Size(file.id)} + 1;
+    }
+
+    void FrontEndCache::Trim(std::uint64_t limit)
+    {
+        if (sources_->AddressSpaceUsed() - live_ <= limit)
+        {
+            return;
+        }
+        stats_.trims++;
+        files_.clear();
+        live_ = 0;
+        sources_ = std::make_unique<SourceManager>();
+        interner_ = std::make_unique<Interner>();
+    }
+
+#if TINYCSHARP_DAEMON
+    namespace
+    {
+        // frames on the socket: a request is a magic word, the client's
+        // working directory and the arguments; a reply is the exit status,
+        // stdout and stderr. numbers are 32-bit little endian, strings are
+        // length-prefixed.
+        constexpr std::uint32_t kMagic = 0x31647374; // "tsd1"
+        constexpr std::uint32_t kMaxString = 1u << 30;
+        constexpr std::uint32_t kMaxArgs = 1u << 16;
+
+        class Connection
+        {
+        public:
+            explicit Connection(int fd) : fd_(fd) {}
+            ~Connection()
+            {
+                if (fd_ >= 0)
+                    ::close(fd_);
+            }
+            Connection(const Connection &) = delete;
+            Connection &operator=(const Connection &) = delete;
+
+            int fd() const { return fd_; }
+
+            void WriteU32(std::uint32_t v)
+            {
+                unsigned char bytes[4] = {static_cast<unsigned char>(v), static_cast<unsigned char>(v >> 8),
+                                          static_cast<unsigned char>(v >> 16), static_cast<unsigned char>(v >> 24)};
+                Write(bytes, sizeof bytes);
+            }
+            void WriteString(const std::string &s)
+            {
+                WriteU32(static_cast<std::uint32_t>(s.size()));
+                Write(s.data(), s.size());
+            }
+            std::uint32_t ReadU32()
+            {
+                unsigned char bytes[4];
+                Read(bytes, sizeof bytes);
+                return static_cast<std::uint32_t>(bytes[0]) | static_cast<std::uint32_t>(bytes[1]) << 8 |
+                       static_cast<std::uint32_t>(bytes[2]) << 16 | static_cast<std::uint32_t>(bytes[3]) << 24;
+            }
+            std::string ReadString()
+            {
+                std::uint32_t size = ReadU32();
+                if (size > kMaxString)
+                    throw std::runtime_error("daemon: oversized message");
+                std::string s(size, '\0');
+                Read(s.data(), size);
+                return s;
+            }
+
+        private:
+            void Write(const void *data, std::size_t size)
+            {
+                const char *p = static_cast<const char *>(data);
+                while (size > 0)
+                {
+#ifdef MSG_NOSIGNAL
+                    ssize_t n = ::send(fd_, p, size, MSG_NOSIGNAL);
+#else
+                    ssize_t n = ::write(fd_, p, size);
+#endif
+                    if (n < 0 && errno == EINTR)
+                        continue;
+                    if (n <= 0)
+                        throw std::runtime_error(std::string("daemon: write failed: ") + std::strerror(errno));
+                    p += n;
+                    size -= static_cast<std::size_t>(n);
+                }
+            }
+            void Read(void *data, std::size_t size)
+            {
+                char *p = static_cast<char *>(data);
+                while (size > 0)
+                {
+                    ssize_t n = ::read(fd_, p, size);
+                    if (n < 0 && errno == EINTR)
+                        continue;
+                    if (n <= 0)
+                        throw std::runtime_error("daemon: connection closed");
+                    p += n;
+                    size -= static_cast<std::size_t>(n);
+                }
+            }
+
+            int fd_;
+        };
+
+        sockaddr_un Address(const std::string &path)
+        {
+            sockaddr_un addr{};
+            addr.sun_family = AF_UNIX;
+            if (path.size() >= sizeof addr.sun_path)
+                throw std::runtime_error("daemon: socket path too long: " + path);
+            std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+            return addr;
+        }
+    }
+
+    void ServeDaemon(const std::string &path, const DaemonHandler &handler)
+    {
+        sockaddr_un addr = Address(path);
+        Connection listener{::socket(AF_UNIX, SOCK_STREAM, 0)};
+        if (listener.fd() < 0)
+            throw std::runtime_error(std::string("daemon: socket: ") + std::strerror(errno));
+        // a socket left by a daemon that died; a live one still answers.
+        std::ostringstream ignored;
+        if (SendToDaemon(path, {}, ignored, ignored))
+            throw std::runtime_error("daemon: another daemon is serving " + path);
+        ::unlink(path.c_str());
+        mode_t mask = ::umask(077);
+        int bound = ::bind(listener.fd(), reinterpret_cast<const sockaddr *>(&addr), sizeof addr);
+        ::umask(mask);
+        if (bound < 0 || ::listen(listener.fd(), 16) < 0)
+            throw std::runtime_error("daemon: cannot listen on " + path + ": " + std::strerror(errno));
+        std::filesystem::path home = std::filesystem::current_path();
+        bool serving = true;
+        while (serving)
+        {
+            int fd = ::accept(listener.fd(), nullptr, nullptr);
+            if (fd < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                break;
+            }
+            Connection client{fd};
+            try
+            {
+                if (client.ReadU32() != kMagic)
+                    continue;
+                std::string cwd = client.ReadString();
+                std::uint32_t count = client.ReadU32();
+                if (count > kMaxArgs)
+                    throw std::runtime_error("daemon: too many arguments");
+                std::vector<std::string> args(count);
+                for (std::string &arg : args)
+                    arg = client.ReadString();
+                std::ostringstream out;
+                std::ostringstream err;
+                int status = 0;
+                if (args.size() == 1 && args[0] == "--shutdown")
+                {
+                    serving = false;
+                }
+                else if (!args.empty())
+                {
+                    std::error_code ec;
+                    std::filesystem::current_path(cwd, ec);
+                    if (ec)
+                    {
+                        err << "tinycsharp: cannot enter " << cwd << ": " << ec.message() << "\n";
+                        status = 1;
+                    }
+                    else
+                    {
+                        try
+                        {
+                            status = handler(args, out, err);
+                        }
+                        catch (const std::exception &e)
+                        {
+                            err << "tinycsharp: " << e.what() << "\n";
+                            status = 1;
+                        }
+                    }
+                    std::filesystem::current_path(home, ec);
+                }
+                client.WriteU32(static_cast<std::uint32_t>(status));
+                client.WriteString(out.str());
+                client.WriteString(err.str());
+            }
+            catch (const std::exception &)
+            {
+                // the client went away or sent garbage; serve the next one.
+            }
+        }
+        ::unlink(path.c_str());
+    }
+
+    std::optional<int> SendToDaemon(const std::string &path, const std::vector<std::string> &args, std::ostream &out,
+                                    std::ostream &err)
+    {
+        sockaddr_un addr = Address(path);
+        Connection server{::socket(AF_UNIX, SOCK_STREAM, 0)};
+        if (server.fd() < 0 || ::connect(server.fd(), reinterpret_cast<const sockaddr *>(&addr), sizeof addr) < 0)
+            return std::nullopt;
+        try
+        {
+            server.WriteU32(kMagic);
+            server.WriteString(std::filesystem::current_path().string());
+            server.WriteU32(static_cast<std::uint32_t>(args.size()));
+            for (const std::string &arg : args)
+                server.WriteString(arg);
+            int status = static_cast<int>(server.ReadU32());
+            out << server.ReadString();
+            err << server.ReadString();
+            return status;
+        }
+        catch (const std::runtime_error &)
+        {
+            return std::nullopt;
+        }
+    }
+#else
+    void ServeDaemon(const std::string &, const DaemonHandler &)
+    {
+        throw std::runtime_error("daemon: Unix domain sockets are not available on this platform");
+    }
+
+    std::optional<int> SendToDaemon(const std::string &, const std::vector<std::string> &, std::ostream &, std::ostream &)
+    {
+        return std::nullopt;
+    }
+#endif
+
+}
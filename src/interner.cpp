@@ -0,0 +1,117 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+
+#include "interner.h"
+
+namespace tinycsharp
+{
+
+    Interner::Interner() : slots_(256)
+    {
+        spellings_.push_back({});
+    }
+
+    std::uint32_t Interner::Hash(std::string_view s)
+    {
+        std::uint32_t h = 2166136261u;
+        for (unsigned char c : s)
+        {
+            h = (h ^ c) * 16777619u;
+        }
+        return h;
+    }
+
+    SymbolId Interner::FindLocked(std::string_view s, std::uint32_t hash, std::size_t &slot) const
+    {
+        std::size_t mask = slots_.size() - 1;
+        for (slot = hash & mask;; slot = (slot + 1) & mask)
+        {
+            const Slot &candidate = slots_[slot];
+            if (candidate.id == kNoSymbol)
+            {
+                return kNoSymbol;
+            }
+            if (candidate.hash == hash && spellings_[candidate.id] == s)
+            {
+                return candidate.id;
+            }
+        }
+    }
+
+    SymbolId Interner::Intern(std::string_view s)
+    {
+        std::uint32_t hash = Hash(s);
+        std::lock_guard<std::mutex> lock(mu_);
+        std::size_t slot;
+        if (SymbolId id = FindLocked(s, hash, slot))
+        {
+            return id;
+        }
+        SymbolId id = static_cast<SymbolId>(spellings_.size());
+        spellings_.push_back(arena_.CopyString(s));
+        slots_[slot] = Slot{hash, id};
+        if (spellings_.size() * 2 > slots_.size())
+        {
+            Grow();
+        }
+        return id;
+    }
+
+    SymbolId Interner::Find(std::string_view s) const
+    {
+        std::uint32_t hash = Hash(s);
+        std::lock_guard<std::mutex> lock(mu_);
+        std::size_t slot;
+        return FindLocked(s, hash, slot);
+    }
+
+    std::string_view Interner::Spelling(SymbolId id) const
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        return id < spellings_.size() ? spellings_[id] : std::string_view{};
+    }
+
+    std::size_t Interner::Size() const
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        return spellings_.size() - 1;
+    }
+
+    void Interner::Grow()
+    {
+        std::vector<Slot> old;
+        old.swap(slots_);
+        slots_.assign(old.size() * 2, Slot{});
+        std::size_t mask = slots_.size() - 1;
+        for (const Slot &s : old)
+        {
+            if (s.id == kNoSymbol)
+            {
+                continue;
+            }
+            std::size_t i = s.hash & mask;
+            while (slots_[i].id != kNoSymbol)
+            {
+                i = (i + 1) & mask;
+            }
+            slots_[i] = s;
+        }
+    }
+
+}
@@ -0,0 +1,1057 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include "ir.h"
+#include "sema.h"
+#include "types.h"
+#include <sstream>
+#include <unordered_map>
+
+namespace tinycsharp
+{
+    const char *IrTypeToString(IrType type)
+    {
+        switch (type)
+        {
+        case IrType::kVoid:
+            return "void";
+        case IrType::kBool:
+            return "bool";
+        case IrType::kChar:
+            return "char";
+        case IrType::kI32:
+            return "i32";
+        case IrType::kI64:
+            return "i64";
+        case IrType::kF32:
+            return "f32";
+        case IrType::kF64:
+            return "f64";
+        case IrType::kRef:
+            return "ref";
+        }
+        return "?";
+    }
+
+    IrType IrTypeOf(const Type *type)
+    {
+        switch (type->kind)
+        {
+        case TypeKind::kVoid:
+            return IrType::kVoid;
+        case TypeKind::kBool:
+            return IrType::kBool;
+        case TypeKind::kChar:
+            return IrType::kChar;
+        case TypeKind::kInt:
+            return IrType::kI32;
+        case TypeKind::kLong:
+            return IrType::kI64;
+        case TypeKind::kFloat:
+            return IrType::kF32;
+        case TypeKind::kDouble:
+            return IrType::kF64;
+        default:
+            return IrType::kRef;
+        }
+    }
+
+    const char *IrOpToString(IrOp op)
+    {
+        static const char *const kNames[] = {
+#define TINYCSHARP_IR_OP_NAME(Name) #Name,
+            TINYCSHARP_IR_OPS(TINYCSHARP_IR_OP_NAME)
+#undef TINYCSHARP_IR_OP_NAME
+        };
+        return kNames[static_cast<std::size_t>(op)];
+    }
+
+    bool HasSideEffects(IrOp op)
+    {
+        switch (op)
+        {
+        case IrOp::kStoreField:
+        case IrOp::kStoreStatic:
+        case IrOp::kStoreElem:
+        case IrOp::kCall:
+        case IrOp::kCallVirtual:
+        case IrOp::kCallBuiltin:
+        case IrOp::kCallInit:
+        case IrOp::kAwait:
+        // these trap on division by zero, null or a bad index or cast.
+        case IrOp::kDiv:
+        case IrOp::kRem:
+        case IrOp::kLoadField:
+        case IrOp::kLoadElem:
+        case IrOp::kArrayLength:
+        case IrOp::kStringLength:
+        case IrOp::kCharAt:
+        case IrOp::kCheckCast:
+        case IrOp::kNewArray:
+            return true;
+        default:
+            return IsTerminator(op);
+        }
+    }
+
+    std::uint8_t ValueOperandMask(IrOp op)
+    {
+        constexpr std::uint8_t kA = 1, kB = 2, kC = 4;
+        switch (op)
+        {
+        case IrOp::kNop:
+        case IrOp::kConst:
+        case IrOp::kParam:
+        case IrOp::kPhi:
+        case IrOp::kLoadStatic:
+        case IrOp::kNewObject:
+        case IrOp::kCall:
+        case IrOp::kCallVirtual:
+        case IrOp::kCallBuiltin:
+        case IrOp::kJump:
+            return 0;
+        case IrOp::kNeg:
+        case IrOp::kNot:
+        case IrOp::kConvert:
+        case IrOp::kToString:
+        case IrOp::kLoadField:
+        case IrOp::kNewArray:
+        case IrOp::kArrayLength:
+        case IrOp::kStringLength:
+        case IrOp::kCheckCast:
+        case IrOp::kCallInit:
+        case IrOp::kAwait:
+        case IrOp::kBranch:
+        case IrOp::kReturn:
+        case IrOp::kThrow:
+            return kA;
+        case IrOp::kStoreStatic:
+            return kB;
+        case IrOp::kStoreElem:
+            return kA | kB | kC;
+        default:
+            // binary ops, compares, kStrEq, kConcat, kStoreField, kLoadElem
+            return kA | kB;
+        }
+    }
+
+    IrSpan<ValueId> IrFunction::Operands(const IrInst &inst) const
+    {
+        if (!HasOperandList(inst.op))
+        {
+            return {};
+        }
+        return IrSpan<ValueId>{operands_ + inst.a, inst.b};
+    }
+
+    IrSpan<BlockId> IrFunction::Preds(BlockId b) const
+    {
+        return IrSpan<BlockId>{preds_ + blocks_[b].pred_begin, blocks_[b].pred_count};
+    }
+
+    std::uint32_t IrFunction::Successors(BlockId b, BlockId out[2]) const
+    {
+        const IrInst &term = Terminator(b);
+        if (term.op == IrOp::kJump)
+        {
+            out[0] = term.a;
+            return 1;
+        }
+        if (term.op == IrOp::kBranch)
+        {
+            out[0] = term.b;
+            out[1] = term.c;
+            return 2;
+        }
+        return 0;
+    }
+
+    std::size_t IrModule::NumInsts() const
+    {
+        std::size_t n = 0;
+        for (const auto &fn : functions)
+        {
+            if (fn)
+                n += fn->NumInsts();
+        }
+        return n;
+    }
+
+    // builder
+
+    IrBuilder::IrBuilder(std::string name, IrType return_type, std::vector<IrType> param_types)
+        : name_(std::move(name)), return_type_(return_type), param_types_(std::move(param_types))
+    {
+        BlockId entry = NewBlock();
+        blocks_[entry].sealed = true;
+        SetBlock(entry);
+        for (std::size_t i = 0; i < param_types_.size(); i++)
+        {
+            Emit(IrOp::kParam, param_types_[i], static_cast<ValueId>(i));
+        }
+    }
+
+    IrBuilder::IrBuilder(const IrFunction &fn)
+        : name_(fn.name), return_type_(fn.return_type), param_types_(fn.param_types), method_(fn.method)
+    {
+        insts_.assign(fn.insts_, fn.insts_ + fn.num_insts_);
+        lines_.assign(fn.lines_, fn.lines_ + fn.num_insts_);
+        replaced_.assign(fn.num_insts_, kNoValue);
+        for (ValueId v = 0; v < fn.num_insts_; v++)
+        {
+            IrInst &inst = insts_[v];
+            if (HasOperandList(inst.op))
+            {
+                IrSpan<ValueId> ops = fn.Operands(fn.insts_[v]);
+                lists_.emplace_back(ops.begin(), ops.end());
+                inst.a = static_cast<ValueId>(lists_.size() - 1);
+            }
+        }
+        blocks_.resize(fn.num_blocks_);
+        for (BlockId b = 0; b < fn.num_blocks_; b++)
+        {
+            BuilderBlock &block = blocks_[b];
+            block.sealed = true;
+            for (ValueId v = fn.blocks_[b].begin; v < fn.blocks_[b].end; v++)
+            {
+                (insts_[v].op == IrOp::kPhi ? block.phis : block.insts).push_back(v);
+            }
+            IrSpan<BlockId> preds = fn.Preds(b);
+            block.preds.assign(preds.begin(), preds.end());
+        }
+        for (std::uint32_t i = 0; i < fn.num_strings_; i++)
+        {
+            strings_.emplace_back(fn.strings_[i]);
+        }
+    }
+
+    BlockId IrBuilder::NewBlock()
+    {
+        blocks_.emplace_back();
+        return static_cast<BlockId>(blocks_.size() - 1);
+    }
+
+    void IrBuilder::SetBlock(BlockId b)
+    {
+        current_ = b;
+    }
+
+    bool IrBuilder::IsTerminated() const
+    {
+        const auto &insts = blocks_[current_].insts;
+        return !insts.empty() && IsTerminator(insts_[insts.back()].op);
+    }
+
+    ValueId IrBuilder::Append(BlockId b, const IrInst &inst, bool phi)
+    {
+        ValueId v = static_cast<ValueId>(insts_.size());
+        insts_.push_back(inst);
+        lines_.push_back(line_);
+        replaced_.push_back(kNoValue);
+        (phi ? blocks_[b].phis : blocks_[b].insts).push_back(v);
+        return v;
+    }
+
+    ValueId IrBuilder::Emit(IrOp op, IrType type, ValueId a, ValueId b, ValueId c, std::uint16_t aux)
+    {
+        if (IsTerminated())
+        {
+            // code after a return, break or throw: give it a block of its own
+            // that nothing jumps to, and Finalize() drops it.
+            BlockId dead = NewBlock();
+            blocks_[dead].sealed = true;
+            SetBlock(dead);
+        }
+        IrInst inst;
+        inst.op = op;
+        inst.type = type;
+        inst.aux = aux;
+        inst.a = a;
+        inst.b = b;
+        inst.c = c;
+        return Append(current_, inst, false);
+    }
+
+    ValueId IrBuilder::EmitList(IrOp op, IrType type, const std::vector<ValueId> &operands, std::uint32_t c, std::uint16_t aux)
+    {
+        lists_.push_back(operands);
+        return Emit(op, type, static_cast<ValueId>(lists_.size() - 1), static_cast<ValueId>(operands.size()), c, aux);
+    }
+
+    ValueId IrBuilder::ConstInt(IrType type, std::int64_t value)
+    {
+        ValueId v = Emit(IrOp::kConst, type);
+        insts_[v].SetImm(value);
+        return v;
+    }
+
+    ValueId IrBuilder::ConstFloat(IrType type, double value)
+    {
+        ValueId v = Emit(IrOp::kConst, type);
+        insts_[v].SetFloatImm(value);
+        return v;
+    }
+
+    std::uint32_t IrBuilder::InternString(std::string_view s)
+    {
+        std::uint32_t index = 0;
+        while (index < strings_.size() && strings_[index] != s)
+        {
+            index++;
+        }
+        if (index == strings_.size())
+        {
+            strings_.emplace_back(s);
+        }
+        return index;
+    }
+
+    ValueId IrBuilder::ConstString(std::string_view s)
+    {
+        return Emit(IrOp::kConst, IrType::kRef, InternString(s), kNoValue, kNoValue, 1);
+    }
+
+    ValueId IrBuilder::Insert(BlockId b, const IrInst &inst, int line, const std::vector<ValueId> *list)
+    {
+        IrInst copy = inst;
+        if (list)
+        {
+            lists_.push_back(*list);
+            copy.a = static_cast<ValueId>(lists_.size() - 1);
+            copy.b = static_cast<ValueId>(list->size());
+        }
+        int saved = line_;
+        line_ = line;
+        ValueId v = Append(b, copy, false);
+        line_ = saved;
+        return v;
+    }
+
+    ValueId IrBuilder::InsertPhi(BlockId b, IrType type, std::vector<ValueId> operands)
+    {
+        IrInst phi;
+        phi.op = IrOp::kPhi;
+        phi.type = type;
+        phi.b = static_cast<ValueId>(operands.size());
+        lists_.push_back(std::move(operands));
+        phi.a = static_cast<ValueId>(lists_.size() - 1);
+        return Append(b, phi, true);
+    }
+
+    std::uint32_t IrBuilder::Successors(BlockId b, BlockId out[2]) const
+    {
+        const auto &insts = blocks_[b].insts;
+        if (insts.empty())
+        {
+            return 0;
+        }
+        const IrInst &term = insts_[insts.back()];
+        if (term.op == IrOp::kJump)
+        {
+            out[0] = term.a;
+            return 1;
+        }
+        if (term.op == IrOp::kBranch)
+        {
+            out[0] = term.b;
+            out[1] = term.c;
+            return 2;
+        }
+        return 0;
+    }
+
+    void IrBuilder::RemoveEdge(BlockId from, BlockId to)
+    {
+        auto &preds = blocks_[to].preds;
+        for (std::size_t i = 0; i < preds.size(); i++)
+        {
+            if (preds[i] != from)
+                continue;
+            preds.erase(preds.begin() + static_cast<std::ptrdiff_t>(i));
+            for (ValueId phi : blocks_[to].phis)
+            {
+                if (insts_[phi].op != IrOp::kPhi)
+                    continue;
+                auto &list = lists_[insts_[phi].a];
+                list.erase(list.begin() + static_cast<std::ptrdiff_t>(i));
+                insts_[phi].b = static_cast<ValueId>(list.size());
+            }
+            return;
+        }
+    }
+
+    ValueId IrBuilder::ConstNull()
+    {
+        return Emit(IrOp::kConst, IrType::kRef, kNoValue, kNoValue, kNoValue, 0);
+    }
+
+    void IrBuilder::AddEdge(BlockId from, BlockId to)
+    {
+        blocks_[to].preds.push_back(from);
+    }
+
+    void IrBuilder::Jump(BlockId target)
+    {
+        Emit(IrOp::kJump, IrType::kVoid, target);
+        AddEdge(current_, target);
+    }
+
+    void IrBuilder::Branch(ValueId cond, BlockId if_true, BlockId if_false)
+    {
+        Emit(IrOp::kBranch, IrType::kVoid, cond, if_true, if_false);
+        AddEdge(current_, if_true);
+        AddEdge(current_, if_false);
+    }
+
+    void IrBuilder::Return(ValueId value)
+    {
+        Emit(IrOp::kReturn, IrType::kVoid, value);
+    }
+
+    // SSA construction
+
+    std::uint32_t IrBuilder::NewVariable(IrType type)
+    {
+        var_types_.push_back(type);
+        defs_.emplace_back();
+        return static_cast<std::uint32_t>(var_types_.size() - 1);
+    }
+
+    void IrBuilder::WriteVariable(std::uint32_t var, ValueId value)
+    {
+        auto &defs = defs_[var];
+        if (defs.size() <= current_)
+        {
+            defs.resize(blocks_.size(), kNoValue);
+        }
+        defs[current_] = value;
+    }
+
+    ValueId IrBuilder::ReadVariable(std::uint32_t var)
+    {
+        return ReadVariableIn(var, current_);
+    }
+
+    ValueId IrBuilder::ReadVariableIn(std::uint32_t var, BlockId b)
+    {
+        auto &defs = defs_[var];
+        if (b < defs.size() && defs[b] != kNoValue)
+        {
+            return Resolve(defs[b]);
+        }
+        BuilderBlock &block = blocks_[b];
+        IrType type = var_types_[var];
+        ValueId value;
+        if (!block.sealed)
+        {
+            IrInst phi;
+            phi.op = IrOp::kPhi;
+            phi.type = type;
+            lists_.emplace_back();
+            phi.a = static_cast<ValueId>(lists_.size() - 1);
+            value = Append(b, phi, true);
+            block.incomplete_phis.emplace_back(var, value);
+        }
+        else if (block.preds.size() == 1)
+        {
+            value = ReadVariableIn(var, block.preds[0]);
+        }
+        else if (block.preds.empty())
+        {
+            // read before any write (entry block) or in unreachable code.
+            IrInst zero;
+            zero.op = IrOp::kConst;
+            zero.type = type;
+            zero.aux = 0;
+            zero.SetImm(0);
+            value = Append(0, zero, false);
+            auto &entry = blocks_[0].insts;
+            entry.insert(entry.begin(), entry.back());
+            entry.pop_back();
+        }
+        else
+        {
+            IrInst phi;
+            phi.op = IrOp::kPhi;
+            phi.type = type;
+            lists_.emplace_back();
+            phi.a = static_cast<ValueId>(lists_.size() - 1);
+            value = Append(b, phi, true);
+            // record the phi first so loops that reach back here stop at it.
+            if (defs.size() <= b)
+                defs.resize(blocks_.size(), kNoValue);
+            defs[b] = value;
+            AddPhiOperands(var, value, b);
+            value = Resolve(value);
+        }
+        if (defs_[var].size() <= b)
+        {
+            defs_[var].resize(blocks_.size(), kNoValue);
+        }
+        defs_[var][b] = value;
+        return value;
+    }
+
+    void IrBuilder::AddPhiOperands(std::uint32_t var, ValueId phi, BlockId b)
+    {
+        std::vector<ValueId> operands;
+        for (BlockId pred : blocks_[b].preds)
+        {
+            operands.push_back(ReadVariableIn(var, pred));
+        }
+        insts_[phi].b = static_cast<ValueId>(operands.size());
+        lists_[insts_[phi].a] = std::move(operands);
+
+        // a phi whose operands are all one value (or itself) is that value.
+        ValueId same = kNoValue;
+        for (ValueId op : lists_[insts_[phi].a])
+        {
+            op = Resolve(op);
+            if (op == same || op == phi)
+                continue;
+            if (same != kNoValue)
+                return;
+            same = op;
+        }
+        if (same != kNoValue)
+        {
+            Replace(phi, same);
+        }
+    }
+
+    void IrBuilder::SealBlock(BlockId b)
+    {
+        BuilderBlock &block = blocks_[b];
+        if (block.sealed)
+        {
+            return;
+        }
+        block.sealed = true;
+        auto incomplete = std::move(block.incomplete_phis);
+        for (auto [var, phi] : incomplete)
+        {
+            AddPhiOperands(var, phi, b);
+        }
+    }
+
+    void IrBuilder::Replace(ValueId v, ValueId replacement)
+    {
+        replaced_[v] = replacement;
+        if (insts_[v].op == IrOp::kPhi)
+        {
+            insts_[v].op = IrOp::kNop;
+        }
+    }
+
+    ValueId IrBuilder::Resolve(ValueId v) const
+    {
+        while (v != kNoValue && v < replaced_.size() && replaced_[v] != kNoValue)
+        {
+            v = replaced_[v];
+        }
+        return v;
+    }
+
+    std::unique_ptr<IrFunction> IrBuilder::Finalize()
+    {
+        const std::uint32_t num_blocks = static_cast<std::uint32_t>(blocks_.size());
+
+        // falling off the end of a block only happens at the end of a void
+        // method (the checker rejects it elsewhere); make the return explicit.
+        for (BlockId b = 0; b < num_blocks; b++)
+        {
+            if (blocks_[b].insts.empty() || !IsTerminator(insts_[blocks_[b].insts.back()].op))
+            {
+                BlockId saved = current_;
+                current_ = b;
+                ValueId value = kNoValue;
+                if (return_type_ != IrType::kVoid)
+                    value = return_type_ == IrType::kRef ? ConstNull() : ConstInt(return_type_, 0);
+                Return(value);
+                current_ = saved;
+            }
+        }
+
+        // blocks reachable from the entry, laid out in reverse post-order so
+        // a block's dominators come before it and fall-through paths stay
+        // close. successors are visited last-first, which puts the true side
+        // of a branch before the false side.
+        std::vector<BlockId> new_block(num_blocks, kNoValue);
+        std::vector<bool> reachable(num_blocks, false);
+        std::vector<BlockId> post;
+        {
+            std::vector<std::pair<BlockId, std::uint32_t>> stack{{0, 0}};
+            reachable[0] = true;
+            while (!stack.empty())
+            {
+                auto &[b, next] = stack.back();
+                BlockId succ[2];
+                std::uint32_t n = Successors(b, succ);
+                if (next < n)
+                {
+                    BlockId s = succ[n - 1 - next++];
+                    if (!reachable[s])
+                    {
+                        reachable[s] = true;
+                        stack.emplace_back(s, 0);
+                    }
+                    continue;
+                }
+                post.push_back(b);
+                stack.pop_back();
+            }
+        }
+        std::vector<BlockId> layout(post.rbegin(), post.rend());
+        const std::uint32_t live_blocks = static_cast<std::uint32_t>(layout.size());
+        for (std::uint32_t i = 0; i < live_blocks; i++)
+        {
+            new_block[layout[i]] = i;
+        }
+
+        // phi operands coming from unreachable predecessors go away with them.
+        for (BlockId b = 0; b < num_blocks; b++)
+        {
+            if (!reachable[b])
+                continue;
+            BuilderBlock &block = blocks_[b];
+            std::vector<bool> keep(block.preds.size());
+            std::vector<BlockId> preds;
+            for (std::size_t i = 0; i < block.preds.size(); i++)
+            {
+                keep[i] = reachable[block.preds[i]];
+                if (keep[i])
+                    preds.push_back(block.preds[i]);
+            }
+            if (preds.size() == block.preds.size())
+                continue;
+            for (ValueId phi : block.phis)
+            {
+                if (insts_[phi].op != IrOp::kPhi)
+                    continue;
+                auto &list = lists_[insts_[phi].a];
+                std::vector<ValueId> kept;
+                for (std::size_t i = 0; i < list.size(); i++)
+                {
+                    if (keep[i])
+                        kept.push_back(list[i]);
+                }
+                list = std::move(kept);
+                insts_[phi].b = static_cast<ValueId>(list.size());
+            }
+            block.preds = std::move(preds);
+        }
+
+        // remove phis that became trivial, until none are left.
+        for (bool changed = true; changed;)
+        {
+            changed = false;
+            for (BlockId b = 0; b < num_blocks; b++)
+            {
+                if (!reachable[b])
+                    continue;
+                for (ValueId phi : blocks_[b].phis)
+                {
+                    if (insts_[phi].op != IrOp::kPhi)
+                        continue;
+                    ValueId same = kNoValue;
+                    bool trivial = true;
+                    for (ValueId op : lists_[insts_[phi].a])
+                    {
+                        op = Resolve(op);
+                        if (op == same || op == phi)
+                            continue;
+                        if (same != kNoValue)
+                        {
+                            trivial = false;
+                            break;
+                        }
+                        same = op;
+                    }
+                    if (trivial && same != kNoValue)
+                    {
+                        Replace(phi, same);
+                        changed = true;
+                    }
+                }
+            }
+        }
+
+        // lay the blocks out: phis, then the rest, in block order.
+        std::vector<ValueId> new_id(insts_.size(), kNoValue);
+        std::uint32_t num_insts = 0, num_operands = 0, num_preds = 0;
+        for (BlockId b : layout)
+        {
+            for (const auto *list : {&blocks_[b].phis, &blocks_[b].insts})
+            {
+                for (ValueId v : *list)
+                {
+                    if (insts_[v].op == IrOp::kNop)
+                        continue;
+                    new_id[v] = num_insts++;
+                    if (HasOperandList(insts_[v].op))
+                        num_operands += static_cast<std::uint32_t>(lists_[insts_[v].a].size());
+                }
+            }
+            num_preds += static_cast<std::uint32_t>(blocks_[b].preds.size());
+        }
+
+        auto fn = std::make_unique<IrFunction>();
+        fn->name = name_;
+        fn->method = method_;
+        fn->return_type = return_type_;
+        fn->param_types = param_types_;
+        fn->num_insts_ = num_insts;
+        fn->num_blocks_ = live_blocks;
+        fn->num_operands_ = num_operands;
+        fn->num_preds_ = num_preds;
+        fn->insts_ = fn->arena_.NewArray<IrInst>(num_insts);
+        fn->lines_ = fn->arena_.NewArray<int>(num_insts);
+        fn->blocks_ = fn->arena_.NewArray<IrBlock>(live_blocks);
+        fn->operands_ = fn->arena_.NewArray<ValueId>(num_operands);
+        fn->preds_ = fn->arena_.NewArray<BlockId>(num_preds);
+        fn->num_strings_ = static_cast<std::uint32_t>(strings_.size());
+        fn->strings_ = fn->arena_.NewArray<std::string_view>(strings_.size());
+        for (std::size_t i = 0; i < strings_.size(); i++)
+        {
+            fn->strings_[i] = fn->arena_.CopyString(strings_[i]);
+        }
+
+        auto map = [&](ValueId v) { return v == kNoValue ? kNoValue : new_id[Resolve(v)]; };
+        std::uint32_t at = 0, operand_at = 0, pred_at = 0;
+        for (BlockId b : layout)
+        {
+            IrBlock &out = fn->blocks_[new_block[b]];
+            out.begin = at;
+            out.pred_begin = pred_at;
+            out.pred_count = static_cast<std::uint32_t>(blocks_[b].preds.size());
+            for (BlockId pred : blocks_[b].preds)
+            {
+                fn->preds_[pred_at++] = new_block[pred];
+            }
+            for (const auto *list : {&blocks_[b].phis, &blocks_[b].insts})
+            {
+                for (ValueId v : *list)
+                {
+                    IrInst inst = insts_[v];
+                    if (inst.op == IrOp::kNop)
+                        continue;
+                    if (HasOperandList(inst.op))
+                    {
+                        const auto &ops = lists_[inst.a];
+                        inst.a = operand_at;
+                        inst.b = static_cast<ValueId>(ops.size());
+                        for (ValueId op : ops)
+                        {
+                            fn->operands_[operand_at++] = map(op);
+                        }
+                    }
+                    std::uint8_t mask = ValueOperandMask(inst.op);
+                    if (mask & 1)
+                        inst.a = map(inst.a);
+                    if (mask & 2)
+                        inst.b = map(inst.b);
+                    if (mask & 4)
+                        inst.c = map(inst.c);
+                    if (inst.op == IrOp::kJump)
+                        inst.a = new_block[inst.a];
+                    else if (inst.op == IrOp::kBranch)
+                    {
+                        inst.b = new_block[inst.b];
+                        inst.c = new_block[inst.c];
+                    }
+                    fn->lines_[at] = lines_[v];
+                    fn->insts_[at++] = inst;
+                }
+            }
+            out.end = at;
+        }
+        return fn;
+    }
+
+    // printing and verification
+
+    namespace
+    {
+        void PrintValue(std::ostream &out, ValueId v)
+        {
+            if (v == kNoValue)
+                out << "_";
+            else
+                out << "v" << v;
+        }
+
+        void PrintInst(std::ostream &out, const IrFunction &fn, ValueId v)
+        {
+            const IrInst &inst = fn.Inst(v);
+            out << "  ";
+            if (inst.type != IrType::kVoid)
+            {
+                out << "v" << v << " = ";
+            }
+            out << IrOpToString(inst.op);
+            if (inst.type != IrType::kVoid)
+            {
+                out << " " << IrTypeToString(inst.type);
+            }
+            switch (inst.op)
+            {
+            case IrOp::kConst:
+                if (inst.type == IrType::kRef)
+                {
+                    if (inst.aux == 1)
+                    {
+                        out << " \"";
+                        for (char c : fn.String(inst.a))
+                        {
+                            if (c == '\n')
+                                out << "\\n";
+                            else if (c == '"' || c == '\\')
+                                out << '\\' << c;
+                            else
+                                out << c;
+                        }
+                        out << "\"";
+                    }
+                    else
+                        out << " null";
+                }
+                else if (IsFloatIrType(inst.type))
+                    out << " " << inst.FloatImm();
+                else
+                    out << " " << inst.Imm();
+                return;
+            case IrOp::kParam:
+                out << " " << inst.a;
+                return;
+            case IrOp::kPhi:
+            {
+                IrSpan<ValueId> ops = fn.Operands(inst);
+                BlockId block = 0;
+                while (!(fn.Block(block).begin <= v && v < fn.Block(block).end))
+                    block++;
+                IrSpan<BlockId> preds = fn.Preds(block);
+                for (std::size_t i = 0; i < ops.size(); i++)
+                {
+                    out << (i ? ", [" : " [");
+                    PrintValue(out, ops[i]);
+                    out << ", b" << (i < preds.size() ? preds[i] : 0) << "]";
+                }
+                return;
+            }
+            case IrOp::kJump:
+                out << " b" << inst.a;
+                return;
+            case IrOp::kBranch:
+                out << " ";
+                PrintValue(out, inst.a);
+                out << ", b" << inst.b << ", b" << inst.c;
+                return;
+            case IrOp::kCall:
+            case IrOp::kCallVirtual:
+            case IrOp::kCallBuiltin:
+            {
+                if (inst.op == IrOp::kCallBuiltin)
+                    out << " " << BuiltinToString(static_cast<Builtin>(inst.c));
+                else
+                    out << " #" << inst.c;
+                out << "(";
+                IrSpan<ValueId> ops = fn.Operands(inst);
+                for (std::size_t i = 0; i < ops.size(); i++)
+                {
+                    if (i)
+                        out << ", ";
+                    PrintValue(out, ops[i]);
+                }
+                out << ")";
+                return;
+            }
+            default:
+                break;
+            }
+            std::uint8_t mask = ValueOperandMask(inst.op);
+            const char *sep = " ";
+            const ValueId fields[3] = {inst.a, inst.b, inst.c};
+            for (int i = 0; i < 3; i++)
+            {
+                if ((mask & (1 << i)) && fields[i] != kNoValue)
+                {
+                    out << sep;
+                    PrintValue(out, fields[i]);
+                    sep = ", ";
+                }
+            }
+            switch (inst.op)
+            {
+            case IrOp::kLoadField:
+            case IrOp::kStoreField:
+            case IrOp::kLoadStatic:
+            case IrOp::kStoreStatic:
+                out << sep << "slot " << inst.c;
+                break;
+            case IrOp::kNewObject:
+            case IrOp::kCheckCast:
+            case IrOp::kCallInit:
+                out << sep << "class #" << inst.c;
+                break;
+            case IrOp::kConvert:
+            case IrOp::kToString:
+            case IrOp::kNewArray:
+                out << sep << "from " << IrTypeToString(static_cast<IrType>(inst.aux));
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    void PrintIr(std::ostream &out, const IrFunction &fn)
+    {
+        out << "function " << fn.name << " : (";
+        for (std::size_t i = 0; i < fn.param_types.size(); i++)
+        {
+            out << (i ? ", " : "") << IrTypeToString(fn.param_types[i]);
+        }
+        out << ") -> " << IrTypeToString(fn.return_type) << "\n";
+        for (BlockId b = 0; b < fn.NumBlocks(); b++)
+        {
+            out << "b" << b << ":";
+            IrSpan<BlockId> preds = fn.Preds(b);
+            if (!preds.empty())
+            {
+                out << " ; preds";
+                for (BlockId p : preds)
+                    out << " b" << p;
+            }
+            out << "\n";
+            for (ValueId v = fn.Block(b).begin; v < fn.Block(b).end; v++)
+            {
+                PrintInst(out, fn, v);
+                out << "\n";
+            }
+        }
+    }
+
+    void PrintIr(std::ostream &out, const IrModule &module)
+    {
+        for (const auto &fn : module.functions)
+        {
+            if (fn)
+            {
+                PrintIr(out, *fn);
+                out << "\n";
+            }
+        }
+    }
+
+    std::string VerifyIr(const IrFunction &fn)
+    {
+        std::ostringstream err;
+        auto fail = [&](ValueId v, const std::string &what)
+        {
+            err << fn.name << ": v" << v << ": " << what;
+            return err.str();
+        };
+        auto check_value = [&](ValueId v, ValueId use) -> bool
+        {
+            return v < fn.NumInsts() && fn.Inst(v).type != IrType::kVoid && v != use;
+        };
+        if (fn.NumBlocks() == 0)
+        {
+            return fn.name + ": no blocks";
+        }
+        std::vector<BlockId> block_of(fn.NumInsts(), kNoValue);
+        for (BlockId b = 0; b < fn.NumBlocks(); b++)
+        {
+            for (ValueId v = fn.Block(b).begin; v < fn.Block(b).end; v++)
+                block_of[v] = b;
+        }
+        for (BlockId b = 0; b < fn.NumBlocks(); b++)
+        {
+            const IrBlock &block = fn.Block(b);
+            if (block.begin >= block.end)
+            {
+                return fn.name + ": b" + std::to_string(b) + " is empty";
+            }
+            if (b > 0 && block.begin != fn.Block(b - 1).end)
+            {
+                return fn.name + ": b" + std::to_string(b) + " does not follow its predecessor in layout";
+            }
+            bool in_phis = true;
+            for (ValueId v = block.begin; v < block.end; v++)
+            {
+                const IrInst &inst = fn.Inst(v);
+                if (inst.op == IrOp::kPhi)
+                {
+                    if (!in_phis)
+                        return fail(v, "phi after a non-phi instruction");
+                    if (inst.b != block.pred_count)
+                        return fail(v, "phi has " + std::to_string(inst.b) + " operands for " +
+                                           std::to_string(block.pred_count) + " predecessors");
+                    for (ValueId op : fn.Operands(inst))
+                    {
+                        if (op >= fn.NumInsts() || fn.Inst(op).type == IrType::kVoid)
+                            return fail(v, "bad phi operand");
+                    }
+                    continue;
+                }
+                in_phis = false;
+                if (IsTerminator(inst.op) != (v == block.end - 1))
+                {
+                    return fail(v, IsTerminator(inst.op) ? "terminator in the middle of a block" : "block does not end in a terminator");
+                }
+                std::vector<ValueId> uses;
+                if (HasOperandList(inst.op))
+                {
+                    for (ValueId op : fn.Operands(inst))
+                        uses.push_back(op);
+                }
+                std::uint8_t mask = ValueOperandMask(inst.op);
+                const ValueId fields[3] = {inst.a, inst.b, inst.c};
+                for (int i = 0; i < 3; i++)
+                {
+                    if ((mask & (1 << i)) && fields[i] != kNoValue)
+                        uses.push_back(fields[i]);
+                }
+                for (ValueId use : uses)
+                {
+                    if (!check_value(use, v))
+                        return fail(v, "bad operand v" + std::to_string(use));
+                    if (block_of[use] == b && use > v)
+                        return fail(v, "use of v" + std::to_string(use) + " before its definition");
+                }
+                if (inst.op == IrOp::kJump && inst.a >= fn.NumBlocks())
+                    return fail(v, "jump to a missing block");
+                if (inst.op == IrOp::kBranch && (inst.b >= fn.NumBlocks() || inst.c >= fn.NumBlocks()))
+                    return fail(v, "branch to a missing block");
+            }
+            for (BlockId pred : fn.Preds(b))
+            {
+                BlockId succ[2];
+                std::uint32_t n = fn.Successors(pred, succ);
+                bool found = false;
+                for (std::uint32_t i = 0; i < n; i++)
+                    found = found || succ[i] == b;
+                if (!found)
+                    return fn.name + ": b" + std::to_string(pred) + " is listed as a predecessor of b" + std::to_string(b) +
+                           " but does not branch to it";
+            }
+        }
+        return std::string();
+    }
+
+}
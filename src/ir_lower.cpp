@@ -0,0 +1,1064 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include "const_eval.h"
+#include "ir.h"
+#include "sema.h"
+#include "thread_pool.h"
+#include "visitor.h"
+#include <algorithm>
+#include <unordered_map>
+
+namespace tinycsharp
+{
+    namespace
+    {
+        // what lowering needs to know about the module while functions are
+        // lowered concurrently; fixed before the first one starts.
+        struct ModuleLayout
+        {
+            const GlobalSymbols &globals;
+            const std::vector<std::int32_t> &instance_init;
+        };
+
+        // the nearest parameterless constructor up the class chain: the one
+        // 'new' or a derived constructor runs implicitly.
+        const MethodInfo *DefaultCtor(const ClassInfo *cls)
+        {
+            for (; cls; cls = cls->base)
+            {
+                for (const MethodInfo *ctor : cls->ctors)
+                {
+                    if (!ctor->is_static && ctor->param_types.empty())
+                        return ctor;
+                }
+                if (!cls->ctors.empty())
+                    return nullptr;
+            }
+            return nullptr;
+        }
+
+        // lowers one method body (or a synthesized initializer) to SSA.
+        // every expression yields a value of the IR type of its checked type.
+        class IrLowering : public AstVisitor<IrLowering, ValueId>
+        {
+        public:
+            IrLowering(const ModuleLayout &layout, ClassInfo *owner, const MethodInfo *method, std::string name,
+                       IrType return_type, std::vector<IrType> params)
+                : layout_(layout), types_(layout.globals.types()), owner_(owner), method_(method),
+                  builder_(std::move(name), return_type, std::move(params))
+            {
+                builder_.SetMethod(method);
+                is_static_ = method ? method->is_static : true;
+                std::uint32_t first = is_static_ ? 0 : 1;
+                if (method)
+                {
+                    for (std::size_t i = 0; i < method->param_types.size(); i++)
+                    {
+                        std::uint32_t var = builder_.NewVariable(IrTypeOf(method->param_types[i]));
+                        builder_.WriteVariable(var, first + static_cast<ValueId>(i));
+                        param_vars_.push_back(var);
+                    }
+                }
+            }
+
+            std::unique_ptr<IrFunction> LowerMethod()
+            {
+                const MethodInfo *m = method_;
+                if (m->is_ctor && !m->is_static && owner_->base)
+                {
+                    if (const MethodInfo *base = DefaultCtor(owner_->base))
+                        builder_.EmitList(IrOp::kCall, IrType::kVoid, {This()}, base->id);
+                }
+                Statement(m->decl->body);
+                if (!builder_.IsTerminated())
+                {
+                    builder_.SetLine(Line(m->decl));
+                    ReturnFromMethod(kNoValue);
+                }
+                return builder_.Finalize();
+            }
+
+            // C.<init>: the instance field initializers of cls and its bases,
+            // bases first.
+            std::unique_ptr<IrFunction> LowerInstanceInit(ClassInfo *cls)
+            {
+                std::vector<ClassInfo *> chain;
+                for (ClassInfo *c = cls; c; c = c->base)
+                    chain.push_back(c);
+                for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+                {
+                    owner_ = *it;
+                    for (FieldInfo *field : (*it)->fields)
+                    {
+                        if (field->is_static || field->is_const || !field->decl->init)
+                            continue;
+                        builder_.SetLine(Line(field->decl));
+                        ValueId value = Coerce(Lower(field->decl->init), field->decl->init->type, field->type);
+                        builder_.Emit(IrOp::kStoreField, IrType::kVoid, This(), value, field->slot);
+                    }
+                }
+                builder_.Return(kNoValue);
+                return builder_.Finalize();
+            }
+
+            // <static-init>: every static field initializer, then the class's
+            // static constructor, class by class in declaration order.
+            std::unique_ptr<IrFunction> LowerStaticInit()
+            {
+                for (ClassInfo *cls : layout_.globals.classes())
+                {
+                    owner_ = cls;
+                    for (FieldInfo *field : cls->fields)
+                    {
+                        if (!field->is_static || field->is_const || !field->decl->init)
+                            continue;
+                        builder_.SetLine(Line(field->decl));
+                        ValueId value = Coerce(Lower(field->decl->init), field->decl->init->type, field->type);
+                        builder_.Emit(IrOp::kStoreStatic, IrType::kVoid, kNoValue, value, field->slot);
+                    }
+                    for (MethodInfo *ctor : cls->ctors)
+                    {
+                        if (ctor->is_static && ctor->decl->body)
+                            builder_.EmitList(IrOp::kCall, IrType::kVoid, {}, ctor->id);
+                    }
+                }
+                builder_.Return(kNoValue);
+                return builder_.Finalize();
+            }
+
+            // statements
+
+            ValueId VisitBlockStmt(BlockStmt *block)
+            {
+                for (Node *stmt : block->stmts)
+                {
+                    Statement(stmt);
+                }
+                return kNoValue;
+            }
+
+            ValueId VisitLocalVarStmt(LocalVarStmt *local)
+            {
+                std::uint32_t var = builder_.NewVariable(IrTypeOf(local->resolved_type));
+                locals_[local] = var;
+                if (local->init)
+                {
+                    builder_.WriteVariable(var, Coerce(Lower(local->init), local->init->type, local->resolved_type));
+                }
+                return kNoValue;
+            }
+
+            ValueId VisitExprStmt(ExprStmt *stmt)
+            {
+                Lower(stmt->expr);
+                return kNoValue;
+            }
+
+            ValueId VisitIfStmt(IfStmt *stmt)
+            {
+                BlockId then_block = builder_.NewBlock();
+                BlockId join = builder_.NewBlock();
+                BlockId else_block = stmt->else_stmt ? builder_.NewBlock() : join;
+                Condition(stmt->cond, then_block, else_block);
+                builder_.SealBlock(then_block);
+                builder_.SetBlock(then_block);
+                Statement(stmt->then_stmt);
+                JumpIfOpen(join);
+                if (stmt->else_stmt)
+                {
+                    builder_.SealBlock(else_block);
+                    builder_.SetBlock(else_block);
+                    Statement(stmt->else_stmt);
+                    JumpIfOpen(join);
+                }
+                builder_.SealBlock(join);
+                builder_.SetBlock(join);
+                return kNoValue;
+            }
+
+            ValueId VisitWhileStmt(WhileStmt *stmt)
+            {
+                BlockId header = builder_.NewBlock();
+                BlockId body = builder_.NewBlock();
+                BlockId exit = builder_.NewBlock();
+                builder_.Jump(header);
+                builder_.SetBlock(header);
+                Condition(stmt->cond, body, exit);
+                builder_.SealBlock(body);
+                builder_.SetBlock(body);
+                loops_.push_back(Loop{exit, header});
+                Statement(stmt->body);
+                loops_.pop_back();
+                JumpIfOpen(header);
+                builder_.SealBlock(header);
+                builder_.SealBlock(exit);
+                builder_.SetBlock(exit);
+                return kNoValue;
+            }
+
+            ValueId VisitDoWhileStmt(DoWhileStmt *stmt)
+            {
+                BlockId body = builder_.NewBlock();
+                BlockId cond = builder_.NewBlock();
+                BlockId exit = builder_.NewBlock();
+                builder_.Jump(body);
+                builder_.SetBlock(body);
+                loops_.push_back(Loop{exit, cond});
+                Statement(stmt->body);
+                loops_.pop_back();
+                JumpIfOpen(cond);
+                builder_.SealBlock(cond);
+                builder_.SetBlock(cond);
+                Condition(stmt->cond, body, exit);
+                builder_.SealBlock(body);
+                builder_.SealBlock(exit);
+                builder_.SetBlock(exit);
+                return kNoValue;
+            }
+
+            ValueId VisitReturnStmt(ReturnStmt *stmt)
+            {
+                ValueId value = kNoValue;
+                if (stmt->value)
+                {
+                    const Type *to = method_->return_type;
+                    if (method_->is_async && to->kind == TypeKind::kTask)
+                        to = to->element;
+                    value = Coerce(Lower(stmt->value), stmt->value->type, to);
+                }
+                ReturnFromMethod(value);
+                return kNoValue;
+            }
+
+            ValueId VisitBreakStmt(BreakStmt *)
+            {
+                builder_.Jump(loops_.back().break_target);
+                return kNoValue;
+            }
+
+            ValueId VisitContinueStmt(ContinueStmt *)
+            {
+                builder_.Jump(loops_.back().continue_target);
+                return kNoValue;
+            }
+
+            ValueId VisitThrowStmt(ThrowStmt *stmt)
+            {
+                ValueId value = stmt->value ? Lower(stmt->value) : builder_.ConstNull();
+                builder_.Emit(IrOp::kThrow, IrType::kVoid, value);
+                return kNoValue;
+            }
+
+            // expressions
+
+            ValueId VisitLiteralExpr(LiteralExpr *lit)
+            {
+                switch (lit->literal_kind)
+                {
+                case LiteralKind::kInt:
+                    return builder_.ConstInt(IrTypeOf(lit->type), lit->int_value);
+                case LiteralKind::kFloat:
+                    return builder_.ConstFloat(IrType::kF64, lit->float_value);
+                case LiteralKind::kString:
+                    return builder_.ConstString(lit->string_value);
+                case LiteralKind::kBool:
+                    return builder_.ConstInt(IrType::kBool, lit->bool_value);
+                }
+                return kNoValue;
+            }
+
+            ValueId VisitNameExpr(NameExpr *name)
+            {
+                if (auto *param = NodeCast<ParamDecl>(name->decl))
+                {
+                    return builder_.ReadVariable(param_vars_[param->index]);
+                }
+                if (auto *local = NodeCast<LocalVarStmt>(name->decl))
+                {
+                    return builder_.ReadVariable(locals_.at(local));
+                }
+                if (auto *field = NodeCast<FieldDecl>(name->decl))
+                {
+                    return LoadField(field->info, kNoValue);
+                }
+                return builder_.ConstNull();
+            }
+
+            ValueId VisitMemberExpr(MemberExpr *member)
+            {
+                switch (static_cast<Builtin>(member->builtin))
+                {
+                case Builtin::kStringLength:
+                    return builder_.Emit(IrOp::kStringLength, IrType::kI32, Lower(member->object));
+                case Builtin::kArrayLength:
+                    return builder_.Emit(IrOp::kArrayLength, IrType::kI32, Lower(member->object));
+                case Builtin::kIntMaxValue:
+                    return builder_.ConstInt(IrType::kI32, INT32_MAX);
+                case Builtin::kIntMinValue:
+                    return builder_.ConstInt(IrType::kI32, INT32_MIN);
+                case Builtin::kLongMaxValue:
+                    return builder_.ConstInt(IrType::kI64, INT64_MAX);
+                case Builtin::kLongMinValue:
+                    return builder_.ConstInt(IrType::kI64, INT64_MIN);
+                case Builtin::kTaskCompleted:
+                    return builder_.EmitList(IrOp::kCallBuiltin, IrType::kRef, {}, static_cast<std::uint32_t>(Builtin::kTaskCompleted));
+                default:
+                    break;
+                }
+                if (member->field)
+                {
+                    FieldInfo *field = member->field;
+                    bool instance = !field->is_static && !field->is_const;
+                    return LoadField(field, instance ? Lower(member->object) : kNoValue);
+                }
+                // a library member the compiler knows nothing about.
+                return builder_.EmitList(IrOp::kCallBuiltin, IrType::kRef, {builder_.ConstString(LibraryName(member))},
+                                         static_cast<std::uint32_t>(Builtin::kNone));
+            }
+
+            ValueId VisitCallExpr(CallExpr *call)
+            {
+                Builtin builtin = static_cast<Builtin>(call->builtin);
+                if (builtin != Builtin::kNone || !call->target)
+                {
+                    return CallBuiltin(call, builtin);
+                }
+                const MethodInfo *target = call->target;
+                std::vector<ValueId> args;
+                // the receiver's static class, for devirtualization.
+                const ClassInfo *receiver = nullptr;
+                if (!target->is_static)
+                {
+                    auto *member = NodeCast<MemberExpr>(call->callee);
+                    args.push_back(member ? Lower(member->object) : This());
+                    receiver = owner_;
+                    if (member)
+                        receiver = member->object->type && member->object->type->kind == TypeKind::kClass ? member->object->type->cls : nullptr;
+                }
+                for (std::size_t i = 0; i < call->args.size(); i++)
+                {
+                    args.push_back(Coerce(Lower(call->args[i]), call->args[i]->type, target->param_types[i]));
+                }
+                builder_.SetLine(Line(call));
+                if (!target->is_virtual)
+                    return builder_.EmitList(IrOp::kCall, IrTypeOf(target->return_type), args, target->id);
+                std::uint16_t aux = receiver && receiver->id < 0xffff ? static_cast<std::uint16_t>(receiver->id + 1) : 0;
+                return builder_.EmitList(IrOp::kCallVirtual, IrTypeOf(target->return_type), args, target->id, aux);
+            }
+
+            ValueId VisitIndexExpr(IndexExpr *index)
+            {
+                ValueId object = Lower(index->object);
+                ValueId at = Coerce(Lower(index->index), index->index->type, types_.Int());
+                if (index->object->type->kind == TypeKind::kString)
+                {
+                    return builder_.Emit(IrOp::kCharAt, IrType::kChar, object, at);
+                }
+                return builder_.Emit(IrOp::kLoadElem, IrTypeOf(index->type), object, at);
+            }
+
+            ValueId VisitUnaryExpr(UnaryExpr *unary)
+            {
+                switch (unary->op)
+                {
+                case TokenKind::kTIncrement:
+                case TokenKind::kTDecrement:
+                {
+                    LValue lv = Place(unary->operand);
+                    ValueId old = Load(lv);
+                    IrType type = IrTypeOf(lv.type);
+                    IrType op_type = std::max(type, IrType::kI32);
+                    ValueId one = IsFloatIrType(op_type) ? builder_.ConstFloat(op_type, 1) : builder_.ConstInt(op_type, 1);
+                    ValueId wide = Convert(old, type, op_type);
+                    ValueId result = builder_.Emit(unary->op == TokenKind::kTIncrement ? IrOp::kAdd : IrOp::kSub, op_type, wide, one);
+                    result = Convert(result, op_type, type);
+                    Store(lv, result);
+                    return unary->postfix ? old : result;
+                }
+                case TokenKind::kTNot:
+                    return builder_.Emit(IrOp::kNot, IrType::kBool, Coerce(Lower(unary->operand), unary->operand->type, types_.Bool()));
+                case TokenKind::kTMinus:
+                {
+                    ValueId value = Coerce(Lower(unary->operand), unary->operand->type, unary->type);
+                    return builder_.Emit(IrOp::kNeg, IrTypeOf(unary->type), value);
+                }
+                default:
+                    return Coerce(Lower(unary->operand), unary->operand->type, unary->type);
+                }
+            }
+
+            ValueId VisitBinaryExpr(BinaryExpr *binary)
+            {
+                switch (binary->op)
+                {
+                case TokenKind::kTLogicalAnd:
+                case TokenKind::kTLogicalOr:
+                    return ShortCircuit(binary);
+                case TokenKind::kTEquality:
+                case TokenKind::kTNeq:
+                case TokenKind::kTLessThan:
+                case TokenKind::kTGreaterThan:
+                case TokenKind::kTLessOrEqual:
+                case TokenKind::kTGreaterOrEqual:
+                    return Compare(binary);
+                default:
+                    break;
+                }
+                ValueId lhs = Lower(binary->lhs);
+                ValueId rhs = Lower(binary->rhs);
+                return Arithmetic(binary->op, lhs, binary->lhs->type, rhs, binary->rhs->type, binary->type);
+            }
+
+            ValueId VisitAssignExpr(AssignExpr *assign)
+            {
+                LValue lv = Place(assign->target);
+                ValueId value;
+                if (assign->op == TokenKind::kTAssign)
+                {
+                    value = Coerce(Lower(assign->value), assign->value->type, lv.type);
+                }
+                else
+                {
+                    ValueId old = Load(lv);
+                    ValueId rhs = Lower(assign->value);
+                    TokenKind op = assign->op == TokenKind::kTPlusAssign ? TokenKind::kTPlus : TokenKind::kTMinus;
+                    const Type *result = ArithmeticType(op, lv.type, assign->value->type);
+                    value = Coerce(Arithmetic(op, old, lv.type, rhs, assign->value->type, result), result, lv.type);
+                }
+                Store(lv, value);
+                return value;
+            }
+
+            ValueId VisitConditionalExpr(ConditionalExpr *cond)
+            {
+                std::uint32_t result = builder_.NewVariable(IrTypeOf(cond->type));
+                BlockId then_block = builder_.NewBlock();
+                BlockId else_block = builder_.NewBlock();
+                BlockId join = builder_.NewBlock();
+                Condition(cond->cond, then_block, else_block);
+                builder_.SealBlock(then_block);
+                builder_.SealBlock(else_block);
+                builder_.SetBlock(then_block);
+                builder_.WriteVariable(result, Coerce(Lower(cond->then_expr), cond->then_expr->type, cond->type));
+                builder_.Jump(join);
+                builder_.SetBlock(else_block);
+                builder_.WriteVariable(result, Coerce(Lower(cond->else_expr), cond->else_expr->type, cond->type));
+                builder_.Jump(join);
+                builder_.SealBlock(join);
+                builder_.SetBlock(join);
+                return builder_.ReadVariable(result);
+            }
+
+            ValueId VisitCastExpr(CastExpr *cast)
+            {
+                const Type *to = cast->Expr::type;
+                const Type *from = cast->operand->type;
+                ValueId value = Lower(cast->operand);
+                if (to->kind == TypeKind::kClass && from->IsReference() &&
+                    !(from->kind == TypeKind::kClass && from->cls->IsSubclassOf(to->cls)))
+                {
+                    return builder_.Emit(IrOp::kCheckCast, IrType::kRef, value, kNoValue, to->cls->id);
+                }
+                return Coerce(value, from, to);
+            }
+
+            ValueId VisitNewExpr(NewExpr *expr)
+            {
+                const Type *type = expr->Expr::type;
+                if (type->kind == TypeKind::kArray)
+                {
+                    ValueId length = expr->args.empty() ? builder_.ConstInt(IrType::kI32, 0)
+                                                        : Coerce(Lower(expr->args[0]), expr->args[0]->type, types_.Int());
+                    return builder_.Emit(IrOp::kNewArray, IrType::kRef, length, kNoValue, kNoValue,
+                                         static_cast<std::uint16_t>(IrTypeOf(type->element)));
+                }
+                if (type->kind != TypeKind::kClass)
+                {
+                    std::vector<ValueId> args{builder_.ConstString("new " + std::string(type->name))};
+                    for (Expr *arg : expr->args)
+                        args.push_back(Convert(Lower(arg), IrTypeOf(arg->type), IrType::kRef));
+                    return builder_.EmitList(IrOp::kCallBuiltin, IrType::kRef, args, static_cast<std::uint32_t>(Builtin::kNone));
+                }
+                ClassInfo *cls = type->cls;
+                std::vector<ValueId> args{kNoValue};
+                const MethodInfo *ctor = expr->ctor ? expr->ctor : DefaultCtor(cls);
+                for (std::size_t i = 0; i < expr->args.size() && expr->ctor; i++)
+                {
+                    args.push_back(Coerce(Lower(expr->args[i]), expr->args[i]->type, ctor->param_types[i]));
+                }
+                builder_.SetLine(Line(expr));
+                ValueId object = builder_.Emit(IrOp::kNewObject, IrType::kRef, kNoValue, kNoValue, cls->id);
+                if (layout_.instance_init[cls->id] >= 0)
+                {
+                    builder_.Emit(IrOp::kCallInit, IrType::kVoid, object, kNoValue, cls->id);
+                }
+                if (ctor)
+                {
+                    args[0] = object;
+                    builder_.EmitList(IrOp::kCall, IrType::kVoid, args, ctor->id);
+                }
+                return object;
+            }
+
+            ValueId VisitThisExpr(ThisExpr *)
+            {
+                return This();
+            }
+
+            ValueId VisitAwaitExpr(AwaitExpr *expr)
+            {
+                ValueId task = Lower(expr->operand);
+                builder_.SetLine(Line(expr));
+                ValueId result = builder_.Emit(IrOp::kAwait, IrType::kRef, task);
+                if (expr->type->kind == TypeKind::kVoid)
+                {
+                    return kNoValue;
+                }
+                return Convert(result, IrType::kRef, IrTypeOf(expr->type));
+            }
+
+            ValueId VisitNode(Node *)
+            {
+                return kNoValue;
+            }
+
+        private:
+            struct Loop
+            {
+                BlockId break_target;
+                BlockId continue_target;
+            };
+
+            // an assignable location, with its object and index already
+            // evaluated.
+            struct LValue
+            {
+                enum Kind
+                {
+                    kVariable,
+                    kStatic,
+                    kField,
+                    kElement,
+                } kind = kVariable;
+                const Type *type = nullptr;
+                std::uint32_t var = 0;
+                std::uint32_t slot = 0;
+                ValueId object = kNoValue;
+                ValueId index = kNoValue;
+            };
+
+            ValueId Lower(Expr *expr)
+            {
+                builder_.SetLine(Line(expr));
+                if (expr->constant)
+                {
+                    return Coerce(Constant(expr->constant), expr->constant->type, expr->type);
+                }
+                return Visit(expr);
+            }
+
+            void Statement(Node *stmt)
+            {
+                if (stmt)
+                {
+                    builder_.SetLine(Line(stmt));
+                    Visit(stmt);
+                }
+            }
+
+            ValueId This() const
+            {
+                return 0;
+            }
+
+            ValueId Constant(const ConstValue *value)
+            {
+                IrType type = IrTypeOf(value->type);
+                if (value->type->kind == TypeKind::kString)
+                    return builder_.ConstString(value->string_value);
+                if (IsFloatIrType(type))
+                    return builder_.ConstFloat(type, value->float_value);
+                return builder_.ConstInt(type, value->int_value);
+            }
+
+            ValueId Convert(ValueId value, IrType from, IrType to)
+            {
+                if (from == to || to == IrType::kVoid || value == kNoValue)
+                    return value;
+                return builder_.Emit(IrOp::kConvert, to, value, kNoValue, kNoValue, static_cast<std::uint16_t>(from));
+            }
+
+            // value of static type from, as a value of type to: numeric
+            // widening and narrowing, boxing into object and unboxing.
+            ValueId Coerce(ValueId value, const Type *from, const Type *to)
+            {
+                return Convert(value, IrTypeOf(from), IrTypeOf(to));
+            }
+
+            ValueId LoadField(const FieldInfo *field, ValueId object)
+            {
+                if (field->is_const)
+                    return Coerce(Constant(field->constant), field->constant->type, field->type);
+                IrType type = IrTypeOf(field->type);
+                if (field->is_static)
+                    return builder_.Emit(IrOp::kLoadStatic, type, kNoValue, kNoValue, field->slot);
+                return builder_.Emit(IrOp::kLoadField, type, object == kNoValue ? This() : object, kNoValue, field->slot);
+            }
+
+            LValue Place(Expr *target)
+            {
+                LValue lv;
+                lv.type = target->type;
+                FieldInfo *field = nullptr;
+                ValueId object = kNoValue;
+                if (auto *name = NodeCast<NameExpr>(target))
+                {
+                    if (auto *param = NodeCast<ParamDecl>(name->decl))
+                    {
+                        lv.var = param_vars_[param->index];
+                        return lv;
+                    }
+                    if (auto *local = NodeCast<LocalVarStmt>(name->decl))
+                    {
+                        lv.var = locals_.at(local);
+                        return lv;
+                    }
+                    field = static_cast<FieldDecl *>(name->decl)->info;
+                    if (!field->is_static)
+                        object = This();
+                }
+                else if (auto *member = NodeCast<MemberExpr>(target))
+                {
+                    field = member->field;
+                    if (!field->is_static)
+                        object = Lower(member->object);
+                }
+                else
+                {
+                    auto *index = static_cast<IndexExpr *>(target);
+                    lv.kind = LValue::kElement;
+                    lv.object = Lower(index->object);
+                    lv.index = Coerce(Lower(index->index), index->index->type, types_.Int());
+                    return lv;
+                }
+                lv.kind = field->is_static ? LValue::kStatic : LValue::kField;
+                lv.slot = field->slot;
+                lv.object = object;
+                return lv;
+            }
+
+            ValueId Load(const LValue &lv)
+            {
+                IrType type = IrTypeOf(lv.type);
+                switch (lv.kind)
+                {
+                case LValue::kVariable:
+                    return builder_.ReadVariable(lv.var);
+                case LValue::kStatic:
+                    return builder_.Emit(IrOp::kLoadStatic, type, kNoValue, kNoValue, lv.slot);
+                case LValue::kField:
+                    return builder_.Emit(IrOp::kLoadField, type, lv.object, kNoValue, lv.slot);
+                case LValue::kElement:
+                    return builder_.Emit(IrOp::kLoadElem, type, lv.object, lv.index);
+                }
+                return kNoValue;
+            }
+
+            void Store(const LValue &lv, ValueId value)
+            {
+                switch (lv.kind)
+                {
+                case LValue::kVariable:
+                    builder_.WriteVariable(lv.var, value);
+                    break;
+                case LValue::kStatic:
+                    builder_.Emit(IrOp::kStoreStatic, IrType::kVoid, kNoValue, value, lv.slot);
+                    break;
+                case LValue::kField:
+                    builder_.Emit(IrOp::kStoreField, IrType::kVoid, lv.object, value, lv.slot);
+                    break;
+                case LValue::kElement:
+                    builder_.Emit(IrOp::kStoreElem, IrType::kVoid, lv.object, lv.index, value);
+                    break;
+                }
+            }
+
+            // the type checker's result type for op on operands of these
+            // types; only needed for compound assignment, where no node
+            // records it.
+            const Type *ArithmeticType(TokenKind op, const Type *lhs, const Type *rhs) const
+            {
+                if (op == TokenKind::kTPlus && (lhs->kind == TypeKind::kString || rhs->kind == TypeKind::kString))
+                    return types_.String();
+                if (!lhs->IsNumeric() || !rhs->IsNumeric())
+                    return lhs;
+                switch (std::max({lhs->kind, rhs->kind, TypeKind::kInt}))
+                {
+                case TypeKind::kLong:
+                    return types_.Long();
+                case TypeKind::kFloat:
+                    return types_.Float();
+                case TypeKind::kDouble:
+                    return types_.Double();
+                default:
+                    return types_.Int();
+                }
+            }
+
+            ValueId Arithmetic(TokenKind op, ValueId lhs, const Type *lhs_type, ValueId rhs, const Type *rhs_type, const Type *result)
+            {
+                if (op == TokenKind::kTPlus && result->kind == TypeKind::kString)
+                {
+                    lhs = Stringify(lhs, lhs_type);
+                    rhs = Stringify(rhs, rhs_type);
+                    return builder_.Emit(IrOp::kConcat, IrType::kRef, lhs, rhs);
+                }
+                IrType type = IrTypeOf(result);
+                IrOp ir_op;
+                switch (op)
+                {
+                case TokenKind::kTPlus:
+                    ir_op = IrOp::kAdd;
+                    break;
+                case TokenKind::kTMinus:
+                    ir_op = IrOp::kSub;
+                    break;
+                case TokenKind::kTStar:
+                    ir_op = IrOp::kMul;
+                    break;
+                case TokenKind::kTFSlash:
+                    ir_op = IrOp::kDiv;
+                    break;
+                case TokenKind::kTModulo:
+                    ir_op = IrOp::kRem;
+                    break;
+                case TokenKind::kTAmpersand:
+                    ir_op = IrOp::kAnd;
+                    break;
+                case TokenKind::kTPipe:
+                    ir_op = IrOp::kOr;
+                    break;
+                case TokenKind::kTXor:
+                    ir_op = IrOp::kXor;
+                    break;
+                case TokenKind::kTLShift:
+                    ir_op = IrOp::kShl;
+                    break;
+                default:
+                    ir_op = IrOp::kShr;
+                    break;
+                }
+                lhs = Coerce(lhs, lhs_type, result);
+                rhs = ir_op == IrOp::kShl || ir_op == IrOp::kShr ? Coerce(rhs, rhs_type, types_.Int()) : Coerce(rhs, rhs_type, result);
+                return builder_.Emit(ir_op, type, lhs, rhs);
+            }
+
+            ValueId Stringify(ValueId value, const Type *type)
+            {
+                if (type->kind == TypeKind::kString)
+                    return value;
+                IrType from = IrTypeOf(type);
+                return builder_.Emit(IrOp::kToString, IrType::kRef, value, kNoValue, kNoValue, static_cast<std::uint16_t>(from));
+            }
+
+            ValueId Compare(BinaryExpr *binary)
+            {
+                const Type *lt = binary->lhs->type;
+                const Type *rt = binary->rhs->type;
+                ValueId lhs = Lower(binary->lhs);
+                ValueId rhs = Lower(binary->rhs);
+                bool equality = binary->op == TokenKind::kTEquality || binary->op == TokenKind::kTNeq;
+                if (equality && lt->kind == TypeKind::kString && rt->kind == TypeKind::kString)
+                {
+                    ValueId eq = builder_.Emit(IrOp::kStrEq, IrType::kBool, lhs, rhs);
+                    return binary->op == TokenKind::kTEquality ? eq : builder_.Emit(IrOp::kNot, IrType::kBool, eq);
+                }
+                IrType type = IrTypeOf(lt);
+                if (lt->IsNumeric() && rt->IsNumeric())
+                {
+                    type = std::max({IrTypeOf(lt), IrTypeOf(rt), IrType::kI32});
+                }
+                else if (IrTypeOf(rt) != type)
+                {
+                    type = IrType::kRef;
+                }
+                lhs = Convert(lhs, IrTypeOf(lt), type);
+                rhs = Convert(rhs, IrTypeOf(rt), type);
+                IrOp op;
+                switch (binary->op)
+                {
+                case TokenKind::kTEquality:
+                    op = IrOp::kEq;
+                    break;
+                case TokenKind::kTNeq:
+                    op = IrOp::kNe;
+                    break;
+                case TokenKind::kTLessThan:
+                    op = IrOp::kLt;
+                    break;
+                case TokenKind::kTGreaterThan:
+                    op = IrOp::kGt;
+                    break;
+                case TokenKind::kTLessOrEqual:
+                    op = IrOp::kLe;
+                    break;
+                default:
+                    op = IrOp::kGe;
+                    break;
+                }
+                return builder_.Emit(op, IrType::kBool, lhs, rhs, kNoValue, static_cast<std::uint16_t>(type));
+            }
+
+            ValueId ShortCircuit(BinaryExpr *binary)
+            {
+                bool is_and = binary->op == TokenKind::kTLogicalAnd;
+                std::uint32_t result = builder_.NewVariable(IrType::kBool);
+                BlockId rhs_block = builder_.NewBlock();
+                BlockId join = builder_.NewBlock();
+                ValueId lhs = Coerce(Lower(binary->lhs), binary->lhs->type, types_.Bool());
+                builder_.WriteVariable(result, lhs);
+                if (is_and)
+                    builder_.Branch(lhs, rhs_block, join);
+                else
+                    builder_.Branch(lhs, join, rhs_block);
+                builder_.SealBlock(rhs_block);
+                builder_.SetBlock(rhs_block);
+                builder_.WriteVariable(result, Coerce(Lower(binary->rhs), binary->rhs->type, types_.Bool()));
+                builder_.Jump(join);
+                builder_.SealBlock(join);
+                builder_.SetBlock(join);
+                return builder_.ReadVariable(result);
+            }
+
+            // branches on cond without materializing && and || as values.
+            void Condition(Expr *cond, BlockId if_true, BlockId if_false)
+            {
+                builder_.SetLine(Line(cond));
+                if (cond->constant)
+                {
+                    builder_.Jump(cond->constant->int_value ? if_true : if_false);
+                    return;
+                }
+                if (auto *binary = NodeCast<BinaryExpr>(cond))
+                {
+                    if (binary->op == TokenKind::kTLogicalAnd || binary->op == TokenKind::kTLogicalOr)
+                    {
+                        BlockId rhs_block = builder_.NewBlock();
+                        if (binary->op == TokenKind::kTLogicalAnd)
+                            Condition(binary->lhs, rhs_block, if_false);
+                        else
+                            Condition(binary->lhs, if_true, rhs_block);
+                        builder_.SealBlock(rhs_block);
+                        builder_.SetBlock(rhs_block);
+                        Condition(binary->rhs, if_true, if_false);
+                        return;
+                    }
+                }
+                if (auto *unary = NodeCast<UnaryExpr>(cond))
+                {
+                    if (unary->op == TokenKind::kTNot)
+                    {
+                        Condition(unary->operand, if_false, if_true);
+                        return;
+                    }
+                }
+                ValueId value = Coerce(Lower(cond), cond->type, types_.Bool());
+                builder_.Branch(value, if_true, if_false);
+            }
+
+            void JumpIfOpen(BlockId target)
+            {
+                if (!builder_.IsTerminated())
+                {
+                    builder_.Jump(target);
+                }
+            }
+
+            // async methods run to completion and hand back a finished task.
+            void ReturnFromMethod(ValueId value)
+            {
+                if (method_->is_async && method_->return_type->kind == TypeKind::kTask)
+                {
+                    std::vector<ValueId> args;
+                    Builtin builtin = Builtin::kTaskCompleted;
+                    if (value != kNoValue)
+                    {
+                        args.push_back(Convert(value, IrTypeOf(method_->return_type->element), IrType::kRef));
+                        builtin = Builtin::kTaskFromResult;
+                    }
+                    value = builder_.EmitList(IrOp::kCallBuiltin, IrType::kRef, args, static_cast<std::uint32_t>(builtin));
+                }
+                builder_.Return(value);
+            }
+
+            ValueId CallBuiltin(CallExpr *call, Builtin builtin)
+            {
+                std::vector<ValueId> args;
+                IrType type = IrTypeOf(call->type);
+                if (builtin == Builtin::kNone)
+                {
+                    args.push_back(builder_.ConstString(LibraryName(call->callee)));
+                }
+                for (Expr *arg : call->args)
+                {
+                    ValueId value = Lower(arg);
+                    switch (builtin)
+                    {
+                    case Builtin::kConsoleWrite:
+                    case Builtin::kConsoleWriteLine:
+                        // formatting happens here, so the runtime only
+                        // ever prints strings.
+                        value = Stringify(value, arg->type);
+                        break;
+                    case Builtin::kMathAbs:
+                    case Builtin::kMathMax:
+                    case Builtin::kMathMin:
+                    case Builtin::kMathSqrt:
+                        value = Coerce(value, arg->type, call->type);
+                        break;
+                    case Builtin::kTaskDelay:
+                        value = Coerce(value, arg->type, types_.Int());
+                        break;
+                    default:
+                        value = Convert(value, IrTypeOf(arg->type), IrType::kRef);
+                        break;
+                    }
+                    args.push_back(value);
+                }
+                builder_.SetLine(Line(call));
+                return builder_.EmitList(IrOp::kCallBuiltin, type, args, static_cast<std::uint32_t>(builtin));
+            }
+
+            // dotted spelling of a library callee, e.g. "Console.ReadLine".
+            static std::string LibraryName(const Expr *expr)
+            {
+                if (auto *name = NodeCast<NameExpr>(expr))
+                    return std::string(name->name);
+                if (auto *member = NodeCast<MemberExpr>(expr))
+                {
+                    std::string object = LibraryName(member->object);
+                    return object.empty() ? std::string(member->name) : object + "." + std::string(member->name);
+                }
+                return "";
+            }
+
+            // the source line of node, in the file of the class being
+            // lowered.
+            int Line(const Node *node) const
+            {
+                const CompilationUnit *unit = owner_ && owner_->decl ? owner_->decl->unit : nullptr;
+                return unit ? unit->Locate(node).line : 0;
+            }
+
+            const ModuleLayout &layout_;
+            TypeTable &types_;
+            ClassInfo *owner_;
+            const MethodInfo *method_;
+            IrBuilder builder_;
+            bool is_static_ = true;
+            std::vector<std::uint32_t> param_vars_;
+            std::unordered_map<const LocalVarStmt *, std::uint32_t> locals_;
+            std::vector<Loop> loops_;
+        };
+
+        std::vector<IrType> ParamTypes(const MethodInfo *method)
+        {
+            std::vector<IrType> params;
+            if (!method->is_static)
+                params.push_back(IrType::kRef);
+            for (const Type *type : method->param_types)
+                params.push_back(IrTypeOf(type));
+            return params;
+        }
+    }
+
+    IrModule LowerToIr(const GlobalSymbols &globals, ThreadPool *pool)
+    {
+        IrModule module;
+        module.globals = &globals;
+        const auto &methods = globals.methods();
+        const auto &classes = globals.classes();
+        module.num_static_slots = static_cast<std::uint32_t>(globals.static_fields().size());
+
+        // fix the function numbering before anything is lowered: methods by
+        // id, then one <init> per class that has instance field initializers
+        // (its own or inherited), then <static-init>.
+        std::size_t count = methods.size();
+        std::vector<ClassInfo *> init_classes;
+        module.instance_init.assign(classes.size(), -1);
+        for (ClassInfo *cls : classes)
+        {
+            for (ClassInfo *c = cls; c; c = c->base)
+            {
+                bool has_init = std::any_of(c->fields.begin(), c->fields.end(), [](const FieldInfo *f)
+                                            { return !f->is_static && !f->is_const && f->decl->init; });
+                if (has_init)
+                {
+                    module.instance_init[cls->id] = static_cast<std::int32_t>(count++);
+                    init_classes.push_back(cls);
+                    break;
+                }
+            }
+        }
+        module.static_init = static_cast<std::int32_t>(count++);
+        module.functions.resize(count);
+        for (MethodInfo *method : methods)
+        {
+            if (method->is_static && !method->is_ctor && method->decl->name == "Main" && method->param_types.size() <= 1 &&
+                module.entry < 0)
+                module.entry = static_cast<std::int32_t>(method->id);
+        }
+
+        ModuleLayout layout{globals, module.instance_init};
+        auto lower = [&](std::size_t i)
+        {
+            if (i < methods.size())
+            {
+                MethodInfo *method = methods[i];
+                if (!method->decl->body)
+                    return;
+                IrLowering lowering(layout, method->owner, method, MethodSignature(method), IrTypeOf(method->return_type),
+                                    ParamTypes(method));
+                module.functions[i] = lowering.LowerMethod();
+            }
+            else if (i < methods.size() + init_classes.size())
+            {
+                ClassInfo *cls = init_classes[i - methods.size()];
+                IrLowering lowering(layout, cls, nullptr, cls->qualified_name + ".<init>", IrType::kVoid, {IrType::kRef});
+                module.functions[i] = lowering.LowerInstanceInit(cls);
+            }
+            else
+            {
+                IrLowering lowering(layout, nullptr, nullptr, "<static-init>", IrType::kVoid, {});
+                module.functions[i] = lowering.LowerStaticInit();
+            }
+        };
+        if (pool)
+        {
+            pool->ParallelFor(count, lower);
+        }
+        else
+        {
+            for (std::size_t i = 0; i < count; i++)
+                lower(i);
+        }
+        return module;
+    }
+
+}
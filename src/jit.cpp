@@ -0,0 +1,844 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include "jit.h"
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <utility>
+
+#if defined(__x86_64__) && defined(__unix__) && !defined(TINYCSHARP_NO_JIT)
+#define TINYCSHARP_JIT 1
+#include <sys/mman.h>
+#else
+#define TINYCSHARP_JIT 0
+#endif
+
+namespace tinycsharp
+{
+    namespace
+    {
+        enum Reg : int
+        {
+            kRax = 0,
+            kRcx = 1,
+            kRdx = 2,
+            kRbx = 3,
+            kRsi = 6,
+            kRdi = 7,
+            kR12 = 12,
+            kR13 = 13,
+        };
+        constexpr int kXmm0 = 0;
+        constexpr int kXmm1 = 1;
+
+        // condition codes, as in jcc and setcc.
+        enum Cond : std::uint8_t
+        {
+            kBelow = 0x2,
+            kAboveEqual = 0x3,
+            kEqual = 0x4,
+            kNotEqual = 0x5,
+            kAbove = 0x7,
+            kParity = 0xa,
+            kNoParity = 0xb,
+            kLess = 0xc,
+            kGreaterEqual = 0xd,
+            kLessEqual = 0xe,
+            kGreater = 0xf,
+        };
+
+        // the few x86-64 encodings the templates need. memory operands are
+        // always [base + disp32].
+        class Assembler
+        {
+        public:
+            std::vector<std::uint8_t> code;
+
+            std::uint32_t Size() const { return static_cast<std::uint32_t>(code.size()); }
+            void Byte(std::uint8_t b) { code.push_back(b); }
+            void Int32(std::int32_t v)
+            {
+                for (int i = 0; i < 4; i++)
+                    Byte(static_cast<std::uint8_t>(static_cast<std::uint32_t>(v) >> (8 * i)));
+            }
+            void Int64(std::uint64_t v)
+            {
+                for (int i = 0; i < 8; i++)
+                    Byte(static_cast<std::uint8_t>(v >> (8 * i)));
+            }
+
+            void Rex(bool wide, int reg, int rm)
+            {
+                std::uint8_t rex = static_cast<std::uint8_t>(0x40 | (wide ? 8 : 0) | ((reg >> 3) << 2) | (rm >> 3));
+                if (rex != 0x40)
+                    Byte(rex);
+            }
+            void Mem(std::uint8_t prefix, bool wide, std::initializer_list<std::uint8_t> opcode, int reg, int base, std::int32_t disp)
+            {
+                if (prefix)
+                    Byte(prefix);
+                Rex(wide, reg, base);
+                for (std::uint8_t b : opcode)
+                    Byte(b);
+                Byte(static_cast<std::uint8_t>(0x80 | ((reg & 7) << 3) | (base & 7)));
+                if ((base & 7) == 4)
+                    Byte(0x24);
+                Int32(disp);
+            }
+            void RegReg(std::uint8_t prefix, bool wide, std::initializer_list<std::uint8_t> opcode, int reg, int rm)
+            {
+                if (prefix)
+                    Byte(prefix);
+                Rex(wide, reg, rm);
+                for (std::uint8_t b : opcode)
+                    Byte(b);
+                Byte(static_cast<std::uint8_t>(0xc0 | ((reg & 7) << 3) | (rm & 7)));
+            }
+
+            void Load(int r, int base, std::int32_t disp) { Mem(0, true, {0x8b}, r, base, disp); }
+            void Store(int base, std::int32_t disp, int r) { Mem(0, true, {0x89}, r, base, disp); }
+            void Load32(int r, int base, std::int32_t disp) { Mem(0, false, {0x8b}, r, base, disp); }
+            void Store32(int base, std::int32_t disp, int r) { Mem(0, false, {0x89}, r, base, disp); }
+            // add 03, or 0b, and 23, sub 2b, xor 33, cmp 3b: r op= [base + disp]
+            void Alu(std::uint8_t op, int r, int base, std::int32_t disp) { Mem(0, true, {op}, r, base, disp); }
+            void Imul(int r, int base, std::int32_t disp) { Mem(0, true, {0x0f, 0xaf}, r, base, disp); }
+            void Movsxd(int r, int src) { RegReg(0, true, {0x63}, r, src); }
+            void Mov(int dst, int src) { RegReg(0, true, {0x89}, src, dst); }
+            void Add(int dst, int src) { RegReg(0, true, {0x01}, src, dst); }
+            void Cmp(int x, int y) { RegReg(0, true, {0x39}, y, x); }
+            void Test(int r) { RegReg(0, true, {0x85}, r, r); }
+            void MovImm(int r, std::uint64_t imm)
+            {
+                Rex(true, 0, r);
+                Byte(static_cast<std::uint8_t>(0xb8 + (r & 7)));
+                Int64(imm);
+            }
+            void MovImm32(int base, std::int32_t disp, std::int32_t imm)
+            {
+                Mem(0, false, {0xc7}, 0, base, disp);
+                Int32(imm);
+            }
+            void CmpImm(int r, std::int32_t imm)
+            {
+                RegReg(0, true, {0x81}, 7, r);
+                Int32(imm);
+            }
+            void CmpByte(int base, std::int32_t disp, std::uint8_t imm)
+            {
+                Mem(0, false, {0x80}, 7, base, disp);
+                Byte(imm);
+            }
+            // /digit forms of 83 (and 4, xor 6), c1 (shl 4) and 0f ba (btc 7).
+            void AluImm8(int digit, int r, std::uint8_t imm, bool wide)
+            {
+                RegReg(0, wide, {0x83}, digit, r);
+                Byte(imm);
+            }
+            void ShlImm(int r, std::uint8_t imm)
+            {
+                RegReg(0, true, {0xc1}, 4, r);
+                Byte(imm);
+            }
+            void Btc(int r, std::uint8_t bit, bool wide)
+            {
+                RegReg(0, wide, {0x0f, 0xba}, 7, r);
+                Byte(bit);
+            }
+            void Neg(int r) { RegReg(0, true, {0xf7}, 3, r); }
+            void Not(int r) { RegReg(0, true, {0xf7}, 2, r); }
+            void Idiv(int r) { RegReg(0, true, {0xf7}, 7, r); }
+            void Cqo() { code.insert(code.end(), {0x48, 0x99}); }
+            void ShlCl(int r) { RegReg(0, true, {0xd3}, 4, r); }
+            void SarCl(int r) { RegReg(0, true, {0xd3}, 7, r); }
+            // al or cl only.
+            void Setcc(Cond cc, int r8) { RegReg(0, false, {0x0f, static_cast<std::uint8_t>(0x90 | cc)}, 0, r8); }
+            void AndAlCl() { code.insert(code.end(), {0x20, 0xc8}); }
+            void OrAlCl() { code.insert(code.end(), {0x08, 0xc8}); }
+            void MovzxAl(int r) { RegReg(0, false, {0x0f, 0xb6}, r, kRax); }
+            void MovzxByte(int r, int base, std::int32_t disp) { Mem(0, false, {0x0f, 0xb6}, r, base, disp); }
+            void XorEax() { code.insert(code.end(), {0x31, 0xc0}); }
+            void MovEax(std::int32_t imm)
+            {
+                Byte(0xb8);
+                Int32(imm);
+            }
+            // sse: prefix f2 for doubles, f3 for floats. load 10, store 11,
+            // add 58, mul 59, sub 5c, div 5e.
+            void Sse(std::uint8_t prefix, std::uint8_t op, int xmm, int base, std::int32_t disp)
+            {
+                Mem(prefix, false, {0x0f, op}, xmm, base, disp);
+            }
+            // ucomisd (66) or ucomiss (no prefix) xmm, [base + disp]
+            void Ucomis(bool is_double, int xmm, int base, std::int32_t disp)
+            {
+                Mem(is_double ? 0x66 : 0, false, {0x0f, 0x2e}, xmm, base, disp);
+            }
+            void Cvtsi2sd(int xmm, int r) { RegReg(0xf2, true, {0x0f, 0x2a}, xmm, r); }
+            void Push(int r)
+            {
+                Rex(false, 0, r);
+                Byte(static_cast<std::uint8_t>(0x50 + (r & 7)));
+            }
+            void Pop(int r)
+            {
+                Rex(false, 0, r);
+                Byte(static_cast<std::uint8_t>(0x58 + (r & 7)));
+            }
+            void JmpReg(int r) { RegReg(0, false, {0xff}, 4, r); }
+            void CallReg(int r) { RegReg(0, false, {0xff}, 2, r); }
+            void Ret() { Byte(0xc3); }
+            // a rel32 jump to be patched; returns where its offset is.
+            std::uint32_t Jmp()
+            {
+                Byte(0xe9);
+                Int32(0);
+                return Size() - 4;
+            }
+            std::uint32_t Jcc(Cond cc)
+            {
+                Byte(0x0f);
+                Byte(static_cast<std::uint8_t>(0x80 | cc));
+                Int32(0);
+                return Size() - 4;
+            }
+            void Patch(std::uint32_t at, std::uint32_t target)
+            {
+                std::int32_t rel = static_cast<std::int32_t>(target) - static_cast<std::int32_t>(at + 4);
+                std::memcpy(code.data() + at, &rel, 4);
+            }
+        };
+
+        // helpers native code calls; plain functions of machine words.
+        void JitWriteBarrier(Heap *heap, Object *holder, Object *value)
+        {
+            heap->WriteBarrier(holder, value);
+        }
+        std::int64_t JitConvert(std::int64_t bits, int from, int to)
+        {
+            Value v = IntValue(bits);
+            return ConvertPrimitive(v, static_cast<IrType>(from), static_cast<IrType>(to)).i;
+        }
+        double JitFmod(double x, double y) { return std::fmod(x, y); }
+        float JitFmodF(float x, float y) { return std::fmod(x, y); }
+
+        template <typename F>
+        std::uint64_t Address(F *fn) { return reinterpret_cast<std::uint64_t>(fn); }
+
+        constexpr std::int32_t kInfo = 12;
+        constexpr std::int32_t kKind = 8;
+        constexpr std::int32_t kPayload = sizeof(Object);
+        static_assert(offsetof(Object, info) == kInfo && offsetof(Object, kind) == kKind, "object header layout");
+        static_assert(offsetof(JitExit, value) == 0 && offsetof(JitExit, pc) == 8, "JitExit layout");
+
+        inline std::int32_t Slot(std::uint32_t r) { return static_cast<std::int32_t>(r * sizeof(Value)); }
+
+        // translates one function. rbx holds the frame's registers and r12
+        // the JitExit throughout; values live in the frame, never across
+        // instructions in machine registers.
+        class Translator
+        {
+        public:
+            Translator(const BcFunction &fn, Heap &heap, const StringImage &strings, Value *statics)
+                : fn_(fn), heap_(heap), strings_(strings), statics_(statics)
+            {
+            }
+
+            void Translate(std::vector<std::uint8_t> &code, std::vector<std::uint32_t> &entries)
+            {
+                const std::uint32_t size = static_cast<std::uint32_t>(fn_.code.size());
+                std::vector<std::uint32_t> offsets(size, JitFunction::kNoEntry);
+                entries.assign(size, JitFunction::kNoEntry);
+                // entered as std::uint32_t (Value *regs, JitExit *exit, const void *entry).
+                as_.Push(kRbx);
+                as_.Push(kR12);
+                as_.Push(kR13); // keeps calls 16-byte aligned
+                as_.Mov(kRbx, kRdi);
+                as_.Mov(kR12, kRsi);
+                as_.JmpReg(kRdx);
+                epilogue_ = as_.Size();
+                as_.Pop(kR13);
+                as_.Pop(kR12);
+                as_.Pop(kRbx);
+                as_.Ret();
+
+                for (std::uint32_t pc = 0; pc < size; pc += InstLength(fn_.code[pc]))
+                {
+                    offsets[pc] = as_.Size();
+                    if (Emit(fn_.code[pc], pc))
+                        entries[pc] = offsets[pc];
+                    else
+                        bails_.emplace_back(as_.Jmp(), pc);
+                }
+                // the last instruction always transfers control, so nothing
+                // falls off the end. bail stubs follow the code, one per pc
+                // that leaves for the interpreter.
+                for (auto [at, pc] : jumps_)
+                    as_.Patch(at, offsets[pc]);
+                std::vector<std::uint32_t> stubs(size, JitFunction::kNoEntry);
+                for (auto [at, pc] : bails_)
+                {
+                    if (stubs[pc] == JitFunction::kNoEntry)
+                    {
+                        stubs[pc] = as_.Size();
+                        as_.MovImm32(kR12, 8, static_cast<std::int32_t>(pc));
+                        as_.MovEax(1);
+                        as_.Patch(as_.Jmp(), epilogue_);
+                    }
+                    as_.Patch(at, stubs[pc]);
+                }
+                code = std::move(as_.code);
+            }
+
+        private:
+            // leaves for the interpreter to run pc when cc holds.
+            void BailIf(Cond cc, std::uint32_t pc) { bails_.emplace_back(as_.Jcc(cc), pc); }
+            void JumpTo(std::uint32_t target) { jumps_.emplace_back(as_.Jmp(), target); }
+            void JumpIf(Cond cc, std::uint32_t target) { jumps_.emplace_back(as_.Jcc(cc), target); }
+
+            void LoadRef(int r, std::uint16_t reg, std::uint32_t pc)
+            {
+                as_.Load(r, kRbx, Slot(reg));
+                as_.Test(r);
+                BailIf(kEqual, pc);
+            }
+            // rax = array, rcx = index, checked against its length.
+            void LoadIndexed(std::uint16_t array, std::uint16_t index, std::uint32_t pc)
+            {
+                LoadRef(kRax, array, pc);
+                as_.Load(kRcx, kRbx, Slot(index));
+                as_.Load32(kRdx, kRax, kInfo);
+                as_.Cmp(kRcx, kRdx);
+                BailIf(kAboveEqual, pc);
+            }
+            void CallHelper(std::uint64_t fn)
+            {
+                as_.MovImm(kRax, fn);
+                as_.CallReg(kRax);
+            }
+            // holder in rsi, stored reference in rdx.
+            void WriteBarrier()
+            {
+                as_.Test(kRdx);
+                std::uint32_t skip = as_.Jcc(kEqual);
+                as_.MovImm(kRdi, reinterpret_cast<std::uint64_t>(&heap_));
+                CallHelper(Address(&JitWriteBarrier));
+                as_.Patch(skip, as_.Size());
+            }
+
+            void IntOp(std::uint8_t alu, bool mul, bool wrap32, const BcInst &inst)
+            {
+                as_.Load(kRax, kRbx, Slot(inst.b));
+                if (mul)
+                    as_.Imul(kRax, kRbx, Slot(inst.c));
+                else
+                    as_.Alu(alu, kRax, kRbx, Slot(inst.c));
+                if (wrap32)
+                    as_.Movsxd(kRax, kRax);
+                as_.Store(kRbx, Slot(inst.a), kRax);
+            }
+            void FloatOp(std::uint8_t sse, bool is_double, const BcInst &inst)
+            {
+                std::uint8_t prefix = is_double ? 0xf2 : 0xf3;
+                as_.Sse(prefix, 0x10, kXmm0, kRbx, Slot(inst.b));
+                as_.Sse(prefix, sse, kXmm0, kRbx, Slot(inst.c));
+                as_.Sse(prefix, 0x11, kXmm0, kRbx, Slot(inst.a));
+            }
+            // add, sub, mul: 03/58, 2b/5c, 0faf/59.
+            void Arith(std::uint8_t alu, std::uint8_t sse, bool mul, IrType type, const BcInst &inst)
+            {
+                if (type == IrType::kI32 || type == IrType::kI64)
+                    IntOp(alu, mul, type == IrType::kI32, inst);
+                else
+                    FloatOp(sse, type != IrType::kF32, inst);
+            }
+            void IntDivide(bool div, bool is_i32, const BcInst &inst, std::uint32_t pc)
+            {
+                as_.Load(kRcx, kRbx, Slot(inst.c));
+                as_.Test(kRcx);
+                BailIf(kEqual, pc);
+                as_.Load(kRax, kRbx, Slot(inst.b));
+                as_.CmpImm(kRcx, -1);
+                std::uint32_t skip = as_.Jcc(kNotEqual);
+                as_.MovImm(kRdx, is_i32 ? static_cast<std::uint64_t>(static_cast<std::int64_t>(INT32_MIN))
+                                        : static_cast<std::uint64_t>(INT64_MIN));
+                as_.Cmp(kRax, kRdx);
+                BailIf(kEqual, pc);
+                as_.Patch(skip, as_.Size());
+                as_.Cqo();
+                as_.Idiv(kRcx);
+                as_.Store(kRbx, Slot(inst.a), div ? kRax : kRdx);
+            }
+            void Divide(bool div, IrType type, const BcInst &inst, std::uint32_t pc)
+            {
+                if (type == IrType::kF32 || type == IrType::kF64)
+                {
+                    bool is_double = type == IrType::kF64;
+                    if (div)
+                        return FloatOp(0x5e, is_double, inst);
+                    std::uint8_t prefix = is_double ? 0xf2 : 0xf3;
+                    as_.Sse(prefix, 0x10, kXmm0, kRbx, Slot(inst.b));
+                    as_.Sse(prefix, 0x10, kXmm1, kRbx, Slot(inst.c));
+                    CallHelper(is_double ? Address(&JitFmod) : Address(&JitFmodF));
+                    as_.Sse(prefix, 0x11, kXmm0, kRbx, Slot(inst.a));
+                    return;
+                }
+                IntDivide(div, type == IrType::kI32, inst, pc);
+            }
+            void Shift(bool left, bool is_i32, const BcInst &inst)
+            {
+                as_.Load(kRcx, kRbx, Slot(inst.c));
+                as_.AluImm8(4, kRcx, is_i32 ? 31 : 63, false);
+                as_.Load(kRax, kRbx, Slot(inst.b));
+                if (left)
+                    as_.ShlCl(kRax);
+                else
+                    as_.SarCl(kRax);
+                if (left && is_i32)
+                    as_.Movsxd(kRax, kRax);
+                as_.Store(kRbx, Slot(inst.a), kRax);
+            }
+            void Negate(IrType type, const BcInst &inst)
+            {
+                if (type == IrType::kF32)
+                {
+                    as_.Load32(kRax, kRbx, Slot(inst.b));
+                    as_.Btc(kRax, 31, false);
+                    as_.Store32(kRbx, Slot(inst.a), kRax);
+                    return;
+                }
+                as_.Load(kRax, kRbx, Slot(inst.b));
+                if (type == IrType::kI32 || type == IrType::kI64)
+                    as_.Neg(kRax);
+                else
+                    as_.Btc(kRax, 63, true);
+                if (type == IrType::kI32)
+                    as_.Movsxd(kRax, kRax);
+                as_.Store(kRbx, Slot(inst.a), kRax);
+            }
+            // op is the generic compare; C semantics for NaN.
+            void Compare(BcOp op, IrType type, const BcInst &inst)
+            {
+                if (type == IrType::kF32 || type == IrType::kF64)
+                {
+                    bool is_double = type == IrType::kF64;
+                    std::uint8_t prefix = is_double ? 0xf2 : 0xf3;
+                    // x < y and x <= y are tested as y > x and y >= x.
+                    bool swap = op == BcOp::kLt || op == BcOp::kLe;
+                    as_.Sse(prefix, 0x10, kXmm0, kRbx, Slot(swap ? inst.c : inst.b));
+                    as_.Ucomis(is_double, kXmm0, kRbx, Slot(swap ? inst.b : inst.c));
+                    switch (op)
+                    {
+                    case BcOp::kEq:
+                        as_.Setcc(kEqual, kRax);
+                        as_.Setcc(kNoParity, kRcx);
+                        as_.AndAlCl();
+                        break;
+                    case BcOp::kNe:
+                        as_.Setcc(kNotEqual, kRax);
+                        as_.Setcc(kParity, kRcx);
+                        as_.OrAlCl();
+                        break;
+                    case BcOp::kLt:
+                    case BcOp::kGt:
+                        as_.Setcc(kAbove, kRax);
+                        break;
+                    default:
+                        as_.Setcc(kAboveEqual, kRax);
+                        break;
+                    }
+                }
+                else
+                {
+                    as_.Load(kRax, kRbx, Slot(inst.b));
+                    as_.Alu(0x3b, kRax, kRbx, Slot(inst.c));
+                    as_.Setcc(IntCond(op), kRax);
+                }
+                as_.MovzxAl(kRax);
+                as_.Store(kRbx, Slot(inst.a), kRax);
+            }
+            static Cond IntCond(BcOp op)
+            {
+                switch (op)
+                {
+                case BcOp::kEq:
+                case BcOp::kJumpIfEqI:
+                    return kEqual;
+                case BcOp::kNe:
+                case BcOp::kJumpIfNeI:
+                    return kNotEqual;
+                case BcOp::kLt:
+                case BcOp::kJumpIfLtI:
+                    return kLess;
+                case BcOp::kLe:
+                case BcOp::kJumpIfLeI:
+                    return kLessEqual;
+                case BcOp::kGt:
+                case BcOp::kJumpIfGtI:
+                    return kGreater;
+                default:
+                    return kGreaterEqual;
+                }
+            }
+            // the fused read-modify-write ops: [base + disp] += R(src).
+            void AddTo(int base, std::int32_t disp, std::uint16_t src, IrType type)
+            {
+                if (type == IrType::kI32 || type == IrType::kI64)
+                {
+                    as_.Load(kRcx, base, disp);
+                    as_.Alu(0x03, kRcx, kRbx, Slot(src));
+                    if (type == IrType::kI32)
+                        as_.Movsxd(kRcx, kRcx);
+                    as_.Store(base, disp, kRcx);
+                    return;
+                }
+                as_.Sse(0xf2, 0x10, kXmm0, base, disp);
+                as_.Sse(0xf2, 0x58, kXmm0, kRbx, Slot(src));
+                as_.Sse(0xf2, 0x11, kXmm0, base, disp);
+            }
+            void Convert(IrType from, IrType to, const BcInst &inst)
+            {
+                as_.Load(kRdi, kRbx, Slot(inst.b));
+                as_.MovImm(kRsi, static_cast<std::uint64_t>(from));
+                as_.MovImm(kRdx, static_cast<std::uint64_t>(to));
+                CallHelper(Address(&JitConvert));
+                as_.Store(kRbx, Slot(inst.a), kRax);
+            }
+
+            // false for an instruction left to the interpreter, emitting
+            // nothing.
+            bool Emit(const BcInst &inst, std::uint32_t pc)
+            {
+                switch (inst.op)
+                {
+                case BcOp::kNop:
+                    return true;
+                case BcOp::kMove:
+                    as_.Load(kRax, kRbx, Slot(inst.b));
+                    as_.Store(kRbx, Slot(inst.a), kRax);
+                    return true;
+                case BcOp::kLoadK:
+                    as_.MovImm(kRax, static_cast<std::uint64_t>(fn_.constants[inst.Wide()]));
+                    as_.Store(kRbx, Slot(inst.a), kRax);
+                    return true;
+                case BcOp::kLoadStr:
+                    as_.MovImm(kRax, reinterpret_cast<std::uint64_t>(strings_.Literal(inst.Wide())));
+                    as_.Store(kRbx, Slot(inst.a), kRax);
+                    return true;
+                case BcOp::kLoadNull:
+                    as_.XorEax();
+                    as_.Store(kRbx, Slot(inst.a), kRax);
+                    return true;
+                case BcOp::kAdd:
+                    Arith(0x03, 0x58, false, inst.type, inst);
+                    return true;
+                case BcOp::kSub:
+                    Arith(0x2b, 0x5c, false, inst.type, inst);
+                    return true;
+                case BcOp::kMul:
+                    Arith(0, 0x59, true, inst.type, inst);
+                    return true;
+                case BcOp::kAddI32:
+                case BcOp::kAddI64:
+                    IntOp(0x03, false, inst.op == BcOp::kAddI32, inst);
+                    return true;
+                case BcOp::kSubI32:
+                case BcOp::kSubI64:
+                    IntOp(0x2b, false, inst.op == BcOp::kSubI32, inst);
+                    return true;
+                case BcOp::kMulI32:
+                case BcOp::kMulI64:
+                    IntOp(0, true, inst.op == BcOp::kMulI32, inst);
+                    return true;
+                case BcOp::kAddF64:
+                    FloatOp(0x58, true, inst);
+                    return true;
+                case BcOp::kSubF64:
+                    FloatOp(0x5c, true, inst);
+                    return true;
+                case BcOp::kMulF64:
+                    FloatOp(0x59, true, inst);
+                    return true;
+                case BcOp::kDivF64:
+                    FloatOp(0x5e, true, inst);
+                    return true;
+                case BcOp::kDiv:
+                case BcOp::kRem:
+                    Divide(inst.op == BcOp::kDiv, inst.type, inst, pc);
+                    return true;
+                case BcOp::kDivI32:
+                case BcOp::kDivI64:
+                    IntDivide(true, inst.op == BcOp::kDivI32, inst, pc);
+                    return true;
+                case BcOp::kRemI32:
+                case BcOp::kRemI64:
+                    IntDivide(false, inst.op == BcOp::kRemI32, inst, pc);
+                    return true;
+                case BcOp::kAnd:
+                    IntOp(0x23, false, false, inst);
+                    return true;
+                case BcOp::kOr:
+                    IntOp(0x0b, false, false, inst);
+                    return true;
+                case BcOp::kXor:
+                    IntOp(0x33, false, false, inst);
+                    return true;
+                case BcOp::kShl:
+                case BcOp::kShr:
+                    Shift(inst.op == BcOp::kShl, inst.type == IrType::kI32, inst);
+                    return true;
+                case BcOp::kShlI32:
+                case BcOp::kShlI64:
+                    Shift(true, inst.op == BcOp::kShlI32, inst);
+                    return true;
+                case BcOp::kShrI32:
+                case BcOp::kShrI64:
+                    Shift(false, inst.op == BcOp::kShrI32, inst);
+                    return true;
+                case BcOp::kNeg:
+                    Negate(inst.type, inst);
+                    return true;
+                case BcOp::kNegI32:
+                    Negate(IrType::kI32, inst);
+                    return true;
+                case BcOp::kNegF64:
+                    Negate(IrType::kF64, inst);
+                    return true;
+                case BcOp::kNot:
+                    as_.Load(kRax, kRbx, Slot(inst.b));
+                    if (inst.type == IrType::kBool)
+                        as_.AluImm8(6, kRax, 1, true);
+                    else
+                        as_.Not(kRax);
+                    as_.Store(kRbx, Slot(inst.a), kRax);
+                    return true;
+                case BcOp::kEq:
+                case BcOp::kNe:
+                case BcOp::kLt:
+                case BcOp::kLe:
+                case BcOp::kGt:
+                case BcOp::kGe:
+                    Compare(inst.op, inst.type, inst);
+                    return true;
+                case BcOp::kEqI:
+                case BcOp::kNeI:
+                case BcOp::kLtI:
+                case BcOp::kLeI:
+                case BcOp::kGtI:
+                case BcOp::kGeI:
+                    Compare(static_cast<BcOp>(static_cast<int>(BcOp::kEq) + (static_cast<int>(inst.op) - static_cast<int>(BcOp::kEqI))),
+                            IrType::kI64, inst);
+                    return true;
+                case BcOp::kEqF64:
+                case BcOp::kNeF64:
+                case BcOp::kLtF64:
+                case BcOp::kLeF64:
+                case BcOp::kGtF64:
+                case BcOp::kGeF64:
+                    Compare(static_cast<BcOp>(static_cast<int>(BcOp::kEq) + (static_cast<int>(inst.op) - static_cast<int>(BcOp::kEqF64))),
+                            IrType::kF64, inst);
+                    return true;
+                case BcOp::kConvert:
+                {
+                    IrType from = static_cast<IrType>(inst.c);
+                    if (inst.type == IrType::kRef || from == IrType::kRef)
+                        return false;
+                    Convert(from, inst.type, inst);
+                    return true;
+                }
+                case BcOp::kConvI64I32:
+                    as_.Load(kRax, kRbx, Slot(inst.b));
+                    as_.Movsxd(kRax, kRax);
+                    as_.Store(kRbx, Slot(inst.a), kRax);
+                    return true;
+                case BcOp::kConvIF64:
+                    as_.Load(kRax, kRbx, Slot(inst.b));
+                    as_.Cvtsi2sd(kXmm0, kRax);
+                    as_.Sse(0xf2, 0x11, kXmm0, kRbx, Slot(inst.a));
+                    return true;
+                case BcOp::kConvF64I32:
+                    Convert(IrType::kF64, IrType::kI32, inst);
+                    return true;
+                case BcOp::kGetField:
+                    LoadRef(kRax, inst.b, pc);
+                    as_.Load(kRax, kRax, kPayload + Slot(inst.c));
+                    as_.Store(kRbx, Slot(inst.a), kRax);
+                    return true;
+                case BcOp::kSetField:
+                    LoadRef(kRsi, inst.a, pc);
+                    as_.Load(kRdx, kRbx, Slot(inst.b));
+                    as_.Store(kRsi, kPayload + Slot(inst.c), kRdx);
+                    if (inst.type == IrType::kRef)
+                        WriteBarrier();
+                    return true;
+                case BcOp::kGetStatic:
+                    as_.MovImm(kRax, reinterpret_cast<std::uint64_t>(statics_ + inst.c));
+                    as_.Load(kRax, kRax, 0);
+                    as_.Store(kRbx, Slot(inst.a), kRax);
+                    return true;
+                case BcOp::kSetStatic:
+                    as_.Load(kRcx, kRbx, Slot(inst.b));
+                    as_.MovImm(kRax, reinterpret_cast<std::uint64_t>(statics_ + inst.c));
+                    as_.Store(kRax, 0, kRcx);
+                    return true;
+                case BcOp::kGetElem:
+                    LoadIndexed(inst.b, inst.c, pc);
+                    as_.ShlImm(kRcx, 3);
+                    as_.Add(kRax, kRcx);
+                    as_.Load(kRax, kRax, kPayload);
+                    as_.Store(kRbx, Slot(inst.a), kRax);
+                    return true;
+                case BcOp::kSetElem:
+                    LoadIndexed(inst.a, inst.b, pc);
+                    as_.ShlImm(kRcx, 3);
+                    as_.Add(kRcx, kRax);
+                    as_.Load(kRdx, kRbx, Slot(inst.c));
+                    as_.Store(kRcx, kPayload, kRdx);
+                    if (inst.type == IrType::kRef)
+                    {
+                        as_.Mov(kRsi, kRax);
+                        WriteBarrier();
+                    }
+                    return true;
+                case BcOp::kArrayLength:
+                case BcOp::kStringLength:
+                    LoadRef(kRax, inst.b, pc);
+                    as_.Load32(kRax, kRax, kInfo);
+                    as_.Store(kRbx, Slot(inst.a), kRax);
+                    return true;
+                case BcOp::kCharAt:
+                    // ropes are flattened by the interpreter.
+                    LoadIndexed(inst.b, inst.c, pc);
+                    as_.CmpByte(kRax, kKind, static_cast<std::uint8_t>(ObjectKind::kString));
+                    BailIf(kNotEqual, pc);
+                    as_.Add(kRax, kRcx);
+                    as_.MovzxByte(kRax, kRax, kPayload);
+                    as_.Store(kRbx, Slot(inst.a), kRax);
+                    return true;
+                case BcOp::kAddField:
+                    LoadRef(kRax, inst.a, pc);
+                    AddTo(kRax, kPayload + Slot(inst.c), inst.b, inst.type);
+                    return true;
+                case BcOp::kAddStatic:
+                    as_.MovImm(kRax, reinterpret_cast<std::uint64_t>(statics_ + inst.c));
+                    AddTo(kRax, 0, inst.b, inst.type);
+                    return true;
+                case BcOp::kAddElem:
+                    LoadIndexed(inst.a, inst.b, pc);
+                    as_.ShlImm(kRcx, 3);
+                    as_.Add(kRax, kRcx);
+                    AddTo(kRax, kPayload, inst.c, inst.type);
+                    return true;
+                case BcOp::kJump:
+                    JumpTo(inst.Wide());
+                    return true;
+                case BcOp::kJumpIfTrue:
+                case BcOp::kJumpIfFalse:
+                    as_.Load(kRax, kRbx, Slot(inst.a));
+                    as_.Test(kRax);
+                    JumpIf(inst.op == BcOp::kJumpIfTrue ? kNotEqual : kEqual, inst.Wide());
+                    return true;
+                case BcOp::kJumpIfEqI:
+                case BcOp::kJumpIfNeI:
+                case BcOp::kJumpIfLtI:
+                case BcOp::kJumpIfLeI:
+                case BcOp::kJumpIfGtI:
+                case BcOp::kJumpIfGeI:
+                    as_.Load(kRax, kRbx, Slot(inst.a));
+                    as_.Alu(0x3b, kRax, kRbx, Slot(inst.b));
+                    JumpIf(IntCond(inst.op), (&inst)[1].Wide());
+                    return true;
+                case BcOp::kReturn:
+                    as_.Load(kRax, kRbx, Slot(inst.a));
+                    as_.Store(kR12, 0, kRax);
+                    as_.XorEax();
+                    as_.Patch(as_.Jmp(), epilogue_);
+                    return true;
+                case BcOp::kReturnVoid:
+                    as_.XorEax();
+                    as_.Store(kR12, 0, kRax);
+                    as_.Patch(as_.Jmp(), epilogue_);
+                    return true;
+                default:
+                    return false;
+                }
+            }
+
+            const BcFunction &fn_;
+            Heap &heap_;
+            const StringImage &strings_;
+            Value *statics_;
+            Assembler as_;
+            std::uint32_t epilogue_ = 0;
+            // (offset of a rel32, pc it jumps to)
+            std::vector<std::pair<std::uint32_t, std::uint32_t>> jumps_;
+            // (offset of a rel32, pc the interpreter resumes at)
+            std::vector<std::pair<std::uint32_t, std::uint32_t>> bails_;
+        };
+    }
+
+    JitFunction::~JitFunction()
+    {
+#if TINYCSHARP_JIT
+        if (memory_)
+            munmap(memory_, size_);
+#endif
+    }
+
+    bool JitFunction::Run(Value *regs, JitExit *exit, const void *entry) const
+    {
+        using Native = std::uint32_t (*)(Value *, JitExit *, const void *);
+        return reinterpret_cast<Native>(memory_)(regs, exit, entry) == 0;
+    }
+
+    Jit::Jit(Heap &heap, const StringImage &strings, Value *statics) : heap_(heap), strings_(strings), statics_(statics) {}
+
+    bool Jit::Supported()
+    {
+        return TINYCSHARP_JIT != 0;
+    }
+
+    std::unique_ptr<JitFunction> Jit::Compile(const BcFunction &fn) const
+    {
+#if TINYCSHARP_JIT
+        if (fn.code.empty())
+            return nullptr;
+        std::unique_ptr<JitFunction> out(new JitFunction());
+        std::vector<std::uint8_t> code;
+        Translator(fn, heap_, strings_, statics_).Translate(code, out->entries_);
+        // written while writable, then made executable and read-only.
+        void *memory = mmap(nullptr, code.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED)
+            return nullptr;
+        std::memcpy(memory, code.data(), code.size());
+        if (mprotect(memory, code.size(), PROT_READ | PROT_EXEC) != 0)
+        {
+            munmap(memory, code.size());
+            return nullptr;
+        }
+        out->memory_ = memory;
+        out->size_ = code.size();
+        return out;
+#else
+        (void)fn;
+        return nullptr;
+#endif
+    }
+
+}
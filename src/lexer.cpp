@@ -23,12 +23,16 @@
 #include <sstream>
 #include <exception>
 #include <cctype>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
 
 namespace tinycsharp
 {
 
-    Lexer::Lexer(std::string input)
-        : source(PadSourceStr(input)), position(-1), line(std::make_shared<int>(1)), column(std::make_shared<int>(-1))
+    Lexer::Lexer(std::string input, SourceLocation base)
+        : position(-1), source(PadSourceStr(input)), base(base)
     {
         if (input.empty() || std::all_of(input.begin(), input.end(), ::isspace))
         {
@@ -138,11 +142,10 @@ namespace tinycsharp
             {
                 l += n_char;
                 NextToken();
-                if (c_char == '<')
+                if (Peek() == '<')
                 {
-                    l += c_char;
                     NextToken();
-
+                    l += c_char;
                     return NewToken(TokenKind::kTLShiftAssign, l, position);
                 }
 
@@ -163,11 +166,10 @@ namespace tinycsharp
             {
                 l += n_char;
                 NextToken();
-                if (c_char == '>')
+                if (Peek() == '>')
                 {
-                    l += c_char;
                     NextToken();
-
+                    l += c_char;
                     return NewToken(TokenKind::kTRShiftAssign, l, position);
                 }
 
@@ -323,17 +325,35 @@ namespace tinycsharp
 
         return tok;
     }
+    std::vector<Token> Lexer::Tokenize()
+    {
+        std::vector<Token> tokens;
+        while (true)
+        {
+            Token tok = Lex();
+            if (tok.kind == TokenKind::kTEof)
+            {
+                tok.lexeme.clear();
+                // the end of the text, past the padding's first space.
+                tok.loc = base + static_cast<long>(source.size() - 2);
+                tokens.push_back(std::move(tok));
+                break;
+            }
+            tokens.push_back(std::move(tok));
+        }
+        return tokens;
+    }
     Token Lexer::NewToken(const TokenKind &kind, const std::string &lexeme, int start_pos)
     {
         Token tok{kind, lexeme};
-        tok.line = *line;
-        tok.column = *column - (position - start_pos);
+        // positions count the space the source is padded with.
+        tok.loc = base + (start_pos - 1);
         return tok;
     }
-    Token Lexer::NewToken(const TokenKind &kind, const std::string &lexeme, int start_pos, int int_val)
+    Token Lexer::NewToken(const TokenKind &kind, const std::string &lexeme, int start_pos, std::int64_t int_val)
     {
         Token tok = NewToken(kind, lexeme, start_pos);
-        tok.int_val = std::make_unique<int>(std::move(int_val));
+        tok.int_val = std::make_shared<std::int64_t>(int_val);
         return tok;
     }
     Token Lexer::NewToken(const TokenKind &kind, const std::string &lexeme, int start_pos, double float_val)
@@ -352,15 +372,6 @@ namespace tinycsharp
         else
         {
             c_char = source[position];
-            if (c_char == '\n')
-            {
-                (*line)++;
-                (*column) = 0;
-            }
-            else
-            {
-                (*column)++;
-            }
         }
     }
     Token Lexer::MakeStringLiteralToken()
@@ -368,6 +379,10 @@ namespace tinycsharp
         char stop_char = c_char;
         NextToken();
         int curr_pos = position;
+        if (c_char == stop_char)
+        {
+            return NewToken(TokenKind::kTSLiteral, "", curr_pos - 1);
+        }
         while (c_char != '\0' && Peek() != stop_char)
         {
             NextToken();
@@ -419,7 +434,17 @@ namespace tinycsharp
         {
             return NewToken(TokenKind::kTNLiteral, number_literal, start_pos, std::stod(number_literal));
         }
-        return NewToken(TokenKind::kTNLiteral, number_literal, start_pos, std::stoi(number_literal));
+        // literals are kept at 64 bits; sema types those past int.MaxValue as long.
+        // 9223372036854775808 only fits once negated, so it is lexed as
+        // long.MinValue and the parser rejects it anywhere but after a '-'.
+        errno = 0;
+        char *end = nullptr;
+        unsigned long long value = std::strtoull(number_literal.c_str(), &end, 10);
+        if (errno == ERANGE || value > static_cast<unsigned long long>(INT64_MAX) + 1)
+        {
+            throw std::runtime_error("Integral constant is too large: " + number_literal);
+        }
+        return NewToken(TokenKind::kTNLiteral, number_literal, start_pos, static_cast<std::int64_t>(value));
     }
     bool Lexer::IsCharAValidIdentElem(char32_t n_char)
     {
@@ -429,11 +454,6 @@ namespace tinycsharp
     {
         while (std::isspace(c_char))
         {
-            if (IsNewlineChar(c_char))
-            {
-                (*line)++;
-                (*column) = 1;
-            }
             NextToken();
         }
     }
@@ -466,8 +486,6 @@ namespace tinycsharp
     {
         if (IsNewlineChar(c_char))
         {
-            (*line)++;
-            (*column) = 1;
             return;
         }
         if (c_char != '\0' && (c_char == '#' || (c_char = '/' && n_char == '/')))
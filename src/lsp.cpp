@@ -0,0 +1,1280 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include "lsp.h"
+#include "ast.h"
+#include "cache.h"
+#include "lexer.h"
+#include "parser.h"
+#include "sema.h"
+#include "types.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
+
+namespace tinycsharp
+{
+    void TokenStream::Reset(std::string text)
+    {
+        text_ = std::move(text);
+        Relex(0, 0, LONG_MAX);
+    }
+
+    void TokenStream::Edit(std::size_t offset, std::size_t length, std::string_view text)
+    {
+        offset = std::min(offset, text_.size());
+        length = std::min(length, text_.size() - offset);
+        text_.replace(offset, length, text);
+        if (!error_.empty() || tokens_.size() < 2)
+        {
+            Relex(0, 0, LONG_MAX);
+            return;
+        }
+        // positions are the lexer's, in the source padded with one space on
+        // each side. a token is kept when the lexer, peeking one character
+        // past it, stayed clear of the edit.
+        long first = static_cast<long>(offset) + 1;
+        auto end = after_.end() - 1; // the end of file is always re-lexed
+        auto kept = std::partition_point(after_.begin(), end, [&](int position)
+                                         { return position + 1 < first; });
+        Relex(static_cast<std::size_t>(kept - after_.begin()), static_cast<long>(text.size()) - static_cast<long>(length),
+              first + static_cast<long>(length));
+    }
+
+    // re-lexes from the state after the first keep tokens. edit_end is the
+    // first old position past the edit, and delta how far the edit moved the
+    // text after it; once a new token leaves the lexer where an old one past
+    // edit_end did, the rest of the old tokens are shifted rather than lexed.
+    void TokenStream::Relex(std::size_t keep, long delta, long edit_end)
+    {
+        error_.clear();
+        error_line_ = 0;
+        if (std::all_of(text_.begin(), text_.end(), [](unsigned char c)
+                        { return std::isspace(c); }))
+        {
+            tokens_.clear();
+            after_.clear();
+            tokens_.push_back(Token{TokenKind::kTEof, ""});
+            after_.push_back(0);
+            relexed_ = 1;
+            return;
+        }
+
+        Lexer lexer{text_};
+        if (keep > 0)
+        {
+            lexer.position = after_[keep - 1];
+            lexer.c_char = static_cast<unsigned char>(lexer.source[lexer.position]);
+        }
+        std::vector<Token> fresh;
+        std::vector<int> states;
+        std::size_t resume = tokens_.size();
+        try
+        {
+            for (;;)
+            {
+                Token tok = lexer.Lex();
+                int position = lexer.position;
+                if (tok.kind == TokenKind::kTEof)
+                {
+                    tok.lexeme.clear();
+                    tok.loc = SourceLocation{static_cast<std::uint32_t>(text_.size())};
+                    fresh.push_back(std::move(tok));
+                    states.push_back(position);
+                    break;
+                }
+                fresh.push_back(std::move(tok));
+                states.push_back(position);
+                long old = position - delta;
+                if (old + 1 >= edit_end && after_.size() > keep)
+                {
+                    auto it = std::lower_bound(after_.begin() + keep, after_.end() - 1, old);
+                    if (it != after_.end() - 1 && *it == old)
+                    {
+                        resume = static_cast<std::size_t>(it - after_.begin()) + 1;
+                        break;
+                    }
+                }
+            }
+        }
+        catch (const std::exception &e)
+        {
+            error_ = e.what();
+            // the lexer stopped at position, which counts as the line of
+            // the character there.
+            std::size_t at = std::min(static_cast<std::size_t>(std::max(lexer.position, 0)), text_.size());
+            error_line_ = 1 + static_cast<int>(std::count(text_.begin(), text_.begin() + at, '\n'));
+            tokens_.clear();
+            after_.clear();
+            Token eof{TokenKind::kTEof, ""};
+            eof.loc = SourceLocation{static_cast<std::uint32_t>(at)};
+            tokens_.push_back(std::move(eof));
+            after_.push_back(0);
+            relexed_ = fresh.size();
+            return;
+        }
+
+        for (std::size_t i = resume; i < tokens_.size(); i++)
+        {
+            tokens_[i].loc = tokens_[i].loc + delta;
+            after_[i] += static_cast<int>(delta);
+        }
+        relexed_ = fresh.size();
+        tokens_.erase(tokens_.begin() + keep, tokens_.begin() + resume);
+        tokens_.insert(tokens_.begin() + keep, std::make_move_iterator(fresh.begin()), std::make_move_iterator(fresh.end()));
+        after_.erase(after_.begin() + keep, after_.begin() + resume);
+        after_.insert(after_.begin() + keep, states.begin(), states.end());
+    }
+
+    std::vector<Token> TokenStream::CopyTokens(SourceLocation base) const
+    {
+        std::vector<Token> copy;
+        copy.reserve(tokens_.size());
+        for (const Token &tok : tokens_)
+        {
+            Token t{tok.kind, tok.lexeme};
+            t.int_val = tok.int_val;
+            t.float_val = tok.float_val;
+            t.loc = base + tok.loc.offset;
+            copy.push_back(std::move(t));
+        }
+        return copy;
+    }
+
+    // a JSON value, enough of one for the protocol. objects keep their
+    // fields in order.
+    struct LanguageServer::Json
+    {
+        enum class Kind : std::uint8_t
+        {
+            kNull,
+            kBool,
+            kNumber,
+            kString,
+            kArray,
+            kObject,
+        };
+
+        Kind kind = Kind::kNull;
+        bool boolean = false;
+        double number = 0;
+        std::string string;
+        std::vector<Json> items;
+        std::vector<std::pair<std::string, Json>> fields;
+
+        Json() = default;
+        Json(std::nullptr_t) {}
+        Json(bool b) : kind(Kind::kBool), boolean(b) {}
+        Json(int n) : kind(Kind::kNumber), number(n) {}
+        Json(long n) : kind(Kind::kNumber), number(static_cast<double>(n)) {}
+        Json(double n) : kind(Kind::kNumber), number(n) {}
+        Json(std::string s) : kind(Kind::kString), string(std::move(s)) {}
+        Json(const char *s) : kind(Kind::kString), string(s) {}
+
+        static Json Array()
+        {
+            Json j;
+            j.kind = Kind::kArray;
+            return j;
+        }
+        static Json Object()
+        {
+            Json j;
+            j.kind = Kind::kObject;
+            return j;
+        }
+
+        Json &Set(std::string key, Json value)
+        {
+            fields.emplace_back(std::move(key), std::move(value));
+            return *this;
+        }
+        Json &Add(Json value)
+        {
+            items.push_back(std::move(value));
+            return *this;
+        }
+
+        const Json &operator[](std::string_view key) const
+        {
+            static const Json null;
+            for (const auto &[name, value] : fields)
+            {
+                if (name == key)
+                    return value;
+            }
+            return null;
+        }
+
+        bool IsNull() const { return kind == Kind::kNull; }
+        bool Has(std::string_view key) const { return !(*this)[key].IsNull(); }
+        long Int() const { return static_cast<long>(number); }
+        const std::string &Str() const { return string; }
+    };
+
+    namespace
+    {
+        using Json = LanguageServer::Json;
+
+        class JsonReader
+        {
+        public:
+            explicit JsonReader(std::string_view text) : text_(text) {}
+
+            Json Read()
+            {
+                Json value = Value();
+                Space();
+                if (pos_ != text_.size())
+                    Fail("trailing characters");
+                return value;
+            }
+
+        private:
+            [[noreturn]] void Fail(const char *what)
+            {
+                throw std::runtime_error(std::string("json: ") + what + " at offset " + std::to_string(pos_));
+            }
+
+            void Space()
+            {
+                while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_])))
+                    pos_++;
+            }
+
+            bool Eat(char c)
+            {
+                Space();
+                if (pos_ < text_.size() && text_[pos_] == c)
+                {
+                    pos_++;
+                    return true;
+                }
+                return false;
+            }
+
+            void Expect(char c)
+            {
+                if (!Eat(c))
+                    Fail("unexpected character");
+            }
+
+            bool Word(std::string_view word)
+            {
+                if (text_.substr(pos_, word.size()) != word)
+                    return false;
+                pos_ += word.size();
+                return true;
+            }
+
+            Json Value()
+            {
+                Space();
+                if (pos_ >= text_.size())
+                    Fail("unexpected end");
+                char c = text_[pos_];
+                if (c == '{')
+                {
+                    pos_++;
+                    Json object = Json::Object();
+                    if (Eat('}'))
+                        return object;
+                    do
+                    {
+                        Space();
+                        std::string key = String();
+                        Expect(':');
+                        object.Set(std::move(key), Value());
+                    } while (Eat(','));
+                    Expect('}');
+                    return object;
+                }
+                if (c == '[')
+                {
+                    pos_++;
+                    Json array = Json::Array();
+                    if (Eat(']'))
+                        return array;
+                    do
+                    {
+                        array.Add(Value());
+                    } while (Eat(','));
+                    Expect(']');
+                    return array;
+                }
+                if (c == '"')
+                    return Json(String());
+                if (Word("true"))
+                    return Json(true);
+                if (Word("false"))
+                    return Json(false);
+                if (Word("null"))
+                    return Json();
+                std::size_t start = pos_;
+                while (pos_ < text_.size() && std::strchr("+-.0123456789eE", text_[pos_]))
+                    pos_++;
+                if (start == pos_)
+                    Fail("unexpected character");
+                return Json(std::strtod(std::string(text_.substr(start, pos_ - start)).c_str(), nullptr));
+            }
+
+            unsigned Hex4()
+            {
+                if (pos_ + 4 > text_.size())
+                    Fail("bad escape");
+                unsigned value = 0;
+                for (int i = 0; i < 4; i++)
+                {
+                    char c = text_[pos_++];
+                    value <<= 4;
+                    if (c >= '0' && c <= '9')
+                        value |= static_cast<unsigned>(c - '0');
+                    else if (c >= 'a' && c <= 'f')
+                        value |= static_cast<unsigned>(c - 'a' + 10);
+                    else if (c >= 'A' && c <= 'F')
+                        value |= static_cast<unsigned>(c - 'A' + 10);
+                    else
+                        Fail("bad escape");
+                }
+                return value;
+            }
+
+            static void AppendUtf8(std::string &out, unsigned cp)
+            {
+                if (cp < 0x80)
+                {
+                    out += static_cast<char>(cp);
+                }
+                else if (cp < 0x800)
+                {
+                    out += static_cast<char>(0xC0 | (cp >> 6));
+                    out += static_cast<char>(0x80 | (cp & 0x3F));
+                }
+                else if (cp < 0x10000)
+                {
+                    out += static_cast<char>(0xE0 | (cp >> 12));
+                    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (cp & 0x3F));
+                }
+                else
+                {
+                    out += static_cast<char>(0xF0 | (cp >> 18));
+                    out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+                    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (cp & 0x3F));
+                }
+            }
+
+            std::string String()
+            {
+                if (pos_ >= text_.size() || text_[pos_] != '"')
+                    Fail("expected a string");
+                pos_++;
+                std::string out;
+                for (;;)
+                {
+                    if (pos_ >= text_.size())
+                        Fail("unterminated string");
+                    char c = text_[pos_++];
+                    if (c == '"')
+                        return out;
+                    if (c != '\\')
+                    {
+                        out += c;
+                        continue;
+                    }
+                    if (pos_ >= text_.size())
+                        Fail("unterminated string");
+                    switch (text_[pos_++])
+                    {
+                    case '"':
+                        out += '"';
+                        break;
+                    case '\\':
+                        out += '\\';
+                        break;
+                    case '/':
+                        out += '/';
+                        break;
+                    case 'b':
+                        out += '\b';
+                        break;
+                    case 'f':
+                        out += '\f';
+                        break;
+                    case 'n':
+                        out += '\n';
+                        break;
+                    case 'r':
+                        out += '\r';
+                        break;
+                    case 't':
+                        out += '\t';
+                        break;
+                    case 'u':
+                    {
+                        unsigned cp = Hex4();
+                        if (cp >= 0xD800 && cp < 0xDC00 && text_.substr(pos_, 2) == "\\u")
+                        {
+                            pos_ += 2;
+                            unsigned low = Hex4();
+                            cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                        }
+                        AppendUtf8(out, cp);
+                        break;
+                    }
+                    default:
+                        Fail("bad escape");
+                    }
+                }
+            }
+
+            std::string_view text_;
+            std::size_t pos_ = 0;
+        };
+
+        void WriteString(std::string &out, const std::string &s)
+        {
+            out += '"';
+            for (unsigned char c : s)
+            {
+                switch (c)
+                {
+                case '"':
+                    out += "\\\"";
+                    break;
+                case '\\':
+                    out += "\\\\";
+                    break;
+                case '\n':
+                    out += "\\n";
+                    break;
+                case '\r':
+                    out += "\\r";
+                    break;
+                case '\t':
+                    out += "\\t";
+                    break;
+                default:
+                    if (c < 0x20)
+                    {
+                        char buf[8];
+                        std::snprintf(buf, sizeof buf, "\\u%04x", c);
+                        out += buf;
+                    }
+                    else
+                    {
+                        out += static_cast<char>(c);
+                    }
+                }
+            }
+            out += '"';
+        }
+
+        void WriteJson(std::string &out, const Json &j)
+        {
+            switch (j.kind)
+            {
+            case Json::Kind::kNull:
+                out += "null";
+                break;
+            case Json::Kind::kBool:
+                out += j.boolean ? "true" : "false";
+                break;
+            case Json::Kind::kNumber:
+            {
+                char buf[32];
+                if (j.number == std::floor(j.number) && std::fabs(j.number) < 1e15)
+                    std::snprintf(buf, sizeof buf, "%lld", static_cast<long long>(j.number));
+                else
+                    std::snprintf(buf, sizeof buf, "%.17g", j.number);
+                out += buf;
+                break;
+            }
+            case Json::Kind::kString:
+                WriteString(out, j.string);
+                break;
+            case Json::Kind::kArray:
+                out += '[';
+                for (std::size_t i = 0; i < j.items.size(); i++)
+                {
+                    if (i)
+                        out += ',';
+                    WriteJson(out, j.items[i]);
+                }
+                out += ']';
+                break;
+            case Json::Kind::kObject:
+                out += '{';
+                for (std::size_t i = 0; i < j.fields.size(); i++)
+                {
+                    if (i)
+                        out += ',';
+                    WriteString(out, j.fields[i].first);
+                    out += ':';
+                    WriteJson(out, j.fields[i].second);
+                }
+                out += '}';
+                break;
+            }
+        }
+
+        std::string Dump(const Json &j)
+        {
+            std::string out;
+            WriteJson(out, j);
+            return out;
+        }
+
+        // UTF-16 code units in the first bytes bytes of a line, which is how
+        // the protocol counts characters.
+        int Utf16Length(std::string_view line, std::size_t bytes)
+        {
+            int units = 0;
+            for (std::size_t i = 0; i < bytes && i < line.size(); i++)
+            {
+                unsigned char c = static_cast<unsigned char>(line[i]);
+                if ((c & 0xC0) != 0x80)
+                    units += c >= 0xF0 ? 2 : 1;
+            }
+            return units;
+        }
+
+        std::size_t ByteLength(std::string_view line, int units)
+        {
+            std::size_t i = 0;
+            while (i < line.size() && units > 0)
+            {
+                unsigned char c = static_cast<unsigned char>(line[i]);
+                units -= c >= 0xF0 ? 2 : 1;
+                i++;
+                while (i < line.size() && (static_cast<unsigned char>(line[i]) & 0xC0) == 0x80)
+                    i++;
+            }
+            return i;
+        }
+
+        bool IsIdentChar(char c)
+        {
+            return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+        }
+
+        std::string TypeName(const Type *type)
+        {
+            return type ? TypeToString(type) : "?";
+        }
+
+        // the class a type names, looking through arrays and tasks.
+        ClassInfo *ClassOf(const Type *type)
+        {
+            while (type && (type->kind == TypeKind::kArray || type->kind == TypeKind::kTask))
+                type = type->element;
+            return type && type->kind == TypeKind::kClass ? type->cls : nullptr;
+        }
+
+        std::string Describe(const Node *decl)
+        {
+            std::string s;
+            if (auto cls = NodeCast<ClassDecl>(decl))
+            {
+                s = cls->is_struct ? "struct " : "class ";
+                s += cls->info ? cls->info->qualified_name : std::string(cls->name);
+                if (cls->info && cls->info->base)
+                    s += " : " + cls->info->base->qualified_name;
+            }
+            else if (auto method = NodeCast<MethodDecl>(decl))
+            {
+                const MethodInfo *info = method->info;
+                if (method->modifiers & kModStatic)
+                    s += "static ";
+                if (!method->is_ctor)
+                    s += TypeName(info ? info->return_type : nullptr) + " ";
+                s += info ? info->owner->qualified_name : std::string(method->owner->name);
+                if (!method->is_ctor)
+                    s += "." + std::string(method->name);
+                s += "(";
+                for (std::uint32_t i = 0; i < method->params.count; i++)
+                {
+                    const ParamDecl *param = method->params.items[i];
+                    if (i)
+                        s += ", ";
+                    s += TypeName(param->resolved_type) + " " + std::string(param->name);
+                }
+                s += ")";
+            }
+            else if (auto field = NodeCast<FieldDecl>(decl))
+            {
+                const FieldInfo *info = field->info;
+                if (info && info->is_const)
+                    s += "const ";
+                else if (field->modifiers & kModStatic)
+                    s += "static ";
+                s += TypeName(info ? info->type : nullptr) + " ";
+                s += info ? info->owner->qualified_name : std::string(field->owner->name);
+                s += "." + std::string(field->name);
+            }
+            else if (auto param = NodeCast<ParamDecl>(decl))
+            {
+                s = "(parameter) " + TypeName(param->resolved_type) + " " + std::string(param->name);
+            }
+            else if (auto local = NodeCast<LocalVarStmt>(decl))
+            {
+                s = std::string(local->is_const ? "(local constant) " : "(local) ") + TypeName(local->resolved_type) + " " +
+                    std::string(local->name);
+            }
+            return s;
+        }
+
+        std::string_view DeclName(const Node *decl)
+        {
+            switch (decl->kind)
+            {
+            case NodeKind::kClassDecl:
+                return static_cast<const ClassDecl *>(decl)->name;
+            case NodeKind::kMethodDecl:
+                return static_cast<const MethodDecl *>(decl)->name;
+            case NodeKind::kFieldDecl:
+                return static_cast<const FieldDecl *>(decl)->name;
+            case NodeKind::kParamDecl:
+                return static_cast<const ParamDecl *>(decl)->name;
+            case NodeKind::kLocalVarStmt:
+                return static_cast<const LocalVarStmt *>(decl)->name;
+            default:
+                return {};
+            }
+        }
+    }
+
+    struct LanguageServer::Symbol
+    {
+        int line;
+        int column; // in bytes, from 1
+        int length;
+        const Node *decl;
+    };
+
+    struct LanguageServer::Document
+    {
+        std::string uri;
+        TokenStream tokens;
+        std::vector<std::size_t> line_starts;
+        bool parsed = false; // ast matches the text
+        std::unique_ptr<AstContext> ast;
+        std::vector<Diagnostic> diagnostics;
+        // the symbols of line l are symbols[by_line[l - 1] .. by_line[l]).
+        bool indexed = false;
+        std::vector<Symbol> symbols;
+        std::vector<std::uint32_t> by_line;
+
+        void SetText(std::string text)
+        {
+            tokens.Reset(std::move(text));
+            Lines();
+        }
+
+        void Lines()
+        {
+            const std::string &text = tokens.text();
+            line_starts.assign(1, 0);
+            for (std::size_t i = 0; i < text.size(); i++)
+            {
+                if (text[i] == '\n')
+                    line_starts.push_back(i + 1);
+            }
+            parsed = false;
+        }
+
+        // line is counted from 1, without its newline.
+        std::string_view Line(int line) const
+        {
+            if (line < 1 || static_cast<std::size_t>(line) > line_starts.size())
+                return {};
+            std::string_view text = tokens.text();
+            std::size_t start = line_starts[line - 1];
+            std::size_t end = static_cast<std::size_t>(line) < line_starts.size() ? line_starts[line] - 1 : text.size();
+            if (end > start && text[end - 1] == '\r')
+                end--;
+            return text.substr(start, end - start);
+        }
+
+        std::size_t Offset(const Json &position) const
+        {
+            long line = position["line"].Int();
+            if (line < 0)
+                return 0;
+            if (static_cast<std::size_t>(line) >= line_starts.size())
+                return tokens.text().size();
+            return line_starts[line] + ByteLength(Line(static_cast<int>(line) + 1), static_cast<int>(position["character"].Int()));
+        }
+
+        Json Position(int line, int column) const
+        {
+            line = std::max(line, 1);
+            column = std::max(column, 1);
+            return Json::Object()
+                .Set("line", line - 1)
+                .Set("character", Utf16Length(Line(line), static_cast<std::size_t>(column - 1)));
+        }
+
+        // where a node of the document's syntax tree is.
+        SourcePosition Locate(const Node *node) const { return ast->sources().Decode(node->loc); }
+
+        Json Range(int line, int column, int length) const
+        {
+            return Json::Object().Set("start", Position(line, column)).Set("end", Position(line, column + length));
+        }
+
+        // finds name as a whole word at or after line:column, where the
+        // syntax tree places a node ahead of its name.
+        bool Find(std::string_view name, int &line, int &column) const
+        {
+            if (name.empty() || line < 1 || static_cast<std::size_t>(line) > line_starts.size())
+                return false;
+            const std::string &text = tokens.text();
+            std::size_t from = line_starts[line - 1] + static_cast<std::size_t>(std::max(column, 1) - 1);
+            for (std::size_t at = text.find(name, from); at != std::string::npos && at - from < 256; at = text.find(name, at + 1))
+            {
+                if ((at > 0 && IsIdentChar(text[at - 1])) || (at + name.size() < text.size() && IsIdentChar(text[at + name.size()])))
+                    continue;
+                auto it = std::upper_bound(line_starts.begin(), line_starts.end(), at);
+                line = static_cast<int>(it - line_starts.begin());
+                column = static_cast<int>(at - line_starts[line - 1]) + 1;
+                return true;
+            }
+            return false;
+        }
+    };
+
+    LanguageServer::LanguageServer(std::ostream &out, unsigned jobs) : out_(out), pool_(jobs)
+    {
+    }
+
+    LanguageServer::~LanguageServer() = default;
+
+    void LanguageServer::Post(std::string message)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            queue_.push_back(std::move(message));
+        }
+        cv_.notify_one();
+    }
+
+    void LanguageServer::Close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            closed_ = true;
+        }
+        cv_.notify_one();
+    }
+
+    int LanguageServer::Serve()
+    {
+        for (;;)
+        {
+            std::string message;
+            {
+                std::unique_lock<std::mutex> lock(mu_);
+                if (queue_.empty() && dirty_)
+                {
+                    // nothing is waiting: a good time to analyze.
+                    lock.unlock();
+                    Analyze();
+                    continue;
+                }
+                cv_.wait(lock, [&]
+                         { return !queue_.empty() || closed_; });
+                if (queue_.empty())
+                    return shutdown_ ? 0 : 1;
+                message = std::move(queue_.front());
+                queue_.pop_front();
+            }
+            Json parsed;
+            try
+            {
+                parsed = JsonReader(message).Read();
+            }
+            catch (const std::exception &e)
+            {
+                ReplyError(Json(), -32700, e.what());
+                continue;
+            }
+            if (parsed["method"].Str() == "exit")
+                return shutdown_ ? 0 : 1;
+            Handle(parsed);
+        }
+    }
+
+    void LanguageServer::Handle(const Json &message)
+    {
+        const std::string &method = message["method"].Str();
+        const Json &id = message["id"];
+        const Json &params = message["params"];
+        bool request = message.Has("id");
+
+        if (method == "initialize")
+        {
+            Json sync = Json::Object().Set("openClose", true).Set("change", 2);
+            Json capabilities = Json::Object()
+                                    .Set("textDocumentSync", std::move(sync))
+                                    .Set("hoverProvider", true)
+                                    .Set("definitionProvider", true);
+            Reply(id, Json::Object()
+                          .Set("capabilities", std::move(capabilities))
+                          .Set("serverInfo", Json::Object().Set("name", "tinycsharp").Set("version", TINYCSHARP_VERSION)));
+        }
+        else if (method == "shutdown")
+        {
+            shutdown_ = true;
+            Reply(id, Json());
+        }
+        else if (method == "textDocument/didOpen")
+        {
+            const Json &item = params["textDocument"];
+            auto &doc = documents_[item["uri"].Str()];
+            doc = std::make_unique<Document>();
+            doc->uri = item["uri"].Str();
+            doc->SetText(item["text"].Str());
+            dirty_ = true;
+        }
+        else if (method == "textDocument/didChange")
+        {
+            Change(params);
+        }
+        else if (method == "textDocument/didClose")
+        {
+            const std::string &uri = params["textDocument"]["uri"].Str();
+            if (documents_.erase(uri))
+            {
+                dirty_ = true;
+                Send(Json::Object()
+                         .Set("jsonrpc", "2.0")
+                         .Set("method", "textDocument/publishDiagnostics")
+                         .Set("params", Json::Object().Set("uri", uri).Set("diagnostics", Json::Array())));
+            }
+        }
+        else if (method == "textDocument/hover" || method == "textDocument/definition")
+        {
+            if (IsStale(message))
+            {
+                ReplyError(id, -32800, "request cancelled");
+                return;
+            }
+            if (dirty_)
+                Analyze();
+            Document *doc = nullptr;
+            const Symbol *symbol = SymbolAt(params, doc);
+            if (!symbol)
+            {
+                Reply(id, Json());
+            }
+            else if (method == "textDocument/hover")
+            {
+                Json contents = Json::Object().Set("kind", "markdown").Set("value", "```csharp\n" + Describe(symbol->decl) + "\n```");
+                Reply(id, Json::Object().Set("contents", std::move(contents)).Set("range", doc->Range(symbol->line, symbol->column, symbol->length)));
+            }
+            else
+            {
+                Reply(id, Location(symbol->decl, *doc));
+            }
+        }
+        else if (request)
+        {
+            ReplyError(id, -32601, "method not found: " + method);
+        }
+        // other notifications, initialized and $/cancelRequest among them,
+        // need nothing here.
+    }
+
+    void LanguageServer::Reply(const Json &id, Json result)
+    {
+        Send(Json::Object().Set("jsonrpc", "2.0").Set("id", id).Set("result", std::move(result)));
+    }
+
+    void LanguageServer::ReplyError(const Json &id, int code, const std::string &message)
+    {
+        Json error = Json::Object().Set("code", code).Set("message", message);
+        Send(Json::Object().Set("jsonrpc", "2.0").Set("id", id).Set("error", std::move(error)));
+    }
+
+    void LanguageServer::Send(const Json &message)
+    {
+        std::string body = Dump(message);
+        out_ << "Content-Length: " << body.size() << "\r\n\r\n"
+             << body;
+        out_.flush();
+    }
+
+    // a request is stale once an edit of its document or its cancellation
+    // is queued behind it; both are rare enough that a substring test keeps
+    // the other messages from being parsed.
+    bool LanguageServer::IsStale(const Json &request)
+    {
+        const std::string &uri = request["params"]["textDocument"]["uri"].Str();
+        std::string id = Dump(request["id"]);
+        std::lock_guard<std::mutex> lock(mu_);
+        for (const std::string &queued : queue_)
+        {
+            bool change = queued.find("textDocument/didChange") != std::string::npos;
+            bool cancel = queued.find("$/cancelRequest") != std::string::npos;
+            if (!change && !cancel)
+                continue;
+            Json message;
+            try
+            {
+                message = JsonReader(queued).Read();
+            }
+            catch (const std::exception &)
+            {
+                continue;
+            }
+            const std::string &method = message["method"].Str();
+            if (method == "textDocument/didChange" && message["params"]["textDocument"]["uri"].Str() == uri)
+                return true;
+            if (method == "$/cancelRequest" && Dump(message["params"]["id"]) == id)
+                return true;
+        }
+        return false;
+    }
+
+    void LanguageServer::Change(const Json &params)
+    {
+        auto it = documents_.find(params["textDocument"]["uri"].Str());
+        if (it == documents_.end())
+            return;
+        Document &doc = *it->second;
+        for (const Json &change : params["contentChanges"].items)
+        {
+            if (!change.Has("range"))
+            {
+                doc.SetText(change["text"].Str());
+                continue;
+            }
+            std::size_t start = doc.Offset(change["range"]["start"]);
+            std::size_t end = std::max(start, doc.Offset(change["range"]["end"]));
+            doc.tokens.Edit(start, end - start, change["text"].Str());
+            doc.Lines();
+        }
+        dirty_ = true;
+    }
+
+    // re-parses the documents whose text changed, then checks every open
+    // document together and publishes each one's diagnostics.
+    void LanguageServer::Analyze()
+    {
+        std::vector<CompilationUnit *> units;
+        std::vector<Document *> docs;
+        for (auto &[uri, doc] : documents_)
+        {
+            docs.push_back(doc.get());
+            if (!doc->parsed)
+            {
+                doc->parsed = true;
+                doc->ast.reset();
+                doc->diagnostics.clear();
+                if (!doc->tokens.error().empty())
+                {
+                    doc->diagnostics.push_back(Diagnostic{Severity::kError, uri, doc->tokens.error_line(), 1, doc->tokens.error()});
+                    continue;
+                }
+                auto ast = std::make_unique<AstContext>(interner_);
+                try
+                {
+                    SourceLocation base = ast->sources().Begin(ast->sources().AddFile(uri, doc->tokens.text()));
+                    Parser parser{*ast, doc->tokens.CopyTokens(base), uri};
+                    parser.ParseCompilationUnit();
+                    doc->ast = std::move(ast);
+                }
+                catch (const ParseError &e)
+                {
+                    // the message repeats the position after the file name.
+                    std::string message = e.what();
+                    std::string prefix = uri + ":";
+                    if (message.compare(0, prefix.size(), prefix) == 0)
+                    {
+                        std::size_t at = message.find(": ", prefix.size());
+                        if (at != std::string::npos)
+                            message.erase(0, at + 2);
+                    }
+                    doc->diagnostics.push_back(Diagnostic{Severity::kError, uri, e.line, e.column, message});
+                }
+                catch (const std::exception &e)
+                {
+                    doc->diagnostics.push_back(Diagnostic{Severity::kError, uri, 1, 1, e.what()});
+                }
+            }
+            if (doc->ast)
+                units.insert(units.end(), doc->ast->units.begin(), doc->ast->units.end());
+        }
+
+        auto sema = std::make_unique<Sema>(interner_);
+        sema->Analyze(units, &pool_);
+        sema_ = std::move(sema);
+        dirty_ = false;
+
+        std::sort(docs.begin(), docs.end(), [](const Document *a, const Document *b)
+                  { return a->uri < b->uri; });
+        for (Document *doc : docs)
+        {
+            doc->indexed = false;
+            Json diagnostics = Json::Array();
+            auto publish = [&](const Diagnostic &d)
+            {
+                std::string_view line = doc->Line(d.line);
+                std::size_t at = static_cast<std::size_t>(std::max(d.column, 1) - 1);
+                int length = 1;
+                while (at + length < line.size() && IsIdentChar(line[at]) && IsIdentChar(line[at + length]))
+                    length++;
+                diagnostics.Add(Json::Object()
+                                    .Set("range", doc->Range(d.line, d.column, length))
+                                    .Set("severity", d.severity == Severity::kError ? 1 : 2)
+                                    .Set("source", "tinycsharp")
+                                    .Set("message", d.message));
+            };
+            for (const Diagnostic &d : doc->diagnostics)
+                publish(d);
+            for (const Diagnostic &d : sema_->diagnostics())
+            {
+                if (d.file == doc->uri)
+                    publish(d);
+            }
+            Send(Json::Object()
+                     .Set("jsonrpc", "2.0")
+                     .Set("method", "textDocument/publishDiagnostics")
+                     .Set("params", Json::Object().Set("uri", doc->uri).Set("diagnostics", std::move(diagnostics))));
+        }
+    }
+
+    // records every name in the document with the declaration it binds to:
+    // declarations themselves, names, members and the class names in types.
+    void LanguageServer::Index(Document &doc)
+    {
+        doc.indexed = true;
+        doc.symbols.clear();
+        doc.by_line.assign(doc.line_starts.size() + 1, 0);
+        if (!doc.ast)
+            return;
+        const AstContext &ast = *doc.ast;
+        std::vector<Symbol> found;
+        auto record = [&](int line, int column, std::string_view name, const Node *decl)
+        {
+            if (decl && line >= 1 && static_cast<std::size_t>(line) <= doc.line_starts.size())
+                found.push_back(Symbol{line, column, static_cast<int>(name.size()), decl});
+        };
+        auto add = [&](const Node *at, std::string_view name, const Node *decl)
+        {
+            SourcePosition pos = doc.Locate(at);
+            record(pos.line, pos.column, name, decl);
+        };
+        auto add_found = [&](const Node *at, std::string_view name, const Node *decl)
+        {
+            SourcePosition pos = doc.Locate(at);
+            if (decl && doc.Find(name, pos.line, pos.column))
+                record(pos.line, pos.column, name, decl);
+        };
+        auto add_type = [&](const TypeRef *ref, const Type *type)
+        {
+            ClassInfo *cls = ClassOf(type);
+            if (!ref || !cls || !cls->decl)
+                return;
+            std::string_view name = ref->name.substr(ref->name.rfind('.') == std::string_view::npos ? 0 : ref->name.rfind('.') + 1);
+            add_found(ref, name, cls->decl);
+        };
+
+        for (const Node *node : ast.NodesOfKind(NodeKind::kClassDecl))
+        {
+            auto cls = static_cast<const ClassDecl *>(node);
+            add_found(cls, cls->name, cls);
+            if (cls->info && cls->info->base && cls->bases.count)
+                add_type(cls->bases.items[0], cls->info->base->type);
+        }
+        for (const Node *node : ast.NodesOfKind(NodeKind::kMethodDecl))
+        {
+            auto method = static_cast<const MethodDecl *>(node);
+            add(method, method->name, method);
+            if (method->info)
+                add_type(method->return_type, method->info->return_type);
+        }
+        for (const Node *node : ast.NodesOfKind(NodeKind::kFieldDecl))
+        {
+            auto field = static_cast<const FieldDecl *>(node);
+            add(field, field->name, field);
+            if (field->info)
+                add_type(field->type, field->info->type);
+        }
+        for (const Node *node : ast.NodesOfKind(NodeKind::kParamDecl))
+        {
+            auto param = static_cast<const ParamDecl *>(node);
+            add_found(param, param->name, param);
+            add_type(param->type, param->resolved_type);
+        }
+        for (const Node *node : ast.NodesOfKind(NodeKind::kLocalVarStmt))
+        {
+            auto local = static_cast<const LocalVarStmt *>(node);
+            add(local, local->name, local);
+            add_type(local->type, local->resolved_type);
+        }
+        for (const Node *node : ast.NodesOfKind(NodeKind::kNewExpr))
+        {
+            auto expr = static_cast<const NewExpr *>(node);
+            add_type(expr->type, expr->Expr::type);
+        }
+        for (const Node *node : ast.NodesOfKind(NodeKind::kCastExpr))
+        {
+            auto expr = static_cast<const CastExpr *>(node);
+            add_type(expr->type, expr->Expr::type);
+        }
+
+        // a called name binds to the method the call resolved to.
+        std::unordered_map<const Expr *, const MethodInfo *> targets;
+        for (const Node *node : ast.NodesOfKind(NodeKind::kCallExpr))
+        {
+            auto call = static_cast<const CallExpr *>(node);
+            if (call->target)
+                targets[call->callee] = call->target;
+        }
+        for (const Node *node : ast.NodesOfKind(NodeKind::kNameExpr))
+        {
+            auto name = static_cast<const NameExpr *>(node);
+            auto it = targets.find(name);
+            add(name, name->name, it != targets.end() ? it->second->decl : name->decl);
+        }
+        for (const Node *node : ast.NodesOfKind(NodeKind::kMemberExpr))
+        {
+            auto member = static_cast<const MemberExpr *>(node);
+            auto it = targets.find(member);
+            const Node *decl = it != targets.end() ? static_cast<const Node *>(it->second->decl)
+                                                   : member->field ? member->field->decl
+                                                                   : nullptr;
+            add_found(member, member->name, decl);
+        }
+
+        // bucket by line, keeping the order within a line.
+        for (const Symbol &s : found)
+            doc.by_line[s.line]++;
+        for (std::size_t l = 1; l < doc.by_line.size(); l++)
+            doc.by_line[l] += doc.by_line[l - 1];
+        std::vector<std::uint32_t> next(doc.by_line.begin(), doc.by_line.end() - 1);
+        doc.symbols.resize(found.size());
+        for (const Symbol &s : found)
+            doc.symbols[next[s.line - 1]++] = s;
+    }
+
+    const LanguageServer::Symbol *LanguageServer::SymbolAt(const Json &params, Document *&doc)
+    {
+        auto it = documents_.find(params["textDocument"]["uri"].Str());
+        if (it == documents_.end())
+            return nullptr;
+        doc = it->second.get();
+        if (!doc->indexed)
+            Index(*doc);
+        long line = params["position"]["line"].Int() + 1;
+        if (line < 1 || static_cast<std::size_t>(line) >= doc->by_line.size())
+            return nullptr;
+        int column = static_cast<int>(ByteLength(doc->Line(static_cast<int>(line)), static_cast<int>(params["position"]["character"].Int()))) + 1;
+        for (std::uint32_t i = doc->by_line[line - 1]; i < doc->by_line[line]; i++)
+        {
+            const Symbol &s = doc->symbols[i];
+            if (column >= s.column && column <= s.column + s.length)
+                return &s;
+        }
+        return nullptr;
+    }
+
+    // the document a declaration is in. locals and parameters are only
+    // named within their own document.
+    LanguageServer::Document *LanguageServer::DocumentOf(const Node *decl, Document &from)
+    {
+        const ClassDecl *cls = NodeCast<ClassDecl>(decl);
+        if (auto method = NodeCast<MethodDecl>(decl))
+            cls = method->owner;
+        else if (auto field = NodeCast<FieldDecl>(decl))
+            cls = field->owner;
+        if (!cls || !cls->unit)
+            return &from;
+        auto it = documents_.find(std::string(cls->unit->file));
+        return it != documents_.end() ? it->second.get() : nullptr;
+    }
+
+    LanguageServer::Json LanguageServer::Location(const Node *decl, Document &from)
+    {
+        Document *doc = DocumentOf(decl, from);
+        if (!doc || !doc->ast)
+            return Json();
+        std::string_view name = DeclName(decl);
+        SourcePosition pos = doc->Locate(decl);
+        int line = pos.line;
+        int column = pos.column;
+        bool ahead = decl->kind == NodeKind::kClassDecl || decl->kind == NodeKind::kParamDecl;
+        if (ahead && !doc->Find(name, line, column))
+            return Json();
+        return Json::Object().Set("uri", doc->uri).Set("range", doc->Range(line, column, static_cast<int>(name.size())));
+    }
+
+    int RunLanguageServer(std::istream &in, std::ostream &out)
+    {
+        auto server = std::make_shared<LanguageServer>(out);
+        std::thread reader([server, &in]
+                           {
+            std::string line;
+            for (;;)
+            {
+                std::size_t length = 0;
+                bool header = false;
+                while (std::getline(in, line))
+                {
+                    if (!line.empty() && line.back() == '\r')
+                        line.pop_back();
+                    if (line.empty())
+                        break;
+                    header = true;
+                    std::string lower = line;
+                    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c)
+                                   { return static_cast<char>(std::tolower(c)); });
+                    if (lower.compare(0, 15, "content-length:") == 0)
+                        length = std::stoul(line.substr(15));
+                }
+                if (!in || !header)
+                    break;
+                std::string body(length, '\0');
+                in.read(body.data(), static_cast<std::streamsize>(length));
+                if (static_cast<std::size_t>(in.gcount()) != length)
+                    break;
+                server->Post(std::move(body));
+            }
+            server->Close(); });
+        int status = server->Serve();
+        // a client may send exit and keep stdin open; the process is about
+        // to end, so the reader is left blocked there.
+        if (&in == &std::cin)
+            reader.detach();
+        else
+            reader.join();
+        return status;
+    }
+
+}
@@ -16,8 +16,667 @@
  * Copyright (C) 2025 Faith (propenster) Olusegun.
  * Contact: https://propenster.github.io
  */
+#include "build.h"
+#include "bytecode.h"
+#include "c_backend.h"
+#include "cache.h"
+#include "daemon.h"
+#include "ir.h"
+#include "lexer.h"
+#include "lsp.h"
+#include "metadata.h"
+#include "parser.h"
+#include "passes.h"
+#include "profiler.h"
+#include "sema.h"
+#include "thread_pool.h"
+#include "vm.h"
+#include <fstream>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
 
-int main(int, char**){
-    std::cout << "Hello, from tinycsharp!\n";
+namespace
+{
+    bool ReadFile(const std::string &path, std::string &out)
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+        {
+            return false;
+        }
+        std::ostringstream ss;
+        ss << in.rdbuf();
+        out = ss.str();
+        return true;
+    }
+
+    bool StartsWith(const std::string &s, const std::string &prefix)
+    {
+        return s.compare(0, prefix.size(), prefix) == 0;
+    }
+
+    // the value of a numeric option such as --jobs=N; false unless text is
+    // all digits and fits in value.
+    template <typename T>
+    bool ParseCount(const std::string &text, T &value)
+    {
+        if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos)
+            return false;
+        try
+        {
+            unsigned long long n = std::stoull(text);
+            if (n > std::numeric_limits<T>::max())
+                return false;
+            value = static_cast<T>(n);
+            return true;
+        }
+        catch (const std::out_of_range &)
+        {
+            return false;
+        }
+    }
+
+    // the outcome of running a program: its output, exit status and the
+    // unhandled exception's text, if any.
+    struct RunResult
+    {
+        std::string output;
+        int status = 0;
+        std::string error;
+
+        bool operator==(const RunResult &o) const { return output == o.output && status == o.status && error == o.error; }
+    };
+
+    RunResult RunProgram(const tinycsharp::BcProgram &program, tinycsharp::Vm::Options options)
+    {
+        RunResult result;
+        std::ostringstream out;
+        tinycsharp::Vm vm{program, out, options};
+        try
+        {
+            result.status = vm.Run();
+        }
+        catch (const std::exception &e)
+        {
+            result.error = e.what();
+            result.status = 1;
+        }
+        result.output = out.str();
+        return result;
+    }
+
+    // "tinycsharp build MANIFEST": checks the manifest's assemblies as a
+    // graph of steps across the cores, then compiles the whole program.
+    // --timings reports the dependencies found and every step's timing.
+    int Build(const std::vector<std::string> &args, std::ostream &out, std::ostream &err)
+    {
+        unsigned jobs = 0;
+        bool timings = false;
+        std::string opt_flag = "-O1";
+        std::string manifest_path;
+        for (std::size_t i = 1; i < args.size(); i++)
+        {
+            const std::string &arg = args[i];
+            if (StartsWith(arg, "--jobs="))
+            {
+                if (!ParseCount(arg.substr(7), jobs))
+                {
+                    err << "tinycsharp: invalid --jobs\n";
+                    return 1;
+                }
+            }
+            else if (arg == "--timings")
+                timings = true;
+            else if (StartsWith(arg, "-O"))
+                opt_flag = arg;
+            else if (manifest_path.empty())
+                manifest_path = arg;
+            else
+            {
+                err << "tinycsharp: build takes one manifest\n";
+                return 1;
+            }
+        }
+        if (manifest_path.empty())
+        {
+            err << "tinycsharp: build needs a manifest\n";
+            return 1;
+        }
+
+        tinycsharp::OptLevel opt_level;
+        tinycsharp::BuildManifest manifest;
+        try
+        {
+            opt_level = tinycsharp::ParseOptLevel(opt_flag);
+            manifest = tinycsharp::BuildManifest::Load(manifest_path);
+        }
+        catch (const std::exception &e)
+        {
+            err << "tinycsharp: " << e.what() << "\n";
+            return 1;
+        }
+        std::size_t files = 0;
+        for (const auto &assembly : manifest.assemblies)
+            files += assembly.files.size();
+
+        tinycsharp::ThreadPool pool{jobs};
+        tinycsharp::ProjectBuild build{std::move(manifest), pool};
+        bool ok = build.Check(err);
+        if (ok)
+        {
+            // code generation is program-wide, after every assembly.
+            auto codegen = build.graph().Add("codegen", [&]
+                                             {
+                tinycsharp::IrModule module = tinycsharp::LowerToIr(build.sema().globals(), &pool);
+                tinycsharp::PassManager passes{&pool};
+                passes.AddPipeline(opt_level);
+                passes.Run(module);
+                tinycsharp::CompileBytecode(module, &pool);
+                return true; }, {build.checked()});
+            ok = build.graph().Run(pool);
+            const auto &node = build.graph().nodes()[codegen];
+            if (!node.error.empty())
+                err << "tinycsharp: " << node.error << "\n";
+        }
+        if (timings)
+        {
+            build.PrintDependencies(out);
+            build.graph().PrintTimings(out);
+        }
+        out << "build: " << build.manifest().assemblies.size() << " assemblies, " << files << " files, "
+            << (ok ? "ok" : "failed") << "\n";
+        return ok ? 0 : 1;
+    }
+
+    // one compiler invocation: args without the program name, with out and
+    // err standing in for stdout and stderr. a daemon passes its warm front
+    // end, which replaces lexing and parsing of unchanged files.
+    int Compile(const std::vector<std::string> &args, std::ostream &out, std::ostream &err, tinycsharp::FrontEndCache *warm)
+    {
+        if (!args.empty() && args[0] == "build")
+        {
+            return Build(args, out, err);
+        }
+        std::string cache_dir;
+        std::uint64_t cache_size = 256ull << 20;
+        unsigned jobs = 0;
+        bool emit_ir = false;
+        bool emit_bytecode = false;
+        bool pass_stats = false;
+        bool vm_stats = false;
+        bool jit_diff = false;
+        std::string profile_mode;
+        std::string profile_output = "tinycsharp.folded";
+        bool emit_c = false;
+        std::string native_output;
+        std::vector<std::string> references;
+        std::string metadata_output;
+        std::string emit_tokens;
+        // "tinycsharp run FILE..." compiles and then executes Main; the program
+        // owns stdout, so the driver's own reports go to stderr.
+        bool run = !args.empty() && args[0] == "run";
+        std::string opt_flag;
+        std::vector<std::string> files;
+        for (std::size_t i = run ? 1 : 0; i < args.size(); i++)
+        {
+            const std::string &arg = args[i];
+            if (StartsWith(arg, "--cache-dir="))
+            {
+                cache_dir = arg.substr(12);
+            }
+            else if (StartsWith(arg, "--cache-size="))
+            {
+                if (!ParseCount(arg.substr(13), cache_size))
+                {
+                    err << "tinycsharp: invalid --cache-size\n";
+                    return 1;
+                }
+            }
+            else if (arg == "--emit-ir")
+            {
+                emit_ir = true;
+            }
+            else if (arg == "--emit-bytecode")
+            {
+                emit_bytecode = true;
+            }
+            else if (arg == "--pass-stats")
+            {
+                pass_stats = true;
+            }
+            else if (arg == "--vm-stats")
+            {
+                vm_stats = true;
+            }
+            else if (arg == "--jit-diff")
+            {
+                jit_diff = true;
+            }
+            else if (StartsWith(arg, "--profile="))
+            {
+                profile_mode = arg.substr(10);
+            }
+            else if (StartsWith(arg, "--profile-out="))
+            {
+                profile_output = arg.substr(14);
+            }
+            else if (arg == "--emit-c")
+            {
+                emit_c = true;
+            }
+            else if (StartsWith(arg, "--native="))
+            {
+                native_output = arg.substr(9);
+            }
+            else if (StartsWith(arg, "--reference="))
+            {
+                references.push_back(arg.substr(12));
+            }
+            else if (StartsWith(arg, "--emit-tokens="))
+            {
+                emit_tokens = arg.substr(14);
+            }
+            else if (StartsWith(arg, "--emit-metadata="))
+            {
+                metadata_output = arg.substr(16);
+            }
+            else if (StartsWith(arg, "-O"))
+            {
+                opt_flag = arg;
+            }
+            else if (StartsWith(arg, "--jobs="))
+            {
+                if (!ParseCount(arg.substr(7), jobs))
+                {
+                    err << "tinycsharp: invalid --jobs\n";
+                    return 1;
+                }
+            }
+            else
+            {
+                files.push_back(arg);
+            }
+        }
+
+        if (files.empty())
+        {
+            out << "Hello, from tinycsharp!\n";
+            out << "usage: tinycsharp [run] [--cache-dir=DIR] [--cache-size=BYTES] [--jobs=N] [-O0|-O1|-O2] [--emit-ir]\n"
+                   "                  [--emit-bytecode] [--emit-c] [--native=OUT] [--pass-stats] [--vm-stats] [--jit-diff]\n"
+                   "                  [--reference=MODULE] [--emit-metadata=OUT] [--emit-tokens=text|bin]\n"
+                   "                  [--profile=sample|exact] [--profile-out=FILE] FILE...\n"
+                   "       tinycsharp --daemon=SOCKET\n"
+                   "       tinycsharp --connect=SOCKET [ARGS...|--shutdown]\n"
+                   "       tinycsharp build [--jobs=N] [-O0|-O1|-O2] [--timings] MANIFEST\n"
+                   "       tinycsharp --lsp\n";
+            return 0;
+        }
+        if (opt_flag.empty())
+        {
+            opt_flag = run ? "-O1" : "-O0";
+        }
+        std::ostream &report = run ? err : out;
+        if (!emit_tokens.empty() && emit_tokens != "text" && emit_tokens != "bin")
+        {
+            err << "tinycsharp: --emit-tokens takes text or bin\n";
+            return 1;
+        }
+        if (emit_tokens == "bin" && files.size() != 1)
+        {
+            err << "tinycsharp: --emit-tokens=bin takes one file\n";
+            return 1;
+        }
+
+        tinycsharp::OptLevel opt_level;
+        try
+        {
+            opt_level = tinycsharp::ParseOptLevel(opt_flag);
+        }
+        catch (const std::exception &e)
+        {
+            err << "tinycsharp: " << e.what() << "\n";
+            return 1;
+        }
+
+        std::unique_ptr<tinycsharp::CompilationCache> cache;
+        if (!cache_dir.empty())
+        {
+            try
+            {
+                cache = std::make_unique<tinycsharp::CompilationCache>(cache_dir, cache_size);
+            }
+            catch (const std::exception &e)
+            {
+                err << "tinycsharp: " << e.what() << "\n";
+                return 1;
+            }
+        }
+
+        // files parsed here (all of them, or replayed dumps beside a warm
+        // front end's) share the names and the source address space of the
+        // units they are analyzed with.
+        if (warm)
+            warm->Trim();
+        tinycsharp::Interner interner;
+        tinycsharp::SourceManager sources;
+        tinycsharp::AstContext ctx{warm ? warm->interner() : interner, warm ? warm->sources() : sources};
+        std::vector<tinycsharp::CompilationUnit *> units;
+        int status = 0;
+        for (const auto &file : files)
+        {
+            std::string source;
+            if (!ReadFile(file, source))
+            {
+                err << "tinycsharp: cannot read " << file << "\n";
+                status = 1;
+                continue;
+            }
+            try
+            {
+                // a token dump (--emit-tokens=bin) replays in place of
+                // lexing the file.
+                bool replay = tinycsharp::IsTokenDump(source);
+                if (warm && !replay && emit_tokens.empty())
+                {
+                    const auto &parsed = warm->Parse(file, source, cache.get());
+                    if (!run)
+                        out << file << ": " << parsed.tokens << " tokens\n";
+                    units.insert(units.end(), parsed.ast->units.begin(), parsed.ast->units.end());
+                    continue;
+                }
+                if (cache && !replay && emit_tokens.empty())
+                {
+                    tinycsharp::FileId id = ctx.sources().AddFile(file, source);
+                    std::size_t count = 0;
+                    units.push_back(tinycsharp::ParseCached(*cache, ctx, source, file, ctx.sources().Begin(id), &count));
+                    if (!run)
+                        out << file << ": " << count << " tokens\n";
+                    continue;
+                }
+                std::vector<tinycsharp::Token> tokens;
+                tinycsharp::FileId id = tinycsharp::kNoFile;
+                if (replay)
+                {
+                    tokens = tinycsharp::ReadTokenDump(source, ctx.sources(), file);
+                    if (!tokens.empty())
+                        id = ctx.sources().FileOf(tokens.back().loc);
+                }
+                else
+                {
+                    id = ctx.sources().AddFile(file, source);
+                    tinycsharp::SourceLocation base = ctx.sources().Begin(id);
+                    if (cache)
+                    {
+                        tokens = tinycsharp::LexCached(*cache, source, base);
+                    }
+                    else
+                    {
+                        tinycsharp::Lexer lexer{source, base};
+                        tokens = lexer.Tokenize();
+                    }
+                }
+                if (emit_tokens == "bin")
+                {
+                    tinycsharp::WriteTokenDump(out, ctx.sources(), id, tokens);
+                    continue;
+                }
+                if (emit_tokens == "text")
+                {
+                    for (const auto &token : tokens)
+                    {
+                        tinycsharp::SourcePosition at = ctx.sources().Decode(token.loc);
+                        out << at.line << ":" << at.column << " " << token << "\n";
+                    }
+                    continue;
+                }
+                if (!run)
+                    out << file << ": " << tokens.size() << " tokens\n";
+                tinycsharp::Parser parser{ctx, std::move(tokens), file};
+                units.push_back(parser.ParseCompilationUnit());
+            }
+            catch (const std::exception &e)
+            {
+                err << file << ": " << e.what() << "\n";
+                status = 1;
+            }
+        }
+
+        if (!emit_tokens.empty())
+        {
+            return status;
+        }
+
+        // reference metadata modules are mapped, not read; their classes
+        // load as the program names them.
+        std::vector<std::unique_ptr<tinycsharp::MetadataModule>> modules;
+        for (const auto &path : references)
+        {
+            try
+            {
+                modules.push_back(tinycsharp::MetadataModule::Open(path));
+            }
+            catch (const std::exception &e)
+            {
+                err << "tinycsharp: " << e.what() << "\n";
+                status = 1;
+            }
+        }
+
+        if (status == 0)
+        {
+            tinycsharp::ThreadPool pool{jobs};
+            tinycsharp::Sema sema{ctx.interner()};
+            for (const auto &module : modules)
+            {
+                sema.AddReference(module.get());
+            }
+            if (!sema.Analyze(units, &pool))
+            {
+                status = 1;
+            }
+            for (const auto &d : sema.diagnostics())
+            {
+                err << d << "\n";
+            }
+            if (status == 0 && !metadata_output.empty())
+            {
+                std::ofstream metadata(metadata_output, std::ios::binary);
+                tinycsharp::WriteMetadata(metadata, sema.globals());
+                if (!metadata.flush())
+                {
+                    err << "tinycsharp: cannot write " << metadata_output << "\n";
+                    status = 1;
+                }
+            }
+            bool native = emit_c || !native_output.empty();
+            bool codegen = emit_ir || emit_bytecode || pass_stats || run || native;
+            if (status == 0 && codegen && !sema.globals().ReferencedClasses().empty())
+            {
+                // a module carries signatures only; the code behind them
+                // has to come from the library's sources.
+                const tinycsharp::ClassInfo *cls = sema.globals().ReferencedClasses().front();
+                err << "tinycsharp: cannot generate code against reference metadata: '" << cls->qualified_name
+                    << "' is defined in " << cls->reference->path() << "; compile the library's sources instead\n";
+                status = 1;
+            }
+            if (status == 0 && codegen)
+            {
+                tinycsharp::IrModule module = tinycsharp::LowerToIr(sema.globals(), &pool);
+                tinycsharp::PassManager passes{&pool};
+                passes.AddPipeline(opt_level);
+                passes.Run(module);
+                if (emit_ir)
+                    tinycsharp::PrintIr(out, module);
+                if (pass_stats)
+                    passes.PrintStats(err);
+                try
+                {
+                    if (emit_c)
+                        tinycsharp::EmitC(out, module);
+                    if (!native_output.empty())
+                        tinycsharp::CompileNative(module, native_output);
+                }
+                catch (const std::exception &e)
+                {
+                    err << "tinycsharp: " << e.what() << "\n";
+                    status = 1;
+                }
+                if (emit_bytecode || run)
+                {
+                    tinycsharp::BcProgram program = tinycsharp::CompileBytecode(module, &pool);
+                    if (emit_bytecode)
+                        tinycsharp::PrintBytecode(out, program);
+                    if (run && jit_diff)
+                    {
+                        // runs the program twice, interpreted only and with
+                        // every function compiled on its first call, and
+                        // reports any difference between the two.
+                        tinycsharp::Vm::Options interpreted;
+                        interpreted.jit = false;
+                        tinycsharp::Vm::Options compiled;
+                        compiled.jit_threshold = 1;
+                        RunResult expected = RunProgram(program, interpreted);
+                        RunResult actual = RunProgram(program, compiled);
+                        out << actual.output;
+                        out.flush();
+                        if (!actual.error.empty())
+                            err << actual.error << "\n";
+                        status = actual.status;
+                        if (!(expected == actual))
+                        {
+                            err << "tinycsharp: --jit-diff: the JIT run differs from the interpreter's (status "
+                                      << expected.status << " interpreted, " << actual.status << " compiled)\n";
+                            if (expected.output != actual.output)
+                                err << "interpreted output:\n" << expected.output;
+                            if (expected.error != actual.error)
+                                err << "interpreted exception:\n" << expected.error << "\n";
+                            status = 1;
+                        }
+                    }
+                    else if (run)
+                    {
+                        // --profile samples the run on a CPU timer, or counts
+                        // every instruction exactly; the folded stacks go to
+                        // --profile-out for a flamegraph, the hot methods and
+                        // their instructions to stderr.
+                        std::unique_ptr<tinycsharp::Profiler> profiler;
+                        tinycsharp::Vm::Options options;
+                        if (profile_mode == "sample" || profile_mode == "exact")
+                        {
+                            profiler = std::make_unique<tinycsharp::Profiler>(profile_mode == "sample" ? tinycsharp::Profiler::Mode::kSample
+                                                                                                      : tinycsharp::Profiler::Mode::kExact);
+                            options.profiler = profiler.get();
+                        }
+                        else if (!profile_mode.empty())
+                        {
+                            err << "tinycsharp: --profile takes sample or exact\n";
+                            return 1;
+                        }
+                        tinycsharp::Vm vm{program, out, options};
+                        try
+                        {
+                            if (profiler)
+                                profiler->Start();
+                            status = vm.Run();
+                        }
+                        catch (const std::exception &e)
+                        {
+                            out.flush();
+                            err << e.what() << "\n";
+                            status = 1;
+                        }
+                        out.flush();
+                        if (profiler)
+                        {
+                            profiler->Stop();
+                            std::ofstream folded(profile_output);
+                            profiler->WriteFolded(folded);
+                            if (!folded)
+                            {
+                                err << "tinycsharp: cannot write " << profile_output << "\n";
+                                status = 1;
+                            }
+                            profiler->WriteReport(err);
+                        }
+                        if (vm_stats)
+                        {
+                            const auto &heap = vm.heap().stats();
+                            err << "vm: " << vm.stats().instructions << " instructions, " << vm.stats().calls << " calls, "
+                                      << vm.stats().quickened << " quickened, "
+                                      << heap.objects_allocated << " objects, " << heap.bytes_allocated << " bytes allocated, "
+                                      << heap.collections << " collections (" << heap.minor_collections << " minor, "
+                                      << heap.major_collections << " major), " << heap.bytes_promoted << " bytes promoted\n";
+                            const auto &stats = vm.stats();
+                            if (stats.VirtualCalls())
+                                err << "vm: " << stats.VirtualCalls() << " virtual calls, " << stats.monomorphic_hits
+                                          << " monomorphic hits, " << stats.polymorphic_hits << " polymorphic hits, "
+                                          << stats.inline_cache_misses << " misses, " << stats.megamorphic_calls
+                                          << " megamorphic, " << static_cast<int>(stats.InlineCacheHitRate() * 100 + 0.5)
+                                          << "% hit rate\n";
+                            if (stats.suspensions)
+                                err << "vm: " << stats.suspensions << " suspensions, " << stats.resumptions << " resumptions\n";
+                            if (stats.jit_functions)
+                                err << "vm: " << stats.jit_functions << " functions compiled, " << stats.native_entries
+                                          << " native entries\n";
+                        }
+                    }
+                }
+            }
+        }
+
+        if (cache)
+        {
+            auto stats = cache->Stats();
+            report << "cache: " << stats.hits << " hits, " << stats.misses << " misses, "
+                      << stats.stores << " stores, " << stats.evictions << " evictions, "
+                      << cache->SizeInBytes() << " bytes";
+            if (stats.failed_stores)
+                report << " (" << stats.failed_stores << " entries could not be written)";
+            report << "\n";
+        }
+        return status;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<std::string> args(argv + 1, argv + argc);
+    // "--lsp" speaks the Language Server Protocol on stdin and stdout.
+    if (args.size() == 1 && args[0] == "--lsp")
+    {
+        return tinycsharp::RunLanguageServer(std::cin, std::cout);
+    }
+    // "--daemon=SOCKET" keeps one process serving compilations with a warm
+    // front end; "--connect=SOCKET" sends this invocation to it, and
+    // compiles here when no daemon answers.
+    if (!args.empty() && StartsWith(args[0], "--daemon="))
+    {
+        tinycsharp::FrontEndCache warm;
+        try
+        {
+            tinycsharp::ServeDaemon(args[0].substr(9), [&](const std::vector<std::string> &request, std::ostream &out, std::ostream &err)
+                                    { return Compile(request, out, err, &warm); });
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "tinycsharp: " << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+    if (!args.empty() && StartsWith(args[0], "--connect="))
+    {
+        std::string socket = args[0].substr(10);
+        args.erase(args.begin());
+        if (std::optional<int> status = tinycsharp::SendToDaemon(socket, args, std::cout, std::cerr))
+            return *status;
+        if (args.size() == 1 && args[0] == "--shutdown")
+            return 0;
+    }
+    return Compile(args, std::cout, std::cerr, nullptr);
 }
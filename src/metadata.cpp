@@ -0,0 +1,601 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include "metadata.h"
+#include "cache.h"
+#include "const_eval.h"
+#include "sema.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TINYCSHARP_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define TINYCSHARP_MMAP 0
+#endif
+
+namespace tinycsharp
+{
+    namespace
+    {
+        constexpr std::size_t kHeaderSize = 32;
+        constexpr std::size_t kTypeSize = 24;
+        constexpr std::size_t kMemberSize = 24;
+        constexpr std::size_t kParamSize = 8;
+        // a missing string while the writer's offsets are still relative.
+        constexpr std::uint32_t kNoString = UINT32_MAX;
+
+        std::uint32_t NameHash(std::string_view name)
+        {
+            return static_cast<std::uint32_t>(HashBytes(name));
+        }
+
+        void Put32(std::string &out, std::uint32_t value)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                out.push_back(static_cast<char>(value >> (8 * i)));
+            }
+        }
+
+        void Put64(std::string &out, std::uint64_t value)
+        {
+            Put32(out, static_cast<std::uint32_t>(value));
+            Put32(out, static_cast<std::uint32_t>(value >> 32));
+        }
+
+        std::uint32_t Get32(const char *p)
+        {
+            std::uint32_t value = 0;
+            for (int i = 3; i >= 0; i--)
+            {
+                value = value << 8 | static_cast<unsigned char>(p[i]);
+            }
+            return value;
+        }
+
+        // the module's strings, each stored once; offsets are relative to
+        // the start of the string table until the layout is known.
+        class StringTable
+        {
+        public:
+            std::uint32_t Add(std::string_view s)
+            {
+                auto it = offsets_.find(std::string(s));
+                if (it != offsets_.end())
+                {
+                    return it->second;
+                }
+                auto offset = static_cast<std::uint32_t>(data_.size());
+                Put32(data_, static_cast<std::uint32_t>(s.size()));
+                data_.append(s);
+                offsets_.emplace(std::string(s), offset);
+                return offset;
+            }
+            const std::string &data() const { return data_; }
+
+        private:
+            std::string data_;
+            std::unordered_map<std::string, std::uint32_t> offsets_;
+        };
+
+        struct MemberRecord
+        {
+            std::uint8_t kind;
+            std::uint8_t flags;
+            std::uint32_t name;
+            std::uint32_t type;
+            std::uint32_t slot;
+            std::uint64_t value;
+            bool value_is_string;
+            std::vector<std::pair<std::uint32_t, std::uint32_t>> params;
+        };
+
+        struct TypeRecord
+        {
+            std::string_view name;
+            std::uint32_t name_offset;
+            std::uint32_t base;
+            std::uint32_t flags;
+            std::uint32_t instance_slots;
+            std::vector<MemberRecord> members;
+        };
+
+        bool IsExported(Modifiers modifiers)
+        {
+            return modifiers & (kModPublic | kModProtected);
+        }
+
+        bool IsExported(const ClassInfo *cls)
+        {
+            for (const ClassInfo *c = cls; c; c = c->outer)
+            {
+                if (!(c->decl->modifiers & kModPublic))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        MemberRecord MethodRecord(const MethodInfo *method, StringTable &strings)
+        {
+            MemberRecord record{};
+            record.kind = method->is_ctor ? MetadataMember::kCtor : MetadataMember::kMethod;
+            Modifiers modifiers = method->decl->modifiers;
+            record.flags = (method->is_static ? MetadataMember::kStatic : 0) |
+                           (modifiers & kModVirtual ? MetadataMember::kVirtual : 0) |
+                           (method->is_abstract ? MetadataMember::kAbstract : 0) |
+                           (method->overridden ? MetadataMember::kOverride : 0) |
+                           (method->is_async ? MetadataMember::kAsync : 0);
+            record.name = strings.Add(method->decl->name);
+            record.type = strings.Add(TypeToString(method->return_type));
+            for (std::size_t i = 0; i < method->param_types.size(); i++)
+            {
+                record.params.emplace_back(strings.Add(method->decl->params[i]->name),
+                                           strings.Add(TypeToString(method->param_types[i])));
+            }
+            return record;
+        }
+
+        MemberRecord FieldRecord(const FieldInfo *field, StringTable &strings)
+        {
+            MemberRecord record{};
+            record.kind = MetadataMember::kField;
+            record.flags = (field->is_static ? MetadataMember::kStatic : 0) |
+                           (field->is_const ? MetadataMember::kConst : 0) |
+                           (field->is_readonly ? MetadataMember::kReadonly : 0);
+            record.name = strings.Add(field->decl->name);
+            record.type = strings.Add(TypeToString(field->type));
+            record.slot = field->slot;
+            if (const ConstValue *value = field->constant)
+            {
+                if (value->type->kind == TypeKind::kString)
+                {
+                    record.value = strings.Add(value->string_value);
+                    record.value_is_string = true;
+                }
+                else if (value->type->kind == TypeKind::kFloat || value->type->kind == TypeKind::kDouble)
+                {
+                    std::memcpy(&record.value, &value->float_value, sizeof(double));
+                }
+                else
+                {
+                    record.value = static_cast<std::uint64_t>(value->int_value);
+                }
+            }
+            return record;
+        }
+
+        std::string_view OutermostNamespace(const ClassInfo *cls)
+        {
+            while (cls->outer)
+            {
+                cls = cls->outer;
+            }
+            return cls->decl->ns ? cls->decl->ns->name : std::string_view();
+        }
+    }
+
+    void WriteMetadata(std::ostream &out, const GlobalSymbols &globals)
+    {
+        StringTable strings;
+        std::vector<TypeRecord> types;
+        std::vector<std::string> namespaces;
+        std::size_t member_count = 0;
+        std::size_t param_count = 0;
+        for (const ClassInfo *cls : globals.classes())
+        {
+            if (!IsExported(cls))
+            {
+                continue;
+            }
+            TypeRecord type{};
+            type.name = cls->qualified_name;
+            type.name_offset = strings.Add(cls->qualified_name);
+            type.base = cls->base && IsExported(cls->base) ? strings.Add(cls->base->qualified_name) : kNoString;
+            type.flags = (cls->decl->is_struct ? MetadataType::kStruct : 0) | (cls->is_sealed ? MetadataType::kSealed : 0) |
+                         (cls->is_abstract ? MetadataType::kAbstract : 0) | (cls->is_static ? MetadataType::kStatic : 0);
+            type.instance_slots = cls->instance_slots;
+            for (const FieldInfo *field : cls->fields)
+            {
+                if (IsExported(field->decl->modifiers))
+                {
+                    type.members.push_back(FieldRecord(field, strings));
+                }
+            }
+            for (const MethodInfo *ctor : cls->ctors)
+            {
+                if (IsExported(ctor->decl->modifiers))
+                {
+                    type.members.push_back(MethodRecord(ctor, strings));
+                }
+            }
+            for (const MethodInfo *method : cls->methods)
+            {
+                if (IsExported(method->decl->modifiers))
+                {
+                    type.members.push_back(MethodRecord(method, strings));
+                }
+            }
+            for (const MemberRecord &member : type.members)
+            {
+                param_count += member.params.size();
+            }
+            member_count += type.members.size();
+
+            std::string_view ns = OutermostNamespace(cls);
+            if (!ns.empty())
+            {
+                for (std::size_t dot = ns.find('.'); dot != std::string_view::npos; dot = ns.find('.', dot + 1))
+                {
+                    namespaces.emplace_back(ns.substr(0, dot));
+                }
+                namespaces.emplace_back(ns);
+            }
+            types.push_back(std::move(type));
+        }
+        std::sort(namespaces.begin(), namespaces.end());
+        namespaces.erase(std::unique(namespaces.begin(), namespaces.end()), namespaces.end());
+        std::vector<std::uint32_t> namespace_names;
+        for (const std::string &ns : namespaces)
+        {
+            namespace_names.push_back(strings.Add(ns));
+        }
+
+        // at most half full, so probes stay short.
+        std::uint32_t slots = 8;
+        while (slots < types.size() * 2)
+        {
+            slots *= 2;
+        }
+        std::size_t index_offset = kHeaderSize;
+        std::size_t namespaces_offset = index_offset + std::size_t{slots} * 8;
+        std::size_t types_offset = namespaces_offset + namespace_names.size() * 4;
+        std::size_t members_offset = types_offset + types.size() * kTypeSize;
+        std::size_t params_offset = members_offset + member_count * kMemberSize;
+        std::size_t strings_offset = params_offset + param_count * kParamSize;
+        std::size_t size = strings_offset + strings.data().size();
+        if (size > UINT32_MAX)
+        {
+            throw std::runtime_error("metadata module exceeds 4 GiB");
+        }
+        auto str = [&](std::uint32_t relative)
+        { return static_cast<std::uint32_t>(strings_offset + relative); };
+
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> index(slots, {0, 0});
+        for (std::size_t i = 0; i < types.size(); i++)
+        {
+            std::uint32_t hash = NameHash(types[i].name);
+            std::uint32_t slot = hash & (slots - 1);
+            while (index[slot].second != 0)
+            {
+                slot = (slot + 1) & (slots - 1);
+            }
+            index[slot] = {hash, static_cast<std::uint32_t>(types_offset + i * kTypeSize)};
+        }
+
+        std::string data;
+        data.reserve(size);
+        data.append("TCSM", 4);
+        Put32(data, MetadataModule::kVersion);
+        Put32(data, static_cast<std::uint32_t>(types.size()));
+        Put32(data, slots);
+        Put32(data, static_cast<std::uint32_t>(index_offset));
+        Put32(data, static_cast<std::uint32_t>(namespace_names.size()));
+        Put32(data, static_cast<std::uint32_t>(namespaces_offset));
+        Put32(data, static_cast<std::uint32_t>(size));
+        for (const auto &entry : index)
+        {
+            Put32(data, entry.first);
+            Put32(data, entry.second);
+        }
+        for (std::uint32_t name : namespace_names)
+        {
+            Put32(data, str(name));
+        }
+        std::size_t next_member = members_offset;
+        for (const TypeRecord &type : types)
+        {
+            Put32(data, str(type.name_offset));
+            Put32(data, type.base != kNoString ? str(type.base) : 0);
+            Put32(data, type.flags);
+            Put32(data, type.instance_slots);
+            Put32(data, static_cast<std::uint32_t>(type.members.size()));
+            Put32(data, static_cast<std::uint32_t>(next_member));
+            next_member += type.members.size() * kMemberSize;
+        }
+        std::size_t next_param = params_offset;
+        for (const TypeRecord &type : types)
+        {
+            for (const MemberRecord &member : type.members)
+            {
+                data.push_back(static_cast<char>(member.kind));
+                data.push_back(static_cast<char>(member.flags));
+                data.push_back(static_cast<char>(member.params.size()));
+                data.push_back(static_cast<char>(member.params.size() >> 8));
+                Put32(data, str(member.name));
+                Put32(data, str(member.type));
+                if (member.kind == MetadataMember::kField)
+                {
+                    Put32(data, member.slot);
+                }
+                else
+                {
+                    Put32(data, static_cast<std::uint32_t>(next_param));
+                    next_param += member.params.size() * kParamSize;
+                }
+                Put64(data, member.value_is_string ? str(static_cast<std::uint32_t>(member.value)) : member.value);
+            }
+        }
+        for (const TypeRecord &type : types)
+        {
+            for (const MemberRecord &member : type.members)
+            {
+                for (const auto &param : member.params)
+                {
+                    Put32(data, str(param.first));
+                    Put32(data, str(param.second));
+                }
+            }
+        }
+        data += strings.data();
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+
+    std::unique_ptr<MetadataModule> MetadataModule::Open(const std::string &path)
+    {
+#if TINYCSHARP_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw std::runtime_error("cannot read " + path);
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || st.st_size <= 0)
+        {
+            ::close(fd);
+            throw std::runtime_error(path + ": not a metadata module");
+        }
+        auto size = static_cast<std::size_t>(st.st_size);
+        void *mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED)
+        {
+            throw std::runtime_error("cannot map " + path);
+        }
+        std::unique_ptr<MetadataModule> module;
+        try
+        {
+            module.reset(new MetadataModule(path, static_cast<const char *>(mapping), size));
+        }
+        catch (...)
+        {
+            ::munmap(mapping, size);
+            throw;
+        }
+        module->mapping_ = mapping;
+        return module;
+#else
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+        {
+            throw std::runtime_error("cannot read " + path);
+        }
+        std::ostringstream ss;
+        ss << in.rdbuf();
+        return FromBytes(ss.str(), path);
+#endif
+    }
+
+    std::unique_ptr<MetadataModule> MetadataModule::FromBytes(std::string bytes, const std::string &name)
+    {
+        std::unique_ptr<MetadataModule> module(new MetadataModule(name, bytes.data(), bytes.size()));
+        module->bytes_ = std::move(bytes);
+        module->data_ = module->bytes_.data();
+        return module;
+    }
+
+    MetadataModule::MetadataModule(std::string path, const char *data, std::size_t size)
+        : path_(std::move(path)), data_(data), size_(size)
+    {
+        if (size_ < kHeaderSize || std::memcmp(data_, "TCSM", 4) != 0)
+        {
+            throw std::runtime_error(path_ + ": not a metadata module");
+        }
+        if (Get32(data_ + 4) != kVersion)
+        {
+            throw std::runtime_error(path_ + ": unsupported metadata module version " + std::to_string(Get32(data_ + 4)));
+        }
+        type_count_ = Get32(data_ + 8);
+        index_slots_ = Get32(data_ + 12);
+        index_offset_ = Get32(data_ + 16);
+        namespace_count_ = Get32(data_ + 20);
+        namespaces_offset_ = Get32(data_ + 24);
+        if (Get32(data_ + 28) != size_ || index_slots_ == 0 || (index_slots_ & (index_slots_ - 1)) != 0 ||
+            index_offset_ + std::uint64_t{index_slots_} * 8 > size_ ||
+            namespaces_offset_ + std::uint64_t{namespace_count_} * 4 > size_)
+        {
+            throw std::runtime_error(path_ + ": corrupt metadata module");
+        }
+    }
+
+    MetadataModule::~MetadataModule()
+    {
+#if TINYCSHARP_MMAP
+        if (mapping_)
+        {
+            ::munmap(mapping_, size_);
+        }
+#endif
+    }
+
+    bool MetadataModule::Read32(std::size_t offset, std::uint32_t &out) const
+    {
+        if (offset + 4 > size_)
+        {
+            return false;
+        }
+        out = Get32(data_ + offset);
+        return true;
+    }
+
+    bool MetadataModule::ReadString(std::uint32_t offset, std::string_view &out) const
+    {
+        std::uint32_t length;
+        if (!Read32(offset, length) || std::uint64_t{offset} + 4 + length > size_)
+        {
+            return false;
+        }
+        out = std::string_view(data_ + offset + 4, length);
+        return true;
+    }
+
+    std::string_view MetadataModule::String(std::uint32_t offset) const
+    {
+        std::string_view s;
+        return offset && ReadString(offset, s) ? s : std::string_view();
+    }
+
+    const MetadataType *MetadataModule::FindType(std::string_view qualified_name) const
+    {
+        std::uint32_t hash = NameHash(qualified_name);
+        std::uint32_t slot = hash & (index_slots_ - 1);
+        for (std::uint32_t probes = 0; probes < index_slots_; probes++)
+        {
+            const char *entry = data_ + index_offset_ + std::size_t{slot} * 8;
+            std::uint32_t offset = Get32(entry + 4);
+            if (offset == 0)
+            {
+                return nullptr;
+            }
+            std::uint32_t name;
+            std::string_view spelling;
+            if (Get32(entry) == hash && Read32(offset, name) && ReadString(name, spelling) && spelling == qualified_name)
+            {
+                return Decode(offset);
+            }
+            slot = (slot + 1) & (index_slots_ - 1);
+        }
+        return nullptr;
+    }
+
+    const MetadataType *MetadataModule::Decode(std::uint32_t offset) const
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        auto it = decoded_.find(offset);
+        if (it != decoded_.end())
+        {
+            return it->second.get();
+        }
+        std::unique_ptr<MetadataType> &slot = decoded_[offset];
+        auto type = std::make_unique<MetadataType>();
+        std::uint32_t base, member_count, members;
+        if (std::uint64_t{offset} + kTypeSize > size_ || !ReadString(Get32(data_ + offset), type->name))
+        {
+            return nullptr;
+        }
+        base = Get32(data_ + offset + 4);
+        type->flags = Get32(data_ + offset + 8);
+        type->instance_slots = Get32(data_ + offset + 12);
+        member_count = Get32(data_ + offset + 16);
+        members = Get32(data_ + offset + 20);
+        if ((base && !ReadString(base, type->base)) || members + std::uint64_t{member_count} * kMemberSize > size_)
+        {
+            return nullptr;
+        }
+        for (std::uint32_t i = 0; i < member_count; i++)
+        {
+            const char *p = data_ + members + std::size_t{i} * kMemberSize;
+            MetadataMember member;
+            member.kind = static_cast<MetadataMember::Kind>(p[0]);
+            member.flags = static_cast<std::uint8_t>(p[1]);
+            std::uint32_t param_count = static_cast<unsigned char>(p[2]) | static_cast<unsigned char>(p[3]) << 8;
+            member.value = Get32(p + 16) | std::uint64_t{Get32(p + 20)} << 32;
+            if (member.kind > MetadataMember::kCtor || !ReadString(Get32(p + 4), member.name) ||
+                !ReadString(Get32(p + 8), member.type))
+            {
+                return nullptr;
+            }
+            if (member.kind == MetadataMember::kField)
+            {
+                member.slot = Get32(p + 12);
+            }
+            else
+            {
+                std::uint32_t params = Get32(p + 12);
+                if (params + std::uint64_t{param_count} * kParamSize > size_)
+                {
+                    return nullptr;
+                }
+                for (std::uint32_t j = 0; j < param_count; j++)
+                {
+                    std::string_view param_name, param_type;
+                    if (!ReadString(Get32(data_ + params + j * kParamSize), param_name) ||
+                        !ReadString(Get32(data_ + params + j * kParamSize + 4), param_type))
+                    {
+                        return nullptr;
+                    }
+                    member.params.emplace_back(param_name, param_type);
+                }
+            }
+            type->members.push_back(std::move(member));
+        }
+        slot = std::move(type);
+        return slot.get();
+    }
+
+    bool MetadataModule::HasNamespace(std::string_view name) const
+    {
+        // the names are sorted.
+        std::uint32_t lo = 0, hi = namespace_count_;
+        while (lo < hi)
+        {
+            std::uint32_t mid = lo + (hi - lo) / 2;
+            std::string_view spelling = String(Get32(data_ + namespaces_offset_ + std::size_t{mid} * 4));
+            if (spelling == name)
+            {
+                return true;
+            }
+            if (spelling < name)
+            {
+                lo = mid + 1;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
+        return false;
+    }
+
+    std::size_t MetadataModule::decoded_types() const
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        return static_cast<std::size_t>(std::count_if(decoded_.begin(), decoded_.end(), [](const auto &entry)
+                                                      { return entry.second != nullptr; }));
+    }
+
+}
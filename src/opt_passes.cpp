@@ -0,0 +1,1276 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include "passes.h"
+#include "sema.h"
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+namespace tinycsharp
+{
+    namespace
+    {
+        // dominator tree of a builder's CFG (Cooper, Harvey and Kennedy,
+        // "A Simple, Fast Dominance Algorithm").
+        struct Dominators
+        {
+            std::vector<BlockId> rpo;             // reachable blocks, reverse post-order
+            std::vector<std::uint32_t> order;     // rpo index by block; kNoValue if unreachable
+            std::vector<BlockId> idom;            // immediate dominator; the entry is its own
+            std::vector<std::vector<BlockId>> children;
+
+            explicit Dominators(IrBuilder &b)
+            {
+                const std::uint32_t n = b.NumBlocks();
+                order.assign(n, kNoValue);
+                std::vector<BlockId> post;
+                std::vector<std::pair<BlockId, std::uint32_t>> stack{{0, 0}};
+                std::vector<bool> seen(n, false);
+                seen[0] = true;
+                while (!stack.empty())
+                {
+                    auto &[block, next] = stack.back();
+                    BlockId succ[2];
+                    std::uint32_t count = b.Successors(block, succ);
+                    if (next < count)
+                    {
+                        BlockId s = succ[next++];
+                        if (!seen[s])
+                        {
+                            seen[s] = true;
+                            stack.emplace_back(s, 0);
+                        }
+                        continue;
+                    }
+                    post.push_back(block);
+                    stack.pop_back();
+                }
+                rpo.assign(post.rbegin(), post.rend());
+                for (std::uint32_t i = 0; i < rpo.size(); i++)
+                    order[rpo[i]] = i;
+
+                idom.assign(n, kNoValue);
+                idom[0] = 0;
+                for (bool changed = true; changed;)
+                {
+                    changed = false;
+                    for (std::size_t i = 1; i < rpo.size(); i++)
+                    {
+                        BlockId block = rpo[i];
+                        BlockId new_idom = kNoValue;
+                        for (BlockId pred : b.BlockPreds(block))
+                        {
+                            if (order[pred] == kNoValue || idom[pred] == kNoValue)
+                                continue;
+                            new_idom = new_idom == kNoValue ? pred : Intersect(pred, new_idom);
+                        }
+                        if (new_idom != idom[block])
+                        {
+                            idom[block] = new_idom;
+                            changed = true;
+                        }
+                    }
+                }
+                children.assign(n, {});
+                for (std::size_t i = 1; i < rpo.size(); i++)
+                    children[idom[rpo[i]]].push_back(rpo[i]);
+            }
+
+            BlockId Intersect(BlockId a, BlockId b) const
+            {
+                while (a != b)
+                {
+                    while (order[a] > order[b])
+                        a = idom[a];
+                    while (order[b] > order[a])
+                        b = idom[b];
+                }
+                return a;
+            }
+
+            bool Dominates(BlockId a, BlockId b) const
+            {
+                if (order[b] == kNoValue)
+                    return false;
+                while (b != a && b != 0)
+                    b = idom[b];
+                return b == a;
+            }
+        };
+
+        template <typename F>
+        void ForEachOperand(IrBuilder &b, ValueId v, F &&fn)
+        {
+            IrInst &inst = b.At(v);
+            if (HasOperandList(inst.op))
+            {
+                for (ValueId &op : b.ListOf(v))
+                    fn(op);
+            }
+            std::uint8_t mask = ValueOperandMask(inst.op);
+            if ((mask & 1) && inst.a != kNoValue)
+                fn(inst.a);
+            if ((mask & 2) && inst.b != kNoValue)
+                fn(inst.b);
+            if ((mask & 4) && inst.c != kNoValue)
+                fn(inst.c);
+        }
+
+        // computes a value and nothing else: no trap, no allocation whose
+        // identity could be observed, no memory read. safe to hoist or drop.
+        bool IsPure(const IrInst &inst)
+        {
+            switch (inst.op)
+            {
+            case IrOp::kConst:
+            case IrOp::kAdd:
+            case IrOp::kSub:
+            case IrOp::kMul:
+            case IrOp::kAnd:
+            case IrOp::kOr:
+            case IrOp::kXor:
+            case IrOp::kShl:
+            case IrOp::kShr:
+            case IrOp::kNeg:
+            case IrOp::kNot:
+            case IrOp::kEq:
+            case IrOp::kNe:
+            case IrOp::kLt:
+            case IrOp::kLe:
+            case IrOp::kGt:
+            case IrOp::kGe:
+            case IrOp::kStrEq:
+                return true;
+            case IrOp::kConvert:
+                // boxing allocates; unboxing traps on a bad type.
+                return inst.type != IrType::kRef && static_cast<IrType>(inst.aux) != IrType::kRef;
+            default:
+                return false;
+            }
+        }
+
+        // gives the same result every time its operands are the same, so a
+        // dominating copy can stand in for it. traps are fine: had the
+        // first one trapped, the second would not run.
+        bool IsRedundancyCandidate(const IrInst &inst)
+        {
+            switch (inst.op)
+            {
+            case IrOp::kDiv:
+            case IrOp::kRem:
+            case IrOp::kArrayLength:
+            case IrOp::kStringLength:
+            case IrOp::kCharAt:
+                return true;
+            default:
+                return IsPure(inst);
+            }
+        }
+
+        bool IsCommutative(IrOp op)
+        {
+            return op == IrOp::kAdd || op == IrOp::kMul || op == IrOp::kAnd || op == IrOp::kOr || op == IrOp::kXor ||
+                   op == IrOp::kEq || op == IrOp::kNe || op == IrOp::kStrEq;
+        }
+
+        // wraps an integral result to the width of type, as unchecked C# does.
+        std::int64_t Wrap(IrType type, std::uint64_t value)
+        {
+            switch (type)
+            {
+            case IrType::kBool:
+                return value != 0;
+            case IrType::kChar:
+                return static_cast<std::int64_t>(value & 0xffff);
+            case IrType::kI32:
+                return static_cast<std::int32_t>(static_cast<std::uint32_t>(value));
+            default:
+                return static_cast<std::int64_t>(value);
+            }
+        }
+
+        double RoundFloat(IrType type, double value)
+        {
+            return type == IrType::kF32 ? static_cast<double>(static_cast<float>(value)) : value;
+        }
+
+        // ------------------------------------------------------------------
+        // dead code elimination
+
+        class DeadCodeElimination : public IrPass
+        {
+        public:
+            const char *Name() const override { return "dce"; }
+
+            std::uint32_t Run(IrBuilder &b, const IrFunction &, const IrModule &) const override
+            {
+                std::uint32_t changes = 0;
+                for (BlockId block = 0; block < b.NumBlocks(); block++)
+                {
+                    if (b.BlockInsts(block).empty())
+                        continue;
+                    IrInst &term = b.At(b.BlockInsts(block).back());
+                    if (term.op != IrOp::kBranch)
+                        continue;
+                    const IrInst &cond = b.At(b.Resolve(term.a));
+                    if (cond.op != IrOp::kConst)
+                        continue;
+                    BlockId taken = cond.Imm() ? term.b : term.c;
+                    BlockId dropped = cond.Imm() ? term.c : term.b;
+                    b.RemoveEdge(block, dropped);
+                    term.op = IrOp::kJump;
+                    term.a = taken;
+                    term.b = term.c = kNoValue;
+                    changes++;
+                }
+
+                changes += MergeBlocks(b);
+
+                std::vector<bool> live(b.NumValues(), false);
+                std::vector<ValueId> work;
+                auto mark = [&](ValueId v)
+                {
+                    v = b.Resolve(v);
+                    if (!live[v])
+                    {
+                        live[v] = true;
+                        work.push_back(v);
+                    }
+                };
+                for (BlockId block = 0; block < b.NumBlocks(); block++)
+                {
+                    for (ValueId v : b.BlockInsts(block))
+                    {
+                        IrOp op = b.At(v).op;
+                        if (op != IrOp::kNop && (HasSideEffects(op) || op == IrOp::kParam))
+                            mark(v);
+                    }
+                }
+                while (!work.empty())
+                {
+                    ValueId v = work.back();
+                    work.pop_back();
+                    ForEachOperand(b, v, [&](ValueId &op) { mark(op); });
+                }
+                for (BlockId block = 0; block < b.NumBlocks(); block++)
+                {
+                    for (const auto *list : {&b.BlockPhis(block), &b.BlockInsts(block)})
+                    {
+                        for (ValueId v : *list)
+                        {
+                            if (b.At(v).op != IrOp::kNop && !live[v])
+                            {
+                                b.Kill(v);
+                                changes++;
+                            }
+                        }
+                    }
+                }
+                return changes;
+            }
+
+        private:
+            // folds a block into its predecessor when that predecessor jumps
+            // to it unconditionally and nothing else enters it.
+            static std::uint32_t MergeBlocks(IrBuilder &b)
+            {
+                std::uint32_t changes = 0;
+                for (BlockId block = 0; block < b.NumBlocks(); block++)
+                {
+                    for (;;)
+                    {
+                        auto &insts = b.BlockInsts(block);
+                        if (insts.empty())
+                            break;
+                        const IrInst &term = b.At(insts.back());
+                        if (term.op != IrOp::kJump)
+                            break;
+                        BlockId next = term.a;
+                        if (next == block || next == 0 || b.BlockPreds(next).size() != 1)
+                            break;
+                        for (ValueId phi : b.BlockPhis(next))
+                        {
+                            if (b.At(phi).op == IrOp::kPhi)
+                                b.Replace(phi, b.ListOf(phi)[0]);
+                        }
+                        b.BlockPhis(next).clear();
+                        b.Kill(insts.back());
+                        insts.pop_back();
+                        auto &moved = b.BlockInsts(next);
+                        insts.insert(insts.end(), moved.begin(), moved.end());
+                        moved.clear();
+                        b.BlockPreds(next).clear();
+                        BlockId succ[2];
+                        std::uint32_t n = b.Successors(block, succ);
+                        for (std::uint32_t i = 0; i < n; i++)
+                        {
+                            if (i == 1 && succ[1] == succ[0])
+                                break;
+                            for (BlockId &pred : b.BlockPreds(succ[i]))
+                            {
+                                if (pred == next)
+                                    pred = block;
+                            }
+                        }
+                        changes++;
+                    }
+                }
+                return changes;
+            }
+        };
+
+        // ------------------------------------------------------------------
+        // global value numbering
+
+        struct ValueKey
+        {
+            IrOp op;
+            IrType type;
+            std::uint16_t aux;
+            ValueId a, b, c;
+            std::vector<ValueId> list;
+
+            bool operator==(const ValueKey &o) const
+            {
+                return op == o.op && type == o.type && aux == o.aux && a == o.a && b == o.b && c == o.c && list == o.list;
+            }
+        };
+
+        struct ValueKeyHash
+        {
+            std::size_t operator()(const ValueKey &k) const
+            {
+                std::size_t h = static_cast<std::size_t>(k.op) * 31 + static_cast<std::size_t>(k.type);
+                h = h * 1000003 ^ k.aux;
+                h = h * 1000003 ^ k.a;
+                h = h * 1000003 ^ k.b;
+                h = h * 1000003 ^ k.c;
+                for (ValueId v : k.list)
+                    h = h * 1000003 ^ v;
+                return h;
+            }
+        };
+
+        class GlobalValueNumbering : public IrPass
+        {
+        public:
+            const char *Name() const override { return "gvn"; }
+
+            std::uint32_t Run(IrBuilder &b, const IrFunction &, const IrModule &) const override
+            {
+                Dominators dom{b};
+                std::unordered_map<ValueKey, ValueId, ValueKeyHash> table;
+                std::vector<ValueKey> scope_log;
+                std::uint32_t changes = 0;
+
+                // preorder walk of the dominator tree; entries made in a block
+                // are forgotten when its subtree is done.
+                struct Frame
+                {
+                    BlockId block;
+                    std::size_t log_size;
+                    bool entered;
+                };
+                std::vector<Frame> stack{{0, 0, false}};
+                while (!stack.empty())
+                {
+                    Frame &frame = stack.back();
+                    if (frame.entered)
+                    {
+                        while (scope_log.size() > frame.log_size)
+                        {
+                            table.erase(scope_log.back());
+                            scope_log.pop_back();
+                        }
+                        stack.pop_back();
+                        continue;
+                    }
+                    frame.entered = true;
+                    frame.log_size = scope_log.size();
+                    BlockId block = frame.block;
+                    changes += NumberBlock(b, block, table, scope_log);
+                    for (BlockId child : dom.children[block])
+                        stack.push_back(Frame{child, 0, false});
+                }
+                return changes;
+            }
+
+        private:
+            std::uint32_t NumberBlock(IrBuilder &b, BlockId block, std::unordered_map<ValueKey, ValueId, ValueKeyHash> &table,
+                                      std::vector<ValueKey> &log) const
+            {
+                std::uint32_t changes = 0;
+                auto lookup = [&](ValueId v, ValueKey key)
+                {
+                    auto it = table.find(key);
+                    if (it != table.end())
+                    {
+                        b.Replace(v, it->second);
+                        b.Kill(v);
+                        changes++;
+                        return;
+                    }
+                    table.emplace(key, v);
+                    log.push_back(std::move(key));
+                };
+
+                for (ValueId v : b.BlockPhis(block))
+                {
+                    if (b.At(v).op != IrOp::kPhi)
+                        continue;
+                    ValueId same = kNoValue;
+                    bool trivial = true;
+                    for (ValueId &op : b.ListOf(v))
+                    {
+                        op = b.Resolve(op);
+                        if (op == v || op == same)
+                            continue;
+                        trivial = trivial && same == kNoValue;
+                        same = op;
+                    }
+                    if (trivial && same != kNoValue)
+                    {
+                        b.Replace(v, same);
+                        changes++;
+                        continue;
+                    }
+                    // identical phis of one block are one value.
+                    const IrInst &phi = b.At(v);
+                    lookup(v, ValueKey{IrOp::kPhi, phi.type, 0, block, kNoValue, kNoValue, b.ListOf(v)});
+                }
+
+                for (ValueId v : b.BlockInsts(block))
+                {
+                    IrInst &inst = b.At(v);
+                    if (inst.op == IrOp::kNop)
+                        continue;
+                    ForEachOperand(b, v, [&](ValueId &op) { op = b.Resolve(op); });
+                    if (!IsRedundancyCandidate(inst))
+                        continue;
+                    if (Fold(b, v))
+                        changes++;
+                    if (ValueId same = Simplify(b, v); same != kNoValue)
+                    {
+                        b.Replace(v, same);
+                        b.Kill(v);
+                        changes++;
+                        continue;
+                    }
+                    if (inst.op != IrOp::kConst && IsCommutative(inst.op) && inst.a > inst.b)
+                        std::swap(inst.a, inst.b);
+                    lookup(v, ValueKey{inst.op, inst.type, inst.aux, inst.a, inst.b, inst.c, {}});
+                }
+                return changes;
+            }
+
+            static const IrInst *ConstOperand(IrBuilder &b, ValueId v)
+            {
+                const IrInst &inst = b.At(v);
+                return inst.op == IrOp::kConst ? &inst : nullptr;
+            }
+
+            static void MakeInt(IrInst &inst, std::int64_t value)
+            {
+                inst.op = IrOp::kConst;
+                inst.aux = 0;
+                inst.a = kNoValue;
+                inst.SetImm(value);
+            }
+
+            static void MakeFloat(IrInst &inst, double value)
+            {
+                inst.op = IrOp::kConst;
+                inst.aux = 0;
+                inst.a = kNoValue;
+                inst.SetFloatImm(RoundFloat(inst.type, value));
+            }
+
+            // evaluates an instruction whose operands are all constants,
+            // turning it into a constant in place.
+            static bool Fold(IrBuilder &b, ValueId v)
+            {
+                IrInst &inst = b.At(v);
+                if (inst.op == IrOp::kConst)
+                    return false;
+                std::uint8_t mask = ValueOperandMask(inst.op);
+                const IrInst *x = (mask & 1) ? ConstOperand(b, inst.a) : nullptr;
+                const IrInst *y = (mask & 2) ? ConstOperand(b, inst.b) : nullptr;
+                if (!x || ((mask & 2) && !y))
+                    return false;
+                if (x->type == IrType::kRef || (y && y->type == IrType::kRef))
+                {
+                    if (inst.op == IrOp::kStrEq && x->aux == 1 && y->aux == 1)
+                    {
+                        bool eq = b.StringAt(x->a) == b.StringAt(y->a);
+                        MakeInt(inst, eq);
+                        return true;
+                    }
+                    return false;
+                }
+                IrType in = x->type;
+                bool fp = IsFloatIrType(in);
+
+                if (IsCompare(inst.op))
+                {
+                    int cmp;
+                    if (fp)
+                    {
+                        double l = x->FloatImm(), r = y->FloatImm();
+                        if (std::isnan(l) || std::isnan(r))
+                        {
+                            MakeInt(inst, inst.op == IrOp::kNe);
+                            return true;
+                        }
+                        cmp = l < r ? -1 : l > r ? 1 : 0;
+                    }
+                    else
+                    {
+                        std::int64_t l = x->Imm(), r = y->Imm();
+                        cmp = l < r ? -1 : l > r ? 1 : 0;
+                    }
+                    bool result = false;
+                    switch (inst.op)
+                    {
+                    case IrOp::kEq:
+                        result = cmp == 0;
+                        break;
+                    case IrOp::kNe:
+                        result = cmp != 0;
+                        break;
+                    case IrOp::kLt:
+                        result = cmp < 0;
+                        break;
+                    case IrOp::kLe:
+                        result = cmp <= 0;
+                        break;
+                    case IrOp::kGt:
+                        result = cmp > 0;
+                        break;
+                    default:
+                        result = cmp >= 0;
+                        break;
+                    }
+                    MakeInt(inst, result);
+                    return true;
+                }
+
+                if (inst.op == IrOp::kConvert)
+                {
+                    if (!fp && !IsFloatIrType(inst.type))
+                        MakeInt(inst, Wrap(inst.type, static_cast<std::uint64_t>(x->Imm())));
+                    else if (!fp)
+                        MakeFloat(inst, static_cast<double>(x->Imm()));
+                    else if (IsFloatIrType(inst.type))
+                        MakeFloat(inst, x->FloatImm());
+                    else
+                    {
+                        // out-of-range float to integer conversions are
+                        // left to the target.
+                        double d = std::trunc(x->FloatImm());
+                        if (!(d >= -9.2e18 && d <= 9.2e18))
+                            return false;
+                        std::int64_t i = static_cast<std::int64_t>(d);
+                        if (Wrap(inst.type, static_cast<std::uint64_t>(i)) != i && inst.type != IrType::kChar)
+                            return false;
+                        MakeInt(inst, Wrap(inst.type, static_cast<std::uint64_t>(i)));
+                    }
+                    return true;
+                }
+
+                if (fp)
+                {
+                    double l = x->FloatImm(), r = y ? y->FloatImm() : 0;
+                    switch (inst.op)
+                    {
+                    case IrOp::kAdd:
+                        MakeFloat(inst, l + r);
+                        return true;
+                    case IrOp::kSub:
+                        MakeFloat(inst, l - r);
+                        return true;
+                    case IrOp::kMul:
+                        MakeFloat(inst, l * r);
+                        return true;
+                    case IrOp::kDiv:
+                        MakeFloat(inst, l / r);
+                        return true;
+                    case IrOp::kRem:
+                        MakeFloat(inst, std::fmod(l, r));
+                        return true;
+                    case IrOp::kNeg:
+                        MakeFloat(inst, -l);
+                        return true;
+                    default:
+                        return false;
+                    }
+                }
+
+                std::uint64_t l = static_cast<std::uint64_t>(x->Imm());
+                std::uint64_t r = y ? static_cast<std::uint64_t>(y->Imm()) : 0;
+                std::int64_t sl = x->Imm(), sr = y ? y->Imm() : 0;
+                unsigned width_mask = inst.type == IrType::kI64 ? 63 : 31;
+                switch (inst.op)
+                {
+                case IrOp::kAdd:
+                    MakeInt(inst, Wrap(inst.type, l + r));
+                    return true;
+                case IrOp::kSub:
+                    MakeInt(inst, Wrap(inst.type, l - r));
+                    return true;
+                case IrOp::kMul:
+                    MakeInt(inst, Wrap(inst.type, l * r));
+                    return true;
+                case IrOp::kDiv:
+                case IrOp::kRem:
+                {
+                    // division by zero and MinValue / -1 trap at run time.
+                    std::int64_t min = inst.type == IrType::kI64 ? INT64_MIN : INT32_MIN;
+                    if (sr == 0 || (sr == -1 && sl == min))
+                        return false;
+                    MakeInt(inst, Wrap(inst.type, static_cast<std::uint64_t>(inst.op == IrOp::kDiv ? sl / sr : sl % sr)));
+                    return true;
+                }
+                case IrOp::kAnd:
+                    MakeInt(inst, Wrap(inst.type, l & r));
+                    return true;
+                case IrOp::kOr:
+                    MakeInt(inst, Wrap(inst.type, l | r));
+                    return true;
+                case IrOp::kXor:
+                    MakeInt(inst, Wrap(inst.type, l ^ r));
+                    return true;
+                case IrOp::kShl:
+                    MakeInt(inst, Wrap(inst.type, l << (r & width_mask)));
+                    return true;
+                case IrOp::kShr:
+                    MakeInt(inst, Wrap(inst.type, static_cast<std::uint64_t>(sl >> (r & width_mask))));
+                    return true;
+                case IrOp::kNeg:
+                    MakeInt(inst, Wrap(inst.type, 0 - l));
+                    return true;
+                case IrOp::kNot:
+                    MakeInt(inst, l == 0);
+                    return true;
+                default:
+                    return false;
+                }
+            }
+
+            // an existing value the instruction always equals (x + 0 is x),
+            // or kNoValue.
+            static ValueId Simplify(IrBuilder &b, ValueId v)
+            {
+                const IrInst &inst = b.At(v);
+                if (!IsBinary(inst.op) || !IsIntegralIrType(inst.type))
+                    return kNoValue;
+                auto is = [&](ValueId op, std::int64_t value)
+                {
+                    const IrInst *c = ConstOperand(b, op);
+                    return c && c->Imm() == value;
+                };
+                switch (inst.op)
+                {
+                case IrOp::kAdd:
+                case IrOp::kOr:
+                case IrOp::kXor:
+                    if (is(inst.b, 0))
+                        return inst.a;
+                    if (is(inst.a, 0))
+                        return inst.b;
+                    break;
+                case IrOp::kSub:
+                case IrOp::kShl:
+                case IrOp::kShr:
+                    if (is(inst.b, 0))
+                        return inst.a;
+                    break;
+                case IrOp::kMul:
+                    if (is(inst.b, 1))
+                        return inst.a;
+                    if (is(inst.a, 1))
+                        return inst.b;
+                    break;
+                case IrOp::kDiv:
+                    if (is(inst.b, 1))
+                        return inst.a;
+                    break;
+                case IrOp::kAnd:
+                    if (inst.a == inst.b)
+                        return inst.a;
+                    break;
+                default:
+                    break;
+                }
+                return kNoValue;
+            }
+        };
+
+        // ------------------------------------------------------------------
+        // devirtualization
+
+        class Devirtualizer : public IrPass
+        {
+        public:
+            const char *Name() const override { return "devirtualize"; }
+
+            std::uint32_t Run(IrBuilder &b, const IrFunction &fn, const IrModule &module) const override
+            {
+                if (!module.globals)
+                    return 0;
+                std::uint32_t changes = 0;
+                // a guard splits the block at the call; the calls after it
+                // move to the new block, which is visited later.
+                for (BlockId block = 0; block < b.NumBlocks(); block++)
+                {
+                    for (std::size_t pos = 0; pos < b.BlockInsts(block).size(); pos++)
+                    {
+                        ValueId call = b.BlockInsts(block)[pos];
+                        if (b.At(call).op != IrOp::kCallVirtual)
+                            continue;
+                        ValueId receiver = b.Resolve(b.ListOf(call)[0]);
+                        const MethodInfo *target = Target(*module.globals, b, call, receiver);
+                        if (!target)
+                            continue;
+                        IrInst &inst = b.At(call);
+                        inst.op = IrOp::kCall;
+                        inst.c = target->id;
+                        inst.aux = 0;
+                        changes++;
+                        if (!IsNonNull(b, fn, receiver))
+                        {
+                            GuardNull(b, block, pos, receiver);
+                            break;
+                        }
+                    }
+                }
+                return changes;
+            }
+
+        private:
+            // the only method a virtual call can reach, from the class
+            // hierarchy: the receiver's exact class when it was allocated
+            // here, a sealed static type, or the one implementation that
+            // every concrete class below the static type shares.
+            static const MethodInfo *Target(const GlobalSymbols &globals, IrBuilder &b, ValueId call, ValueId receiver)
+            {
+                const MethodInfo *method = globals.methods()[b.At(call).c];
+                if (method->vtable_slot < 0)
+                    return nullptr;
+                auto slot = static_cast<std::size_t>(method->vtable_slot);
+                std::uint16_t aux = b.At(call).aux;
+                const ClassInfo *cls = aux ? globals.classes()[aux - 1u] : method->owner;
+                if (b.At(receiver).op == IrOp::kNewObject)
+                    cls = globals.classes()[b.At(receiver).c];
+                else if (!cls->is_sealed)
+                {
+                    const MethodInfo *only = nullptr;
+                    for (const ClassInfo *sub : globals.classes())
+                    {
+                        if (sub->is_abstract || sub->is_static || !sub->IsSubclassOf(cls) || slot >= sub->vtable.size())
+                            continue;
+                        if (only && sub->vtable[slot] != only)
+                            return nullptr;
+                        only = sub->vtable[slot];
+                    }
+                    return only && !only->is_abstract ? only : nullptr;
+                }
+                if (slot >= cls->vtable.size() || cls->vtable[slot]->is_abstract)
+                    return nullptr;
+                return cls->vtable[slot];
+            }
+
+            static bool IsNonNull(IrBuilder &b, const IrFunction &fn, ValueId v)
+            {
+                const IrInst &inst = b.At(v);
+                if (inst.op == IrOp::kNewObject)
+                    return true;
+                return inst.op == IrOp::kParam && inst.a == 0 && fn.method && !fn.method->is_static;
+            }
+
+            // a virtual call faults on a null receiver and a direct one does
+            // not, so the call gets a test that throws null, which raises the
+            // same NullReferenceException at the same line.
+            static void GuardNull(IrBuilder &b, BlockId block, std::size_t pos, ValueId receiver)
+            {
+                int line = b.LineOf(b.BlockInsts(block)[pos]);
+                BlockId cont = b.NewBlock();
+                BlockId fault = b.NewBlock();
+                {
+                    auto &insts = b.BlockInsts(block);
+                    b.BlockInsts(cont).assign(insts.begin() + static_cast<std::ptrdiff_t>(pos), insts.end());
+                    insts.resize(pos);
+                }
+                BlockId succ[2];
+                std::uint32_t n = b.Successors(cont, succ);
+                for (std::uint32_t i = 0; i < n; i++)
+                {
+                    if (i == 1 && succ[1] == succ[0])
+                        break;
+                    for (BlockId &pred : b.BlockPreds(succ[i]))
+                    {
+                        if (pred == block)
+                            pred = cont;
+                    }
+                }
+                IrInst null;
+                null.op = IrOp::kConst;
+                null.type = IrType::kRef;
+                ValueId null_value = b.Insert(block, null, line);
+                IrInst test;
+                test.op = IrOp::kEq;
+                test.type = IrType::kBool;
+                test.aux = static_cast<std::uint16_t>(IrType::kRef);
+                test.a = receiver;
+                test.b = null_value;
+                ValueId is_null = b.Insert(block, test, line);
+                IrInst branch;
+                branch.op = IrOp::kBranch;
+                branch.a = is_null;
+                branch.b = fault;
+                branch.c = cont;
+                b.Insert(block, branch, line);
+                b.BlockPreds(fault).push_back(block);
+                b.BlockPreds(cont).push_back(block);
+                IrInst thrown;
+                thrown.op = IrOp::kThrow;
+                thrown.a = b.Insert(fault, null, line);
+                b.Insert(fault, thrown, line);
+            }
+        };
+
+        // ------------------------------------------------------------------
+        // inlining
+
+        class Inliner : public IrPass
+        {
+        public:
+            explicit Inliner(std::uint32_t max_callee_insts) : max_callee_insts_(max_callee_insts) {}
+            const char *Name() const override { return "inline"; }
+
+            std::uint32_t Run(IrBuilder &b, const IrFunction &fn, const IrModule &module) const override
+            {
+                // calls present before inlining; calls inside inlined code are
+                // left for the next run of the pass.
+                std::vector<std::pair<ValueId, const IrFunction *>> calls;
+                for (BlockId block = 0; block < b.NumBlocks(); block++)
+                {
+                    for (ValueId v : b.BlockInsts(block))
+                    {
+                        const IrInst &inst = b.At(v);
+                        if (inst.op != IrOp::kCall || inst.c >= module.functions.size())
+                            continue;
+                        const IrFunction *callee = module.functions[inst.c].get();
+                        if (callee && callee != &fn && IsInlinable(*callee))
+                            calls.emplace_back(v, callee);
+                    }
+                }
+                std::uint32_t budget = fn.NumInsts() * 3 + 200;
+                std::uint32_t changes = 0;
+                for (auto [call, callee] : calls)
+                {
+                    if (b.NumValues() + callee->NumInsts() > fn.NumInsts() + budget)
+                        break;
+                    InlineCall(b, call, *callee);
+                    changes++;
+                }
+                return changes;
+            }
+
+        private:
+            bool IsInlinable(const IrFunction &callee) const
+            {
+                if (callee.NumInsts() > max_callee_insts_ || (callee.method && callee.method->is_async))
+                    return false;
+                for (ValueId v = 0; v < callee.NumInsts(); v++)
+                {
+                    if (callee.Inst(v).op == IrOp::kAwait)
+                        return false;
+                }
+                return true;
+            }
+
+            static BlockId BlockOf(IrBuilder &b, ValueId v, std::size_t &pos)
+            {
+                for (BlockId block = 0; block < b.NumBlocks(); block++)
+                {
+                    auto &insts = b.BlockInsts(block);
+                    auto it = std::find(insts.begin(), insts.end(), v);
+                    if (it != insts.end())
+                    {
+                        pos = static_cast<std::size_t>(it - insts.begin());
+                        return block;
+                    }
+                }
+                return kNoValue;
+            }
+
+            static void InlineCall(IrBuilder &b, ValueId call, const IrFunction &callee)
+            {
+                std::size_t pos = 0;
+                BlockId block = BlockOf(b, call, pos);
+                int line = b.LineOf(call);
+                std::vector<ValueId> args = b.ListOf(call);
+                for (ValueId &arg : args)
+                    arg = b.Resolve(arg);
+
+                // split the block after the call; the second half takes over
+                // the block's successors.
+                BlockId cont = b.NewBlock();
+                {
+                    auto &insts = b.BlockInsts(block);
+                    b.BlockInsts(cont).assign(insts.begin() + static_cast<std::ptrdiff_t>(pos) + 1, insts.end());
+                    insts.resize(pos);
+                }
+                BlockId succ[2];
+                std::uint32_t n = b.Successors(cont, succ);
+                for (std::uint32_t i = 0; i < n; i++)
+                {
+                    if (i == 1 && succ[1] == succ[0])
+                        break;
+                    for (BlockId &pred : b.BlockPreds(succ[i]))
+                    {
+                        if (pred == block)
+                            pred = cont;
+                    }
+                }
+
+                std::vector<BlockId> block_map(callee.NumBlocks());
+                for (BlockId cb = 0; cb < callee.NumBlocks(); cb++)
+                    block_map[cb] = b.NewBlock();
+                std::vector<ValueId> value_map(callee.NumInsts(), kNoValue);
+                std::vector<std::pair<BlockId, ValueId>> returns;
+                std::vector<ValueId> return_jumps;
+
+                // copy every instruction first, then point the copies at each
+                // other: phis may refer to values defined further down.
+                for (BlockId cb = 0; cb < callee.NumBlocks(); cb++)
+                {
+                    BlockId nb = block_map[cb];
+                    for (BlockId pred : callee.Preds(cb))
+                        b.BlockPreds(nb).push_back(block_map[pred]);
+                    for (ValueId v = callee.Block(cb).begin; v < callee.Block(cb).end; v++)
+                    {
+                        IrInst inst = callee.Inst(v);
+                        if (inst.op == IrOp::kParam)
+                        {
+                            value_map[v] = args[inst.a];
+                            continue;
+                        }
+                        if (inst.op == IrOp::kReturn)
+                        {
+                            returns.emplace_back(nb, inst.a);
+                            IrInst jump;
+                            jump.op = IrOp::kJump;
+                            jump.a = cont;
+                            return_jumps.push_back(b.Insert(nb, jump, line));
+                            continue;
+                        }
+                        if (inst.op == IrOp::kConst && inst.type == IrType::kRef && inst.aux == 1)
+                            inst.a = b.InternString(callee.String(inst.a));
+                        if (inst.op == IrOp::kPhi)
+                        {
+                            IrSpan<ValueId> ops = callee.Operands(inst);
+                            value_map[v] = b.InsertPhi(nb, inst.type, std::vector<ValueId>(ops.begin(), ops.end()));
+                            continue;
+                        }
+                        if (HasOperandList(inst.op))
+                        {
+                            IrSpan<ValueId> ops = callee.Operands(inst);
+                            std::vector<ValueId> list(ops.begin(), ops.end());
+                            value_map[v] = b.Insert(nb, inst, line, &list);
+                            continue;
+                        }
+                        value_map[v] = b.Insert(nb, inst, line);
+                    }
+                }
+                for (BlockId cb = 0; cb < callee.NumBlocks(); cb++)
+                {
+                    BlockId nb = block_map[cb];
+                    for (const auto *list : {&b.BlockPhis(nb), &b.BlockInsts(nb)})
+                    {
+                        for (ValueId v : *list)
+                        {
+                            IrInst &inst = b.At(v);
+                            if (std::find(return_jumps.begin(), return_jumps.end(), v) != return_jumps.end())
+                                continue;
+                            ForEachOperand(b, v, [&](ValueId &op) { op = value_map[op]; });
+                            if (inst.op == IrOp::kJump)
+                                inst.a = block_map[inst.a];
+                            else if (inst.op == IrOp::kBranch)
+                            {
+                                inst.b = block_map[inst.b];
+                                inst.c = block_map[inst.c];
+                            }
+                        }
+                    }
+                }
+
+                IrInst jump;
+                jump.op = IrOp::kJump;
+                jump.a = block_map[0];
+                b.Insert(block, jump, line);
+                b.BlockPreds(block_map[0]).push_back(block);
+
+                std::vector<ValueId> results;
+                for (auto [ret_block, value] : returns)
+                {
+                    b.BlockPreds(cont).push_back(ret_block);
+                    if (value != kNoValue)
+                        results.push_back(value_map[value]);
+                }
+                IrType type = b.At(call).type;
+                if (type != IrType::kVoid && !results.empty())
+                {
+                    ValueId result = results.size() == 1 ? results[0] : b.InsertPhi(cont, type, results);
+                    b.Replace(call, result);
+                }
+                b.Kill(call);
+            }
+
+            std::uint32_t max_callee_insts_;
+        };
+
+        // ------------------------------------------------------------------
+        // loop-invariant code motion
+
+        class LoopInvariantCodeMotion : public IrPass
+        {
+        public:
+            const char *Name() const override { return "licm"; }
+
+            std::uint32_t Run(IrBuilder &b, const IrFunction &, const IrModule &) const override
+            {
+                std::uint32_t changes = 0;
+                std::vector<bool> done;
+                // a preheader changes the CFG, so the analysis is redone after
+                // each loop; loops are handled innermost (smallest) first.
+                for (;;)
+                {
+                    Dominators dom{b};
+                    done.resize(b.NumBlocks(), false);
+                    BlockId header = kNoValue;
+                    std::vector<bool> body;
+                    std::size_t best = SIZE_MAX;
+                    for (BlockId h : dom.rpo)
+                    {
+                        if (done[h])
+                            continue;
+                        std::vector<bool> loop = LoopBody(b, dom, h);
+                        std::size_t size = static_cast<std::size_t>(std::count(loop.begin(), loop.end(), true));
+                        if (size > 0 && size < best)
+                        {
+                            best = size;
+                            header = h;
+                            body = std::move(loop);
+                        }
+                    }
+                    if (header == kNoValue)
+                        break;
+                    done[header] = true;
+                    changes += HoistFrom(b, dom, header, body);
+                }
+                return changes;
+            }
+
+        private:
+            // the blocks of the natural loop headed by h (empty when no back
+            // edge enters h).
+            static std::vector<bool> LoopBody(IrBuilder &b, const Dominators &dom, BlockId h)
+            {
+                std::vector<bool> body(b.NumBlocks(), false);
+                std::vector<BlockId> work;
+                for (BlockId pred : b.BlockPreds(h))
+                {
+                    if (dom.Dominates(h, pred) && !body[pred])
+                    {
+                        body[pred] = true;
+                        work.push_back(pred);
+                    }
+                }
+                if (work.empty())
+                    return std::vector<bool>(b.NumBlocks(), false);
+                body[h] = true;
+                while (!work.empty())
+                {
+                    BlockId block = work.back();
+                    work.pop_back();
+                    if (block == h)
+                        continue;
+                    for (BlockId pred : b.BlockPreds(block))
+                    {
+                        if (!body[pred] && dom.order[pred] != kNoValue)
+                        {
+                            body[pred] = true;
+                            work.push_back(pred);
+                        }
+                    }
+                }
+                return body;
+            }
+
+            static BlockId Preheader(IrBuilder &b, BlockId header, const std::vector<bool> &body)
+            {
+                std::vector<std::size_t> outside;
+                auto &preds = b.BlockPreds(header);
+                for (std::size_t i = 0; i < preds.size(); i++)
+                {
+                    if (!body[preds[i]])
+                        outside.push_back(i);
+                }
+                if (outside.size() == 1)
+                {
+                    BlockId succ[2];
+                    if (b.Successors(preds[outside[0]], succ) == 1)
+                        return preds[outside[0]];
+                }
+
+                BlockId pre = b.NewBlock();
+                std::vector<BlockId> old_preds = b.BlockPreds(header);
+                std::vector<BlockId> pre_preds;
+                for (std::size_t i : outside)
+                {
+                    BlockId pred = old_preds[i];
+                    pre_preds.push_back(pred);
+                    IrInst &term = b.At(b.BlockInsts(pred).back());
+                    // one edge per predecessor entry: a branch with both
+                    // targets on the header has two entries.
+                    if (term.op == IrOp::kJump && term.a == header)
+                        term.a = pre;
+                    else if (term.op == IrOp::kBranch && term.b == header)
+                        term.b = pre;
+                    else if (term.op == IrOp::kBranch && term.c == header)
+                        term.c = pre;
+                }
+                b.BlockPreds(pre) = pre_preds;
+
+                std::vector<BlockId> new_preds{pre};
+                std::vector<bool> is_outside(old_preds.size(), false);
+                for (std::size_t i : outside)
+                    is_outside[i] = true;
+                for (std::size_t i = 0; i < old_preds.size(); i++)
+                {
+                    if (!is_outside[i])
+                        new_preds.push_back(old_preds[i]);
+                }
+                for (ValueId phi : std::vector<ValueId>(b.BlockPhis(header)))
+                {
+                    if (b.At(phi).op != IrOp::kPhi)
+                        continue;
+                    std::vector<ValueId> list = b.ListOf(phi);
+                    std::vector<ValueId> entering, looping;
+                    for (std::size_t i = 0; i < list.size(); i++)
+                        (is_outside[i] ? entering : looping).push_back(list[i]);
+                    ValueId merged = entering[0];
+                    if (std::any_of(entering.begin(), entering.end(), [&](ValueId v) { return b.Resolve(v) != b.Resolve(entering[0]); }))
+                        merged = b.InsertPhi(pre, b.At(phi).type, entering);
+                    looping.insert(looping.begin(), merged);
+                    b.ListOf(phi) = looping;
+                    b.At(phi).b = static_cast<ValueId>(looping.size());
+                }
+                b.BlockPreds(header) = new_preds;
+                IrInst jump;
+                jump.op = IrOp::kJump;
+                jump.a = header;
+                b.Insert(pre, jump, b.LineOf(b.BlockInsts(header).front()));
+                return pre;
+            }
+
+            static std::uint32_t HoistFrom(IrBuilder &b, const Dominators &dom, BlockId header, const std::vector<bool> &body)
+            {
+                std::vector<BlockId> where(b.NumValues(), kNoValue);
+                for (BlockId block = 0; block < b.NumBlocks(); block++)
+                {
+                    for (const auto *list : {&b.BlockPhis(block), &b.BlockInsts(block)})
+                    {
+                        for (ValueId v : *list)
+                            where[v] = block;
+                    }
+                }
+                auto invariant = [&](ValueId v)
+                {
+                    v = b.Resolve(v);
+                    return where[v] == kNoValue || !body[where[v]];
+                };
+
+                std::vector<ValueId> hoisted;
+                for (BlockId block : dom.rpo)
+                {
+                    if (!body[block])
+                        continue;
+                    auto &insts = b.BlockInsts(block);
+                    for (std::size_t i = 0; i < insts.size(); i++)
+                    {
+                        ValueId v = insts[i];
+                        if (!IsPure(b.At(v)))
+                            continue;
+                        bool all = true;
+                        ForEachOperand(b, v, [&](ValueId &op) { all = all && invariant(op); });
+                        if (!all)
+                            continue;
+                        hoisted.push_back(v);
+                        where[v] = kNoValue;
+                    }
+                }
+                if (hoisted.empty())
+                    return 0;
+
+                std::vector<bool> moving(b.NumValues(), false);
+                for (ValueId v : hoisted)
+                    moving[v] = true;
+                for (BlockId block = 0; block < b.NumBlocks(); block++)
+                {
+                    if (!body[block])
+                        continue;
+                    auto &insts = b.BlockInsts(block);
+                    insts.erase(std::remove_if(insts.begin(), insts.end(), [&](ValueId v) { return moving[v]; }), insts.end());
+                }
+                BlockId pre = Preheader(b, header, body);
+                auto &pre_insts = b.BlockInsts(pre);
+                pre_insts.insert(pre_insts.end() - 1, hoisted.begin(), hoisted.end());
+                return static_cast<std::uint32_t>(hoisted.size());
+            }
+        };
+    }
+
+    std::unique_ptr<IrPass> MakeDeadCodeElimination()
+    {
+        return std::make_unique<DeadCodeElimination>();
+    }
+
+    std::unique_ptr<IrPass> MakeGlobalValueNumbering()
+    {
+        return std::make_unique<GlobalValueNumbering>();
+    }
+
+    std::unique_ptr<IrPass> MakeDevirtualization()
+    {
+        return std::make_unique<Devirtualizer>();
+    }
+
+    std::unique_ptr<IrPass> MakeInliner(std::uint32_t max_callee_insts)
+    {
+        return std::make_unique<Inliner>(max_callee_insts);
+    }
+
+    std::unique_ptr<IrPass> MakeLoopInvariantCodeMotion()
+    {
+        return std::make_unique<LoopInvariantCodeMotion>();
+    }
+
+}
@@ -0,0 +1,1113 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+
+#include "parser.h"
+#include "lexer.h"
+#include "utils.h"
+#include <sstream>
+
+namespace tinycsharp
+{
+    namespace
+    {
+        int BinaryPrecedence(TokenKind kind)
+        {
+            switch (kind)
+            {
+            case TokenKind::kTLogicalOr:
+            case TokenKind::kTOr:
+                return 1;
+            case TokenKind::kTLogicalAnd:
+                return 2;
+            case TokenKind::kTPipe:
+                return 3;
+            case TokenKind::kTXor:
+                return 4;
+            case TokenKind::kTAmpersand:
+                return 5;
+            case TokenKind::kTEquality:
+            case TokenKind::kTNeq:
+                return 6;
+            case TokenKind::kTLessThan:
+            case TokenKind::kTGreaterThan:
+            case TokenKind::kTLessOrEqual:
+            case TokenKind::kTGreaterOrEqual:
+                return 7;
+            case TokenKind::kTLShift:
+            case TokenKind::kTRShift:
+                return 8;
+            case TokenKind::kTPlus:
+            case TokenKind::kTMinus:
+                return 9;
+            case TokenKind::kTStar:
+            case TokenKind::kTFSlash:
+            case TokenKind::kTModulo:
+                return 10;
+            default:
+                return 0;
+            }
+        }
+
+        std::string Unescape(const std::string &raw)
+        {
+            std::string out;
+            out.reserve(raw.size());
+            for (std::size_t i = 0; i < raw.size(); i++)
+            {
+                if (raw[i] != '\\' || i + 1 == raw.size())
+                {
+                    out += raw[i];
+                    continue;
+                }
+                char c = raw[++i];
+                switch (c)
+                {
+                case 'n':
+                    out += '\n';
+                    break;
+                case 't':
+                    out += '\t';
+                    break;
+                case 'r':
+                    out += '\r';
+                    break;
+                case '0':
+                    out += '\0';
+                    break;
+                default:
+                    out += c;
+                    break;
+                }
+            }
+            return out;
+        }
+    }
+
+    ParseError::ParseError(const std::string &message, int line, int column)
+        : std::runtime_error(message), line(line), column(column)
+    {
+    }
+
+    Parser::Parser(AstContext &ctx, std::vector<Token> tokens, std::string_view file)
+        : ctx_(ctx), file_(ctx.CopyString(file))
+    {
+        tokens_.reserve(tokens.size() + 1);
+        for (auto &tok : tokens)
+        {
+            if (tok.kind != TokenKind::kTDocComment)
+            {
+                tokens_.push_back(std::move(tok));
+            }
+        }
+        if (tokens_.empty() || tokens_.back().kind != TokenKind::kTEof)
+        {
+            Token eof{TokenKind::kTEof, ""};
+            if (!tokens_.empty())
+            {
+                eof.loc = tokens_.back().loc;
+            }
+            tokens_.push_back(std::move(eof));
+        }
+    }
+
+    Parser::Parser(AstContext &ctx, const std::string &source, std::string_view file)
+        : Parser(ctx, Lexer{source, ctx.sources().Begin(ctx.sources().AddFile(std::string(file), source))}.Tokenize(), file)
+    {
+    }
+
+    const Token &Parser::Peek(std::size_t ahead) const
+    {
+        std::size_t i = pos_ + ahead;
+        return i < tokens_.size() ? tokens_[i] : tokens_.back();
+    }
+    const Token &Parser::Advance()
+    {
+        const Token &tok = Current();
+        if (pos_ + 1 < tokens_.size())
+        {
+            pos_++;
+        }
+        return tok;
+    }
+    bool Parser::Check(TokenKind kind) const
+    {
+        return Current().kind == kind;
+    }
+    bool Parser::Match(TokenKind kind)
+    {
+        if (Check(kind))
+        {
+            Advance();
+            return true;
+        }
+        return false;
+    }
+    const Token &Parser::Expect(TokenKind kind, const char *what)
+    {
+        if (!Check(kind))
+        {
+            Error(std::string("expected ") + what);
+        }
+        return Advance();
+    }
+    void Parser::Error(const std::string &message) const
+    {
+        const Token &tok = Current();
+        SourcePosition at = ctx_.sources().Decode(tok.loc);
+        std::ostringstream os;
+        if (!file_.empty())
+        {
+            os << file_ << ":";
+        }
+        os << at.line << ":" << at.column << ": " << message;
+        if (tok.kind == TokenKind::kTEof)
+        {
+            os << " but found end of file";
+        }
+        else
+        {
+            os << " but found '" << tok.lexeme << "'";
+        }
+        throw ParseError(os.str(), at.line, at.column);
+    }
+    std::string_view Parser::ExpectIdent(const char *what)
+    {
+        const Token &tok = Current();
+        bool ok = tok.kind == TokenKind::kTIdent || tok.kind == TokenKind::kTGet || tok.kind == TokenKind::kTSet ||
+                  (tok.kind == TokenKind::kTType && !IsClassKeyword(tok));
+        if (!ok)
+        {
+            Error(std::string("expected ") + what);
+        }
+        return ctx_.Intern(Advance().lexeme);
+    }
+
+    bool Parser::IsClassKeyword(const Token &tok) const
+    {
+        if (tok.kind == TokenKind::kTClass || tok.kind == TokenKind::kTStruct)
+        {
+            return true;
+        }
+        if (tok.kind != TokenKind::kTType)
+        {
+            return false;
+        }
+        std::string l = util::to_lowercase(tok.lexeme);
+        return l == "class" || l == "struct";
+    }
+    bool Parser::IsModifier(const Token &tok) const
+    {
+        switch (tok.kind)
+        {
+        case TokenKind::kTPublic:
+        case TokenKind::kTPrivate:
+        case TokenKind::kTProtected:
+        case TokenKind::kTInternal:
+        case TokenKind::kTStatic:
+        case TokenKind::kTConst:
+        case TokenKind::kTReadonly:
+        case TokenKind::kTVirtual:
+        case TokenKind::kTOverride:
+        case TokenKind::kTAbstract:
+        case TokenKind::kTSealed:
+        case TokenKind::kTAsync:
+            return true;
+        default:
+            return false;
+        }
+    }
+    Modifiers Parser::ParseModifiers()
+    {
+        Modifiers mods = 0;
+        while (IsModifier(Current()))
+        {
+            switch (Advance().kind)
+            {
+            case TokenKind::kTPublic:
+                mods |= kModPublic;
+                break;
+            case TokenKind::kTPrivate:
+                mods |= kModPrivate;
+                break;
+            case TokenKind::kTProtected:
+                mods |= kModProtected;
+                break;
+            case TokenKind::kTInternal:
+                mods |= kModInternal;
+                break;
+            case TokenKind::kTStatic:
+                mods |= kModStatic;
+                break;
+            case TokenKind::kTConst:
+                mods |= kModConst | kModStatic;
+                break;
+            case TokenKind::kTReadonly:
+                mods |= kModReadonly;
+                break;
+            case TokenKind::kTVirtual:
+                mods |= kModVirtual;
+                break;
+            case TokenKind::kTOverride:
+                mods |= kModOverride;
+                break;
+            case TokenKind::kTAbstract:
+                mods |= kModAbstract;
+                break;
+            case TokenKind::kTSealed:
+                mods |= kModSealed;
+                break;
+            case TokenKind::kTAsync:
+                mods |= kModAsync;
+                break;
+            default:
+                break;
+            }
+        }
+        return mods;
+    }
+    std::string_view Parser::ParseQualifiedName()
+    {
+        std::string name(ExpectIdent("a name"));
+        while (Check(TokenKind::kTDot))
+        {
+            Advance();
+            name += ".";
+            name += ExpectIdent("a name after '.'");
+        }
+        return ctx_.Intern(name);
+    }
+
+    CompilationUnit *Parser::ParseCompilationUnit()
+    {
+        const Token &first = Current();
+        auto *unit = ctx_.Make<CompilationUnit>(first.loc);
+        unit->file = file_;
+        unit->sources = &ctx_.sources();
+        unit_ = unit;
+
+        std::vector<UsingDirective *> usings;
+        std::vector<Node *> members;
+        while (Check(TokenKind::kTUsing))
+        {
+            usings.push_back(ParseUsing());
+        }
+        while (!Check(TokenKind::kTEof))
+        {
+            if (Check(TokenKind::kTNamespace))
+            {
+                NamespaceDecl *ns = ParseNamespace(nullptr);
+                members.push_back(ns);
+                continue;
+            }
+            if (Match(TokenKind::kTSemiColon))
+            {
+                continue;
+            }
+            Modifiers mods = ParseModifiers();
+            if (!IsClassKeyword(Current()))
+            {
+                Error("expected a namespace, class or struct declaration");
+            }
+            members.push_back(ParseClass(mods, nullptr, nullptr));
+        }
+        unit->usings = ctx_.MakeList(usings);
+        unit->members = ctx_.MakeList(members);
+        ctx_.units.push_back(unit);
+        return unit;
+    }
+
+    UsingDirective *Parser::ParseUsing()
+    {
+        const Token &kw = Expect(TokenKind::kTUsing, "'using'");
+        auto *u = ctx_.Make<UsingDirective>(kw.loc);
+        u->name = ParseQualifiedName();
+        u->name_id = ctx_.Symbol(u->name);
+        Expect(TokenKind::kTSemiColon, "';' after using directive");
+        return u;
+    }
+
+    NamespaceDecl *Parser::ParseNamespace(NamespaceDecl *outer)
+    {
+        const Token &kw = Expect(TokenKind::kTNamespace, "'namespace'");
+        auto *ns = ctx_.Make<NamespaceDecl>(kw.loc);
+        ns->outer = outer;
+        ns->name = ParseQualifiedName();
+        if (outer)
+        {
+            ns->name = ctx_.Intern(std::string(outer->name) + "." + std::string(ns->name));
+        }
+        ns->name_id = ctx_.Symbol(ns->name);
+
+        std::vector<UsingDirective *> usings;
+        std::vector<Node *> members;
+        if (Match(TokenKind::kTSemiColon))
+        {
+            // file scoped namespace: the rest of the unit belongs to it.
+            ParseNamespaceBody(ns, usings, members, false);
+        }
+        else
+        {
+            Expect(TokenKind::kTLCurly, "'{' after namespace name");
+            ParseNamespaceBody(ns, usings, members, true);
+            Expect(TokenKind::kTRCurly, "'}' to close namespace");
+        }
+        ns->usings = ctx_.MakeList(usings);
+        ns->members = ctx_.MakeList(members);
+        return ns;
+    }
+
+    void Parser::ParseNamespaceBody(NamespaceDecl *ns, std::vector<UsingDirective *> &usings, std::vector<Node *> &members, bool braced)
+    {
+        while (Check(TokenKind::kTUsing))
+        {
+            usings.push_back(ParseUsing());
+        }
+        while (!Check(TokenKind::kTEof) && !(braced && Check(TokenKind::kTRCurly)))
+        {
+            if (Check(TokenKind::kTNamespace))
+            {
+                members.push_back(ParseNamespace(ns));
+                continue;
+            }
+            if (Match(TokenKind::kTSemiColon))
+            {
+                continue;
+            }
+            Modifiers mods = ParseModifiers();
+            if (!IsClassKeyword(Current()))
+            {
+                Error("expected a class or struct declaration");
+            }
+            members.push_back(ParseClass(mods, ns, nullptr));
+        }
+    }
+
+    ClassDecl *Parser::ParseClass(Modifiers mods, NamespaceDecl *ns, ClassDecl *outer)
+    {
+        const Token &kw = Advance();
+        auto *cls = ctx_.Make<ClassDecl>(kw.loc);
+        cls->modifiers = mods;
+        cls->is_struct = kw.kind == TokenKind::kTStruct || util::to_lowercase(kw.lexeme) == "struct";
+        cls->unit = unit_;
+        cls->ns = ns;
+        cls->outer = outer;
+        cls->name = ExpectIdent("a class name");
+        cls->name_id = ctx_.Symbol(cls->name);
+
+        std::vector<TypeRef *> bases;
+        if (Match(TokenKind::kTColon))
+        {
+            do
+            {
+                bases.push_back(ParseType());
+            } while (Match(TokenKind::kTComma));
+        }
+        cls->bases = ctx_.MakeList(bases);
+
+        Expect(TokenKind::kTLCurly, "'{' to open class body");
+        std::vector<Node *> members;
+        while (!Check(TokenKind::kTRCurly) && !Check(TokenKind::kTEof))
+        {
+            ParseMember(cls, members);
+        }
+        Expect(TokenKind::kTRCurly, "'}' to close class body");
+        Match(TokenKind::kTSemiColon);
+        cls->members = ctx_.MakeList(members);
+        return cls;
+    }
+
+    void Parser::ParseMember(ClassDecl *owner, std::vector<Node *> &members)
+    {
+        if (Match(TokenKind::kTSemiColon))
+        {
+            return;
+        }
+        Modifiers mods = ParseModifiers();
+        if (IsClassKeyword(Current()))
+        {
+            members.push_back(ParseClass(mods, owner->ns, owner));
+            return;
+        }
+        if (Current().kind == TokenKind::kTIdent && Current().lexeme == owner->name &&
+            Peek(1).kind == TokenKind::kTLParen)
+        {
+            const Token &name = Advance();
+            members.push_back(ParseMethodRest(owner, mods, nullptr, name));
+            return;
+        }
+
+        TypeRef *type = ParseType();
+        const Token &name = Current();
+        std::string_view ident = ExpectIdent("a member name");
+        if (Check(TokenKind::kTLParen))
+        {
+            members.push_back(ParseMethodRest(owner, mods, type, name));
+            return;
+        }
+
+        auto *field = ctx_.Make<FieldDecl>(name.loc);
+        field->name = ident;
+        field->name_id = ctx_.Symbol(field->name);
+        field->modifiers = mods;
+        field->owner = owner;
+        field->type = type;
+        if (Check(TokenKind::kTLCurly))
+        {
+            ParsePropertyRest(field);
+            members.push_back(field);
+            return;
+        }
+        while (true)
+        {
+            if (Match(TokenKind::kTAssign))
+            {
+                field->init = ParseExpression();
+            }
+            members.push_back(field);
+            if (!Match(TokenKind::kTComma))
+            {
+                break;
+            }
+            const Token &next = Current();
+            std::string_view next_name = ExpectIdent("a field name");
+            field = ctx_.Make<FieldDecl>(next.loc);
+            field->name = next_name;
+            field->name_id = ctx_.Symbol(field->name);
+            field->modifiers = mods;
+            field->owner = owner;
+            field->type = type;
+        }
+        Expect(TokenKind::kTSemiColon, "';' after field declaration");
+    }
+
+    void Parser::ParsePropertyRest(FieldDecl *field)
+    {
+        field->is_property = true;
+        Expect(TokenKind::kTLCurly, "'{' to open property accessors");
+        while (!Check(TokenKind::kTRCurly) && !Check(TokenKind::kTEof))
+        {
+            ParseModifiers();
+            if (!Match(TokenKind::kTGet) && !Match(TokenKind::kTSet))
+            {
+                Error("expected 'get' or 'set'");
+            }
+            if (!Match(TokenKind::kTSemiColon))
+            {
+                Error("only auto-implemented accessors are supported; expected ';'");
+            }
+        }
+        Expect(TokenKind::kTRCurly, "'}' to close property accessors");
+        if (Match(TokenKind::kTAssign))
+        {
+            field->init = ParseExpression();
+            Expect(TokenKind::kTSemiColon, "';' after property initializer");
+        }
+    }
+
+    MethodDecl *Parser::ParseMethodRest(ClassDecl *owner, Modifiers mods, TypeRef *return_type, const Token &name)
+    {
+        auto *method = ctx_.Make<MethodDecl>(name.loc);
+        method->name = ctx_.Intern(name.lexeme);
+        method->name_id = ctx_.Symbol(method->name);
+        method->modifiers = mods;
+        method->owner = owner;
+        method->return_type = return_type;
+        method->is_ctor = return_type == nullptr;
+
+        Expect(TokenKind::kTLParen, "'(' to open parameter list");
+        std::vector<ParamDecl *> params;
+        if (!Check(TokenKind::kTRParen))
+        {
+            do
+            {
+                const Token &start = Current();
+                auto *param = ctx_.Make<ParamDecl>(start.loc);
+                param->type = ParseType();
+                param->name = ExpectIdent("a parameter name");
+                param->name_id = ctx_.Symbol(param->name);
+                param->index = static_cast<std::uint32_t>(params.size());
+                params.push_back(param);
+            } while (Match(TokenKind::kTComma));
+        }
+        Expect(TokenKind::kTRParen, "')' to close parameter list");
+        method->params = ctx_.MakeList(params);
+
+        if (Check(TokenKind::kTLCurly))
+        {
+            method->body = ParseBlock();
+        }
+        else if (Check(TokenKind::kTArrow))
+        {
+            const Token &arrow = Advance();
+            Expr *value = ParseExpression();
+            Expect(TokenKind::kTSemiColon, "';' after expression body");
+            auto *body = ctx_.Make<BlockStmt>(arrow.loc);
+            Node *stmt;
+            if (return_type && return_type->name == "void")
+            {
+                auto *es = ctx_.Make<ExprStmt>(arrow.loc);
+                es->expr = value;
+                stmt = es;
+            }
+            else
+            {
+                auto *ret = ctx_.Make<ReturnStmt>(arrow.loc);
+                ret->value = value;
+                stmt = ret;
+            }
+            body->stmts = ctx_.MakeList(std::vector<Node *>{stmt});
+            method->body = body;
+        }
+        else
+        {
+            Expect(TokenKind::kTSemiColon, "a method body or ';'");
+        }
+        return method;
+    }
+
+    bool Parser::StartsType(const Token &tok) const
+    {
+        return tok.kind == TokenKind::kTIdent || tok.kind == TokenKind::kTVoid ||
+               (tok.kind == TokenKind::kTType && !IsClassKeyword(tok));
+    }
+
+    TypeRef *Parser::ParseType()
+    {
+        const Token &start = Current();
+        if (!StartsType(start))
+        {
+            Error("expected a type");
+        }
+        auto *type = ctx_.Make<TypeRef>(start.loc);
+        std::string name = Advance().lexeme;
+        while (Check(TokenKind::kTDot) && StartsType(Peek(1)))
+        {
+            Advance();
+            name += ".";
+            name += Advance().lexeme;
+        }
+        type->name = ctx_.Intern(name);
+        type->name_id = ctx_.Symbol(type->name);
+        if (Match(TokenKind::kTLessThan))
+        {
+            std::vector<TypeRef *> args;
+            do
+            {
+                args.push_back(ParseType());
+            } while (Match(TokenKind::kTComma));
+            Expect(TokenKind::kTGreaterThan, "'>' to close type arguments");
+            type->args = ctx_.MakeList(args);
+        }
+        while (Check(TokenKind::kTLSquare) && Peek(1).kind == TokenKind::kTRSquare)
+        {
+            Advance();
+            Advance();
+            type->array_rank++;
+        }
+        return type;
+    }
+
+    // token-level lookahead used to tell `Foo x = ...;` apart from an
+    // expression statement without allocating nodes for the guess.
+    bool Parser::LooksLikeLocalDecl()
+    {
+        std::size_t i = 0;
+        auto at = [&](std::size_t k) -> const Token &
+        { return Peek(k); };
+        if (!StartsType(at(i)))
+        {
+            return false;
+        }
+        i++;
+        while (at(i).kind == TokenKind::kTDot && StartsType(at(i + 1)))
+        {
+            i += 2;
+        }
+        if (at(i).kind == TokenKind::kTLessThan)
+        {
+            int depth = 0;
+            do
+            {
+                if (at(i).kind == TokenKind::kTLessThan)
+                    depth++;
+                else if (at(i).kind == TokenKind::kTGreaterThan)
+                    depth--;
+                else if (!StartsType(at(i)) && at(i).kind != TokenKind::kTComma && at(i).kind != TokenKind::kTDot)
+                    return false;
+                i++;
+            } while (depth > 0);
+        }
+        while (at(i).kind == TokenKind::kTLSquare && at(i + 1).kind == TokenKind::kTRSquare)
+        {
+            i += 2;
+        }
+        const Token &name = at(i);
+        if (name.kind != TokenKind::kTIdent && !(name.kind == TokenKind::kTType && !IsClassKeyword(name)))
+        {
+            return false;
+        }
+        TokenKind next = at(i + 1).kind;
+        return next == TokenKind::kTAssign || next == TokenKind::kTSemiColon || next == TokenKind::kTComma;
+    }
+
+    BlockStmt *Parser::ParseBlock()
+    {
+        const Token &open = Expect(TokenKind::kTLCurly, "'{'");
+        auto *block = ctx_.Make<BlockStmt>(open.loc);
+        std::vector<Node *> stmts;
+        while (!Check(TokenKind::kTRCurly) && !Check(TokenKind::kTEof))
+        {
+            if (Node *stmt = ParseStatement())
+            {
+                stmts.push_back(stmt);
+            }
+        }
+        Expect(TokenKind::kTRCurly, "'}' to close block");
+        block->stmts = ctx_.MakeList(stmts);
+        return block;
+    }
+
+    Node *Parser::ParseLocalVar(TypeRef *type, bool is_const)
+    {
+        const Token &name = Current();
+        auto *local = ctx_.Make<LocalVarStmt>(name.loc);
+        local->name = ExpectIdent("a variable name");
+        local->name_id = ctx_.Symbol(local->name);
+        local->type = type;
+        local->is_const = is_const;
+        if (Match(TokenKind::kTAssign))
+        {
+            local->init = ParseExpression();
+        }
+        else if (!type || is_const)
+        {
+            Error("expected '=' and an initializer");
+        }
+        if (Check(TokenKind::kTComma))
+        {
+            Error("multiple declarators in one local declaration are not supported");
+        }
+        Expect(TokenKind::kTSemiColon, "';' after local declaration");
+        return local;
+    }
+
+    Node *Parser::ParseStatement()
+    {
+        const Token &tok = Current();
+        switch (tok.kind)
+        {
+        case TokenKind::kTLCurly:
+            return ParseBlock();
+        case TokenKind::kTSemiColon:
+            Advance();
+            return nullptr;
+        case TokenKind::kTVar:
+            Advance();
+            return ParseLocalVar(nullptr, false);
+        case TokenKind::kTConst:
+        {
+            Advance();
+            TypeRef *type = ParseType();
+            return ParseLocalVar(type, true);
+        }
+        case TokenKind::kTIf:
+        {
+            Advance();
+            auto *stmt = ctx_.Make<IfStmt>(tok.loc);
+            Expect(TokenKind::kTLParen, "'(' after 'if'");
+            stmt->cond = ParseExpression();
+            Expect(TokenKind::kTRParen, "')' after if condition");
+            stmt->then_stmt = ParseStatement();
+            if (Match(TokenKind::kTElse))
+            {
+                stmt->else_stmt = ParseStatement();
+            }
+            return stmt;
+        }
+        case TokenKind::kTWhile:
+        {
+            Advance();
+            auto *stmt = ctx_.Make<WhileStmt>(tok.loc);
+            Expect(TokenKind::kTLParen, "'(' after 'while'");
+            stmt->cond = ParseExpression();
+            Expect(TokenKind::kTRParen, "')' after while condition");
+            stmt->body = ParseStatement();
+            return stmt;
+        }
+        case TokenKind::kTDo:
+        {
+            Advance();
+            auto *stmt = ctx_.Make<DoWhileStmt>(tok.loc);
+            stmt->body = ParseStatement();
+            Expect(TokenKind::kTWhile, "'while' after do body");
+            Expect(TokenKind::kTLParen, "'(' after 'while'");
+            stmt->cond = ParseExpression();
+            Expect(TokenKind::kTRParen, "')' after do-while condition");
+            Expect(TokenKind::kTSemiColon, "';' after do-while");
+            return stmt;
+        }
+        case TokenKind::kTReturn:
+        {
+            Advance();
+            auto *stmt = ctx_.Make<ReturnStmt>(tok.loc);
+            if (!Check(TokenKind::kTSemiColon))
+            {
+                stmt->value = ParseExpression();
+            }
+            Expect(TokenKind::kTSemiColon, "';' after return");
+            return stmt;
+        }
+        case TokenKind::kTBreak:
+        {
+            Advance();
+            auto *stmt = ctx_.Make<BreakStmt>(tok.loc);
+            Expect(TokenKind::kTSemiColon, "';' after break");
+            return stmt;
+        }
+        case TokenKind::kTContinue:
+        {
+            Advance();
+            auto *stmt = ctx_.Make<ContinueStmt>(tok.loc);
+            Expect(TokenKind::kTSemiColon, "';' after continue");
+            return stmt;
+        }
+        case TokenKind::kTThrow:
+        {
+            Advance();
+            auto *stmt = ctx_.Make<ThrowStmt>(tok.loc);
+            if (!Check(TokenKind::kTSemiColon))
+            {
+                stmt->value = ParseExpression();
+            }
+            Expect(TokenKind::kTSemiColon, "';' after throw");
+            return stmt;
+        }
+        default:
+            break;
+        }
+
+        if (LooksLikeLocalDecl())
+        {
+            TypeRef *type = ParseType();
+            return ParseLocalVar(type, false);
+        }
+        auto *stmt = ctx_.Make<ExprStmt>(tok.loc);
+        stmt->expr = ParseExpression();
+        Expect(TokenKind::kTSemiColon, "';' after expression");
+        return stmt;
+    }
+
+    Expr *Parser::ParseExpression()
+    {
+        return ParseAssignment();
+    }
+
+    Expr *Parser::ParseAssignment()
+    {
+        Expr *target = ParseConditional();
+        TokenKind kind = Current().kind;
+        if (kind == TokenKind::kTAssign || kind == TokenKind::kTPlusAssign || kind == TokenKind::kTMinusAssign)
+        {
+            const Token &op = Advance();
+            auto *assign = ctx_.Make<AssignExpr>(op.loc);
+            assign->op = kind;
+            assign->target = target;
+            assign->value = ParseAssignment();
+            return assign;
+        }
+        return target;
+    }
+
+    Expr *Parser::ParseConditional()
+    {
+        Expr *cond = ParseBinary(1);
+        if (!Check(TokenKind::kTQuestion))
+        {
+            return cond;
+        }
+        const Token &q = Advance();
+        auto *expr = ctx_.Make<ConditionalExpr>(q.loc);
+        expr->cond = cond;
+        expr->then_expr = ParseExpression();
+        Expect(TokenKind::kTColon, "':' in conditional expression");
+        expr->else_expr = ParseConditional();
+        return expr;
+    }
+
+    Expr *Parser::ParseBinary(int min_prec)
+    {
+        Expr *lhs = ParseUnary();
+        while (true)
+        {
+            TokenKind kind = Current().kind;
+            int prec = BinaryPrecedence(kind);
+            if (prec == 0 || prec < min_prec)
+            {
+                return lhs;
+            }
+            const Token &op = Advance();
+            auto *bin = ctx_.Make<BinaryExpr>(op.loc);
+            bin->op = kind == TokenKind::kTOr ? TokenKind::kTLogicalOr : kind;
+            bin->lhs = lhs;
+            bin->rhs = ParseBinary(prec + 1);
+            lhs = bin;
+        }
+    }
+
+    Expr *Parser::ParseUnary()
+    {
+        const Token &tok = Current();
+        switch (tok.kind)
+        {
+        case TokenKind::kTMinus:
+        {
+            // -<integer literal> is a single literal, as in C#, so that
+            // int.MinValue and long.MinValue can be written out.
+            const Token &operand = Peek(1);
+            TokenKind after = Peek(2).kind;
+            bool postfix = after == TokenKind::kTDot || after == TokenKind::kTLParen || after == TokenKind::kTLSquare ||
+                           after == TokenKind::kTIncrement || after == TokenKind::kTDecrement;
+            if (operand.kind == TokenKind::kTNLiteral && operand.int_val && !postfix)
+            {
+                Advance();
+                Advance();
+                auto *lit = ctx_.Make<LiteralExpr>(tok.loc);
+                lit->literal_kind = LiteralKind::kInt;
+                lit->int_value = static_cast<std::int64_t>(0ull - static_cast<std::uint64_t>(*operand.int_val));
+                return lit;
+            }
+            Advance();
+            auto *un = ctx_.Make<UnaryExpr>(tok.loc);
+            un->op = tok.kind;
+            un->operand = ParseUnary();
+            return un;
+        }
+        case TokenKind::kTNot:
+        case TokenKind::kTPlus:
+        case TokenKind::kTIncrement:
+        case TokenKind::kTDecrement:
+        {
+            Advance();
+            auto *un = ctx_.Make<UnaryExpr>(tok.loc);
+            un->op = tok.kind;
+            un->operand = ParseUnary();
+            return un;
+        }
+        case TokenKind::kTAwait:
+        {
+            Advance();
+            auto *aw = ctx_.Make<AwaitExpr>(tok.loc);
+            aw->operand = ParseUnary();
+            return aw;
+        }
+        case TokenKind::kTLParen:
+        {
+            // (T)x is a cast when T is a built-in type, or a named type that is
+            // followed by something that can only start an operand.
+            const Token &inner = Peek(1);
+            bool builtin = inner.kind == TokenKind::kTType && !IsClassKeyword(inner);
+            if ((builtin || inner.kind == TokenKind::kTIdent) && Peek(2).kind == TokenKind::kTRParen)
+            {
+                TokenKind after = Peek(3).kind;
+                bool operand_follows = after == TokenKind::kTIdent || after == TokenKind::kTNLiteral ||
+                                       after == TokenKind::kTSLiteral || after == TokenKind::kTBLiteral ||
+                                       after == TokenKind::kTLParen || after == TokenKind::kTThis ||
+                                       after == TokenKind::kTNew ||
+                                       (after == TokenKind::kTType && !IsClassKeyword(Peek(3)));
+                if (builtin && (after == TokenKind::kTMinus || after == TokenKind::kTNot))
+                {
+                    operand_follows = true;
+                }
+                if (operand_follows)
+                {
+                    Advance();
+                    auto *cast = ctx_.Make<CastExpr>(tok.loc);
+                    cast->type = ParseType();
+                    Expect(TokenKind::kTRParen, "')' after cast type");
+                    cast->operand = ParseUnary();
+                    return cast;
+                }
+            }
+            break;
+        }
+        default:
+            break;
+        }
+        return ParsePostfix(ParsePrimary());
+    }
+
+    Expr *Parser::ParsePostfix(Expr *expr)
+    {
+        while (true)
+        {
+            const Token &tok = Current();
+            if (tok.kind == TokenKind::kTDot)
+            {
+                Advance();
+                auto *member = ctx_.Make<MemberExpr>(tok.loc);
+                member->object = expr;
+                member->name = ExpectIdent("a member name after '.'");
+                member->name_id = ctx_.Symbol(member->name);
+                expr = member;
+            }
+            else if (tok.kind == TokenKind::kTLParen)
+            {
+                auto *call = ctx_.Make<CallExpr>(expr->loc);
+                call->callee = expr;
+                call->args = ParseArguments();
+                expr = call;
+            }
+            else if (tok.kind == TokenKind::kTLSquare)
+            {
+                Advance();
+                auto *index = ctx_.Make<IndexExpr>(tok.loc);
+                index->object = expr;
+                index->index = ParseExpression();
+                Expect(TokenKind::kTRSquare, "']' after index");
+                expr = index;
+            }
+            else if (tok.kind == TokenKind::kTIncrement || tok.kind == TokenKind::kTDecrement)
+            {
+                Advance();
+                auto *un = ctx_.Make<UnaryExpr>(tok.loc);
+                un->op = tok.kind;
+                un->postfix = true;
+                un->operand = expr;
+                expr = un;
+            }
+            else
+            {
+                return expr;
+            }
+        }
+    }
+
+    NodeList<Expr> Parser::ParseArguments()
+    {
+        Expect(TokenKind::kTLParen, "'('");
+        std::vector<Expr *> args;
+        if (!Check(TokenKind::kTRParen))
+        {
+            do
+            {
+                args.push_back(ParseExpression());
+            } while (Match(TokenKind::kTComma));
+        }
+        Expect(TokenKind::kTRParen, "')' to close argument list");
+        return ctx_.MakeList(args);
+    }
+
+    Expr *Parser::ParsePrimary()
+    {
+        const Token &tok = Current();
+        switch (tok.kind)
+        {
+        case TokenKind::kTNLiteral:
+        {
+            if (tok.int_val && *tok.int_val == INT64_MIN)
+            {
+                // only reachable without a leading '-'; see ParseUnary.
+                SourcePosition at = ctx_.sources().Decode(tok.loc);
+                std::ostringstream os;
+                if (!file_.empty())
+                {
+                    os << file_ << ":";
+                }
+                os << at.line << ":" << at.column << ": Integral constant is too large: " << tok.lexeme;
+                throw ParseError(os.str(), at.line, at.column);
+            }
+            Advance();
+            auto *lit = ctx_.Make<LiteralExpr>(tok.loc);
+            if (tok.float_val)
+            {
+                lit->literal_kind = LiteralKind::kFloat;
+                lit->float_value = *tok.float_val;
+            }
+            else
+            {
+                lit->literal_kind = LiteralKind::kInt;
+                lit->int_value = tok.int_val ? *tok.int_val : 0;
+            }
+            return lit;
+        }
+        case TokenKind::kTSLiteral:
+        {
+            Advance();
+            auto *lit = ctx_.Make<LiteralExpr>(tok.loc);
+            lit->literal_kind = LiteralKind::kString;
+            lit->string_value = ctx_.CopyString(Unescape(tok.lexeme));
+            return lit;
+        }
+        case TokenKind::kTBLiteral:
+        {
+            Advance();
+            auto *lit = ctx_.Make<LiteralExpr>(tok.loc);
+            lit->literal_kind = LiteralKind::kBool;
+            lit->bool_value = util::to_lowercase(tok.lexeme) == "true";
+            return lit;
+        }
+        case TokenKind::kTThis:
+            Advance();
+            return ctx_.Make<ThisExpr>(tok.loc);
+        case TokenKind::kTNew:
+        {
+            Advance();
+            auto *expr = ctx_.Make<NewExpr>(tok.loc);
+            expr->type = ParseType();
+            if (Check(TokenKind::kTLSquare))
+            {
+                // new T[n]
+                Advance();
+                expr->args = ctx_.MakeList(std::vector<Expr *>{ParseExpression()});
+                Expect(TokenKind::kTRSquare, "']' after array length");
+                expr->type->array_rank++;
+                return expr;
+            }
+            expr->args = ParseArguments();
+            return expr;
+        }
+        case TokenKind::kTLParen:
+        {
+            Advance();
+            Expr *inner = ParseExpression();
+            Expect(TokenKind::kTRParen, "')'");
+            return inner;
+        }
+        case TokenKind::kTIdent:
+        case TokenKind::kTType:
+        case TokenKind::kTGet:
+        case TokenKind::kTSet:
+        {
+            if (IsClassKeyword(tok))
+            {
+                break;
+            }
+            Advance();
+            auto *name = ctx_.Make<NameExpr>(tok.loc);
+            name->name = ctx_.Intern(tok.lexeme);
+            name->name_id = ctx_.Symbol(name->name);
+            return name;
+        }
+        default:
+            break;
+        }
+        Error("expected an expression");
+    }
+
+}
@@ -0,0 +1,155 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include "passes.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <stdexcept>
+
+namespace tinycsharp
+{
+    OptLevel ParseOptLevel(std::string_view s)
+    {
+        if (!s.empty() && s[0] == '-')
+        {
+            s.remove_prefix(1);
+        }
+        if (s == "O0")
+            return OptLevel::kO0;
+        if (s == "O1")
+            return OptLevel::kO1;
+        if (s == "O2")
+            return OptLevel::kO2;
+        throw std::invalid_argument("unknown optimization level '" + std::string(s) + "'");
+    }
+
+    void PassManager::Add(std::unique_ptr<IrPass> pass)
+    {
+        passes_.push_back(std::move(pass));
+    }
+
+    void PassManager::AddPipeline(OptLevel level)
+    {
+        switch (level)
+        {
+        case OptLevel::kO0:
+            break;
+        case OptLevel::kO1:
+            Add(MakeGlobalValueNumbering());
+            Add(MakeDeadCodeElimination());
+            break;
+        case OptLevel::kO2:
+            Add(MakeGlobalValueNumbering());
+            Add(MakeDeadCodeElimination());
+            Add(MakeDevirtualization());
+            Add(MakeInliner(40));
+            Add(MakeGlobalValueNumbering());
+            Add(MakeLoopInvariantCodeMotion());
+            Add(MakeGlobalValueNumbering());
+            Add(MakeDeadCodeElimination());
+            break;
+        }
+    }
+
+    void PassManager::Run(IrModule &module)
+    {
+        const std::size_t n = module.functions.size();
+        for (const auto &pass : passes_)
+        {
+            PassStats stats;
+            stats.pass = pass->Name();
+            stats.insts_before = module.NumInsts();
+            auto start = std::chrono::steady_clock::now();
+
+            // passes read the module as it was before they started, so the
+            // rewritten functions are only swapped in once all are done.
+            std::vector<std::unique_ptr<IrFunction>> rewritten(n);
+            std::vector<std::uint32_t> changes(n, 0);
+            auto run = [&](std::size_t i)
+            {
+                const IrFunction *fn = module.functions[i].get();
+                if (!fn)
+                    return;
+                IrBuilder builder{*fn};
+                changes[i] = pass->Run(builder, *fn, module);
+                if (changes[i] == 0)
+                    return;
+                rewritten[i] = builder.Finalize();
+                if (verify_)
+                {
+                    std::string error = VerifyIr(*rewritten[i]);
+                    if (!error.empty())
+                        throw std::logic_error(std::string(pass->Name()) + " broke " + error);
+                }
+            };
+            if (pool_)
+            {
+                pool_->ParallelFor(n, run);
+            }
+            else
+            {
+                for (std::size_t i = 0; i < n; i++)
+                    run(i);
+            }
+
+            for (std::size_t i = 0; i < n; i++)
+            {
+                if (rewritten[i])
+                {
+                    module.functions[i] = std::move(rewritten[i]);
+                    stats.functions_changed++;
+                    stats.changes += changes[i];
+                }
+            }
+            stats.millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            stats.insts_after = module.NumInsts();
+            stats_.push_back(std::move(stats));
+        }
+    }
+
+    void PassManager::PrintStats(std::ostream &out) const
+    {
+        // the name and insts columns are as wide as their longest entry, so
+        // long pass names and large functions keep the table aligned.
+        std::size_t name_width = 4;
+        std::size_t insts_width = 5;
+        std::vector<std::string> insts;
+        insts.reserve(stats_.size());
+        for (const auto &s : stats_)
+        {
+            name_width = std::max(name_width, s.pass.size());
+            insts.push_back(std::to_string(s.insts_before) + " -> " + std::to_string(s.insts_after));
+            insts_width = std::max(insts_width, insts.back().size());
+        }
+        int name_w = static_cast<int>(name_width + 2);
+        int insts_w = static_cast<int>(insts_width + 2);
+        out << std::left << std::setw(name_w) << "pass" << std::right << std::setw(10) << "ms" << std::setw(10) << "changes"
+            << std::setw(11) << "functions" << std::setw(insts_w) << "insts" << "\n";
+        for (std::size_t i = 0; i < stats_.size(); i++)
+        {
+            const auto &s = stats_[i];
+            out << std::left << std::setw(name_w) << s.pass << std::right << std::setw(10) << std::fixed << std::setprecision(3)
+                << s.millis << std::setw(10) << s.changes << std::setw(11) << s.functions_changed << std::setw(insts_w)
+                << insts[i] << "\n";
+        }
+    }
+
+}
@@ -0,0 +1,268 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include "profiler.h"
+#include <algorithm>
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TINYCSHARP_SIGPROF 1
+#include <csignal>
+#include <sys/time.h>
+#else
+#define TINYCSHARP_SIGPROF 0
+#endif
+
+namespace tinycsharp
+{
+    std::atomic<std::uint32_t> Profiler::ticks_{0};
+
+    namespace
+    {
+#if TINYCSHARP_SIGPROF
+        // the profiler whose timer runs.
+        std::atomic<Profiler *> sampling{nullptr};
+        struct sigaction previous_action;
+#endif
+
+        double Percent(std::uint64_t part, std::uint64_t whole)
+        {
+            return whole ? 100.0 * static_cast<double>(part) / static_cast<double>(whole) : 0.0;
+        }
+    }
+
+    Profiler::Profiler(Mode mode, std::chrono::microseconds interval) : mode_(mode), interval_(interval)
+    {
+        nodes_.push_back(Node{nullptr, 0});
+    }
+
+    Profiler::~Profiler()
+    {
+        Stop();
+    }
+
+    bool Profiler::SamplingSupported()
+    {
+        return TINYCSHARP_SIGPROF;
+    }
+
+    void Profiler::Tick(int)
+    {
+        ticks_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void Profiler::Start()
+    {
+        if (mode_ != Mode::kSample || running_)
+            return;
+#if TINYCSHARP_SIGPROF
+        Profiler *none = nullptr;
+        if (!sampling.compare_exchange_strong(none, this))
+            throw std::runtime_error("another profiler is already sampling");
+        ticks_.store(0, std::memory_order_relaxed);
+        struct sigaction action = {};
+        action.sa_handler = Tick;
+        action.sa_flags = SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGPROF, &action, &previous_action);
+        long usec = std::max<long>(static_cast<long>(interval_.count()), 1);
+        struct itimerval timer = {};
+        timer.it_interval.tv_sec = usec / 1000000;
+        timer.it_interval.tv_usec = usec % 1000000;
+        timer.it_value = timer.it_interval;
+        if (setitimer(ITIMER_PROF, &timer, nullptr) != 0)
+        {
+            sigaction(SIGPROF, &previous_action, nullptr);
+            sampling.store(nullptr);
+            throw std::runtime_error("cannot start the profiling timer");
+        }
+        running_ = true;
+#else
+        throw std::runtime_error("sampling is not supported on this platform");
+#endif
+    }
+
+    void Profiler::Stop()
+    {
+        if (!running_)
+            return;
+#if TINYCSHARP_SIGPROF
+        struct itimerval timer = {};
+        setitimer(ITIMER_PROF, &timer, nullptr);
+        sigaction(SIGPROF, &previous_action, nullptr);
+        sampling.store(nullptr);
+#endif
+        running_ = false;
+    }
+
+    Profiler::Counts &Profiler::CountsOf(const BcFunction *fn)
+    {
+        if (fn != last_fn_)
+        {
+            Counts &counts = counts_[fn];
+            if (counts.pcs.size() < fn->code.size())
+                counts.pcs.resize(fn->code.size());
+            last_fn_ = fn;
+            last_counts_ = &counts;
+        }
+        return *last_counts_;
+    }
+
+    void Profiler::Enter(const BcFunction *fn)
+    {
+        std::uint32_t parent = path_.empty() ? 0 : path_.back();
+        auto it = nodes_[parent].children.find(fn);
+        std::uint32_t node;
+        if (it != nodes_[parent].children.end())
+        {
+            node = it->second;
+        }
+        else
+        {
+            node = static_cast<std::uint32_t>(nodes_.size());
+            nodes_[parent].children.emplace(fn, node);
+            nodes_.push_back(Node{fn, parent});
+        }
+        path_.push_back(node);
+        CountsOf(fn).calls++;
+    }
+
+    void Profiler::Count(const BcFunction *fn, const BcInst *pc, std::uint64_t weight)
+    {
+        nodes_[path_.empty() ? 0 : path_.back()].self += weight;
+        CountsOf(fn).pcs[static_cast<std::size_t>(pc - fn->code.data())] += weight;
+        opcodes_[static_cast<std::uint8_t>(pc->op)] += weight;
+        events_ += weight;
+    }
+
+    std::vector<Profiler::Method> Profiler::Methods() const
+    {
+        // a node's events with those of its subtree; children come after
+        // their parents, so one pass from the back adds them up.
+        std::vector<std::uint64_t> subtree(nodes_.size());
+        for (std::size_t i = nodes_.size(); i-- > 1;)
+        {
+            subtree[i] += nodes_[i].self;
+            subtree[nodes_[i].parent] += subtree[i];
+        }
+        std::unordered_map<const BcFunction *, Method> methods;
+        for (std::size_t i = 1; i < nodes_.size(); i++)
+        {
+            const Node &node = nodes_[i];
+            Method &method = methods[node.fn];
+            method.fn = node.fn;
+            method.self += node.self;
+            // a recursive call is already in the total of the outer one.
+            bool outermost = true;
+            for (std::uint32_t up = node.parent; up && outermost; up = nodes_[up].parent)
+                outermost = nodes_[up].fn != node.fn;
+            if (outermost)
+                method.total += subtree[i];
+        }
+        std::vector<Method> result;
+        for (auto &[fn, method] : methods)
+        {
+            auto it = counts_.find(fn);
+            if (it != counts_.end())
+            {
+                method.calls = mode_ == Mode::kExact ? it->second.calls : 0;
+                method.pcs = it->second.pcs;
+            }
+            result.push_back(std::move(method));
+        }
+        std::sort(result.begin(), result.end(), [](const Method &a, const Method &b)
+                  { return a.self != b.self ? a.self > b.self : a.fn->name < b.fn->name; });
+        return result;
+    }
+
+    void Profiler::WriteFolded(std::ostream &out) const
+    {
+        std::vector<std::string> lines;
+        for (std::size_t i = 1; i < nodes_.size(); i++)
+        {
+            if (!nodes_[i].self)
+                continue;
+            std::vector<const BcFunction *> stack;
+            for (std::uint32_t up = static_cast<std::uint32_t>(i); up; up = nodes_[up].parent)
+                stack.push_back(nodes_[up].fn);
+            std::string line;
+            for (auto it = stack.rbegin(); it != stack.rend(); ++it)
+            {
+                if (!line.empty())
+                    line += ';';
+                line += (*it)->name;
+            }
+            lines.push_back(line + " " + std::to_string(nodes_[i].self));
+        }
+        std::sort(lines.begin(), lines.end());
+        for (const std::string &line : lines)
+            out << line << "\n";
+    }
+
+    void Profiler::WriteReport(std::ostream &out, std::size_t methods, std::size_t instructions) const
+    {
+        const bool exact = mode_ == Mode::kExact;
+        out << (exact ? "profile: " : "profile: sampled, ") << events_ << (exact ? " instructions\n" : " ticks\n");
+        out << "  self%        self       total" << (exact ? "       calls" : "") << "  method\n";
+        std::vector<Method> hot = Methods();
+        for (std::size_t m = 0; m < hot.size() && m < methods; m++)
+        {
+            const Method &method = hot[m];
+            out << std::fixed << std::setprecision(1) << std::setw(7) << Percent(method.self, events_) << std::setw(12)
+                << method.self << std::setw(12) << method.total;
+            if (exact)
+                out << std::setw(12) << method.calls;
+            out << "  " << method.fn->name << "\n";
+            std::vector<std::uint32_t> pcs;
+            for (std::uint32_t pc = 0; pc < method.pcs.size(); pc++)
+            {
+                if (method.pcs[pc])
+                    pcs.push_back(pc);
+            }
+            std::sort(pcs.begin(), pcs.end(), [&](std::uint32_t a, std::uint32_t b)
+                      { return method.pcs[a] != method.pcs[b] ? method.pcs[a] > method.pcs[b] : a < b; });
+            for (std::size_t i = 0; i < pcs.size() && i < instructions; i++)
+            {
+                std::uint32_t pc = pcs[i];
+                // instructions the compiler added, such as hoisted
+                // constants, have no line.
+                const std::vector<int> &lines = method.fn->lines;
+                int line = pc < lines.size() ? lines[pc] : 0;
+                out << std::setw(19) << method.pcs[pc] << "    line " << std::setw(4) << (line > 0 ? std::to_string(line) : "-")
+                    << "  pc " << std::setw(4) << pc << "  " << BcOpToString(method.fn->code[pc].op) << "\n";
+            }
+        }
+        std::vector<std::uint32_t> ops;
+        for (std::uint32_t op = 0; op < opcodes_.size(); op++)
+        {
+            if (opcodes_[op])
+                ops.push_back(op);
+        }
+        std::sort(ops.begin(), ops.end(), [&](std::uint32_t a, std::uint32_t b)
+                  { return opcodes_[a] != opcodes_[b] ? opcodes_[a] > opcodes_[b] : a < b; });
+        if (!ops.empty())
+            out << "  opcodes:\n";
+        for (std::size_t i = 0; i < ops.size() && i < methods; i++)
+            out << std::setw(7) << Percent(opcodes_[ops[i]], events_) << std::setw(12) << opcodes_[ops[i]] << "  "
+                << BcOpToString(static_cast<BcOp>(ops[i])) << "\n";
+        out << std::defaultfloat;
+    }
+
+}
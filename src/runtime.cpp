@@ -0,0 +1,815 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include "runtime.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace tinycsharp
+{
+    namespace
+    {
+        std::atomic<std::uint64_t> next_epoch{1};
+
+        inline std::size_t Align(std::size_t size) { return (size + 7) & ~static_cast<std::size_t>(7); }
+
+        // hands visit every reference slot of object.
+        template <typename F>
+        void ForEachReference(Object *object, const BcProgram &program, F &&visit)
+        {
+            switch (object->kind)
+            {
+            case ObjectKind::kInstance:
+                for (std::uint16_t slot : program.classes[object->info].ref_slots)
+                    visit(Payload(object)[slot].ref);
+                break;
+            case ObjectKind::kArray:
+                if (object->type == IrType::kRef)
+                {
+                    for (std::uint32_t i = 0; i < object->info; i++)
+                        visit(Payload(object)[i].ref);
+                }
+                break;
+            case ObjectKind::kTask:
+                visit(TaskOf(object)->result);
+                visit(TaskOf(object)->waiters);
+                break;
+            case ObjectKind::kExternal:
+                visit(External(object)->name);
+                visit(External(object)->message);
+                break;
+            case ObjectKind::kRope:
+                visit(Rope(object)->left);
+                visit(Rope(object)->right);
+                break;
+            case ObjectKind::kStateMachine:
+            {
+                const BcFunction &fn = program.functions[object->info];
+                std::uint32_t refs = fn.await_points[StateMachine(object)->await].refs;
+                visit(StateMachine(object)->task);
+                visit(StateMachine(object)->next);
+                for (std::uint32_t i = 0; i < refs; i++)
+                    visit(SavedRegisters(object)[i].ref);
+                break;
+            }
+            default:
+                break;
+            }
+        }
+    }
+
+    thread_local Heap::TlabCache Heap::tlab_cache_;
+
+    Heap::Heap(const BcProgram &program, std::size_t eden_bytes)
+        : program_(program), id_(next_epoch.fetch_add(1, std::memory_order_relaxed))
+    {
+        eden_bytes = std::max<std::size_t>(Align(eden_bytes), 1024);
+        survivor_bytes_ = Align(eden_bytes / 8);
+        std::size_t young_bytes = eden_bytes + 2 * survivor_bytes_;
+        young_.reset(new char[young_bytes]);
+        young_end_ = young_.get() + young_bytes;
+        eden_top_ = young_.get();
+        eden_end_ = eden_top_ + eden_bytes;
+        survivors_[0] = eden_end_;
+        survivors_[1] = eden_end_ + survivor_bytes_;
+        from_top_ = survivors_[0];
+        tlab_bytes_ = Align(std::clamp<std::size_t>(eden_bytes / 16, 256, 32u << 10));
+        large_object_bytes_ = eden_bytes / 4;
+        initial_old_threshold_ = old_threshold_ = std::max<std::size_t>(eden_bytes * 4, 1u << 20);
+        // room for the threshold plus a nursery promoted whole.
+        std::size_t old_bytes = old_threshold_ + young_bytes;
+        old_.reset(new char[old_bytes]);
+        old_top_ = old_.get();
+        old_end_ = old_top_ + old_bytes;
+        NewEpoch();
+    }
+
+    Heap::~Heap() = default;
+
+    std::size_t Heap::SizeOf(const Object *object, const BcProgram &program)
+    {
+        switch (object->kind)
+        {
+        case ObjectKind::kInstance:
+            return sizeof(Object) + sizeof(Value) * program.classes[object->info].num_slots;
+        case ObjectKind::kArray:
+            return sizeof(Object) + sizeof(Value) * object->info;
+        case ObjectKind::kString:
+            return Align(sizeof(Object) + object->info + 1);
+        case ObjectKind::kBox:
+            return sizeof(Object) + sizeof(Value);
+        case ObjectKind::kTask:
+            return sizeof(Object) + sizeof(TaskPayload);
+        case ObjectKind::kExternal:
+            return sizeof(Object) + sizeof(ExternalPayload);
+        case ObjectKind::kRope:
+            return sizeof(Object) + sizeof(RopePayload);
+        case ObjectKind::kStateMachine:
+            return sizeof(Object) + sizeof(StateMachinePayload) + sizeof(Value) * program.functions[object->info].await_slots;
+        }
+        return sizeof(Object);
+    }
+
+    std::size_t Heap::YoungBytes() const
+    {
+        return static_cast<std::size_t>(eden_top_ - young_.get()) + static_cast<std::size_t>(from_top_ - survivors_[from_]);
+    }
+
+    void Heap::NewEpoch()
+    {
+        epoch_ = next_epoch.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Heap::Tlab &Heap::OwnTlab()
+    {
+        TlabCache &cache = tlab_cache_;
+        if (cache.heap != id_)
+        {
+            std::lock_guard<std::mutex> lock(tlabs_mutex_);
+            cache = TlabCache{id_, &tlabs_[std::this_thread::get_id()]};
+        }
+        return *cache.tlab;
+    }
+
+    // counts what the thread allocated from its buffer so far.
+    void Heap::RetireTlab()
+    {
+        Tlab &tlab = OwnTlab();
+        if (tlab.epoch != epoch_)
+            return;
+        stats_.objects_allocated += tlab.objects;
+        stats_.bytes_allocated += static_cast<std::size_t>(tlab.top - tlab.start);
+        tlab.objects = 0;
+        tlab.start = tlab.top;
+    }
+
+    Object *Heap::Allocate(ObjectKind kind, std::size_t payload_bytes)
+    {
+        std::size_t size = Align(sizeof(Object) + payload_bytes);
+        Tlab &tlab = OwnTlab();
+        char *memory;
+        if (tlab.epoch == epoch_ && static_cast<std::size_t>(tlab.end - tlab.top) >= size)
+        {
+            memory = tlab.top;
+            tlab.top += size;
+            tlab.objects++;
+        }
+        else
+        {
+            memory = AllocateSlow(size);
+        }
+        Object *object = new (memory) Object();
+        object->kind = kind;
+        return object;
+    }
+
+    // a fresh buffer from eden, zeroed here rather than per object. a
+    // full eden is collected first.
+    char *Heap::AllocateSlow(std::size_t size)
+    {
+        if (size > large_object_bytes_)
+            return AllocateOld(size);
+        for (;;)
+        {
+            {
+                std::lock_guard<std::mutex> lock(refill_mutex_);
+                RetireTlab();
+                std::size_t free = static_cast<std::size_t>(eden_end_ - eden_top_);
+                if (free >= size)
+                {
+                    std::size_t chunk = std::min(std::max(tlab_bytes_, size), free);
+                    char *start = eden_top_;
+                    eden_top_ += chunk;
+                    std::memset(start, 0, chunk);
+                    OwnTlab() = Tlab{epoch_, start, start + size, start + chunk, 1};
+                    return start;
+                }
+            }
+            CollectMinor();
+        }
+    }
+
+    char *Heap::AllocateOld(std::size_t size)
+    {
+        if (size > static_cast<std::size_t>(old_end_ - old_top_) || static_cast<std::size_t>(old_top_ - old_.get()) + size > old_threshold_)
+            CollectMajor(size);
+        char *memory = old_top_;
+        old_top_ += size;
+        std::memset(memory, 0, size);
+        stats_.objects_allocated++;
+        stats_.bytes_allocated += size;
+        return memory;
+    }
+
+    Object *Heap::NewInstance(std::uint32_t cls)
+    {
+        Object *object = Allocate(ObjectKind::kInstance, sizeof(Value) * program_.classes[cls].num_slots);
+        object->info = cls;
+        return object;
+    }
+
+    Object *Heap::NewArray(IrType element, std::uint32_t length)
+    {
+        Object *array = Allocate(ObjectKind::kArray, sizeof(Value) * static_cast<std::size_t>(length));
+        array->type = element;
+        array->info = length;
+        return array;
+    }
+
+    Object *Heap::NewString(std::size_t length)
+    {
+        if (length > 0x7fffffffu)
+            throw std::bad_alloc();
+        Object *s = Allocate(ObjectKind::kString, length + 1);
+        s->info = static_cast<std::uint32_t>(length);
+        return s;
+    }
+
+    Object *Heap::NewString(std::string_view text)
+    {
+        Object *s = NewString(text.size());
+        if (!text.empty())
+            std::memcpy(StringData(s), text.data(), text.size());
+        return s;
+    }
+
+    Object *Heap::NewBox(IrType type, Value value)
+    {
+        Object *box = Allocate(ObjectKind::kBox, sizeof(Value));
+        box->type = type;
+        Payload(box)[0] = value;
+        return box;
+    }
+
+    Object *Heap::NewTask(bool completed, Object *result)
+    {
+        handles_.push_back(result);
+        Object *task = Allocate(ObjectKind::kTask, sizeof(TaskPayload));
+        result = handles_.back();
+        handles_.pop_back();
+        task->info = completed ? 1 : 0;
+        TaskOf(task)->result = result;
+        WriteBarrier(task, result);
+        return task;
+    }
+
+    Object *Heap::NewStateMachine(std::uint32_t function)
+    {
+        Object *machine = Allocate(ObjectKind::kStateMachine,
+                                   sizeof(StateMachinePayload) + sizeof(Value) * program_.functions[function].await_slots);
+        machine->info = function;
+        return machine;
+    }
+
+    Object *Heap::NewExternal()
+    {
+        return Allocate(ObjectKind::kExternal, sizeof(ExternalPayload));
+    }
+
+    Object *Heap::NewRope(Object *left, Object *right)
+    {
+        std::size_t length = static_cast<std::size_t>(left->info) + right->info;
+        if (length > 0x7fffffffu)
+            throw std::bad_alloc();
+        handles_.push_back(left);
+        handles_.push_back(right);
+        Object *rope = Allocate(ObjectKind::kRope, sizeof(RopePayload));
+        right = handles_.back();
+        handles_.pop_back();
+        left = handles_.back();
+        handles_.pop_back();
+        rope->info = static_cast<std::uint32_t>(length);
+        Rope(rope)->left = left;
+        Rope(rope)->right = right;
+        WriteBarrier(rope, left);
+        WriteBarrier(rope, right);
+        return rope;
+    }
+
+    void Heap::Remember(Object *object)
+    {
+        object->gc_bits |= kRemembered;
+        remembered_.push_back(object);
+    }
+
+    void Heap::VisitRoots(const RootVisitor &visit)
+    {
+        if (roots_)
+            roots_(visit);
+        for (Object *&handle : handles_)
+            visit(handle);
+    }
+
+    const HeapStats &Heap::stats()
+    {
+        RetireTlab();
+        stats_.live_bytes = static_cast<std::size_t>(old_top_ - old_.get()) + YoungBytes();
+        return stats_;
+    }
+
+    // copies a young object to the survivor space, or promotes it once it
+    // is old enough or the survivor space is full. the original keeps the
+    // new address for the other references to it.
+    Object *Heap::Evacuate(Object *object)
+    {
+        char *to = survivors_[from_ ^ 1];
+        char *p = reinterpret_cast<char *>(object);
+        if (p >= to && p < to + survivor_bytes_)
+            return object;
+        if (object->gc_bits & kForwarded)
+            return object->forward;
+        std::size_t size = SizeOf(object, program_);
+        unsigned age = (object->gc_bits >> kAgeShift) + 1;
+        char *dest;
+        if (age < kTenureAge && static_cast<std::size_t>(to + survivor_bytes_ - to_top_) >= size)
+        {
+            dest = to_top_;
+            to_top_ += size;
+        }
+        else
+        {
+            dest = old_top_;
+            old_top_ += size;
+            stats_.bytes_promoted += size;
+            age = 0;
+        }
+        std::memcpy(dest, object, size);
+        Object *copy = reinterpret_cast<Object *>(dest);
+        copy->gc_bits = static_cast<std::uint8_t>(age << kAgeShift);
+        copy->forward = nullptr;
+        object->gc_bits |= kForwarded;
+        object->forward = copy;
+        return copy;
+    }
+
+    // Cheney's algorithm over the nursery: the roots and the remembered
+    // old objects are the starting points, and the copies themselves are
+    // the queue, in the survivor space and in the promoted part of the old
+    // generation.
+    void Heap::CollectMinor()
+    {
+        RetireTlab();
+        std::size_t young = YoungBytes();
+        if (static_cast<std::size_t>(old_end_ - old_top_) < young)
+        {
+            // promotion could overflow the old generation.
+            CollectMajor(0);
+            return;
+        }
+        stats_.collections++;
+        stats_.minor_collections++;
+        char *to = survivors_[from_ ^ 1];
+        to_top_ = to;
+        char *promoted = old_top_;
+        std::uint64_t promoted_before = stats_.bytes_promoted;
+
+        auto evacuate = [this](Object *&ref)
+        {
+            if (ref && IsYoung(ref))
+                ref = Evacuate(ref);
+        };
+        // an old object stays remembered while it still refers to the
+        // nursery.
+        auto scan_old = [&](Object *object)
+        {
+            bool young_refs = false;
+            ForEachReference(object, program_, [&](Object *&ref)
+                             {
+                                 evacuate(ref);
+                                 young_refs = young_refs || (ref && IsYoung(ref)); });
+            if (young_refs)
+                Remember(object);
+        };
+        VisitRoots(evacuate);
+        std::vector<Object *> remembered;
+        remembered.swap(remembered_);
+        for (Object *object : remembered)
+        {
+            object->gc_bits &= static_cast<std::uint8_t>(~kRemembered);
+            scan_old(object);
+        }
+        char *scan_to = to;
+        char *scan_promoted = promoted;
+        while (scan_to < to_top_ || scan_promoted < old_top_)
+        {
+            while (scan_to < to_top_)
+            {
+                Object *object = reinterpret_cast<Object *>(scan_to);
+                scan_to += SizeOf(object, program_);
+                ForEachReference(object, program_, evacuate);
+            }
+            while (scan_promoted < old_top_)
+            {
+                Object *object = reinterpret_cast<Object *>(scan_promoted);
+                scan_promoted += SizeOf(object, program_);
+                scan_old(object);
+            }
+        }
+
+        std::size_t survived = static_cast<std::size_t>(to_top_ - to) + (stats_.bytes_promoted - promoted_before);
+        stats_.bytes_freed += young - survived;
+        from_ ^= 1;
+        from_top_ = to_top_;
+        eden_top_ = young_.get();
+        NewEpoch();
+        if (static_cast<std::size_t>(old_top_ - old_.get()) > old_threshold_)
+            CollectMajor(0);
+    }
+
+    // mark-compact (LISP2) of the whole heap: mark from the roots, give
+    // every live object its address in the compacted old generation, with
+    // the live young objects after the old ones, rewrite every reference,
+    // then slide. the old generation moves to a bigger region when the live
+    // data plus extra bytes about to be allocated need it.
+    void Heap::CollectMajor(std::size_t extra)
+    {
+        RetireTlab();
+        stats_.collections++;
+        stats_.major_collections++;
+        std::size_t before = static_cast<std::size_t>(old_top_ - old_.get()) + YoungBytes();
+
+        std::size_t live = 0;
+        auto mark = [this](Object *&ref)
+        {
+            if (ref && !(ref->gc_bits & (kMarked | kImmortal)))
+            {
+                ref->gc_bits |= kMarked;
+                mark_stack_.push_back(ref);
+            }
+        };
+        VisitRoots(mark);
+        while (!mark_stack_.empty())
+        {
+            Object *object = mark_stack_.back();
+            mark_stack_.pop_back();
+            live += SizeOf(object, program_);
+            if (IsYoung(object))
+                young_live_.push_back(object);
+            ForEachReference(object, program_, mark);
+        }
+
+        std::size_t threshold = std::max(initial_old_threshold_, 2 * (live + extra));
+        std::size_t capacity = threshold + static_cast<std::size_t>(young_end_ - young_.get());
+        std::unique_ptr<char[]> grown;
+        if (capacity > static_cast<std::size_t>(old_end_ - old_.get()))
+            grown.reset(new char[capacity]);
+        char *dest = grown ? grown.get() : old_.get();
+        for (char *p = old_.get(); p < old_top_;)
+        {
+            Object *object = reinterpret_cast<Object *>(p);
+            std::size_t size = SizeOf(object, program_);
+            if (object->gc_bits & kMarked)
+            {
+                object->forward = reinterpret_cast<Object *>(dest);
+                dest += size;
+            }
+            p += size;
+        }
+        std::size_t young_live_bytes = 0;
+        for (Object *object : young_live_)
+        {
+            std::size_t size = SizeOf(object, program_);
+            object->forward = reinterpret_cast<Object *>(dest);
+            dest += size;
+            young_live_bytes += size;
+        }
+
+        auto update = [](Object *&ref)
+        {
+            if (ref && !(ref->gc_bits & kImmortal))
+                ref = ref->forward;
+        };
+        VisitRoots(update);
+        for (char *p = old_.get(); p < old_top_;)
+        {
+            Object *object = reinterpret_cast<Object *>(p);
+            p += SizeOf(object, program_);
+            if (object->gc_bits & kMarked)
+                ForEachReference(object, program_, update);
+        }
+        for (Object *object : young_live_)
+            ForEachReference(object, program_, update);
+
+        // objects only move down within the old generation, so each one's
+        // header is read before anything is written over it.
+        for (char *p = old_.get(); p < old_top_;)
+        {
+            Object *object = reinterpret_cast<Object *>(p);
+            std::size_t size = SizeOf(object, program_);
+            p += size;
+            if (object->gc_bits & kMarked)
+            {
+                Object *copy = object->forward;
+                std::memmove(copy, object, size);
+                copy->gc_bits = 0;
+                copy->forward = nullptr;
+            }
+        }
+        for (Object *object : young_live_)
+        {
+            Object *copy = object->forward;
+            std::memcpy(copy, object, SizeOf(object, program_));
+            copy->gc_bits = 0;
+            copy->forward = nullptr;
+        }
+        if (grown)
+        {
+            old_ = std::move(grown);
+            old_end_ = old_.get() + capacity;
+        }
+        old_top_ = dest;
+        old_threshold_ = threshold;
+        eden_top_ = young_.get();
+        from_top_ = survivors_[from_];
+        remembered_.clear();
+        young_live_.clear();
+        stats_.bytes_promoted += young_live_bytes;
+        stats_.bytes_freed += before - live;
+        NewEpoch();
+    }
+
+    StringImage::StringImage(const std::vector<std::string> &literals) : num_literals_(literals.size())
+    {
+        auto size_of = [](std::size_t length)
+        { return Align(sizeof(Object) + length + 1); };
+        for (const auto &text : literals)
+            bytes_ += size_of(text.size());
+        bytes_ += size_of(0) + 256 * size_of(1);
+        memory_.reset(new std::uint64_t[bytes_ / sizeof(std::uint64_t)]());
+        char *at = reinterpret_cast<char *>(memory_.get());
+        auto add = [&](std::string_view text)
+        {
+            Object *s = new (at) Object();
+            s->kind = ObjectKind::kString;
+            s->gc_bits = Heap::kImmortal;
+            s->info = static_cast<std::uint32_t>(text.size());
+            if (!text.empty())
+                std::memcpy(StringData(s), text.data(), text.size());
+            objects_.push_back(s);
+            at += size_of(text.size());
+        };
+        for (const auto &text : literals)
+            add(text);
+        add(std::string_view());
+        for (int c = 0; c < 256; c++)
+        {
+            char byte = static_cast<char>(c);
+            add(std::string_view(&byte, 1));
+        }
+    }
+
+    // ropes are walked with an explicit stack: "s += x" in a loop builds
+    // one as deep as the loop is long.
+    void CopyText(const Object *s, char *dest)
+    {
+        std::vector<const Object *> pending{s};
+        while (!pending.empty())
+        {
+            const Object *piece = pending.back();
+            pending.pop_back();
+            while (!IsFlat(piece))
+            {
+                pending.push_back(Rope(piece)->right);
+                piece = Rope(piece)->left;
+            }
+            std::string_view text = StringView(piece);
+            if (!text.empty())
+                std::memcpy(dest, text.data(), text.size());
+            dest += text.size();
+        }
+    }
+
+    std::string StringText(const Object *s)
+    {
+        if (IsFlat(s))
+            return std::string(StringView(s));
+        std::string text(s->info, '\0');
+        CopyText(s, text.data());
+        return text;
+    }
+
+    namespace
+    {
+        // C# prints the shortest digits that round trip, switching to
+        // exponent notation outside [1e-4, 10^sci_limit).
+        std::string FormatShortest(double value, int max_precision, int sci_limit, bool is_float)
+        {
+            if (std::isnan(value))
+                return "NaN";
+            if (std::isinf(value))
+                return value < 0 ? "-\xe2\x88\x9e" : "\xe2\x88\x9e";
+            if (value == 0)
+                return std::signbit(value) ? "-0" : "0";
+
+            char buf[64];
+            for (int precision = 1; precision <= max_precision; precision++)
+            {
+                std::snprintf(buf, sizeof buf, "%.*e", precision - 1, value);
+                double back = std::strtod(buf, nullptr);
+                if (is_float ? static_cast<float>(back) == static_cast<float>(value) : back == value)
+                    break;
+            }
+            // buf is [-]d[.ddd]e[+-]xx
+            std::string text = buf;
+            bool negative = text[0] == '-';
+            std::size_t e_pos = text.find('e');
+            int exponent = std::atoi(text.c_str() + e_pos + 1);
+            std::string digits;
+            for (std::size_t i = negative ? 1 : 0; i < e_pos; i++)
+            {
+                if (text[i] != '.')
+                    digits += text[i];
+            }
+            while (digits.size() > 1 && digits.back() == '0')
+                digits.pop_back();
+
+            std::string out = negative ? "-" : "";
+            if (exponent >= sci_limit || exponent < -4)
+            {
+                out += digits[0];
+                if (digits.size() > 1)
+                    out += "." + digits.substr(1);
+                char exp[16];
+                std::snprintf(exp, sizeof exp, "E%c%02d", exponent < 0 ? '-' : '+', std::abs(exponent));
+                return out + exp;
+            }
+            if (exponent < 0)
+            {
+                return out + "0." + std::string(static_cast<std::size_t>(-exponent - 1), '0') + digits;
+            }
+            std::size_t int_digits = static_cast<std::size_t>(exponent) + 1;
+            if (digits.size() <= int_digits)
+                return out + digits + std::string(int_digits - digits.size(), '0');
+            return out + digits.substr(0, int_digits) + "." + digits.substr(int_digits);
+        }
+    }
+
+    const char *ClrTypeName(IrType type)
+    {
+        switch (type)
+        {
+        case IrType::kBool:
+            return "System.Boolean";
+        case IrType::kChar:
+            return "System.Char";
+        case IrType::kI32:
+            return "System.Int32";
+        case IrType::kI64:
+            return "System.Int64";
+        case IrType::kF32:
+            return "System.Single";
+        case IrType::kF64:
+            return "System.Double";
+        default:
+            return "System.Object";
+        }
+    }
+
+    Value ConvertPrimitive(Value v, IrType from, IrType to)
+    {
+        Value r = IntValue(0);
+        if (from == to)
+            return v;
+        if (IsFloatIrType(from))
+        {
+            double d = from == IrType::kF32 ? static_cast<double>(v.f) : v.d;
+            switch (to)
+            {
+            case IrType::kF32:
+                r.f = static_cast<float>(d);
+                break;
+            case IrType::kF64:
+                r.d = d;
+                break;
+            case IrType::kI64:
+                r.i = Saturate<std::int64_t>(d);
+                break;
+            case IrType::kI32:
+                r.i = Saturate<std::int32_t>(d);
+                break;
+            case IrType::kChar:
+                r.i = Saturate<std::uint16_t>(d);
+                break;
+            default:
+                r.i = d != 0;
+                break;
+            }
+            return r;
+        }
+        switch (to)
+        {
+        case IrType::kF32:
+            r.f = static_cast<float>(v.i);
+            break;
+        case IrType::kF64:
+            r.d = static_cast<double>(v.i);
+            break;
+        case IrType::kI32:
+            r.i = static_cast<std::int32_t>(static_cast<std::uint32_t>(v.i));
+            break;
+        case IrType::kChar:
+            r.i = v.i & 0xffff;
+            break;
+        case IrType::kBool:
+            r.i = v.i != 0;
+            break;
+        default:
+            r.i = v.i;
+            break;
+        }
+        return r;
+    }
+
+    std::string FormatDouble(double value)
+    {
+        return FormatShortest(value, 17, 15, false);
+    }
+
+    std::string FormatFloat(float value)
+    {
+        return FormatShortest(value, 9, 7, true);
+    }
+
+    std::string FormatValue(Value value, IrType type)
+    {
+        switch (type)
+        {
+        case IrType::kBool:
+            return value.i ? "True" : "False";
+        case IrType::kChar:
+            return std::string(1, static_cast<char>(value.i));
+        case IrType::kI32:
+        case IrType::kI64:
+            return std::to_string(value.i);
+        case IrType::kF32:
+            return FormatFloat(value.f);
+        case IrType::kF64:
+            return FormatDouble(value.d);
+        default:
+            return "";
+        }
+    }
+
+    std::string FormatObject(const Object *object, const BcProgram &program)
+    {
+        if (!object)
+            return "";
+        switch (object->kind)
+        {
+        case ObjectKind::kString:
+        case ObjectKind::kRope:
+            return StringText(object);
+        case ObjectKind::kBox:
+            return FormatValue(Payload(object)[0], object->type);
+        default:
+            return ObjectTypeName(object, program);
+        }
+    }
+
+    std::string ObjectTypeName(const Object *object, const BcProgram &program)
+    {
+        switch (object->kind)
+        {
+        case ObjectKind::kInstance:
+            return program.classes[object->info].name;
+        case ObjectKind::kArray:
+            return std::string(ClrTypeName(object->type)) + "[]";
+        case ObjectKind::kString:
+        case ObjectKind::kRope:
+            return "System.String";
+        case ObjectKind::kBox:
+            return ClrTypeName(object->type);
+        case ObjectKind::kTask:
+            return "System.Threading.Tasks.Task";
+        case ObjectKind::kStateMachine:
+            return program.functions[object->info].name + "+<StateMachine>";
+        case ObjectKind::kExternal:
+        {
+            const Object *name = reinterpret_cast<const ExternalPayload *>(object + 1)->name;
+            return name ? std::string(StringView(name)) : "System.Object";
+        }
+        }
+        return "";
+    }
+
+}
@@ -0,0 +1,191 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include "scheduler.h"
+#include <algorithm>
+
+namespace tinycsharp
+{
+    namespace
+    {
+        // the scheduler and run queue of the worker running on this thread.
+        thread_local const TaskScheduler *current_scheduler = nullptr;
+        thread_local unsigned current_worker = 0;
+    }
+
+    TaskScheduler::TaskScheduler(unsigned workers)
+    {
+        if (workers == 0)
+        {
+            workers = std::max(1u, std::thread::hardware_concurrency());
+        }
+        for (unsigned i = 0; i < workers; i++)
+        {
+            queues_.push_back(std::make_unique<RunQueue>());
+        }
+        workers_.reserve(workers);
+        for (unsigned i = 0; i < workers; i++)
+        {
+            workers_.emplace_back([this, i]
+                                  { WorkerLoop(i); });
+        }
+        timer_thread_ = std::thread([this]
+                                    { TimerLoop(); });
+    }
+
+    TaskScheduler::~TaskScheduler()
+    {
+        Stop();
+    }
+
+    void TaskScheduler::Submit(Job job)
+    {
+        outstanding_++;
+        Push(std::move(job));
+    }
+
+    void TaskScheduler::SubmitAfter(std::chrono::milliseconds delay, Job job)
+    {
+        outstanding_++;
+        {
+            std::lock_guard<std::mutex> lock(timer_mu_);
+            timers_.push(Timer{Clock::now() + delay, next_sequence_++, std::move(job)});
+        }
+        timer_cv_.notify_one();
+    }
+
+    void TaskScheduler::Push(Job job)
+    {
+        unsigned q = current_scheduler == this ? current_worker : next_queue_++ % Size();
+        {
+            std::lock_guard<std::mutex> lock(queues_[q]->mu);
+            queues_[q]->jobs.push_back(std::move(job));
+        }
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            queued_++;
+        }
+        work_cv_.notify_one();
+    }
+
+    bool TaskScheduler::RunOne(unsigned worker)
+    {
+        Job job;
+        {
+            RunQueue &own = *queues_[worker];
+            std::lock_guard<std::mutex> lock(own.mu);
+            if (!own.jobs.empty())
+            {
+                job = std::move(own.jobs.back());
+                own.jobs.pop_back();
+            }
+        }
+        for (unsigned i = 1; !job && i < Size(); i++)
+        {
+            RunQueue &victim = *queues_[(worker + i) % Size()];
+            std::lock_guard<std::mutex> lock(victim.mu);
+            if (!victim.jobs.empty())
+            {
+                job = std::move(victim.jobs.front());
+                victim.jobs.pop_front();
+                steals_++;
+            }
+        }
+        if (!job)
+        {
+            return false;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            queued_--;
+        }
+        job();
+        outstanding_--;
+        return true;
+    }
+
+    void TaskScheduler::WorkerLoop(unsigned worker)
+    {
+        current_scheduler = this;
+        current_worker = worker;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mu_);
+                work_cv_.wait(lock, [this]
+                              { return stopping_ || queued_ > 0; });
+                if (stopping_)
+                {
+                    return;
+                }
+            }
+            RunOne(worker);
+        }
+    }
+
+    void TaskScheduler::TimerLoop()
+    {
+        std::unique_lock<std::mutex> lock(timer_mu_);
+        while (!stopping_)
+        {
+            if (timers_.empty())
+            {
+                timer_cv_.wait(lock);
+                continue;
+            }
+            Clock::time_point due = timers_.top().due;
+            if (Clock::now() < due)
+            {
+                timer_cv_.wait_until(lock, due);
+                continue;
+            }
+            Job job = std::move(const_cast<Timer &>(timers_.top()).job);
+            timers_.pop();
+            lock.unlock();
+            Push(std::move(job));
+            lock.lock();
+        }
+    }
+
+    void TaskScheduler::Stop()
+    {
+        {
+            std::scoped_lock lock(mu_, timer_mu_);
+            if (stopping_)
+            {
+                return;
+            }
+            stopping_ = true;
+        }
+        work_cv_.notify_all();
+        timer_cv_.notify_all();
+        for (auto &t : workers_)
+        {
+            t.join();
+        }
+        timer_thread_.join();
+        for (auto &queue : queues_)
+        {
+            queue->jobs.clear();
+        }
+        timers_ = {};
+        queued_ = 0;
+        outstanding_ = 0;
+    }
+
+}
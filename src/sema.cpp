@@ -0,0 +1,1258 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include "sema.h"
+#include "const_eval.h"
+#include "metadata.h"
+#include "thread_pool.h"
+#include "visitor.h"
+#include <algorithm>
+#include <cstring>
+
+namespace tinycsharp
+{
+    namespace
+    {
+        std::string_view LastSegment(std::string_view name)
+        {
+            std::size_t dot = name.rfind('.');
+            return dot == std::string_view::npos ? name : name.substr(dot + 1);
+        }
+
+        bool IsTaskName(std::string_view name)
+        {
+            return name == "Task" || name == "System.Threading.Tasks.Task" || name == "Tasks.Task";
+        }
+
+        std::string_view FileOf(const ClassInfo *cls)
+        {
+            return cls && cls->decl && cls->decl->unit ? cls->decl->unit->file : std::string_view();
+        }
+
+        // where node, in a file of cls, is.
+        SourcePosition PositionOf(const ClassInfo *cls, const Node *node)
+        {
+            return cls && cls->decl && cls->decl->unit ? cls->decl->unit->Locate(node) : SourcePosition{};
+        }
+
+        // clears what an earlier analysis wrote into a tree. a tree kept
+        // across analyses (by the daemon or the language server) may point
+        // into the tree of a file since re-parsed, and some of it is only
+        // overwritten when resolution succeeds.
+        struct AnnotationReset : RecursiveAstVisitor<AnnotationReset>
+        {
+            static void Reset(Expr *expr)
+            {
+                expr->type = nullptr;
+                expr->constant = nullptr;
+            }
+
+            void VisitClassDecl(ClassDecl *n)
+            {
+                n->info = nullptr;
+                WalkClassDecl(n);
+            }
+            void VisitFieldDecl(FieldDecl *n)
+            {
+                n->info = nullptr;
+                WalkFieldDecl(n);
+            }
+            void VisitMethodDecl(MethodDecl *n)
+            {
+                n->info = nullptr;
+                WalkMethodDecl(n);
+            }
+            void VisitParamDecl(ParamDecl *n)
+            {
+                n->resolved_type = nullptr;
+                WalkParamDecl(n);
+            }
+            void VisitLocalVarStmt(LocalVarStmt *n)
+            {
+                n->resolved_type = nullptr;
+                WalkLocalVarStmt(n);
+            }
+            void VisitNameExpr(NameExpr *n)
+            {
+                Reset(n);
+                n->decl = nullptr;
+            }
+            void VisitMemberExpr(MemberExpr *n)
+            {
+                Reset(n);
+                n->field = nullptr;
+                n->builtin = 0;
+                WalkMemberExpr(n);
+            }
+            void VisitCallExpr(CallExpr *n)
+            {
+                Reset(n);
+                n->target = nullptr;
+                n->builtin = 0;
+                WalkCallExpr(n);
+            }
+            void VisitNewExpr(NewExpr *n)
+            {
+                Reset(n);
+                n->ctor = nullptr;
+                WalkNewExpr(n);
+            }
+#define TINYCSHARP_RESET_EXPR(Name) \
+    void Visit##Name(Name *n)         \
+    {                                 \
+        Reset(n);                     \
+        Walk##Name(n);                \
+    }
+            TINYCSHARP_RESET_EXPR(LiteralExpr)
+            TINYCSHARP_RESET_EXPR(IndexExpr)
+            TINYCSHARP_RESET_EXPR(UnaryExpr)
+            TINYCSHARP_RESET_EXPR(BinaryExpr)
+            TINYCSHARP_RESET_EXPR(AssignExpr)
+            TINYCSHARP_RESET_EXPR(ConditionalExpr)
+            TINYCSHARP_RESET_EXPR(CastExpr)
+            TINYCSHARP_RESET_EXPR(ThisExpr)
+            TINYCSHARP_RESET_EXPR(AwaitExpr)
+#undef TINYCSHARP_RESET_EXPR
+        };
+    }
+
+    const char *BuiltinToString(Builtin builtin)
+    {
+        switch (builtin)
+        {
+        case Builtin::kNone:
+            return "none";
+        case Builtin::kConsoleWriteLine:
+            return "Console.WriteLine";
+        case Builtin::kConsoleWrite:
+            return "Console.Write";
+        case Builtin::kMathAbs:
+            return "Math.Abs";
+        case Builtin::kMathMax:
+            return "Math.Max";
+        case Builtin::kMathMin:
+            return "Math.Min";
+        case Builtin::kMathSqrt:
+            return "Math.Sqrt";
+        case Builtin::kTaskFromResult:
+            return "Task.FromResult";
+        case Builtin::kTaskYield:
+            return "Task.Yield";
+        case Builtin::kTaskDelay:
+            return "Task.Delay";
+        case Builtin::kTaskCompleted:
+            return "Task.CompletedTask";
+        case Builtin::kStringLength:
+            return "string.Length";
+        case Builtin::kArrayLength:
+            return "Array.Length";
+        case Builtin::kIntMaxValue:
+            return "int.MaxValue";
+        case Builtin::kIntMinValue:
+            return "int.MinValue";
+        case Builtin::kLongMaxValue:
+            return "long.MaxValue";
+        case Builtin::kLongMinValue:
+            return "long.MinValue";
+        }
+        return "unknown";
+    }
+
+    std::string MethodSignature(const MethodInfo *method)
+    {
+        std::string out = method->owner->qualified_name + "." + std::string(method->decl->name) + "(";
+        for (std::size_t i = 0; i < method->param_types.size(); i++)
+        {
+            if (i)
+            {
+                out += ", ";
+            }
+            out += TypeToString(method->param_types[i]);
+        }
+        return out + ")";
+    }
+
+    ClassInfo *ImportScope::Find(SymbolId name) const
+    {
+        for (const ImportScope *s = this; s; s = s->parent)
+        {
+            auto it = s->classes.find(name);
+            if (it != s->classes.end())
+            {
+                return it->second;
+            }
+        }
+        return nullptr;
+    }
+
+    bool ImportScope::AllowsExternalTypes() const
+    {
+        for (const ImportScope *s = this; s; s = s->parent)
+        {
+            if (s->has_external_usings)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    FieldInfo *ClassInfo::FindField(SymbolId name) const
+    {
+        for (const ClassInfo *c = this; c; c = c->base)
+        {
+            auto it = c->field_map.find(name);
+            if (it != c->field_map.end())
+            {
+                return it->second;
+            }
+        }
+        return nullptr;
+    }
+
+    void ClassInfo::FindMethods(SymbolId name, std::vector<MethodInfo *> &out) const
+    {
+        for (const ClassInfo *c = this; c; c = c->base)
+        {
+            auto it = c->method_map.find(name);
+            if (it == c->method_map.end())
+            {
+                continue;
+            }
+            for (MethodInfo *m : it->second)
+            {
+                // an override stands in for the method it replaces.
+                bool hidden = false;
+                for (MethodInfo *seen : out)
+                {
+                    if (seen->vtable_slot >= 0 && seen->vtable_slot == m->vtable_slot)
+                    {
+                        hidden = true;
+                        break;
+                    }
+                }
+                if (!hidden)
+                {
+                    out.push_back(m);
+                }
+            }
+        }
+    }
+
+    bool ClassInfo::IsSubclassOf(const ClassInfo *other) const
+    {
+        for (const ClassInfo *c = this; c; c = c->base)
+        {
+            if (c == other)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    GlobalSymbols::GlobalSymbols(Interner &interner, TypeTable &types)
+        : interner_(interner), types_(types), reference_constants_(std::make_unique<ConstantPool>(types))
+    {
+    }
+
+    GlobalSymbols::~GlobalSymbols() = default;
+
+    ClassInfo *GlobalSymbols::FindClass(std::string_view qualified_name) const
+    {
+        auto it = by_qualified_name_.find(std::string(qualified_name));
+        if (it != by_qualified_name_.end())
+        {
+            return it->second;
+        }
+        if (references_.empty())
+        {
+            return nullptr;
+        }
+        // bodies are checked in parallel, and any of them may be the first
+        // to name a referenced class.
+        std::lock_guard<std::mutex> lock(reference_mu_);
+        return FindReferenced(std::string(qualified_name));
+    }
+
+    bool GlobalSymbols::IsNamespace(std::string_view name) const
+    {
+        return namespaces_.count(std::string(name)) != 0 || IsReferencedNamespace(name);
+    }
+
+    bool GlobalSymbols::IsReferencedNamespace(std::string_view name) const
+    {
+        for (const MetadataModule *module : references_)
+        {
+            if (module->HasNamespace(name))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<ClassInfo *> GlobalSymbols::ReferencedClasses() const
+    {
+        std::lock_guard<std::mutex> lock(reference_mu_);
+        return referenced_order_;
+    }
+
+    ClassInfo *GlobalSymbols::FindReferenced(const std::string &qualified_name) const
+    {
+        auto it = referenced_.find(qualified_name);
+        if (it != referenced_.end())
+        {
+            return it->second;
+        }
+        const MetadataModule *module = nullptr;
+        const MetadataType *record = nullptr;
+        for (const MetadataModule *m : references_)
+        {
+            if ((record = m->FindType(qualified_name)))
+            {
+                module = m;
+                break;
+            }
+        }
+        ClassInfo *&found = referenced_[qualified_name];
+        if (!record)
+        {
+            return nullptr;
+        }
+
+        // the class stands on declarations made up from the record, so the
+        // checker sees it as it would a class of the program without bodies.
+        if (!reference_ast_)
+        {
+            reference_ast_ = std::make_unique<AstContext>(interner_);
+        }
+        AstContext &ast = *reference_ast_;
+        auto *unit = ast.Make<CompilationUnit>(SourceLocation{});
+        unit->file = ast.CopyString(module->path());
+        auto type_ref = [&](std::string_view spelling)
+        {
+            auto *ref = ast.Make<TypeRef>(SourceLocation{});
+            ref->name = ast.CopyString(spelling);
+            return ref;
+        };
+
+        reference_classes_.emplace_back();
+        ClassInfo *cls = &reference_classes_.back();
+        found = cls;
+        referenced_order_.push_back(cls);
+        auto *decl = ast.Make<ClassDecl>(SourceLocation{});
+        decl->name = ast.Intern(LastSegment(record->name));
+        decl->name_id = ast.Symbol(decl->name);
+        decl->modifiers = kModPublic | (record->flags & MetadataType::kSealed ? kModSealed : 0) |
+                          (record->flags & MetadataType::kAbstract ? kModAbstract : 0) |
+                          (record->flags & MetadataType::kStatic ? kModStatic : 0);
+        decl->is_struct = record->flags & MetadataType::kStruct;
+        decl->unit = unit;
+        decl->info = cls;
+        cls->decl = decl;
+        cls->qualified_name = qualified_name;
+        cls->reference = module;
+        cls->id = UINT32_MAX;
+        cls->is_sealed = record->flags & (MetadataType::kSealed | MetadataType::kStruct);
+        cls->is_abstract = record->flags & MetadataType::kAbstract;
+        cls->is_static = record->flags & MetadataType::kStatic;
+        cls->type = types_.ClassType(cls);
+        if (!record->base.empty())
+        {
+            cls->base = FindReferenced(std::string(record->base));
+        }
+        if (cls->base)
+        {
+            cls->vtable = cls->base->vtable;
+        }
+        cls->instance_slots = record->instance_slots;
+
+        std::vector<Node *> members;
+        for (const MetadataMember &member : record->members)
+        {
+            if (member.kind == MetadataMember::kField)
+            {
+                auto *field_decl = ast.Make<FieldDecl>(SourceLocation{});
+                field_decl->name = ast.Intern(member.name);
+                field_decl->name_id = ast.Symbol(member.name);
+                field_decl->modifiers = kModPublic | (member.flags & MetadataMember::kStatic ? kModStatic : 0) |
+                                        (member.flags & MetadataMember::kConst ? kModConst : 0) |
+                                        (member.flags & MetadataMember::kReadonly ? kModReadonly : 0);
+                field_decl->owner = decl;
+                field_decl->type = type_ref(member.type);
+                reference_fields_.emplace_back();
+                FieldInfo *field = &reference_fields_.back();
+                field->decl = field_decl;
+                field->owner = cls;
+                field->type = ReferencedType(member.type);
+                field->is_static = member.flags & MetadataMember::kStatic;
+                field->is_const = member.flags & MetadataMember::kConst;
+                field->is_readonly = member.flags & MetadataMember::kReadonly;
+                field->slot = member.slot;
+                field_decl->info = field;
+                if (field->is_const)
+                {
+                    switch (field->type->kind)
+                    {
+                    case TypeKind::kString:
+                        field->constant = reference_constants_->String(module->String(static_cast<std::uint32_t>(member.value)));
+                        break;
+                    case TypeKind::kFloat:
+                    case TypeKind::kDouble:
+                    {
+                        double value;
+                        std::memcpy(&value, &member.value, sizeof value);
+                        field->constant = reference_constants_->Floating(field->type, value);
+                        break;
+                    }
+                    default:
+                        field->constant = reference_constants_->Integral(field->type, static_cast<std::int64_t>(member.value));
+                        break;
+                    }
+                }
+                cls->fields.push_back(field);
+                cls->field_map.emplace(field_decl->name_id, field);
+                members.push_back(field_decl);
+                continue;
+            }
+
+            auto *method_decl = ast.Make<MethodDecl>(SourceLocation{});
+            method_decl->name = member.kind == MetadataMember::kCtor ? decl->name : ast.Intern(member.name);
+            method_decl->name_id = ast.Symbol(method_decl->name);
+            method_decl->modifiers = kModPublic | (member.flags & MetadataMember::kStatic ? kModStatic : 0) |
+                                     (member.flags & MetadataMember::kVirtual ? kModVirtual : 0) |
+                                     (member.flags & MetadataMember::kAbstract ? kModAbstract : 0) |
+                                     (member.flags & MetadataMember::kOverride ? kModOverride : 0) |
+                                     (member.flags & MetadataMember::kAsync ? kModAsync : 0);
+            method_decl->is_ctor = member.kind == MetadataMember::kCtor;
+            method_decl->owner = decl;
+            reference_methods_.emplace_back();
+            MethodInfo *method = &reference_methods_.back();
+            method->decl = method_decl;
+            method->owner = cls;
+            method->is_ctor = method_decl->is_ctor;
+            method->is_static = member.flags & MetadataMember::kStatic;
+            method->is_abstract = member.flags & MetadataMember::kAbstract;
+            method->is_virtual = member.flags & (MetadataMember::kVirtual | MetadataMember::kAbstract | MetadataMember::kOverride);
+            method->is_async = member.flags & MetadataMember::kAsync;
+            method->id = UINT32_MAX;
+            if (!method->is_ctor)
+            {
+                method_decl->return_type = type_ref(member.type);
+            }
+            method->return_type = method->is_ctor ? types_.Void() : ReferencedType(member.type);
+            std::vector<ParamDecl *> params;
+            for (const auto &[name, type] : member.params)
+            {
+                auto *param = ast.Make<ParamDecl>(SourceLocation{});
+                param->name = ast.Intern(name);
+                param->name_id = ast.Symbol(name);
+                param->type = type_ref(type);
+                param->index = static_cast<std::uint32_t>(params.size());
+                param->resolved_type = ReferencedType(type);
+                method->param_types.push_back(param->resolved_type);
+                params.push_back(param);
+            }
+            method_decl->params = ast.MakeList(params);
+            method_decl->info = method;
+            members.push_back(method_decl);
+            if (method->is_ctor)
+            {
+                cls->ctors.push_back(method);
+                continue;
+            }
+            cls->methods.push_back(method);
+            cls->method_map[method_decl->name_id].push_back(method);
+            if (!method->is_virtual)
+            {
+                continue;
+            }
+            for (MethodInfo *candidate : cls->vtable)
+            {
+                if ((member.flags & MetadataMember::kOverride) && candidate->decl->name_id == method_decl->name_id &&
+                    candidate->param_types == method->param_types)
+                {
+                    method->overridden = candidate;
+                    method->vtable_slot = candidate->vtable_slot;
+                    cls->vtable[method->vtable_slot] = method;
+                    break;
+                }
+            }
+            if (method->vtable_slot < 0)
+            {
+                method->vtable_slot = static_cast<int>(cls->vtable.size());
+                cls->vtable.push_back(method);
+            }
+        }
+        decl->members = ast.MakeList(members);
+        return cls;
+    }
+
+    const Type *GlobalSymbols::ReferencedType(std::string_view spelling) const
+    {
+        if (spelling.size() > 2 && spelling.substr(spelling.size() - 2) == "[]")
+        {
+            return types_.ArrayOf(ReferencedType(spelling.substr(0, spelling.size() - 2)));
+        }
+        if (spelling == "Task")
+        {
+            return types_.TaskOf(types_.Void());
+        }
+        if (spelling.rfind("Task<", 0) == 0 && spelling.back() == '>')
+        {
+            return types_.TaskOf(ReferencedType(spelling.substr(5, spelling.size() - 6)));
+        }
+        if (const Type *builtin = types_.Builtin(spelling))
+        {
+            return builtin;
+        }
+        if (ClassInfo *cls = FindReferenced(std::string(spelling)))
+        {
+            return cls->type;
+        }
+        return types_.External(spelling);
+    }
+
+    ClassInfo *GlobalSymbols::LookupClass(std::string_view name, const ClassInfo *context, const ImportScope *imports) const
+    {
+        std::size_t dot = name.find('.');
+        SymbolId first = interner_.Find(name.substr(0, dot));
+        ClassInfo *found = nullptr;
+        if (first != kNoSymbol)
+        {
+            for (const ClassInfo *c = context; c && !found; c = c->outer)
+            {
+                if (c->decl && c->decl->name_id == first)
+                {
+                    found = const_cast<ClassInfo *>(c);
+                    break;
+                }
+                auto it = c->nested.find(first);
+                if (it != c->nested.end())
+                {
+                    found = it->second;
+                }
+            }
+            if (!found && imports)
+            {
+                found = imports->Find(first);
+            }
+        }
+        while (found && dot != std::string_view::npos)
+        {
+            std::size_t next = name.find('.', dot + 1);
+            SymbolId part = interner_.Find(name.substr(dot + 1, next == std::string_view::npos ? next : next - dot - 1));
+            auto it = found->nested.find(part);
+            found = it == found->nested.end() ? nullptr : it->second;
+            dot = next;
+        }
+        if (found)
+        {
+            return found;
+        }
+        if (ClassInfo *cls = FindClass(name))
+        {
+            return cls;
+        }
+        for (const ImportScope *s = references_.empty() ? nullptr : imports; s; s = s->parent)
+        {
+            for (const std::string &ns : s->referenced_namespaces)
+            {
+                if (ClassInfo *cls = FindClass(ns + "." + std::string(name)))
+                {
+                    return cls;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    const Type *GlobalSymbols::ResolveType(const TypeRef *ref, const ClassInfo *context, std::vector<Diagnostic> *diags) const
+    {
+        const ImportScope *imports = context ? context->imports : nullptr;
+        const Type *type = nullptr;
+        std::string_view name = ref->name;
+        if (ClassInfo *cls = LookupClass(name, context, imports))
+        {
+            type = cls->type;
+        }
+        else if (IsTaskName(name))
+        {
+            if (ref->args.size() > 1)
+            {
+                if (diags)
+                {
+                    SourcePosition at = PositionOf(context, ref);
+                    diags->push_back(Diagnostic{Severity::kError, std::string(FileOf(context)), at.line, at.column,
+                                                "Using the generic type 'Task<TResult>' requires 1 type arguments"});
+                }
+                return types_.Error();
+            }
+            type = ref->args.empty() ? types_.TaskOf(types_.Void()) : types_.TaskOf(ResolveType(ref->args[0], context, diags));
+        }
+        else if (const Type *builtin = types_.Builtin(name.rfind("System.", 0) == 0 ? LastSegment(name) : name))
+        {
+            type = builtin;
+        }
+        else if (imports && imports->AllowsExternalTypes())
+        {
+            type = types_.External(name);
+        }
+        else
+        {
+            if (diags)
+            {
+                SourcePosition at = PositionOf(context, ref);
+                diags->push_back(Diagnostic{Severity::kError, std::string(FileOf(context)), at.line, at.column,
+                                            "The type or namespace name '" + std::string(name) + "' could not be found"});
+            }
+            return types_.Error();
+        }
+        for (int i = 0; i < ref->array_rank; i++)
+        {
+            type = types_.ArrayOf(type);
+        }
+        return type;
+    }
+
+    DeclarationPass::DeclarationPass(GlobalSymbols &globals, std::vector<Diagnostic> &diagnostics)
+        : globals_(globals), diagnostics_(diagnostics)
+    {
+    }
+
+    void DeclarationPass::Run(const std::vector<CompilationUnit *> &units)
+    {
+        for (CompilationUnit *unit : units)
+        {
+            for (Node *member : unit->members)
+            {
+                CollectClasses(member, "", nullptr);
+            }
+        }
+
+        globals_.scope_storage_.emplace_back();
+        root_ = &globals_.scope_storage_.back();
+        AddNamespaceClasses(*root_, "");
+        for (CompilationUnit *unit : units)
+        {
+            BuildScopes(unit, unit->members, unit->usings, root_, unit);
+        }
+        for (ClassInfo *cls : globals_.classes_)
+        {
+            const Node *owner = cls->decl->ns ? static_cast<const Node *>(cls->decl->ns) : cls->decl->unit;
+            auto it = scopes_.find(owner);
+            cls->imports = it != scopes_.end() ? it->second : root_;
+        }
+
+        for (ClassInfo *cls : globals_.classes_)
+        {
+            ResolveBase(cls);
+        }
+        for (ClassInfo *cls : globals_.classes_)
+        {
+            Layout(cls);
+        }
+        for (ClassInfo *cls : globals_.classes_)
+        {
+            if (cls->is_abstract)
+            {
+                continue;
+            }
+            for (MethodInfo *m : cls->vtable)
+            {
+                if (m->is_abstract)
+                {
+                    Error(cls->decl, cls, "'" + cls->qualified_name + "' does not implement inherited abstract member '" +
+                                              MethodSignature(m) + "'");
+                }
+            }
+        }
+    }
+
+    void DeclarationPass::CollectClasses(Node *member, std::string_view ns, ClassInfo *outer)
+    {
+        if (auto *inner = NodeCast<NamespaceDecl>(member))
+        {
+            std::string_view name = inner->name;
+            for (std::size_t dot = name.find('.'); dot != std::string_view::npos; dot = name.find('.', dot + 1))
+            {
+                globals_.namespaces_.insert(std::string(name.substr(0, dot)));
+            }
+            globals_.namespaces_.insert(std::string(name));
+            for (Node *m : inner->members)
+            {
+                CollectClasses(m, inner->name, nullptr);
+            }
+            return;
+        }
+        auto *decl = NodeCast<ClassDecl>(member);
+        if (!decl)
+        {
+            return;
+        }
+
+        globals_.class_storage_.emplace_back();
+        ClassInfo *cls = &globals_.class_storage_.back();
+        cls->decl = decl;
+        cls->outer = outer;
+        cls->id = static_cast<std::uint32_t>(globals_.classes_.size());
+        cls->is_sealed = (decl->modifiers & kModSealed) || decl->is_struct;
+        cls->is_abstract = decl->modifiers & kModAbstract;
+        cls->is_static = decl->modifiers & kModStatic;
+        if (outer)
+        {
+            cls->qualified_name = outer->qualified_name + "." + std::string(decl->name);
+        }
+        else
+        {
+            cls->qualified_name = ns.empty() ? std::string(decl->name) : std::string(ns) + "." + std::string(decl->name);
+        }
+        cls->type = globals_.types_.ClassType(cls);
+        decl->info = cls;
+        globals_.classes_.push_back(cls);
+
+        if (!globals_.by_qualified_name_.emplace(cls->qualified_name, cls).second)
+        {
+            if (outer)
+            {
+                Error(decl, cls, "The type '" + outer->qualified_name + "' already contains a definition for '" +
+                                     std::string(decl->name) + "'");
+            }
+            else
+            {
+                Error(decl, cls, "The namespace '" + (ns.empty() ? std::string("<global namespace>") : std::string(ns)) +
+                                     "' already contains a definition for '" + std::string(decl->name) + "'");
+            }
+        }
+        else if (outer)
+        {
+            outer->nested.emplace(decl->name_id, cls);
+        }
+        else
+        {
+            namespace_classes_[std::string(ns)].push_back(cls);
+        }
+
+        for (Node *m : decl->members)
+        {
+            CollectClasses(m, ns, cls);
+        }
+    }
+
+    void DeclarationPass::AddNamespaceClasses(ImportScope &scope, std::string_view ns)
+    {
+        auto it = namespace_classes_.find(std::string(ns));
+        if (it == namespace_classes_.end())
+        {
+            return;
+        }
+        for (ClassInfo *cls : it->second)
+        {
+            scope.classes.emplace(cls->decl->name_id, cls);
+        }
+    }
+
+    void DeclarationPass::BuildScopes(const CompilationUnit *unit, const NodeList<Node> &members,
+                                      const NodeList<UsingDirective> &usings, const ImportScope *parent, const Node *owner)
+    {
+        globals_.scope_storage_.emplace_back();
+        ImportScope &scope = globals_.scope_storage_.back();
+        scope.parent = parent;
+        if (owner->kind == NodeKind::kNamespaceDecl)
+        {
+            // namespace A.B sees the classes of A as well as those of A.B;
+            // the classes of A.B win, so they go in first.
+            auto *ns = static_cast<const NamespaceDecl *>(owner);
+            std::string_view name = ns->name;
+            AddNamespaceClasses(scope, name);
+            std::size_t skip = ns->outer ? ns->outer->name.size() + 1 : 0;
+            std::vector<std::string_view> prefixes;
+            for (std::size_t dot = name.find('.', skip); dot != std::string_view::npos; dot = name.find('.', dot + 1))
+            {
+                prefixes.push_back(name.substr(0, dot));
+            }
+            for (auto it = prefixes.rbegin(); it != prefixes.rend(); ++it)
+            {
+                AddNamespaceClasses(scope, *it);
+            }
+            prefixes.insert(prefixes.begin(), name);
+            for (std::string_view prefix : prefixes)
+            {
+                if (globals_.IsReferencedNamespace(prefix))
+                {
+                    scope.referenced_namespaces.emplace_back(prefix);
+                }
+            }
+        }
+        for (UsingDirective *u : usings)
+        {
+            if (globals_.IsReferencedNamespace(u->name))
+            {
+                scope.referenced_namespaces.emplace_back(u->name);
+            }
+            if (globals_.IsNamespace(u->name))
+            {
+                AddNamespaceClasses(scope, u->name);
+            }
+            else if (u->name == "System" || u->name.rfind("System.", 0) == 0)
+            {
+                scope.has_external_usings = globals_.library_usings_;
+            }
+            else
+            {
+                Error(u, unit, "The type or namespace name '" + std::string(u->name) +
+                                   "' could not be found (are you missing an assembly reference?)");
+            }
+        }
+        scopes_[owner] = &scope;
+        for (Node *member : members)
+        {
+            if (auto *inner = NodeCast<NamespaceDecl>(member))
+            {
+                BuildScopes(unit, inner->members, inner->usings, &scope, inner);
+            }
+        }
+    }
+
+    void DeclarationPass::ResolveBase(ClassInfo *cls)
+    {
+        for (std::size_t i = 0; i < cls->decl->bases.size(); i++)
+        {
+            TypeRef *ref = cls->decl->bases[i];
+            ClassInfo *base = globals_.LookupClass(ref->name, cls->outer, cls->imports);
+            if (!base)
+            {
+                // interfaces and library base types are not modelled.
+                if (!cls->imports->AllowsExternalTypes())
+                {
+                    Error(ref, cls, "The type or namespace name '" + std::string(ref->name) + "' could not be found");
+                }
+                continue;
+            }
+            if (i > 0)
+            {
+                Error(ref, cls, "Class '" + cls->qualified_name + "' cannot have multiple base classes: '" +
+                                    (cls->base ? cls->base->qualified_name : std::string()) + "' and '" +
+                                    base->qualified_name + "'");
+                continue;
+            }
+            if (cls->decl->is_struct)
+            {
+                Error(ref, cls, "Type '" + base->qualified_name + "' in interface list is not an interface");
+                continue;
+            }
+            if (base->is_sealed || base->is_static)
+            {
+                Error(ref, cls, "'" + cls->qualified_name + "': cannot derive from " +
+                                    (base->is_static ? "static class '" : "sealed type '") + base->qualified_name + "'");
+                continue;
+            }
+            cls->base = base;
+        }
+    }
+
+    void DeclarationPass::Layout(ClassInfo *cls)
+    {
+        if (cls->reference)
+        {
+            return; // laid out when it was loaded
+        }
+        int &state = layout_state_[cls];
+        if (state == 2)
+        {
+            return;
+        }
+        if (state == 1)
+        {
+            return;
+        }
+        state = 1;
+        if (cls->base)
+        {
+            if (layout_state_[cls->base] == 1)
+            {
+                Error(cls->decl, cls, "Circular base type dependency involving '" + cls->qualified_name + "' and '" +
+                                          cls->base->qualified_name + "'");
+                cls->base = nullptr;
+            }
+            else
+            {
+                Layout(cls->base);
+                cls->instance_slots = cls->base->instance_slots;
+                cls->vtable = cls->base->vtable;
+            }
+        }
+
+        for (Node *member : cls->decl->members)
+        {
+            if (auto *field = NodeCast<FieldDecl>(member))
+            {
+                DeclareField(cls, field);
+            }
+        }
+        for (Node *member : cls->decl->members)
+        {
+            if (auto *method = NodeCast<MethodDecl>(member))
+            {
+                DeclareMethod(cls, method);
+            }
+        }
+        layout_state_[cls] = 2;
+    }
+
+    void DeclarationPass::DeclareField(ClassInfo *cls, FieldDecl *decl)
+    {
+        globals_.field_storage_.emplace_back();
+        FieldInfo *field = &globals_.field_storage_.back();
+        field->decl = decl;
+        field->owner = cls;
+        field->type = globals_.ResolveType(decl->type, cls, &diagnostics_);
+        field->is_static = decl->modifiers & kModStatic;
+        field->is_const = decl->modifiers & kModConst;
+        field->is_readonly = decl->modifiers & kModReadonly;
+        decl->info = field;
+        if (field->type->kind == TypeKind::kVoid)
+        {
+            Error(decl->type, cls, "Keyword 'void' cannot be used in this context");
+        }
+        if (field->is_const && !decl->init)
+        {
+            Error(decl, cls, "A const field requires a value to be provided");
+        }
+
+        if (!cls->field_map.emplace(decl->name_id, field).second || cls->nested.count(decl->name_id))
+        {
+            Error(decl, cls, "The type '" + cls->qualified_name + "' already contains a definition for '" +
+                                 std::string(decl->name) + "'");
+        }
+        cls->fields.push_back(field);
+        if (field->is_const)
+        {
+            return;
+        }
+        if (field->is_static)
+        {
+            field->slot = static_slots_++;
+            globals_.static_fields_.push_back(field);
+        }
+        else
+        {
+            field->slot = cls->instance_slots++;
+        }
+    }
+
+    void DeclarationPass::DeclareMethod(ClassInfo *cls, MethodDecl *decl)
+    {
+        globals_.method_storage_.emplace_back();
+        MethodInfo *method = &globals_.method_storage_.back();
+        method->decl = decl;
+        method->owner = cls;
+        method->is_ctor = decl->is_ctor;
+        method->is_static = decl->modifiers & kModStatic;
+        method->is_abstract = decl->modifiers & kModAbstract;
+        method->is_virtual = decl->modifiers & (kModVirtual | kModAbstract | kModOverride);
+        method->is_async = decl->modifiers & kModAsync;
+        method->return_type = decl->return_type ? globals_.ResolveType(decl->return_type, cls, &diagnostics_)
+                                                : globals_.types_.Void();
+        for (ParamDecl *param : decl->params)
+        {
+            const Type *type = globals_.ResolveType(param->type, cls, &diagnostics_);
+            if (type->kind == TypeKind::kVoid)
+            {
+                Error(param->type, cls, "Keyword 'void' cannot be used in this context");
+                type = globals_.types_.Error();
+            }
+            param->resolved_type = type;
+            method->param_types.push_back(type);
+        }
+        method->id = static_cast<std::uint32_t>(globals_.methods_.size());
+        decl->info = method;
+        globals_.methods_.push_back(method);
+
+        std::string signature = MethodSignature(method);
+        if (decl->is_ctor)
+        {
+            if (decl->name_id != cls->decl->name_id)
+            {
+                Error(decl, cls, "Method must have a return type");
+            }
+            cls->ctors.push_back(method);
+            return;
+        }
+
+        if (method->is_async && method->return_type->kind != TypeKind::kVoid &&
+            method->return_type->kind != TypeKind::kTask && method->return_type->kind != TypeKind::kExternal &&
+            method->return_type->kind != TypeKind::kError)
+        {
+            Error(decl->return_type, cls, "The return type of an async method must be void, Task or Task<T>");
+        }
+        if (method->is_abstract)
+        {
+            if (decl->body)
+            {
+                Error(decl, cls, "'" + signature + "' cannot declare a body because it is marked abstract");
+            }
+            if (!cls->is_abstract)
+            {
+                Error(decl, cls, "'" + signature + "' is abstract but it is contained in non-abstract type '" +
+                                     cls->qualified_name + "'");
+            }
+        }
+        else if (!decl->body)
+        {
+            Error(decl, cls, "'" + signature + "' must declare a body because it is not marked abstract");
+        }
+        if (method->is_static && method->is_virtual)
+        {
+            Error(decl, cls, "A static member cannot be marked as 'virtual', 'abstract' or 'override'");
+            method->is_virtual = false;
+        }
+
+        auto &overloads = cls->method_map[decl->name_id];
+        for (MethodInfo *other : overloads)
+        {
+            if (other->param_types == method->param_types)
+            {
+                Error(decl, cls, "Type '" + cls->qualified_name + "' already defines a member called '" +
+                                     std::string(decl->name) + "' with the same parameter types");
+                break;
+            }
+        }
+        if (cls->field_map.count(decl->name_id))
+        {
+            Error(decl, cls, "The type '" + cls->qualified_name + "' already contains a definition for '" +
+                                 std::string(decl->name) + "'");
+        }
+        overloads.push_back(method);
+        cls->methods.push_back(method);
+
+        if (decl->modifiers & kModOverride)
+        {
+            MethodInfo *base = nullptr;
+            for (MethodInfo *candidate : cls->vtable)
+            {
+                if (candidate->decl->name_id == decl->name_id && candidate->param_types == method->param_types)
+                {
+                    base = candidate;
+                    break;
+                }
+            }
+            if (!base)
+            {
+                Error(decl, cls, "'" + signature + "': no suitable method found to override");
+                method->is_virtual = false;
+                return;
+            }
+            if (base->return_type != method->return_type)
+            {
+                Error(decl, cls, "'" + signature + "': return type must be '" + TypeToString(base->return_type) +
+                                     "' to match overridden member '" + MethodSignature(base) + "'");
+            }
+            method->overridden = base;
+            method->vtable_slot = base->vtable_slot;
+            cls->vtable[method->vtable_slot] = method;
+        }
+        else if (method->is_virtual)
+        {
+            if (cls->is_sealed && !method->is_abstract)
+            {
+                Error(decl, cls, "'" + signature + "' is a new virtual member in sealed type '" + cls->qualified_name + "'");
+            }
+            method->vtable_slot = static_cast<int>(cls->vtable.size());
+            cls->vtable.push_back(method);
+        }
+    }
+
+    void DeclarationPass::Error(const Node *node, const ClassInfo *cls, const std::string &message)
+    {
+        SourcePosition at = PositionOf(cls, node);
+        diagnostics_.push_back(Diagnostic{Severity::kError, std::string(FileOf(cls)), at.line, at.column, message});
+    }
+    void DeclarationPass::Error(const Node *node, const CompilationUnit *unit, const std::string &message)
+    {
+        SourcePosition at = unit->Locate(node);
+        diagnostics_.push_back(Diagnostic{Severity::kError, std::string(unit->file), at.line, at.column, message});
+    }
+
+    Sema::Sema(Interner &interner) : interner_(interner), constants_(std::make_unique<ConstantPool>(types_))
+    {
+    }
+
+    Sema::~Sema() = default;
+
+    bool Sema::Analyze(const std::vector<CompilationUnit *> &units, ThreadPool *pool)
+    {
+        Declare(units);
+        std::vector<std::size_t> all(bodies_.size());
+        for (std::size_t i = 0; i < all.size(); i++)
+        {
+            all[i] = i;
+        }
+        CheckBodies(all, pool);
+        return Finish(pool);
+    }
+
+    bool Sema::Declare(const std::vector<CompilationUnit *> &units)
+    {
+        globals_ = std::make_unique<GlobalSymbols>(interner_, types_);
+        for (const MetadataModule *module : references_)
+        {
+            globals_->AddReference(module);
+        }
+        globals_->SetLibraryUsings(library_usings_);
+        diagnostics_.clear();
+        bodies_.clear();
+        files_.clear();
+        AnnotationReset reset;
+        for (CompilationUnit *unit : units)
+            reset.Visit(unit);
+        DeclarationPass(*globals_, diagnostics_).Run(units);
+
+        for (ClassInfo *cls : globals_->classes())
+        {
+            std::string_view file = FileOf(cls);
+            for (Node *member : cls->decl->members)
+            {
+                auto *field = NodeCast<FieldDecl>(member);
+                auto *method = NodeCast<MethodDecl>(member);
+                if ((field && field->init) || (method && method->body))
+                {
+                    bodies_.push_back(BodyTask{member, cls, file});
+                }
+            }
+        }
+        checked_.assign(bodies_.size(), {});
+        done_.assign(bodies_.size(), 0);
+        for (CompilationUnit *unit : units)
+        {
+            files_.push_back(unit->file);
+        }
+        return !HasErrors(diagnostics_);
+    }
+
+    bool Sema::CheckFiles(const std::vector<std::string_view> &files, ThreadPool *pool)
+    {
+        std::vector<std::size_t> indices;
+        for (std::size_t i = 0; i < bodies_.size(); i++)
+        {
+            if (std::find(files.begin(), files.end(), bodies_[i].file) != files.end())
+            {
+                indices.push_back(i);
+            }
+        }
+        return CheckBodies(indices, pool);
+    }
+
+    bool Sema::CheckBodies(const std::vector<std::size_t> &indices, ThreadPool *pool)
+    {
+        auto run = [&](std::size_t i)
+        {
+            CheckBody(*globals_, bodies_[indices[i]], checked_[indices[i]]);
+            done_[indices[i]] = 1;
+        };
+        if (pool && indices.size() > 1)
+        {
+            pool->ParallelFor(indices.size(), run);
+        }
+        else
+        {
+            for (std::size_t i = 0; i < indices.size(); i++)
+            {
+                run(i);
+            }
+        }
+        for (std::size_t i : indices)
+        {
+            if (HasErrors(checked_[i]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool Sema::Finish(ThreadPool *pool)
+    {
+        for (auto &buffer : checked_)
+        {
+            diagnostics_.insert(diagnostics_.end(), std::make_move_iterator(buffer.begin()),
+                                std::make_move_iterator(buffer.end()));
+        }
+        checked_.clear();
+        // a driver may finish with some files left unchecked; only checked
+        // bodies can be folded.
+        bool complete = std::all_of(done_.begin(), done_.end(), [](std::uint8_t done)
+                                    { return done != 0; });
+        if (complete)
+        {
+            ConstantFolder(*globals_, *constants_, diagnostics_).FoldConstFields();
+        }
+        ForEachBody(pool, [&](const BodyTask &body, std::vector<Diagnostic> &out)
+                    {
+                        if (done_[&body - bodies_.data()])
+                            ConstantFolder(*globals_, *constants_, out).FoldBody(body); });
+
+        // source order: by file in the order given, then position.
+        std::unordered_map<std::string_view, std::size_t> file_order;
+        for (std::string_view file : files_)
+        {
+            file_order.emplace(file, file_order.size());
+        }
+        auto order = [&](const Diagnostic &d)
+        {
+            auto it = file_order.find(d.file);
+            return it == file_order.end() ? file_order.size() : it->second;
+        };
+        std::stable_sort(diagnostics_.begin(), diagnostics_.end(), [&](const Diagnostic &a, const Diagnostic &b)
+                         {
+                             std::size_t fa = order(a), fb = order(b);
+                             if (fa != fb)
+                                 return fa < fb;
+                             if (a.line != b.line)
+                                 return a.line < b.line;
+                             return a.column < b.column; });
+        return !HasErrors(diagnostics_);
+    }
+
+    void Sema::ForEachBody(ThreadPool *pool, const std::function<void(const BodyTask &, std::vector<Diagnostic> &)> &fn)
+    {
+        // every body writes to its own buffer; nothing is shared between
+        // tasks but the read-only global view and the locked type table.
+        std::vector<std::vector<Diagnostic>> buffers(bodies_.size());
+        auto run = [&](std::size_t i)
+        { fn(bodies_[i], buffers[i]); };
+        if (pool && bodies_.size() > 1)
+        {
+            pool->ParallelFor(bodies_.size(), run);
+        }
+        else
+        {
+            for (std::size_t i = 0; i < bodies_.size(); i++)
+            {
+                run(i);
+            }
+        }
+        for (auto &buffer : buffers)
+        {
+            diagnostics_.insert(diagnostics_.end(), std::make_move_iterator(buffer.begin()),
+                                std::make_move_iterator(buffer.end()));
+        }
+    }
+
+}
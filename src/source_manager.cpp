@@ -0,0 +1,164 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include "source_manager.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace tinycsharp
+{
+    FileId SourceManager::AddFile(std::string name, std::string text)
+    {
+        if (text.size() >= UINT32_MAX)
+            throw std::length_error("source file too large: " + name);
+        std::uint32_t size = static_cast<std::uint32_t>(text.size());
+        return Add(std::move(name), std::move(text), size, {});
+    }
+
+    FileId SourceManager::AddFile(std::string name, std::uint32_t size, std::vector<std::uint32_t> line_starts)
+    {
+        if (line_starts.empty() || line_starts.front() != 0 || !std::is_sorted(line_starts.begin(), line_starts.end()) ||
+            line_starts.back() > size)
+            throw std::invalid_argument("bad line table for " + name);
+        return Add(std::move(name), std::string(), size, std::move(line_starts));
+    }
+
+    FileId SourceManager::Add(std::string name, std::string text, std::uint32_t size, std::vector<std::uint32_t> line_starts)
+    {
+        std::unique_lock lock(mu_);
+        if (next_ + size + 1 > UINT32_MAX)
+            throw std::length_error("source address space exhausted loading " + name);
+        File &file = files_.emplace_back();
+        file.name = std::move(name);
+        file.text = std::move(text);
+        file.begin = static_cast<std::uint32_t>(next_);
+        file.size = size;
+        if (!line_starts.empty())
+        {
+            // already known: mark the table built.
+            file.line_starts = std::move(line_starts);
+            std::call_once(file.lines_once, [] {});
+        }
+        begins_.push_back(file.begin);
+        next_ += std::uint64_t{size} + 1;
+        return static_cast<FileId>(files_.size() - 1);
+    }
+
+    void SourceManager::Release(FileId id)
+    {
+        std::unique_lock lock(mu_);
+        if (id >= files_.size())
+            throw std::out_of_range("no such source file");
+        File &file = files_[id];
+        std::call_once(file.lines_once, [] {});
+        std::string().swap(file.text);
+        std::vector<std::uint32_t>{0}.swap(file.line_starts);
+    }
+
+    const SourceManager::File &SourceManager::FileAt(FileId id) const
+    {
+        std::shared_lock lock(mu_);
+        if (id >= files_.size())
+            throw std::out_of_range("no such source file");
+        // elements of a deque stay where they are as it grows.
+        return files_[id];
+    }
+
+    SourceLocation SourceManager::Begin(FileId id) const
+    {
+        return SourceLocation{FileAt(id).begin};
+    }
+
+    std::uint32_t SourceManager::Size(FileId id) const
+    {
+        return FileAt(id).size;
+    }
+
+    std::string_view SourceManager::Name(FileId id) const
+    {
+        return FileAt(id).name;
+    }
+
+    std::string_view SourceManager::Text(FileId id) const
+    {
+        return FileAt(id).text;
+    }
+
+    const std::vector<std::uint32_t> &SourceManager::LineStarts(FileId id) const
+    {
+        return LinesOf(FileAt(id));
+    }
+
+    const std::vector<std::uint32_t> &SourceManager::LinesOf(const File &file)
+    {
+        std::call_once(file.lines_once, [&file]
+                       {
+                           file.line_starts.push_back(0);
+                           for (std::uint32_t i = 0; i < file.size; i++)
+                           {
+                               if (file.text[i] == '\n')
+                                   file.line_starts.push_back(i + 1);
+                           } });
+        return file.line_starts;
+    }
+
+    FileId SourceManager::FileOf(SourceLocation loc) const
+    {
+        std::shared_lock lock(mu_);
+        return FileOfLocked(loc);
+    }
+
+    FileId SourceManager::FileOfLocked(SourceLocation loc) const
+    {
+        if (!loc.valid())
+            return kNoFile;
+        auto it = std::upper_bound(begins_.begin(), begins_.end(), loc.offset);
+        if (it == begins_.begin())
+            return kNoFile;
+        FileId id = static_cast<FileId>(it - begins_.begin() - 1);
+        return loc.offset - files_[id].begin <= files_[id].size ? id : kNoFile;
+    }
+
+    SourcePosition SourceManager::Decode(SourceLocation loc) const
+    {
+        // held through the line lookup: Release() swaps the table out.
+        std::shared_lock lock(mu_);
+        FileId id = FileOfLocked(loc);
+        if (id == kNoFile)
+            return SourcePosition{};
+        const File &file = files_[id];
+        const std::vector<std::uint32_t> &lines = LinesOf(file);
+        std::uint32_t offset = loc.offset - file.begin;
+        auto it = std::upper_bound(lines.begin(), lines.end(), offset);
+        int line = static_cast<int>(it - lines.begin());
+        return SourcePosition{file.name, line, static_cast<int>(offset - lines[line - 1]) + 1};
+    }
+
+    std::size_t SourceManager::FileCount() const
+    {
+        std::shared_lock lock(mu_);
+        return files_.size();
+    }
+
+    std::uint64_t SourceManager::AddressSpaceUsed() const
+    {
+        std::shared_lock lock(mu_);
+        return next_ - 1;
+    }
+
+}
@@ -0,0 +1,156 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+
+#include "symbol_table.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace tinycsharp
+{
+    namespace
+    {
+        std::size_t HashSymbol(SymbolId id)
+        {
+            // ids are dense, so spread them before masking.
+            return static_cast<std::size_t>(id * 0x9E3779B1u);
+        }
+    }
+
+    const char *SymbolKindToString(SymbolKind kind)
+    {
+        switch (kind)
+        {
+        case SymbolKind::kNamespace:
+            return "namespace";
+        case SymbolKind::kClass:
+            return "class";
+        case SymbolKind::kField:
+            return "field";
+        case SymbolKind::kMethod:
+            return "method";
+        case SymbolKind::kParam:
+            return "parameter";
+        case SymbolKind::kLocal:
+            return "local";
+        default:
+            return "unknown";
+        }
+    }
+
+    ScopedSymbolTable::ScopedSymbolTable() : slots_(64)
+    {
+    }
+
+    std::size_t ScopedSymbolTable::FindSlot(SymbolId name) const
+    {
+        std::size_t mask = slots_.size() - 1;
+        std::size_t i = HashSymbol(name) & mask;
+        while (slots_[i].name != kNoSymbol && slots_[i].name != name)
+        {
+            i = (i + 1) & mask;
+        }
+        return i;
+    }
+
+    void ScopedSymbolTable::PushScope()
+    {
+        scope_starts_.push_back(static_cast<std::uint32_t>(entries_.size()));
+    }
+
+    void ScopedSymbolTable::PopScope()
+    {
+        if (scope_starts_.empty())
+        {
+            throw std::logic_error("PopScope() without a matching PushScope()");
+        }
+        std::uint32_t start = scope_starts_.back();
+        scope_starts_.pop_back();
+        for (std::size_t i = entries_.size(); i > start; i--)
+        {
+            const SymbolEntry &e = entries_[i - 1];
+            // the slot stays claimed by the name so the next binding of it is
+            // a single probe again.
+            slots_[FindSlot(e.name)].entry = e.shadowed;
+        }
+        entries_.resize(start);
+    }
+
+    bool ScopedSymbolTable::Declare(SymbolId name, SymbolKind kind, Node *decl)
+    {
+        if (scope_starts_.empty())
+        {
+            throw std::logic_error("Declare() outside of any scope");
+        }
+        std::size_t slot = FindSlot(name);
+        std::uint32_t current = slots_[slot].entry;
+        if (current != kNoEntry && current >= scope_starts_.back())
+        {
+            return false;
+        }
+        entries_.push_back(SymbolEntry{name, kind, decl, current});
+        slots_[slot].entry = static_cast<std::uint32_t>(entries_.size() - 1);
+        if (slots_[slot].name == kNoSymbol)
+        {
+            slots_[slot].name = name;
+            if (++used_slots_ * 2 > slots_.size())
+            {
+                Grow();
+            }
+        }
+        return true;
+    }
+
+    const SymbolEntry *ScopedSymbolTable::Lookup(SymbolId name) const
+    {
+        const Slot &slot = slots_[FindSlot(name)];
+        return slot.entry == kNoEntry ? nullptr : &entries_[slot.entry];
+    }
+
+    const SymbolEntry *ScopedSymbolTable::LookupInCurrentScope(SymbolId name) const
+    {
+        const SymbolEntry *e = Lookup(name);
+        if (!e || scope_starts_.empty() || static_cast<std::uint32_t>(e - entries_.data()) < scope_starts_.back())
+        {
+            return nullptr;
+        }
+        return e;
+    }
+
+    std::size_t ScopedSymbolTable::ScopeOf(const SymbolEntry *e) const
+    {
+        std::uint32_t index = static_cast<std::uint32_t>(e - entries_.data());
+        auto it = std::upper_bound(scope_starts_.begin(), scope_starts_.end(), index);
+        return static_cast<std::size_t>(it - scope_starts_.begin());
+    }
+
+    void ScopedSymbolTable::Grow()
+    {
+        std::vector<Slot> old;
+        old.swap(slots_);
+        slots_.assign(old.size() * 2, Slot{});
+        for (const Slot &s : old)
+        {
+            if (s.name != kNoSymbol)
+            {
+                slots_[FindSlot(s.name)] = s;
+            }
+        }
+    }
+
+}
@@ -0,0 +1,158 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+namespace tinycsharp
+{
+
+    ThreadPool::ThreadPool(unsigned threads)
+    {
+        if (threads == 0)
+        {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        workers_.reserve(threads);
+        for (unsigned i = 0; i < threads; i++)
+        {
+            workers_.emplace_back([this]
+                                  { WorkerLoop(); });
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            stopping_ = true;
+        }
+        work_cv_.notify_all();
+        for (auto &t : workers_)
+        {
+            t.join();
+        }
+    }
+
+    void ThreadPool::Submit(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            queue_.push_back(std::move(task));
+        }
+        work_cv_.notify_one();
+    }
+
+    void ThreadPool::Wait()
+    {
+        std::unique_lock<std::mutex> lock(mu_);
+        idle_cv_.wait(lock, [this]
+                      { return queue_.empty() && active_ == 0; });
+    }
+
+    void ThreadPool::WorkerLoop()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mu_);
+                work_cv_.wait(lock, [this]
+                              { return stopping_ || !queue_.empty(); });
+                if (queue_.empty())
+                {
+                    return;
+                }
+                task = std::move(queue_.front());
+                queue_.pop_front();
+                active_++;
+            }
+            task();
+            {
+                std::lock_guard<std::mutex> lock(mu_);
+                active_--;
+                if (queue_.empty() && active_ == 0)
+                {
+                    idle_cv_.notify_all();
+                }
+            }
+        }
+    }
+
+    void ThreadPool::ParallelFor(std::size_t n, const std::function<void(std::size_t)> &fn)
+    {
+        if (n == 0)
+        {
+            return;
+        }
+        struct Shared
+        {
+            std::atomic<std::size_t> next{0};
+            std::atomic<std::size_t> done{0};
+            std::exception_ptr error;
+            std::mutex mu;
+            std::condition_variable cv;
+        };
+        auto shared = std::make_shared<Shared>();
+        auto run = [shared, n, &fn]
+        {
+            std::size_t i;
+            while ((i = shared->next.fetch_add(1)) < n)
+            {
+                try
+                {
+                    fn(i);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(shared->mu);
+                    if (!shared->error)
+                    {
+                        shared->error = std::current_exception();
+                    }
+                }
+                if (shared->done.fetch_add(1) + 1 == n)
+                {
+                    std::lock_guard<std::mutex> lock(shared->mu);
+                    shared->cv.notify_all();
+                }
+            }
+        };
+
+        std::size_t helpers = std::min<std::size_t>(workers_.size(), n - 1);
+        for (std::size_t i = 0; i < helpers; i++)
+        {
+            Submit(run);
+        }
+        run();
+        {
+            std::unique_lock<std::mutex> lock(shared->mu);
+            shared->cv.wait(lock, [&]
+                            { return shared->done.load() == n; });
+        }
+        if (shared->error)
+        {
+            std::rethrow_exception(shared->error);
+        }
+    }
+
+}
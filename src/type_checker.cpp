@@ -0,0 +1,1290 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include "sema.h"
+#include "symbol_table.h"
+#include "visitor.h"
+#include <algorithm>
+
+namespace tinycsharp
+{
+    namespace
+    {
+        // what the left side of a '.' or a callee denotes.
+        struct Target
+        {
+            enum Kind
+            {
+                kValue,
+                kClass,    // a program class, for static access
+                kExternal, // a library type or namespace, or a program namespace
+            } kind = kValue;
+            const Type *type = nullptr;
+            ClassInfo *cls = nullptr;
+            std::string path;
+        };
+
+        std::string_view StripSystem(std::string_view path)
+        {
+            return path.rfind("System.", 0) == 0 ? path.substr(7) : path;
+        }
+
+        bool IsTrueLiteral(const Expr *e)
+        {
+            const auto *lit = NodeCast<LiteralExpr>(e);
+            return lit && lit->literal_kind == LiteralKind::kBool && lit->bool_value;
+        }
+
+        const char *OperatorSpelling(TokenKind op)
+        {
+            switch (op)
+            {
+            case TokenKind::kTPlus:
+                return "+";
+            case TokenKind::kTMinus:
+                return "-";
+            case TokenKind::kTStar:
+                return "*";
+            case TokenKind::kTFSlash:
+                return "/";
+            case TokenKind::kTModulo:
+                return "%";
+            case TokenKind::kTLessThan:
+                return "<";
+            case TokenKind::kTGreaterThan:
+                return ">";
+            case TokenKind::kTLessOrEqual:
+                return "<=";
+            case TokenKind::kTGreaterOrEqual:
+                return ">=";
+            case TokenKind::kTEquality:
+                return "==";
+            case TokenKind::kTNeq:
+                return "!=";
+            case TokenKind::kTLogicalAnd:
+                return "&&";
+            case TokenKind::kTLogicalOr:
+                return "||";
+            case TokenKind::kTAmpersand:
+                return "&";
+            case TokenKind::kTPipe:
+                return "|";
+            case TokenKind::kTXor:
+                return "^";
+            case TokenKind::kTLShift:
+                return "<<";
+            case TokenKind::kTRShift:
+                return ">>";
+            case TokenKind::kTNot:
+                return "!";
+            case TokenKind::kTIncrement:
+                return "++";
+            case TokenKind::kTDecrement:
+                return "--";
+            case TokenKind::kTPlusAssign:
+                return "+=";
+            case TokenKind::kTMinusAssign:
+                return "-=";
+            default:
+                return "?";
+            }
+        }
+
+        class TypeChecker : public AstVisitor<TypeChecker, const Type *>
+        {
+        public:
+            TypeChecker(const GlobalSymbols &globals, const BodyTask &task, std::vector<Diagnostic> &diagnostics)
+                : globals_(globals), types_(globals.types()), task_(task), diagnostics_(diagnostics), owner_(task.owner)
+            {
+            }
+
+            void Run()
+            {
+                if (auto *field = NodeCast<FieldDecl>(task_.member))
+                {
+                    is_static_ = field->info->is_static;
+                    in_initializer_ = true;
+                    const Type *type = Check(field->init);
+                    Expect(field->init, type, field->info->type);
+                    return;
+                }
+                auto *decl = static_cast<MethodDecl *>(task_.member);
+                method_ = decl->info;
+                is_static_ = method_->is_static;
+                return_type_ = method_->return_type;
+                if (method_->is_async && return_type_->kind == TypeKind::kTask)
+                {
+                    return_type_ = return_type_->element;
+                }
+                table_.PushScope();
+                for (ParamDecl *param : decl->params)
+                {
+                    DeclareLocal(param->name_id, param->name, SymbolKind::kParam, param);
+                }
+                Visit(decl->body);
+                table_.PopScope();
+                if (reachable_ && return_type_->kind != TypeKind::kVoid && return_type_->kind != TypeKind::kError &&
+                    return_type_->kind != TypeKind::kExternal)
+                {
+                    Error(decl, "'" + MethodSignature(method_) + "': not all code paths return a value");
+                }
+            }
+
+            // statements
+
+            const Type *VisitBlockStmt(BlockStmt *block)
+            {
+                table_.PushScope();
+                for (Node *stmt : block->stmts)
+                {
+                    Visit(stmt);
+                }
+                table_.PopScope();
+                return nullptr;
+            }
+
+            const Type *VisitLocalVarStmt(LocalVarStmt *local)
+            {
+                const Type *type = nullptr;
+                if (local->type)
+                {
+                    type = globals_.ResolveType(local->type, owner_, &diagnostics_);
+                    if (type->kind == TypeKind::kVoid)
+                    {
+                        Error(local->type, "Keyword 'void' cannot be used in this context");
+                        type = types_.Error();
+                    }
+                }
+                if (local->init)
+                {
+                    const Type *init = Check(local->init);
+                    if (!type)
+                    {
+                        if (init->kind == TypeKind::kNull || init->kind == TypeKind::kVoid)
+                        {
+                            Error(local, "Cannot assign " + TypeToString(init) + " to an implicitly-typed variable");
+                            init = types_.Error();
+                        }
+                        type = init;
+                    }
+                    else
+                    {
+                        Expect(local->init, init, type);
+                    }
+                }
+                local->resolved_type = type ? type : types_.Error();
+                DeclareLocal(local->name_id, local->name, SymbolKind::kLocal, local);
+                return nullptr;
+            }
+
+            const Type *VisitExprStmt(ExprStmt *stmt)
+            {
+                Check(stmt->expr);
+                switch (stmt->expr->kind)
+                {
+                case NodeKind::kCallExpr:
+                case NodeKind::kAssignExpr:
+                case NodeKind::kNewExpr:
+                case NodeKind::kAwaitExpr:
+                    break;
+                case NodeKind::kUnaryExpr:
+                {
+                    TokenKind op = static_cast<UnaryExpr *>(stmt->expr)->op;
+                    if (op == TokenKind::kTIncrement || op == TokenKind::kTDecrement)
+                        break;
+                    [[fallthrough]];
+                }
+                default:
+                    Error(stmt->expr, "Only assignment, call, increment, decrement, await, and new object expressions can be used as a statement");
+                    break;
+                }
+                return nullptr;
+            }
+
+            const Type *VisitIfStmt(IfStmt *stmt)
+            {
+                CheckCondition(stmt->cond);
+                bool before = reachable_;
+                Visit(stmt->then_stmt);
+                bool after_then = reachable_;
+                reachable_ = before;
+                if (stmt->else_stmt)
+                {
+                    Visit(stmt->else_stmt);
+                }
+                reachable_ = after_then || reachable_;
+                return nullptr;
+            }
+
+            const Type *VisitWhileStmt(WhileStmt *stmt)
+            {
+                CheckCondition(stmt->cond);
+                loops_.push_back(Loop{});
+                Visit(stmt->body);
+                Loop loop = loops_.back();
+                loops_.pop_back();
+                reachable_ = loop.has_break || !IsTrueLiteral(stmt->cond);
+                return nullptr;
+            }
+
+            const Type *VisitDoWhileStmt(DoWhileStmt *stmt)
+            {
+                loops_.push_back(Loop{});
+                Visit(stmt->body);
+                Loop loop = loops_.back();
+                loops_.pop_back();
+                CheckCondition(stmt->cond);
+                reachable_ = loop.has_break || ((reachable_ || loop.has_continue) && !IsTrueLiteral(stmt->cond));
+                return nullptr;
+            }
+
+            const Type *VisitReturnStmt(ReturnStmt *stmt)
+            {
+                if (in_initializer_)
+                {
+                    return nullptr;
+                }
+                if (stmt->value)
+                {
+                    const Type *type = Check(stmt->value);
+                    if (return_type_->kind == TypeKind::kVoid)
+                    {
+                        if (method_->is_async && method_->return_type->kind == TypeKind::kTask)
+                        {
+                            Error(stmt, "Since '" + MethodSignature(method_) +
+                                            "' is an async method that returns 'Task', a return keyword must not be followed by an object expression");
+                        }
+                        else
+                        {
+                            Error(stmt, "Since '" + MethodSignature(method_) +
+                                            "' returns void, a return keyword must not be followed by an object expression");
+                        }
+                    }
+                    else
+                    {
+                        Expect(stmt->value, type, return_type_);
+                    }
+                }
+                else if (return_type_->kind != TypeKind::kVoid && return_type_->kind != TypeKind::kError)
+                {
+                    Error(stmt, "An object of a type convertible to '" + TypeToString(return_type_) + "' is required");
+                }
+                reachable_ = false;
+                return nullptr;
+            }
+
+            const Type *VisitBreakStmt(BreakStmt *stmt)
+            {
+                if (loops_.empty())
+                    Error(stmt, "No enclosing loop out of which to break or continue");
+                else
+                    loops_.back().has_break = true;
+                reachable_ = false;
+                return nullptr;
+            }
+
+            const Type *VisitContinueStmt(ContinueStmt *stmt)
+            {
+                if (loops_.empty())
+                    Error(stmt, "No enclosing loop out of which to break or continue");
+                else
+                    loops_.back().has_continue = true;
+                reachable_ = false;
+                return nullptr;
+            }
+
+            const Type *VisitThrowStmt(ThrowStmt *stmt)
+            {
+                if (stmt->value)
+                {
+                    const Type *type = Check(stmt->value);
+                    if (!type->IsReference() && type->kind != TypeKind::kError)
+                    {
+                        Error(stmt->value, "The type caught or thrown must be derived from System.Exception");
+                    }
+                }
+                reachable_ = false;
+                return nullptr;
+            }
+
+            // expressions
+
+            const Type *VisitLiteralExpr(LiteralExpr *lit)
+            {
+                switch (lit->literal_kind)
+                {
+                case LiteralKind::kInt:
+                    return lit->int_value > 0x7fffffffLL || lit->int_value < -0x80000000LL ? types_.Long() : types_.Int();
+                case LiteralKind::kFloat:
+                    return types_.Double();
+                case LiteralKind::kString:
+                    return types_.String();
+                case LiteralKind::kBool:
+                    return types_.Bool();
+                }
+                return types_.Error();
+            }
+
+            const Type *VisitNameExpr(NameExpr *name)
+            {
+                name->decl = nullptr;
+                if (const SymbolEntry *e = table_.Lookup(name->name_id))
+                {
+                    name->decl = e->decl;
+                    return e->kind == SymbolKind::kParam ? static_cast<ParamDecl *>(e->decl)->resolved_type
+                                                         : static_cast<LocalVarStmt *>(e->decl)->resolved_type;
+                }
+                if (FieldInfo *field = FieldInScope(name))
+                {
+                    name->decl = field->decl;
+                    return field->type;
+                }
+                std::vector<MethodInfo *> methods;
+                if (MethodsInScope(name->name_id, methods))
+                {
+                    Error(name, "Cannot convert method group '" + std::string(name->name) + "' to non-delegate type");
+                    return types_.Error();
+                }
+                if (ClassInfo *cls = globals_.LookupClass(name->name, owner_, owner_->imports))
+                {
+                    name->decl = cls->decl;
+                    Error(name, "'" + cls->qualified_name + "' is a type, which is not valid in the given context");
+                    return types_.Error();
+                }
+                if (name->name == "null")
+                {
+                    return types_.Null();
+                }
+                Error(name, "The name '" + std::string(name->name) + "' does not exist in the current context");
+                return types_.Error();
+            }
+
+            const Type *VisitMemberExpr(MemberExpr *member)
+            {
+                Target target = Resolve(member);
+                switch (target.kind)
+                {
+                case Target::kValue:
+                    return target.type;
+                case Target::kClass:
+                    Error(member, "'" + target.cls->qualified_name + "' is a type, which is not valid in the given context");
+                    return types_.Error();
+                case Target::kExternal:
+                    if (globals_.IsNamespace(target.path))
+                    {
+                        Error(member, "'" + target.path + "' is a namespace but is used like a variable");
+                        return types_.Error();
+                    }
+                    return Dynamic();
+                }
+                return types_.Error();
+            }
+
+            const Type *VisitCallExpr(CallExpr *call)
+            {
+                std::vector<const Type *> args;
+                for (Expr *arg : call->args)
+                {
+                    args.push_back(Check(arg));
+                }
+
+                if (auto *name = NodeCast<NameExpr>(call->callee))
+                {
+                    std::vector<MethodInfo *> candidates;
+                    ClassInfo *found_in = MethodsInScope(name->name_id, candidates);
+                    if (!found_in)
+                    {
+                        if (table_.Lookup(name->name_id) || FieldInScope(name))
+                            Error(name, "Non-invocable member '" + std::string(name->name) + "' cannot be used like a method");
+                        else
+                            Error(name, "The name '" + std::string(name->name) + "' does not exist in the current context");
+                        return types_.Error();
+                    }
+                    MethodInfo *method = ResolveOverload(call, name->name, candidates, args);
+                    if (!method)
+                    {
+                        return types_.Error();
+                    }
+                    if (!method->is_static && (is_static_ || found_in != owner_))
+                    {
+                        Error(name, "An object reference is required for the non-static field, method, or property '" +
+                                        MethodSignature(method) + "'");
+                    }
+                    name->decl = method->decl;
+                    call->target = method;
+                    return method->return_type;
+                }
+
+                auto *member = NodeCast<MemberExpr>(call->callee);
+                if (!member)
+                {
+                    Check(call->callee);
+                    Error(call->callee, "Method name expected");
+                    return types_.Error();
+                }
+                Target object = Resolve(member->object);
+                std::vector<MethodInfo *> candidates;
+                switch (object.kind)
+                {
+                case Target::kExternal:
+                    return CallExternal(call, member, object.path, args);
+                case Target::kClass:
+                    object.cls->FindMethods(member->name_id, candidates);
+                    break;
+                case Target::kValue:
+                    if (object.type->kind == TypeKind::kError)
+                        return types_.Error();
+                    if (object.type->kind == TypeKind::kExternal)
+                        return Dynamic();
+                    if (object.type->kind == TypeKind::kClass)
+                        object.type->cls->FindMethods(member->name_id, candidates);
+                    break;
+                }
+                if (candidates.empty())
+                {
+                    std::string owner = object.kind == Target::kClass ? object.cls->qualified_name : TypeToString(object.type);
+                    Error(member, "'" + owner + "' does not contain a definition for '" + std::string(member->name) + "'");
+                    return types_.Error();
+                }
+                MethodInfo *method = ResolveOverload(call, member->name, candidates, args);
+                if (!method)
+                {
+                    return types_.Error();
+                }
+                if (object.kind == Target::kClass && !method->is_static)
+                {
+                    Error(member, "An object reference is required for the non-static field, method, or property '" +
+                                      MethodSignature(method) + "'");
+                }
+                else if (object.kind == Target::kValue && method->is_static)
+                {
+                    Error(member, "Member '" + MethodSignature(method) +
+                                      "' cannot be accessed with an instance reference; qualify it with a type name instead");
+                }
+                call->target = method;
+                return method->return_type;
+            }
+
+            const Type *VisitIndexExpr(IndexExpr *index)
+            {
+                const Type *object = Check(index->object);
+                const Type *at = Check(index->index);
+                if (!at->IsIntegral() && at->kind != TypeKind::kError && at->kind != TypeKind::kExternal)
+                {
+                    Error(index->index, "Cannot implicitly convert type '" + TypeToString(at) + "' to 'int'");
+                }
+                switch (object->kind)
+                {
+                case TypeKind::kArray:
+                    return object->element;
+                case TypeKind::kString:
+                    return types_.Char();
+                case TypeKind::kError:
+                    return types_.Error();
+                case TypeKind::kExternal:
+                    return Dynamic();
+                default:
+                    Error(index, "Cannot apply indexing with [] to an expression of type '" + TypeToString(object) + "'");
+                    return types_.Error();
+                }
+            }
+
+            const Type *VisitUnaryExpr(UnaryExpr *unary)
+            {
+                const Type *operand = Check(unary->operand);
+                if (IsUnchecked(operand))
+                {
+                    return unary->op == TokenKind::kTNot ? types_.Bool() : operand;
+                }
+                switch (unary->op)
+                {
+                case TokenKind::kTNot:
+                    if (operand->kind == TypeKind::kBool)
+                        return operand;
+                    break;
+                case TokenKind::kTMinus:
+                case TokenKind::kTPlus:
+                    if (operand->IsNumeric())
+                        return Promote(operand, types_.Int());
+                    break;
+                case TokenKind::kTIncrement:
+                case TokenKind::kTDecrement:
+                    if (operand->IsNumeric())
+                    {
+                        CheckAssignable(unary->operand, "The operand of an increment or decrement operator must be a variable, property or indexer");
+                        return operand;
+                    }
+                    break;
+                default:
+                    break;
+                }
+                Error(unary, std::string("Operator '") + OperatorSpelling(unary->op) + "' cannot be applied to operand of type '" +
+                                 TypeToString(operand) + "'");
+                return types_.Error();
+            }
+
+            const Type *VisitBinaryExpr(BinaryExpr *binary)
+            {
+                const Type *lhs = Check(binary->lhs);
+                const Type *rhs = Check(binary->rhs);
+                const Type *result = BinaryResult(binary->op, lhs, rhs);
+                if (!result)
+                {
+                    Error(binary, std::string("Operator '") + OperatorSpelling(binary->op) +
+                                      "' cannot be applied to operands of type '" + TypeToString(lhs) + "' and '" +
+                                      TypeToString(rhs) + "'");
+                    return types_.Error();
+                }
+                return result;
+            }
+
+            const Type *VisitAssignExpr(AssignExpr *assign)
+            {
+                const Type *target = Check(assign->target);
+                const Type *value = Check(assign->value);
+                CheckAssignable(assign->target, "The left-hand side of an assignment must be a variable, property or indexer");
+                if (assign->op == TokenKind::kTAssign)
+                {
+                    Expect(assign->value, value, target);
+                    return target;
+                }
+                const Type *result = BinaryResult(assign->op == TokenKind::kTPlusAssign ? TokenKind::kTPlus : TokenKind::kTMinus, target, value);
+                if (!result)
+                {
+                    Error(assign, std::string("Operator '") + OperatorSpelling(assign->op) +
+                                      "' cannot be applied to operands of type '" + TypeToString(target) + "' and '" +
+                                      TypeToString(value) + "'");
+                }
+                else if (!IsAssignable(result, target, nullptr))
+                {
+                    Error(assign, "Cannot implicitly convert type '" + TypeToString(result) + "' to '" + TypeToString(target) +
+                                      "'. An explicit conversion exists (are you missing a cast?)");
+                }
+                return target;
+            }
+
+            const Type *VisitConditionalExpr(ConditionalExpr *cond)
+            {
+                CheckCondition(cond->cond);
+                const Type *a = Check(cond->then_expr);
+                const Type *b = Check(cond->else_expr);
+                if (a == b)
+                    return a;
+                if (IsAssignable(b, a, cond->else_expr))
+                    return a;
+                if (IsAssignable(a, b, cond->then_expr))
+                    return b;
+                Error(cond, "Type of conditional expression cannot be determined because there is no implicit conversion between '" +
+                                TypeToString(a) + "' and '" + TypeToString(b) + "'");
+                return types_.Error();
+            }
+
+            const Type *VisitCastExpr(CastExpr *cast)
+            {
+                const Type *to = globals_.ResolveType(cast->type, owner_, &diagnostics_);
+                const Type *from = Check(cast->operand);
+                bool ok = IsAssignable(from, to, cast->operand) || IsAssignable(to, from, nullptr) ||
+                          (from->IsNumeric() && to->IsNumeric());
+                if (!ok)
+                {
+                    Error(cast, "Cannot convert type '" + TypeToString(from) + "' to '" + TypeToString(to) + "'");
+                    return types_.Error();
+                }
+                return to;
+            }
+
+            const Type *VisitNewExpr(NewExpr *expr)
+            {
+                std::vector<const Type *> args;
+                for (Expr *arg : expr->args)
+                {
+                    args.push_back(Check(arg));
+                }
+                const Type *type = globals_.ResolveType(expr->type, owner_, &diagnostics_);
+                if (type->kind == TypeKind::kError)
+                {
+                    return type;
+                }
+                if (type->kind == TypeKind::kArray)
+                {
+                    // new T[n]
+                    if (args.size() == 1 && !args[0]->IsIntegral() && !IsUnchecked(args[0]))
+                    {
+                        Error(expr->args[0], "Cannot implicitly convert type '" + TypeToString(args[0]) + "' to 'int'");
+                    }
+                    return type;
+                }
+                if (type->kind != TypeKind::kClass)
+                {
+                    if (!args.empty() && type->kind != TypeKind::kExternal)
+                    {
+                        Error(expr, "'" + TypeToString(type) + "' does not contain a constructor that takes " +
+                                        std::to_string(args.size()) + " arguments");
+                    }
+                    return type;
+                }
+                ClassInfo *cls = type->cls;
+                if (cls->is_abstract || cls->is_static)
+                {
+                    Error(expr, "Cannot create an instance of the " + std::string(cls->is_static ? "static class" : "abstract type") +
+                                    " '" + cls->qualified_name + "'");
+                    return type;
+                }
+                if (cls->ctors.empty())
+                {
+                    if (!args.empty())
+                    {
+                        Error(expr, "'" + cls->qualified_name + "' does not contain a constructor that takes " +
+                                        std::to_string(args.size()) + " arguments");
+                    }
+                    return type;
+                }
+                std::vector<MethodInfo *> candidates = cls->ctors;
+                expr->ctor = ResolveOverload(expr, cls->decl->name, candidates, args);
+                return type;
+            }
+
+            const Type *VisitThisExpr(ThisExpr *expr)
+            {
+                if (is_static_)
+                {
+                    Error(expr, "Keyword 'this' is not valid in a static property, static method, or static field initializer");
+                    return types_.Error();
+                }
+                return owner_->type;
+            }
+
+            const Type *VisitAwaitExpr(AwaitExpr *expr)
+            {
+                const Type *operand = Check(expr->operand);
+                if (!method_ || !method_->is_async)
+                {
+                    Error(expr, "The 'await' operator can only be used within an async method");
+                    return types_.Error();
+                }
+                if (operand->kind == TypeKind::kTask)
+                    return operand->element;
+                if (IsUnchecked(operand))
+                    return operand;
+                Error(expr, "Cannot await '" + TypeToString(operand) + "'");
+                return types_.Error();
+            }
+
+        private:
+            struct Loop
+            {
+                bool has_break = false;
+                bool has_continue = false;
+            };
+
+            const Type *Check(Expr *expr)
+            {
+                const Type *type = Visit(expr);
+                expr->type = type ? type : types_.Error();
+                return expr->type;
+            }
+
+            const Type *Dynamic() { return types_.External("dynamic"); }
+
+            static bool IsUnchecked(const Type *type)
+            {
+                return type->kind == TypeKind::kError || type->kind == TypeKind::kExternal;
+            }
+
+            const Type *OfKind(TypeKind kind) const
+            {
+                switch (kind)
+                {
+                case TypeKind::kLong:
+                    return types_.Long();
+                case TypeKind::kFloat:
+                    return types_.Float();
+                case TypeKind::kDouble:
+                    return types_.Double();
+                default:
+                    return types_.Int();
+                }
+            }
+
+            // binary numeric promotion; char widens to int.
+            const Type *Promote(const Type *a, const Type *b) const
+            {
+                TypeKind kind = std::max({a->kind, b->kind, TypeKind::kInt});
+                return OfKind(kind);
+            }
+
+            // result type of a binary operator, or null if it does not apply.
+            const Type *BinaryResult(TokenKind op, const Type *lhs, const Type *rhs)
+            {
+                bool unchecked = IsUnchecked(lhs) || IsUnchecked(rhs);
+                switch (op)
+                {
+                case TokenKind::kTPlus:
+                    if ((lhs->kind == TypeKind::kString && rhs->kind != TypeKind::kVoid) ||
+                        (rhs->kind == TypeKind::kString && lhs->kind != TypeKind::kVoid))
+                        return types_.String();
+                    [[fallthrough]];
+                case TokenKind::kTMinus:
+                case TokenKind::kTStar:
+                case TokenKind::kTFSlash:
+                case TokenKind::kTModulo:
+                    if (unchecked)
+                        return IsUnchecked(lhs) ? lhs : rhs;
+                    if (lhs->IsNumeric() && rhs->IsNumeric())
+                        return Promote(lhs, rhs);
+                    return nullptr;
+                case TokenKind::kTLessThan:
+                case TokenKind::kTGreaterThan:
+                case TokenKind::kTLessOrEqual:
+                case TokenKind::kTGreaterOrEqual:
+                    return unchecked || (lhs->IsNumeric() && rhs->IsNumeric()) ? types_.Bool() : nullptr;
+                case TokenKind::kTEquality:
+                case TokenKind::kTNeq:
+                    if (unchecked || (lhs->IsNumeric() && rhs->IsNumeric()) || lhs == rhs ||
+                        (lhs->IsReference() && rhs->IsReference() &&
+                         (IsAssignable(lhs, rhs, nullptr) || IsAssignable(rhs, lhs, nullptr))))
+                        return types_.Bool();
+                    return nullptr;
+                case TokenKind::kTLogicalAnd:
+                case TokenKind::kTLogicalOr:
+                    return unchecked || (lhs->kind == TypeKind::kBool && rhs->kind == TypeKind::kBool) ? types_.Bool() : nullptr;
+                case TokenKind::kTAmpersand:
+                case TokenKind::kTPipe:
+                case TokenKind::kTXor:
+                    if (lhs->kind == TypeKind::kBool && rhs->kind == TypeKind::kBool)
+                        return types_.Bool();
+                    if (unchecked)
+                        return IsUnchecked(lhs) ? lhs : rhs;
+                    return lhs->IsIntegral() && rhs->IsIntegral() ? Promote(lhs, rhs) : nullptr;
+                case TokenKind::kTLShift:
+                case TokenKind::kTRShift:
+                    if (unchecked)
+                        return IsUnchecked(lhs) ? lhs : rhs;
+                    return lhs->IsIntegral() && rhs->IsIntegral() && rhs->kind != TypeKind::kLong ? Promote(lhs, types_.Int()) : nullptr;
+                default:
+                    return nullptr;
+                }
+            }
+
+            bool IsAssignable(const Type *from, const Type *to, const Expr *expr) const
+            {
+                if (from == to || IsUnchecked(from) || IsUnchecked(to))
+                    return true;
+                if (to->kind == TypeKind::kObject)
+                    return from->kind != TypeKind::kVoid;
+                if (from->kind == TypeKind::kNull)
+                    return to->IsReference();
+                if (from->IsNumeric() && to->IsNumeric())
+                {
+                    if (to->kind == TypeKind::kChar)
+                        return false;
+                    if (from->kind <= to->kind)
+                        return true;
+                    // a double literal may initialise a float.
+                    return from->kind == TypeKind::kDouble && to->kind == TypeKind::kFloat && expr &&
+                           expr->kind == NodeKind::kLiteralExpr;
+                }
+                if (from->kind == TypeKind::kClass && to->kind == TypeKind::kClass)
+                    return from->cls->IsSubclassOf(to->cls);
+                return false;
+            }
+
+            void Expect(Expr *expr, const Type *from, const Type *to)
+            {
+                if (IsAssignable(from, to, expr))
+                {
+                    return;
+                }
+                std::string message = "Cannot implicitly convert type '" + TypeToString(from) + "' to '" + TypeToString(to) + "'";
+                if ((from->IsNumeric() && to->IsNumeric()) || IsAssignable(to, from, nullptr))
+                {
+                    message += ". An explicit conversion exists (are you missing a cast?)";
+                }
+                Error(expr, message);
+            }
+
+            void CheckCondition(Expr *cond)
+            {
+                const Type *type = Check(cond);
+                if (type->kind != TypeKind::kBool && !IsUnchecked(type))
+                {
+                    Error(cond, "Cannot implicitly convert type '" + TypeToString(type) + "' to 'bool'");
+                }
+            }
+
+            void CheckField(Expr *target, FieldInfo *field, const std::string &message)
+            {
+                if (field->is_const)
+                {
+                    Error(target, message);
+                }
+                else if (field->is_readonly && !in_initializer_ &&
+                         !(method_ && method_->is_ctor && field->owner == owner_ && method_->is_static == field->is_static))
+                {
+                    Error(target, "A readonly field cannot be assigned to (except in a constructor or a variable initializer)");
+                }
+            }
+
+            // target must be a variable: a local, parameter, field or array element.
+            void CheckAssignable(Expr *target, const std::string &message)
+            {
+                if (IsUnchecked(target->type))
+                {
+                    return;
+                }
+                if (auto *name = NodeCast<NameExpr>(target))
+                {
+                    if (auto *local = NodeCast<LocalVarStmt>(name->decl))
+                    {
+                        if (local->is_const)
+                            Error(target, message);
+                        return;
+                    }
+                    if (name->decl && name->decl->kind == NodeKind::kParamDecl)
+                        return;
+                    if (auto *field = NodeCast<FieldDecl>(name->decl))
+                    {
+                        CheckField(target, field->info, message);
+                        return;
+                    }
+                }
+                else if (auto *member = NodeCast<MemberExpr>(target))
+                {
+                    if (member->field)
+                    {
+                        CheckField(target, member->field, message);
+                        return;
+                    }
+                }
+                else if (auto *index = NodeCast<IndexExpr>(target))
+                {
+                    if (index->object->type->kind == TypeKind::kArray || IsUnchecked(index->object->type))
+                        return;
+                    Error(target, "Property or indexer '" + TypeToString(index->object->type) +
+                                      ".this[int]' cannot be assigned to -- it is read only");
+                    return;
+                }
+                Error(target, message);
+            }
+
+            void DeclareLocal(SymbolId id, std::string_view name, SymbolKind kind, Node *decl)
+            {
+                // every binding in the table belongs to this body, so any
+                // visible one conflicts.
+                if (const SymbolEntry *existing = table_.Lookup(id))
+                {
+                    if (table_.ScopeOf(existing) == table_.Depth())
+                        Error(decl, "A local variable or parameter named '" + std::string(name) + "' is already defined in this scope");
+                    else
+                        Error(decl, "A local or parameter named '" + std::string(name) +
+                                        "' cannot be declared in this scope because that name is used in an enclosing local scope");
+                    return;
+                }
+                table_.Declare(id, kind, decl);
+            }
+
+            // a field visible by simple name: one of this class (or a base),
+            // or a static field of an enclosing class.
+            FieldInfo *FieldInScope(NameExpr *name)
+            {
+                for (ClassInfo *cls = owner_; cls; cls = cls->outer)
+                {
+                    FieldInfo *field = cls->FindField(name->name_id);
+                    if (!field)
+                    {
+                        continue;
+                    }
+                    if (!field->is_static && (is_static_ || cls != owner_))
+                    {
+                        Error(name, "An object reference is required for the non-static field, method, or property '" +
+                                        field->owner->qualified_name + "." + std::string(field->decl->name) + "'");
+                    }
+                    return field;
+                }
+                return nullptr;
+            }
+
+            // methods visible by simple name; returns the class they were
+            // found in, or null.
+            ClassInfo *MethodsInScope(SymbolId name, std::vector<MethodInfo *> &out)
+            {
+                for (ClassInfo *cls = owner_; cls; cls = cls->outer)
+                {
+                    cls->FindMethods(name, out);
+                    if (!out.empty())
+                    {
+                        return cls;
+                    }
+                }
+                return nullptr;
+            }
+
+            // classifies the object of a member access or call: a value, a
+            // program class or a library type / namespace path.
+            Target Resolve(Expr *expr)
+            {
+                Target target;
+                if (auto *name = NodeCast<NameExpr>(expr))
+                {
+                    if (!table_.Lookup(name->name_id) && !FindFieldQuiet(name->name_id))
+                    {
+                        std::vector<MethodInfo *> methods;
+                        if (!MethodsInScope(name->name_id, methods) && name->name != "null")
+                        {
+                            if (ClassInfo *cls = globals_.LookupClass(name->name, owner_, owner_->imports))
+                            {
+                                name->decl = cls->decl;
+                                name->type = cls->type;
+                                target.kind = Target::kClass;
+                                target.cls = cls;
+                                return target;
+                            }
+                            if (IsExternalRoot(name->name))
+                            {
+                                name->type = Dynamic();
+                                target.kind = Target::kExternal;
+                                target.path = std::string(name->name);
+                                return target;
+                            }
+                        }
+                    }
+                }
+                else if (auto *member = NodeCast<MemberExpr>(expr))
+                {
+                    Target object = Resolve(member->object);
+                    if (object.kind == Target::kValue)
+                    {
+                        target.type = MemberOf(member, object.type);
+                        member->type = target.type;
+                        return target;
+                    }
+                    if (object.kind == Target::kClass)
+                    {
+                        auto it = object.cls->nested.find(member->name_id);
+                        if (it != object.cls->nested.end())
+                        {
+                            member->type = it->second->type;
+                            target.kind = Target::kClass;
+                            target.cls = it->second;
+                            return target;
+                        }
+                        target.type = StaticMemberOf(member, object.cls);
+                        member->type = target.type;
+                        return target;
+                    }
+                    std::string path = object.path + "." + std::string(member->name);
+                    if (const Type *type = BuiltinMember(member, object.path))
+                    {
+                        member->type = type;
+                        target.type = type;
+                        return target;
+                    }
+                    if (ClassInfo *cls = globals_.FindClass(path))
+                    {
+                        member->type = cls->type;
+                        target.kind = Target::kClass;
+                        target.cls = cls;
+                        return target;
+                    }
+                    if (globals_.IsNamespace(object.path) && !globals_.IsNamespace(path))
+                    {
+                        Error(member, "The type or namespace name '" + std::string(member->name) +
+                                          "' does not exist in the namespace '" + object.path + "'");
+                        member->type = types_.Error();
+                        target.type = types_.Error();
+                        return target;
+                    }
+                    member->type = Dynamic();
+                    target.kind = Target::kExternal;
+                    target.path = path;
+                    return target;
+                }
+                target.type = Check(expr);
+                return target;
+            }
+
+            FieldInfo *FindFieldQuiet(SymbolId name) const
+            {
+                for (ClassInfo *cls = owner_; cls; cls = cls->outer)
+                {
+                    if (FieldInfo *field = cls->FindField(name))
+                        return field;
+                }
+                return nullptr;
+            }
+
+            // names the checker treats as library types or namespaces when
+            // they appear on the left of a '.'.
+            bool IsExternalRoot(std::string_view name) const
+            {
+                return name == "Console" || name == "Math" || name == "Task" || name == "System" || name == "String" ||
+                       types_.Builtin(name) != nullptr || globals_.IsNamespace(name) ||
+                       owner_->imports->AllowsExternalTypes();
+            }
+
+            const Type *BuiltinMember(MemberExpr *member, std::string_view path)
+            {
+                path = StripSystem(path);
+                std::string_view name = member->name;
+                Builtin builtin = Builtin::kNone;
+                const Type *type = nullptr;
+                const Type *owner = types_.Builtin(path);
+                if (owner == types_.Int() && (name == "MaxValue" || name == "MinValue"))
+                {
+                    builtin = name == "MaxValue" ? Builtin::kIntMaxValue : Builtin::kIntMinValue;
+                    type = types_.Int();
+                }
+                else if (owner == types_.Long() && (name == "MaxValue" || name == "MinValue"))
+                {
+                    builtin = name == "MaxValue" ? Builtin::kLongMaxValue : Builtin::kLongMinValue;
+                    type = types_.Long();
+                }
+                else if ((path == "Task" || path == "Threading.Tasks.Task") && name == "CompletedTask")
+                {
+                    builtin = Builtin::kTaskCompleted;
+                    type = types_.TaskOf(types_.Void());
+                }
+                member->builtin = static_cast<std::uint16_t>(builtin);
+                return type;
+            }
+
+            const Type *MemberOf(MemberExpr *member, const Type *object)
+            {
+                switch (object->kind)
+                {
+                case TypeKind::kError:
+                    return object;
+                case TypeKind::kExternal:
+                    return Dynamic();
+                case TypeKind::kString:
+                case TypeKind::kArray:
+                    if (member->name == "Length")
+                    {
+                        member->builtin = static_cast<std::uint16_t>(object->kind == TypeKind::kString ? Builtin::kStringLength
+                                                                                                      : Builtin::kArrayLength);
+                        return types_.Int();
+                    }
+                    break;
+                case TypeKind::kClass:
+                    if (FieldInfo *field = object->cls->FindField(member->name_id))
+                    {
+                        if (field->is_static)
+                        {
+                            Error(member, "Member '" + field->owner->qualified_name + "." + std::string(member->name) +
+                                              "' cannot be accessed with an instance reference; qualify it with a type name instead");
+                        }
+                        member->field = field;
+                        return field->type;
+                    }
+                    break;
+                default:
+                    break;
+                }
+                Error(member, "'" + TypeToString(object) + "' does not contain a definition for '" + std::string(member->name) + "'");
+                return types_.Error();
+            }
+
+            const Type *StaticMemberOf(MemberExpr *member, ClassInfo *cls)
+            {
+                if (FieldInfo *field = cls->FindField(member->name_id))
+                {
+                    if (!field->is_static)
+                    {
+                        Error(member, "An object reference is required for the non-static field, method, or property '" +
+                                          field->owner->qualified_name + "." + std::string(member->name) + "'");
+                    }
+                    member->field = field;
+                    return field->type;
+                }
+                Error(member, "'" + cls->qualified_name + "' does not contain a definition for '" + std::string(member->name) + "'");
+                return types_.Error();
+            }
+
+            const Type *CallExternal(CallExpr *call, MemberExpr *member, const std::string &path, const std::vector<const Type *> &args)
+            {
+                std::string_view owner = StripSystem(path);
+                std::string_view name = member->name;
+                auto arity = [&](std::size_t n)
+                {
+                    if (args.size() == n)
+                        return true;
+                    Error(member, "No overload for method '" + std::string(name) + "' takes " + std::to_string(args.size()) + " arguments");
+                    return false;
+                };
+                auto numeric = [&](std::size_t i)
+                {
+                    if (args[i]->IsNumeric() || IsUnchecked(args[i]))
+                        return true;
+                    Error(call->args[i], "Argument " + std::to_string(i + 1) + ": cannot convert from '" + TypeToString(args[i]) + "' to 'double'");
+                    return false;
+                };
+                Builtin builtin = Builtin::kNone;
+                const Type *result = nullptr;
+                if (owner == "Console" && (name == "WriteLine" || name == "Write"))
+                {
+                    builtin = name == "WriteLine" ? Builtin::kConsoleWriteLine : Builtin::kConsoleWrite;
+                    for (std::size_t i = 0; i < args.size(); i++)
+                    {
+                        if (args[i]->kind == TypeKind::kVoid)
+                            Error(call->args[i], "Argument " + std::to_string(i + 1) + ": cannot convert from 'void' to 'object'");
+                    }
+                    result = types_.Void();
+                }
+                else if (owner == "Math" && (name == "Abs" || name == "Sqrt"))
+                {
+                    builtin = name == "Abs" ? Builtin::kMathAbs : Builtin::kMathSqrt;
+                    result = types_.Error();
+                    if (arity(1) && numeric(0))
+                        result = name == "Sqrt" ? types_.Double() : IsUnchecked(args[0]) ? args[0] : Promote(args[0], types_.Int());
+                }
+                else if (owner == "Math" && (name == "Max" || name == "Min"))
+                {
+                    builtin = name == "Max" ? Builtin::kMathMax : Builtin::kMathMin;
+                    result = types_.Error();
+                    if (arity(2) && numeric(0) && numeric(1))
+                        result = IsUnchecked(args[0]) ? args[0] : IsUnchecked(args[1]) ? args[1] : Promote(args[0], args[1]);
+                }
+                else if (owner == "Task" || owner == "Threading.Tasks.Task")
+                {
+                    result = types_.Error();
+                    if (name == "FromResult")
+                    {
+                        builtin = Builtin::kTaskFromResult;
+                        if (arity(1))
+                            result = types_.TaskOf(args[0]);
+                    }
+                    else if (name == "Yield")
+                    {
+                        builtin = Builtin::kTaskYield;
+                        if (arity(0))
+                            result = types_.TaskOf(types_.Void());
+                    }
+                    else if (name == "Delay")
+                    {
+                        builtin = Builtin::kTaskDelay;
+                        if (arity(1) && numeric(0))
+                            result = types_.TaskOf(types_.Void());
+                    }
+                    else
+                    {
+                        Error(member, "'Task' does not contain a definition for '" + std::string(name) + "'");
+                    }
+                }
+                else if (globals_.IsNamespace(path))
+                {
+                    Error(member, "'" + path + "' is a namespace but is used like a type");
+                    return types_.Error();
+                }
+                if (!result)
+                {
+                    return Dynamic();
+                }
+                call->builtin = static_cast<std::uint16_t>(builtin);
+                member->builtin = call->builtin;
+                return result;
+            }
+
+            // picks the first candidate whose parameters accept the
+            // arguments, preferring an exact match.
+            MethodInfo *ResolveOverload(Expr *at, std::string_view name, const std::vector<MethodInfo *> &candidates,
+                                        const std::vector<const Type *> &args)
+            {
+                MethodInfo *applicable = nullptr;
+                MethodInfo *same_arity = nullptr;
+                for (MethodInfo *m : candidates)
+                {
+                    if (m->param_types.size() != args.size())
+                    {
+                        continue;
+                    }
+                    if (!same_arity)
+                    {
+                        same_arity = m;
+                    }
+                    bool exact = true, ok = true;
+                    for (std::size_t i = 0; i < args.size() && ok; i++)
+                    {
+                        exact = exact && args[i] == m->param_types[i];
+                        ok = IsAssignable(args[i], m->param_types[i], ArgAt(at, i));
+                    }
+                    if (ok && exact)
+                    {
+                        return m;
+                    }
+                    if (ok && !applicable)
+                    {
+                        applicable = m;
+                    }
+                }
+                if (applicable)
+                {
+                    return applicable;
+                }
+                if (!same_arity)
+                {
+                    Error(at, "No overload for method '" + std::string(name) + "' takes " + std::to_string(args.size()) + " arguments");
+                    return nullptr;
+                }
+                for (std::size_t i = 0; i < args.size(); i++)
+                {
+                    if (!IsAssignable(args[i], same_arity->param_types[i], ArgAt(at, i)))
+                    {
+                        Error(ArgAt(at, i), "Argument " + std::to_string(i + 1) + ": cannot convert from '" +
+                                                TypeToString(args[i]) + "' to '" + TypeToString(same_arity->param_types[i]) + "'");
+                        break;
+                    }
+                }
+                return nullptr;
+            }
+
+            static Expr *ArgAt(Expr *at, std::size_t i)
+            {
+                if (auto *call = NodeCast<CallExpr>(at))
+                    return call->args[i];
+                return static_cast<NewExpr *>(at)->args[i];
+            }
+
+            void Error(const Node *node, const std::string &message)
+            {
+                const CompilationUnit *unit = task_.owner->decl->unit;
+                SourcePosition at = unit ? unit->Locate(node) : SourcePosition{};
+                diagnostics_.push_back(Diagnostic{Severity::kError, std::string(task_.file), at.line, at.column, message});
+            }
+
+            const GlobalSymbols &globals_;
+            TypeTable &types_;
+            const BodyTask &task_;
+            std::vector<Diagnostic> &diagnostics_;
+            ClassInfo *owner_;
+            MethodInfo *method_ = nullptr;
+            const Type *return_type_ = nullptr;
+            bool is_static_ = false;
+            bool in_initializer_ = false;
+            bool reachable_ = true;
+            std::vector<Loop> loops_;
+            ScopedSymbolTable table_;
+        };
+    }
+
+    void CheckBody(const GlobalSymbols &globals, const BodyTask &task, std::vector<Diagnostic> &diagnostics)
+    {
+        TypeChecker checker(globals, task, diagnostics);
+        checker.Run();
+    }
+
+}
@@ -0,0 +1,151 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+
+#include "types.h"
+#include "sema.h"
+
+namespace tinycsharp
+{
+
+    TypeTable::TypeTable()
+        : builtins_{{TypeKind::kError}, {TypeKind::kVoid}, {TypeKind::kBool}, {TypeKind::kChar}, {TypeKind::kInt}, {TypeKind::kLong}, {TypeKind::kFloat}, {TypeKind::kDouble}, {TypeKind::kString}, {TypeKind::kObject}, {TypeKind::kNull}}
+    {
+    }
+
+    const Type *TypeTable::Builtin(std::string_view name) const
+    {
+        if (name == "void")
+            return Void();
+        if (name == "bool" || name == "Boolean")
+            return Bool();
+        if (name == "char")
+            return Char();
+        // byte and short are widened to int; the subset has no narrow arithmetic.
+        if (name == "int" || name == "short" || name == "byte" || name == "Int32")
+            return Int();
+        if (name == "long" || name == "Int64")
+            return Long();
+        if (name == "float")
+            return Float();
+        if (name == "double")
+            return Double();
+        if (name == "string" || name == "String")
+            return String();
+        if (name == "object" || name == "Object")
+            return Object();
+        return nullptr;
+    }
+
+    const Type *TypeTable::ClassType(ClassInfo *cls)
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        auto it = classes_.find(cls);
+        if (it != classes_.end())
+        {
+            return it->second;
+        }
+        storage_.push_back(Type{TypeKind::kClass, cls});
+        classes_[cls] = &storage_.back();
+        return &storage_.back();
+    }
+
+    const Type *TypeTable::ArrayOf(const Type *element)
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        auto it = arrays_.find(element);
+        if (it != arrays_.end())
+        {
+            return it->second;
+        }
+        storage_.push_back(Type{TypeKind::kArray, nullptr, element});
+        arrays_[element] = &storage_.back();
+        return &storage_.back();
+    }
+
+    const Type *TypeTable::TaskOf(const Type *result)
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        auto it = tasks_.find(result);
+        if (it != tasks_.end())
+        {
+            return it->second;
+        }
+        storage_.push_back(Type{TypeKind::kTask, nullptr, result});
+        tasks_[result] = &storage_.back();
+        return &storage_.back();
+    }
+
+    const Type *TypeTable::External(std::string_view name)
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        auto it = externals_.find(name);
+        if (it != externals_.end())
+        {
+            return it->second;
+        }
+        names_.emplace_back(name);
+        storage_.push_back(Type{TypeKind::kExternal, nullptr, nullptr, names_.back()});
+        externals_.emplace(names_.back(), &storage_.back());
+        return &storage_.back();
+    }
+
+    std::string TypeToString(const Type *type)
+    {
+        if (!type)
+        {
+            return "<null>";
+        }
+        switch (type->kind)
+        {
+        case TypeKind::kError:
+            return "<error>";
+        case TypeKind::kVoid:
+            return "void";
+        case TypeKind::kBool:
+            return "bool";
+        case TypeKind::kChar:
+            return "char";
+        case TypeKind::kInt:
+            return "int";
+        case TypeKind::kLong:
+            return "long";
+        case TypeKind::kFloat:
+            return "float";
+        case TypeKind::kDouble:
+            return "double";
+        case TypeKind::kString:
+            return "string";
+        case TypeKind::kObject:
+            return "object";
+        case TypeKind::kNull:
+            return "<null>";
+        case TypeKind::kClass:
+            return type->cls->qualified_name;
+        case TypeKind::kArray:
+            return TypeToString(type->element) + "[]";
+        case TypeKind::kTask:
+            return type->element->kind == TypeKind::kVoid ? "Task" : "Task<" + TypeToString(type->element) + ">";
+        case TypeKind::kExternal:
+            return std::string(type->name);
+        default:
+            return "<unknown>";
+        }
+    }
+
+}
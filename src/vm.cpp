@@ -0,0 +1,1423 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include "vm.h"
+#include "sema.h"
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if defined(__GNUC__) && !defined(TINYCSHARP_VM_SWITCH_DISPATCH)
+#define TINYCSHARP_VM_THREADED 1
+#else
+#define TINYCSHARP_VM_THREADED 0
+#endif
+
+namespace tinycsharp
+{
+    namespace
+    {
+        const char *const kNullReference = "System.NullReferenceException";
+        const char *const kNullReferenceMessage = "Object reference not set to an instance of an object.";
+        const char *const kIndexOutOfRange = "System.IndexOutOfRangeException";
+        const char *const kIndexOutOfRangeMessage = "Index was outside the bounds of the array.";
+        const char *const kOverflow = "System.OverflowException";
+        const char *const kOverflowMessage = "Arithmetic operation resulted in an overflow.";
+        const char *const kInvalidCast = "System.InvalidCastException";
+
+        // concatenations up to this long are copied; longer ones share
+        // their operands in a rope.
+        constexpr std::size_t kFlatConcatBytes = 64;
+
+        inline std::uint64_t U(std::int64_t v) { return static_cast<std::uint64_t>(v); }
+        inline std::int64_t I32(std::uint64_t v) { return static_cast<std::int32_t>(static_cast<std::uint32_t>(v)); }
+        inline std::int64_t I64(std::uint64_t v) { return static_cast<std::int64_t>(v); }
+
+        // the addition of the fused read-modify-write ops; the compiler
+        // only fuses i32, i64 and f64 additions.
+        inline void AddTo(Value &slot, Value x, IrType type)
+        {
+            if (type == IrType::kI32)
+                slot.i = I32(U(slot.i) + U(x.i));
+            else if (type == IrType::kI64)
+                slot.i = I64(U(slot.i) + U(x.i));
+            else
+                slot.d += x.d;
+        }
+
+        // C# composite formatting of already stringified arguments: {n} is
+        // replaced by argument n, {{ and }} are literal braces.
+        std::string Format(std::string_view format, const std::vector<std::string_view> &args)
+        {
+            std::string out;
+            for (std::size_t i = 0; i < format.size(); i++)
+            {
+                char c = format[i];
+                if ((c == '{' || c == '}') && i + 1 < format.size() && format[i + 1] == c)
+                {
+                    out += c;
+                    i++;
+                    continue;
+                }
+                if (c == '{')
+                {
+                    std::size_t close = format.find('}', i);
+                    if (close != std::string_view::npos)
+                    {
+                        std::size_t index = 0;
+                        bool numeric = close > i + 1;
+                        for (std::size_t j = i + 1; j < close && numeric; j++)
+                        {
+                            numeric = format[j] >= '0' && format[j] <= '9';
+                            index = index * 10 + static_cast<std::size_t>(format[j] - '0');
+                        }
+                        if (numeric && index < args.size())
+                        {
+                            out += args[index];
+                            i = close;
+                            continue;
+                        }
+                    }
+                }
+                out += c;
+            }
+            return out;
+        }
+    }
+
+    VmError::VmError(std::string type, std::string message, std::string trace)
+        : std::runtime_error("Unhandled exception. " + type + ": " + message + trace),
+          type_(std::move(type)), message_(std::move(message))
+    {
+    }
+
+    Vm::Vm(const BcProgram &program, std::ostream &out) : Vm(program, out, Options{}) {}
+
+    Vm::Vm(const BcProgram &program, std::ostream &out, Options options)
+        : program_(program), out_(out), options_(options),
+          heap_(std::make_unique<Heap>(program_, options.gc_threshold)),
+          stack_(std::make_unique<Value[]>(options.stack_values)),
+          statics_(program_.num_statics, IntValue(0)),
+          strings_(program_.strings),
+          inline_caches_(program_.num_call_sites),
+          jit_state_(program_.functions.size())
+    {
+        if (options_.jit && !options_.profiler && Jit::Supported())
+            jit_ = std::make_unique<Jit>(*heap_, strings_, statics_.data());
+        heap_->SetRoots([this](const Heap::RootVisitor &visit)
+                        { VisitRoots(visit); });
+    }
+
+    Vm::~Vm()
+    {
+        RetireScheduler();
+    }
+
+    const JitFunction *Vm::HotNative(const BcFunction *fn)
+    {
+        JitState &state = jit_state_[static_cast<std::size_t>(fn - program_.functions.data())];
+        if (state.code || state.hotness >= options_.jit_threshold)
+            return state.code.get();
+        if (++state.hotness == options_.jit_threshold)
+        {
+            state.code = jit_->Compile(*fn);
+            if (state.code)
+                stats_.jit_functions++;
+        }
+        return state.code.get();
+    }
+
+    bool Vm::ThreadedDispatch()
+    {
+        return TINYCSHARP_VM_THREADED != 0;
+    }
+
+    void Vm::VisitRoots(const Heap::RootVisitor &visit)
+    {
+        for (Frame &frame : frames_)
+        {
+            if (frame.machine)
+                visit(frame.machine);
+            if (!frame.pc)
+                continue;
+            const BcStackMap *map = frame.fn->FindStackMap(static_cast<std::uint32_t>(frame.pc - frame.fn->code.data()));
+            if (!map)
+                continue;
+            const std::uint16_t *registers = frame.fn->stack_map_registers.data() + map->first;
+            for (std::uint32_t i = 0; i < map->count; i++)
+                visit(frame.regs[registers[i]].ref);
+        }
+        for (std::uint32_t slot : program_.ref_statics)
+            visit(statics_[slot].ref);
+        for (Object *&temp : temp_roots_)
+            visit(temp);
+        if (completed_task_)
+            visit(completed_task_);
+        for (Object *&pinned : pinned_)
+        {
+            if (pinned)
+                visit(pinned);
+        }
+    }
+
+    void Vm::RunStaticInitializers()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (program_.static_init >= 0)
+            Call(static_cast<std::uint32_t>(program_.static_init), {});
+    }
+
+    int Vm::Run()
+    {
+        if (program_.entry < 0)
+        {
+            throw std::runtime_error("program has no static Main method");
+        }
+        const BcFunction &main = program_.functions[program_.entry];
+        std::unique_lock<std::mutex> lock(mutex_);
+        Value result;
+        try
+        {
+            if (program_.static_init >= 0)
+                Call(static_cast<std::uint32_t>(program_.static_init), {});
+            std::vector<Value> args;
+            if (main.num_params == 1)
+                args.push_back(RefValue(heap_->NewArray(IrType::kRef, 0)));
+            result = Call(static_cast<std::uint32_t>(program_.entry), args);
+            if (main.return_type == IrType::kRef && result.ref && result.ref->kind == ObjectKind::kTask && !result.ref->info)
+            {
+                // an async Main that suspended: wait for its task while the
+                // scheduler runs the continuations.
+                std::uint32_t pin = Pin(result.ref);
+                while (!pinned_[pin]->info)
+                {
+                    if (failure_)
+                        std::rethrow_exception(failure_);
+                    if (!scheduler_ || scheduler_->Outstanding() == 0)
+                        throw VmError("System.InvalidOperationException", "The awaited task never completes.", "");
+                    progress_.wait_for(lock, std::chrono::milliseconds(10));
+                }
+                result = RefValue(Unpin(pin));
+            }
+        }
+        catch (...)
+        {
+            lock.unlock();
+            RetireScheduler();
+            throw;
+        }
+        lock.unlock();
+        RetireScheduler();
+        if (main.return_type == IrType::kI32)
+            return static_cast<int>(result.i);
+        if (main.return_type == IrType::kRef && result.ref && result.ref->kind == ObjectKind::kTask)
+        {
+            Object *value = TaskOf(result.ref)->result;
+            if (value && value->kind == ObjectKind::kBox && value->type == IrType::kI32)
+                return static_cast<int>(Payload(value)[0].i);
+        }
+        return 0;
+    }
+
+    Value Vm::Invoke(std::uint32_t function, const std::vector<Value> &args)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return Call(function, args);
+    }
+
+    Value Vm::Call(std::uint32_t function, const std::vector<Value> &args)
+    {
+        const BcFunction *fn = &program_.functions.at(function);
+        if (fn->code.empty())
+        {
+            throw std::runtime_error(fn->name + " has no body");
+        }
+        if (args.size() != fn->num_params)
+        {
+            throw std::runtime_error(fn->name + " takes " + std::to_string(fn->num_params) + " arguments");
+        }
+        frames_.clear();
+        Value *regs = stack_.get();
+        std::memset(static_cast<void *>(regs), 0, sizeof(Value) * fn->num_registers);
+        for (std::size_t i = 0; i < args.size(); i++)
+            regs[i] = args[i];
+        return Execute(fn, regs);
+    }
+
+    std::string Vm::StackTrace(const BcFunction *fn, const BcInst *pc) const
+    {
+        std::string trace;
+        auto line = [&](const BcFunction *f, const BcInst *at)
+        {
+            std::size_t index = static_cast<std::size_t>(at - f->code.data());
+            trace += "\n   at " + f->name + ":line " + std::to_string(index < f->lines.size() ? f->lines[index] : 0);
+        };
+        line(fn, pc);
+        int shown = 1;
+        for (std::size_t k = frames_.size(); k-- > 1 && shown < 32; shown++)
+        {
+            if (!frames_[k].return_pc)
+                break;
+            line(frames_[k - 1].fn, frames_[k].return_pc - 1);
+        }
+        return trace;
+    }
+
+    void Vm::Profile(const BcFunction *fn, const BcInst *ip, bool exact)
+    {
+        Profiler &profiler = *options_.profiler;
+        std::uint64_t weight = exact ? 1 : Profiler::TakeTicks();
+        if (!weight)
+            return;
+        // brings the profiler's path in line with the frames. between two
+        // dispatches a call or return changes only the top of the stack, so
+        // an exact profile looks down from there to the first frame it
+        // still has; a sample, taken long after the last one, compares
+        // them all from the bottom.
+        std::size_t depth = frames_.size();
+        std::size_t keep = std::min(profiler.depth(), depth);
+        if (exact)
+        {
+            while (keep && profiler.FunctionAt(keep - 1) != frames_[keep - 1].fn)
+                keep--;
+        }
+        else
+        {
+            std::size_t same = 0;
+            while (same < keep && profiler.FunctionAt(same) == frames_[same].fn)
+                same++;
+            keep = same;
+        }
+        if (keep != profiler.depth() || keep != depth)
+        {
+            profiler.Truncate(keep);
+            for (std::size_t k = keep; k < depth; k++)
+                profiler.Enter(frames_[k].fn);
+        }
+        profiler.Count(fn, ip, weight);
+    }
+
+    void Vm::Fault(const BcFunction *fn, const BcInst *pc, const char *type, const std::string &message)
+    {
+        throw VmError(type, message, StackTrace(fn, pc));
+    }
+
+    void Vm::Throw(const BcFunction *fn, const BcInst *pc, Object *exception)
+    {
+        if (!exception)
+            Fault(fn, pc, kNullReference, kNullReferenceMessage);
+        if (exception->kind == ObjectKind::kExternal)
+        {
+            ExternalPayload *payload = External(exception);
+            std::string message = payload->message ? StringText(payload->message)
+                                                   : "Exception of type '" + ObjectTypeName(exception, program_) + "' was thrown.";
+            Fault(fn, pc, ObjectTypeName(exception, program_).c_str(), message);
+        }
+        std::string type = ObjectTypeName(exception, program_);
+        Fault(fn, pc, type.c_str(), "Exception of type '" + type + "' was thrown.");
+    }
+
+    // the slow path of a virtual call: a probe of the site's other entries,
+    // then a vtable lookup that is remembered while the cache has room.
+    std::uint32_t Vm::ResolveVirtual(InlineCache &cache, std::uint32_t cls, std::uint32_t slot)
+    {
+        std::uint32_t target = program_.classes[cls].vtable[slot];
+        if (cache.megamorphic)
+        {
+            stats_.megamorphic_calls++;
+            return target;
+        }
+        for (std::uint32_t i = 1; i < cache.size; i++)
+        {
+            if (cache.classes[i] == cls)
+            {
+                stats_.polymorphic_hits++;
+                return cache.targets[i];
+            }
+        }
+        if (cache.size == InlineCache::kEntries)
+        {
+            cache.megamorphic = true;
+            stats_.megamorphic_calls++;
+            return target;
+        }
+        cache.classes[cache.size] = cls;
+        cache.targets[cache.size] = target;
+        cache.size++;
+        stats_.inline_cache_misses++;
+        return target;
+    }
+
+    Value Vm::Box(IrType type, Value value)
+    {
+        return RefValue(heap_->NewBox(type, value));
+    }
+
+    Value Vm::Convert(const BcFunction *fn, const BcInst *pc, Value value)
+    {
+        IrType to = pc->type;
+        IrType from = static_cast<IrType>(pc->c);
+        if (to == IrType::kRef)
+        {
+            return from == IrType::kRef ? value : Box(from, value);
+        }
+        if (from == IrType::kRef)
+        {
+            Object *object = value.ref;
+            if (!object)
+                Fault(fn, pc, kNullReference, kNullReferenceMessage);
+            if (object->kind != ObjectKind::kBox || object->type != to)
+                Fault(fn, pc, kInvalidCast, "Unable to cast object of type '" + ObjectTypeName(object, program_) +
+                                                "' to type '" + ClrTypeName(to) + "'.");
+            return Payload(object)[0];
+        }
+        return ConvertPrimitive(value, from, to);
+    }
+
+    Object *Vm::ToString(Value value, IrType type)
+    {
+        if (type == IrType::kChar)
+            return strings_.Char(static_cast<unsigned char>(value.i));
+        if (type != IrType::kRef)
+            return heap_->NewString(FormatValue(value, type));
+        if (!value.ref)
+            return strings_.Empty();
+        if (IsString(value.ref))
+            return value.ref;
+        return heap_->NewString(FormatObject(value.ref, program_));
+    }
+
+    // short results are copied flat; longer ones become a rope, so that
+    // building a string with += in a loop stays linear.
+    Object *Vm::Concat(Object *a, Object *b)
+    {
+        if (!a || a->info == 0)
+            return b ? b : strings_.Empty();
+        if (!b || b->info == 0)
+            return a;
+        std::size_t length = static_cast<std::size_t>(a->info) + b->info;
+        if (length > kFlatConcatBytes)
+            return heap_->NewRope(a, b);
+        // the allocation may move both operands.
+        temp_roots_.push_back(a);
+        temp_roots_.push_back(b);
+        Object *s = heap_->NewString(length);
+        b = temp_roots_.back();
+        temp_roots_.pop_back();
+        a = temp_roots_.back();
+        temp_roots_.pop_back();
+        CopyText(a, StringData(s));
+        CopyText(b, StringData(s) + a->info);
+        return s;
+    }
+
+    // gives a rope its flat text, once; later reads go straight to it.
+    Object *Vm::Flatten(Object *s)
+    {
+        if (IsFlat(s))
+            return s->kind == ObjectKind::kRope ? Rope(s)->left : s;
+        temp_roots_.push_back(s);
+        Object *flat = heap_->NewString(static_cast<std::size_t>(s->info));
+        s = temp_roots_.back();
+        temp_roots_.pop_back();
+        CopyText(s, StringData(flat));
+        Rope(s)->left = flat;
+        Rope(s)->right = nullptr;
+        heap_->WriteBarrier(s, flat);
+        return flat;
+    }
+
+    Object *Vm::CompletedTask()
+    {
+        if (!completed_task_)
+            completed_task_ = heap_->NewTask(true, nullptr);
+        return completed_task_;
+    }
+
+    Object *Vm::PendingTask(std::chrono::milliseconds delay)
+    {
+        Object *task = heap_->NewTask(false, nullptr);
+        std::uint32_t pin = Pin(task);
+        auto complete = [this, pin, epoch = async_epoch_]
+        {
+            RunJob(epoch, [&]
+                   { CompleteTask(Unpin(pin), nullptr); });
+        };
+        if (delay.count() > 0)
+            Scheduler().SubmitAfter(delay, complete);
+        else
+            Scheduler().Submit(complete);
+        return task;
+    }
+
+    // the slow path of await, for a task still running: the call suspends.
+    // its live registers are saved in its state machine, created on the
+    // call's first suspension together with the Task the call returns,
+    // and the machine waits on the task. returns the call's Task.
+    Object *Vm::Suspend(const BcFunction *fn, const BcInst *pc, Value *regs)
+    {
+        Object *task = regs[pc->b].ref;
+        if (!task)
+            Fault(fn, pc, kNullReference, kNullReferenceMessage);
+        if (task->kind != ObjectKind::kTask)
+            Fault(fn, pc, kInvalidCast, "Unable to cast object of type '" + ObjectTypeName(task, program_) +
+                                            "' to type 'System.Threading.Tasks.Task'.");
+        const BcAwaitPoint *point = fn->FindAwaitPoint(static_cast<std::uint32_t>(pc - fn->code.data()));
+        Object *machine = frames_.back().machine;
+        if (!machine)
+        {
+            temp_roots_.push_back(heap_->NewTask(false, nullptr));
+            machine = heap_->NewStateMachine(static_cast<std::uint32_t>(fn - program_.functions.data()));
+            StateMachine(machine)->task = temp_roots_.back();
+            temp_roots_.pop_back();
+            heap_->WriteBarrier(machine, StateMachine(machine)->task);
+            // the allocations may have moved the task.
+            task = regs[pc->b].ref;
+        }
+        StateMachine(machine)->await = point - fn->await_points.data();
+        const std::uint16_t *saved = fn->await_registers.data() + point->first;
+        for (std::uint32_t i = 0; i < point->count; i++)
+        {
+            SavedRegisters(machine)[i] = regs[saved[i]];
+            if (i < point->refs)
+                heap_->WriteBarrier(machine, regs[saved[i]].ref);
+        }
+        StateMachine(machine)->next = TaskOf(task)->waiters;
+        heap_->WriteBarrier(machine, StateMachine(machine)->next);
+        TaskOf(task)->waiters = machine;
+        heap_->WriteBarrier(task, machine);
+        stats_.suspensions++;
+        return StateMachine(machine)->task;
+    }
+
+    // runs a suspended call from its await, which finds the task completed
+    // now, until the call returns or suspends again. a call that returns
+    // completes its own Task with its result.
+    void Vm::Resume(Object *machine)
+    {
+        frames_.clear();
+        temp_roots_.clear();
+        const BcFunction *fn = &program_.functions[machine->info];
+        const BcAwaitPoint &point = fn->await_points[StateMachine(machine)->await];
+        Value *regs = stack_.get();
+        std::memset(static_cast<void *>(regs), 0, sizeof(Value) * fn->num_registers);
+        const std::uint16_t *saved = fn->await_registers.data() + point.first;
+        for (std::uint32_t i = 0; i < point.count; i++)
+            regs[saved[i]] = SavedRegisters(machine)[i];
+        stats_.resumptions++;
+        temp_roots_.push_back(machine);
+        Value result = Execute(fn, regs, fn->code.data() + point.pc, machine);
+        machine = temp_roots_.back();
+        temp_roots_.pop_back();
+        if (suspended_)
+            return;
+        Object *value = nullptr;
+        if (fn->return_type == IrType::kRef && result.ref && result.ref->kind == ObjectKind::kTask)
+            value = TaskOf(result.ref)->result;
+        CompleteTask(StateMachine(machine)->task, value);
+    }
+
+    // completes a pending task and schedules the calls waiting on it, in
+    // the order they started waiting.
+    void Vm::CompleteTask(Object *task, Object *result)
+    {
+        task->info = 1;
+        TaskOf(task)->result = result;
+        heap_->WriteBarrier(task, result);
+        Object *waiters = nullptr;
+        for (Object *machine = TaskOf(task)->waiters; machine;)
+        {
+            Object *next = StateMachine(machine)->next;
+            StateMachine(machine)->next = waiters;
+            waiters = machine;
+            machine = next;
+        }
+        TaskOf(task)->waiters = nullptr;
+        while (waiters)
+        {
+            Object *machine = waiters;
+            waiters = StateMachine(machine)->next;
+            StateMachine(machine)->next = nullptr;
+            std::uint32_t pin = Pin(machine);
+            Scheduler().Submit([this, pin, epoch = async_epoch_]
+                               { RunJob(epoch, [&]
+                                        { Resume(Unpin(pin)); }); });
+        }
+    }
+
+    TaskScheduler &Vm::Scheduler()
+    {
+        if (!scheduler_)
+            scheduler_ = std::make_unique<TaskScheduler>(options_.async_workers);
+        return *scheduler_;
+    }
+
+    void Vm::RunJob(std::uint64_t epoch, const std::function<void()> &job)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (epoch != async_epoch_ || failure_)
+            return;
+        try
+        {
+            job();
+        }
+        catch (...)
+        {
+            failure_ = std::current_exception();
+        }
+        // the worker's allocations count before another thread reads the
+        // stats.
+        heap_->FlushTlab();
+        progress_.notify_all();
+    }
+
+    // stops running continuations; the ones still queued or waiting on a
+    // timer are dropped, as when a process exits with tasks outstanding.
+    void Vm::RetireScheduler()
+    {
+        std::unique_ptr<TaskScheduler> scheduler;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            async_epoch_++;
+            scheduler = std::move(scheduler_);
+            pinned_.clear();
+            free_pins_.clear();
+            failure_ = nullptr;
+        }
+        // jobs already running finish, or find their epoch retired, first.
+        scheduler.reset();
+    }
+
+    std::uint32_t Vm::Pin(Object *object)
+    {
+        if (free_pins_.empty())
+        {
+            pinned_.push_back(object);
+            return static_cast<std::uint32_t>(pinned_.size() - 1);
+        }
+        std::uint32_t pin = free_pins_.back();
+        free_pins_.pop_back();
+        pinned_[pin] = object;
+        return pin;
+    }
+
+    Object *Vm::Unpin(std::uint32_t pin)
+    {
+        Object *object = pinned_[pin];
+        pinned_[pin] = nullptr;
+        free_pins_.push_back(pin);
+        return object;
+    }
+
+    Value Vm::CallBuiltin(const BcFunction *fn, const BcInst *pc, Value *regs)
+    {
+        auto arg = [&](std::uint32_t i) -> Value
+        { return regs[CallArgument(pc, i)]; };
+        auto text = [&](std::uint32_t i) -> std::string_view
+        {
+            Object *s = arg(i).ref;
+            return s ? StringView(s) : std::string_view();
+        };
+        std::uint32_t argc = pc->b;
+        // text reads strings in place, so the ropes among them are
+        // flattened first: no allocation may move a string once read.
+        auto flatten_strings = [&]()
+        {
+            for (std::uint32_t i = 0; i < argc; i++)
+            {
+                Object *s = arg(i).ref;
+                if (s && s->kind == ObjectKind::kRope)
+                    Flatten(s);
+            }
+        };
+        Value result = IntValue(0);
+        switch (static_cast<Builtin>(pc->c))
+        {
+        case Builtin::kConsoleWrite:
+        case Builtin::kConsoleWriteLine:
+        {
+            flatten_strings();
+            if (argc == 1)
+            {
+                std::string_view s = text(0);
+                out_.write(s.data(), static_cast<std::streamsize>(s.size()));
+            }
+            else if (argc > 1)
+            {
+                std::vector<std::string_view> args;
+                for (std::uint32_t i = 1; i < argc; i++)
+                    args.push_back(text(i));
+                out_ << Format(text(0), args);
+            }
+            if (static_cast<Builtin>(pc->c) == Builtin::kConsoleWriteLine)
+                out_.put('\n');
+            return result;
+        }
+        case Builtin::kMathAbs:
+            switch (pc->type)
+            {
+            case IrType::kI32:
+            case IrType::kI64:
+            {
+                std::int64_t v = arg(0).i;
+                std::int64_t min = pc->type == IrType::kI32 ? std::numeric_limits<std::int32_t>::min()
+                                                            : std::numeric_limits<std::int64_t>::min();
+                if (v == min)
+                    Fault(fn, pc, kOverflow, "Negating the minimum value of a twos complement number is invalid.");
+                result.i = v < 0 ? -v : v;
+                return result;
+            }
+            case IrType::kF32:
+                result.f = std::fabs(arg(0).f);
+                return result;
+            default:
+                result.d = std::fabs(arg(0).d);
+                return result;
+            }
+        case Builtin::kMathMax:
+        case Builtin::kMathMin:
+        {
+            bool max = static_cast<Builtin>(pc->c) == Builtin::kMathMax;
+            Value a = arg(0);
+            Value b = arg(1);
+            switch (pc->type)
+            {
+            case IrType::kF32:
+                result.f = std::isnan(a.f) || std::isnan(b.f) ? std::numeric_limits<float>::quiet_NaN()
+                                                              : (max ? std::fmax(a.f, b.f) : std::fmin(a.f, b.f));
+                return result;
+            case IrType::kF64:
+                result.d = std::isnan(a.d) || std::isnan(b.d) ? std::numeric_limits<double>::quiet_NaN()
+                                                              : (max ? std::fmax(a.d, b.d) : std::fmin(a.d, b.d));
+                return result;
+            default:
+                result.i = max ? std::max(a.i, b.i) : std::min(a.i, b.i);
+                return result;
+            }
+        }
+        case Builtin::kMathSqrt:
+            result.d = std::sqrt(arg(0).d);
+            return result;
+        case Builtin::kTaskFromResult:
+            return RefValue(heap_->NewTask(true, arg(0).ref));
+        case Builtin::kTaskDelay:
+            if (arg(0).i > 0)
+                return RefValue(PendingTask(std::chrono::milliseconds(arg(0).i)));
+            return RefValue(CompletedTask());
+        case Builtin::kTaskYield:
+            return RefValue(PendingTask(std::chrono::milliseconds(0)));
+        case Builtin::kTaskCompleted:
+            return RefValue(CompletedTask());
+        case Builtin::kNone:
+        {
+            flatten_strings();
+            std::string_view name = argc > 0 ? text(0) : std::string_view("?");
+            if (name.substr(0, 4) != "new ")
+                Fault(fn, pc, "System.MissingMethodException", "Method not found: '" + std::string(name) + "'.");
+            // an instance of a library type. only exceptions are useful
+            // here: they keep their type name and message for Throw.
+            std::string type(name.substr(4));
+            if (type.find('.') == std::string::npos)
+                type = "System." + type;
+            temp_roots_.push_back(heap_->NewString(type));
+            Object *object = heap_->NewExternal();
+            External(object)->name = temp_roots_.back();
+            temp_roots_.pop_back();
+            Object *message = argc > 1 ? arg(1).ref : nullptr;
+            if (message && IsString(message))
+                External(object)->message = message;
+            heap_->WriteBarrier(object, External(object)->name);
+            heap_->WriteBarrier(object, message);
+            return RefValue(object);
+        }
+        default:
+            Fault(fn, pc, "System.NotSupportedException", std::string(BuiltinToString(static_cast<Builtin>(pc->c))) + " is not supported.");
+        }
+    }
+
+    Value Vm::Execute(const BcFunction *fn, Value *regs, const BcInst *start, Object *machine)
+    {
+        const std::size_t base = frames_.size();
+        frames_.push_back(Frame{fn, regs, nullptr, kNoRegister, nullptr, machine});
+        const BcInst *code = fn->code.data();
+        const BcInst *ip = start ? start : code;
+        bool suspending = false;
+        const std::int64_t *constants = fn->constants.data();
+        Value *statics = statics_.data();
+        Value *const stack_end = stack_.get() + options_.stack_values;
+        const BcFunction *callee = nullptr;
+        Value result = IntValue(0);
+        std::uint64_t count = 0;
+        std::uint64_t calls = 0;
+        std::uint64_t quickened = 0;
+        const bool quicken = options_.quicken;
+        InlineCache *const caches = inline_caches_.data();
+        const BcFunction *const functions = program_.functions.data();
+        std::uint64_t monomorphic_hits = 0;
+        std::uint64_t polymorphic_hits = 0;
+        const JitFunction *native = nullptr;
+        std::uint64_t native_entries = 0;
+        Profiler *const profiler = options_.profiler;
+        const bool exact = profiler && profiler->mode() == Profiler::Mode::kExact;
+
+#define R(field) regs[ip->field]
+
+#if TINYCSHARP_VM_THREADED
+        static const void *const kHandlers[] = {
+#define TINYCSHARP_VM_LABEL(Name) &&op_##Name,
+            TINYCSHARP_BC_OPS(TINYCSHARP_VM_LABEL)
+#undef TINYCSHARP_VM_LABEL
+        };
+        // a profiled run sends every dispatch through the profile label on
+        // its way to the handler, so the others pay nothing for it.
+        static const void *const kProfiled[] = {
+#define TINYCSHARP_VM_PROFILED(Name) &&profile,
+            TINYCSHARP_BC_OPS(TINYCSHARP_VM_PROFILED)
+#undef TINYCSHARP_VM_PROFILED
+        };
+        const void *const *const handlers = profiler ? kProfiled : kHandlers;
+#endif
+// counts the dispatch in an exact profile, or takes a sample once the
+// timer has ticked.
+#define VM_PROFILE()                                      \
+    do                                                    \
+    {                                                     \
+        if (exact || Profiler::Pending())                 \
+            Profile(fn, ip, exact);                       \
+    } while (0)
+#if TINYCSHARP_VM_THREADED
+#define VM_CASE(Name) op_##Name:
+#define VM_DISPATCH()                                             \
+    do                                                            \
+    {                                                             \
+        ++count;                                                  \
+        goto *handlers[static_cast<std::uint8_t>(ip->op)];        \
+    } while (0)
+#else
+#define VM_CASE(Name) case BcOp::k##Name:
+#define VM_DISPATCH() goto dispatch
+#endif
+#define VM_NEXT()     \
+    do                \
+    {                 \
+        ++ip;         \
+        VM_DISPATCH(); \
+    } while (0)
+#define VM_FAULT(type, message) Fault(fn, ip, type, message)
+// records where the frame is before an instruction that may collect.
+#define VM_SAFEPOINT() frames_.back().pc = ip
+// rewrites a generic instruction to its typed variant and runs that. the
+// code belongs to this Vm's copy of the program, so the cast is sound.
+#define VM_QUICKEN()                                   \
+    do                                                 \
+    {                                                  \
+        BcOp quick = quicken ? QuickenedOp(*ip) : ip->op; \
+        if (quick != ip->op)                           \
+        {                                              \
+            const_cast<BcInst *>(ip)->op = quick;      \
+            quickened++;                               \
+            VM_DISPATCH();                             \
+        }                                              \
+    } while (0)
+#define VM_SIMPLE(Name, statement) \
+    VM_CASE(Name)                  \
+    {                              \
+        statement;                 \
+        VM_NEXT();                 \
+    }
+#define VM_INT_DIVIDE(Name, op, Min)                                               \
+    VM_CASE(Name)                                                                  \
+    {                                                                              \
+        std::int64_t x = R(b).i;                                                   \
+        std::int64_t y = R(c).i;                                                   \
+        if (y == 0)                                                                \
+            VM_FAULT("System.DivideByZeroException", "Attempted to divide by zero."); \
+        if (y == -1 && x == std::numeric_limits<Min>::min())                       \
+            VM_FAULT(kOverflow, kOverflowMessage);                                 \
+        R(a).i = x op y;                                                           \
+        VM_NEXT();                                                                 \
+    }
+// counts a call or back edge into fn at ip, and goes on in native code
+// from there once fn has some.
+#define VM_HOT()                                   \
+    do                                             \
+    {                                              \
+        if (jit_ && (native = HotNative(fn)))      \
+            goto native_entry;                     \
+        VM_DISPATCH();                             \
+    } while (0)
+// jumps to target, counting it when it goes backwards.
+#define VM_JUMP(target)                            \
+    do                                             \
+    {                                              \
+        const BcInst *to = (target);               \
+        bool back = to <= ip;                      \
+        ip = to;                                   \
+        if (back)                                  \
+            VM_HOT();                              \
+        VM_DISPATCH();                             \
+    } while (0)
+#define VM_JUMP_IF(Name, op)                                   \
+    VM_CASE(Name)                                              \
+    {                                                          \
+        if (R(a).i op R(b).i)                                  \
+            VM_JUMP(code + ip[1].Wide());                      \
+        ip += 2;                                               \
+        VM_DISPATCH();                                         \
+    }
+
+#define VM_ARITH(Name, op)                                  \
+    VM_CASE(Name)                                           \
+    {                                                       \
+        VM_QUICKEN();                                       \
+        switch (ip->type)                                   \
+        {                                                   \
+        case IrType::kI32:                                  \
+            R(a).i = I32(U(R(b).i) op U(R(c).i));           \
+            break;                                          \
+        case IrType::kI64:                                  \
+            R(a).i = I64(U(R(b).i) op U(R(c).i));           \
+            break;                                          \
+        case IrType::kF32:                                  \
+            R(a).f = R(b).f op R(c).f;                      \
+            break;                                          \
+        default:                                            \
+            R(a).d = R(b).d op R(c).d;                      \
+            break;                                          \
+        }                                                   \
+        VM_NEXT();                                          \
+    }
+#define VM_BITWISE(Name, op)              \
+    VM_CASE(Name)                         \
+    {                                     \
+        R(a).i = R(b).i op R(c).i;        \
+        VM_NEXT();                        \
+    }
+#define VM_COMPARE(Name, op)              \
+    VM_CASE(Name)                         \
+    {                                     \
+        VM_QUICKEN();                     \
+        bool r;                           \
+        switch (ip->type)                 \
+        {                                 \
+        case IrType::kF32:                \
+            r = R(b).f op R(c).f;         \
+            break;                        \
+        case IrType::kF64:                \
+            r = R(b).d op R(c).d;         \
+            break;                        \
+        default:                          \
+            r = R(b).i op R(c).i;         \
+            break;                        \
+        }                                 \
+        R(a).i = r;                       \
+        VM_NEXT();                        \
+    }
+
+#if TINYCSHARP_VM_THREADED
+        VM_HOT();
+#else
+        if (jit_ && (native = HotNative(fn)))
+            goto native_entry;
+    dispatch:
+        ++count;
+        if (profiler)
+            VM_PROFILE();
+        switch (ip->op)
+        {
+#endif
+        VM_CASE(Nop)
+        {
+            VM_NEXT();
+        }
+        VM_CASE(Move)
+        {
+            R(a) = R(b);
+            VM_NEXT();
+        }
+        VM_CASE(LoadK)
+        {
+            R(a).i = constants[ip->Wide()];
+            VM_NEXT();
+        }
+        VM_CASE(LoadStr)
+        {
+            R(a) = RefValue(strings_.Literal(ip->Wide()));
+            VM_NEXT();
+        }
+        VM_CASE(LoadNull)
+        {
+            R(a).i = 0;
+            VM_NEXT();
+        }
+        VM_ARITH(Add, +)
+        VM_ARITH(Sub, -)
+        VM_ARITH(Mul, *)
+        VM_CASE(Div)
+        VM_CASE(Rem)
+        {
+            VM_QUICKEN();
+            bool div = ip->op == BcOp::kDiv;
+            switch (ip->type)
+            {
+            case IrType::kF32:
+                R(a).f = div ? R(b).f / R(c).f : std::fmod(R(b).f, R(c).f);
+                break;
+            case IrType::kF64:
+                R(a).d = div ? R(b).d / R(c).d : std::fmod(R(b).d, R(c).d);
+                break;
+            default:
+            {
+                std::int64_t x = R(b).i;
+                std::int64_t y = R(c).i;
+                if (y == 0)
+                    VM_FAULT("System.DivideByZeroException", "Attempted to divide by zero.");
+                std::int64_t min = ip->type == IrType::kI32 ? std::numeric_limits<std::int32_t>::min()
+                                                            : std::numeric_limits<std::int64_t>::min();
+                if (y == -1 && x == min)
+                    VM_FAULT(kOverflow, kOverflowMessage);
+                R(a).i = div ? x / y : x % y;
+                break;
+            }
+            }
+            VM_NEXT();
+        }
+        VM_BITWISE(And, &)
+        VM_BITWISE(Or, |)
+        VM_BITWISE(Xor, ^)
+        VM_CASE(Shl)
+        {
+            VM_QUICKEN();
+            if (ip->type == IrType::kI32)
+                R(a).i = I32(U(R(b).i) << (R(c).i & 31));
+            else
+                R(a).i = I64(U(R(b).i) << (R(c).i & 63));
+            VM_NEXT();
+        }
+        VM_CASE(Shr)
+        {
+            VM_QUICKEN();
+            R(a).i = R(b).i >> (R(c).i & (ip->type == IrType::kI32 ? 31 : 63));
+            VM_NEXT();
+        }
+        VM_CASE(Neg)
+        {
+            VM_QUICKEN();
+            switch (ip->type)
+            {
+            case IrType::kI32:
+                R(a).i = I32(0 - U(R(b).i));
+                break;
+            case IrType::kI64:
+                R(a).i = I64(0 - U(R(b).i));
+                break;
+            case IrType::kF32:
+                R(a).f = -R(b).f;
+                break;
+            default:
+                R(a).d = -R(b).d;
+                break;
+            }
+            VM_NEXT();
+        }
+        VM_CASE(Not)
+        {
+            R(a).i = ip->type == IrType::kBool ? R(b).i ^ 1 : ~R(b).i;
+            VM_NEXT();
+        }
+        VM_COMPARE(Eq, ==)
+        VM_COMPARE(Ne, !=)
+        VM_COMPARE(Lt, <)
+        VM_COMPARE(Le, <=)
+        VM_COMPARE(Gt, >)
+        VM_COMPARE(Ge, >=)
+        VM_CASE(Convert)
+        {
+            VM_QUICKEN();
+            VM_SAFEPOINT();
+            R(a) = Convert(fn, ip, R(b));
+            VM_NEXT();
+        }
+        VM_CASE(StrEq)
+        {
+            Object *x = R(b).ref;
+            Object *y = R(c).ref;
+            if (x == y || !x || !y || x->info != y->info)
+            {
+                R(a).i = x == y;
+                VM_NEXT();
+            }
+            VM_SAFEPOINT();
+            Flatten(x);
+            Flatten(R(c).ref);
+            R(a).i = StringView(R(b).ref) == StringView(R(c).ref);
+            VM_NEXT();
+        }
+        VM_CASE(Concat)
+        {
+            VM_SAFEPOINT();
+            R(a) = RefValue(Concat(R(b).ref, R(c).ref));
+            VM_NEXT();
+        }
+        VM_CASE(ToString)
+        {
+            VM_SAFEPOINT();
+            R(a) = RefValue(ToString(R(b), static_cast<IrType>(ip->c)));
+            VM_NEXT();
+        }
+        VM_CASE(GetField)
+        {
+            Object *object = R(b).ref;
+            if (!object)
+                VM_FAULT(kNullReference, kNullReferenceMessage);
+            R(a) = Payload(object)[ip->c];
+            VM_NEXT();
+        }
+        VM_CASE(SetField)
+        {
+            Object *object = R(a).ref;
+            if (!object)
+                VM_FAULT(kNullReference, kNullReferenceMessage);
+            Payload(object)[ip->c] = R(b);
+            if (ip->type == IrType::kRef)
+                heap_->WriteBarrier(object, R(b).ref);
+            VM_NEXT();
+        }
+        VM_CASE(GetStatic)
+        {
+            R(a) = statics[ip->c];
+            VM_NEXT();
+        }
+        VM_CASE(SetStatic)
+        {
+            statics[ip->c] = R(b);
+            VM_NEXT();
+        }
+        VM_CASE(New)
+        {
+            VM_SAFEPOINT();
+            R(a) = RefValue(heap_->NewInstance(ip->c));
+            VM_NEXT();
+        }
+        VM_CASE(NewArray)
+        {
+            std::int64_t length = R(b).i;
+            if (length < 0)
+                VM_FAULT(kOverflow, kOverflowMessage);
+            VM_SAFEPOINT();
+            R(a) = RefValue(heap_->NewArray(ip->type, static_cast<std::uint32_t>(length)));
+            VM_NEXT();
+        }
+        VM_CASE(GetElem)
+        {
+            Object *array = R(b).ref;
+            if (!array)
+                VM_FAULT(kNullReference, kNullReferenceMessage);
+            std::uint64_t index = U(R(c).i);
+            if (index >= array->info)
+                VM_FAULT(kIndexOutOfRange, kIndexOutOfRangeMessage);
+            R(a) = Payload(array)[index];
+            VM_NEXT();
+        }
+        VM_CASE(SetElem)
+        {
+            Object *array = R(a).ref;
+            if (!array)
+                VM_FAULT(kNullReference, kNullReferenceMessage);
+            std::uint64_t index = U(R(b).i);
+            if (index >= array->info)
+                VM_FAULT(kIndexOutOfRange, kIndexOutOfRangeMessage);
+            Payload(array)[index] = R(c);
+            if (ip->type == IrType::kRef)
+                heap_->WriteBarrier(array, R(c).ref);
+            VM_NEXT();
+        }
+        VM_CASE(ArrayLength)
+        VM_CASE(StringLength)
+        {
+            Object *object = R(b).ref;
+            if (!object)
+                VM_FAULT(kNullReference, kNullReferenceMessage);
+            R(a).i = object->info;
+            VM_NEXT();
+        }
+        VM_CASE(CharAt)
+        {
+            Object *s = R(b).ref;
+            if (!s)
+                VM_FAULT(kNullReference, kNullReferenceMessage);
+            std::uint64_t index = U(R(c).i);
+            if (index >= s->info)
+                VM_FAULT(kIndexOutOfRange, kIndexOutOfRangeMessage);
+            if (s->kind == ObjectKind::kRope)
+            {
+                VM_SAFEPOINT();
+                s = Flatten(s);
+            }
+            R(a).i = static_cast<unsigned char>(StringData(s)[index]);
+            VM_NEXT();
+        }
+        VM_CASE(CheckCast)
+        {
+            Object *object = R(b).ref;
+            if (object && !(object->kind == ObjectKind::kInstance && program_.IsSubclass(object->info, ip->c)))
+                VM_FAULT(kInvalidCast, "Unable to cast object of type '" + ObjectTypeName(object, program_) +
+                                           "' to type '" + program_.classes[ip->c].name + "'.");
+            R(a) = R(b);
+            VM_NEXT();
+        }
+        VM_CASE(Call)
+        {
+            callee = &functions[ip->c];
+            goto call;
+        }
+        VM_CASE(CallVirtual)
+        {
+            Object *receiver = regs[CallArgument(ip, 0)].ref;
+            if (!receiver)
+                VM_FAULT(kNullReference, kNullReferenceMessage);
+            InlineCache &cache = caches[CallSite(ip)];
+            if (cache.classes[0] == receiver->info && cache.size)
+            {
+                callee = &functions[cache.targets[0]];
+                if (cache.size == 1)
+                    monomorphic_hits++;
+                else
+                    polymorphic_hits++;
+            }
+            else
+            {
+                callee = &functions[ResolveVirtual(cache, receiver->info, ip->c)];
+            }
+            goto call;
+        }
+    call:
+        {
+            if (callee->code.empty())
+                VM_FAULT("System.MissingMethodException", callee->name + " has no body.");
+            Value *callee_regs = regs + fn->num_registers;
+            if (callee_regs + callee->num_registers > stack_end || frames_.size() >= options_.max_depth)
+                VM_FAULT("System.StackOverflowException", "Operation caused a stack overflow.");
+            std::uint32_t argc = ip->b;
+            for (std::uint32_t i = 0; i < argc; i++)
+                callee_regs[i] = regs[CallArgument(ip, i)];
+            VM_SAFEPOINT();
+            std::memset(static_cast<void *>(callee_regs + argc), 0, sizeof(Value) * (callee->num_registers - argc));
+            frames_.push_back(Frame{callee, callee_regs, ip + InstLength(*ip), ip->a});
+            calls++;
+            fn = callee;
+            regs = callee_regs;
+            code = fn->code.data();
+            constants = fn->constants.data();
+            ip = code;
+            VM_HOT();
+        }
+        VM_CASE(CallBuiltin)
+        {
+            VM_SAFEPOINT();
+            Value value = CallBuiltin(fn, ip, regs);
+            if (ip->a != kNoRegister)
+                R(a) = value;
+            ip += CallLength(ip->b);
+            VM_DISPATCH();
+        }
+        VM_CASE(Await)
+        {
+            Object *task = R(b).ref;
+            if (task && task->kind == ObjectKind::kTask && task->info)
+            {
+                R(a) = RefValue(TaskOf(task)->result);
+                VM_NEXT();
+            }
+            VM_SAFEPOINT();
+            result = RefValue(Suspend(fn, ip, regs));
+            suspending = true;
+            goto leave;
+        }
+        VM_CASE(Jump)
+        {
+            VM_JUMP(code + ip->Wide());
+        }
+        VM_CASE(JumpIfTrue)
+        {
+            if (R(a).i)
+                VM_JUMP(code + ip->Wide());
+            VM_NEXT();
+        }
+        VM_CASE(JumpIfFalse)
+        {
+            if (!R(a).i)
+                VM_JUMP(code + ip->Wide());
+            VM_NEXT();
+        }
+        VM_CASE(Return)
+        {
+            result = R(a);
+            goto leave;
+        }
+        VM_CASE(ReturnVoid)
+        {
+            result = IntValue(0);
+            goto leave;
+        }
+    leave:
+        {
+            Frame done = frames_.back();
+            frames_.pop_back();
+            if (frames_.size() == base)
+            {
+                stats_.instructions += count;
+                stats_.calls += calls;
+                stats_.quickened += quickened;
+                stats_.monomorphic_hits += monomorphic_hits;
+                stats_.polymorphic_hits += polymorphic_hits;
+                stats_.native_entries += native_entries;
+                suspended_ = suspending;
+                return result;
+            }
+            suspending = false;
+            const Frame &caller = frames_.back();
+            fn = caller.fn;
+            regs = caller.regs;
+            code = fn->code.data();
+            constants = fn->constants.data();
+            ip = done.return_pc;
+            if (done.result != kNoRegister)
+                regs[done.result] = result;
+            if (jit_ && (native = jit_state_[static_cast<std::size_t>(fn - functions)].code.get()))
+                goto native_entry;
+            VM_DISPATCH();
+        }
+    native_entry:
+        {
+            // native code runs from ip until it returns or reaches an
+            // instruction it leaves to the interpreter.
+            const void *entry = native->Entry(static_cast<std::uint32_t>(ip - code));
+            if (!entry)
+                VM_DISPATCH();
+            native_entries++;
+            JitExit exit;
+            if (native->Run(regs, &exit, entry))
+            {
+                result = exit.value;
+                goto leave;
+            }
+            ip = code + exit.pc;
+            VM_DISPATCH();
+        }
+#if TINYCSHARP_VM_THREADED
+    profile:
+        {
+            VM_PROFILE();
+            goto *kHandlers[static_cast<std::uint8_t>(ip->op)];
+        }
+#endif
+        VM_CASE(Throw)
+        {
+            Throw(fn, ip, R(a).ref);
+        }
+        VM_SIMPLE(AddI32, R(a).i = I32(U(R(b).i) + U(R(c).i)))
+        VM_SIMPLE(AddI64, R(a).i = I64(U(R(b).i) + U(R(c).i)))
+        VM_SIMPLE(AddF64, R(a).d = R(b).d + R(c).d)
+        VM_SIMPLE(SubI32, R(a).i = I32(U(R(b).i) - U(R(c).i)))
+        VM_SIMPLE(SubI64, R(a).i = I64(U(R(b).i) - U(R(c).i)))
+        VM_SIMPLE(SubF64, R(a).d = R(b).d - R(c).d)
+        VM_SIMPLE(MulI32, R(a).i = I32(U(R(b).i) * U(R(c).i)))
+        VM_SIMPLE(MulI64, R(a).i = I64(U(R(b).i) * U(R(c).i)))
+        VM_SIMPLE(MulF64, R(a).d = R(b).d * R(c).d)
+        VM_INT_DIVIDE(DivI32, /, std::int32_t)
+        VM_INT_DIVIDE(DivI64, /, std::int64_t)
+        VM_SIMPLE(DivF64, R(a).d = R(b).d / R(c).d)
+        VM_INT_DIVIDE(RemI32, %, std::int32_t)
+        VM_INT_DIVIDE(RemI64, %, std::int64_t)
+        VM_SIMPLE(ShlI32, R(a).i = I32(U(R(b).i) << (R(c).i & 31)))
+        VM_SIMPLE(ShlI64, R(a).i = I64(U(R(b).i) << (R(c).i & 63)))
+        VM_SIMPLE(ShrI32, R(a).i = R(b).i >> (R(c).i & 31))
+        VM_SIMPLE(ShrI64, R(a).i = R(b).i >> (R(c).i & 63))
+        VM_SIMPLE(NegI32, R(a).i = I32(0 - U(R(b).i)))
+        VM_SIMPLE(NegF64, R(a).d = -R(b).d)
+        VM_SIMPLE(EqI, R(a).i = R(b).i == R(c).i)
+        VM_SIMPLE(NeI, R(a).i = R(b).i != R(c).i)
+        VM_SIMPLE(LtI, R(a).i = R(b).i < R(c).i)
+        VM_SIMPLE(LeI, R(a).i = R(b).i <= R(c).i)
+        VM_SIMPLE(GtI, R(a).i = R(b).i > R(c).i)
+        VM_SIMPLE(GeI, R(a).i = R(b).i >= R(c).i)
+        VM_SIMPLE(EqF64, R(a).i = R(b).d == R(c).d)
+        VM_SIMPLE(NeF64, R(a).i = R(b).d != R(c).d)
+        VM_SIMPLE(LtF64, R(a).i = R(b).d < R(c).d)
+        VM_SIMPLE(LeF64, R(a).i = R(b).d <= R(c).d)
+        VM_SIMPLE(GtF64, R(a).i = R(b).d > R(c).d)
+        VM_SIMPLE(GeF64, R(a).i = R(b).d >= R(c).d)
+        VM_SIMPLE(ConvI64I32, R(a).i = I32(U(R(b).i)))
+        VM_SIMPLE(ConvIF64, R(a).d = static_cast<double>(R(b).i))
+        VM_SIMPLE(ConvF64I32, R(a).i = Saturate<std::int32_t>(R(b).d))
+        VM_JUMP_IF(JumpIfEqI, ==)
+        VM_JUMP_IF(JumpIfNeI, !=)
+        VM_JUMP_IF(JumpIfLtI, <)
+        VM_JUMP_IF(JumpIfLeI, <=)
+        VM_JUMP_IF(JumpIfGtI, >)
+        VM_JUMP_IF(JumpIfGeI, >=)
+        VM_CASE(AddField)
+        {
+            Object *object = R(a).ref;
+            if (!object)
+                VM_FAULT(kNullReference, kNullReferenceMessage);
+            AddTo(Payload(object)[ip->c], R(b), ip->type);
+            VM_NEXT();
+        }
+        VM_CASE(AddStatic)
+        {
+            AddTo(statics[ip->c], R(b), ip->type);
+            VM_NEXT();
+        }
+        VM_CASE(AddElem)
+        {
+            Object *array = R(a).ref;
+            if (!array)
+                VM_FAULT(kNullReference, kNullReferenceMessage);
+            std::uint64_t index = U(R(b).i);
+            if (index >= array->info)
+                VM_FAULT(kIndexOutOfRange, kIndexOutOfRangeMessage);
+            AddTo(Payload(array)[index], R(c), ip->type);
+            VM_NEXT();
+        }
+#if !TINYCSHARP_VM_THREADED
+        }
+#endif
+        return result;
+
+#undef VM_JUMP_IF
+#undef VM_JUMP
+#undef VM_HOT
+#undef VM_PROFILE
+#undef VM_INT_DIVIDE
+#undef VM_SIMPLE
+#undef VM_QUICKEN
+#undef VM_COMPARE
+#undef VM_BITWISE
+#undef VM_ARITH
+#undef VM_FAULT
+#undef VM_SAFEPOINT
+#undef VM_NEXT
+#undef VM_DISPATCH
+#undef VM_CASE
+#undef R
+    }
+
+}
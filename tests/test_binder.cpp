@@ -0,0 +1,154 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include <gtest/gtest.h>
+#include "ast.h"
+#include "binder.h"
+#include "parser.h"
+
+#include <string>
+#include <vector>
+
+namespace tinycsharp_test
+{
+
+    class BinderTest : public ::testing::Test
+    {
+    protected:
+        tinycsharp::Interner interner;
+        tinycsharp::AstContext ctx{interner};
+        std::vector<tinycsharp::Diagnostic> diagnostics;
+
+        void Bind(const std::vector<std::string> &sources)
+        {
+            int n = 0;
+            for (const auto &src : sources)
+            {
+                tinycsharp::Parser parser{ctx, src, "file" + std::to_string(n++) + ".cs"};
+                parser.ParseCompilationUnit();
+            }
+            tinycsharp::Binder binder{interner, diagnostics};
+            binder.Bind(ctx.units);
+        }
+
+        tinycsharp::NameExpr *FindName(std::string_view name, int nth = 0)
+        {
+            for (auto *node : ctx.NodesOfKind(tinycsharp::NodeKind::kNameExpr))
+            {
+                auto *expr = static_cast<tinycsharp::NameExpr *>(node);
+                if (expr->name == name && nth-- == 0)
+                {
+                    return expr;
+                }
+            }
+            return nullptr;
+        }
+    };
+
+    TEST_F(BinderTest, ShouldResolveLocalsParamsFieldsAndClasses)
+    {
+        Bind({R"(
+namespace Shop
+{
+    class Cart
+    {
+        int count;
+        int Add(int amount)
+        {
+            var total = count + amount;
+            {
+                var count = 1;
+                total = total + count;
+            }
+            return Helper.Twice(total);
+        }
+    }
+    class Helper
+    {
+        static int Twice(int v) => v * 2;
+    }
+}
+)"});
+        EXPECT_TRUE(diagnostics.empty()) << diagnostics.front();
+
+        auto *field_use = FindName("count", 0);
+        ASSERT_NE(field_use, nullptr);
+        EXPECT_EQ(field_use->decl->kind, tinycsharp::NodeKind::kFieldDecl);
+
+        auto *shadowing_local = FindName("count", 1);
+        ASSERT_NE(shadowing_local, nullptr);
+        EXPECT_EQ(shadowing_local->decl->kind, tinycsharp::NodeKind::kLocalVarStmt);
+
+        EXPECT_EQ(FindName("amount")->decl->kind, tinycsharp::NodeKind::kParamDecl);
+        EXPECT_EQ(FindName("Helper")->decl->kind, tinycsharp::NodeKind::kClassDecl);
+    }
+
+    TEST_F(BinderTest, ShouldResolveAcrossFilesThroughUsingsAndBases)
+    {
+        Bind({R"(
+namespace Core
+{
+    public class Entity
+    {
+        protected int id;
+    }
+}
+)",
+              R"(
+using Core;
+namespace App
+{
+    class User : Entity
+    {
+        int Id() { return id; }
+    }
+}
+)"});
+        EXPECT_TRUE(diagnostics.empty()) << diagnostics.front();
+        auto *id = FindName("id");
+        ASSERT_NE(id, nullptr);
+        ASSERT_NE(id->decl, nullptr);
+        EXPECT_EQ(static_cast<tinycsharp::FieldDecl *>(id->decl)->owner->name, "Entity");
+    }
+
+    TEST_F(BinderTest, ShouldReportUndeclaredAndRedeclaredNames)
+    {
+        Bind({R"(
+class A
+{
+    void F(int x)
+    {
+        var y = missing;
+        if (x > 0)
+        {
+            var x = 2;
+        }
+        var y = 3;
+        Console.WriteLine(y);
+    }
+}
+)"});
+        ASSERT_EQ(diagnostics.size(), 3u);
+        EXPECT_NE(diagnostics[0].message.find("'missing' does not exist"), std::string::npos);
+        EXPECT_EQ(diagnostics[0].file, "file0.cs");
+        EXPECT_EQ(diagnostics[0].line, 6);
+        EXPECT_NE(diagnostics[1].message.find("enclosing local scope"), std::string::npos);
+        EXPECT_NE(diagnostics[2].message.find("already defined in this scope"), std::string::npos);
+    }
+
+}
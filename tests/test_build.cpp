@@ -0,0 +1,228 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include <gtest/gtest.h>
+#include "build.h"
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+namespace tinycsharp_test
+{
+
+    namespace
+    {
+        using Status = tinycsharp::TaskGraph::Status;
+
+        // a scratch project directory, removed again at the end of a test.
+        struct Project
+        {
+            std::filesystem::path dir;
+
+            Project()
+            {
+                dir = std::filesystem::temp_directory_path() / ("tinycsharp_build_" + std::to_string(::getpid()));
+                std::filesystem::remove_all(dir);
+                std::filesystem::create_directories(dir);
+            }
+            ~Project() { std::filesystem::remove_all(dir); }
+
+            void Write(const std::string &name, const std::string &text) const
+            {
+                std::filesystem::create_directories((dir / name).parent_path());
+                std::ofstream(dir / name) << text;
+            }
+        };
+
+        const char *kManifest = "# the test project\n"
+                                "assembly Core\n"
+                                "    core/Numbers.cs\n"
+                                "assembly Text   # depends on Core\n"
+                                "    text/Format.cs\n"
+                                "assembly App\n"
+                                "    app/Main.cs\n"
+                                "assembly Tool\n"
+                                "    tool/Tool.cs\n";
+
+        void WriteProject(const Project &project, const std::string &format_body)
+        {
+            project.Write("build.txt", kManifest);
+            project.Write("core/Numbers.cs", "namespace Core { class Numbers { public static int Twice(int x) { return 2 * x; } } }");
+            project.Write("text/Format.cs", "using Core;\nnamespace Text { class Format { public static int Width(int x) { " + format_body + " } } }");
+            project.Write("app/Main.cs", "using Core;\nusing Text;\nusing System;\n"
+                                         "class Program { static void Main() { Console.WriteLine(Format.Width(Numbers.Twice(3))); } }");
+            project.Write("tool/Tool.cs", "class Tool { static int Run() { return 1; } }");
+        }
+    }
+
+    TEST(BuildManifestTest, ShouldReadAssembliesAndReportBadLines)
+    {
+        auto manifest = tinycsharp::BuildManifest::Parse(kManifest, "/src");
+        ASSERT_EQ(manifest.assemblies.size(), 4u);
+        EXPECT_EQ(manifest.assemblies[1].name, "Text");
+        ASSERT_EQ(manifest.assemblies[1].files.size(), 1u);
+        EXPECT_EQ(manifest.assemblies[1].files[0], "/src/text/Format.cs");
+
+        try
+        {
+            tinycsharp::BuildManifest::Parse("\na.cs\n", "", "p.txt");
+            FAIL() << "a file outside an assembly was accepted";
+        }
+        catch (const std::runtime_error &e)
+        {
+            EXPECT_EQ(std::string(e.what()), "p.txt:2: 'a.cs' is not in an assembly");
+        }
+        EXPECT_THROW(tinycsharp::BuildManifest::Parse("assembly A\na.cs\nassembly A\nb.cs\n"), std::runtime_error);
+        EXPECT_THROW(tinycsharp::BuildManifest::Parse("assembly A\n"), std::runtime_error);
+        EXPECT_THROW(tinycsharp::BuildManifest::Parse("# nothing\n"), std::runtime_error);
+    }
+
+    TEST(TaskGraphTest, ShouldRunStepsAfterTheirDependenciesAndSkipThoseOfFailedOnes)
+    {
+        tinycsharp::ThreadPool pool{4};
+        tinycsharp::TaskGraph graph;
+        std::atomic<int> clock{0};
+        std::vector<int> finished(6, -1);
+        auto step = [&](int id, int ms, bool ok)
+        {
+            return [&, id, ms, ok]
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+                finished[id] = clock++;
+                return ok;
+            };
+        };
+        auto a = graph.Add("a", step(0, 20, true));
+        auto b = graph.Add("b", step(1, 1, true));
+        auto c = graph.Add("c", step(2, 20, true), {a, b});
+        auto d = graph.Add("d", step(3, 1, false), {b});
+        auto e = graph.Add("e", step(4, 1, true), {d});
+        EXPECT_FALSE(graph.Run(pool));
+        EXPECT_GT(finished[2], finished[0]);
+        EXPECT_GT(finished[2], finished[1]);
+        EXPECT_EQ(graph.nodes()[c].status, Status::kSucceeded);
+        EXPECT_EQ(graph.nodes()[d].status, Status::kFailed);
+        EXPECT_EQ(graph.nodes()[e].status, Status::kSkipped);
+        EXPECT_EQ(finished[4], -1);
+        EXPECT_EQ(graph.CriticalPath(), (std::vector<tinycsharp::TaskGraph::Step>{a, c}));
+
+        // later steps may wait on earlier runs; a throw fails the step.
+        auto f = graph.Add("f", []() -> bool
+                           { throw std::runtime_error("no disk"); }, {c});
+        auto g = graph.Add("g", step(5, 1, true), {e});
+        EXPECT_FALSE(graph.Run(pool));
+        EXPECT_EQ(graph.nodes()[f].error, "no disk");
+        EXPECT_EQ(graph.nodes()[g].status, Status::kSkipped);
+
+        std::ostringstream report;
+        graph.PrintTimings(report);
+        EXPECT_NE(report.str().find("critical path"), std::string::npos) << report.str();
+        EXPECT_NE(report.str().find("skipped  e"), std::string::npos) << report.str();
+        EXPECT_NE(report.str().find("d (failed)"), std::string::npos) << report.str();
+    }
+
+    TEST(ProjectBuildTest, ShouldCheckAssembliesInDependencyOrder)
+    {
+        Project project;
+        WriteProject(project, "return x + 1;");
+        tinycsharp::ThreadPool pool{4};
+        tinycsharp::ProjectBuild build{tinycsharp::BuildManifest::Load((project.dir / "build.txt").string()), pool};
+        std::ostringstream err;
+        ASSERT_TRUE(build.Check(err)) << err.str();
+        EXPECT_EQ(err.str(), "");
+
+        // Core 0, Text 1, App 2, Tool 3.
+        const auto &deps = build.dependencies();
+        EXPECT_EQ(deps[0], std::vector<std::size_t>{});
+        EXPECT_EQ(deps[1], std::vector<std::size_t>{0});
+        EXPECT_EQ(deps[2], (std::vector<std::size_t>{0, 1}));
+        EXPECT_EQ(deps[3], std::vector<std::size_t>{});
+        std::ostringstream graph;
+        build.PrintDependencies(graph);
+        EXPECT_EQ(graph.str(), "Text -> Core (using Core)\nApp -> Core (using Core)\nApp -> Text (using Text)\n");
+
+        const auto &nodes = build.graph().nodes();
+        auto find = [&](const std::string &name) -> const tinycsharp::TaskGraph::Node &
+        {
+            for (const auto &node : nodes)
+            {
+                if (node.name == name)
+                    return node;
+            }
+            throw std::runtime_error("no step " + name);
+        };
+        EXPECT_GE(find("check Text").start_ms, find("check Core").end_ms);
+        EXPECT_GE(find("check App").start_ms, find("check Text").end_ms);
+        EXPECT_GE(find("check Tool").start_ms, find("declare").end_ms);
+        EXPECT_EQ(find("finish").status, Status::kSucceeded);
+    }
+
+    TEST(ProjectBuildTest, ShouldSkipTheDependentsOfAnAssemblyWithErrors)
+    {
+        Project project;
+        WriteProject(project, "return \"wide\";");
+        tinycsharp::ThreadPool pool{2};
+        tinycsharp::ProjectBuild build{tinycsharp::BuildManifest::Load((project.dir / "build.txt").string()), pool};
+        std::ostringstream err;
+        EXPECT_FALSE(build.Check(err));
+        EXPECT_NE(err.str().find("Format.cs:2:"), std::string::npos) << err.str();
+        EXPECT_NE(err.str().find("App was not checked"), std::string::npos) << err.str();
+        for (const auto &node : build.graph().nodes())
+        {
+            if (node.name == "check Tool" || node.name == "check Core")
+            {
+                EXPECT_EQ(node.status, Status::kSucceeded) << node.name;
+            }
+            if (node.name == "check App" || node.name == "finish")
+            {
+                EXPECT_EQ(node.status, Status::kSkipped) << node.name;
+            }
+        }
+
+        // a cycle between assemblies stops the build before checking.
+        project.Write("core/Numbers.cs", "using Text;\nnamespace Core { class Numbers { } }");
+        tinycsharp::ProjectBuild cyclic{tinycsharp::BuildManifest::Load((project.dir / "build.txt").string()), pool};
+        std::ostringstream cycle;
+        EXPECT_FALSE(cyclic.Check(cycle));
+        EXPECT_EQ(cycle.str(), "tinycsharp: dependency cycle: Core -> Text -> Core\n");
+    }
+
+    TEST(ProjectBuildTest, ShouldReportNamesNoAssemblyDeclares)
+    {
+        // App calls into Core, which the manifest leaves out: a System using
+        // must not let the call pass as a library one.
+        Project project;
+        WriteProject(project, "return x;");
+        project.Write("build.txt", "assembly App\n    app/Main.cs\n");
+        project.Write("app/Main.cs", "using System;\nusing System.Text;\n"
+                                     "class Program { static void Main() { StringBuilder text = null; Console.WriteLine(Numbers.Twice(3)); } }");
+        tinycsharp::ThreadPool pool{2};
+        tinycsharp::ProjectBuild build{tinycsharp::BuildManifest::Load((project.dir / "build.txt").string()), pool};
+        std::ostringstream err;
+        EXPECT_FALSE(build.Check(err));
+        EXPECT_NE(err.str().find("Main.cs:3:38: error: The type or namespace name 'StringBuilder' could not be found"), std::string::npos) << err.str();
+        EXPECT_NE(err.str().find("error: The name 'Numbers' does not exist in the current context"), std::string::npos) << err.str();
+    }
+
+}
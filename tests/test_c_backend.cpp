@@ -0,0 +1,369 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include <gtest/gtest.h>
+#include "bytecode.h"
+#include "c_backend.h"
+#include "ir.h"
+#include "parser.h"
+#include "passes.h"
+#include "sema.h"
+#include "vm.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+namespace tinycsharp_test
+{
+
+    // compiles programs to native executables with the system C compiler
+    // and runs them next to the interpreter, which they must agree with:
+    // output, exit code and the text of any unhandled exception.
+    class CBackendTest : public ::testing::Test
+    {
+    protected:
+        tinycsharp::Interner interner;
+        tinycsharp::AstContext ctx{interner};
+        tinycsharp::Sema sema{interner};
+        tinycsharp::IrModule module;
+        std::string base = ::testing::TempDir() + "tinycsharp_native_" + std::to_string(::getpid());
+
+        struct Outcome
+        {
+            std::string output;
+            int exit_code = 0;
+            std::string error;
+        };
+
+        void TearDown() override
+        {
+            for (const char *suffix : {"", ".out", ".err"})
+                std::remove((base + suffix).c_str());
+        }
+
+        static bool HaveCompiler() { return std::system("cc --version >/dev/null 2>&1") == 0; }
+
+        void Compile(const std::string &source)
+        {
+            tinycsharp::Parser parser{ctx, source, "test.cs"};
+            parser.ParseCompilationUnit();
+            ASSERT_TRUE(sema.Analyze(ctx.units)) << (sema.diagnostics().empty() ? "" : sema.diagnostics()[0].message);
+            module = tinycsharp::LowerToIr(sema.globals());
+            tinycsharp::PassManager passes;
+            passes.AddPipeline(tinycsharp::OptLevel::kO1);
+            passes.Run(module);
+        }
+
+        Outcome Interpret()
+        {
+            Outcome outcome;
+            std::ostringstream out;
+            tinycsharp::BcProgram program = tinycsharp::CompileBytecode(module);
+            tinycsharp::Vm vm{program, out};
+            try
+            {
+                outcome.exit_code = vm.Run();
+            }
+            catch (const tinycsharp::VmError &e)
+            {
+                outcome.error = e.what();
+                outcome.exit_code = 1;
+            }
+            outcome.output = out.str();
+            return outcome;
+        }
+
+        static std::string ReadAll(const std::string &path)
+        {
+            std::ifstream in(path, std::ios::binary);
+            std::ostringstream ss;
+            ss << in.rdbuf();
+            return ss.str();
+        }
+
+        Outcome RunNative()
+        {
+            tinycsharp::CompileNative(module, base);
+            std::string command = "'" + base + "' >'" + base + ".out' 2>'" + base + ".err'";
+            int status = std::system(command.c_str());
+            Outcome outcome;
+            outcome.exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+            outcome.output = ReadAll(base + ".out");
+            outcome.error = ReadAll(base + ".err");
+            if (!outcome.error.empty() && outcome.error.back() == '\n')
+                outcome.error.pop_back();
+            return outcome;
+        }
+
+        Outcome Differential(const std::string &source)
+        {
+            Compile(source);
+            Outcome expected = Interpret();
+            Outcome actual = RunNative();
+            EXPECT_EQ(actual.output, expected.output);
+            EXPECT_EQ(actual.exit_code, expected.exit_code);
+            EXPECT_EQ(actual.error, expected.error);
+            return actual;
+        }
+    };
+
+    TEST_F(CBackendTest, ShouldEmitOneTranslationUnit)
+    {
+        Compile(R"(
+class Program
+{
+    static int Twice(int x) { return x + x; }
+    static void Main() { System.Console.WriteLine("what??/ " + Twice(21)); }
+}
+)");
+        std::ostringstream out;
+        tinycsharp::EmitC(out, module);
+        std::string c = out.str();
+        EXPECT_NE(c.find("int main(void)"), std::string::npos);
+        EXPECT_NE(c.find("/* Program.Twice(int) */"), std::string::npos);
+        EXPECT_NE(c.find("what\\077\\077/"), std::string::npos);
+        EXPECT_EQ(c.find("??"), std::string::npos);
+    }
+
+    TEST_F(CBackendTest, ShouldRejectAsyncMethods)
+    {
+        Compile(R"(
+using System.Threading.Tasks;
+class Program
+{
+    static async Task<int> Answer() { await Task.Yield(); return 42; }
+    static async Task Main() { System.Console.WriteLine(await Answer()); }
+}
+)");
+        std::ostringstream out;
+        EXPECT_THROW(tinycsharp::EmitC(out, module), std::runtime_error);
+    }
+
+    TEST_F(CBackendTest, ShouldMatchTheInterpreterOnIntegerArithmetic)
+    {
+        if (!HaveCompiler())
+            GTEST_SKIP() << "no C compiler";
+        Outcome out = Differential(R"(
+class Program
+{
+    static int Mix(int a, int b)
+    {
+        int r = a * 31 + b;
+        r = r ^ (r >> 3);
+        r = r | (b << 7);
+        return r - a / (b | 1) + a % 7;
+    }
+    static int Main()
+    {
+        int h = 17;
+        long l = 1;
+        int i = 0;
+        while (i < 5000)
+        {
+            h = Mix(h, i) + (i << 29);
+            l = l * 6364136223846793005 + i;
+            l = l ^ (l >> 17);
+            i++;
+        }
+        int wrap = 2147483647;
+        wrap = wrap + i;
+        int min = -2147483647 - 1;
+        System.Console.WriteLine(h + " " + l + " " + wrap + " " + (-h) + " " + (-min) + " " + (-7 / 2) + " " + (-7 % 2) + " " + (1 << 33));
+        System.Console.WriteLine(System.Math.Abs(-5) + " " + System.Math.Max(3, 9) + " " + System.Math.Min(l, 4));
+        return h & 127;
+    }
+}
+)");
+        EXPECT_FALSE(out.output.empty());
+    }
+
+    // function names must stay clear of the runtime's helpers (tc_f32,
+    // tc_f64, ...) however many functions there are.
+    TEST_F(CBackendTest, ShouldCompileProgramsWithManyFunctions)
+    {
+        if (!HaveCompiler())
+            GTEST_SKIP() << "no C compiler";
+        std::string source = "class Program\n{\n";
+        std::string sum = "0";
+        for (int i = 0; i < 80; i++)
+        {
+            source += "    static int F" + std::to_string(i) + "(int x) { return x * " + std::to_string(i) + " + 1; }\n";
+            sum += " + F" + std::to_string(i) + "(" + std::to_string(i) + ")";
+        }
+        source += "    static int Main()\n    {\n        System.Console.WriteLine(" + sum + ");\n        return 3;\n    }\n}\n";
+        Outcome out = Differential(source);
+        EXPECT_EQ(out.output, "167560\n");
+        EXPECT_EQ(out.exit_code, 3);
+    }
+
+    TEST_F(CBackendTest, ShouldMatchTheInterpreterOnFloatingPoint)
+    {
+        if (!HaveCompiler())
+            GTEST_SKIP() << "no C compiler";
+        Differential(R"(
+class Program
+{
+    static void Main()
+    {
+        double d = 0.5;
+        float f = (float)1.25;
+        double nan = 0.0 / 0.0;
+        int i = 1;
+        while (i < 3000)
+        {
+            d = d * 1.0001 + 1.0 / i - d % 3.0;
+            f = f * (float)0.999 + (float)0.5 - f % (float)2.0;
+            i++;
+        }
+        long big = (long)(d * 100000000000000000000.0);
+        System.Console.WriteLine(d + " " + f + " " + (int)d + " " + big + " " + (int)nan + " " + (double)i + " " + nan);
+        System.Console.WriteLine("{0} and {1}", 0.1 + 0.2, System.Math.Sqrt(2.0));
+        System.Console.WriteLine(1.0 / 0.0);
+        System.Console.WriteLine(System.Math.Max(nan, 1.0) + " " + (float)0.1 + " " + 123456789.0 * 1000000000000.0);
+    }
+}
+)");
+    }
+
+    TEST_F(CBackendTest, ShouldMatchTheInterpreterOnObjectsArraysAndStrings)
+    {
+        if (!HaveCompiler())
+            GTEST_SKIP() << "no C compiler";
+        Differential(R"(
+class Shape
+{
+    public string name = "shape";
+    public virtual double Area() { return 0.0; }
+    public string Describe() { return name + ":" + Area(); }
+}
+class Square : Shape
+{
+    public double side;
+    public Square(double s) { side = s; name = "square"; }
+    public override double Area() { return side * side; }
+}
+class Circle : Shape
+{
+    public double r;
+    public Circle(double radius) { r = radius; name = "circle"; }
+    public override double Area() { return 3.0 * r * r; }
+}
+class Program
+{
+    static int calls;
+    static void Main(string[] args)
+    {
+        Shape[] shapes = new Shape[4];
+        shapes[0] = new Square(2.0);
+        shapes[1] = new Circle(1.5);
+        shapes[2] = new Shape();
+        shapes[3] = new Square(0.5);
+        double total = 0.0;
+        int i = 0;
+        while (i < shapes.Length)
+        {
+            total += shapes[i].Area();
+            System.Console.WriteLine(shapes[i].Describe());
+            System.Console.WriteLine(shapes[i]);
+            calls++;
+            i++;
+        }
+        string text = "héllo, world";
+        int[] counts = new int[128];
+        i = 0;
+        while (i < text.Length)
+        {
+            char c = text[i];
+            if (c < 128)
+                counts[c]++;
+            i++;
+        }
+        object boxed = counts[108];
+        int back = (int)boxed;
+        System.Console.Write(total + " " + calls + " " + args.Length + " " + back + " " + (text == "héllo, world") + " ");
+        System.Console.WriteLine(text[1] + "|" + (text + "!").Length);
+        Shape s = shapes[1];
+        Circle circle = (Circle)s;
+        System.Console.WriteLine(circle.r);
+    }
+}
+)");
+    }
+
+    TEST_F(CBackendTest, ShouldReportUnhandledExceptionsLikeTheInterpreter)
+    {
+        if (!HaveCompiler())
+            GTEST_SKIP() << "no C compiler";
+        Outcome out = Differential(R"(
+class Program
+{
+    static int At(int[] values, int i)
+    {
+        return values[i];
+    }
+    static int Sum(int[] values, int n)
+    {
+        int total = 0;
+        int i = 0;
+        while (i <= n)
+        {
+            total += At(values, i);
+            i++;
+        }
+        return total;
+    }
+    static void Main()
+    {
+        int[] values = new int[3];
+        System.Console.WriteLine("before");
+        System.Console.WriteLine(Sum(values, 3));
+    }
+}
+)");
+        EXPECT_EQ(out.output, "before\n");
+        EXPECT_NE(out.error.find("System.IndexOutOfRangeException"), std::string::npos);
+        EXPECT_NE(out.error.find("at Program.Sum"), std::string::npos);
+    }
+
+    TEST_F(CBackendTest, ShouldMatchTheInterpreterOnDivisionFaults)
+    {
+        if (!HaveCompiler())
+            GTEST_SKIP() << "no C compiler";
+        Differential(R"(
+class Program
+{
+    static int Divide(int a, int b) { return a / b; }
+    static void Main()
+    {
+        int i = 3;
+        while (i >= 0)
+        {
+            System.Console.WriteLine(Divide(12, i));
+            i--;
+        }
+    }
+}
+)");
+    }
+
+}
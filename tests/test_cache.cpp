@@ -0,0 +1,342 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include <gtest/gtest.h>
+#include "cache.h"
+#include "lexer.h"
+#include "parser.h"
+#include "sema.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace tinycsharp_test
+{
+
+    class CacheTest : public ::testing::Test
+    {
+    protected:
+        std::filesystem::path dir;
+
+        void SetUp() override
+        {
+            dir = std::filesystem::temp_directory_path() /
+                  ("tinycsharp_cache_" + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()));
+            std::filesystem::remove_all(dir);
+        }
+        void TearDown() override
+        {
+            std::filesystem::remove_all(dir);
+        }
+
+        const std::string source = R"(
+namespace Veal
+{
+    public class Config
+    {
+        const int Retries = 3;
+        const string Name = "veal";
+        float ratio = 2.5;
+    }
+}
+)";
+    };
+
+    TEST_F(CacheTest, ShouldRoundTripTokenStreams)
+    {
+        tinycsharp::SourceLocation base{1000};
+        tinycsharp::Lexer lexer{source, base};
+        auto tokens = lexer.Tokenize();
+        auto decoded = tinycsharp::DecodeTokens(tinycsharp::EncodeTokens(tokens, base), base);
+        auto moved = tinycsharp::DecodeTokens(tinycsharp::EncodeTokens(tokens, base), base + 50);
+
+        ASSERT_EQ(decoded.size(), tokens.size());
+        for (std::size_t i = 0; i < tokens.size(); i++)
+        {
+            SCOPED_TRACE("Token index " + std::to_string(i));
+            EXPECT_EQ(decoded[i].kind, tokens[i].kind);
+            EXPECT_EQ(decoded[i].lexeme, tokens[i].lexeme);
+            EXPECT_EQ(decoded[i].loc, tokens[i].loc);
+            EXPECT_EQ(moved[i].loc, tokens[i].loc + 50);
+            EXPECT_EQ(!!decoded[i].int_val, !!tokens[i].int_val);
+            EXPECT_EQ(!!decoded[i].float_val, !!tokens[i].float_val);
+            if (tokens[i].int_val)
+            {
+                EXPECT_EQ(*decoded[i].int_val, *tokens[i].int_val);
+            }
+            if (tokens[i].float_val)
+            {
+                EXPECT_EQ(*decoded[i].float_val, *tokens[i].float_val);
+            }
+        }
+        EXPECT_EQ(decoded.back().kind, tinycsharp::TokenKind::kTEof);
+    }
+
+    TEST_F(CacheTest, ShouldCountHitsAndMissesAcrossInstances)
+    {
+        {
+            tinycsharp::CompilationCache cache{dir, 1 << 20};
+            tinycsharp::LexCached(cache, source);
+            auto stats = cache.Stats();
+            EXPECT_EQ(stats.misses, 1u);
+            EXPECT_EQ(stats.hits, 0u);
+            EXPECT_EQ(stats.stores, 1u);
+        }
+
+        tinycsharp::CompilationCache cache{dir, 1 << 20};
+        EXPECT_EQ(cache.EntryCount(), 1u);
+        auto tokens = tinycsharp::LexCached(cache, source);
+        EXPECT_EQ(cache.Stats().hits, 1u);
+        EXPECT_EQ(cache.Stats().misses, 0u);
+        EXPECT_EQ(tokens.front().kind, tinycsharp::TokenKind::kTNamespace);
+    }
+
+    TEST_F(CacheTest, ShouldKeyOnContentsAndPhaseOnly)
+    {
+        tinycsharp::CompilationCache first{dir, 1 << 20};
+        tinycsharp::CompilationCache second{dir, 1 << 20};
+
+        auto a = first.KeyFor(source, tinycsharp::CachePhase::kTokens);
+        auto b = second.KeyFor(source, tinycsharp::CachePhase::kTokens);
+        auto c = first.KeyFor(source + " ", tinycsharp::CachePhase::kTokens);
+        EXPECT_EQ(a.hash, b.hash);
+        EXPECT_NE(a.hash, c.hash);
+        EXPECT_EQ(a.FileName().substr(16), ".tokens");
+        EXPECT_EQ(first.KeyFor(source, tinycsharp::CachePhase::kAst).FileName().substr(16), ".ast");
+        EXPECT_EQ(a.hash, first.KeyFor(std::string(source), tinycsharp::CachePhase::kTokens).hash);
+    }
+
+    TEST_F(CacheTest, ShouldCarryOnWhenEntriesCannotBeWritten)
+    {
+        tinycsharp::CompilationCache cache{dir, 1 << 20};
+        std::filesystem::remove_all(dir);
+        std::ofstream(dir) << "not a directory";
+
+        auto tokens = tinycsharp::LexCached(cache, source);
+        EXPECT_EQ(tokens.front().kind, tinycsharp::TokenKind::kTNamespace);
+        EXPECT_EQ(cache.Stats().stores, 0u);
+        EXPECT_EQ(cache.Stats().failed_stores, 1u);
+        EXPECT_EQ(cache.EntryCount(), 0u);
+        std::filesystem::remove(dir);
+    }
+
+    TEST_F(CacheTest, ShouldEvictLeastRecentlyUsedEntries)
+    {
+        tinycsharp::CompilationCache cache{dir, 3 * 1024};
+        const std::string blob(1000, 'x');
+        auto first = cache.KeyFor("first", tinycsharp::CachePhase::kTokens);
+        auto second = cache.KeyFor("second", tinycsharp::CachePhase::kTokens);
+        auto third = cache.KeyFor("third", tinycsharp::CachePhase::kTokens);
+
+        cache.Store(first, blob);
+        cache.Store(second, blob);
+        ASSERT_TRUE(cache.Lookup(first).has_value());
+        cache.Store(third, blob);
+
+        EXPECT_EQ(cache.Stats().evictions, 1u);
+        EXPECT_LE(cache.SizeInBytes(), 3u * 1024);
+        EXPECT_TRUE(cache.Lookup(first).has_value());
+        EXPECT_FALSE(cache.Lookup(second).has_value());
+        EXPECT_TRUE(cache.Lookup(third).has_value());
+    }
+
+    TEST_F(CacheTest, ShouldTreatCorruptEntriesAsMisses)
+    {
+        tinycsharp::CompilationCache cache{dir, 1 << 20};
+        auto key = cache.KeyFor(source, tinycsharp::CachePhase::kTokens);
+        cache.Store(key, "payload");
+        {
+            std::ofstream out(dir / key.FileName(), std::ios::binary | std::ios::trunc);
+            out << "garbage";
+        }
+        EXPECT_FALSE(cache.Lookup(key).has_value());
+        EXPECT_EQ(cache.EntryCount(), 0u);
+        EXPECT_FALSE(std::filesystem::exists(dir / key.FileName()));
+    }
+
+    TEST_F(CacheTest, ShouldReplayTokenDumpsThroughTheParser)
+    {
+        std::ostringstream text;
+        std::ostringstream dump;
+        {
+            tinycsharp::SourceManager sources;
+            tinycsharp::FileId id = sources.AddFile("config.cs", source);
+            tinycsharp::Lexer lexer{source, sources.Begin(id)};
+            auto tokens = lexer.Tokenize();
+            for (const auto &token : tokens)
+                text << token << "\n";
+            tinycsharp::WriteTokenDump(dump, sources, id, tokens);
+        }
+        EXPECT_TRUE(tinycsharp::IsTokenDump(dump.str()));
+        EXPECT_FALSE(tinycsharp::IsTokenDump(source));
+        EXPECT_LT(dump.str().size() * 5, text.str().size());
+
+        tinycsharp::AstContext replayed_ctx;
+        auto replayed = tinycsharp::ReadTokenDump(dump.str(), replayed_ctx.sources(), "config.cs");
+        std::ostringstream replayed_text;
+        for (const auto &token : replayed)
+            replayed_text << token << "\n";
+        EXPECT_EQ(replayed_text.str(), text.str());
+
+        tinycsharp::AstContext lexed_ctx;
+        auto lexed_unit = tinycsharp::Parser{lexed_ctx, source, "config.cs"}.ParseCompilationUnit();
+        auto replayed_unit = tinycsharp::Parser{replayed_ctx, std::move(replayed), "config.cs"}.ParseCompilationUnit();
+        EXPECT_EQ(replayed_ctx.NodeCount(), lexed_ctx.NodeCount());
+        EXPECT_EQ(replayed_ctx.BytesUsed(), lexed_ctx.BytesUsed());
+
+        // the dump carries the line table, so replayed nodes decode to the
+        // lines and columns of the source.
+        auto lexed_fields = lexed_ctx.NodesOfKind(tinycsharp::NodeKind::kFieldDecl);
+        auto replayed_fields = replayed_ctx.NodesOfKind(tinycsharp::NodeKind::kFieldDecl);
+        ASSERT_EQ(replayed_fields.size(), lexed_fields.size());
+        ASSERT_FALSE(lexed_fields.empty());
+        for (std::size_t i = 0; i < lexed_fields.size(); i++)
+        {
+            tinycsharp::SourcePosition lexed = lexed_unit->Locate(lexed_fields[i]);
+            tinycsharp::SourcePosition replayed_pos = replayed_unit->Locate(replayed_fields[i]);
+            EXPECT_GT(lexed.line, 1);
+            EXPECT_EQ(replayed_pos.line, lexed.line);
+            EXPECT_EQ(replayed_pos.column, lexed.column);
+        }
+
+        tinycsharp::SourceManager sources;
+        EXPECT_THROW(tinycsharp::ReadTokenDump(source, sources, "config.cs"), std::runtime_error);
+        EXPECT_THROW(tinycsharp::ReadTokenDump(dump.str().substr(0, dump.str().size() - 3), sources, "config.cs"), std::runtime_error);
+    }
+
+    TEST_F(CacheTest, ShouldRejectTruncatedTokenStreams)
+    {
+        tinycsharp::Lexer lexer{source};
+        std::string blob = tinycsharp::EncodeTokens(lexer.Tokenize());
+        EXPECT_THROW(tinycsharp::DecodeTokens(blob.substr(0, blob.size() / 2)), std::runtime_error);
+    }
+
+    TEST_F(CacheTest, ShouldRoundTripSyntaxTrees)
+    {
+        const std::string program = R"(
+using System;
+namespace Veal.Core
+{
+    namespace Inner
+    {
+        public struct Point { public int x, y; }
+    }
+    public abstract class Shape : Object
+    {
+        protected const long Big = -9223372036854775808;
+        public string Label { get; set; } = "shape\n";
+        public Shape(int sides) { }
+        public abstract double Area();
+        public int Twice(int v) => v * 2;
+        public class Nested
+        {
+            int[] cells = new int[4];
+            bool Run(double r, Shape s)
+            {
+                var i = 0;
+                while (i < 3) { i++; if (i == 2) continue; else break; }
+                do { cells[i] -= (int)r; } while (!(i >= 0) && true);
+                s = i > 1 ? null : s;
+                Console.WriteLine(s.Twice(i).ToString() + 1.5);
+                return this != null;
+            }
+        }
+    }
+}
+)";
+        tinycsharp::AstContext parsed;
+        auto *unit = tinycsharp::Parser{parsed, program, "shape.cs"}.ParseCompilationUnit();
+        tinycsharp::SourceLocation base = parsed.sources().Begin(parsed.sources().FileOf(unit->loc));
+        std::string blob = tinycsharp::EncodeAst(*unit, base);
+
+        tinycsharp::AstContext decoded;
+        tinycsharp::SourceLocation moved{500};
+        auto *copy = tinycsharp::DecodeAst(blob, decoded, "shape.cs", moved);
+        ASSERT_EQ(decoded.units.size(), 1u);
+        EXPECT_EQ(decoded.units[0], copy);
+        EXPECT_EQ(copy->file, "shape.cs");
+        EXPECT_EQ(decoded.NodeCount(), parsed.NodeCount());
+        EXPECT_EQ(tinycsharp::EncodeAst(*copy, moved), blob);
+        // the same nodes at the same places, though the per-kind index is
+        // in tree order rather than the parser's.
+        for (std::size_t k = 0; k < tinycsharp::kNodeKindCount; k++)
+        {
+            auto kind = static_cast<tinycsharp::NodeKind>(k);
+            std::vector<std::uint32_t> want, got;
+            for (const auto *node : parsed.NodesOfKind(kind))
+                want.push_back(node->loc.offset - base.offset + 500);
+            for (const auto *node : decoded.NodesOfKind(kind))
+                got.push_back(node->loc.offset);
+            std::sort(want.begin(), want.end());
+            std::sort(got.begin(), got.end());
+            EXPECT_EQ(got, want) << tinycsharp::NodeKindToString(kind);
+        }
+
+        // back pointers are restored, and the type shared by x and y stays shared.
+        auto fields = decoded.NodesOfKind(tinycsharp::NodeKind::kFieldDecl);
+        auto *x = static_cast<tinycsharp::FieldDecl *>(fields[0]);
+        auto *y = static_cast<tinycsharp::FieldDecl *>(fields[1]);
+        EXPECT_EQ(x->type, y->type);
+        EXPECT_EQ(x->owner->name, "Point");
+        EXPECT_EQ(x->owner->ns->name, "Veal.Core.Inner");
+        EXPECT_EQ(x->owner->ns->outer->name, "Veal.Core");
+        EXPECT_EQ(x->owner->unit, copy);
+        auto classes = decoded.NodesOfKind(tinycsharp::NodeKind::kClassDecl);
+        auto *nested = static_cast<tinycsharp::ClassDecl *>(classes.back());
+        EXPECT_EQ(nested->outer->name, "Shape");
+        EXPECT_EQ(nested->ns->name, "Veal.Core");
+
+        EXPECT_THROW(tinycsharp::DecodeAst(blob.substr(0, blob.size() / 2), decoded, "shape.cs"), std::runtime_error);
+        EXPECT_THROW(tinycsharp::DecodeAst(blob + "x", decoded, "shape.cs"), std::runtime_error);
+    }
+
+    TEST_F(CacheTest, ShouldServeParsedTreesWithoutLexingOrParsing)
+    {
+        const std::string program = "class App { static int Main() { int n = 4; return n * Config.Scale; } }";
+        const std::string config = "class Config { public const int Scale = 3; }";
+        tinycsharp::CompilationCache cache{dir, 1 << 20};
+        for (int run = 0; run < 2; run++)
+        {
+            tinycsharp::Interner interner;
+            tinycsharp::AstContext ctx{interner};
+            std::size_t tokens = 0;
+            for (const std::string *text : {&program, &config})
+            {
+                tinycsharp::FileId id = ctx.sources().AddFile("app.cs", *text);
+                tinycsharp::ParseCached(cache, ctx, *text, "app.cs", ctx.sources().Begin(id), &tokens);
+            }
+            EXPECT_EQ(tokens, 12u);
+            tinycsharp::Sema sema{interner};
+            EXPECT_TRUE(sema.Analyze(ctx.units));
+        }
+        auto stats = cache.Stats();
+        EXPECT_EQ(stats.misses, 2u);
+        EXPECT_EQ(stats.stores, 2u);
+        EXPECT_EQ(stats.hits, 2u);
+
+        // a file that does not parse is not stored, and fails again.
+        tinycsharp::AstContext ctx;
+        EXPECT_THROW(tinycsharp::ParseCached(cache, ctx, "class {", "bad.cs"), tinycsharp::ParseError);
+        EXPECT_THROW(tinycsharp::ParseCached(cache, ctx, "class {", "bad.cs"), tinycsharp::ParseError);
+        EXPECT_EQ(cache.Stats().stores, 2u);
+    }
+
+}
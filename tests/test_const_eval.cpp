@@ -0,0 +1,222 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include <gtest/gtest.h>
+#include "ast.h"
+#include "const_eval.h"
+#include "parser.h"
+#include "sema.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace tinycsharp_test
+{
+
+    class ConstEvalTest : public ::testing::Test
+    {
+    protected:
+        tinycsharp::Interner interner;
+        tinycsharp::AstContext ctx{interner};
+        tinycsharp::Sema sema{interner};
+
+        bool Analyze(const std::vector<std::string> &sources)
+        {
+            int n = 0;
+            for (const auto &src : sources)
+            {
+                tinycsharp::Parser parser{ctx, src, "file" + std::to_string(n++) + ".cs"};
+                parser.ParseCompilationUnit();
+            }
+            return sema.Analyze(ctx.units);
+        }
+
+        std::vector<std::string> Messages() const
+        {
+            std::vector<std::string> out;
+            for (const auto &d : sema.diagnostics())
+            {
+                std::ostringstream ss;
+                ss << d;
+                out.push_back(ss.str());
+            }
+            return out;
+        }
+
+        const tinycsharp::ConstValue *Field(const std::string &cls, std::string_view name)
+        {
+            for (auto *field : sema.globals().FindClass(cls)->fields)
+            {
+                if (field->decl->name == name)
+                    return field->constant;
+            }
+            return nullptr;
+        }
+
+        const tinycsharp::ConstValue *Local(std::string_view name)
+        {
+            for (auto *node : ctx.NodesOfKind(tinycsharp::NodeKind::kLocalVarStmt))
+            {
+                auto *local = static_cast<tinycsharp::LocalVarStmt *>(node);
+                if (local->name == name)
+                    return local->init->constant;
+            }
+            return nullptr;
+        }
+    };
+
+    TEST_F(ConstEvalTest, ShouldFoldConstFieldsAcrossFiles)
+    {
+        ASSERT_TRUE(Analyze({R"(
+namespace App
+{
+    class Limits
+    {
+        public const int Retries = Config.Base * 3 + 1;
+        public const long Big = (long)int.MaxValue + 1;
+        public const double Ratio = Retries / 2.0;
+        public const float Scale = 2.5;
+    }
+}
+)",
+                             R"(
+namespace App
+{
+    class Config
+    {
+        public const int Base = 1 << 4;
+        public const string Name = "svc" + "-" + "api";
+        public const bool Verbose = Base > 10 && !(Base == 0);
+        public const int Masked = (Base | 3) ^ 1;
+    }
+}
+)"})) << ::testing::PrintToString(Messages());
+
+        EXPECT_EQ(Field("App.Config", "Base")->int_value, 16);
+        EXPECT_EQ(Field("App.Limits", "Retries")->int_value, 49);
+        EXPECT_EQ(Field("App.Limits", "Big")->int_value, 2147483648LL);
+        EXPECT_EQ(tinycsharp::TypeToString(Field("App.Limits", "Big")->type), "long");
+        EXPECT_DOUBLE_EQ(Field("App.Limits", "Ratio")->float_value, 24.5);
+        EXPECT_FLOAT_EQ(static_cast<float>(Field("App.Limits", "Scale")->float_value), 2.5f);
+        EXPECT_EQ(Field("App.Config", "Name")->string_value, "svc-api");
+        EXPECT_EQ(Field("App.Config", "Verbose")->int_value, 1);
+        EXPECT_EQ(Field("App.Config", "Masked")->int_value, 18);
+        EXPECT_TRUE(sema.globals().static_fields().empty());
+    }
+
+    TEST_F(ConstEvalTest, ShouldFoldConstantSubexpressionsInBodies)
+    {
+        ASSERT_TRUE(Analyze({R"(
+class Job
+{
+    const int Size = 64;
+    int Run(int n)
+    {
+        const int half = Size / 2;
+        var mask = half - 1;
+        var total = n * (Size * 4);
+        var label = "size=" + Size;
+        return mask + total;
+    }
+}
+)"})) << ::testing::PrintToString(Messages());
+
+        ASSERT_NE(Local("half"), nullptr);
+        EXPECT_EQ(Local("half")->int_value, 32);
+        ASSERT_NE(Local("mask"), nullptr);
+        EXPECT_EQ(Local("mask")->int_value, 31);
+        EXPECT_EQ(Local("total"), nullptr);
+        auto *total = ctx.NodesOfKind(tinycsharp::NodeKind::kLocalVarStmt)[2];
+        auto *mul = static_cast<tinycsharp::BinaryExpr *>(static_cast<tinycsharp::LocalVarStmt *>(total)->init);
+        ASSERT_NE(mul->rhs->constant, nullptr);
+        EXPECT_EQ(mul->rhs->constant->int_value, 256);
+        EXPECT_EQ(Local("label"), nullptr);
+    }
+
+    TEST_F(ConstEvalTest, ShouldReportOverflowDivisionByZeroAndCycles)
+    {
+        EXPECT_FALSE(Analyze({R"(
+class Bad
+{
+    const int Max = int.MaxValue + 1;
+    const int Zero = 0;
+    const int Div = 10 / Zero;
+    const long Wide = long.MinValue * -1;
+    const int A = B + 1;
+    const int B = A + 1;
+    static int Field = 4;
+    const int NotConst = Field;
+    int Run()
+    {
+        var x = (int)3000000000;
+        return 7 % (Zero * 2);
+    }
+}
+)"}));
+        auto messages = Messages();
+        std::vector<std::string> expected = {
+            "file0.cs:4:34: error: The operation overflows at compile time in checked mode",
+            "file0.cs:6:24: error: Division by constant zero",
+            "file0.cs:7:37: error: The operation overflows at compile time in checked mode",
+            "file0.cs:8:15: error: The evaluation of the constant value for 'Bad.A' involves a circular definition",
+            "file0.cs:11:26: error: The expression being assigned to 'Bad.NotConst' must be constant",
+            "file0.cs:14:17: error: Constant value '3000000000' cannot be converted to a 'int' (use 'unchecked' syntax to override)",
+            "file0.cs:15:18: error: Division by constant zero",
+        };
+        EXPECT_EQ(messages, expected);
+    }
+
+    TEST_F(ConstEvalTest, ShouldTypeNegatedLiteralsAsAWhole)
+    {
+        ASSERT_TRUE(Analyze({R"(
+class Limits
+{
+    const int IntMin = -2147483648;
+    const long LongMin = -9223372036854775808;
+    const long Wide = -2147483649;
+    const int Twice = -(-5);
+}
+)"}));
+        EXPECT_EQ(Field("Limits", "IntMin")->int_value, INT32_MIN);
+        EXPECT_EQ(Field("Limits", "LongMin")->int_value, INT64_MIN);
+        EXPECT_EQ(Field("Limits", "Wide")->int_value, -2147483649LL);
+        EXPECT_EQ(Field("Limits", "Twice")->int_value, 5);
+    }
+
+    TEST_F(ConstEvalTest, ShouldReportOverflowOnIntMinDividedByMinusOne)
+    {
+        EXPECT_FALSE(Analyze({R"(
+class Bad
+{
+    const int Quotient = -2147483648 / -1;
+}
+)"}));
+        std::vector<std::string> expected = {
+            "file0.cs:4:38: error: The operation overflows at compile time in checked mode",
+        };
+        EXPECT_EQ(Messages(), expected);
+    }
+
+    TEST_F(ConstEvalTest, ShouldRejectLongMinValueMagnitudeWithoutMinus)
+    {
+        EXPECT_THROW(Analyze({"class Bad { const long Big = 9223372036854775808; }"}), tinycsharp::ParseError);
+        EXPECT_THROW(Analyze({"class Bad { const long Big = 1 - 9223372036854775808; }"}), tinycsharp::ParseError);
+    }
+
+}
@@ -0,0 +1,165 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include <gtest/gtest.h>
+#include "bytecode.h"
+#include "corpus.h"
+#include "ir.h"
+#include "lexer.h"
+#include "parser.h"
+#include "passes.h"
+#include "sema.h"
+#include "vm.h"
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace tinycsharp_test
+{
+    using tinycsharp::CorpusGenerator;
+    using tinycsharp::CorpusOptions;
+
+    CorpusOptions Options(std::uint64_t seed, int files, int lines)
+    {
+        CorpusOptions options;
+        options.seed = seed;
+        options.files = files;
+        options.lines_per_file = lines;
+        return options;
+    }
+
+    std::size_t Lines(const std::string &text)
+    {
+        return static_cast<std::size_t>(std::count(text.begin(), text.end(), '\n'));
+    }
+
+    TEST(CorpusTest, IsAFunctionOfItsOptions)
+    {
+        CorpusGenerator generator{Options(7, 4, 200)};
+        auto files = generator.Files();
+        ASSERT_EQ(files.size(), 4u);
+        EXPECT_EQ(files[0].name, "file0.cs");
+
+        // any file can be made on its own, in any order.
+        EXPECT_EQ(generator.File(3).text, files[3].text);
+        EXPECT_EQ(CorpusGenerator{Options(7, 4, 200)}.File(1).text, files[1].text);
+        EXPECT_NE(CorpusGenerator{Options(8, 4, 200)}.File(1).text, files[1].text);
+        EXPECT_NE(files[0].text, files[1].text);
+
+        EXPECT_EQ(CorpusGenerator{Options(7, 12, 200)}.File(0).name, "file00.cs");
+        EXPECT_THROW(generator.File(4), std::out_of_range);
+        EXPECT_THROW(CorpusGenerator{Options(7, 0, 200)}, std::invalid_argument);
+        CorpusOptions dense = Options(7, 1, 200);
+        dense.comment_density = 1;
+        EXPECT_THROW(CorpusGenerator{dense}, std::invalid_argument);
+    }
+
+    TEST(CorpusTest, WritesExactlyTheLinesAskedFor)
+    {
+        for (int lines : {1, 10, 24, 25, 40, 173, 1000})
+        {
+            for (double density : {0.0, 0.1, 0.5})
+            {
+                CorpusOptions options = Options(static_cast<std::uint64_t>(lines), 3, lines);
+                options.comment_density = density;
+                options.max_depth = lines % 2 ? 5 : 0;
+                for (const auto &file : CorpusGenerator{options}.Files())
+                {
+                    if (lines >= 25)
+                    {
+                        EXPECT_EQ(Lines(file.text), static_cast<std::size_t>(lines)) << density;
+                    }
+                    else
+                    {
+                        EXPECT_LE(Lines(file.text), 25u) << density;
+                    }
+                }
+            }
+        }
+    }
+
+    TEST(CorpusTest, FollowsTheKnobs)
+    {
+        CorpusOptions options = Options(3, 3, 600);
+        options.identifier_length = 12;
+        options.comment_density = 0.3;
+        options.max_depth = 0;
+        std::size_t lines = 0;
+        std::size_t comments = 0;
+        for (const auto &file : CorpusGenerator{options}.Files())
+        {
+            EXPECT_EQ(Lines(file.text), 600u);
+            std::istringstream in(file.text);
+            bool block = false;
+            for (std::string line; std::getline(in, line); lines++)
+            {
+                std::string code = line.substr(std::min(line.find_first_not_of(' '), line.size()));
+                if (block || code.rfind("//", 0) == 0 || code.rfind("/*", 0) == 0)
+                    comments++;
+                block = (block || code.rfind("/*", 0) == 0) && code.find("*/") == std::string::npos;
+                // no nesting: straight-line methods.
+                EXPECT_NE(code.rfind("if (", 0), 0u) << line;
+                EXPECT_NE(code.rfind("while (", 0), 0u) << line;
+            }
+
+            tinycsharp::Lexer lexer{file.text};
+            for (const auto &token : lexer.Tokenize())
+            {
+                // the names made up, as opposed to those every file uses.
+                const std::string &name = token.lexeme;
+                if (token.kind == tinycsharp::TokenKind::kTIdent && std::isdigit(static_cast<unsigned char>(name.back())) &&
+                    name[0] != 'F')
+                {
+                    EXPECT_GE(name.size(), 12u) << name;
+                }
+            }
+        }
+        double density = static_cast<double>(comments) / static_cast<double>(lines);
+        EXPECT_NEAR(density, 0.3, 0.05);
+    }
+
+    TEST(CorpusTest, ChecksAndRuns)
+    {
+        for (std::uint64_t seed = 1; seed <= 3; seed++)
+        {
+            SCOPED_TRACE("seed " + std::to_string(seed));
+            CorpusOptions options = Options(seed, 6, 300);
+            options.max_depth = 4;
+            tinycsharp::AstContext ctx;
+            for (const auto &file : CorpusGenerator{options}.Files())
+                tinycsharp::Parser{ctx, file.text, file.name}.ParseCompilationUnit();
+            tinycsharp::Sema sema{ctx.interner()};
+            ASSERT_TRUE(sema.Analyze(ctx.units)) << sema.diagnostics()[0].message;
+
+            tinycsharp::IrModule module = tinycsharp::LowerToIr(sema.globals());
+            tinycsharp::PassManager passes;
+            passes.AddPipeline(tinycsharp::OptLevel::kO1);
+            passes.Run(module);
+            tinycsharp::BcProgram program = tinycsharp::CompileBytecode(module);
+            std::ostringstream out;
+            tinycsharp::Vm vm{program, out};
+            int first = vm.Run();
+            tinycsharp::Vm again{program, out};
+            EXPECT_EQ(again.Run(), first);
+        }
+    }
+
+}
@@ -0,0 +1,193 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include <gtest/gtest.h>
+#include "daemon.h"
+#include "sema.h"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+namespace tinycsharp_test
+{
+
+    TEST(FrontEndCacheTest, ShouldReuseTreesOfUnchangedFiles)
+    {
+        tinycsharp::FrontEndCache cache;
+        const std::string a = "class A { public static int F() { return B.G() + 1; } }";
+        const std::string b = "class B { public static int G() { return 41; } }";
+        const auto *first = &cache.Parse("a.cs", a);
+        cache.Parse("b.cs", b);
+        EXPECT_EQ(&cache.Parse("a.cs", a), first);
+        EXPECT_EQ(cache.stats().hits, 1u);
+        EXPECT_EQ(cache.stats().misses, 2u);
+        EXPECT_GT(first->tokens, 0u);
+
+        // every compilation analyzes the cached trees afresh.
+        for (int i = 0; i < 2; i++)
+        {
+            std::vector<tinycsharp::CompilationUnit *> units;
+            for (const char *path : {"a.cs", "b.cs"})
+            {
+                const auto &file = cache.Parse(path, path[0] == 'a' ? a : b);
+                units.insert(units.end(), file.ast->units.begin(), file.ast->units.end());
+            }
+            tinycsharp::Sema sema{cache.interner()};
+            EXPECT_TRUE(sema.Analyze(units));
+        }
+
+        // a changed file is parsed again; a broken one leaves nothing behind.
+        EXPECT_NE(cache.Parse("b.cs", b + "\n").source, b);
+        EXPECT_THROW(cache.Parse("a.cs", "class A {"), std::exception);
+        std::uint64_t misses = cache.stats().misses;
+        cache.Parse("a.cs", a);
+        EXPECT_EQ(cache.stats().misses, misses + 1);
+    }
+
+    // a kept tree must not hold on to what an earlier analysis bound it to:
+    // the file it pointed into may have been parsed again since.
+    TEST(FrontEndCacheTest, ShouldForgetBindingsIntoReplacedTrees)
+    {
+        tinycsharp::FrontEndCache cache;
+        const std::string a = "class A { const int C = Other.K + 1; public static int F() { int x = C; return Other.G() + x; } }";
+        const std::string b = "class Other { public const int K = 4; public static int G() { return K; } }";
+        std::string renamed = b;
+        renamed.replace(renamed.find("Other"), 5, "Other2");
+        auto compile = [&](const std::vector<std::pair<std::string, std::string>> &files)
+        {
+            std::vector<tinycsharp::CompilationUnit *> units;
+            for (const auto &[path, source] : files)
+            {
+                try
+                {
+                    const auto &file = cache.Parse(path, source);
+                    units.insert(units.end(), file.ast->units.begin(), file.ast->units.end());
+                }
+                catch (const std::exception &)
+                {
+                }
+            }
+            tinycsharp::Sema sema{cache.interner()};
+            return sema.Analyze(units);
+        };
+
+        EXPECT_TRUE(compile({{"a.cs", a}, {"b.cs", b}}));
+        EXPECT_FALSE(compile({{"a.cs", a}, {"b.cs", "class Other {"}}));
+        EXPECT_TRUE(compile({{"a.cs", a}, {"b.cs", b}}));
+        EXPECT_FALSE(compile({{"a.cs", a}, {"b.cs", renamed}}));
+        EXPECT_TRUE(compile({{"a.cs", a}, {"b.cs", b}}));
+        EXPECT_FALSE(compile({{"a.cs", a}}));
+        EXPECT_TRUE(compile({{"a.cs", a}, {"b.cs", b}}));
+        EXPECT_EQ(cache.stats().hits, 7u);
+    }
+
+    TEST(FrontEndCacheTest, ShouldStartOverOnceTheSourcesAreMostlyUnused)
+    {
+        tinycsharp::FrontEndCache cache;
+        std::string source = "class A { public static int F() { return 1; } }";
+        cache.Parse("a.cs", source);
+        for (int i = 0; i < 8; i++)
+        {
+            source += "\n";
+            cache.Parse("a.cs", source);
+        }
+        std::uint64_t used = cache.sources().AddressSpaceUsed();
+        EXPECT_TRUE(cache.sources().Text(0).empty());
+        cache.Trim(used);
+        EXPECT_EQ(cache.stats().trims, 0u);
+        cache.Trim(source.size());
+        EXPECT_EQ(cache.stats().trims, 1u);
+        EXPECT_EQ(cache.sources().FileCount(), 0u);
+        cache.Parse("a.cs", source);
+        EXPECT_EQ(cache.stats().hits, 0u);
+        EXPECT_EQ(cache.sources().AddressSpaceUsed(), source.size() + 1);
+    }
+
+    TEST(DaemonTest, ShouldServeRequestsUntilShutdown)
+    {
+#if !defined(__unix__) && !defined(__APPLE__)
+        GTEST_SKIP() << "no Unix domain sockets";
+#endif
+        std::string socket = ::testing::TempDir() + "tinycsharp_" + std::to_string(::getpid()) + ".sock";
+        int requests = 0;
+        std::thread server(
+            [&]
+            {
+                tinycsharp::ServeDaemon(socket,
+                                        [&](const std::vector<std::string> &args, std::ostream &out, std::ostream &err)
+                                        {
+                                            requests++;
+                                            out << std::filesystem::current_path().string() << ":";
+                                            for (const auto &arg : args)
+                                                out << " " << arg;
+                                            err << "done\n";
+                                            return static_cast<int>(args.size());
+                                        });
+            });
+
+        std::ostringstream out, err;
+        std::optional<int> status;
+        for (int attempt = 0; attempt < 500 && !status; attempt++)
+        {
+            status = tinycsharp::SendToDaemon(socket, {"run", "a b.cs"}, out, err);
+            if (!status)
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        ASSERT_TRUE(status.has_value());
+        EXPECT_EQ(*status, 2);
+        EXPECT_EQ(out.str(), std::filesystem::current_path().string() + ": run a b.cs");
+        EXPECT_EQ(err.str(), "done\n");
+
+#if defined(__unix__) || defined(__APPLE__)
+        // a request claiming 2^32 - 1 arguments is dropped, and the daemon
+        // keeps serving.
+        {
+            int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            sockaddr_un addr{};
+            addr.sun_family = AF_UNIX;
+            std::strncpy(addr.sun_path, socket.c_str(), sizeof addr.sun_path - 1);
+            ASSERT_EQ(::connect(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof addr), 0);
+            const unsigned char request[] = {0x74, 0x73, 0x64, 0x31, 0, 0, 0, 0, 0xff, 0xff, 0xff, 0xff};
+            ASSERT_EQ(::write(fd, request, sizeof request), static_cast<ssize_t>(sizeof request));
+            char reply;
+            EXPECT_LE(::read(fd, &reply, 1), 0);
+            ::close(fd);
+        }
+        out.str("");
+        err.str("");
+        EXPECT_EQ(tinycsharp::SendToDaemon(socket, {"check"}, out, err), std::optional<int>(1));
+#endif
+
+        std::ostringstream ignored;
+        EXPECT_EQ(tinycsharp::SendToDaemon(socket, {"--shutdown"}, ignored, ignored), std::optional<int>(0));
+        server.join();
+        EXPECT_EQ(requests, 2);
+        EXPECT_FALSE(std::filesystem::exists(socket));
+        EXPECT_FALSE(tinycsharp::SendToDaemon(socket, {"x"}, ignored, ignored).has_value());
+    }
+
+}
@@ -0,0 +1,274 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include <gtest/gtest.h>
+#include "runtime.h"
+
+#include <string>
+#include <vector>
+
+namespace tinycsharp_test
+{
+    using tinycsharp::Heap;
+    using tinycsharp::IntValue;
+    using tinycsharp::IrType;
+    using tinycsharp::Object;
+    using tinycsharp::Payload;
+    using tinycsharp::RefValue;
+
+    class HeapTest : public ::testing::Test
+    {
+    protected:
+        HeapTest()
+        {
+            // class 0: a list node, slot 0 the next node, slot 1 a value.
+            tinycsharp::BcClass node;
+            node.name = "Node";
+            node.num_slots = 2;
+            node.ref_slots = {0};
+            program.classes.push_back(node);
+        }
+
+        void Start(std::size_t eden_bytes)
+        {
+            heap = std::make_unique<Heap>(program, eden_bytes);
+            heap->SetRoots([this](const Heap::RootVisitor &visit)
+                           {
+                               for (Object *&root : roots)
+                                   visit(root); });
+        }
+
+        Object *Node(Object *next, std::int64_t value)
+        {
+            roots.push_back(next);
+            Object *node = heap->NewInstance(0);
+            next = roots.back();
+            roots.pop_back();
+            Payload(node)[0] = RefValue(next);
+            Payload(node)[1] = IntValue(value);
+            heap->WriteBarrier(node, next);
+            return node;
+        }
+
+        // a list of count nodes valued count-1 down to 0, as roots[slot].
+        void BuildList(std::size_t slot, int count)
+        {
+            for (int i = 0; i < count; i++)
+                roots[slot] = Node(roots[slot], i);
+        }
+
+        static std::int64_t Sum(const Object *node)
+        {
+            std::int64_t sum = 0;
+            for (; node; node = Payload(node)[0].ref)
+                sum += Payload(node)[1].i;
+            return sum;
+        }
+
+        void Garbage(int count)
+        {
+            for (int i = 0; i < count; i++)
+                heap->NewInstance(0);
+        }
+
+        tinycsharp::BcProgram program;
+        std::unique_ptr<Heap> heap;
+        std::vector<Object *> roots;
+    };
+
+    TEST_F(HeapTest, ShouldBumpAllocateZeroedObjectsInTheNursery)
+    {
+        Start(64 * 1024);
+        Object *a = heap->NewInstance(0);
+        Object *b = heap->NewInstance(0);
+        EXPECT_TRUE(heap->IsYoung(a));
+        EXPECT_EQ(reinterpret_cast<char *>(b) - reinterpret_cast<char *>(a), 32);
+        EXPECT_EQ(Payload(b)[0].ref, nullptr);
+        EXPECT_EQ(Payload(b)[1].i, 0);
+        EXPECT_EQ(heap->stats().objects_allocated, 2u);
+        EXPECT_EQ(heap->stats().bytes_allocated, 64u);
+        EXPECT_EQ(heap->stats().collections, 0u);
+    }
+
+    TEST_F(HeapTest, ShouldCountAllocationsPerHeapOnOneThread)
+    {
+        // each heap has its own buffer on the thread, so switching between
+        // them loses none of either's allocations.
+        Start(64 * 1024);
+        Heap other{program, 64 * 1024};
+        for (int i = 0; i < 100; i++)
+        {
+            heap->NewInstance(0);
+            other.NewInstance(0);
+            other.NewInstance(0);
+        }
+        EXPECT_EQ(heap->stats().objects_allocated, 100u);
+        EXPECT_EQ(heap->stats().bytes_allocated, 3200u);
+        EXPECT_EQ(other.stats().objects_allocated, 200u);
+        EXPECT_EQ(other.stats().bytes_allocated, 6400u);
+    }
+
+    TEST_F(HeapTest, ShouldCopySurvivorsAndPromoteThemWithAge)
+    {
+        Start(4096);
+        roots.assign(1, nullptr);
+        BuildList(0, 10);
+        Object *before = roots[0];
+        heap->CollectMinor();
+        EXPECT_NE(roots[0], before);
+        EXPECT_TRUE(heap->IsYoung(roots[0]));
+        EXPECT_EQ(Sum(roots[0]), 45);
+        EXPECT_EQ(heap->stats().bytes_promoted, 0u);
+
+        heap->CollectMinor();
+        EXPECT_FALSE(heap->IsYoung(roots[0]));
+        EXPECT_EQ(Sum(roots[0]), 45);
+        EXPECT_EQ(heap->stats().bytes_promoted, 10u * 32);
+        EXPECT_EQ(heap->stats().minor_collections, 2u);
+
+        // what does not fit the survivor space is promoted early.
+        roots[0] = nullptr;
+        BuildList(0, 40);
+        heap->CollectMinor();
+        EXPECT_EQ(Sum(roots[0]), 780);
+        EXPECT_EQ(heap->stats().bytes_promoted, (10u + 40 - 512 / 32) * 32);
+    }
+
+    TEST_F(HeapTest, ShouldReclaimShortLivedObjectsWithoutPromotingThem)
+    {
+        Start(4096);
+        roots.assign(1, nullptr);
+        BuildList(0, 10);
+        Garbage(10000);
+        EXPECT_GT(heap->stats().minor_collections, 50u);
+        EXPECT_EQ(heap->stats().major_collections, 0u);
+        EXPECT_EQ(heap->stats().bytes_promoted, 10u * 32);
+        EXPECT_EQ(Sum(roots[0]), 45);
+        EXPECT_LT(heap->stats().live_bytes, 8192u);
+    }
+
+    TEST_F(HeapTest, ShouldKeepYoungObjectsReachableOnlyFromOldOnes)
+    {
+        Start(4096);
+        roots.assign(1, nullptr);
+        roots[0] = heap->NewArray(IrType::kRef, 8);
+        heap->CollectMinor();
+        heap->CollectMinor();
+        Object *array = roots[0];
+        ASSERT_FALSE(heap->IsYoung(array));
+        for (std::int64_t i = 0; i < 8; i++)
+        {
+            Object *node = Node(nullptr, i + 1);
+            array = roots[0];
+            Payload(array)[i] = RefValue(node);
+            heap->WriteBarrier(array, node);
+        }
+        Garbage(1000);
+        std::int64_t sum = 0;
+        for (int i = 0; i < 8; i++)
+            sum += Sum(Payload(roots[0])[i].ref);
+        EXPECT_EQ(sum, 36);
+        EXPECT_GT(heap->stats().minor_collections, 2u);
+    }
+
+    TEST_F(HeapTest, ShouldCompactTheOldGenerationAndRewriteReferences)
+    {
+        Start(4096);
+        roots.assign(4, nullptr);
+        for (std::size_t i = 0; i < roots.size(); i++)
+            BuildList(i, 200);
+        heap->CollectMinor();
+        heap->CollectMinor();
+        std::size_t live = heap->stats().live_bytes;
+        roots[0] = nullptr;
+        roots[2] = nullptr;
+        heap->Collect();
+        EXPECT_EQ(heap->stats().major_collections, 1u);
+        EXPECT_EQ(heap->stats().live_bytes, 2u * 200 * 32);
+        EXPECT_LT(heap->stats().live_bytes, live);
+        EXPECT_EQ(Sum(roots[1]), 19900);
+        EXPECT_EQ(Sum(roots[3]), 19900);
+    }
+
+    TEST_F(HeapTest, ShouldAllocateLargeObjectsInTheOldGeneration)
+    {
+        Start(4096);
+        Object *array = heap->NewArray(IrType::kI64, 1000);
+        EXPECT_FALSE(heap->IsYoung(array));
+        EXPECT_EQ(Payload(array)[999].i, 0);
+    }
+
+    TEST_F(HeapTest, ShouldGrowTheOldGenerationForLiveData)
+    {
+        Start(1024);
+        roots.assign(1, nullptr);
+        // 3MB of live nodes against a 1MB initial old generation.
+        BuildList(0, 100000);
+        EXPECT_GT(heap->stats().major_collections, 0u);
+        EXPECT_EQ(Sum(roots[0]), 100000ll * 99999 / 2);
+        Object *node = roots[0];
+        for (std::int64_t i = 99999; node; node = Payload(node)[0].ref, i--)
+            ASSERT_EQ(Payload(node)[1].i, i);
+    }
+
+    TEST_F(HeapTest, ShouldUpdateReferencesTheHeapHoldsDuringAllocation)
+    {
+        Start(1024);
+        roots.assign(1, nullptr);
+        roots[0] = heap->NewString(std::string_view("result"));
+        roots.push_back(nullptr);
+        for (int i = 0; i < 200; i++)
+            roots[1] = heap->NewTask(true, roots[0]);
+        EXPECT_EQ(Payload(roots[1])[0].ref, roots[0]);
+        EXPECT_EQ(tinycsharp::StringView(roots[0]), "result");
+    }
+
+    TEST_F(HeapTest, ShouldKeepImageStringsOutOfTheCollectedHeap)
+    {
+        Start(1024);
+        tinycsharp::StringImage image({"hello", "world"});
+        roots.assign(1, image.Literal(1));
+        roots.push_back(heap->NewRope(image.Literal(0), roots[0]));
+        Garbage(100);
+        heap->Collect();
+        EXPECT_EQ(roots[0], image.Literal(1));
+        EXPECT_EQ(Payload(roots[1])[0].ref, image.Literal(0));
+        EXPECT_EQ(tinycsharp::StringText(roots[1]), "helloworld");
+        EXPECT_EQ(tinycsharp::StringView(image.Char('x')), "x");
+        EXPECT_EQ(image.Empty()->info, 0u);
+    }
+
+    TEST_F(HeapTest, ShouldMoveRopesWithTheirPieces)
+    {
+        Start(4096);
+        roots.assign(1, heap->NewString(std::string_view("a")));
+        std::string expected = "a";
+        for (int i = 0; i < 5000; i++)
+        {
+            std::string piece = std::to_string(i % 10);
+            Object *s = heap->NewString(piece);
+            roots[0] = heap->NewRope(roots[0], s);
+            expected += piece;
+        }
+        EXPECT_GT(heap->stats().collections, 10u);
+        EXPECT_EQ(roots[0]->info, expected.size());
+        EXPECT_FALSE(tinycsharp::IsFlat(roots[0]));
+        EXPECT_EQ(tinycsharp::StringText(roots[0]), expected);
+    }
+
+}
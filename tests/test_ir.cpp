@@ -0,0 +1,243 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include <gtest/gtest.h>
+#include "ir.h"
+#include "parser.h"
+#include "sema.h"
+#include "thread_pool.h"
+
+#include <sstream>
+#include <string>
+
+namespace tinycsharp_test
+{
+
+    class IrTest : public ::testing::Test
+    {
+    protected:
+        tinycsharp::Interner interner;
+        tinycsharp::AstContext ctx{interner};
+        tinycsharp::Sema sema{interner};
+        tinycsharp::IrModule module;
+
+        void Lower(const std::string &source, tinycsharp::ThreadPool *pool = nullptr)
+        {
+            tinycsharp::Parser parser{ctx, source, "test.cs"};
+            parser.ParseCompilationUnit();
+            ASSERT_TRUE(sema.Analyze(ctx.units)) << (sema.diagnostics().empty() ? "" : sema.diagnostics()[0].message);
+            module = tinycsharp::LowerToIr(sema.globals(), pool);
+            for (const auto &fn : module.functions)
+            {
+                if (fn)
+                {
+                    ASSERT_EQ(tinycsharp::VerifyIr(*fn), "") << Dump(*fn);
+                }
+            }
+        }
+
+        const tinycsharp::IrFunction &Function(std::string_view name)
+        {
+            for (auto *method : sema.globals().methods())
+            {
+                if (method->decl->name == name)
+                    return *module.functions[method->id];
+            }
+            throw std::runtime_error("no method " + std::string(name));
+        }
+
+        static std::string Dump(const tinycsharp::IrFunction &fn)
+        {
+            std::ostringstream out;
+            tinycsharp::PrintIr(out, fn);
+            return out.str();
+        }
+
+        static int Count(const tinycsharp::IrFunction &fn, tinycsharp::IrOp op)
+        {
+            int n = 0;
+            for (tinycsharp::ValueId v = 0; v < fn.NumInsts(); v++)
+                n += fn.Inst(v).op == op;
+            return n;
+        }
+    };
+
+    TEST_F(IrTest, ShouldLowerStraightLineCode)
+    {
+        Lower("class C { static long Add(int a, long b) { return a + b; } }");
+        const auto &fn = Function("Add");
+        ASSERT_EQ(fn.NumBlocks(), 1u);
+        ASSERT_EQ(fn.NumInsts(), 5u) << Dump(fn);
+        EXPECT_EQ(fn.Inst(0).op, tinycsharp::IrOp::kParam);
+        EXPECT_EQ(fn.Inst(2).op, tinycsharp::IrOp::kConvert);
+        EXPECT_EQ(fn.Inst(3).op, tinycsharp::IrOp::kAdd);
+        EXPECT_EQ(fn.Inst(3).type, tinycsharp::IrType::kI64);
+        EXPECT_EQ(fn.Inst(3).a, 2u);
+        EXPECT_EQ(fn.Inst(3).b, 1u);
+        EXPECT_EQ(fn.Inst(4).op, tinycsharp::IrOp::kReturn);
+        EXPECT_EQ(fn.Inst(4).a, 3u);
+    }
+
+    TEST_F(IrTest, ShouldPlacePhisOnlyWhereDefinitionsMeet)
+    {
+        Lower(R"(
+class C
+{
+    static int Sum(int n)
+    {
+        int s = 0;
+        int i = 0;
+        int k = 7;
+        while (i < n)
+        {
+            s = s + i * k;
+            i = i + 1;
+        }
+        return s;
+    }
+})");
+        const auto &fn = Function("Sum");
+        // s and i change in the loop; k and n do not.
+        EXPECT_EQ(Count(fn, tinycsharp::IrOp::kPhi), 2) << Dump(fn);
+        for (tinycsharp::BlockId b = 0; b < fn.NumBlocks(); b++)
+        {
+            const auto &block = fn.Block(b);
+            if (fn.Inst(block.begin).op == tinycsharp::IrOp::kPhi)
+            {
+                EXPECT_EQ(block.pred_count, 2u);
+            }
+        }
+    }
+
+    TEST_F(IrTest, ShouldMergeBranchesWithPhis)
+    {
+        Lower(R"(
+class C
+{
+    static int Pick(bool c, int a)
+    {
+        int x = a;
+        int y = 1;
+        if (c)
+            x = 2;
+        else
+            x = 3;
+        if (a > 0 && c)
+            y = a;
+        return x + y;
+    }
+})");
+        const auto &fn = Function("Pick");
+        EXPECT_EQ(Count(fn, tinycsharp::IrOp::kPhi), 2) << Dump(fn);
+        // && becomes control flow rather than a value.
+        EXPECT_EQ(Count(fn, tinycsharp::IrOp::kAnd), 0);
+    }
+
+    TEST_F(IrTest, ShouldLoadFoldedConstantsAndDropDeadCode)
+    {
+        Lower(R"(
+class C
+{
+    const int K = 6;
+    static int F()
+    {
+        return K * 7 + 1;
+        int unreachable = 5;
+        return unreachable;
+    }
+})");
+        const auto &fn = Function("F");
+        ASSERT_EQ(fn.NumInsts(), 2u) << Dump(fn);
+        EXPECT_EQ(fn.Inst(0).op, tinycsharp::IrOp::kConst);
+        EXPECT_EQ(fn.Inst(0).Imm(), 43);
+    }
+
+    TEST_F(IrTest, ShouldLowerObjectsAndInitializers)
+    {
+        Lower(R"(
+class Base
+{
+    public int a = 1;
+    public Base() { a = a + 1; }
+}
+class Derived : Base
+{
+    public static int count = 10;
+    public int b;
+    public Derived(int v) { b = v; }
+    public virtual int Get() { return a + b; }
+    public static int Make() { Derived d = new Derived(5); count++; return d.Get(); }
+}
+)");
+        auto *derived = sema.globals().FindClass("Derived");
+        auto *base = sema.globals().FindClass("Base");
+        ASSERT_GE(module.instance_init[derived->id], 0);
+        EXPECT_GE(module.instance_init[base->id], 0);
+        ASSERT_GE(module.static_init, 0);
+        EXPECT_EQ(Count(*module.functions[module.static_init], tinycsharp::IrOp::kStoreStatic), 1);
+
+        const auto &make = Function("Make");
+        EXPECT_EQ(Count(make, tinycsharp::IrOp::kNewObject), 1) << Dump(make);
+        EXPECT_EQ(Count(make, tinycsharp::IrOp::kCallInit), 1);
+        EXPECT_EQ(Count(make, tinycsharp::IrOp::kCallVirtual), 1);
+        EXPECT_EQ(Count(make, tinycsharp::IrOp::kStoreStatic), 1);
+
+        // the derived constructor runs the base one first.
+        const auto &ctor = *module.functions[derived->ctors[0]->id];
+        ASSERT_EQ(Count(ctor, tinycsharp::IrOp::kCall), 1) << Dump(ctor);
+    }
+
+    TEST_F(IrTest, ShouldLowerInParallelDeterministically)
+    {
+        std::string source = "class C {\n";
+        for (int i = 0; i < 40; i++)
+        {
+            source += "static int F" + std::to_string(i) + "(int n) { int s = 0; while (n > 0) { s = s + n % " +
+                      std::to_string(i + 2) + "; n = n - 1; } return s; }\n";
+        }
+        source += "}\n";
+        tinycsharp::ThreadPool pool{4};
+        Lower(source, &pool);
+        std::ostringstream parallel;
+        tinycsharp::PrintIr(parallel, module);
+        tinycsharp::IrModule serial = tinycsharp::LowerToIr(sema.globals());
+        std::ostringstream expected;
+        tinycsharp::PrintIr(expected, serial);
+        EXPECT_EQ(parallel.str(), expected.str());
+    }
+
+    TEST_F(IrTest, ShouldRoundTripThroughTheBuilder)
+    {
+        Lower(R"(
+class C
+{
+    static string Describe(int n)
+    {
+        string s = "-";
+        do { s = s + n; n = n / 2; } while (n != 0);
+        return n > 3 ? s : "small";
+    }
+})");
+        const auto &fn = Function("Describe");
+        tinycsharp::IrBuilder builder{fn};
+        auto copy = builder.Finalize();
+        EXPECT_EQ(tinycsharp::VerifyIr(*copy), "");
+        EXPECT_EQ(Dump(*copy), Dump(fn));
+    }
+
+}
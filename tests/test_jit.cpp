@@ -0,0 +1,368 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include <gtest/gtest.h>
+#include "bytecode.h"
+#include "ir.h"
+#include "jit.h"
+#include "parser.h"
+#include "passes.h"
+#include "sema.h"
+#include "vm.h"
+
+#include <sstream>
+#include <string>
+
+namespace tinycsharp_test
+{
+
+    // runs programs interpreted and compiled, which must agree exactly:
+    // output, exit code and the text of any unhandled exception.
+    class JitTest : public ::testing::Test
+    {
+    protected:
+        tinycsharp::Interner interner;
+        tinycsharp::AstContext ctx{interner};
+        tinycsharp::Sema sema{interner};
+        tinycsharp::IrModule module;
+        tinycsharp::BcProgram program;
+
+        struct Outcome
+        {
+            std::string output;
+            int exit_code = 0;
+            std::string error;
+            tinycsharp::VmStats stats;
+        };
+
+        void SetUp() override
+        {
+            if (!tinycsharp::Jit::Supported())
+                GTEST_SKIP() << "no JIT on this platform";
+        }
+
+        void Compile(const std::string &source)
+        {
+            tinycsharp::Parser parser{ctx, source, "test.cs"};
+            parser.ParseCompilationUnit();
+            ASSERT_TRUE(sema.Analyze(ctx.units)) << (sema.diagnostics().empty() ? "" : sema.diagnostics()[0].message);
+            module = tinycsharp::LowerToIr(sema.globals());
+            tinycsharp::PassManager passes;
+            passes.AddPipeline(tinycsharp::OptLevel::kO1);
+            passes.Run(module);
+            program = tinycsharp::CompileBytecode(module);
+        }
+
+        Outcome Run(tinycsharp::Vm::Options options)
+        {
+            Outcome outcome;
+            std::ostringstream out;
+            tinycsharp::Vm vm{program, out, options};
+            try
+            {
+                outcome.exit_code = vm.Run();
+            }
+            catch (const tinycsharp::VmError &e)
+            {
+                outcome.error = e.what();
+            }
+            outcome.output = out.str();
+            outcome.stats = vm.stats();
+            return outcome;
+        }
+
+        // compiles source and runs it interpreted, with every function
+        // compiled on its first call and with the default threshold,
+        // expecting the same outcome each time. returns the eager run.
+        Outcome Differential(const std::string &source)
+        {
+            Compile(source);
+            tinycsharp::Vm::Options interpreted;
+            interpreted.jit = false;
+            tinycsharp::Vm::Options eager;
+            eager.jit_threshold = 1;
+            Outcome expected = Run(interpreted);
+            Outcome compiled = Run(eager);
+            Outcome tiered = Run(tinycsharp::Vm::Options{});
+            EXPECT_EQ(expected.stats.jit_functions, 0u);
+            for (const Outcome *actual : {&compiled, &tiered})
+            {
+                EXPECT_EQ(actual->output, expected.output);
+                EXPECT_EQ(actual->exit_code, expected.exit_code);
+                EXPECT_EQ(actual->error, expected.error);
+            }
+            return compiled;
+        }
+    };
+
+    TEST_F(JitTest, ShouldMatchTheInterpreterOnIntegerArithmetic)
+    {
+        Outcome out = Differential(R"(
+class Program
+{
+    static int Mix(int a, int b)
+    {
+        int r = a * 31 + b;
+        r = r ^ (r >> 3);
+        r = r | (b << 7);
+        r = r & 2147483647;
+        return r - a / (b | 1) + a % 7;
+    }
+    static int Main()
+    {
+        int h = 17;
+        long l = 1;
+        int i = 0;
+        while (i < 5000)
+        {
+            h = Mix(h, i) + (i << 29);
+            l = l * 6364136223846793005 + i;
+            l = l ^ (l >> 17);
+            i++;
+        }
+        int wrap = 2147483647;
+        wrap = wrap + i;
+        System.Console.WriteLine(h + " " + l + " " + wrap + " " + (-h) + " " + (-7 / 2) + " " + (-7 % 2));
+        return h & 127;
+    }
+}
+)");
+        EXPECT_GT(out.stats.jit_functions, 0u);
+        EXPECT_GT(out.stats.native_entries, 0u);
+    }
+
+    TEST_F(JitTest, ShouldMatchTheInterpreterOnFloatingPoint)
+    {
+        Differential(R"(
+class Program
+{
+    static void Main()
+    {
+        double d = 0.5;
+        float f = (float)1.25;
+        double nan = 0.0 / 0.0;
+        int lt = 0;
+        int i = 1;
+        while (i < 3000)
+        {
+            d = d * 1.0001 + 1.0 / i - d % 3.0;
+            f = f * (float)0.999 + (float)0.5 - f % (float)2.0;
+            if (d < 100.0 && !(nan < d) && nan != nan && !(nan == nan))
+                lt++;
+            if (-f <= (float)0.0)
+                lt += 2;
+            i++;
+        }
+        int truncated = (int)d;
+        long big = (long)(d * 100000000000000000000.0);
+        int nanint = (int)nan;
+        System.Console.WriteLine(d + " " + f + " " + lt + " " + truncated + " " + big + " " + nanint + " " + (double)i);
+    }
+}
+)");
+    }
+
+    TEST_F(JitTest, ShouldMatchTheInterpreterOnArraysFieldsAndStatics)
+    {
+        Outcome out = Differential(R"(
+class Node
+{
+    public Node next;
+    public int value;
+    public double weight;
+}
+class Program
+{
+    static int total;
+    static double mass;
+    static void Main()
+    {
+        int[] counts = new int[16];
+        string text = "the quick brown fox jumps over the lazy dog";
+        Node head = null;
+        int i = 0;
+        while (i < 2000)
+        {
+            char c = text[i % text.Length];
+            counts[c & 15] += 1;
+            total += c;
+            Node n = new Node();
+            n.value = i;
+            n.weight = i * 0.5;
+            n.next = head;
+            head = n;
+            mass += n.weight;
+            i++;
+        }
+        int sum = 0;
+        Node p = head;
+        while (p != null)
+        {
+            sum += p.value;
+            p.value += 1;
+            p = p.next;
+        }
+        int j = 0;
+        while (j < counts.Length)
+        {
+            System.Console.Write(counts[j] + ",");
+            j++;
+        }
+        System.Console.WriteLine(" " + total + " " + mass + " " + sum + " " + head.value);
+    }
+}
+)");
+        EXPECT_GT(out.stats.native_entries, 0u);
+    }
+
+    TEST_F(JitTest, ShouldEnterHotLoopsOnStackReplacement)
+    {
+        Compile(R"(
+class Program
+{
+    static long Main()
+    {
+        long sum = 0;
+        int i = 0;
+        while (i < 100000)
+        {
+            int j = 0;
+            while (j < 10)
+            {
+                sum += i * j;
+                j++;
+            }
+            i++;
+        }
+        return sum % 1000;
+    }
+}
+)");
+        tinycsharp::Vm::Options interpreted;
+        interpreted.jit = false;
+        Outcome expected = Run(interpreted);
+        Outcome tiered = Run(tinycsharp::Vm::Options{});
+        EXPECT_EQ(tiered.exit_code, expected.exit_code);
+        // Main runs once, so only its back edges make it hot.
+        EXPECT_EQ(tiered.stats.jit_functions, 1u);
+        EXPECT_GT(tiered.stats.native_entries, 0u);
+        EXPECT_LT(tiered.stats.instructions * 100, expected.stats.instructions);
+    }
+
+    TEST_F(JitTest, ShouldReportFaultsInNativeCodeLikeTheInterpreter)
+    {
+        Outcome out = Differential(R"(
+class Program
+{
+    static int Step(int[] data, int i)
+    {
+        return data[i] / (100 - i);
+    }
+    static void Main()
+    {
+        int[] data = new int[200];
+        int i = 0;
+        int sum = 0;
+        while (i < 200)
+        {
+            data[i] = i * 3;
+            sum += Step(data, i);
+            i++;
+        }
+        System.Console.WriteLine(sum);
+    }
+}
+)");
+        EXPECT_NE(out.error.find("System.DivideByZeroException"), std::string::npos);
+        EXPECT_NE(out.error.find("Step"), std::string::npos);
+    }
+
+    TEST_F(JitTest, ShouldLeaveOverflowingDivisionToTheInterpreter)
+    {
+        Outcome out = Differential(R"(
+class Program
+{
+    static void Main()
+    {
+        int x = -2147483647;
+        x = x - 1;
+        int sum = 0;
+        int k = 0;
+        while (k < 2000)
+        {
+            sum += x / (k - 999);
+            k++;
+        }
+        System.Console.WriteLine(sum);
+    }
+}
+)");
+        EXPECT_NE(out.error.find("System.OverflowException"), std::string::npos);
+    }
+
+    TEST_F(JitTest, ShouldKeepReferencesStoredByNativeCodeAcrossCollections)
+    {
+        Compile(R"(
+class Box
+{
+    public Box inner;
+    public int id;
+}
+class Program
+{
+    static Box kept;
+    static void Main()
+    {
+        Box[] boxes = new Box[64];
+        int i = 0;
+        while (i < 20000)
+        {
+            Box b = new Box();
+            b.id = i;
+            b.inner = boxes[i % 64];
+            boxes[i % 64] = b;
+            if (i % 1000 == 0)
+                kept = b;
+            i++;
+        }
+        int depth = 0;
+        Box p = boxes[5];
+        while (p != null)
+        {
+            depth++;
+            p = p.inner;
+        }
+        System.Console.WriteLine(depth + " " + kept.id + " " + kept.inner.id);
+    }
+}
+)");
+        tinycsharp::Vm::Options interpreted;
+        interpreted.jit = false;
+        interpreted.gc_threshold = 4096;
+        tinycsharp::Vm::Options eager = interpreted;
+        eager.jit = true;
+        eager.jit_threshold = 1;
+        Outcome expected = Run(interpreted);
+        Outcome compiled = Run(eager);
+        EXPECT_EQ(expected.output, "313 19000 18936\n");
+        EXPECT_EQ(compiled.output, expected.output);
+        EXPECT_EQ(compiled.error, expected.error);
+        EXPECT_GT(compiled.stats.native_entries, 0u);
+    }
+
+}
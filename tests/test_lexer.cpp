@@ -653,7 +653,8 @@ namespace Veal
             {tinycsharp::TokenKind::kTNLiteral, "10", 1, 9},
             {tinycsharp::TokenKind::kTSemiColon, ";", 1, 11}};
 
-        tinycsharp::Lexer lexer{input};
+        tinycsharp::SourceManager sources;
+        tinycsharp::Lexer lexer{input, sources.Begin(sources.AddFile("test.cs", input))};
 
         for (const auto &expected : expected_tokens)
         {
@@ -661,9 +662,57 @@ namespace Veal
             auto actual_token = lexer.Lex();
             EXPECT_EQ(actual_token.kind, expected.kind);
             EXPECT_EQ(actual_token.lexeme, expected.lexeme);
-            EXPECT_EQ(actual_token.line, expected.line);
-            EXPECT_EQ(actual_token.column, expected.column);
+            tinycsharp::SourcePosition pos = sources.Decode(actual_token.loc);
+            EXPECT_EQ(pos.file, "test.cs");
+            EXPECT_EQ(pos.line, expected.line);
+            EXPECT_EQ(pos.column, expected.column);
         }
     }
 
+    TEST_F(LexerTest, ShouldCountEachNewlineOnce)
+    {
+        std::string input = "var x\n\n  = 10;\n// comment\nx";
+        tinycsharp::SourceManager sources;
+        tinycsharp::Lexer lexer{input, sources.Begin(sources.AddFile("test.cs", input))};
+        auto tokens = lexer.Tokenize();
+        ASSERT_EQ(tokens.size(), 7u);
+        EXPECT_EQ(sources.Decode(tokens[1].loc).line, 1);
+        EXPECT_EQ(sources.Decode(tokens[2].loc).line, 3);
+        EXPECT_EQ(sources.Decode(tokens[2].loc).column, 3);
+        EXPECT_EQ(tokens[5].lexeme, "x");
+        EXPECT_EQ(sources.Decode(tokens[5].loc).line, 5);
+        EXPECT_EQ(sources.Decode(tokens[5].loc).column, 1);
+        EXPECT_EQ(sources.Decode(tokens[6].loc).column, 2);
+
+        // without a base, locations are offsets into the text.
+        EXPECT_EQ(tinycsharp::Lexer{input}.Tokenize()[5].loc.offset, input.size() - 1);
+    }
+
+    TEST_F(LexerTest, ShouldLexShiftsAndLongLiterals)
+    {
+        tinycsharp::Lexer lexer{"a << 2 >> b; 3000000000"};
+        auto tokens = lexer.Tokenize();
+        ASSERT_EQ(tokens.size(), 8u);
+        EXPECT_EQ(tokens[1].kind, tinycsharp::TokenKind::kTLShift);
+        EXPECT_EQ(tokens[2].lexeme, "2");
+        EXPECT_EQ(tokens[3].kind, tinycsharp::TokenKind::kTRShift);
+        EXPECT_EQ(tokens[4].lexeme, "b");
+        ASSERT_TRUE(tokens[6].int_val);
+        EXPECT_EQ(*tokens[6].int_val, 3000000000LL);
+
+        tinycsharp::Lexer too_large{"99999999999999999999"};
+        EXPECT_THROW(too_large.Tokenize(), std::runtime_error);
+    }
+
+    TEST_F(LexerTest, ShouldLexEmptyStringLiterals)
+    {
+        tinycsharp::Lexer lexer{"s = \"\"; t = \"x\";"};
+        auto tokens = lexer.Tokenize();
+        ASSERT_EQ(tokens.size(), 9u);
+        EXPECT_EQ(tokens[2].kind, tinycsharp::TokenKind::kTSLiteral);
+        EXPECT_EQ(tokens[2].lexeme, "");
+        EXPECT_EQ(tokens[3].kind, tinycsharp::TokenKind::kTSemiColon);
+        EXPECT_EQ(tokens[6].lexeme, "x");
+    }
+
 }
@@ -0,0 +1,280 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include <gtest/gtest.h>
+#include "lexer.h"
+#include "lsp.h"
+
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace tinycsharp_test
+{
+
+    namespace
+    {
+        // the message bodies in framed output.
+        std::vector<std::string> Frames(const std::string &out)
+        {
+            std::vector<std::string> bodies;
+            std::size_t at = 0;
+            while ((at = out.find("Content-Length: ", at)) != std::string::npos)
+            {
+                std::size_t length = std::stoul(out.substr(at + 16));
+                std::size_t body = out.find("\r\n\r\n", at) + 4;
+                bodies.push_back(out.substr(body, length));
+                at = body + length;
+            }
+            return bodies;
+        }
+
+        std::string Find(const std::vector<std::string> &bodies, const std::string &needle)
+        {
+            for (const auto &body : bodies)
+            {
+                if (body.find(needle) != std::string::npos)
+                    return body;
+            }
+            return "";
+        }
+
+        std::string Position(const char *method, int id, const char *file, int line, int character)
+        {
+            return "{\"jsonrpc\":\"2.0\",\"id\":" + std::to_string(id) + ",\"method\":\"" + method +
+                   "\",\"params\":{\"textDocument\":{\"uri\":\"file:///" + file + ".cs\"},\"position\":{\"line\":" +
+                   std::to_string(line) + ",\"character\":" + std::to_string(character) + "}}}";
+        }
+
+        std::string Open(const char *uri, const char *text)
+        {
+            std::string open = std::string("{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/didOpen\",\"params\":{\"textDocument\":") +
+                               "{\"uri\":\"" + uri + "\",\"languageId\":\"csharp\",\"version\":1,\"text\":\"";
+            for (const char *p = text; *p; p++)
+                open += *p == '\n' ? std::string("\\n") : std::string(1, *p);
+            return open + "\"}}}";
+        }
+
+        const char *kCounter = "class Counter\n"
+                               "{\n"
+                               "    int count;\n"
+                               "    public int Add(int step)\n"
+                               "    {\n"
+                               "        count = count + step;\n"
+                               "        return count;\n"
+                               "    }\n"
+                               "}\n";
+
+        const char *kProgram = "class Program\n"
+                               "{\n"
+                               "    static void Main()\n"
+                               "    {\n"
+                               "        Counter c = new Counter();\n"
+                               "        c.Add(2);\n"
+                               "    }\n"
+                               "}\n";
+    }
+
+    TEST(TokenStreamTest, ShouldMatchAFullRelexAfterEachEdit)
+    {
+        const std::vector<std::string> snippets = {"x", " ", "\n", "/* c */", "\"s\"", "\"", "1.5", "// c\n", "/// d\n", "{",
+                                                   "}", "foo(1)", "==", "=", "*/", "/*", "+", "42", "\t", "a.b"};
+        std::mt19937 rng(7);
+        tinycsharp::TokenStream stream;
+        stream.Reset(std::string(kCounter) + kProgram);
+        for (int i = 0; i < 2000; i++)
+        {
+            std::string text = stream.text();
+            std::size_t offset = rng() % (text.size() + 1);
+            std::size_t length = rng() % 3 == 0 ? std::min<std::size_t>(rng() % 8, text.size() - offset) : 0;
+            std::string insert = rng() % 4 == 0 ? "" : snippets[rng() % snippets.size()];
+            if (text.size() > 2000)
+                length = std::min<std::size_t>(64, text.size() - offset), insert.clear();
+            stream.Edit(offset, length, insert);
+            text.replace(offset, length, insert);
+            ASSERT_EQ(stream.text(), text);
+
+            std::vector<tinycsharp::Token> expected;
+            try
+            {
+                tinycsharp::Lexer lexer{text};
+                expected = lexer.Tokenize();
+            }
+            catch (const std::invalid_argument &)
+            {
+                ASSERT_EQ(stream.tokens().size(), 1u);
+                continue;
+            }
+            catch (const std::exception &)
+            {
+                EXPECT_FALSE(stream.error().empty());
+                continue;
+            }
+            ASSERT_TRUE(stream.error().empty()) << stream.error();
+            const auto &actual = stream.tokens();
+            ASSERT_EQ(actual.size(), expected.size()) << "after edit " << i;
+            for (std::size_t t = 0; t < actual.size(); t++)
+            {
+                ASSERT_EQ(actual[t].kind, expected[t].kind) << "token " << t << " after edit " << i;
+                ASSERT_EQ(actual[t].lexeme, expected[t].lexeme) << "token " << t << " after edit " << i;
+                ASSERT_EQ(actual[t].loc, expected[t].loc) << "token " << t << " after edit " << i;
+            }
+        }
+    }
+
+    TEST(TokenStreamTest, ShouldRelexOnlyNearAnEdit)
+    {
+        std::string text;
+        for (int i = 0; i < 200; i++)
+            text += "class C" + std::to_string(i) + " { int f; }\n";
+        tinycsharp::TokenStream stream;
+        stream.Reset(text);
+        std::size_t tokens = stream.tokens().size();
+        EXPECT_EQ(stream.relexed(), tokens);
+
+        std::size_t at = text.find("int f", text.size() / 2);
+        stream.Edit(at + 4, 1, "field;\n    int g");
+        EXPECT_LE(stream.relexed(), 8u);
+        EXPECT_EQ(stream.tokens().size(), tokens + 3);
+        // the tokens past the edit were moved by the bytes it added.
+        const auto &tokens_after = stream.tokens();
+        EXPECT_EQ(tokens_after.back().loc.offset, stream.text().size());
+        EXPECT_EQ(tokens_after[tokens_after.size() - 7].lexeme, "C199");
+        EXPECT_EQ(tokens_after[tokens_after.size() - 7].loc.offset, stream.text().rfind("C199"));
+    }
+
+    TEST(LanguageServerTest, ShouldAnswerFromTheLastAnalysisAndCancelStaleRequests)
+    {
+        std::ostringstream out;
+        tinycsharp::LanguageServer server{out, 2};
+        server.Post("{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"initialize\",\"params\":{}}");
+        server.Post("{\"jsonrpc\":\"2.0\",\"method\":\"initialized\",\"params\":{}}");
+        server.Post(Open("file:///a.cs", kCounter));
+        server.Post(Open("file:///b.cs", kProgram));
+        server.Post(Position("textDocument/hover", 2, "b", 5, 10));
+        server.Post(Position("textDocument/definition", 3, "b", 5, 10));
+        server.Post(Position("textDocument/hover", 4, "b", 4, 9));
+        // hover 5 is out of date by the time it is handled: the edit after
+        // it assigns a string to the int field.
+        server.Post(Position("textDocument/hover", 5, "a", 5, 8));
+        server.Post("{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/didChange\",\"params\":{\"textDocument\":{\"uri\":\"file:///a.cs\",\"version\":2},"
+                    "\"contentChanges\":[{\"range\":{\"start\":{\"line\":5,\"character\":24},\"end\":{\"line\":5,\"character\":28}},\"text\":\"\\\"two\\\"\"}]}}");
+        server.Post(Position("textDocument/hover", 6, "a", 5, 8));
+        server.Post(Position("textDocument/hover", 7, "a", 3, 25));
+        server.Post(Position("textDocument/hover", 8, "b", 4, 9));
+        server.Post("{\"jsonrpc\":\"2.0\",\"method\":\"$/cancelRequest\",\"params\":{\"id\":8}}");
+        server.Post("{\"jsonrpc\":\"2.0\",\"id\":9,\"method\":\"textDocument/rename\",\"params\":{}}");
+        server.Post("{\"jsonrpc\":\"2.0\",\"id\":10,\"method\":\"shutdown\"}");
+        server.Post("{\"jsonrpc\":\"2.0\",\"method\":\"exit\"}");
+        server.Close();
+        EXPECT_EQ(server.Serve(), 0);
+
+        auto frames = Frames(out.str());
+        EXPECT_NE(Find(frames, "\"id\":1,").find("\"hoverProvider\":true"), std::string::npos);
+        EXPECT_NE(Find(frames, "\"id\":2,").find("int Counter.Add(int step)"), std::string::npos);
+        EXPECT_NE(Find(frames, "\"id\":3,").find("{\"uri\":\"file:///a.cs\",\"range\":{\"start\":{\"line\":3,\"character\":15},"
+                                                "\"end\":{\"line\":3,\"character\":18}}}"),
+                  std::string::npos);
+        EXPECT_NE(Find(frames, "\"id\":4,").find("class Counter"), std::string::npos);
+        EXPECT_NE(Find(frames, "\"id\":5,").find("-32800"), std::string::npos);
+        EXPECT_NE(Find(frames, "\"id\":6,").find("int Counter.count"), std::string::npos);
+        EXPECT_NE(Find(frames, "\"id\":7,").find("(parameter) int step"), std::string::npos);
+        EXPECT_NE(Find(frames, "\"id\":8,").find("-32800"), std::string::npos);
+        EXPECT_NE(Find(frames, "\"id\":9,").find("-32601"), std::string::npos);
+        EXPECT_NE(Find(frames, "\"id\":10,").find("\"result\":null"), std::string::npos);
+
+        // both files were clean at first; the edit was analyzed before
+        // hover 6, and its diagnostic is on the edited line.
+        EXPECT_NE(Find(frames, "\"uri\":\"file:///a.cs\",\"diagnostics\":[]"), "");
+        std::string published = Find(frames, "Cannot implicitly convert");
+        EXPECT_NE(published.find("\"uri\":\"file:///a.cs\""), std::string::npos) << published;
+        EXPECT_NE(published.find("\"start\":{\"line\":5,"), std::string::npos) << published;
+        EXPECT_NE(published.find("\"severity\":1"), std::string::npos) << published;
+    }
+
+    // a.cs binds to a class of b.cs, which is parsed again on each edit
+    // while a.cs's tree is kept.
+    TEST(LanguageServerTest, ShouldRebindAfterADeclarationElsewhereIsRenamed)
+    {
+        const char *uses = "class A\n"
+                           "{\n"
+                           "    const int C = Other.K + 1;\n"
+                           "    public static int F()\n"
+                           "    {\n"
+                           "        int x = C;\n"
+                           "        return Other.G() + x;\n"
+                           "    }\n"
+                           "}\n";
+        const char *declares = "class Other\n"
+                               "{\n"
+                               "    public const int K = 4;\n"
+                               "    public static int G() { return K; }\n"
+                               "}\n";
+        std::ostringstream out;
+        tinycsharp::LanguageServer server{out, 2};
+        server.Post("{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"initialize\",\"params\":{}}");
+        server.Post(Open("file:///a.cs", uses));
+        server.Post(Open("file:///b.cs", declares));
+        int id = 2;
+        std::string name = "Other";
+        for (const char *next : {"Other2", "Other", "Other3", "Other"})
+        {
+            server.Post("{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/didChange\",\"params\":{\"textDocument\":{\"uri\":\"file:///b.cs\",\"version\":" +
+                        std::to_string(id) + "},\"contentChanges\":[{\"range\":{\"start\":{\"line\":0,\"character\":6},\"end\":{\"line\":0,\"character\":" +
+                        std::to_string(6 + name.size()) + "}},\"text\":\"" + next + "\"}]}}");
+            server.Post(Position("textDocument/hover", id++, "a", 6, 16));
+            name = next;
+        }
+        server.Post("{\"jsonrpc\":\"2.0\",\"id\":99,\"method\":\"shutdown\"}");
+        server.Post("{\"jsonrpc\":\"2.0\",\"method\":\"exit\"}");
+        server.Close();
+        EXPECT_EQ(server.Serve(), 0);
+
+        auto frames = Frames(out.str());
+        EXPECT_EQ(Find(frames, "\"id\":2,").find("class Other"), std::string::npos);
+        EXPECT_NE(Find(frames, "\"id\":3,").find("class Other"), std::string::npos);
+        EXPECT_EQ(Find(frames, "\"id\":4,").find("class Other"), std::string::npos);
+        EXPECT_NE(Find(frames, "\"id\":5,").find("class Other"), std::string::npos);
+        // the last analysis found nothing wrong with a.cs.
+        std::string last;
+        for (const auto &frame : frames)
+        {
+            if (frame.find("\"uri\":\"file:///a.cs\",\"diagnostics\"") != std::string::npos)
+                last = frame;
+        }
+        EXPECT_NE(last.find("\"diagnostics\":[]"), std::string::npos) << last;
+    }
+
+    TEST(LanguageServerTest, ShouldReadFramedMessages)
+    {
+        std::string input;
+        for (std::string body : {"{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"shutdown\"}", "{\"jsonrpc\":\"2.0\",\"method\":\"exit\"}"})
+            input += "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+        std::istringstream in(input);
+        std::ostringstream out;
+        EXPECT_EQ(tinycsharp::RunLanguageServer(in, out), 0);
+        EXPECT_NE(out.str().find("\"id\":1,\"result\":null"), std::string::npos);
+
+        // input that ends without an exit is a failure.
+        std::istringstream eof("Content-Length: 9\r\n\r\n{\"x\":1}\n");
+        std::ostringstream none;
+        EXPECT_EQ(tinycsharp::RunLanguageServer(eof, none), 1);
+    }
+
+}
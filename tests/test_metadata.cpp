@@ -0,0 +1,269 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include <gtest/gtest.h>
+#include "const_eval.h"
+#include "metadata.h"
+#include "parser.h"
+#include "sema.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace tinycsharp_test
+{
+
+    namespace
+    {
+        const char *kLibrary = "namespace Lib.Shapes\n"
+                               "{\n"
+                               "    public abstract class Shape\n"
+                               "    {\n"
+                               "        public abstract double Area();\n"
+                               "        public virtual string Name() { return \"shape\"; }\n"
+                               "        protected int sides;\n"
+                               "        private int secret;\n"
+                               "    }\n"
+                               "    public sealed class Circle : Shape\n"
+                               "    {\n"
+                               "        public double radius;\n"
+                               "        public Circle(double r) { radius = r; }\n"
+                               "        public override double Area() { return 3.0 * radius * radius; }\n"
+                               "    }\n"
+                               "    public static class Util\n"
+                               "    {\n"
+                               "        public const int Max = 2 * 21;\n"
+                               "        public const string Title = \"shapes\";\n"
+                               "        public const double Half = 0.5;\n"
+                               "        public static int Twice(int x) { return Hidden(x) * 2; }\n"
+                               "        public static Shape[] Many(int n) { return new Shape[n]; }\n"
+                               "        private static int Hidden(int x) { return x; }\n"
+                               "    }\n"
+                               "    public class Unused { }\n"
+                               "    class Detail { }\n"
+                               "}\n";
+
+        // analyzes the library and returns its module.
+        std::unique_ptr<tinycsharp::MetadataModule> BuildModule(const std::string &source)
+        {
+            tinycsharp::Interner interner;
+            tinycsharp::AstContext ctx{interner};
+            tinycsharp::Parser parser{ctx, source, "lib.cs"};
+            parser.ParseCompilationUnit();
+            tinycsharp::Sema sema{interner};
+            EXPECT_TRUE(sema.Analyze(ctx.units));
+            std::ostringstream out;
+            tinycsharp::WriteMetadata(out, sema.globals());
+            return tinycsharp::MetadataModule::FromBytes(out.str(), "lib.tcsm");
+        }
+
+        class Client
+        {
+        public:
+            tinycsharp::Interner interner;
+            tinycsharp::AstContext ctx{interner};
+            tinycsharp::Sema sema{interner};
+
+            bool Analyze(const tinycsharp::MetadataModule &module, const std::string &source,
+                         tinycsharp::ThreadPool *pool = nullptr)
+            {
+                tinycsharp::Parser parser{ctx, source, "app.cs"};
+                parser.ParseCompilationUnit();
+                sema.AddReference(&module);
+                return sema.Analyze(ctx.units, pool);
+            }
+
+            std::string Messages() const
+            {
+                std::ostringstream ss;
+                for (const auto &d : sema.diagnostics())
+                    ss << d << "\n";
+                return ss.str();
+            }
+        };
+    }
+
+    TEST(MetadataTest, ShouldHoldOnlyThePublicSurface)
+    {
+        auto module = BuildModule(kLibrary);
+        EXPECT_EQ(module->type_count(), 4u);
+        EXPECT_EQ(module->decoded_types(), 0u);
+        EXPECT_TRUE(module->HasNamespace("Lib"));
+        EXPECT_TRUE(module->HasNamespace("Lib.Shapes"));
+        EXPECT_FALSE(module->HasNamespace("Shapes"));
+        EXPECT_EQ(module->FindType("Lib.Shapes.Detail"), nullptr);
+        EXPECT_EQ(module->FindType("Shape"), nullptr);
+
+        const tinycsharp::MetadataType *shape = module->FindType("Lib.Shapes.Shape");
+        ASSERT_NE(shape, nullptr);
+        EXPECT_TRUE(shape->flags & tinycsharp::MetadataType::kAbstract);
+        std::vector<std::string> names;
+        for (const auto &member : shape->members)
+            names.emplace_back(member.name);
+        EXPECT_EQ(names, (std::vector<std::string>{"sides", "Area", "Name"}));
+
+        const tinycsharp::MetadataType *util = module->FindType("Lib.Shapes.Util");
+        ASSERT_NE(util, nullptr);
+        ASSERT_EQ(util->members.size(), 5u);
+        EXPECT_EQ(util->members[0].name, "Max");
+        EXPECT_EQ(util->members[0].value, 42u);
+        EXPECT_EQ(module->String(static_cast<std::uint32_t>(util->members[1].value)), "shapes");
+        EXPECT_EQ(util->members[4].type, "Lib.Shapes.Shape[]");
+        ASSERT_EQ(util->members[3].params.size(), 1u);
+        EXPECT_EQ(util->members[3].params[0].first, "x");
+        EXPECT_EQ(util->members[3].params[0].second, "int");
+
+        EXPECT_EQ(module->FindType("Lib.Shapes.Shape"), shape);
+        EXPECT_EQ(module->decoded_types(), 2u);
+
+        EXPECT_THROW(tinycsharp::MetadataModule::FromBytes("not a module", "junk"), std::runtime_error);
+        std::ostringstream empty;
+        tinycsharp::Interner interner;
+        tinycsharp::TypeTable types;
+        tinycsharp::GlobalSymbols globals{interner, types};
+        tinycsharp::WriteMetadata(empty, globals);
+        std::string truncated = empty.str();
+        truncated.pop_back();
+        EXPECT_THROW(tinycsharp::MetadataModule::FromBytes(truncated, "short"), std::runtime_error);
+        EXPECT_EQ(tinycsharp::MetadataModule::FromBytes(empty.str(), "empty")->type_count(), 0u);
+    }
+
+    TEST(MetadataTest, ShouldCheckAClientAgainstTheModuleAlone)
+    {
+        auto module = BuildModule(kLibrary);
+        Client client;
+        bool ok = client.Analyze(*module, "using Lib.Shapes;\n"
+                                          "class Square : Shape\n"
+                                          "{\n"
+                                          "    public override double Area() { return 4.0; }\n"
+                                          "}\n"
+                                          "class Program\n"
+                                          "{\n"
+                                          "    const int Limit = Util.Max + 1;\n"
+                                          "    static void Main()\n"
+                                          "    {\n"
+                                          "        Shape s = new Circle(2.0);\n"
+                                          "        double a = s.Area() + Util.Half;\n"
+                                          "        string n = s.Name() + Util.Title;\n"
+                                          "        int t = Lib.Shapes.Util.Twice(Limit);\n"
+                                          "        Shape[] all = Util.Many(t);\n"
+                                          "    }\n"
+                                          "}\n");
+        EXPECT_TRUE(ok) << client.Messages();
+
+        // only the classes the program named were loaded.
+        std::vector<std::string> loaded;
+        for (const auto *cls : client.sema.globals().ReferencedClasses())
+            loaded.push_back(cls->qualified_name);
+        std::sort(loaded.begin(), loaded.end());
+        EXPECT_EQ(loaded, (std::vector<std::string>{"Lib.Shapes.Circle", "Lib.Shapes.Shape", "Lib.Shapes.Util"}));
+        EXPECT_EQ(module->decoded_types(), 3u);
+        EXPECT_EQ(client.sema.globals().classes().size(), 2u);
+
+        // consts fold across the reference.
+        const tinycsharp::ClassInfo *program = client.sema.globals().FindClass("Program");
+        ASSERT_NE(program, nullptr);
+        ASSERT_NE(program->fields[0]->constant, nullptr);
+        EXPECT_EQ(program->fields[0]->constant->int_value, 43);
+
+        // the override lands in the referenced base's vtable slot.
+        const tinycsharp::ClassInfo *square = client.sema.globals().FindClass("Square");
+        ASSERT_NE(square, nullptr);
+        EXPECT_EQ(square->vtable.size(), 2u);
+        EXPECT_EQ(square->vtable[0]->owner, square);
+    }
+
+    TEST(MetadataTest, ShouldReportMisuseOfReferencedMembers)
+    {
+        auto module = BuildModule(kLibrary);
+        Client client;
+        bool ok = client.Analyze(*module, "using Lib.Shapes;\n"
+                                          "class Program\n"
+                                          "{\n"
+                                          "    static void Main()\n"
+                                          "    {\n"
+                                          "        int h = Util.Hidden(1);\n"
+                                          "        int t = Util.Twice(\"two\");\n"
+                                          "        Shape s = new Shape();\n"
+                                          "    }\n"
+                                          "}\n"
+                                          "class Round : Circle { }\n");
+        EXPECT_FALSE(ok);
+        std::string messages = client.Messages();
+        EXPECT_NE(messages.find("app.cs:6:"), std::string::npos) << messages;
+        EXPECT_NE(messages.find("app.cs:7:"), std::string::npos) << messages;
+        EXPECT_NE(messages.find("Cannot create an instance of the abstract"), std::string::npos) << messages;
+        EXPECT_NE(messages.find("cannot derive from sealed type 'Lib.Shapes.Circle'"), std::string::npos) << messages;
+    }
+
+    TEST(MetadataTest, ShouldOpenALargeModuleWithoutDecodingIt)
+    {
+        std::string source = "namespace Big\n{\n";
+        for (int i = 0; i < 5000; i++)
+        {
+            std::string n = std::to_string(i);
+            source += "    public class C" + n + " { public const int Id = " + n + "; public int F(int x) { return x + Id; } }\n";
+        }
+        source += "}\n";
+        std::filesystem::path path = std::filesystem::temp_directory_path() /
+                                     ("tinycsharp_metadata_" + std::to_string(::getpid()) + ".tcsm");
+        {
+            tinycsharp::Interner interner;
+            tinycsharp::AstContext ctx{interner};
+            tinycsharp::Parser parser{ctx, source, "big.cs"};
+            parser.ParseCompilationUnit();
+            tinycsharp::Sema sema{interner};
+            ASSERT_TRUE(sema.Analyze(ctx.units));
+            std::ofstream out(path, std::ios::binary);
+            tinycsharp::WriteMetadata(out, sema.globals());
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        auto module = tinycsharp::MetadataModule::Open(path.string());
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        EXPECT_EQ(module->type_count(), 5000u);
+        EXPECT_EQ(module->decoded_types(), 0u);
+        EXPECT_LT(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count(), 50);
+
+        // bodies checked in parallel load classes concurrently, some of
+        // them the same.
+        std::string program = "using Big;\n"
+                              "class Program { const int Sum = C1234.Id + C4999.Id;\n"
+                              "    static int Main() { return new C17().F(Sum); }\n";
+        for (int i = 0; i < 64; i++)
+            program += "    static int M" + std::to_string(i) + "() { return new C" + std::to_string(i % 16) + "().F(C" +
+                       std::to_string(100 + i % 32) + ".Id); }\n";
+        program += "}\n";
+        tinycsharp::ThreadPool pool{4};
+        Client client;
+        EXPECT_TRUE(client.Analyze(*module, program, &pool)) << client.Messages();
+        EXPECT_EQ(module->decoded_types(), 3u + 16u + 32u);
+        EXPECT_EQ(client.sema.globals().ReferencedClasses().size(), 3u + 16u + 32u);
+        EXPECT_EQ(client.sema.globals().FindClass("Program")->fields[0]->constant->int_value, 6233);
+        std::filesystem::remove(path);
+    }
+
+}
@@ -0,0 +1,194 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include <gtest/gtest.h>
+#include "ast.h"
+#include "parser.h"
+
+#include <string>
+
+namespace tinycsharp_test
+{
+
+    class ParserTest : public ::testing::Test
+    {
+    protected:
+        tinycsharp::AstContext ctx;
+
+        const std::string source = R"(
+using System;
+using System.Collections.Generic;
+
+namespace Veal.Http
+{
+    /// <summary>
+    /// responds to requests
+    /// </summary>
+    public sealed class HttpResponder : Responder
+    {
+        const int MaxRetries = 3;
+        public int StatusCode { get; set; }
+        public string Language { get; set; } = "en-US";
+        private static Dictionary<string, object> ViewData = new Dictionary<string, object>();
+
+        public HttpResponder(int code)
+        {
+            StatusCode = code;
+        }
+
+        public override int Retry(int attempts)
+        {
+            var total = 0;
+            int i = 0;
+            while (i < attempts && i < MaxRetries)
+            {
+                total += i * 2 + 1;
+                i++;
+            }
+            if (total > 10) return total; else return -total;
+        }
+
+        public bool IsOk() => StatusCode == 200;
+    }
+}
+)";
+    };
+
+    TEST_F(ParserTest, ShouldParseNamespacesClassesAndMembers)
+    {
+        tinycsharp::Parser parser{ctx, source, "responder.cs"};
+        auto *unit = parser.ParseCompilationUnit();
+
+        ASSERT_EQ(unit->usings.size(), 2u);
+        EXPECT_EQ(unit->usings[1]->name, "System.Collections.Generic");
+        ASSERT_EQ(unit->members.size(), 1u);
+
+        auto *ns = tinycsharp::NodeCast<tinycsharp::NamespaceDecl>(unit->members[0]);
+        ASSERT_NE(ns, nullptr);
+        EXPECT_EQ(ns->name, "Veal.Http");
+
+        auto *cls = tinycsharp::NodeCast<tinycsharp::ClassDecl>(ns->members[0]);
+        ASSERT_NE(cls, nullptr);
+        EXPECT_EQ(cls->name, "HttpResponder");
+        EXPECT_TRUE(cls->modifiers & tinycsharp::kModSealed);
+        ASSERT_EQ(cls->bases.size(), 1u);
+        EXPECT_EQ(cls->bases[0]->name, "Responder");
+        ASSERT_EQ(cls->members.size(), 7u);
+
+        auto *max = tinycsharp::NodeCast<tinycsharp::FieldDecl>(cls->members[0]);
+        ASSERT_NE(max, nullptr);
+        EXPECT_TRUE(max->modifiers & tinycsharp::kModConst);
+        EXPECT_EQ(tinycsharp::NodeCast<tinycsharp::LiteralExpr>(max->init)->int_value, 3);
+
+        auto *lang = tinycsharp::NodeCast<tinycsharp::FieldDecl>(cls->members[2]);
+        ASSERT_NE(lang, nullptr);
+        EXPECT_TRUE(lang->is_property);
+        EXPECT_EQ(tinycsharp::NodeCast<tinycsharp::LiteralExpr>(lang->init)->string_value, "en-US");
+
+        auto *view_data = tinycsharp::NodeCast<tinycsharp::FieldDecl>(cls->members[3]);
+        ASSERT_NE(view_data, nullptr);
+        EXPECT_EQ(view_data->type->name, "Dictionary");
+        EXPECT_EQ(view_data->type->args.size(), 2u);
+
+        auto *ctor = tinycsharp::NodeCast<tinycsharp::MethodDecl>(cls->members[4]);
+        ASSERT_NE(ctor, nullptr);
+        EXPECT_TRUE(ctor->is_ctor);
+        EXPECT_EQ(ctor->owner, cls);
+
+        auto *retry = tinycsharp::NodeCast<tinycsharp::MethodDecl>(cls->members[5]);
+        ASSERT_NE(retry, nullptr);
+        EXPECT_EQ(retry->name, "Retry");
+        EXPECT_TRUE(retry->modifiers & tinycsharp::kModOverride);
+        ASSERT_EQ(retry->params.size(), 1u);
+        EXPECT_EQ(retry->params[0]->type->name, "int");
+        ASSERT_EQ(retry->body->stmts.size(), 4u);
+        EXPECT_EQ(retry->body->stmts[0]->kind, tinycsharp::NodeKind::kLocalVarStmt);
+        EXPECT_EQ(retry->body->stmts[1]->kind, tinycsharp::NodeKind::kLocalVarStmt);
+        EXPECT_EQ(retry->body->stmts[2]->kind, tinycsharp::NodeKind::kWhileStmt);
+        EXPECT_EQ(retry->body->stmts[3]->kind, tinycsharp::NodeKind::kIfStmt);
+
+        auto *is_ok = tinycsharp::NodeCast<tinycsharp::MethodDecl>(cls->members[6]);
+        ASSERT_NE(is_ok, nullptr);
+        ASSERT_EQ(is_ok->body->stmts.size(), 1u);
+        EXPECT_EQ(is_ok->body->stmts[0]->kind, tinycsharp::NodeKind::kReturnStmt);
+    }
+
+    TEST_F(ParserTest, ShouldRespectOperatorPrecedence)
+    {
+        tinycsharp::Parser parser{ctx, "class A { int F() { return 1 + 2 * 3 == 7 && !false; } }"};
+        auto *unit = parser.ParseCompilationUnit();
+        auto *cls = tinycsharp::NodeCast<tinycsharp::ClassDecl>(unit->members[0]);
+        auto *method = tinycsharp::NodeCast<tinycsharp::MethodDecl>(cls->members[0]);
+        auto *ret = tinycsharp::NodeCast<tinycsharp::ReturnStmt>(method->body->stmts[0]);
+
+        auto *logical_and = tinycsharp::NodeCast<tinycsharp::BinaryExpr>(ret->value);
+        ASSERT_NE(logical_and, nullptr);
+        EXPECT_EQ(logical_and->op, tinycsharp::TokenKind::kTLogicalAnd);
+        EXPECT_EQ(logical_and->rhs->kind, tinycsharp::NodeKind::kUnaryExpr);
+
+        auto *eq = tinycsharp::NodeCast<tinycsharp::BinaryExpr>(logical_and->lhs);
+        ASSERT_NE(eq, nullptr);
+        EXPECT_EQ(eq->op, tinycsharp::TokenKind::kTEquality);
+
+        auto *plus = tinycsharp::NodeCast<tinycsharp::BinaryExpr>(eq->lhs);
+        ASSERT_NE(plus, nullptr);
+        EXPECT_EQ(plus->op, tinycsharp::TokenKind::kTPlus);
+        auto *times = tinycsharp::NodeCast<tinycsharp::BinaryExpr>(plus->rhs);
+        ASSERT_NE(times, nullptr);
+        EXPECT_EQ(times->op, tinycsharp::TokenKind::kTStar);
+    }
+
+    TEST_F(ParserTest, ShouldParseCallsCastsAndObjectCreation)
+    {
+        tinycsharp::Parser parser{ctx, R"(
+class A
+{
+    void F(B b)
+    {
+        long x = (long)b.Count(1, "two");
+        var items = new int[x];
+        b.Next.Run(items[0]);
+        Console.WriteLine(x > 0 ? "pos" : "neg");
+    }
+}
+)"};
+        parser.ParseCompilationUnit();
+        EXPECT_EQ(ctx.NodesOfKind(tinycsharp::NodeKind::kCallExpr).size(), 3u);
+        EXPECT_EQ(ctx.NodesOfKind(tinycsharp::NodeKind::kCastExpr).size(), 1u);
+        EXPECT_EQ(ctx.NodesOfKind(tinycsharp::NodeKind::kNewExpr).size(), 1u);
+        EXPECT_EQ(ctx.NodesOfKind(tinycsharp::NodeKind::kIndexExpr).size(), 1u);
+        EXPECT_EQ(ctx.NodesOfKind(tinycsharp::NodeKind::kConditionalExpr).size(), 1u);
+        EXPECT_EQ(ctx.NodesOfKind(tinycsharp::NodeKind::kLocalVarStmt).size(), 2u);
+    }
+
+    TEST_F(ParserTest, ShouldReportLocationOfSyntaxErrors)
+    {
+        tinycsharp::Parser parser{ctx, "class A\n{\n    int F( { }\n}", "bad.cs"};
+        try
+        {
+            parser.ParseCompilationUnit();
+            FAIL() << "expected a ParseError";
+        }
+        catch (const tinycsharp::ParseError &e)
+        {
+            EXPECT_EQ(e.line, 3);
+            EXPECT_NE(std::string(e.what()).find("bad.cs:3:"), std::string::npos) << e.what();
+        }
+    }
+
+}
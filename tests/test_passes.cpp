@@ -0,0 +1,330 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include <gtest/gtest.h>
+#include "ir.h"
+#include "parser.h"
+#include "passes.h"
+#include "sema.h"
+#include "thread_pool.h"
+
+#include <sstream>
+#include <string>
+
+namespace tinycsharp_test
+{
+
+    class PassesTest : public ::testing::Test
+    {
+    protected:
+        tinycsharp::Interner interner;
+        tinycsharp::AstContext ctx{interner};
+        tinycsharp::Sema sema{interner};
+        tinycsharp::IrModule module;
+
+        void Lower(const std::string &source)
+        {
+            tinycsharp::Parser parser{ctx, source, "test.cs"};
+            parser.ParseCompilationUnit();
+            ASSERT_TRUE(sema.Analyze(ctx.units)) << (sema.diagnostics().empty() ? "" : sema.diagnostics()[0].message);
+            module = tinycsharp::LowerToIr(sema.globals());
+        }
+
+        void Optimize(std::unique_ptr<tinycsharp::IrPass> pass)
+        {
+            tinycsharp::PassManager pm;
+            pm.SetVerify(true);
+            pm.Add(std::move(pass));
+            pm.Run(module);
+        }
+
+        const tinycsharp::IrFunction &Function(std::string_view name)
+        {
+            for (auto *method : sema.globals().methods())
+            {
+                if (method->decl->name == name)
+                    return *module.functions[method->id];
+            }
+            throw std::runtime_error("no method " + std::string(name));
+        }
+
+        static std::string Dump(const tinycsharp::IrFunction &fn)
+        {
+            std::ostringstream out;
+            tinycsharp::PrintIr(out, fn);
+            return out.str();
+        }
+
+        static int Count(const tinycsharp::IrFunction &fn, tinycsharp::IrOp op)
+        {
+            int n = 0;
+            for (tinycsharp::ValueId v = 0; v < fn.NumInsts(); v++)
+                n += fn.Inst(v).op == op;
+            return n;
+        }
+
+        // the block an instruction ended up in.
+        static tinycsharp::BlockId BlockOf(const tinycsharp::IrFunction &fn, tinycsharp::IrOp op)
+        {
+            for (tinycsharp::BlockId b = 0; b < fn.NumBlocks(); b++)
+            {
+                for (auto v = fn.Block(b).begin; v < fn.Block(b).end; v++)
+                {
+                    if (fn.Inst(v).op == op)
+                        return b;
+                }
+            }
+            return tinycsharp::kNoValue;
+        }
+    };
+
+    TEST_F(PassesTest, ShouldParseOptimizationLevels)
+    {
+        EXPECT_EQ(tinycsharp::ParseOptLevel("-O0"), tinycsharp::OptLevel::kO0);
+        EXPECT_EQ(tinycsharp::ParseOptLevel("O2"), tinycsharp::OptLevel::kO2);
+        EXPECT_THROW(tinycsharp::ParseOptLevel("-O7"), std::invalid_argument);
+    }
+
+    TEST_F(PassesTest, ShouldRemoveDeadCodeAndConstantBranches)
+    {
+        Lower(R"(
+class C
+{
+    static int F(int a)
+    {
+        int unused = a * 3 + 1;
+        int k = 2;
+        if (k > 1)
+            return a;
+        return a + 1;
+    }
+})");
+        // value numbering folds k > 1; dead code elimination then turns the
+        // branch into a jump and drops the untaken side.
+        Optimize(tinycsharp::MakeGlobalValueNumbering());
+        Optimize(tinycsharp::MakeDeadCodeElimination());
+        const auto &fn = Function("F");
+        EXPECT_EQ(Count(fn, tinycsharp::IrOp::kMul), 0) << Dump(fn);
+        EXPECT_EQ(Count(fn, tinycsharp::IrOp::kAdd), 0);
+        EXPECT_EQ(Count(fn, tinycsharp::IrOp::kBranch), 0);
+        EXPECT_EQ(Count(fn, tinycsharp::IrOp::kReturn), 1);
+    }
+
+    TEST_F(PassesTest, ShouldFoldAndNumberValues)
+    {
+        Lower(R"(
+class C
+{
+    static int F(int a, int b, bool c)
+    {
+        int x = a * b + 2;
+        int y = 0;
+        if (c)
+            y = a * b + 2;
+        else
+            y = b * a + 2;
+        int k = 6;
+        return x + y + k * 7 + 0;
+    }
+})");
+        Optimize(tinycsharp::MakeGlobalValueNumbering());
+        Optimize(tinycsharp::MakeDeadCodeElimination());
+        const auto &fn = Function("F");
+        // one multiply, reused on both sides of the branch, and the phi
+        // merging identical values disappears.
+        EXPECT_EQ(Count(fn, tinycsharp::IrOp::kMul), 1) << Dump(fn);
+        EXPECT_EQ(Count(fn, tinycsharp::IrOp::kPhi), 0);
+        bool found = false;
+        for (tinycsharp::ValueId v = 0; v < fn.NumInsts(); v++)
+            found = found || (fn.Inst(v).op == tinycsharp::IrOp::kConst && fn.Inst(v).Imm() == 42);
+        EXPECT_TRUE(found);
+    }
+
+    TEST_F(PassesTest, ShouldNotFoldTrappingDivision)
+    {
+        Lower("class C { static int F() { int z = 0; return 10 / z; } static int G(int m) { return int.MinValue / m; } }");
+        Optimize(tinycsharp::MakeGlobalValueNumbering());
+        EXPECT_EQ(Count(Function("F"), tinycsharp::IrOp::kDiv), 1);
+    }
+
+    TEST_F(PassesTest, ShouldInlineSmallFunctions)
+    {
+        Lower(R"(
+class C
+{
+    static int Square(int x) { return x * x; }
+    static int Abs(int x) { if (x < 0) return -x; return x; }
+    static int Fact(int n) { if (n < 2) return 1; return n * Fact(n - 1); }
+    static int F(int a) { return Square(a) + Abs(a) + Fact(a); }
+})");
+        Optimize(tinycsharp::MakeInliner(40));
+        const auto &fn = Function("F");
+        // Abs and Fact each return from two places.
+        EXPECT_EQ(Count(fn, tinycsharp::IrOp::kCall), 1) << Dump(fn);
+        EXPECT_EQ(Count(fn, tinycsharp::IrOp::kPhi), 2);
+        // recursion is not unrolled.
+        EXPECT_EQ(Count(Function("Fact"), tinycsharp::IrOp::kCall), 1);
+    }
+
+    TEST_F(PassesTest, ShouldDevirtualizeCallsWithASingleTarget)
+    {
+        Lower(R"(
+class Shape
+{
+    public virtual int Sides() { return 0; }
+    public virtual int Corners() { return Sides(); }
+}
+sealed class Square : Shape
+{
+    public override int Sides() { return 4; }
+}
+class Triangle : Shape
+{
+    public override int Sides() { return 3; }
+}
+class C
+{
+    static int Exact() { return new Triangle().Sides(); }
+    static int OfSquare(Square s) { return s.Sides(); }
+    static int AnyShape(Shape s) { return s.Corners(); }
+    static int Open(Shape s) { return s.Sides(); }
+})");
+        Optimize(tinycsharp::MakeDevirtualization());
+        // a fresh object is never null, so it needs no guard.
+        EXPECT_EQ(Count(Function("Exact"), tinycsharp::IrOp::kCall), 1);
+        EXPECT_EQ(Count(Function("Exact"), tinycsharp::IrOp::kThrow), 0);
+        for (const char *name : {"OfSquare", "AnyShape"})
+        {
+            const auto &fn = Function(name);
+            EXPECT_EQ(Count(fn, tinycsharp::IrOp::kCallVirtual), 0) << Dump(fn);
+            EXPECT_EQ(Count(fn, tinycsharp::IrOp::kThrow), 1) << Dump(fn);
+        }
+        // Shape.Sides has three implementations.
+        EXPECT_EQ(Count(Function("Open"), tinycsharp::IrOp::kCallVirtual), 1);
+        EXPECT_EQ(Count(Function("Corners"), tinycsharp::IrOp::kCallVirtual), 1);
+
+        Optimize(tinycsharp::MakeInliner(40));
+        EXPECT_EQ(Count(Function("OfSquare"), tinycsharp::IrOp::kCall), 0) << Dump(Function("OfSquare"));
+    }
+
+    TEST_F(PassesTest, ShouldHoistLoopInvariantCode)
+    {
+        Lower(R"(
+class C
+{
+    static int F(int n, int a, int b)
+    {
+        int s = 0;
+        int i = 0;
+        while (i < n)
+        {
+            s = s + (a * b) * i;
+            i = i + 1;
+        }
+        return s;
+    }
+})");
+        Optimize(tinycsharp::MakeLoopInvariantCodeMotion());
+        const auto &fn = Function("F");
+        // a * b is computed once, before the loop; the multiply by i stays.
+        tinycsharp::BlockId mul_block = tinycsharp::kNoValue;
+        int muls_in_loop = 0;
+        for (tinycsharp::BlockId b = 0; b < fn.NumBlocks(); b++)
+        {
+            for (auto v = fn.Block(b).begin; v < fn.Block(b).end; v++)
+            {
+                const auto &inst = fn.Inst(v);
+                if (inst.op != tinycsharp::IrOp::kMul)
+                    continue;
+                if (fn.Inst(inst.a).op == tinycsharp::IrOp::kParam && fn.Inst(inst.b).op == tinycsharp::IrOp::kParam)
+                    mul_block = b;
+                else
+                    muls_in_loop++;
+            }
+        }
+        EXPECT_EQ(mul_block, BlockOf(fn, tinycsharp::IrOp::kParam)) << Dump(fn);
+        EXPECT_EQ(muls_in_loop, 1);
+    }
+
+    TEST_F(PassesTest, ShouldCreatePreheadersForLoopsWithSeveralEntries)
+    {
+        Lower(R"(
+class C
+{
+    static int F(int n, int a, bool c)
+    {
+        int i = 0;
+        if (c)
+            i = 1;
+        do
+        {
+            n = n - (a + 3);
+            i = i + 1;
+        } while (n > 0);
+        return i;
+    }
+})");
+        Optimize(tinycsharp::MakeLoopInvariantCodeMotion());
+        const auto &fn = Function("F");
+        EXPECT_NE(BlockOf(fn, tinycsharp::IrOp::kAdd), BlockOf(fn, tinycsharp::IrOp::kSub)) << Dump(fn);
+    }
+
+    TEST_F(PassesTest, ShouldRunPipelinesInParallelAndRecordStats)
+    {
+        std::string source = "class C {\n static int Twice(int x) { return x + x; }\n";
+        for (int i = 0; i < 30; i++)
+        {
+            source += "static int F" + std::to_string(i) + "(int n, int k) { int s = 0; while (n > 0) { s = s + Twice(k * " +
+                      std::to_string(i + 2) + "); n = n - 1; } return s; }\n";
+        }
+        source += "}\n";
+        Lower(source);
+        tinycsharp::ThreadPool pool{4};
+        tinycsharp::PassManager pm{&pool};
+        pm.SetVerify(true);
+        pm.AddPipeline(tinycsharp::OptLevel::kO2);
+        std::size_t before = module.NumInsts();
+        pm.Run(module);
+        ASSERT_FALSE(pm.stats().empty());
+        std::uint64_t inlined = 0;
+        for (const auto &s : pm.stats())
+        {
+            if (s.pass == "inline")
+                inlined += s.changes;
+        }
+        EXPECT_EQ(inlined, 30u);
+        EXPECT_EQ(pm.stats().front().insts_before, before);
+        EXPECT_EQ(Count(Function("F7"), tinycsharp::IrOp::kCall), 0) << Dump(Function("F7"));
+        std::ostringstream report;
+        pm.PrintStats(report);
+        EXPECT_NE(report.str().find("licm"), std::string::npos);
+        EXPECT_NE(report.str().find("devirtualize"), std::string::npos);
+        // every row, header included, lines its columns up with the others.
+        std::istringstream rows(report.str());
+        std::string header, row;
+        std::getline(rows, header);
+        while (std::getline(rows, row))
+            EXPECT_EQ(row.size(), header.size()) << row;
+
+        tinycsharp::PassManager none;
+        none.AddPipeline(tinycsharp::OptLevel::kO0);
+        none.Run(module);
+        EXPECT_TRUE(none.stats().empty());
+    }
+
+}
@@ -0,0 +1,190 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include <gtest/gtest.h>
+#include "bytecode.h"
+#include "ir.h"
+#include "parser.h"
+#include "passes.h"
+#include "profiler.h"
+#include "sema.h"
+#include "vm.h"
+
+#include <sstream>
+#include <string>
+
+namespace tinycsharp_test
+{
+
+    class ProfilerTest : public ::testing::Test
+    {
+    protected:
+        tinycsharp::Interner interner;
+        tinycsharp::AstContext ctx{interner};
+        tinycsharp::Sema sema{interner};
+        tinycsharp::BcProgram program;
+
+        void Compile(const std::string &source)
+        {
+            tinycsharp::Parser parser{ctx, source, "test.cs"};
+            parser.ParseCompilationUnit();
+            ASSERT_TRUE(sema.Analyze(ctx.units)) << (sema.diagnostics().empty() ? "" : sema.diagnostics()[0].message);
+            tinycsharp::IrModule module = tinycsharp::LowerToIr(sema.globals());
+            tinycsharp::PassManager passes;
+            passes.AddPipeline(tinycsharp::OptLevel::kO1);
+            passes.Run(module);
+            program = tinycsharp::CompileBytecode(module);
+        }
+
+        static const tinycsharp::Profiler::Method *Find(const std::vector<tinycsharp::Profiler::Method> &methods, const std::string &name)
+        {
+            for (const auto &method : methods)
+            {
+                if (method.fn->name == name)
+                    return &method;
+            }
+            return nullptr;
+        }
+    };
+
+    const char *const kFib = R"(
+class Program
+{
+    static int Fib(int n)
+    {
+        if (n < 2)
+            return n;
+        return Fib(n - 1) + Fib(n - 2);
+    }
+
+    static int Spin(int n)
+    {
+        int total = 0;
+        int i = 0;
+        while (i < n)
+        {
+            total = total + i % 7;
+            i = i + 1;
+        }
+        return total;
+    }
+
+    static void Main()
+    {
+        System.Console.WriteLine(Fib(15));
+        System.Console.WriteLine(Spin(1000));
+    }
+}
+)";
+
+    TEST_F(ProfilerTest, ShouldCountEveryInstructionAndCallExactly)
+    {
+        Compile(kFib);
+        tinycsharp::Profiler profiler{tinycsharp::Profiler::Mode::kExact};
+        std::ostringstream out;
+        tinycsharp::Vm::Options options;
+        options.profiler = &profiler;
+        tinycsharp::Vm vm{program, out, options};
+        vm.Run();
+        EXPECT_EQ(out.str(), "610\n2997\n");
+        EXPECT_EQ(vm.stats().jit_functions, 0u);
+        EXPECT_EQ(profiler.events(), vm.stats().instructions);
+
+        auto methods = profiler.Methods();
+        const auto *fib = Find(methods, "Program.Fib(int)");
+        const auto *spin = Find(methods, "Program.Spin(int)");
+        const auto *main = Find(methods, "Program.Main()");
+        ASSERT_TRUE(fib && spin && main);
+        EXPECT_EQ(fib->calls, 1973u);
+        EXPECT_EQ(spin->calls, 1u);
+        EXPECT_EQ(main->calls, 1u);
+        // recursion is counted once in a method's total.
+        EXPECT_EQ(fib->total, fib->self);
+        EXPECT_EQ(main->total, main->self + fib->self + spin->self);
+        std::uint64_t words = 0;
+        for (std::uint64_t count : spin->pcs)
+            words += count;
+        EXPECT_EQ(words, spin->self);
+        std::uint64_t dispatches = 0;
+        for (std::uint64_t count : profiler.opcodes())
+            dispatches += count;
+        EXPECT_EQ(dispatches, profiler.events());
+
+        std::ostringstream folded;
+        profiler.WriteFolded(folded);
+        std::string stacks = folded.str();
+        EXPECT_NE(stacks.find("Program.Main();Program.Fib(int);Program.Fib(int);Program.Fib(int) "), std::string::npos) << stacks;
+        EXPECT_NE(stacks.find("Program.Main();Program.Spin(int) "), std::string::npos) << stacks;
+        EXPECT_EQ(stacks.find("Program.Fib(int);Program.Spin(int)"), std::string::npos) << stacks;
+
+        std::ostringstream report;
+        profiler.WriteReport(report);
+        std::string text = report.str();
+        EXPECT_NE(text.find("Program.Fib(int)"), std::string::npos) << text;
+        // Spin's loop body is on lines 15 and 16.
+        EXPECT_TRUE(text.find("line   15") != std::string::npos || text.find("line   16") != std::string::npos) << text;
+    }
+
+    TEST_F(ProfilerTest, ShouldSampleTheFrameStackOnTheTimer)
+    {
+        if (!tinycsharp::Profiler::SamplingSupported())
+            GTEST_SKIP() << "no profiling timer here";
+        Compile(kFib);
+        tinycsharp::Profiler profiler{tinycsharp::Profiler::Mode::kSample, std::chrono::microseconds(500)};
+        tinycsharp::Profiler other{tinycsharp::Profiler::Mode::kSample};
+        std::ostringstream out;
+        tinycsharp::Vm::Options options;
+        options.profiler = &profiler;
+        tinycsharp::Vm vm{program, out, options};
+        profiler.Start();
+        EXPECT_THROW(other.Start(), std::runtime_error);
+        vm.Run();
+        // spins on until the timer has ticked a few times, at most some
+        // seconds of CPU time.
+        std::uint32_t spin_index = 0;
+        while (vm.program().functions[spin_index].name != "Program.Spin(int)")
+            spin_index++;
+        for (int run = 0; run < 1000 && profiler.events() < 20; run++)
+            vm.Invoke(spin_index, {tinycsharp::IntValue(1000000)});
+        profiler.Stop();
+        EXPECT_GE(profiler.events(), 20u);
+
+        auto methods = profiler.Methods();
+        const auto *spin = Find(methods, "Program.Spin(int)");
+        ASSERT_TRUE(spin);
+        EXPECT_EQ(spin->calls, 0u);
+        EXPECT_GT(spin->self, 0u);
+        EXPECT_LE(spin->total, profiler.events());
+        std::ostringstream folded;
+        profiler.WriteFolded(folded);
+        std::istringstream lines(folded.str());
+        std::string line;
+        std::uint64_t sum = 0;
+        std::uint64_t in_spin = 0;
+        while (std::getline(lines, line))
+        {
+            std::uint64_t count = std::stoull(line.substr(line.rfind(' ') + 1));
+            sum += count;
+            if (line.find("Program.Spin(int)") != std::string::npos)
+                in_spin += count;
+        }
+        EXPECT_EQ(sum, profiler.events());
+        EXPECT_EQ(in_spin, spin->total);
+    }
+
+}
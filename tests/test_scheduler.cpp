@@ -0,0 +1,134 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include <gtest/gtest.h>
+#include "scheduler.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tinycsharp_test
+{
+    using namespace std::chrono_literals;
+
+    template <typename F>
+    bool WaitFor(F &&done)
+    {
+        auto deadline = std::chrono::steady_clock::now() + 5s;
+        while (!done())
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+                return false;
+            std::this_thread::sleep_for(1ms);
+        }
+        return true;
+    }
+
+    TEST(TaskSchedulerTest, ShouldRunEveryJobOnce)
+    {
+        tinycsharp::TaskScheduler scheduler{4};
+        std::vector<std::atomic<int>> hits(1000);
+        for (std::size_t i = 0; i < hits.size(); i++)
+        {
+            scheduler.Submit([&hits, i]
+                             { hits[i]++; });
+        }
+        ASSERT_TRUE(WaitFor([&]
+                            { return scheduler.Outstanding() == 0; }));
+        for (auto &h : hits)
+        {
+            EXPECT_EQ(h.load(), 1);
+        }
+    }
+
+    TEST(TaskSchedulerTest, ShouldRunJobsSubmittedByJobs)
+    {
+        tinycsharp::TaskScheduler scheduler{3};
+        std::atomic<int> done{0};
+        std::function<void(int)> spawn = [&](int depth)
+        {
+            done++;
+            if (depth < 10)
+            {
+                scheduler.Submit([&, depth]
+                                 { spawn(depth + 1); });
+                scheduler.Submit([&, depth]
+                                 { spawn(depth + 1); });
+            }
+        };
+        scheduler.Submit([&]
+                         { spawn(0); });
+        ASSERT_TRUE(WaitFor([&]
+                            { return scheduler.Outstanding() == 0; }));
+        EXPECT_EQ(done.load(), (1 << 11) - 1);
+    }
+
+    TEST(TaskSchedulerTest, ShouldStealFromBusyWorkers)
+    {
+        // one job fans out from a single worker's queue; the others can only
+        // get work by stealing it.
+        tinycsharp::TaskScheduler scheduler{4};
+        std::atomic<int> done{0};
+        scheduler.Submit([&]
+                         {
+                             for (int i = 0; i < 64; i++)
+                                 scheduler.Submit([&]
+                                                  {
+                                                      std::this_thread::sleep_for(1ms);
+                                                      done++; }); });
+        ASSERT_TRUE(WaitFor([&]
+                            { return scheduler.Outstanding() == 0; }));
+        EXPECT_EQ(done.load(), 64);
+        EXPECT_GT(scheduler.Steals(), 0u);
+    }
+
+    TEST(TaskSchedulerTest, ShouldRunDelayedJobsInDueOrder)
+    {
+        tinycsharp::TaskScheduler scheduler{1};
+        std::mutex mu;
+        std::vector<int> order;
+        auto start = std::chrono::steady_clock::now();
+        for (int ms : {30, 10, 20})
+        {
+            scheduler.SubmitAfter(std::chrono::milliseconds(ms), [&, ms]
+                                  {
+                                      std::lock_guard<std::mutex> lock(mu);
+                                      order.push_back(ms); });
+        }
+        EXPECT_EQ(scheduler.Outstanding(), 3u);
+        ASSERT_TRUE(WaitFor([&]
+                            { return scheduler.Outstanding() == 0; }));
+        EXPECT_GE(std::chrono::steady_clock::now() - start, 30ms);
+        EXPECT_EQ(order, (std::vector<int>{10, 20, 30}));
+    }
+
+    TEST(TaskSchedulerTest, ShouldDropPendingJobsWhenStopped)
+    {
+        std::atomic<int> ran{0};
+        tinycsharp::TaskScheduler scheduler{2};
+        scheduler.SubmitAfter(10s, [&]
+                              { ran++; });
+        scheduler.Stop();
+        EXPECT_EQ(scheduler.Outstanding(), 0u);
+        EXPECT_EQ(ran.load(), 0);
+    }
+
+}
@@ -0,0 +1,311 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include <gtest/gtest.h>
+#include "ast.h"
+#include "parser.h"
+#include "sema.h"
+#include "thread_pool.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace tinycsharp_test
+{
+
+    class SemaTest : public ::testing::Test
+    {
+    protected:
+        tinycsharp::Interner interner;
+        tinycsharp::AstContext ctx{interner};
+        tinycsharp::Sema sema{interner};
+
+        bool Analyze(const std::vector<std::string> &sources, tinycsharp::ThreadPool *pool = nullptr)
+        {
+            int n = 0;
+            for (const auto &src : sources)
+            {
+                tinycsharp::Parser parser{ctx, src, "file" + std::to_string(n++) + ".cs"};
+                parser.ParseCompilationUnit();
+            }
+            return sema.Analyze(ctx.units, pool);
+        }
+
+        std::vector<std::string> Messages() const
+        {
+            std::vector<std::string> out;
+            for (const auto &d : sema.diagnostics())
+            {
+                std::ostringstream ss;
+                ss << d;
+                out.push_back(ss.str());
+            }
+            return out;
+        }
+
+        template <typename T>
+        T *Nth(std::size_t n)
+        {
+            return static_cast<T *>(ctx.NodesOfKind(T::kKind)[n]);
+        }
+    };
+
+    TEST_F(SemaTest, ShouldBuildClassLayoutsAndVtables)
+    {
+        ASSERT_TRUE(Analyze({R"(
+namespace Zoo
+{
+    abstract class Animal
+    {
+        protected int legs;
+        static int count;
+        public abstract string Sound();
+        public virtual int Legs() { return legs; }
+    }
+    class Dog : Animal
+    {
+        string name;
+        public Dog(string name) { this.name = name; legs = 4; }
+        public override string Sound() { return "woof"; }
+    }
+}
+)"})) << ::testing::PrintToString(Messages());
+
+        auto &globals = sema.globals();
+        auto *animal = globals.FindClass("Zoo.Animal");
+        auto *dog = globals.FindClass("Zoo.Dog");
+        ASSERT_NE(animal, nullptr);
+        ASSERT_NE(dog, nullptr);
+        EXPECT_EQ(dog->base, animal);
+        EXPECT_EQ(animal->instance_slots, 1u);
+        EXPECT_EQ(dog->instance_slots, 2u);
+        EXPECT_EQ(dog->fields[0]->slot, 1u);
+        EXPECT_EQ(globals.static_fields().size(), 1u);
+
+        ASSERT_EQ(dog->vtable.size(), 2u);
+        EXPECT_EQ(dog->vtable[0]->owner, dog);
+        EXPECT_EQ(dog->vtable[1]->owner, animal);
+        EXPECT_EQ(dog->vtable[0]->overridden, animal->vtable[0]);
+        EXPECT_EQ(dog->ctors.size(), 1u);
+    }
+
+    TEST_F(SemaTest, ShouldTypeExpressionsAndResolveCalls)
+    {
+        ASSERT_TRUE(Analyze({R"(
+using System;
+class Calc
+{
+    int total;
+    int Add(int x) { total += x; return total; }
+    long Add(long x) { return x * 2; }
+    static double Half(int x) => x / 2.0;
+    void Run(long big)
+    {
+        var a = Add(1);
+        var b = Add(big);
+        var s = "n=" + a;
+        var h = Half(s.Length);
+        var m = Math.Max(a, b);
+        Console.WriteLine(s);
+    }
+}
+)"})) << ::testing::PrintToString(Messages());
+
+        auto *a = Nth<tinycsharp::LocalVarStmt>(0);
+        auto *b = Nth<tinycsharp::LocalVarStmt>(1);
+        auto *s = Nth<tinycsharp::LocalVarStmt>(2);
+        auto *h = Nth<tinycsharp::LocalVarStmt>(3);
+        auto *m = Nth<tinycsharp::LocalVarStmt>(4);
+        EXPECT_EQ(tinycsharp::TypeToString(a->resolved_type), "int");
+        EXPECT_EQ(tinycsharp::TypeToString(b->resolved_type), "long");
+        EXPECT_EQ(tinycsharp::TypeToString(s->resolved_type), "string");
+        EXPECT_EQ(tinycsharp::TypeToString(h->resolved_type), "double");
+        EXPECT_EQ(tinycsharp::TypeToString(m->resolved_type), "long");
+
+        auto *first = static_cast<tinycsharp::CallExpr *>(a->init);
+        auto *second = static_cast<tinycsharp::CallExpr *>(b->init);
+        ASSERT_NE(first->target, nullptr);
+        ASSERT_NE(second->target, nullptr);
+        EXPECT_NE(first->target, second->target);
+        EXPECT_EQ(static_cast<tinycsharp::Builtin>(static_cast<tinycsharp::CallExpr *>(m->init)->builtin),
+                  tinycsharp::Builtin::kMathMax);
+    }
+
+    TEST_F(SemaTest, ShouldReportTypeErrors)
+    {
+        EXPECT_FALSE(Analyze({R"(
+class Account
+{
+    readonly int id;
+    const int Limit = 10;
+    int Balance() { if (id > 0) { return 1; } }
+    void Stop() { break; }
+    void Deposit(int amount)
+    {
+        string s = amount;
+        bool ok = amount;
+        Limit = 3;
+        id = 2;
+        Missing(1);
+        var x = null;
+        Balance(1);
+    }
+}
+)"}));
+        std::vector<std::string> expected = {
+            "file0.cs:6:9: error: 'Account.Balance()': not all code paths return a value",
+            "file0.cs:7:19: error: No enclosing loop out of which to break or continue",
+            "file0.cs:10:20: error: Cannot implicitly convert type 'int' to 'string'",
+            "file0.cs:11:19: error: Cannot implicitly convert type 'int' to 'bool'",
+            "file0.cs:12:9: error: The left-hand side of an assignment must be a variable, property or indexer",
+            "file0.cs:13:9: error: A readonly field cannot be assigned to (except in a constructor or a variable initializer)",
+            "file0.cs:14:9: error: The name 'Missing' does not exist in the current context",
+            "file0.cs:15:13: error: Cannot assign <null> to an implicitly-typed variable",
+            "file0.cs:16:9: error: No overload for method 'Balance' takes 1 arguments",
+        };
+        EXPECT_EQ(Messages(), expected);
+    }
+
+    TEST_F(SemaTest, ShouldReportDeclarationErrors)
+    {
+        EXPECT_FALSE(Analyze({R"(
+class Base
+{
+    public abstract int Size();
+    public virtual void Draw() {}
+}
+class Shape : Base
+{
+    public override int Area() { return 0; }
+    Widget w;
+}
+sealed class Leaf {}
+class Twig : Leaf {}
+class A : B {}
+class B : A {}
+)"}));
+        auto messages = Messages();
+        auto has = [&](const std::string &text)
+        {
+            for (const auto &m : messages)
+                if (m.find(text) != std::string::npos)
+                    return true;
+            return false;
+        };
+        EXPECT_TRUE(has("'Base.Size()' is abstract but it is contained in non-abstract type 'Base'"));
+        EXPECT_TRUE(has("'Shape.Area()': no suitable method found to override"));
+        EXPECT_TRUE(has("The type or namespace name 'Widget' could not be found"));
+        EXPECT_TRUE(has("'Twig': cannot derive from sealed type 'Leaf'"));
+        EXPECT_TRUE(has("Circular base type dependency"));
+        EXPECT_TRUE(has("'Shape' does not implement inherited abstract member 'Base.Size()'"));
+    }
+
+    TEST_F(SemaTest, ShouldOnlyTrustUsingsOfKnownNamespaces)
+    {
+        EXPECT_FALSE(Analyze({R"(
+using System.Collections.Generic;
+class Library
+{
+    List<int> items = null;
+}
+)",
+                              R"(
+namespace App
+{
+    using Sytsem.Text;
+    class Program
+    {
+        static int Main()
+        {
+            StringBuilder text = null;
+            return Helper.Run();
+        }
+    }
+}
+)"}));
+        // System.Collections.Generic is library, so its names go unchecked;
+        // the misspelt using is reported, and does not silence lookups.
+        std::vector<std::string> expected = {
+            "file1.cs:4:5: error: The type or namespace name 'Sytsem.Text' could not be found (are you missing an assembly reference?)",
+            "file1.cs:9:13: error: The type or namespace name 'StringBuilder' could not be found",
+            "file1.cs:10:20: error: The name 'Helper' does not exist in the current context",
+        };
+        EXPECT_EQ(Messages(), expected);
+    }
+
+    TEST_F(SemaTest, ShouldCheckAsyncMethods)
+    {
+        EXPECT_FALSE(Analyze({R"(
+using System.Threading.Tasks;
+class Worker
+{
+    async Task<int> Compute()
+    {
+        await Task.Yield();
+        var v = await Task.FromResult(41);
+        return v + 1;
+    }
+    int Sync() { return await Compute(); }
+}
+)"}));
+        ASSERT_EQ(Messages().size(), 1u);
+        EXPECT_EQ(Messages()[0], "file0.cs:11:25: error: The 'await' operator can only be used within an async method");
+        EXPECT_EQ(tinycsharp::TypeToString(Nth<tinycsharp::LocalVarStmt>(0)->resolved_type), "int");
+    }
+
+    TEST_F(SemaTest, ShouldMergeParallelDiagnosticsInSourceOrder)
+    {
+        std::vector<std::string> sources;
+        for (int f = 0; f < 4; f++)
+        {
+            std::string src = "namespace N" + std::to_string(f) + "\n{\n    class C\n    {\n";
+            for (int m = 0; m < 50; m++)
+            {
+                src += "        int M" + std::to_string(m) + "(int x) { string s = x; return s; }\n";
+            }
+            src += "    }\n}\n";
+            sources.push_back(src);
+        }
+
+        Analyze(sources);
+        auto serial = Messages();
+        ASSERT_EQ(serial.size(), 4u * 50u * 2u);
+
+        tinycsharp::Interner other_interner;
+        tinycsharp::AstContext other_ctx{other_interner};
+        int n = 0;
+        for (const auto &src : sources)
+        {
+            tinycsharp::Parser parser{other_ctx, src, "file" + std::to_string(n++) + ".cs"};
+            parser.ParseCompilationUnit();
+        }
+        tinycsharp::ThreadPool pool{4};
+        tinycsharp::Sema parallel{other_interner};
+        EXPECT_FALSE(parallel.Analyze(other_ctx.units, &pool));
+        std::vector<std::string> merged;
+        for (const auto &d : parallel.diagnostics())
+        {
+            std::ostringstream ss;
+            ss << d;
+            merged.push_back(ss.str());
+        }
+        EXPECT_EQ(merged, serial);
+    }
+
+}
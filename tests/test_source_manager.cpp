@@ -0,0 +1,164 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include <gtest/gtest.h>
+#include "lexer.h"
+#include "parser.h"
+#include "source_manager.h"
+
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tinycsharp_test
+{
+    using tinycsharp::FileId;
+    using tinycsharp::SourceLocation;
+    using tinycsharp::SourceManager;
+    using tinycsharp::SourcePosition;
+
+    TEST(SourceManagerTest, DecodesLineAndColumn)
+    {
+        SourceManager sources;
+        FileId id = sources.AddFile("a.cs", "ab\ncd\n\nef");
+        SourceLocation begin = sources.Begin(id);
+        EXPECT_TRUE(begin.valid());
+
+        SourcePosition pos = sources.Decode(begin);
+        EXPECT_EQ(pos.file, "a.cs");
+        EXPECT_EQ(pos.line, 1);
+        EXPECT_EQ(pos.column, 1);
+
+        pos = sources.Decode(begin + 4);
+        EXPECT_EQ(pos.line, 2);
+        EXPECT_EQ(pos.column, 2);
+
+        pos = sources.Decode(begin + 7);
+        EXPECT_EQ(pos.line, 4);
+        EXPECT_EQ(pos.column, 1);
+
+        // the end of file has a location of its own.
+        pos = sources.Decode(begin + 9);
+        EXPECT_EQ(pos.line, 4);
+        EXPECT_EQ(pos.column, 3);
+
+        EXPECT_EQ(sources.Decode(SourceLocation{}).line, 0);
+        EXPECT_EQ(sources.LineStarts(id), (std::vector<std::uint32_t>{0, 3, 6, 7}));
+    }
+
+    TEST(SourceManagerTest, FilesHaveRangesOfTheirOwn)
+    {
+        SourceManager sources;
+        FileId a = sources.AddFile("a.cs", "one\ntwo");
+        FileId b = sources.AddFile("b.cs", "three");
+        FileId c = sources.AddFile("c.cs", "");
+        EXPECT_EQ(sources.FileCount(), 3u);
+        EXPECT_EQ(sources.AddressSpaceUsed(), 8u + 6u + 1u);
+
+        EXPECT_EQ(sources.FileOf(sources.Begin(a) + 7), a);
+        EXPECT_EQ(sources.FileOf(sources.Begin(b)), b);
+        EXPECT_EQ(sources.FileOf(sources.Begin(c)), c);
+        EXPECT_EQ(sources.FileOf(sources.Begin(c) + 1), tinycsharp::kNoFile);
+        EXPECT_EQ(sources.FileOf(SourceLocation{}), tinycsharp::kNoFile);
+
+        SourcePosition pos = sources.Decode(sources.Begin(b) + 2);
+        EXPECT_EQ(pos.file, "b.cs");
+        EXPECT_EQ(pos.line, 1);
+        EXPECT_EQ(pos.column, 3);
+        EXPECT_EQ(sources.Text(b), "three");
+    }
+
+    TEST(SourceManagerTest, FileFromLineTable)
+    {
+        SourceManager sources;
+        FileId id = sources.AddFile("dump.cs", 10, {0, 4, 8});
+        EXPECT_EQ(sources.Size(id), 10u);
+        EXPECT_TRUE(sources.Text(id).empty());
+        SourcePosition pos = sources.Decode(sources.Begin(id) + 9);
+        EXPECT_EQ(pos.line, 3);
+        EXPECT_EQ(pos.column, 2);
+
+        EXPECT_THROW(sources.AddFile("bad.cs", 10, {1, 4}), std::invalid_argument);
+        EXPECT_THROW(sources.AddFile("bad.cs", 3, {0, 4}), std::invalid_argument);
+    }
+
+    TEST(SourceManagerTest, TokensAndNodesDecodeToTheirSource)
+    {
+        tinycsharp::Interner interner;
+        tinycsharp::AstContext ctx{interner};
+        ctx.sources().AddFile("first.cs", "class A { }");
+        tinycsharp::Parser parser{ctx, "class B\n{\n    int x;\n}", "second.cs"};
+        tinycsharp::CompilationUnit *unit = parser.ParseCompilationUnit();
+        ASSERT_EQ(unit->members.count, 1u);
+        auto cls = tinycsharp::NodeCast<tinycsharp::ClassDecl>(unit->members.items[0]);
+        ASSERT_NE(cls, nullptr);
+        ASSERT_EQ(cls->members.count, 1u);
+        // a field is placed at its name.
+        SourcePosition pos = unit->Locate(cls->members.items[0]);
+        EXPECT_EQ(pos.file, "second.cs");
+        EXPECT_EQ(pos.line, 3);
+        EXPECT_EQ(pos.column, 9);
+    }
+
+    TEST(SourceManagerTest, DecodesWhileFilesAreAdded)
+    {
+        SourceManager sources;
+        FileId first = sources.AddFile("first.cs", "a\nb\nc\n");
+        std::thread adder([&]
+                          {
+                              for (int i = 0; i < 200; i++)
+                                  sources.AddFile("f" + std::to_string(i) + ".cs", "x\ny\n"); });
+        for (int i = 0; i < 2000; i++)
+        {
+            SourcePosition pos = sources.Decode(sources.Begin(first) + 4);
+            ASSERT_EQ(pos.line, 3);
+            ASSERT_EQ(pos.column, 1);
+        }
+        adder.join();
+        EXPECT_EQ(sources.FileCount(), 201u);
+        EXPECT_EQ(sources.Decode(sources.Begin(200) + 2).line, 2);
+    }
+
+    TEST(SourceManagerTest, DecodesWhileFilesAreReleased)
+    {
+        SourceManager sources;
+        std::vector<FileId> files;
+        for (int i = 0; i < 200; i++)
+            files.push_back(sources.AddFile("f" + std::to_string(i) + ".cs", "a\nb\nc\n"));
+        std::thread releaser([&]
+                             {
+                                 for (int round = 0; round < 20; round++)
+                                 {
+                                     for (FileId id : files)
+                                         sources.Release(id);
+                                 } });
+        for (int round = 0; round < 20; round++)
+        {
+            for (FileId id : files)
+            {
+                // before the release it is line 3, after it line 1.
+                SourcePosition pos = sources.Decode(sources.Begin(id) + 4);
+                ASSERT_TRUE(pos.line == 3 || pos.line == 1) << pos.line;
+            }
+        }
+        releaser.join();
+        EXPECT_EQ(sources.Decode(sources.Begin(files.back()) + 4).line, 1);
+    }
+
+}
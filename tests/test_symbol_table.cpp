@@ -0,0 +1,112 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include <gtest/gtest.h>
+#include "interner.h"
+#include "symbol_table.h"
+
+#include <string>
+
+namespace tinycsharp_test
+{
+
+    TEST(InternerTest, ShouldHandOutStableDenseIds)
+    {
+        tinycsharp::Interner interner;
+        auto a = interner.Intern("alpha");
+        auto b = interner.Intern("beta");
+        EXPECT_NE(a, tinycsharp::kNoSymbol);
+        EXPECT_NE(a, b);
+        EXPECT_EQ(interner.Intern(std::string("alp") + "ha"), a);
+        EXPECT_EQ(interner.Spelling(b), "beta");
+        EXPECT_EQ(interner.Find("gamma"), tinycsharp::kNoSymbol);
+
+        for (int i = 0; i < 5000; i++)
+        {
+            interner.Intern("name" + std::to_string(i));
+        }
+        EXPECT_EQ(interner.Size(), 5002u);
+        EXPECT_EQ(interner.Find("alpha"), a);
+        EXPECT_EQ(interner.Spelling(interner.Find("name4999")), "name4999");
+    }
+
+    TEST(ScopedSymbolTableTest, ShouldResolveInnermostBindingAndRestoreOnPop)
+    {
+        tinycsharp::Interner interner;
+        tinycsharp::ScopedSymbolTable table;
+        tinycsharp::Node outer{}, inner{};
+        auto x = interner.Intern("x");
+
+        table.PushScope();
+        EXPECT_TRUE(table.Declare(x, tinycsharp::SymbolKind::kField, &outer));
+        EXPECT_FALSE(table.Declare(x, tinycsharp::SymbolKind::kField, &inner));
+
+        table.PushScope();
+        EXPECT_EQ(table.LookupInCurrentScope(x), nullptr);
+        EXPECT_TRUE(table.Declare(x, tinycsharp::SymbolKind::kLocal, &inner));
+        ASSERT_NE(table.Lookup(x), nullptr);
+        EXPECT_EQ(table.Lookup(x)->decl, &inner);
+        EXPECT_EQ(table.ScopeOf(table.Lookup(x)), 2u);
+
+        table.PopScope();
+        ASSERT_NE(table.Lookup(x), nullptr);
+        EXPECT_EQ(table.Lookup(x)->decl, &outer);
+        EXPECT_EQ(table.ScopeOf(table.Lookup(x)), 1u);
+
+        table.PopScope();
+        EXPECT_EQ(table.Lookup(x), nullptr);
+    }
+
+    TEST(ScopedSymbolTableTest, ShouldStayCorrectWhenDeeplyNestedAndRehashed)
+    {
+        tinycsharp::Interner interner;
+        tinycsharp::ScopedSymbolTable table;
+        std::vector<tinycsharp::Node> decls(2000);
+        std::vector<tinycsharp::SymbolId> names;
+        for (int i = 0; i < 1000; i++)
+        {
+            names.push_back(interner.Intern("v" + std::to_string(i)));
+        }
+
+        for (int depth = 0; depth < 1000; depth++)
+        {
+            table.PushScope();
+            table.Declare(names[depth], tinycsharp::SymbolKind::kLocal, &decls[depth]);
+            table.Declare(names[0], tinycsharp::SymbolKind::kLocal, &decls[1000 + depth]);
+        }
+        EXPECT_EQ(table.Depth(), 1000u);
+        EXPECT_EQ(table.Lookup(names[0])->decl, &decls[1999]);
+        EXPECT_EQ(table.Lookup(names[500])->decl, &decls[500]);
+
+        for (int depth = 999; depth >= 500; depth--)
+        {
+            table.PopScope();
+        }
+        EXPECT_EQ(table.Lookup(names[0])->decl, &decls[1499]);
+        EXPECT_EQ(table.Lookup(names[500]), nullptr);
+        EXPECT_EQ(table.Lookup(names[499])->decl, &decls[499]);
+    }
+
+    TEST(ScopedSymbolTableTest, ShouldRejectUnbalancedUse)
+    {
+        tinycsharp::ScopedSymbolTable table;
+        EXPECT_THROW(table.PopScope(), std::logic_error);
+        EXPECT_THROW(table.Declare(1, tinycsharp::SymbolKind::kLocal, nullptr), std::logic_error);
+    }
+
+}
@@ -0,0 +1,54 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include <gtest/gtest.h>
+#include "thread_pool.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+namespace tinycsharp_test
+{
+
+    TEST(ThreadPoolTest, ShouldRunEveryIndexOnce)
+    {
+        tinycsharp::ThreadPool pool{3};
+        std::vector<std::atomic<int>> hits(1000);
+        pool.ParallelFor(hits.size(), [&](std::size_t i)
+                         { hits[i]++; });
+        for (auto &h : hits)
+        {
+            EXPECT_EQ(h.load(), 1);
+        }
+    }
+
+    TEST(ThreadPoolTest, ShouldRethrowTaskExceptions)
+    {
+        tinycsharp::ThreadPool pool{2};
+        EXPECT_THROW(pool.ParallelFor(10, [](std::size_t i)
+                                      { if (i == 7) throw std::runtime_error("boom"); }),
+                     std::runtime_error);
+        std::atomic<int> done{0};
+        pool.Submit([&]
+                    { done++; });
+        pool.Wait();
+        EXPECT_EQ(done.load(), 1);
+    }
+
+}
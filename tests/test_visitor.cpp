@@ -0,0 +1,129 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include <gtest/gtest.h>
+#include "ast.h"
+#include "parser.h"
+#include "visitor.h"
+
+#include <string>
+#include <vector>
+
+namespace tinycsharp_test
+{
+
+    class VisitorTest : public ::testing::Test
+    {
+    protected:
+        tinycsharp::AstContext ctx;
+
+        void SetUp() override
+        {
+            tinycsharp::Parser parser{ctx, R"(
+namespace Shop
+{
+    class Cart
+    {
+        int Total(int a, int b)
+        {
+            Log(a);
+            if (a > b) { return Sum(a, Sum(b, 1)); }
+            return 0;
+        }
+        void Log(int x) {}
+        int Sum(int x, int y) => x + y;
+    }
+}
+)"};
+            parser.ParseCompilationUnit();
+        }
+    };
+
+    struct CallCounter : tinycsharp::AstVisitor<CallCounter>
+    {
+        int calls = 0;
+        int others = 0;
+        void VisitCallExpr(tinycsharp::CallExpr *) { calls++; }
+        void VisitNode(tinycsharp::Node *) { others++; }
+    };
+
+    struct CalleeCollector : tinycsharp::RecursiveAstVisitor<CalleeCollector>
+    {
+        std::vector<std::string> callees;
+        int methods = 0;
+
+        void VisitMethodDecl(tinycsharp::MethodDecl *node)
+        {
+            methods++;
+            WalkMethodDecl(node);
+        }
+        void VisitCallExpr(tinycsharp::CallExpr *node)
+        {
+            if (auto *name = tinycsharp::NodeCast<tinycsharp::NameExpr>(node->callee))
+            {
+                callees.emplace_back(name->name);
+            }
+            WalkCallExpr(node);
+        }
+    };
+
+    struct DepthMeasure : tinycsharp::AstVisitor<DepthMeasure, int>
+    {
+        int VisitBinaryExpr(tinycsharp::BinaryExpr *node)
+        {
+            return 1 + std::max(Visit(node->lhs), Visit(node->rhs));
+        }
+        int VisitNode(tinycsharp::Node *) { return 0; }
+    };
+
+    TEST_F(VisitorTest, ShouldVisitEveryNodeOfOneKindWithoutWalkingTheTree)
+    {
+        CallCounter counter;
+        counter.VisitAllOfKind<tinycsharp::CallExpr>(ctx);
+        EXPECT_EQ(counter.calls, 3);
+        EXPECT_EQ(counter.others, 0);
+    }
+
+    TEST_F(VisitorTest, ShouldDispatchOnNodeKind)
+    {
+        CallCounter counter;
+        for (auto *unit : ctx.units)
+        {
+            counter.Visit(unit);
+        }
+        EXPECT_EQ(counter.calls, 0);
+        EXPECT_EQ(counter.others, 1);
+    }
+
+    TEST_F(VisitorTest, ShouldWalkChildrenInSourceOrder)
+    {
+        CalleeCollector collector;
+        collector.Visit(ctx.units[0]);
+        EXPECT_EQ(collector.methods, 3);
+        EXPECT_EQ(collector.callees, (std::vector<std::string>{"Log", "Sum", "Sum"}));
+    }
+
+    TEST_F(VisitorTest, ShouldReturnValuesFromHandlers)
+    {
+        const auto &sums = ctx.NodesOfKind(tinycsharp::NodeKind::kBinaryExpr);
+        ASSERT_EQ(sums.size(), 2u);
+        DepthMeasure depth;
+        EXPECT_EQ(depth.Visit(sums[0]), 1);
+    }
+
+}
@@ -0,0 +1,880 @@
+/*
+ * This file is part of tinycsharp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Faith (propenster) Olusegun.
+ * Contact: https://propenster.github.io
+ */
+#include <gtest/gtest.h>
+#include "bytecode.h"
+#include "ir.h"
+#include "parser.h"
+#include "passes.h"
+#include "sema.h"
+#include "vm.h"
+
+#include <chrono>
+#include <sstream>
+#include <string>
+
+namespace tinycsharp_test
+{
+
+    class VmTest : public ::testing::Test
+    {
+    protected:
+        tinycsharp::Interner interner;
+        tinycsharp::AstContext ctx{interner};
+        tinycsharp::Sema sema{interner};
+        tinycsharp::IrModule module;
+        tinycsharp::BcProgram program;
+        int exit_code = 0;
+
+        void Compile(const std::string &source, tinycsharp::OptLevel level = tinycsharp::OptLevel::kO1)
+        {
+            tinycsharp::Parser parser{ctx, source, "test.cs"};
+            parser.ParseCompilationUnit();
+            ASSERT_TRUE(sema.Analyze(ctx.units)) << (sema.diagnostics().empty() ? "" : sema.diagnostics()[0].message);
+            module = tinycsharp::LowerToIr(sema.globals());
+            tinycsharp::PassManager passes;
+            passes.AddPipeline(level);
+            passes.Run(module);
+            program = tinycsharp::CompileBytecode(module);
+        }
+
+        std::string Run(const std::string &source, tinycsharp::OptLevel level = tinycsharp::OptLevel::kO1)
+        {
+            Compile(source, level);
+            std::ostringstream out;
+            tinycsharp::Vm vm{program, out};
+            exit_code = vm.Run();
+            return out.str();
+        }
+
+        // the exception that escapes Main, or a default VmError if none does.
+        tinycsharp::VmError Fault(const std::string &source, std::string *output = nullptr)
+        {
+            Compile(source);
+            std::ostringstream out;
+            tinycsharp::Vm vm{program, out};
+            try
+            {
+                vm.Run();
+            }
+            catch (const tinycsharp::VmError &e)
+            {
+                if (output)
+                    *output = out.str();
+                return e;
+            }
+            return tinycsharp::VmError("none", "", "");
+        }
+    };
+
+    TEST(BytecodeFormatTest, ShouldKeepInstructionsFixedWidth)
+    {
+        EXPECT_EQ(sizeof(tinycsharp::BcInst), 8u);
+        EXPECT_EQ(tinycsharp::CallLength(0), 1u);
+        EXPECT_EQ(tinycsharp::CallLength(4), 2u);
+        EXPECT_EQ(tinycsharp::CallLength(5), 3u);
+        tinycsharp::BcInst inst;
+        inst.SetWide(0x12345678u);
+        EXPECT_EQ(inst.Wide(), 0x12345678u);
+    }
+
+    TEST_F(VmTest, ShouldRunArithmeticAndRecursion)
+    {
+        std::string out = Run(R"(
+class Program
+{
+    static int Fib(int n)
+    {
+        if (n < 2) return n;
+        return Fib(n - 1) + Fib(n - 2);
+    }
+    static int Main()
+    {
+        System.Console.WriteLine(Fib(20));
+        System.Console.WriteLine(7 / 2 + " " + (-7 % 3) + " " + (7.0 / 2) + " " + (1 << 33));
+        long big = 3000000000;
+        big = big * 3;
+        System.Console.WriteLine(big);
+        int wrap = 2147483647;
+        wrap = wrap + 1;
+        System.Console.WriteLine(wrap);
+        return 42;
+    }
+}
+)");
+        EXPECT_EQ(out, "6765\n3 -1 3.5 2\n9000000000\n-2147483648\n");
+        EXPECT_EQ(exit_code, 42);
+    }
+
+    TEST_F(VmTest, ShouldResolvePhiCyclesAtEveryLevel)
+    {
+        const std::string source = R"(
+class Program
+{
+    static void Main()
+    {
+        int a = 1;
+        int b = 2;
+        int c = 3;
+        int i = 0;
+        while (i < 7)
+        {
+            int t = a;
+            a = b;
+            b = c;
+            c = t;
+            i++;
+        }
+        System.Console.WriteLine(a + " " + b + " " + c);
+    }
+}
+)";
+        for (auto level : {tinycsharp::OptLevel::kO0, tinycsharp::OptLevel::kO1, tinycsharp::OptLevel::kO2})
+        {
+            SCOPED_TRACE(static_cast<int>(level));
+            sema.~Sema();
+            new (&sema) tinycsharp::Sema{interner};
+            ctx.units.clear();
+            EXPECT_EQ(Run(source, level), "2 3 1\n");
+        }
+    }
+
+    TEST_F(VmTest, ShouldDispatchVirtualCallsAndKeepFields)
+    {
+        std::string out = Run(R"(
+class Shape
+{
+    protected int id = 7;
+    public virtual string Name() { return "shape"; }
+    public virtual double Area() { return 0; }
+}
+class Square : Shape
+{
+    private double side;
+    public Square(double s) { side = s; }
+    public override string Name() { return "square" + id; }
+    public override double Area() { return side * side; }
+}
+class Program
+{
+    static void Main()
+    {
+        Shape[] shapes = new Shape[2];
+        shapes[0] = new Shape();
+        shapes[1] = new Square(1.5);
+        int i = 0;
+        while (i < shapes.Length)
+        {
+            System.Console.WriteLine(shapes[i].Name() + " " + shapes[i].Area());
+            i++;
+        }
+        Square sq = (Square)shapes[1];
+        System.Console.WriteLine(sq.Area());
+    }
+}
+)");
+        EXPECT_EQ(out, "shape 0\nsquare7 2.25\n2.25\n");
+    }
+
+    TEST_F(VmTest, ShouldCacheVirtualCallTargetsPerSite)
+    {
+        std::string source = R"(
+class Animal
+{
+    public virtual int Legs() { return 0; }
+}
+class Bird : Animal { public override int Legs() { return 2; } }
+class Dog : Animal { public override int Legs() { return 4; } }
+class Ant : Animal { public override int Legs() { return 6; } }
+class Spider : Animal { public override int Legs() { return 8; } }
+class Snake : Animal { }
+class Program
+{
+    static int Count(Animal[] zoo)
+    {
+        int legs = 0;
+        int i = 0;
+        while (i < zoo.Length)
+        {
+            legs = legs + zoo[i].Legs();
+            i++;
+        }
+        return legs;
+    }
+    static void Main()
+    {
+        Animal[] dogs = new Animal[10];
+        Animal[] pair = new Animal[10];
+        Animal[] zoo = new Animal[12];
+        int i = 0;
+        while (i < 10)
+        {
+            dogs[i] = new Dog();
+            if (i % 2 == 0) pair[i] = new Bird(); else pair[i] = new Ant();
+            i++;
+        }
+        zoo[0] = new Animal();
+        zoo[1] = new Bird();
+        zoo[2] = new Dog();
+        zoo[3] = new Ant();
+        zoo[4] = new Spider();
+        i = 5;
+        while (i < 12)
+        {
+            zoo[i] = new Snake();
+            i++;
+        }
+        int mono = 0;
+        i = 0;
+        while (i < 10)
+        {
+            mono = mono + dogs[i].Legs();
+            i++;
+        }
+        int poly = 0;
+        i = 0;
+        while (i < 10)
+        {
+            poly = poly + pair[i].Legs();
+            i++;
+        }
+        System.Console.WriteLine(mono + " " + poly + " " + Count(zoo));
+    }
+}
+)";
+        Compile(source);
+        ASSERT_EQ(program.num_call_sites, 3u);
+        std::ostringstream out;
+        tinycsharp::Vm vm{program, out};
+        vm.Run();
+        EXPECT_EQ(out.str(), "40 40 20\n");
+
+        const auto &stats = vm.stats();
+        EXPECT_EQ(stats.VirtualCalls(), 32u);
+        // every site misses once per class it sees, up to the cache size.
+        EXPECT_EQ(stats.inline_cache_misses, 1u + 2u + tinycsharp::InlineCache::kEntries);
+        EXPECT_EQ(stats.monomorphic_hits, 9u);
+        EXPECT_EQ(stats.polymorphic_hits, 8u);
+        // the fifth and later classes at Count's site go through the vtable.
+        EXPECT_EQ(stats.megamorphic_calls, 32u - 9u - 8u - 7u);
+        EXPECT_NEAR(stats.InlineCacheHitRate(), 17.0 / 32.0, 1e-9);
+
+        std::size_t monomorphic = 0;
+        std::size_t polymorphic = 0;
+        std::size_t megamorphic = 0;
+        for (const auto &cache : vm.inline_caches())
+        {
+            if (cache.megamorphic)
+                megamorphic++;
+            else if (cache.size > 1)
+                polymorphic++;
+            else if (cache.size == 1)
+                monomorphic++;
+        }
+        EXPECT_EQ(monomorphic, 1u);
+        EXPECT_EQ(polymorphic, 1u);
+        EXPECT_EQ(megamorphic, 1u);
+    }
+
+    TEST_F(VmTest, ShouldFormatLikeDotnet)
+    {
+        std::string out = Run(R"(
+class Program
+{
+    static int counter = 3;
+    static void Main()
+    {
+        double d = 0.1;
+        System.Console.WriteLine(d * 3);
+        System.Console.WriteLine(100000000000000000000.0);
+        System.Console.WriteLine(0.00001);
+        System.Console.WriteLine(1.5 > 1);
+        string s = "hello";
+        System.Console.WriteLine(s[1] + " " + s.Length);
+        System.Console.WriteLine("{0} + {1} = {2}", 1, counter, 1 + counter);
+        object boxed = 5;
+        System.Console.WriteLine(boxed);
+        System.Console.Write("no newline");
+    }
+}
+)");
+        EXPECT_EQ(out, "0.30000000000000004\n1E+20\n1E-05\nTrue\ne 5\n1 + 3 = 4\n5\nno newline");
+        EXPECT_EQ(tinycsharp::FormatDouble(123.5), "123.5");
+        EXPECT_EQ(tinycsharp::FormatDouble(1e15), "1E+15");
+        EXPECT_EQ(tinycsharp::FormatDouble(-0.0), "-0");
+        EXPECT_EQ(tinycsharp::FormatFloat(0.1f), "0.1");
+        EXPECT_EQ(tinycsharp::FormatFloat(16777216.0f), "1.6777216E+07");
+    }
+
+    TEST_F(VmTest, ShouldReportRuntimeExceptions)
+    {
+        std::string output;
+        auto e = Fault(R"(
+class Program
+{
+    static int Div(int a, int b) { return a / b; }
+    static void Main()
+    {
+        System.Console.WriteLine("start");
+        System.Console.WriteLine(Div(1, 0));
+    }
+}
+)", &output);
+        EXPECT_EQ(e.type(), "System.DivideByZeroException");
+        EXPECT_EQ(output, "start\n");
+        EXPECT_NE(std::string(e.what()).find("at Program.Div(int, int):line 4"), std::string::npos) << e.what();
+        EXPECT_NE(std::string(e.what()).find("at Program.Main():line 8"), std::string::npos) << e.what();
+    }
+
+    TEST_F(VmTest, ShouldTrapBadAccesses)
+    {
+        EXPECT_EQ(Fault("class P { static void Main() { int[] a = new int[2]; a[2] = 1; } }").type(),
+                  "System.IndexOutOfRangeException");
+    }
+
+    TEST_F(VmTest, ShouldTrapNullReferences)
+    {
+        EXPECT_EQ(Fault("class N { public int v; } class P { static void Main() { N n = null; n.v = 1; } }").type(),
+                  "System.NullReferenceException");
+    }
+
+    TEST_F(VmTest, ShouldTrapInvalidUnboxing)
+    {
+        auto e = Fault("class P { static void Main() { object o = 5; long l = (long)o; System.Console.WriteLine(l); } }");
+        EXPECT_EQ(e.type(), "System.InvalidCastException");
+        EXPECT_EQ(e.message(), "Unable to cast object of type 'System.Int32' to type 'System.Int64'.");
+    }
+
+    TEST_F(VmTest, ShouldThrowLibraryExceptions)
+    {
+        auto e = Fault(R"(
+using System;
+class Program
+{
+    static void Main() { throw new InvalidOperationException("bad state"); }
+}
+)");
+        EXPECT_EQ(e.type(), "System.InvalidOperationException");
+        EXPECT_EQ(e.message(), "bad state");
+    }
+
+    TEST_F(VmTest, ShouldStopRunawayRecursion)
+    {
+        EXPECT_EQ(Fault("class P { static int F(int n) { return F(n + 1) + 1; } static void Main() { F(0); } }").type(),
+                  "System.StackOverflowException");
+    }
+
+    TEST_F(VmTest, ShouldCollectGarbageAndKeepLiveObjects)
+    {
+        Compile(R"(
+class Node
+{
+    public Node next;
+    public int value;
+}
+class Program
+{
+    static int Main()
+    {
+        Node head = null;
+        string last = "-";
+        int i = 0;
+        while (i < 2000)
+        {
+            Node n = new Node();
+            n.value = i;
+            n.next = head;
+            head = n;
+            last = "item " + i;
+            i++;
+        }
+        System.Console.WriteLine(last);
+        int sum = 0;
+        while (head != null)
+        {
+            sum += head.value;
+            head = head.next;
+        }
+        return sum % 1000;
+    }
+}
+)");
+        std::ostringstream out;
+        tinycsharp::Vm::Options options;
+        options.gc_threshold = 4096;
+        tinycsharp::Vm vm{program, out, options};
+        EXPECT_EQ(vm.Run(), 1999000 % 1000);
+        EXPECT_EQ(out.str(), "item 1999\n");
+        EXPECT_GT(vm.heap().stats().collections, 2u);
+        EXPECT_GT(vm.heap().stats().bytes_freed, 0u);
+    }
+
+    TEST_F(VmTest, ShouldKeepReferencesValidAcrossMovingCollections)
+    {
+        Compile(R"cs(
+class Point
+{
+    public int x;
+    public int y;
+    public Point(int x, int y) { this.x = x; this.y = y; }
+    public virtual string Describe() { return "(" + x + ", " + y + ")"; }
+}
+class Order
+{
+    public Point from;
+    public Point to;
+    public string name;
+}
+class Program
+{
+    static Order Make(int i, string prefix)
+    {
+        Order o = new Order();
+        o.from = new Point(i, i + 1);
+        string label = prefix + i;
+        o.to = new Point(i * 2, i * 3);
+        o.name = label + "/" + o.from.Describe();
+        return o;
+    }
+    static int Main()
+    {
+        Order[] kept = new Order[50];
+        long total = 0;
+        int i = 0;
+        while (i < 20000)
+        {
+            Order o = Make(i, "order ");
+            total += o.from.x + o.to.y;
+            kept[i % 50] = o;
+            i++;
+        }
+        System.Console.WriteLine(kept[7].name);
+        i = 0;
+        while (i < 50)
+        {
+            total += kept[i].to.x;
+            i++;
+        }
+        System.Console.WriteLine(total);
+        return 0;
+    }
+}
+)cs");
+        std::ostringstream out;
+        tinycsharp::Vm::Options options;
+        options.gc_threshold = 4096;
+        tinycsharp::Vm vm{program, out, options};
+        EXPECT_EQ(vm.Run(), 0);
+        EXPECT_EQ(out.str(), "order 19957/(19957, 19958)\n801957450\n");
+        const auto &stats = vm.heap().stats();
+        EXPECT_GT(stats.minor_collections, 100u);
+        EXPECT_GT(stats.major_collections, 0u);
+        EXPECT_GT(stats.bytes_promoted, 0u);
+        EXPECT_LT(stats.bytes_promoted, stats.bytes_allocated / 2);
+        bool mapped = false;
+        for (const auto &fn : program.functions)
+            mapped = mapped || (fn.name.find("Make") != std::string::npos && !fn.stack_maps.empty());
+        EXPECT_TRUE(mapped);
+    }
+
+    TEST_F(VmTest, ShouldBuildLongStringsInLinearTime)
+    {
+        Compile(R"(
+class Program
+{
+    static int Main()
+    {
+        string s = "";
+        string t = "";
+        int i = 0;
+        while (i < 100000)
+        {
+            s += "ab";
+            t = t + "a" + "b";
+            i++;
+        }
+        System.Console.WriteLine(s.Length);
+        System.Console.WriteLine(s[77777]);
+        if (s == t)
+            System.Console.WriteLine("same");
+        return 0;
+    }
+}
+)");
+        std::ostringstream out;
+        tinycsharp::Vm vm{program, out};
+        vm.Run();
+        EXPECT_EQ(out.str(), "200000\nb\nsame\n");
+        // copying on every += would allocate about 20GB.
+        EXPECT_LT(vm.heap().stats().bytes_allocated, 100u * 300000);
+    }
+
+    TEST_F(VmTest, ShouldNotAllocateLiteralsOrCharStrings)
+    {
+        Compile(R"(
+class Program
+{
+    static void Main()
+    {
+        string s = "literal";
+        char c = s[3];
+        System.Console.WriteLine(s);
+        System.Console.WriteLine("" + c);
+        System.Console.WriteLine("");
+    }
+}
+)");
+        std::ostringstream out;
+        tinycsharp::Vm vm{program, out};
+        vm.Run();
+        EXPECT_EQ(out.str(), "literal\ne\n\n");
+        EXPECT_EQ(vm.heap().stats().objects_allocated, 0u);
+    }
+
+    TEST_F(VmTest, ShouldAwaitCompletedTasks)
+    {
+        std::string out = Run(R"(
+using System;
+using System.Threading.Tasks;
+class Program
+{
+    static async Task<int> Compute(int x)
+    {
+        await Task.Yield();
+        return x * 2;
+    }
+    static async Task<int> Main()
+    {
+        int v = await Compute(20);
+        Console.WriteLine(v);
+        return v + 2;
+    }
+}
+)");
+        EXPECT_EQ(out, "40\n");
+        EXPECT_EQ(exit_code, 42);
+    }
+
+    TEST_F(VmTest, ShouldAwaitCompletedTasksWithoutAllocating)
+    {
+        Compile(R"(
+using System.Threading.Tasks;
+class Program
+{
+    static int total;
+    static async Task Step(int i)
+    {
+        await Task.CompletedTask;
+        total = total + i;
+    }
+    static async Task Main()
+    {
+        int i = 0;
+        while (i < 1000)
+        {
+            await Step(i);
+            await Task.CompletedTask;
+            i++;
+        }
+        System.Console.WriteLine(total);
+    }
+}
+)");
+        std::ostringstream out;
+        tinycsharp::Vm vm{program, out};
+        vm.Run();
+        EXPECT_EQ(out.str(), "499500\n");
+        EXPECT_EQ(vm.stats().suspensions, 0u);
+        // the one shared completed task; Main's args array.
+        EXPECT_LE(vm.heap().stats().objects_allocated, 2u);
+    }
+
+    TEST_F(VmTest, ShouldSuspendAndResumeAsyncCalls)
+    {
+        Compile(R"(
+using System;
+using System.Threading.Tasks;
+class Box { public int value; }
+class Program
+{
+    static async Task<int> Count(string name, int n)
+    {
+        int sum = 0;
+        double scale = 0.5;
+        Box box = new Box();
+        int i = 0;
+        while (i < n)
+        {
+            await Task.Yield();
+            string garbage = name + i;
+            box.value = box.value + garbage.Length;
+            sum = sum + i;
+            i++;
+        }
+        Console.WriteLine(name + " " + sum + " " + box.value + " " + (sum * scale));
+        return sum;
+    }
+    static async Task<int> Main()
+    {
+        int a = await Count("a", 10);
+        int b = await Count("bb", 200);
+        return (a + b) % 100;
+    }
+}
+)");
+        std::ostringstream out;
+        tinycsharp::Vm::Options options;
+        options.gc_threshold = 4096;
+        tinycsharp::Vm vm{program, out, options};
+        EXPECT_EQ(vm.Run(), (45 + 19900) % 100);
+        EXPECT_EQ(out.str(), "a 45 20 22.5\nbb 19900 890 9950\n");
+        // each Task.Yield, and Main waiting on both counts.
+        EXPECT_EQ(vm.stats().suspensions, 212u);
+        EXPECT_EQ(vm.stats().resumptions, 212u);
+        EXPECT_GT(vm.heap().stats().minor_collections, 0u);
+    }
+
+    TEST_F(VmTest, ShouldOverlapDelaysInsteadOfBlocking)
+    {
+        Compile(R"(
+using System;
+using System.Threading.Tasks;
+class Program
+{
+    static async Task<int> Wait(int i)
+    {
+        await Task.Delay(100);
+        return i;
+    }
+    static async Task Main()
+    {
+        Task<int>[] waits = new Task<int>[20];
+        int i = 0;
+        while (i < 20)
+        {
+            waits[i] = Wait(i);
+            i++;
+        }
+        int sum = 0;
+        i = 0;
+        while (i < 20)
+        {
+            sum = sum + await waits[i];
+            i++;
+        }
+        Console.WriteLine(sum);
+    }
+}
+)");
+        std::ostringstream out;
+        tinycsharp::Vm vm{program, out};
+        auto start = std::chrono::steady_clock::now();
+        vm.Run();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        EXPECT_EQ(out.str(), "190\n");
+        // twenty sequential 100ms sleeps would take two seconds.
+        EXPECT_LT(elapsed, std::chrono::milliseconds(1000));
+        EXPECT_GE(elapsed, std::chrono::milliseconds(100));
+    }
+
+    TEST_F(VmTest, ShouldKeepNullChecksOfDevirtualizedCalls)
+    {
+        Compile(R"(
+class Source
+{
+    public virtual int Next() { return 0; }
+}
+sealed class Counter : Source
+{
+    public override int Next() { return 1; }
+}
+class Program
+{
+    static int Sum(Counter c, int n)
+    {
+        int total = 0;
+        while (n > 0)
+        {
+            total += c.Next();
+            n--;
+        }
+        return total;
+    }
+    static void Main()
+    {
+        System.Console.WriteLine(Sum(new Counter(), 5));
+        System.Console.WriteLine(Sum(null, 5));
+    }
+}
+)",
+                tinycsharp::OptLevel::kO2);
+        std::ostringstream out;
+        tinycsharp::Vm vm{program, out};
+        try
+        {
+            vm.Run();
+            FAIL() << "expected a NullReferenceException";
+        }
+        catch (const tinycsharp::VmError &e)
+        {
+            EXPECT_EQ(out.str(), "5\n");
+            EXPECT_EQ(e.type(), "System.NullReferenceException");
+            EXPECT_EQ(e.message(), "Object reference not set to an instance of an object.");
+        }
+        EXPECT_EQ(vm.stats().VirtualCalls(), 0u);
+    }
+
+    TEST_F(VmTest, ShouldInvokeFunctionsDirectly)
+    {
+        Compile("class P { static long Mul(long a, int b) { return a * b; } static void Main() { } }");
+        std::ostringstream out;
+        tinycsharp::Vm vm{program, out};
+        std::uint32_t mul = 0;
+        for (auto *method : sema.globals().methods())
+        {
+            if (method->decl->name == "Mul")
+                mul = method->id;
+        }
+        auto result = vm.Invoke(mul, {tinycsharp::IntValue(1) , tinycsharp::IntValue(0)});
+        EXPECT_EQ(result.i, 0);
+        result = vm.Invoke(mul, {tinycsharp::IntValue(1LL << 40), tinycsharp::IntValue(3)});
+        EXPECT_EQ(result.i, 3LL << 40);
+        EXPECT_GT(vm.stats().instructions, 0u);
+    }
+
+    TEST_F(VmTest, ShouldPrintBytecode)
+    {
+        Compile("class P { static int Inc(int x) { return x + 1; } static void Main() { } }");
+        std::ostringstream out;
+        tinycsharp::PrintBytecode(out, program);
+        EXPECT_NE(out.str().find("function P.Inc(int) : 1 params"), std::string::npos) << out.str();
+        EXPECT_NE(out.str().find("Add.i32 r"), std::string::npos) << out.str();
+        EXPECT_NE(out.str().find("Return.i32"), std::string::npos) << out.str();
+    }
+
+    TEST_F(VmTest, ShouldQuickenGenericInstructionsInPlace)
+    {
+        Compile(R"(
+class Program
+{
+    static double Scale(double x, int k) { return x * k - 0.5; }
+    static int Main()
+    {
+        int i = 0;
+        double d = 0.0;
+        long l = 5;
+        while (i < 10)
+        {
+            d = Scale(d, i) / 4.0;
+            l = l * 3 + i;
+            i++;
+        }
+        System.Console.WriteLine((int)d + " " + l);
+        return 0;
+    }
+}
+)");
+        std::ostringstream generic_out;
+        tinycsharp::Vm::Options generic_options;
+        generic_options.quicken = false;
+        tinycsharp::Vm generic{program, generic_out, generic_options};
+        generic.Run();
+        EXPECT_EQ(generic.stats().quickened, 0u);
+
+        std::ostringstream out;
+        tinycsharp::Vm vm{program, out};
+        vm.Run();
+        EXPECT_EQ(out.str(), generic_out.str());
+        EXPECT_GT(vm.stats().quickened, 0u);
+
+        std::ostringstream code;
+        tinycsharp::PrintBytecode(code, vm.program());
+        for (const char *op : {"MulF64", "SubF64", "DivF64", "MulI64", "ConvIF64", "ConvF64I32"})
+            EXPECT_NE(code.str().find(op), std::string::npos) << op << "\n" << code.str();
+        std::ostringstream original;
+        tinycsharp::PrintBytecode(original, program);
+        EXPECT_EQ(original.str().find("MulF64"), std::string::npos);
+
+        // a second run finds the code already quickened.
+        std::uint64_t first = vm.stats().quickened;
+        vm.Run();
+        EXPECT_EQ(vm.stats().quickened, first);
+    }
+
+    TEST_F(VmTest, ShouldFuseSuperinstructionsWithoutChangingResults)
+    {
+        Compile(R"(
+class Counter
+{
+    public int hits;
+    public long total;
+    public double weight;
+}
+class Program
+{
+    static int calls;
+    static int Main()
+    {
+        Counter c = new Counter();
+        int[] data = new int[10];
+        int i = 0;
+        int prev = 0;
+        int a = 1;
+        int b = 1;
+        while (i < 100)
+        {
+            int next = i + 1;
+            prev = prev + i;
+            c.hits++;
+            c.total += i;
+            c.weight += 0.5;
+            data[i % 10] = data[i % 10] + i;
+            calls = calls + 2;
+            int t = a + b;
+            a = b;
+            b = t % 1000;
+            i = next;
+        }
+        System.Console.WriteLine(c.hits + " " + c.total + " " + c.weight + " " + data[3] + " " + calls);
+        System.Console.WriteLine(prev + " " + a + " " + b + " " + i);
+        return 0;
+    }
+}
+)");
+        tinycsharp::BcOptions plain_options;
+        plain_options.superinstructions = false;
+        plain_options.coalesce_moves = false;
+        tinycsharp::BcProgram plain = tinycsharp::CompileBytecode(module, nullptr, plain_options);
+
+        std::ostringstream plain_out;
+        tinycsharp::Vm plain_vm{plain, plain_out};
+        plain_vm.Run();
+        std::ostringstream out;
+        tinycsharp::Vm vm{program, out};
+        vm.Run();
+        EXPECT_EQ(plain_out.str(), "100 4950 50 480 200\n4950 101 176 100\n");
+        EXPECT_EQ(out.str(), plain_out.str());
+        EXPECT_LT(vm.stats().instructions * 4, plain_vm.stats().instructions * 3);
+
+        std::ostringstream code;
+        tinycsharp::PrintBytecode(code, program);
+        for (const char *op : {"JumpIfLtI", "AddField.i32", "AddField.i64", "AddField.f64", "AddElem.i32", "AddStatic.i32"})
+            EXPECT_NE(code.str().find(op), std::string::npos) << op << "\n" << code.str();
+    }
+
+}